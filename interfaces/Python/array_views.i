@@ -0,0 +1,487 @@
+/**********************************************/
+/* BEGIN interface for zero-copy views of DP  */
+/* matrices                                   */
+/**********************************************/
+
+#ifdef SWIGPYTHON
+%{
+
+#include <string.h>
+
+/*
+ *  A read-only, one-dimensional buffer that points directly into a
+ *  DP matrix of a fold compound. The view holds a reference to the
+ *  Python fold_compound object and to the DP matrices it points into,
+ *  so the underlying memory stays valid for as long as the view (or
+ *  any numpy array / memoryview created from it) exists, even if the
+ *  fold compound re-allocates its matrices in the meantime.
+ *
+ *  Views of data that is not part of the DP matrices, e.g. the
+ *  unpaired probabilities of the sliding window approach, own their
+ *  memory instead and may have two dimensions.
+ */
+typedef struct {
+  PyObject_HEAD
+  PyObject              *owner;
+  vrna_fold_compound_t  *fc;
+  vrna_mx_mfe_t         *mfe;   /* referenced MFE matrices, if any */
+  vrna_mx_pf_t          *pf;    /* referenced PF matrices, if any */
+  const char            *name;
+  void        *data;
+  void        *owned;           /* memory released with the view, if any */
+  Py_ssize_t  length;
+  Py_ssize_t  itemsize;
+  char        *format;
+  int         ndim;
+  Py_ssize_t  shape[2];
+  Py_ssize_t  strides[2];
+} py_array_view_t;
+
+static PyTypeObject   py_array_view_type = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+};
+static PyBufferProcs  py_array_view_buffer;
+static PySequenceMethods  py_array_view_sequence;
+
+
+static void
+py_array_view_dealloc(PyObject *obj)
+{
+  py_array_view_t *self = (py_array_view_t *)obj;
+
+  vrna_mx_mfe_unref(self->mfe);
+  vrna_mx_pf_unref(self->pf);
+  free(self->owned);
+  Py_XDECREF(self->owner);
+  Py_TYPE(obj)->tp_free(obj);
+}
+
+
+static int
+py_array_view_getbuffer(PyObject  *obj,
+                        Py_buffer *view,
+                        int       flags)
+{
+  py_array_view_t *self = (py_array_view_t *)obj;
+
+  if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+    PyErr_SetString(PyExc_BufferError, "DP matrix views are read-only");
+    view->obj = NULL;
+    return -1;
+  }
+
+  /*
+   *  buffers exported before are still safe to use, but new ones
+   *  must not show matrices that are no longer part of the fold compound
+   */
+  if (((self->mfe) && (self->fc->matrices != self->mfe)) ||
+      ((self->pf) && (self->fc->exp_matrices != self->pf))) {
+    PyErr_Format(PyExc_BufferError,
+                 "DP matrix \"%s\" has been re-allocated, request a new view",
+                 self->name);
+    view->obj = NULL;
+    return -1;
+  }
+
+  view->obj         = obj;
+  view->buf         = self->data;
+  view->len         = self->length * self->itemsize;
+  view->readonly    = 1;
+  view->itemsize    = self->itemsize;
+  view->format      = (flags & PyBUF_FORMAT) ? self->format : NULL;
+  view->ndim        = (flags & PyBUF_ND) ? self->ndim : 1;
+  view->shape       = (flags & PyBUF_ND) ? self->shape : NULL;
+  view->strides     = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? self->strides : NULL;
+  view->suboffsets  = NULL;
+  view->internal    = NULL;
+
+  Py_INCREF(obj);
+
+  return 0;
+}
+
+
+static Py_ssize_t
+py_array_view_length(PyObject *obj)
+{
+  return ((py_array_view_t *)obj)->length;
+}
+
+
+/* takes over the references to the matrices mfe and pf */
+static PyObject *
+py_array_view_new(PyObject              *owner,
+                  vrna_fold_compound_t  *fc,
+                  vrna_mx_mfe_t         *mfe,
+                  vrna_mx_pf_t          *pf,
+                  const char            *name,
+                  void                  *data,
+                  Py_ssize_t            length,
+                  Py_ssize_t            itemsize,
+                  const char            *format)
+{
+  py_array_view_t *self;
+
+  if (!data) {
+    vrna_mx_mfe_unref(mfe);
+    vrna_mx_pf_unref(pf);
+    Py_RETURN_NONE;
+  }
+
+  if (!py_array_view_type.tp_flags) {
+    py_array_view_buffer.bf_getbuffer   = py_array_view_getbuffer;
+    py_array_view_sequence.sq_length    = py_array_view_length;
+
+    py_array_view_type.tp_name          = "RNA.array_view";
+    py_array_view_type.tp_basicsize     = sizeof(py_array_view_t);
+    py_array_view_type.tp_dealloc       = py_array_view_dealloc;
+    py_array_view_type.tp_as_sequence   = &py_array_view_sequence;
+    py_array_view_type.tp_as_buffer     = &py_array_view_buffer;
+    py_array_view_type.tp_flags         = Py_TPFLAGS_DEFAULT;
+#if PY_VERSION_HEX < 0x03000000
+    py_array_view_type.tp_flags         |= Py_TPFLAGS_HAVE_NEWBUFFER;
+#endif
+    py_array_view_type.tp_doc           = "Read-only view of a dynamic programming matrix of a fold compound";
+
+    if (PyType_Ready(&py_array_view_type) < 0) {
+      py_array_view_type.tp_flags = 0;
+      vrna_mx_mfe_unref(mfe);
+      vrna_mx_pf_unref(pf);
+      return NULL;
+    }
+  }
+
+  self = PyObject_New(py_array_view_t, &py_array_view_type);
+  if (!self) {
+    vrna_mx_mfe_unref(mfe);
+    vrna_mx_pf_unref(pf);
+    return NULL;
+  }
+
+  Py_INCREF(owner);
+  self->owner       = owner;
+  self->fc          = fc;
+  self->mfe         = mfe;
+  self->pf          = pf;
+  self->name        = name;
+  self->data        = data;
+  self->owned       = NULL;
+  self->length      = length;
+  self->itemsize    = itemsize;
+  self->format      = (char *)format;
+  self->ndim        = 1;
+  self->shape[0]    = length;
+  self->shape[1]    = 0;
+  self->strides[0]  = itemsize;
+  self->strides[1]  = 0;
+
+  return (PyObject *)self;
+}
+
+
+/* returns the static copy of a known matrix name, or NULL */
+static const char *
+fc_array_view_known(const char *name)
+{
+  static const char *names[] = {
+    "iindx", "jindx",
+    "c", "fML", "fM1", "f5", "f3", "fc", "fM2",
+    "probs", "q", "qb", "qm", "qm1", "q1k", "qln", "qm2", "scale", "expMLbase",
+    NULL
+  };
+  const char        **ptr;
+
+  for (ptr = names; *ptr; ptr++)
+    if (!strcmp(name, *ptr))
+      return *ptr;
+
+  return NULL;
+}
+
+
+/*
+ *  Collect the unpaired probabilities passed to the vrna_probs_window()
+ *  callback into a single (n + 1) x (ulength + 1) array, such that entry
+ *  [i][u] is the probability that the u nucleotides up to i are unpaired
+ */
+typedef struct {
+  double  *up;
+  int     ulength;
+} fc_unpaired_data_t;
+
+
+static void
+fc_unpaired_cb(FLT_OR_DBL    *pr,
+               int           pr_size,
+               int           i,
+               int           max,
+               unsigned int  type,
+               void          *data)
+{
+  int                 u;
+  double              *pU = (double *)pr;
+  fc_unpaired_data_t  *d  = (fc_unpaired_data_t *)data;
+
+  if ((type & VRNA_PROBS_WINDOW_UP) && ((type & VRNA_ANY_LOOP) == VRNA_ANY_LOOP))
+    for (u = 1; (u <= pr_size) && (u <= d->ulength); u++)
+      d->up[(size_t)i * (d->ulength + 1) + u] = pU[u];
+}
+
+
+static PyObject *
+fc_unpaired_view(PyObject *fc_obj,
+                 int      ulength)
+{
+  int                   ret;
+  void                  *ptr;
+  size_t                n;
+  py_array_view_t       *self;
+  fc_unpaired_data_t    d;
+  vrna_fold_compound_t  *fc;
+
+  if (!SWIG_IsOK(SWIG_ConvertPtr(fc_obj, &ptr, SWIGTYPE_p_vrna_fold_compound_t, 0))) {
+    PyErr_SetString(PyExc_TypeError, "argument must be a fold_compound");
+    return NULL;
+  }
+
+  fc = (vrna_fold_compound_t *)ptr;
+
+  if ((ulength < 1) || (fc->type != VRNA_FC_TYPE_SINGLE)) {
+    PyErr_SetString(PyExc_ValueError,
+                    "unpaired probabilities require ulength > 0 and a single sequence fold compound");
+    return NULL;
+  }
+
+  n         = fc->length;
+  d.ulength = ulength;
+  d.up      = (double *)calloc((n + 1) * (size_t)(ulength + 1), sizeof(double));
+  if (!d.up)
+    return PyErr_NoMemory();
+
+  Py_BEGIN_ALLOW_THREADS
+  ret = vrna_probs_window(fc, ulength, VRNA_PROBS_WINDOW_UP, &fc_unpaired_cb, (void *)&d);
+  Py_END_ALLOW_THREADS
+
+  if (!ret) {
+    free(d.up);
+    PyErr_SetString(PyExc_RuntimeError, "failed to compute unpaired probabilities");
+    return NULL;
+  }
+
+  self = (py_array_view_t *)py_array_view_new(fc_obj,
+                                              fc,
+                                              NULL,
+                                              NULL,
+                                              "unpaired",
+                                              (void *)d.up,
+                                              (Py_ssize_t)((n + 1) * (ulength + 1)),
+                                              sizeof(double),
+                                              "d");
+  if (!self) {
+    free(d.up);
+    return NULL;
+  }
+
+  self->owned       = d.up;
+  self->ndim        = 2;
+  self->shape[0]    = (Py_ssize_t)(n + 1);
+  self->shape[1]    = (Py_ssize_t)(ulength + 1);
+  self->strides[0]  = (Py_ssize_t)((ulength + 1) * sizeof(double));
+  self->strides[1]  = sizeof(double);
+
+  return (PyObject *)self;
+}
+
+
+static PyObject *
+fc_array_view(PyObject    *fc_obj,
+              const char  *name)
+{
+  void                  *ptr, *data;
+  Py_ssize_t            n, size, lin_size, length, itemsize;
+  const char            *format, *known;
+  vrna_fold_compound_t  *fc;
+  vrna_mx_mfe_t         *mfe_ref;
+  vrna_mx_pf_t          *pf_ref;
+
+  if (!SWIG_IsOK(SWIG_ConvertPtr(fc_obj, &ptr, SWIGTYPE_p_vrna_fold_compound_t, 0))) {
+    PyErr_SetString(PyExc_TypeError, "argument must be a fold_compound");
+    return NULL;
+  }
+
+  fc        = (vrna_fold_compound_t *)ptr;
+  mfe_ref   = NULL;
+  pf_ref    = NULL;
+  data      = NULL;
+  length    = 0;
+  itemsize  = sizeof(int);
+  format    = "i";
+
+  if (!strcmp(name, "iindx")) {
+    data    = fc->iindx;
+    length  = fc->length + 1;
+  } else if (!strcmp(name, "jindx")) {
+    data    = fc->jindx;
+    length  = fc->length + 1;
+  } else if ((fc->matrices) &&
+             (fc->matrices->type == VRNA_MX_DEFAULT) &&
+             ((!strcmp(name, "c")) ||
+              (!strcmp(name, "fML")) ||
+              (!strcmp(name, "fM1")) ||
+              (!strcmp(name, "f5")) ||
+              (!strcmp(name, "f3")) ||
+              (!strcmp(name, "fc")) ||
+              (!strcmp(name, "fM2")))) {
+    vrna_mx_mfe_t *mx = mfe_ref = vrna_mx_mfe_ref(fc);
+
+    n         = mx->length;
+    size      = ((n + 1) * (n + 2)) / 2;
+    lin_size  = n + 2;
+
+    if (!strcmp(name, "c")) {
+      data    = mx->c;
+      length  = size;
+    } else if (!strcmp(name, "fML")) {
+      data    = mx->fML;
+      length  = size;
+    } else if (!strcmp(name, "fM1")) {
+      data    = mx->fM1;
+      length  = size;
+    } else if (!strcmp(name, "f5")) {
+      data    = mx->f5;
+      length  = lin_size;
+    } else if (!strcmp(name, "f3")) {
+      data    = mx->f3;
+      length  = lin_size;
+    } else if (!strcmp(name, "fc")) {
+      data    = mx->fc;
+      length  = lin_size;
+    } else {
+      data    = mx->fM2;
+      length  = lin_size;
+    }
+  } else if ((fc->exp_matrices) &&
+             (fc->exp_matrices->type == VRNA_MX_DEFAULT)) {
+    vrna_mx_pf_t *mx = pf_ref = vrna_mx_pf_ref(fc);
+
+    n         = mx->length;
+    size      = ((n + 1) * (n + 2)) / 2;
+    lin_size  = n + 2;
+    itemsize  = sizeof(FLT_OR_DBL);
+    format    = (sizeof(FLT_OR_DBL) == sizeof(float)) ? "f" : "d";
+
+    if (!strcmp(name, "probs")) {
+      data    = mx->probs;
+      length  = size;
+    } else if (!strcmp(name, "q")) {
+      data    = mx->q;
+      length  = size;
+    } else if (!strcmp(name, "qb")) {
+      data    = mx->qb;
+      length  = size;
+    } else if (!strcmp(name, "qm")) {
+      data    = mx->qm;
+      length  = size;
+    } else if (!strcmp(name, "qm1")) {
+      data    = mx->qm1;
+      length  = size;
+    } else if (!strcmp(name, "q1k")) {
+      data    = mx->q1k;
+      length  = lin_size;
+    } else if (!strcmp(name, "qln")) {
+      data    = mx->qln;
+      length  = lin_size;
+    } else if (!strcmp(name, "qm2")) {
+      data    = mx->qm2;
+      length  = lin_size;
+    } else if (!strcmp(name, "scale")) {
+      data    = mx->scale;
+      length  = lin_size;
+    } else if (!strcmp(name, "expMLbase")) {
+      data    = mx->expMLbase;
+      length  = lin_size;
+    }
+  }
+
+  known = fc_array_view_known(name);
+  if (!known) {
+    vrna_mx_mfe_unref(mfe_ref);
+    vrna_mx_pf_unref(pf_ref);
+    PyErr_Format(PyExc_ValueError, "unknown DP matrix \"%s\"", name);
+    return NULL;
+  }
+
+  return py_array_view_new(fc_obj, fc, mfe_ref, pf_ref, known, data, length, itemsize, format);
+}
+
+%}
+
+%rename (_fc_array_view) fc_array_view;
+static PyObject *fc_array_view(PyObject *fc_obj, const char *name);
+%rename (_fc_unpaired_view) fc_unpaired_view;
+static PyObject *fc_unpaired_view(PyObject *fc_obj, int ulength);
+
+/*
+ *  The views need the Python object of the fold compound as owner,
+ *  so the methods are implemented on the Python side of the proxy class
+ */
+%extend vrna_fold_compound_t {
+
+%pythoncode %{
+def mx_view(self, name):
+    """
+    Zero-copy, read-only view of a dynamic programming matrix
+
+    Returns an object that implements the buffer protocol, e.g. for
+    numpy.asarray() or memoryview(), or None if the matrix is not
+    available. Triangular matrices are stored in a single array:
+    pair (i,j) of the partition function matrices (probs, q, qb, qm,
+    qm1) is at index iindx[i] - j, pair (i,j) of the MFE matrices
+    (c, fML, fM1) at index jindx[j] + i, see iindx_view() and
+    jindx_view(). Linear arrays (f5, f3, fc, fM2, q1k, qln, qm2,
+    scale, expMLbase) are indexed by the sequence position.
+
+    The view keeps the matrices alive. If the fold compound re-allocates
+    its matrices, e.g. because a subsequent computation requires a
+    different set of them, buffers obtained from the view before still
+    show the previous matrices, while requesting a new buffer raises a
+    BufferError. In that case, a new view has to be created.
+    """
+    return _fc_array_view(self, name)
+
+def bpp_view(self):
+    """
+    Zero-copy, read-only view of the base pair probabilities
+
+    The probability of pair (i,j), i < j, is at index iindx[i] - j, see
+    iindx_view(). Returns None if no probabilities were computed.
+    """
+    return _fc_array_view(self, "probs")
+
+def iindx_view(self):
+    """Zero-copy view of the row-wise index array of the fold compound"""
+    return _fc_array_view(self, "iindx")
+
+def jindx_view(self):
+    """Zero-copy view of the column-wise index array of the fold compound"""
+    return _fc_array_view(self, "jindx")
+
+def unpaired_view(self, ulength):
+    """
+    Read-only view of the unpaired probabilities of the sliding window approach
+
+    Computes the probabilities that stretches of up to ulength nucleotides
+    are unpaired, see probs_window() with PROBS_WINDOW_UP, and returns them
+    as a two-dimensional buffer of shape (n + 1, ulength + 1). Entry [i][u]
+    is the probability that the u nucleotides i - u + 1, ..., i are
+    unpaired. The data is stored in a single block owned by the view, so no
+    Python object is created per entry. As the computation uses the sliding
+    window DP matrices, views of the other DP matrices obtained before are
+    outdated afterwards.
+    """
+    return _fc_unpaired_view(self, ulength)
+%}
+
+}
+
+#endif
@@ -0,0 +1,77 @@
+/**********************************************/
+/* BEGIN interface for releasing the GIL      */
+/**********************************************/
+
+#ifdef SWIGPYTHON
+
+/*
+ *  Long running computations release the global interpreter lock (GIL), such
+ *  that other Python threads may proceed in the meantime. This is not possible
+ *  for fold compounds with Python callbacks attached, since the callbacks are
+ *  executed from within the computations.
+ */
+%{
+
+static int fc_has_pycallbacks(vrna_fold_compound_t *fc);
+
+%}
+
+/* the callback wrappers are defined in the header section, so we go to the wrapper section */
+%wrapper %{
+
+static int
+fc_has_pycallbacks(vrna_fold_compound_t *fc)
+{
+  if (fc->stat_cb == &py_wrap_fc_status_callback)
+    return 1;
+
+  if ((fc->type == VRNA_FC_TYPE_SINGLE) &&
+      (fc->sc) &&
+      ((fc->sc->f == &py_wrap_sc_f_callback) ||
+       (fc->sc->exp_f == &py_wrap_sc_exp_f_callback) ||
+       (fc->sc->bt == &py_wrap_sc_bt_callback)))
+    return 1;
+
+  if ((fc->domains_up) &&
+      (fc->domains_up->free_data == &delete_py_ud_callback))
+    return 1;
+
+  return 0;
+}
+
+%}
+
+%define %python_allow_threads(func, release)
+%exception func {
+  {
+    PyThreadState *_save = (release) ? PyEval_SaveThread() : NULL;
+    try {
+      $action
+    } catch (const std::exception& e) {
+      if (_save)
+        PyEval_RestoreThread(_save);
+      SWIG_exception(SWIG_RuntimeError, e.what());
+    }
+    if (_save)
+      PyEval_RestoreThread(_save);
+  }
+}
+%enddef
+
+%define %python_allow_threads_fc(method)
+%python_allow_threads(vrna_fold_compound_t::method, !fc_has_pycallbacks(arg1))
+%enddef
+
+%python_allow_threads_fc(mfe);
+%python_allow_threads_fc(mfe_dimer);
+%python_allow_threads_fc(mfe_mutate);
+%python_allow_threads_fc(pf);
+%python_allow_threads_fc(pf_dimer);
+%python_allow_threads_fc(subopt);
+%python_allow_threads_fc(subopt_zuker);
+%python_allow_threads_fc(pbacktrack);
+%python_allow_threads_fc(pbacktrack_nr);
+
+%python_allow_threads(my_fold_batch, 1);
+
+#endif
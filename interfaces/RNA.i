@@ -113,6 +113,11 @@ extern "C" {
   }
 }
 
+/* release the GIL in long running computations */
+#ifdef SWIGPYTHON
+%include "threads.i"
+#endif
+
 /* prepare conversions to native types, such as lists */
 %include "std_pair.i";
 %include "std_vector.i";
@@ -132,6 +137,7 @@ namespace std {
   %template(ElemProbVector) std::vector<vrna_ep_t>;
   %template(PathVector) std::vector<vrna_path_t>;
   %template(MoveVector) std::vector<vrna_move_t>;
+  %template(StringDoubleVectorPair) std::pair<std::vector<std::string>,std::vector<double> >;
 };
 
 %{
@@ -11,14 +11,23 @@
 #include <vector>
 
   std::string
-  my_consensus_sequence(std::vector<std::string> alignment, vrna_md_t *md_p = NULL)
+  my_consensus_sequence(std::vector<std::string>  alignment,
+                        vrna_md_t                 *md_p = NULL,
+                        std::vector<unsigned int> weights = std::vector<unsigned int>())
   {
     /* convert std::vector<std::string> to vector<const char *> */
     std::vector<const char*>  v;
     std::transform(alignment.begin(), alignment.end(), std::back_inserter(v), convert_vecstring2veccharcp);
     v.push_back(NULL); /* mark end of sequences */
 
-    char *c = vrna_aln_consensus_sequence((const char **)&v[0], md_p);
+    if ((!weights.empty()) && (weights.size() != alignment.size())) {
+      vrna_message_warning("aln_consensus_sequence(): number of weights does not match number of sequences!");
+      return std::string("");
+    }
+
+    char *c = vrna_aln_consensus_sequence_weighted((const char **)&v[0],
+                                                   (weights.empty()) ? NULL : &weights[0],
+                                                   md_p);
     std::string cons(c);
     free(c);
     return cons;
@@ -48,13 +57,16 @@
 #endif
 
 std::string
-my_consensus_sequence(std::vector<std::string> alignment, vrna_md_t *md_p = NULL);
+my_consensus_sequence(std::vector<std::string>  alignment,
+                      vrna_md_t                 *md_p = NULL,
+                      std::vector<unsigned int> weights = std::vector<unsigned int>());
 
 std::string
 my_aln_consensus_mis(std::vector<std::string> alignment, vrna_md_t *md_p = NULL);
 
 %ignore consensus;
 %ignore consens_mis;
+%ignore vrna_aln_consensus_sequence_weighted;
 
 
 %rename (aln_mpi) my_aln_mpi;
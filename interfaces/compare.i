@@ -29,6 +29,10 @@ int    loop_degree[1000];     // loop degrees of a structure
 int    loops;                 // n of loops and stacks
 int    unpaired, pairs;       // n of unpaired digits and pairs
 
+%ignore tree_edit_distance_matrix;
+%ignore string_edit_distance_matrix;
+%ignore profile_edit_distance_matrix;
+
 %include  <ViennaRNA/treedist.h>
 %include  <ViennaRNA/stringdist.h>
 %newobject Make_bp_profile;
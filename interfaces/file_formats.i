@@ -38,6 +38,14 @@ std::vector<double> my_file_SHAPE_read( const char *file_name,
 %clear int *status;
 %clear std::string *shape_sequence;
 
+/* the buffered FASTA readers hand out views into their read buffer */
+%ignore vrna_fasta_reader_s;
+%ignore vrna_fasta_record_t;
+%ignore vrna_file_fasta_reader_init;
+%ignore vrna_file_fasta_reader_open;
+%ignore vrna_file_fasta_read_record_view;
+%ignore vrna_file_fasta_reader_free;
+
 %include <ViennaRNA/io/file_formats.h>
 
 /**********************************************/
@@ -10,6 +10,11 @@
 %include callbacks-mfe-window.i
 %include callbacks-pf-window.i
 
+/* add zero-copy views of the DP matrices */
+#ifdef SWIGPYTHON
+%include array_views.i
+#endif
+
 /* start constructing a sane interface to vrna_fold_compound_t */
 
 /* first we remap the fold_compound type enum entries */
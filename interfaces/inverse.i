@@ -55,8 +55,67 @@ char * my_inverse_fold(char *start, const char *target, float *OUTPUT);
 %newobject my_inverse_pf_fold;
 char * my_inverse_pf_fold(char *start, const char *target, float *OUTPUT);
 
+%rename (inverse_fold_multistart) my_inverse_fold_multistart;
+%{
+  char *my_inverse_fold_multistart(char         *start,
+                                   const char   *target,
+                                   unsigned int num_starts,
+                                   float        *cost,
+                                   int          num_threads,
+                                   unsigned int options) {
+    char *seq;
+    int n;
+    n = strlen(target);
+    seq = vrna_random_string(n, symbolset);
+    if (start)
+      strncpy(seq, start, n);
+    *cost = inverse_fold_multistart(seq, target, num_starts, num_threads, options);
+    return(seq);
+  }
+%}
+
+#ifdef SWIGPYTHON
+%feature("autodoc") my_inverse_fold_multistart;
+%feature("kwargs") my_inverse_fold_multistart;
+#endif
+
+%newobject my_inverse_fold_multistart;
+char * my_inverse_fold_multistart(char *start, const char *target, unsigned int num_starts, float *OUTPUT, int num_threads = 0, unsigned int options = 0);
+
 %ignore inverse_fold;
 %ignore inverse_pf_fold;
+%ignore inverse_fold_multistart;
+%ignore inverse_pf_fold_multistart;
+%ignore vrna_inverse;
+%ignore vrna_inverse_opt_defaults;
+%ignore vrna_inverse_opt_t;
+
+/* re-entrant design that starts with the sequence of the fold compound */
+%newobject vrna_fold_compound_t::inverse;
+
+%extend vrna_fold_compound_t {
+
+#ifdef SWIGPYTHON
+%feature("autodoc") inverse;
+%feature("kwargs") inverse;
+#endif
+
+  char *inverse(const char    *target,
+                float         *OUTPUT,
+                unsigned int  type  = VRNA_INVERSE_MFE,
+                unsigned int  seed  = 0)
+  {
+    char                *seq;
+    vrna_inverse_opt_t  opt;
+
+    vrna_inverse_opt_defaults(&opt);
+    opt.type  = type;
+    opt.seed  = seed;
+    seq       = strdup($self->sequence);
+    *OUTPUT   = vrna_inverse($self, target, seq, &opt);
+    return seq;
+  }
+}
 
 
 %init %{
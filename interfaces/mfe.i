@@ -198,9 +198,53 @@ char *my_alifold(std::vector<std::string> alignment, char *constraints, float *O
 %ignore get_alipf_arrays;
 %ignore update_alifold_params;
 
+/* MFE prediction for a list of sequences, distributed over multiple threads */
+%rename (fold_batch) my_fold_batch;
+
+%{
+  std::pair<std::vector<std::string>, std::vector<double> >
+  my_fold_batch(std::vector<std::string> sequences,
+                vrna_md_t                *md = NULL,
+                int                      threads = 0)
+  {
+    std::pair<std::vector<std::string>, std::vector<double> > result;
+    std::vector<const char*>  vc;
+    char                      **structures;
+    float                     *mfes;
+
+    transform(sequences.begin(), sequences.end(), back_inserter(vc), convert_vecstring2veccharcp);
+    vc.push_back(NULL); /* mark end of sequences */
+
+    structures  = (char **)vrna_alloc(sizeof(char *) * (sequences.size() + 1));
+    mfes        = vrna_fold_batch((const char **)&vc[0], md, structures, threads);
+
+    for (size_t i = 0; i < sequences.size(); i++) {
+      result.first.push_back(std::string(structures[i]));
+      result.second.push_back((double)mfes[i]);
+      free(structures[i]);
+    }
+
+    free(structures);
+    free(mfes);
+
+    return result;
+  }
+%}
+
+#ifdef SWIGPYTHON
+%feature("autodoc") my_fold_batch;
+%feature("kwargs") my_fold_batch;
+#endif
+
+std::pair<std::vector<std::string>, std::vector<double> >
+my_fold_batch(std::vector<std::string> sequences,
+              vrna_md_t                *md = NULL,
+              int                      threads = 0);
+
 /* tell swig that these functions return objects that require memory management */
 %newobject vrna_fold_compound_t::mfe;
 %newobject vrna_fold_compound_t::mfe_dimer;
+%newobject vrna_fold_compound_t::mfe_mutate;
 
 %extend vrna_fold_compound_t {
 
@@ -209,6 +253,8 @@ char *my_alifold(std::vector<std::string> alignment, char *constraints, float *O
 %feature("kwargs") mfe;
 %feature("autodoc") mfe_dimer;
 %feature("kwargs") mfe_dimer;
+%feature("autodoc") mfe_mutate;
+%feature("kwargs") mfe_mutate;
 #endif
 
   char *mfe(float *OUTPUT){
@@ -225,6 +271,14 @@ char *my_alifold(std::vector<std::string> alignment, char *constraints, float *O
     *OUTPUT = vrna_mfe_dimer($self, structure);
     return structure;
   }
+
+  /* MFE of a point-mutated sequence, re-using the previous DP matrices */
+  char *mfe_mutate(const char *sequence, float *OUTPUT){
+
+    char *structure = (char*)vrna_alloc(sizeof(char) * ($self->length + 1));
+    *OUTPUT = vrna_mfe_mutate($self, sequence, structure);
+    return structure;
+  }
 }
 
 %include <ViennaRNA/alifold.h>
@@ -25,6 +25,13 @@
 
 %ignore vrna_hx_t;
 %ignore vrna_hx_s;
+%ignore vrna_structure_set_t;
+%ignore vrna_structure_set_s;
+%ignore vrna_structure_set;
+%ignore vrna_structure_set_free;
+%ignore vrna_structure_set_bp_distances;
+%ignore vrna_structure_set_centroid;
+%ignore vrna_structure_set_medoid;
 %ignore vrna_ptable_from_string;
 %ignore vrna_db_flatten;
 %ignore vrna_db_flatten_to;
@@ -22,6 +22,7 @@
 %ignore urn;
 %ignore int_urn;
 */
+%ignore vrna_urn_stream;
 %ignore filecopy;
 %ignore time_stamp;
 
@@ -49,6 +49,7 @@ RNA_ENABLE_LTO
 RNA_ENABLE_SVM
 RNA_ENABLE_JSON
 RNA_ENABLE_GSL
+RNA_ENABLE_ZLIB
 RNA_ENABLE_OPENMP
 RNA_ENABLE_PTHREADS
 RNA_ENABLE_BOUSTROPHEDON
@@ -56,6 +57,7 @@ RNA_ENABLE_NR_SAMPLE_HASH
 RNA_ENABLE_FLOATPF
 RNA_ENABLE_DEPRECATION_WARNINGS
 RNA_ENABLE_COLORED_TTY
+RNA_ENABLE_TIMING
 RNA_ENABLE_STATIC_BIN
 RNA_ENABLE_SIMD
 RNA_ENABLE_VECTORIZE
@@ -223,6 +225,7 @@ Extra Libraries
 ---------------
   * Support Vector Machine    : ${with_svm:-no}
   * GNU Scientific Library    : ${with_gsl:-no}
+  * zlib                      : ${with_zlib:-no}
   * GNU MPFR                  : ${enable_mpfr:-no}
   * JSON                      : ${with_json:-no}
 
@@ -232,6 +235,7 @@ Features
   * Use hash for NR Sampling  : ${enable_NRhash:-no}
   * C11 features              : ${enable_c11:-no}
   * TTY colors                : ${enable_tty_colors:-no}
+  * Timing instrumentation    : ${enable_timing:-no}
   * Float Precision(PF}       : ${enable_floatpf:-no}
   * Deprecation Warnings      : ${enable_warn_deprecated:-no}
 
@@ -80,6 +80,39 @@ AC_DEFUN([RNA_ENABLE_GSL],[
 ])
 
 
+#
+# zlib support for compressed input
+#
+
+AC_DEFUN([RNA_ENABLE_ZLIB],[
+
+  RNA_ADD_PACKAGE([zlib],
+                  [support for gzip compressed input],
+                  [yes])
+
+  # check prerequisties for zlib support
+  RNA_PACKAGE_IF_ENABLED([zlib],[
+    AC_CHECK_HEADER([zlib.h], [
+      AC_CHECK_LIB([z],[inflateReset])
+    ])
+
+    if test "$ac_cv_lib_z_inflateReset" != yes; then
+      AC_MSG_WARN("Can't find zlib. Compressed input will not be supported.")
+      with_zlib="no"
+    fi
+  ])
+  RNA_PACKAGE_IF_ENABLED([zlib],[
+    AC_DEFINE([VRNA_WITH_ZLIB], [1], [Read gzip compressed input])
+    ZLIB_LIBS="-lz"
+    CONFIG_ZLIB="#define VRNA_WITH_ZLIB"
+  ])
+
+  AC_SUBST([ZLIB_LIBS])
+  AC_SUBST([CONFIG_ZLIB])
+  AM_CONDITIONAL(VRNA_AM_SWITCH_ZLIB, test "x$with_zlib" = "xyes")
+])
+
+
 #
 # Boustrophedon scheme for stochastic backtracking
 #
@@ -353,6 +386,26 @@ AC_DEFUN([RNA_ENABLE_COLORED_TTY],[
 ])
 
 
+#
+# Per-phase timing instrumentation
+#
+
+AC_DEFUN([RNA_ENABLE_TIMING],[
+
+  RNA_ADD_FEATURE([timing],
+                  [Per-phase timing instrumentation of the DP algorithms],
+                  [yes])
+
+  ## Add preprocessor define statement for the timing hooks in the DP algorithms
+  RNA_FEATURE_IF_ENABLED([timing],[
+    AC_DEFINE([VRNA_WITH_TIMING], [1], [Compile per-phase timing instrumentation])
+    CONFIG_TIMING="#define VRNA_WITH_TIMING"
+  ])
+
+  AC_SUBST(CONFIG_TIMING)
+])
+
+
 #
 # Statically linked executables
 #
@@ -32,6 +32,8 @@
 #define MYTURN 1
 #define SAME_STRAND(I,J) (((I)>=cut_point)||((J)<cut_point))
 #define ORDER(x,y) if ((x)->nummer>(y)->nummer) {tempb=x; x=y; y=tempb;}
+/* group of the moves of base pair r, 0 for the virtualroot */
+#define GROUP(sim,r) (((r)==(sim)->wurzl) ? 0 : (r)->nummer+1)
 
 /* item of structure ringlist */
 typedef struct _baum {
@@ -46,50 +48,53 @@ typedef struct _baum {
 } baum;
 
 static char UNUSED rcsid[]="$Id: baum.c,v 1.9 2008/05/21 10:15:45 ivo Exp $";
-static short *pairList = NULL;
-static short *typeList = NULL;
-static short *aliasList = NULL;
-static baum *rl = NULL;         /* ringlist */
-static baum *wurzl = NULL;      /* virtualroot of ringlist-tree */
-static char **ptype = NULL;
-
 static int comp_struc(const void *A, const void *B);
 /* PUBLIC FUNCTIONES */
-void ini_or_reset_rl (void);
-void move_it (void);
-void update_tree (int i, int j);
-void clean_up_rl (void);
+void ini_start_stop (void);
+void ini_or_reset_rl (SimState *sim);
+void move_it (SimState *sim);
+void update_tree (SimState *sim, int i, int j);
+void clean_up_rl (SimState *sim);
+void get_loop_energies (SimState *sim, int *E);
+void set_loop_energies (SimState *sim, const int *E);
 
 /* PRIVATE FUNCTIONES */
-static void ini_ringlist(void);
-static void reset_ringlist(void);
-static void struc2tree (char *struc);
-static void close_bp_en (baum *i, baum *j);
-static void close_bp (baum *i, baum *j);
-static void open_bp (baum *i);
-static void open_bp_en (baum *i);
-static void inb (baum *root);
-static void inb_nolp (baum *root);
-static void dnb (baum *rli);
-static void dnb_nolp (baum *rli);
-static void fnb (baum *rli);
-static void make_ptypes(const short *S);
+static void ini_ringlist(SimState *sim);
+static void reset_ringlist(SimState *sim);
+static void struc2tree (SimState *sim, char *struc);
+static void close_bp_en (SimState *sim, baum *i, baum *j);
+static void close_bp (SimState *sim, baum *i, baum *j);
+static void open_bp (SimState *sim, baum *i);
+static void open_bp_en (SimState *sim, baum *i);
+static void inb (SimState *sim, baum *root);
+static void inb_nolp (SimState *sim, baum *root);
+static void dnb (SimState *sim, baum *rli);
+static void dnb_nolp (SimState *sim, baum *rli);
+static void fnb (SimState *sim, baum *rli);
+static void make_ptypes(SimState *sim, const short *S);
+static baum *enclosing (baum *r);
+static void dirty_group (SimState *sim, int g);
+static void dirty_loop (SimState *sim, baum *r);
+static void stale_loop (SimState *sim, baum *r);
+static void update_loop_energies (SimState *sim);
+static void ini_groups (SimState *sim);
+static int loop_E (SimState *sim, baum *r);
 /* debugging tool(s) */
 #if 0
-static void rl_status(void);
+static void rl_status(SimState *sim);
 #endif
 
 /* convert structure in bracked-dot-notation to a ringlist-tree */
-static void struc2tree(char *struc) {
+static void struc2tree(SimState *sim, char *struc) {
   char* struc_copy;
   int ipos, jpos, balance = 0;
   baum *rli, *rlj;
 
-  struc_copy = (char *)calloc(GSV.len+1, sizeof(char));
+  struc_copy = (char *)calloc(sim->len+1, sizeof(char));
   assert(struc_copy);
   strcpy(struc_copy,struc);
 
-  for (ipos = 0; ipos < GSV.len; ipos++) {
+  for (ipos = 0; ipos < sim->len; ipos++) {
     if (struc_copy[ipos] == ')') {
       jpos = ipos;
       struc_copy[ipos] = '.';
@@ -97,40 +102,40 @@ static void struc2tree(char *struc) {
       while (struc_copy[--ipos] != '(');
       struc_copy[ipos] = '.';
       balance--;
-      rli = &rl[ipos];
-      rlj = &rl[jpos];
-      close_bp(rli, rlj);
+      rli = &sim->rl[ipos];
+      rlj = &sim->rl[jpos];
+      close_bp(sim, rli, rlj);
     }
   }
 
   if (balance) {
     fprintf(stderr,
 	    "struc2tree(): start structure is not balanced !\n%s\n%s\n",
-	    GAV.farbe, struc);
+	    sim->farbe, struc);
     exit(1);
   }
 
 #if HAVE_LIBRNA_API3
-  GSV.currE = GSV.startE = (float)vrna_eval_structure_pt(GAV.vc, pairList) / 100.0;
+  sim->currE = sim->startE = (float)vrna_eval_structure_pt(sim->vc, sim->pairList) / 100.0;
 #else
-  GSV.currE = GSV.startE =
-    (float )energy_of_struct_pt_par(GAV.farbe, pairList, typeList,
-				    aliasList, GAV.params, 0) / 100.0;
+  sim->currE = sim->startE =
+    (float )energy_of_struct_pt_par(sim->farbe, sim->pairList, sim->typeList,
+				    sim->aliasList, GAV.params, 0) / 100.0;
 #endif
   {
     int i;
-    for(i = 0; i < GSV.len; i++) {
-      if (pairList[i+1]>i+1)
+    for(i = 0; i < sim->len; i++) {
+      if (sim->pairList[i+1]>i+1)
 #if HAVE_LIBRNA_API3
-        rl[i].loop_energy = vrna_eval_loop_pt(GAV.vc, i+1, pairList);
+        sim->rl[i].loop_energy = vrna_eval_loop_pt(sim->vc, i+1, sim->pairList);
 #else
-	rl[i].loop_energy = loop_energy(pairList, typeList, aliasList,i+1);
+	sim->rl[i].loop_energy = loop_energy(sim->pairList, sim->typeList, sim->aliasList,i+1);
 #endif
     }
 #if HAVE_LIBRNA_API3
-    wurzl->loop_energy = vrna_eval_loop_pt(GAV.vc, 0, pairList);
+    sim->wurzl->loop_energy = vrna_eval_loop_pt(sim->vc, 0, sim->pairList);
 #else
-    wurzl->loop_energy = loop_energy(pairList, typeList, aliasList,0);
+    sim->wurzl->loop_energy = loop_energy(sim->pairList, sim->typeList, sim->aliasList,0);
 #endif
   }
 
@@ -138,233 +143,236 @@ static void struc2tree(char *struc) {
 }
 
 /**/
-static void ini_ringlist(void) {
+static void ini_ringlist(SimState *sim) {
   int i;
 
   /* needed by function energy_of_struct_pt() from Vienna-RNA-1.4 */
-  pairList = (short *)calloc(GSV.len + 2, sizeof(short));
-  assert(pairList != NULL);
-  typeList = (short *)calloc(GSV.len + 2, sizeof(short));
-  assert(typeList != NULL);
-  aliasList = (short *)calloc(GSV.len + 2, sizeof(short));
-  assert(aliasList != NULL);
-  pairList[0] = typeList[0] = aliasList[0] = GSV.len;
-  ptype =  (char **)calloc(GSV.len + 2, sizeof(char *));
-  assert(ptype != NULL);
-  for (i=0; i<=GSV.len; i++) {
-    ptype[i] =   (char*)calloc(GSV.len + 2, sizeof(char));
-    assert(ptype[i] != NULL);
+  sim->pairList = (short *)calloc(sim->len + 2, sizeof(short));
+  assert(sim->pairList != NULL);
+  sim->typeList = (short *)calloc(sim->len + 2, sizeof(short));
+  assert(sim->typeList != NULL);
+  sim->aliasList = (short *)calloc(sim->len + 2, sizeof(short));
+  assert(sim->aliasList != NULL);
+  sim->pairList[0] = sim->typeList[0] = sim->aliasList[0] = sim->len;
+  sim->ptype =  (char **)calloc(sim->len + 2, sizeof(char *));
+  assert(sim->ptype != NULL);
+  for (i=0; i<=sim->len; i++) {
+    sim->ptype[i] =   (char*)calloc(sim->len + 2, sizeof(char));
+    assert(sim->ptype[i] != NULL);
   }
 
   /* allocate virtual root */
-  wurzl = (baum *)calloc(1, sizeof(baum));
-  assert(wurzl != NULL);
+  sim->wurzl = (baum *)calloc(1, sizeof(baum));
+  assert(sim->wurzl != NULL);
   /* allocate ringList */
-  rl = (baum *)calloc(GSV.len+1, sizeof(baum));
-  assert(rl != NULL);
+  sim->rl = (baum *)calloc(sim->len+1, sizeof(baum));
+  assert(sim->rl != NULL);
   /* allocate PostOrderList */
 
   /* initialize virtualroot */
-  wurzl->typ = 'r';
-  wurzl->nummer = -1;
+  sim->wurzl->typ = 'r';
+  sim->wurzl->nummer = -1;
   /* connect virtualroot to ringlist-tree in down direction */
-  wurzl->down = &rl[GSV.len];
+  sim->wurzl->down = &sim->rl[sim->len];
   /* initialize post-order list */
 
+  /* pair matrix may be thread-private, so set it up in each thread */
   make_pair_matrix();
 
   /* initialize rest of ringlist-tree */
-  for(i = 0; i < GSV.len; i++) {
+  for(i = 0; i < sim->len; i++) {
     int c;
-    GAV.currform[i] = '.';
-    GAV.prevform[i] = 'x';
-    pairList[i+1] = 0;
-    rl[i].typ = 'u';
+    sim->currform[i] = '.';
+    sim->prevform[i] = 'x';
+    sim->pairList[i+1] = 0;
+    sim->rl[i].typ = 'u';
     /* decode base to numeric value */
-    c = encode_char(GAV.farbe[i]);
-    rl[i].base = typeList[i+1] = c;
-    aliasList[i+1] = alias[typeList[i+1]];
+    c = encode_char(sim->farbe[i]);
+    sim->rl[i].base = sim->typeList[i+1] = c;
+    sim->aliasList[i+1] = alias[sim->typeList[i+1]];
     /* astablish links for node of the ringlist-tree */
-    rl[i].nummer = i;
-    rl[i].next = &rl[i+1];
-    rl[i].prev = ((i == 0) ? &rl[GSV.len] : &rl[i-1]);
-    rl[i].up = rl[i].down = NULL;
+    sim->rl[i].nummer = i;
+    sim->rl[i].next = &sim->rl[i+1];
+    sim->rl[i].prev = ((i == 0) ? &sim->rl[sim->len] : &sim->rl[i-1]);
+    sim->rl[i].up = sim->rl[i].down = NULL;
   }
-  GAV.currform[GSV.len] =   GAV.prevform[GSV.len] = '\0';
-  make_ptypes(aliasList);
+  sim->currform[sim->len] =   sim->prevform[sim->len] = '\0';
+  make_ptypes(sim, sim->aliasList);
 
-  rl[i].nummer = i;
-  rl[i].base = 0;
+  sim->rl[i].nummer = i;
+  sim->rl[i].base = 0;
   /* make ringlist circular in next, prev direction */
-  rl[i].next = &rl[0];
-  rl[i].prev = &rl[i-1];
+  sim->rl[i].next = &sim->rl[0];
+  sim->rl[i].prev = &sim->rl[i-1];
   /* make virtual basepair for virtualroot */
-  rl[i].up = wurzl;
-  rl[i].typ = 'x';
+  sim->rl[i].up = sim->wurzl;
+  sim->rl[i].typ = 'x';
 
 }
 
-/**/
-void ini_or_reset_rl(void) {
-
-  /* if there is no ringList-tree make a new one */
-  if (wurzl == NULL) {
-    ini_ringlist();
+/*
+  energies of start and stop structure(s), the Mfe is taken as stop
+  structure unless stop structures are given; done once before any
+  simulation starts
+*/
+void ini_start_stop(void) {
 
-    /* start structure */
-    struc2tree(GAV.startform);
 #if HAVE_LIBRNA_API3
-    GSV.currE = GSV.startE = vrna_eval_structure(GAV.vc, GAV.startform);
+  GSV.startE = vrna_eval_structure(GAV.vc, GAV.startform);
 #else
-    GSV.currE = GSV.startE = energy_of_structure(GAV.farbe, GAV.startform, 0);
+  GSV.startE = energy_of_structure(GAV.farbe, GAV.startform, 0);
 #endif
 
-    /* stop structure(s) */
-    if ( GTV.stop )  {
-      int i;
+  /* stop structure(s) */
+  if ( GTV.stop )  {
+    int i;
 
-      qsort(GAV.stopform, GSV.maxS, sizeof(char *), comp_struc);
+    qsort(GAV.stopform, GSV.maxS, sizeof(char *), comp_struc);
 #if HAVE_LIBRNA_API3
-      /*
-        note that we need to hack the full length into GAV.vc again,
-        in case it was shortened due to chain growth simulation
-      */
-      unsigned int n, tmp_n;
-      n     = strlen(GAV.farbe_full);
-      tmp_n = GAV.vc->length;
-      GAV.vc->length = n;
-      for (i = 0; i< GSV.maxS; i++)
-        GAV.sE[i] = vrna_eval_structure(GAV.vc, GAV.stopform[i]);
-      GAV.vc->length = tmp_n;
+    for (i = 0; i< GSV.maxS; i++)
+      GAV.sE[i] = vrna_eval_structure(GAV.vc, GAV.stopform[i]);
 #else
-      for (i = 0; i< GSV.maxS; i++)
-	GAV.sE[i] = energy_of_structure(GAV.farbe_full, GAV.stopform[i], 0);
+    for (i = 0; i< GSV.maxS; i++)
+      GAV.sE[i] = energy_of_structure(GAV.farbe_full, GAV.stopform[i], 0);
 #endif
-    }
-    else {
+  }
+  else {
 #if HAVE_LIBRNA_API3
-      /* fold sequence to get Minimum free energy structure (Mfe) */
-      /*
-        note that we need to hack the full length into GAV.vc again,
-        in case it was shortened due to chain growth simulation
-      */
-      unsigned int n, tmp_n;
-      n     = strlen(GAV.farbe_full);
-      tmp_n = GAV.vc->length;
-      GAV.vc->length = n;
-      GAV.sE[0] = vrna_mfe_dimer(GAV.vc, GAV.stopform[0]);
-      vrna_mx_mfe_free(GAV.vc);
-      /* revaluate energy of Mfe (maye differ if --logML=logarthmic */
-      GAV.sE[0] = vrna_eval_structure(GAV.vc, GAV.stopform[0]);
-      GAV.vc->length = tmp_n;
+    /* fold sequence to get Minimum free energy structure (Mfe) */
+    GAV.sE[0] = vrna_mfe_dimer(GAV.vc, GAV.stopform[0]);
+    vrna_mx_mfe_free(GAV.vc);
+    /* revaluate energy of Mfe (maye differ if --logML=logarthmic */
+    GAV.sE[0] = vrna_eval_structure(GAV.vc, GAV.stopform[0]);
 #else
-      if(GTV.noLP)
-	noLonelyPairs=1;
-      initialize_cofold(GSV.len);
-      /* fold sequence to get Minimum free energy structure (Mfe) */
-      GAV.sE[0] = cofold(GAV.farbe_full, GAV.stopform[0]);
-      free_arrays();
-      /* revaluate energy of Mfe (maye differ if --logML=logarthmic */
-      GAV.sE[0] = energy_of_structure(GAV.farbe_full, GAV.stopform[0], 0);
+    if(GTV.noLP)
+      noLonelyPairs=1;
+    initialize_cofold(GSV.len);
+    /* fold sequence to get Minimum free energy structure (Mfe) */
+    GAV.sE[0] = cofold(GAV.farbe_full, GAV.stopform[0]);
+    free_arrays();
+    /* revaluate energy of Mfe (maye differ if --logML=logarthmic */
+    GAV.sE[0] = energy_of_structure(GAV.farbe_full, GAV.stopform[0], 0);
 #endif
-    }
-    GSV.stopE = GAV.sE[0];
-    ini_nbList(strlen(GAV.farbe_full)*strlen(GAV.farbe_full));
+  }
+  GSV.stopE = GAV.sE[0];
+}
+
+/**/
+void ini_or_reset_rl(SimState *sim) {
+
+  /* if there is no ringList-tree make a new one */
+  if (sim->wurzl == NULL) {
+    ini_ringlist(sim);
+
+    /* start structure */
+    struc2tree(sim, sim->startform);
+#if HAVE_LIBRNA_API3
+    sim->currE = sim->startE = vrna_eval_structure(sim->vc, sim->startform);
+#else
+    sim->currE = sim->startE = energy_of_structure(sim->farbe, sim->startform, 0);
+#endif
+    ini_nbList(sim, strlen(GAV.farbe_full)+1);
   }
   else {
     /* reset ringlist-tree to start conditions */
-    reset_ringlist();
-    if(GTV.start) struc2tree(GAV.startform);
+    reset_ringlist(sim);
+    if(GTV.start) struc2tree(sim, sim->startform);
     else {
-      GSV.currE = GSV.startE;
+      sim->currE = sim->startE;
     }
   }
+
+  /* all moves have to be generated */
+  ini_groups(sim);
 }
 
 /**/
-static void reset_ringlist(void) {
+static void reset_ringlist(SimState *sim) {
   int i;
 
-  for(i = 0; i < GSV.len; i++) {
-    GAV.currform[i] = '.';
-    GAV.prevform[i] = 'x';
-    pairList[i+1] = 0;
-    rl[i].typ = 'u';
-    rl[i].next = &rl[i + 1];
-    rl[i].prev = ((i == 0) ? &rl[GSV.len] : &rl[i - 1]);
-    rl[i].up = rl[i].down = NULL;
+  for(i = 0; i < sim->len; i++) {
+    sim->currform[i] = '.';
+    sim->prevform[i] = 'x';
+    sim->pairList[i+1] = 0;
+    sim->rl[i].typ = 'u';
+    sim->rl[i].next = &sim->rl[i + 1];
+    sim->rl[i].prev = ((i == 0) ? &sim->rl[sim->len] : &sim->rl[i - 1]);
+    sim->rl[i].up = sim->rl[i].down = NULL;
+    sim->rl[i].loop_energy = 0;
   }
-  rl[i].next = &rl[0];
-  rl[i].prev = &rl[i-1];
-  rl[i].up = wurzl;
+  sim->rl[i].next = &sim->rl[0];
+  sim->rl[i].prev = &sim->rl[i-1];
+  sim->rl[i].up = sim->wurzl;
+  /* loop energies of the open chain */
+  sim->wurzl->loop_energy = 0;
 }
 
 /* update ringlist-tree */
-void update_tree(int i, int j) {
+void update_tree(SimState *sim, int i, int j) {
 
   baum *rli, *rlj, *tempb;
 
-  if ( abs(i) < GSV.len) { /* >> single basepair move */
+  if ( abs(i) <= sim->len) { /* >> single basepair move */
     if ((i > 0) && (j > 0)) { /* insert */
-      rli = &rl[i-1];
-      rlj = &rl[j-1];
-      close_bp_en(rli, rlj);
+      rli = &sim->rl[i-1];
+      rlj = &sim->rl[j-1];
+      close_bp_en(sim, rli, rlj);
     }
     else if ((i < 0)&&(j < 0)) { /* delete */
       i = -i;
-      rli = &rl[i-1];
-      open_bp_en(rli);
+      rli = &sim->rl[i-1];
+      open_bp_en(sim, rli);
     }
     else { /* shift */
       if (i > 0) { /* i remains the same, j shifts */
 	j=-j;
-	rli=&rl[i-1];
-	rlj=&rl[j-1];
-	open_bp_en(rli);
+	rli=&sim->rl[i-1];
+	rlj=&sim->rl[j-1];
+	open_bp_en(sim, rli);
 	ORDER(rli, rlj);
-	close_bp_en(rli, rlj);
+	close_bp_en(sim, rli, rlj);
       }
       else { /* j remains the same, i shifts */
 	baum *old_rli;
 	i = -i;
-	rli = &rl[i-1];
-	rlj = &rl[j-1];
+	rli = &sim->rl[i-1];
+	rlj = &sim->rl[j-1];
 	old_rli = rlj->up;
-	open_bp_en(old_rli);
+	open_bp_en(sim, old_rli);
 	ORDER(rli, rlj);
-	close_bp_en(rli, rlj);
+	close_bp_en(sim, rli, rlj);
       }
     }
   } /* << single basepair move */
   else { /* >> double basepair move */
     if ((i > 0) && (j > 0)) { /* insert */
-      rli = &rl[i-GSV.len-2];
-      rlj = &rl[j-GSV.len-2];
-      close_bp_en(rli->next, rlj->prev);
-      close_bp_en(rli, rlj);
+      rli = &sim->rl[i-sim->len-2];
+      rlj = &sim->rl[j-sim->len-2];
+      close_bp_en(sim, rli->next, rlj->prev);
+      close_bp_en(sim, rli, rlj);
     }
     else if ((i < 0)&&(j < 0)) { /* delete */
       i = -i;
-      rli = &rl[i-GSV.len-2];
-      open_bp_en(rli);
-      open_bp_en(rli->next);
+      rli = &sim->rl[i-sim->len-2];
+      open_bp_en(sim, rli);
+      open_bp_en(sim, rli->next);
     }
   } /* << double basepair move */
 
 }
 
 /* open a particular base pair */
-void open_bp(baum *i) {
+void open_bp(SimState *sim, baum *i) {
 
   baum *in; /* points to i->next */
 
   /* change string representation */
-  GAV.currform[i->nummer] = '.';
-  GAV.currform[i->down->nummer] = '.';
+  sim->currform[i->nummer] = '.';
+  sim->currform[i->down->nummer] = '.';
 
   /* change pairtable representation */
-  pairList[1 + i->nummer] = 0;
-  pairList[1 + i->down->nummer] = 0;
+  sim->pairList[1 + i->nummer] = 0;
+  sim->pairList[1 + i->down->nummer] = 0;
 
   /* change tree representation */
   in = i->next;
@@ -378,17 +386,17 @@ void open_bp(baum *i) {
 }
 
 /* close a particular base pair */
-void close_bp (baum *i, baum *j) {
+void close_bp (SimState *sim, baum *i, baum *j) {
 
   baum *jn; /* points to j->next */
 
   /* change string representation */
-  GAV.currform[i->nummer] = '(';
-  GAV.currform[j->nummer] = ')';
+  sim->currform[i->nummer] = '(';
+  sim->currform[j->nummer] = ')';
 
   /* change pairtable representation */
-  pairList[1 + i->nummer] = 1+ j->nummer;
-  pairList[1 + j->nummer] = 1 + i->nummer;
+  sim->pairList[1 + i->nummer] = 1+ j->nummer;
+  sim->pairList[1 + j->nummer] = 1 + i->nummer;
 
   /* change tree representation */
   jn = j->next;
@@ -404,11 +412,11 @@ void close_bp (baum *i, baum *j) {
 
 # if 0
 /* for a given tree, generate postorder-list */
-static void make_poList (baum *root) {
+static void make_poList (SimState *sim, baum *root) {
 
   baum *stop, *rli;
 
-  if (!root) root = wurzl;
+  if (!root) root = sim->wurzl;
   stop = root->down;
 
   /* foreach base in ringlist ... */
@@ -417,11 +425,11 @@ static void make_poList (baum *root) {
     if (rli->typ == 'p') {
       /*  fprintf(stderr, "%d >%d<\n", poListop, rli->nummer); */
       poList[poListop++] = rli;
-      if ( poListop > GSV.len+1 ) {
+      if ( poListop > sim->len+1 ) {
 	fprintf(stderr, "Something went wrong in make_poList()\n");
 	exit(1);
       }
-      make_poList(rli);
+      make_poList(sim, rli);
     }
   }
   return;
@@ -430,9 +438,9 @@ static void make_poList (baum *root) {
 
 /* for a given ringlist, generate all structures
    with one additional basepair */
-static void inb(baum *root) {
+static void inb(SimState *sim, baum *root) {
 
-  int EoT;
+  int dE;
   int E_old, E_new_in, E_new_out;
   baum *stop,*rli,*rlj;
 
@@ -449,24 +457,23 @@ static void inb(baum *root) {
       /* potential j-position is already paired */
       if(rlj->typ=='p') continue;
       /* if i-j can form a base pair ... */
-      if(ptype[rli->nummer][rlj->nummer]){
+      if(sim->ptype[rli->nummer][rlj->nummer]){
 	/* close the base bair and ... */
-	close_bp(rli,rlj);
+	close_bp(sim, rli,rlj);
 #if HAVE_LIBRNA_API3
-        E_new_in  = vrna_eval_loop_pt(GAV.vc, rli->nummer+1, pairList);
-        E_new_out = vrna_eval_loop_pt(GAV.vc, root->nummer+1, pairList);
+        E_new_in  = vrna_eval_loop_pt(sim->vc, rli->nummer+1, sim->pairList);
+        E_new_out = vrna_eval_loop_pt(sim->vc, root->nummer+1, sim->pairList);
 #else
-	E_new_in  = loop_energy(pairList, typeList, aliasList,rli->nummer+1);
-	E_new_out = loop_energy(pairList, typeList, aliasList,root->nummer+1);
+	E_new_in  = loop_energy(sim->pairList, sim->typeList, sim->aliasList,rli->nummer+1);
+	E_new_out = loop_energy(sim->pairList, sim->typeList, sim->aliasList,root->nummer+1);
 #endif
-	/* ... evaluate energy of the structure */
-	EoT = (int) (GSV.currE*100 + ((GSV.currE<0)?-0.4:0.4)) +  E_new_in + E_new_out - E_old ;
-	/* assert(EoT ==  energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params)); */
+	/* ... evaluate energy change of the structure */
+	dE = E_new_in + E_new_out - E_old;
 	/* open the base pair again... */
-	open_bp(rli);
+	open_bp(sim, rli);
 	/* ... and put the move and the enegy
-	   of the structure into the neighbour list */
-	update_nbList(1 + rli->nummer, 1 + rlj->nummer, EoT);
+	   change into the neighbour list */
+	update_nbList(sim, 1 + rli->nummer, 1 + rlj->nummer, dE);
       }
     }
   }
@@ -474,10 +481,10 @@ static void inb(baum *root) {
 
 /* for a given ringlist, generate all structures (canonical)
    with one additional base pair (BUT WITHOUT ISOLATED BASE PAIRS) */
-static void inb_nolp(baum *root) {
+static void inb_nolp(SimState *sim, baum *root) {
 
-  int EoT = 0;
-  baum *stop, *rli, *rlj;
+  int dE = 0;
+  baum *stop, *rli, *rlj, *rlin;
 
   stop = root->down;
     /* loop ringlist over all possible i positions */
@@ -491,44 +498,38 @@ static void inb_nolp(baum *root) {
       /* potential j-position is already paired */
       if (rlj->typ=='p') continue;
       /* if i-j can form a base pair ... */
-      if (ptype[rli->nummer][rlj->nummer]) {
+      if (sim->ptype[rli->nummer][rlj->nummer]) {
 	/* ... and extends a helix ... */
 	if (((rli->prev==stop && rlj->next==stop) && stop->typ != 'x') ||
 	    (rli->next == rlj->prev)) {
 	  /* ... close the base bair and ... */
-	  close_bp(rli,rlj);
-	  /* ... evaluate energy of the structure */
-#if HAVE_LIBRNA_API3
-	  EoT = vrna_eval_structure_pt(GAV.vc, pairList);
-#else
-	  EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
-#endif
+	  close_bp(sim, rli,rlj);
+	  /* ... evaluate energy change of the structure */
+	  dE = loop_E(sim, rli) + loop_E(sim, root) - root->loop_energy;
 	  /* open the base pair again... */
-	  open_bp(rli);
+	  open_bp(sim, rli);
 	  /* ... and put the move and the enegy
-	     of the structure into the neighbour list */
-	  update_nbList(1 + rli->nummer, 1 + rlj->nummer, EoT);
+	     change into the neighbour list */
+	  update_nbList(sim, 1 + rli->nummer, 1 + rlj->nummer, dE);
 	}
 	/* if double insertion is possible ... */
 	else if ((rlj->nummer - rli->nummer >= MYTURN+2)&&
 		 (rli->next->typ != 'p' && rlj->prev->typ != 'p') &&
 		 (rli->next->next != rlj->prev->prev) &&
-		 (ptype[rli->next->nummer][rlj->prev->nummer])) {
+		 (sim->ptype[rli->next->nummer][rlj->prev->nummer])) {
 	  /* close the two base bair and ... */
-	  close_bp(rli->next, rlj->prev);
-	  close_bp(rli, rlj);
-	  /* ... evaluate energy of the structure */
-#if HAVE_LIBRNA_API3
-	  EoT = vrna_eval_structure_pt(GAV.vc, pairList);
-#else
-	  EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
-#endif
+	  rlin = rli->next;
+	  close_bp(sim, rlin, rlj->prev);
+	  close_bp(sim, rli, rlj);
+	  /* ... evaluate energy change of the structure */
+	  dE = loop_E(sim, rlin) + loop_E(sim, rli) + loop_E(sim, root)
+	    - root->loop_energy;
 	  /* open the two base pair again ... */
-	  open_bp(rli);
-	  open_bp(rli->next);
+	  open_bp(sim, rli);
+	  open_bp(sim, rli->next);
 	  /* ... and put the move and the enegy
-	     of the structure into the neighbour list */
-	  update_nbList(1+rli->nummer+GSV.len+1, 1+rlj->nummer+GSV.len+1, EoT);
+	     change into the neighbour list */
+	  update_nbList(sim, 1+rli->nummer+sim->len+1, 1+rlj->nummer+sim->len+1, dE);
 	}
       }
     }
@@ -537,38 +538,32 @@ static void inb_nolp(baum *root) {
 
 /* for a given ringlist, generate all structures
  with one less base pair */
-static void dnb(baum *rli){
+static void dnb(SimState *sim, baum *rli){
 
-  int EoT, E_old_in, E_old_out, E_new;
+  int dE, E_old_in, E_old_out, E_new;
 
   baum *rlj, *r;
 
   rlj=rli->down;
-  open_bp(rli);
+  open_bp(sim, rli);
   /* ... evaluate energy of the structure */
 
   for (r=rli->next; r->up==NULL; r=r->next);
   E_old_in = rli->loop_energy;
   E_old_out = r->up->loop_energy;
-#if HAVE_LIBRNA_API3
-  E_new = vrna_eval_loop_pt(GAV.vc, r->up->nummer+1, pairList);
-#else
-  E_new = loop_energy(pairList,typeList,aliasList,r->up->nummer+1);
-#endif
-  EoT = (int) (GSV.currE*100 + ((GSV.currE<0)?-0.4:0.4)) -
-    E_old_in - E_old_out + E_new;
+  E_new = loop_E(sim, r->up);
+  dE = E_new - E_old_in - E_old_out;
 
-  /* assert(EoT== energy_of_struct_pt(GAV.farbe, pairList, typeList, aliasList));*/
-  close_bp(rli,rlj);
-  update_nbList(-(1 + rli->nummer), -(1 + rlj->nummer), EoT);
+  close_bp(sim, rli,rlj);
+  update_nbList(sim, -(1 + rli->nummer), -(1 + rlj->nummer), dE);
 }
 
 /* for a given ringlist, generate all structures (canonical)
  with one less base pair (BUT WITHOUT ISOLATED BASE PAIRS) */
-static void dnb_nolp(baum *rli) {
+static void dnb_nolp(SimState *sim, baum *rli) {
 
-  int EoT = 0;
-  baum *rlj;
+  int dE = 0;
+  baum *rlj, *r;
   baum *rlin = NULL; /* pointers to following pair in helix, if any */
   baum *rljn = NULL;
   baum *rlip = NULL; /* pointers to preceding pair in helix, if any */
@@ -591,50 +586,50 @@ static void dnb_nolp(baum *rli) {
   /* double delete ? */
   if (rlip==NULL && rlin && rljn->next != rljn->prev ) {
     /* open the two base pairs ... */
-    open_bp(rli);
-    open_bp(rlin);
-    /* ... evaluate energy of the structure ... */
-#if HAVE_LIBRNA_API3
-    EoT = vrna_eval_structure_pt(GAV.vc, pairList);
-#else
-    EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
-#endif
+    open_bp(sim, rli);
+    open_bp(sim, rlin);
+    /* ... evaluate energy change of the structure ... */
+    for (r=rli->next; r->up==NULL; r=r->next);
+    dE = loop_E(sim, r->up)
+      - rli->loop_energy - rlin->loop_energy - r->up->loop_energy;
     /* ... and put the move and the enegy
-       of the structure into the neighbour list ... */
-    update_nbList(-(1+rli->nummer+GSV.len+1),-(1+rlj->nummer+GSV.len+1), EoT);
+       change into the neighbour list ... */
+    update_nbList(sim, -(1+rli->nummer+sim->len+1),-(1+rlj->nummer+sim->len+1), dE);
     /* ... and close the two base pairs again */
-    close_bp(rlin, rljn);
-    close_bp(rli, rlj);
+    close_bp(sim, rlin, rljn);
+    close_bp(sim, rli, rlj);
   } else { /* single delete */
     /* the following will work only if boolean expr are shortcicuited */
     if (rlip==NULL || (rlip->prev == rlip->next && rlip->prev->typ != 'x'))
       if (rlin ==NULL || (rljn->next == rljn->prev)) {
 	/* open the base pair ... */
-	open_bp(rli);
-	/* ... evaluate energy of the structure ... */
-#if HAVE_LIBRNA_API3
-	EoT = vrna_eval_structure_pt(GAV.vc, pairList);
-#else
-	EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
-#endif
+	open_bp(sim, rli);
+	/* ... evaluate energy change of the structure ... */
+	for (r=rli->next; r->up==NULL; r=r->next);
+	dE = loop_E(sim, r->up) - rli->loop_energy - r->up->loop_energy;
 	/* ... and put the move and the enegy
-	   of the structure into the neighbour list ... */
-	update_nbList(-(1 + rli->nummer),-(1 + rlj->nummer), EoT);
+	   change into the neighbour list ... */
+	update_nbList(sim, -(1 + rli->nummer),-(1 + rlj->nummer), dE);
 	/* and close the base pair again */
-	close_bp(rli, rlj);
+	close_bp(sim, rli, rlj);
       }
   }
 }
 
 /* for a given ringlist, generate all structures
  with one shifted base pair */
-static void fnb(baum *rli) {
+static void fnb(SimState *sim, baum *rli) {
 
-  int EoT = 0, x;
-  baum *rlj, *stop, *help_rli, *help_rlj;
+  int dE = 0, E_old, x;
+  baum *rlj, *stop, *help_rli, *help_rlj, *up;
 
   stop = rli->down;
 
+  /* a shift changes the loop closed by bp(ij) and the loop around it */
+  for (up=rli->next; up->up==NULL; up=up->next);
+  up = up->up;
+  E_old = rli->loop_energy + up->loop_energy;
+
   /* examin interior loop of bp(ij); (.......)
      i of j move                      ->   <- */
   for (rlj = stop->next; rlj != stop; rlj = rlj->next) {
@@ -642,43 +637,35 @@ static void fnb(baum *rli) {
     if ((rlj->typ=='p')||(rlj->typ=='q')) continue;
     /* j-position of base pair shifts to k position (ij)->(ik) i<k<j */
     if ( (rlj->nummer-rli->nummer >= MYTURN)
-	 && (ptype[rli->nummer][rlj->nummer]) ) {
+	 && (sim->ptype[rli->nummer][rlj->nummer]) ) {
       /* open original basepair */
-      open_bp(rli);
+      open_bp(sim, rli);
       /* close shifted version of original basepair */
-      close_bp(rli, rlj);
-      /* evaluate energy of the structure */
-#if HAVE_LIBRNA_API3
-      EoT = vrna_eval_structure_pt(GAV.vc, pairList);
-#else
-      EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
-#endif
-      /* put the move and the enegy of the structure into the neighbour list */
-      update_nbList(1+rli->nummer, -(1+rlj->nummer), EoT);
+      close_bp(sim, rli, rlj);
+      /* evaluate energy change of the structure */
+      dE = loop_E(sim, rli) + loop_E(sim, up) - E_old;
+      /* put the move and the enegy change into the neighbour list */
+      update_nbList(sim, 1+rli->nummer, -(1+rlj->nummer), dE);
       /* open shifted basepair */
-      open_bp(rli);
+      open_bp(sim, rli);
       /* restore original basepair */
-      close_bp(rli, stop);
+      close_bp(sim, rli, stop);
     }
     /* i-position of base pair shifts to position k (ij)->(kj) i<k<j */
     if ( (stop->nummer-rlj->nummer >= MYTURN)
-	 && (ptype[stop->nummer][rlj->nummer]) ) {
+	 && (sim->ptype[stop->nummer][rlj->nummer]) ) {
       /* open original basepair */
-      open_bp(rli);
+      open_bp(sim, rli);
       /* close shifted version of original basepair */
-      close_bp(rlj, stop);
-      /* evaluate energy of the structure */
-#if HAVE_LIBRNA_API3
-      EoT = vrna_eval_structure_pt(GAV.vc, pairList);
-#else
-      EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
-#endif
-      /* put the move and the enegy of the structure into the neighbour list */
-      update_nbList(-(1 + rlj->nummer), 1 + stop->nummer, EoT);
+      close_bp(sim, rlj, stop);
+      /* evaluate energy change of the structure */
+      dE = loop_E(sim, rlj) + loop_E(sim, up) - E_old;
+      /* put the move and the enegy change into the neighbour list */
+      update_nbList(sim, -(1 + rlj->nummer), 1 + stop->nummer, dE);
       /* open shifted basepair */
-      open_bp(rlj);
+      open_bp(sim, rlj);
       /* restore original basepair */
-      close_bp(rli, stop);
+      close_bp(sim, rli, stop);
     }
   }
   /* examin exterior loop of bp(ij);   (.......)
@@ -688,7 +675,7 @@ static void fnb(baum *rli) {
     x=rlj->nummer-rli->nummer;
     if (x<0) x=-x;
     /* j-position of base pair shifts to position k */
-    if ((x >= MYTURN) && (ptype[rli->nummer][rlj->nummer])) {
+    if ((x >= MYTURN) && (sim->ptype[rli->nummer][rlj->nummer])) {
       if (rli->nummer<rlj->nummer) {
 	help_rli=rli;
 	help_rlj=rlj;
@@ -698,26 +685,22 @@ static void fnb(baum *rli) {
 	help_rlj=rli;
       }
       /* open original basepair */
-      open_bp(rli);
+      open_bp(sim, rli);
       /* close shifted version of original basepair */
-      close_bp(help_rli,help_rlj);
-      /* evaluate energy of the structure */
-#if HAVE_LIBRNA_API3
-      EoT = vrna_eval_structure_pt(GAV.vc, pairList);
-#else
-      EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
-#endif
-      /* put the move and the enegy of the structure into the neighbour list */
-      update_nbList(1 + rli->nummer, -(1 + rlj->nummer), EoT);
+      close_bp(sim, help_rli,help_rlj);
+      /* evaluate energy change of the structure */
+      dE = loop_E(sim, help_rli) + loop_E(sim, up) - E_old;
+      /* put the move and the enegy change into the neighbour list */
+      update_nbList(sim, 1 + rli->nummer, -(1 + rlj->nummer), dE);
       /* open shifted base pair */
-      open_bp(help_rli);
+      open_bp(sim, help_rli);
       /* restore original basepair */
-      close_bp(rli,stop);
+      close_bp(sim, rli,stop);
     }
     x = rlj->nummer-stop->nummer;
     if (x < 0) x = -x;
     /* i-position of base pair shifts to position k */
-    if ((x >= MYTURN) && (ptype[stop->nummer][rlj->nummer])) {
+    if ((x >= MYTURN) && (sim->ptype[stop->nummer][rlj->nummer])) {
       if (stop->nummer < rlj->nummer) {
 	help_rli = stop;
 	help_rlj = rlj;
@@ -727,73 +710,187 @@ static void fnb(baum *rli) {
 	help_rlj = stop;
       }
       /* open original basepair */
-      open_bp(rli);
+      open_bp(sim, rli);
        /* close shifted version of original basepair */
-      close_bp(help_rli, help_rlj);
-      /* evaluate energy of the structure */
-#if HAVE_LIBRNA_API3
-      EoT = vrna_eval_structure_pt(GAV.vc, pairList);
-#else
-      EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
-#endif
-      /* put the move and the enegy of the structure into the neighbour list */
-      update_nbList(-(1 + rlj->nummer), 1 + stop->nummer, EoT);
+      close_bp(sim, help_rli, help_rlj);
+      /* evaluate energy change of the structure */
+      dE = loop_E(sim, help_rli) + loop_E(sim, up) - E_old;
+      /* put the move and the enegy change into the neighbour list */
+      update_nbList(sim, -(1 + rlj->nummer), 1 + stop->nummer, dE);
       /* open shifted basepair */
-      open_bp(help_rli);
+      open_bp(sim, help_rli);
       /* restore original basepair */
-      close_bp(rli,stop);
+      close_bp(sim, rli,stop);
     }
   }
 }
 
 /* for a given tree (structure),
    generate all neighbours according to moveset */
-void move_it (void) {
-  int i;
-  
+void move_it (SimState *sim) {
+  int k, g;
+  baum *r;
+
+  /* the intermolecular initiation term is not part of any loop energy,
+     so for co-folding the energy of the current structure is recomputed */
+  if (cut_point > 0) {
 #if HAVE_LIBRNA_API3
-  GSV.currE = (float)vrna_eval_structure_pt(GAV.vc, pairList)/100.;
+    sim->currE = (float)vrna_eval_structure_pt(sim->vc, sim->pairList)/100.;
 #else
-  GSV.currE =
-    energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0)/100.;
+    sim->currE =
+      energy_of_struct_pt_par(sim->farbe, sim->pairList, sim->typeList, sim->aliasList, GAV.params, 0)/100.;
 #endif
-  
-  if ( GTV.noLP ) { /* canonical neighbours only */
-    inb_nolp(wurzl);
-    for (i = 0; i < GSV.len; i++) {
-      
-      if (pairList[i+1]>i+1) {
-	inb_nolp(rl+i);      /* insert pair neighbours */
-	dnb_nolp(rl+i);  /* delete pair neighbour */
-      }
-    }
   }
-  else { /* all neighbours */
-    inb(wurzl);
-    for (i = 0; i < GSV.len; i++) {
-      
-      if (pairList[i+1]>i+1) {
-	inb(rl+i); 	 /* insert pair neighbours */
-	dnb(rl+i);  /* delete pair neighbour */
-	if ( GTV.noShift == 0 ) fnb(rl+i);
+
+  update_loop_energies(sim);
+
+  /* only the moves that depend on a changed loop are generated anew */
+  for (k = 0; k < sim->num_dirty; k++) {
+    g = sim->dirty_list[k];
+    sim->dirty[g] = 0;
+    reset_group(sim, g);
+    r = (g == 0) ? sim->wurzl : &sim->rl[g-1];
+    if (r != sim->wurzl && r->typ != 'p') continue;
+
+    if ( GTV.noLP ) { /* canonical neighbours only */
+      inb_nolp(sim, r);      /* insert pair neighbours */
+      if (r != sim->wurzl)
+	dnb_nolp(sim, r);    /* delete pair neighbour */
+    }
+    else { /* all neighbours */
+      inb(sim, r);           /* insert pair neighbours */
+      if (r != sim->wurzl) {
+	dnb(sim, r);         /* delete pair neighbour */
+	if ( GTV.noShift == 0 ) fnb(sim, r);
       }
     }
   }
+  sim->num_dirty = 0;
+}
+
+/* energy of the loop closed by base pair r (or the exterior loop) */
+static int loop_E(SimState *sim, baum *r) {
+#if HAVE_LIBRNA_API3
+  return vrna_eval_loop_pt(sim->vc, r->nummer+1, sim->pairList);
+#else
+  return loop_energy(sim->pairList, sim->typeList, sim->aliasList, r->nummer+1);
+#endif
+}
+
+/* base pair (or virtualroot) that closes the loop r belongs to */
+static baum *enclosing(baum *r) {
+  for (r=r->next; r->up==NULL; r=r->next);
+  return r->up;
+}
+
+/* the moves of group g have to be generated anew */
+static void dirty_group(SimState *sim, int g) {
+  if (sim->dirty[g]) return;
+  sim->dirty[g] = 1;
+  sim->dirty_list[sim->num_dirty++] = g;
+}
+
+/*
+  the loop closed by base pair r has changed: the moves of r, and
+  the delete and shift moves of the base pairs inside this loop depend
+  on it. Without isolated base pairs, the moves of the base pair
+  around r and of the base pairs two levels down depend on it as well.
+*/
+static void dirty_loop(SimState *sim, baum *r) {
+  baum *c, *cc;
+
+  dirty_group(sim, GROUP(sim, r));
+  if (GTV.noLP && r != sim->wurzl) dirty_group(sim, GROUP(sim, enclosing(r)));
+  for (c = r->down->next; c != r->down; c = c->next) {
+    if (c->typ != 'p') continue;
+    dirty_group(sim, GROUP(sim, c));
+    if (GTV.noLP)
+      for (cc = c->down->next; cc != c->down; cc = cc->next)
+	if (cc->typ == 'p') dirty_group(sim, GROUP(sim, cc));
+  }
+}
+
+/*
+  the energy of the loop closed by base pair r (or of the exterior loop)
+  has changed; it is evaluated by move_it() or taken from the cache
+  together with the moves
+*/
+static void stale_loop(SimState *sim, baum *r) {
+  int g;
+
+  g = GROUP(sim, r);
+  if (sim->stale[g]) return;
+  sim->stale[g] = 1;
+  sim->stale_list[sim->num_stale++] = g;
+}
+
+/* evaluate the energies of all changed loops */
+static void update_loop_energies(SimState *sim) {
+  int k, g;
+  baum *r;
+
+  for (k = 0; k < sim->num_stale; k++) {
+    g = sim->stale_list[k];
+    sim->stale[g] = 0;
+    r = (g == 0) ? sim->wurzl : &sim->rl[g-1];
+    /* the base pair may have been opened again */
+    r->loop_energy = (r == sim->wurzl || r->typ == 'p') ? loop_E(sim, r) : 0;
+  }
+  sim->num_stale = 0;
+}
+
+/* energies of all loops by group, 0 for unpaired bases */
+void get_loop_energies(SimState *sim, int *E) {
+  int i;
+
+  E[0] = sim->wurzl->loop_energy;
+  for (i = 0; i < sim->len; i++)
+    E[i+1] = (sim->rl[i].typ == 'p') ? sim->rl[i].loop_energy : 0;
+  for (i = sim->len+1; i < sim->groups; i++) E[i] = 0;
+}
+
+/* take the energies of all changed loops from E */
+void set_loop_energies(SimState *sim, const int *E) {
+  int k, g;
+  baum *r;
+
+  for (k = 0; k < sim->num_stale; k++) {
+    g = sim->stale_list[k];
+    sim->stale[g] = 0;
+    r = (g == 0) ? sim->wurzl : &sim->rl[g-1];
+    r->loop_energy = E[g];
+  }
+  sim->num_stale = 0;
+}
+
+/* start with an empty neighbour list, all moves have to be generated */
+static void ini_groups(SimState *sim) {
+  int i;
+
+  for (i = 0; i < sim->num_dirty; i++) sim->dirty[sim->dirty_list[i]] = 0;
+  sim->num_dirty = 0;
+  for (i = 0; i < sim->num_stale; i++) sim->stale[sim->stale_list[i]] = 0;
+  sim->num_stale = 0;
+  clear_nbList(sim);
+  dirty_group(sim, 0);
+  for (i = 0; i < sim->len; i++)
+    if (sim->rl[i].typ == 'p') dirty_group(sim, i+1);
 }
 
 
 /**/
-void clean_up_rl(void) {
+void clean_up_rl(SimState *sim) {
   int i;
-  free(pairList); pairList=NULL;
-  free(typeList); typeList = NULL;
-  free(aliasList); aliasList = NULL;
-  free(rl); rl=NULL;
-  free(wurzl);  wurzl=NULL;
-  for (i=0; i<=GSV.len; i++)
-    free(ptype[i]);
-  free(ptype);
-  ptype=NULL;
+  if (sim->ptype == NULL) return;
+  free(sim->pairList); sim->pairList=NULL;
+  free(sim->typeList); sim->typeList = NULL;
+  free(sim->aliasList); sim->aliasList = NULL;
+  free(sim->rl); sim->rl=NULL;
+  free(sim->wurzl);  sim->wurzl=NULL;
+  for (i=0; i<=sim->len; i++)
+    free(sim->ptype[i]);
+  free(sim->ptype);
+  sim->ptype=NULL;
 }
 
 /**/
@@ -806,27 +903,27 @@ static int comp_struc(const void *A, const void *B) {
 
 #if 0
 /**/
-static void rl_status(void) {
+static void rl_status(SimState *sim) {
 
   int i;
 
-  printf("\n%s\n%s\n", GAV.farbe, GAV.currform);
-  for (i=0; i <= GSV.len; i++) {
+  printf("\n%s\n%s\n", sim->farbe, sim->currform);
+  for (i=0; i <= sim->len; i++) {
     printf("%2d %c %c %2d %2d %2d %2d\n",
-	   rl[i].nummer,
-	   i == GSV.len ? 'X': GAV.farbe[i],
-	   rl[i].typ,
-	   rl[i].up==NULL?0:(rl[i].up)->nummer,
-	   rl[i].down==NULL?0:(rl[i].down)->nummer,
-	   (rl[i].prev)->nummer,
-	   (rl[i].next)->nummer);
+	   sim->rl[i].nummer,
+	   i == sim->len ? 'X': sim->farbe[i],
+	   sim->rl[i].typ,
+	   sim->rl[i].up==NULL?0:(sim->rl[i].up)->nummer,
+	   sim->rl[i].down==NULL?0:(sim->rl[i].down)->nummer,
+	   (sim->rl[i].prev)->nummer,
+	   (sim->rl[i].next)->nummer);
   }
   printf("---\n");
 }
 #endif
 
 #define TURN 3
-static void make_ptypes(const short *S) {
+static void make_ptypes(SimState *sim, const short *S) {
   int n,i,j,k,l;
   n=S[0];
   for (k=1; k<n; k++)
@@ -840,7 +937,7 @@ static void make_ptypes(const short *S) {
 	if ((i>1)&&(j<n)) ntype = pair[S[i-1]][S[j+1]];
 	if (noLonelyPairs && (!otype) && (!ntype))
 	  type = 0; /* i.j can only form isolated pairs */
-	ptype[i-1][j-1] = ptype[j-1][i-1] = (char) type;
+	sim->ptype[i-1][j-1] = sim->ptype[j-1][i-1] = (char) type;
 	otype =  type;
 	type  = ntype;
 	i--; j++;
@@ -848,35 +945,30 @@ static void make_ptypes(const short *S) {
     }
 }
 
-static void close_bp_en (baum *i, baum *j) {
+static void close_bp_en (SimState *sim, baum *i, baum *j) {
   /* close bp and update energy */
   baum *r;
-  close_bp(i,j);
-
-#if HAVE_LIBRNA_API3
-  i->loop_energy = vrna_eval_loop_pt(GAV.vc, i->nummer+1, pairList);
-#else
-  i->loop_energy = loop_energy(pairList,typeList,aliasList,i->nummer+1);
-#endif
+  close_bp(sim, i,j);
 
-  for (r=i->next; r->up==NULL; r=r->next);
+  r = enclosing(i);
+  stale_loop(sim, i);
+  stale_loop(sim, r);
 
-#if HAVE_LIBRNA_API3
-  r->up->loop_energy = vrna_eval_loop_pt(GAV.vc, r->up->nummer+1, pairList);
-#else
-  r->up->loop_energy = loop_energy(pairList,typeList,aliasList,r->up->nummer+1);
-#endif
+  /* moves depending on the two loops have changed */
+  dirty_loop(sim, i);
+  dirty_loop(sim, r);
 };
 
-static void open_bp_en (baum *i) {
+static void open_bp_en (SimState *sim, baum *i) {
   /* open bp and update energy */
   baum *r;
   i->loop_energy=0;
-  open_bp(i);
-  for (r=i->next; r->up==NULL; r=r->next);
-#if HAVE_LIBRNA_API3
-  r->up->loop_energy = vrna_eval_loop_pt(GAV.vc, r->up->nummer+1, pairList);
-#else
-  r->up->loop_energy = loop_energy(pairList,typeList,aliasList,r->up->nummer+1);
-#endif
+  /* the moves of bp i are gone */
+  dirty_group(sim, GROUP(sim, i));
+  open_bp(sim, i);
+  r = enclosing(i);
+  stale_loop(sim, r);
+
+  /* moves depending on the merged loop have changed */
+  dirty_loop(sim, r);
 };
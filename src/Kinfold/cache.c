@@ -32,107 +32,215 @@
 */
 
 /* PUBLIC FUNCTIONES */
-cache_entry *lookup_cache (char *x);
-int write_cache (cache_entry *x);
+cache_entry *lookup_cache (cache_tab *t, char *x);
+cache_entry *new_cache_entry (char *x, int top, int groups);
+int write_cache (cache_tab *t, cache_entry *x);
 /*  void delete_cache (cache_entry *x); */
-void kill_cache();
-void initialize_cache();
+void kill_cache(cache_tab *t);
+cache_tab *initialize_cache(int size);
 
 /* PRIVATE FUNCTIONES */
 /*  static int cache_comp(cache_entry *x, cache_entry *y); */
-INLINE static unsigned cache_f (char *x);
-
-/* #define CACHESIZE 67108864 -1 */ /* 2^26 -1   must be power of 2 -1 */
-/* #define CACHESIZE 33554432 -1 */ /* 2^25 -1   must be power of 2 -1 */
-/* #define CACHESIZE 16777216 -1 */ /* 2^24 -1   must be power of 2 -1 */ 
-/* #define CACHESIZE  4194304 -1 */ /* 2^22 -1   must be power of 2 -1 */
-#define CACHESIZE  1048576 -1  /* 2^20 -1   must be power of 2 -1 */
-/* #define CACHESIZE   262144 -1 */ /* 2^18 -1   must be power of 2 -1 */
-/* next is default */
-/* #define CACHESIZE    65536 -1 */ /* 2^16 -1   must be power of 2 -1 */
-/* #define CACHESIZE    16384 -1 */ /* 2^14 -1   must be power of 2 -1 */
-/* #define CACHESIZE     4096 -1 */ /* 2^12 -1   must be power of 2 -1 */
-
-static cache_entry *cachetab[CACHESIZE+1];
+INLINE static unsigned long cache_f (cache_tab *t, unsigned long *key, int words);
+INLINE static void pack_key (char *x, int len, unsigned long *key);
+INLINE static int key_words (int len);
+
+/*
+  the cache is an open addressing table of cache_entry pointers;
+  an entry is searched for in at most CACHEPROBE consecutive slots
+  behind its hash value, if they are all taken the entry in the first
+  slot is thrown out. The number of slots is set by the --cache option
+  and rounded up to a power of 2. Each simulation (thread) has a cache
+  of its own.
+*/
+#define CACHEPROBE    8
+#define CACHEDEFAULT  1048576  /* 2^20 */
+
+#define BITS_PER_WORD (8*sizeof(unsigned long))
+#define ALIGN_SIZE(x) (((x) + sizeof(double) - 1) & ~(sizeof(double) - 1))
+
+struct _cache_tab {
+  cache_entry **cachetab;
+  unsigned long cachemask;
+  unsigned long *keybuf;   /* packed key of last lookup */
+  int keylen;
+  unsigned long collisions;
+};
+
 static char UNUSED rcsid[] ="$Id: cache.c,v 1.3 2006/10/04 12:45:12 xtof Exp $";
-unsigned long collisions=0;
-
-/* stolen from perl source */
-char coeff[] = {
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1};
-
-/* key must not be longer than 128 */
-INLINE static unsigned cache_f(char *x) { 
-  register char *s;
-  register int i;
-  register unsigned cache;
-
-  s = x;
-
-  for (i=0,    cache = 0;
-       /* while */ *s;
-       s++,           i++ , cache *= 5 ) {
-    cache += *s * coeff[i];
+
+INLINE static int key_words(int len) {
+  return (2*len + BITS_PER_WORD - 1) / BITS_PER_WORD;
+}
+
+/* '.' -> 0, '(' -> 1, ')' -> 2 */
+INLINE static void pack_key(char *x, int len, unsigned long *key) {
+  int i, b;
+  unsigned long c, w;
+
+  /* fill one word at a time */
+  for (i=0; i<len; key++) {
+    for (w=0, b=0; b<(int)BITS_PER_WORD && i<len; b+=2, i++) {
+      switch (x[i]) {
+      case '.': c = 0; break;
+      case '(': c = 1; break;
+      case ')': c = 2; break;
+      default:  c = 3; break;
+      }
+      w |= c << b;
+    }
+    *key = w;
   }
+}
 
-   /* divide through CACHESIZE for normalization */
-  return ((cache) & (CACHESIZE));
+INLINE static unsigned long cache_f(cache_tab *t, unsigned long *key, int words) {
+  int i;
+  unsigned long long cache = 0x9e3779b97f4a7c15ULL;
+
+  for (i=0; i<words; i++) {
+    cache ^= key[i];
+    cache *= 0xff51afd7ed558ccdULL;
+    cache ^= cache >> 33;
+  }
+
+  return ((unsigned long)cache) & t->cachemask;
 }
 
+/* packs x into the key buffer and returns its number of words */
+static int cache_key(cache_tab *t, char *x, int len) {
+  if (len > t->keylen) {
+    free(t->keybuf);
+    t->keybuf = (unsigned long *) malloc(key_words(len)*sizeof(unsigned long));
+    if (t->keybuf == NULL) {
+      fprintf(stderr, "out of memory\n"); exit(255);
+    }
+    t->keylen = len;
+  }
+  pack_key(x, len, t->keybuf);
+  return key_words(len);
+}
 
 /* returns NULL unless x is in the cache */
-cache_entry *lookup_cache (char *x) {
-  int cacheval;
+cache_entry *lookup_cache (cache_tab *t, char *x) {
+  int i, len, words;
+  unsigned long cacheval;
   cache_entry *c;
 
-  cacheval=cache_f(x);
-  if ((c=cachetab[cacheval]))
-    if (strcmp(c->structure,x)==0) return c;
-  
+  len = strlen(x);
+  words = cache_key(t, x, len);
+  cacheval = cache_f(t, t->keybuf, words);
+  for (i=0; i<CACHEPROBE; i++) {
+    if ((c=t->cachetab[(cacheval+i) & t->cachemask]) == NULL) break;
+    if (c->len == len && memcmp(c->key, t->keybuf, words*sizeof(unsigned long))==0)
+      return c;
+  }
+
   return NULL;
 }
 
+/*
+  allocates an entry for structure x with top neighbors in groups groups
+  in a single block, the caller fills in neighbors, rates, energy changes
+  and loop energies
+*/
+cache_entry *new_cache_entry (char *x, int top, int groups) {
+  int len, words;
+  size_t size;
+  char *block;
+  cache_entry *c;
+
+  len = strlen(x);
+  words = key_words(len);
+  size = ALIGN_SIZE(sizeof(cache_entry))
+    + top*sizeof(double)
+    + words*sizeof(unsigned long)
+    + top*sizeof(int)
+    + (groups+1)*sizeof(int)
+    + groups*sizeof(int)
+    + 2*top*sizeof(short);
+
+  if ((block = (char *) malloc(size))==NULL) {
+    fprintf(stderr, "out of memory\n"); exit(255);
+  }
+  c = (cache_entry *) block;
+  block += ALIGN_SIZE(sizeof(cache_entry));
+  c->rates = (double *) block;
+  block += top*sizeof(double);
+  c->key = (unsigned long *) block;
+  block += words*sizeof(unsigned long);
+  c->dE = (int *) block;
+  block += top*sizeof(int);
+  c->first = (int *) block;
+  block += (groups+1)*sizeof(int);
+  c->loop_energy = (int *) block;
+  block += groups*sizeof(int);
+  c->neighbors = (short *) block;
+
+  c->len = len;
+  c->top = top;
+  c->groups = groups;
+  pack_key(x, len, c->key);
+
+  return c;
+}
+
 /* returns 1 if x already was in the cache */
-int write_cache (cache_entry *x) {
-  int cacheval;
+int write_cache (cache_tab *t, cache_entry *x) {
+  int i, words;
+  unsigned long cacheval, slot;
   cache_entry *c;
-  
-  cacheval=cache_f(x->structure);
-  if ((c=cachetab[cacheval])) {
-    free(c->structure);
-    free(c->neighbors);
-    free(c->rates);
-    free(c->energies);
-    free(c);
+
+  words = key_words(x->len);
+  cacheval = cache_f(t, x->key, words);
+  for (i=0; i<CACHEPROBE; i++) {
+    slot = (cacheval+i) & t->cachemask;
+    if ((c=t->cachetab[slot]) == NULL) {
+      t->cachetab[slot]=x;
+      return 0;
+    }
+    if (c->len == x->len && memcmp(c->key, x->key, words*sizeof(unsigned long))==0) {
+      free(c);
+      t->cachetab[slot]=x;
+      return 1;
+    }
   }
-  cachetab[cacheval]=x;
+
+  /* all slots are taken, replace the first one */
+  t->collisions++;
+  free(t->cachetab[cacheval]);
+  t->cachetab[cacheval]=x;
   return 0;
 }
 
-/**/
-void initialize_cache () { }
+/* size <= 0 selects the default number of slots */
+cache_tab *initialize_cache (int size) {
+  unsigned long n;
+  cache_tab *t;
 
-/**/
-void kill_cache () {
-  int i;
-  
-  for (i=0;i<CACHESIZE+1;i++) {
-    if ( cachetab[i] ) {
-      free (cachetab[i]->structure);
-      free (cachetab[i]->neighbors);
-      free (cachetab[i]->rates);
-      free (cachetab[i]->energies);
-      free (cachetab[i]);
-    }
-    cachetab[i]=NULL;
+  if (size <= 0) size = CACHEDEFAULT;
+  for (n=1; n<(unsigned long)size; n<<=1);
+
+  t = (cache_tab *) calloc(1, sizeof(cache_tab));
+  if (t != NULL)
+    t->cachetab = (cache_entry **) calloc(n, sizeof(cache_entry *));
+  if (t == NULL || t->cachetab == NULL) {
+    fprintf(stderr, "out of memory\n"); exit(255);
   }
+  t->cachemask = n-1;
+  return t;
+}
+
+/**/
+void kill_cache (cache_tab *t) {
+  unsigned long i;
+
+  if (t == NULL) return;
+
+  for (i=0;i<=t->cachemask;i++)
+    free(t->cachetab[i]);
+  free(t->cachetab);
+  free(t->keybuf);
+  free(t);
 }
 
 #if 0
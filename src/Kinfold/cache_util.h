@@ -16,18 +16,24 @@
 #endif
 
 typedef struct {
-  char *structure;
+  unsigned long *key; /* structure packed into 2 bits per position */
+  int len;           /* length of the structure */
   int top;           /* number of neighbors */
-  int lmin;          /* is a local minimum ? */
-  double flux;       /* sum of rates */
+  int groups;        /* number of groups of neighbors */
   double energy;     /* energy of this structure */
-  short *neighbors;  
-  float *rates;
-  double *energies;
+  int *first;        /* neighbors of group g are first[g] .. first[g+1]-1 */
+  int *loop_energy;  /* energy of the loop closed by the base pair of group g */
+  short *neighbors;
+  int *dE;           /* energy changes in dcal/mol */
+  double *rates;
 } cache_entry;
 
-extern cache_entry *lookup_cache (char *x);
-extern int write_cache (cache_entry *x);
-void kill_cache(void);
+typedef struct _cache_tab cache_tab;
+
+extern cache_entry *lookup_cache (cache_tab *t, char *x);
+extern cache_entry *new_cache_entry (char *x, int top, int groups);
+extern int write_cache (cache_tab *t, cache_entry *x);
+cache_tab *initialize_cache(int size);
+void kill_cache(cache_tab *t);
 
 #endif
@@ -94,8 +94,6 @@ void clean_up_globals(void) {
   free(GAV.farbe);
   free(GAV.farbe_full);
   free(GAV.startform);
-  free(GAV.currform);
-  free(GAV.prevform);
   for (i = 0; i < GSV.maxS; i++) free(GAV.stopform[i]);
   free(GAV.stopform);
   free(GAV.sE);
@@ -368,6 +366,17 @@ static void process_options_gg (int argc, char *argv[]) {
   GSV.cut = args_info.cut_arg;
   GSV.grow = args_info.grow_arg;
   GSV.glen = args_info.glen_arg;
+  GSV.cache = args_info.cache_arg;
+  GSV.jobs = (args_info.jobs_given) ? args_info.jobs_arg : 1;
+  if (GSV.jobs < 0) {
+    fprintf(stderr, "Value of --jobs must be >= 0 >%d<\n", GSV.jobs);
+    exit(1);
+  }
+  GSV.hist = (args_info.hist_given) ? args_info.hist_arg : 0;
+  if (args_info.hist_given && GSV.hist <= 0) {
+    fprintf(stderr, "Value of --hist must be > 0 >%d<\n", GSV.hist);
+    exit(1);
+  }
   GTV.lmin = args_info.lmin_flag;
   GTV.fpt  = args_info.fpt_flag;
   cmdline_parser_free(&args_info);
@@ -550,6 +559,9 @@ static void ini_gvars(void) {
   GSV.phi = 1.0;
   GSV.simTime = 0.0;
   GSV.glen = 15;
+  GSV.cache = 1048576;
+  GSV.jobs = 1;
+  GSV.hist = 0;
 }
 
 /**/
@@ -566,8 +578,6 @@ static void ini_garrays(void) {
   assert(GAV.stopform != NULL);
   GAV.farbe = NULL;
   GAV.startform = NULL;
-  GAV.currform = NULL;
-  GAV.prevform = NULL;
   GAV.phi_bounds[0] = 0.1;
   GAV.phi_bounds[1] = 0.1;
   GAV.phi_bounds[2] = 2.0;
@@ -16,6 +16,7 @@
 #endif
 
 #include "config.h"
+#include <stdio.h>
 
 #if HAVE_LIBRNA_API3
 #include <ViennaRNA/model.h>
@@ -40,6 +41,9 @@ typedef struct _GlobVars {
   double time;
   double phi;
   double simTime;
+  int    cache;
+  int    jobs;
+  int    hist;
 } GlobVars;
 
 typedef struct _GlobArrays {
@@ -50,8 +54,6 @@ typedef struct _GlobArrays {
   char *farbe_full;    /* full sequence (for chain growth simulation) */
   char *startform;     /* start structure */
   char **stopform;     /* stop structure(s) */
-  char *currform;      /* current structure */
-  char *prevform;      /* current structure of previous time step */
   float *sE;           /* energy(s) of stop structure(s) */
   double phi_bounds[3];   /* phi_min, phi_inc, phi_max */
   unsigned short subi[3]; /* seeds for random-number-generator */
@@ -83,6 +85,76 @@ typedef struct _GlobToogles {
   int verbose;
 } GlobToggles;
 
+/*
+  state of a single simulation; the trajectories are computed one
+  after another in a SimState, several SimStates may run in parallel
+*/
+typedef struct _SimState {
+  int len;             /* current length of the (growing) chain */
+  int steps;
+  float startE;
+  float currE;
+  char *farbe;         /* current sequence */
+  char *startform;     /* start structure of current chain */
+  char *currform;      /* current structure */
+  char *prevform;      /* current structure of previous time step */
+  unsigned short subi[3]; /* state of the random-number-generator */
+  FILE *out;           /* trajectory output */
+  FILE *log;           /* log-file output */
+#if HAVE_LIBRNA_API3
+  vrna_fold_compound_t *vc;
+#endif
+
+  /* ringlist-tree, see baum.c */
+  struct _baum *rl;
+  struct _baum *wurzl;
+  short *pairList;
+  short *typeList;
+  short *aliasList;
+  char **ptype;
+
+  /* neighbor list, see nachbar.c */
+  short *neighbor_list; /* move of each slot */
+  int *dE;             /* energy change of each move in dcal/mol */
+  int *slot_next;      /* next slot of the same group or free slot */
+  double *rate_tree;   /* rates of the slots and their partial sums */
+  char *used;          /* slot holds a move */
+  int *released;       /* slots freed since the last move was selected */
+  int num_released;
+  int slots;
+  int free_slot;
+  int *group_first;    /* first slot of each group of moves */
+  int groups;
+  int group;           /* group new moves are added to */
+  char *dirty;         /* groups that have to be generated anew */
+  int *dirty_list;
+  int num_dirty;
+  char *stale;         /* loops whose energy has to be evaluated anew */
+  int *stale_list;
+  int num_stale;
+  int top;             /* number of moves */
+  int num_down;        /* number of moves with dE < 0 */
+  int num_flat;        /* number of moves with dE == 0 */
+  long sum_dE;
+  int lmin;
+  int is_from_cache;
+  double totalflux;
+  double Zeit;
+  double zeitInc;
+  double RT;
+  double L, D;         /* laplace stuff */
+  double sumT, sumK, sumKK, sumD;
+  char *costring;
+  int costring_size;
+
+  /* neighborhood cache, see cache.c */
+  struct _cache_tab *cache;
+
+  /* result of the last trajectory */
+  int found_stop;      /* number of stop structure reached (0 for none) */
+  double fpt;          /* first passage (or simulation) time */
+} SimState;
+
 void decode_switches(int argc, char *argv[]);
 void clean_up_globals(void);
 void log_prog_params(FILE *FP);
@@ -12,7 +12,11 @@
 #include <string.h>
 #include <assert.h>
 #include <ctype.h>
+#include <math.h>
 #include <unistd.h>
+#if HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 #if HAVE_LIBRNA_API3
 #include <ViennaRNA/data_structures.h>
@@ -32,17 +36,54 @@
 
 static char UNUSED rcsid[] ="$Id: main.c,v 1.5 2008/08/28 09:40:55 ivo Exp $";
 extern void  read_parameter_file(const char fname[]);
-extern void get_from_cache(cache_entry *c);
+
+/* result of a single trajectory, written in order of the trajectories */
+typedef struct _TrajOut {
+  int done;
+  int found_stop;
+  double fpt;
+  char *out;           /* stdout text */
+  size_t out_size;
+  char *log;           /* log-file text */
+  size_t log_size;
+} TrajOut;
+
+static FILE *logFP = NULL;
+static unsigned short (*seeds)[3] = NULL; /* start seed of each trajectory */
+static TrajOut *results = NULL;
+static int num_written = 0;
+static int num_jobs = 1;
+static int *hist = NULL;       /* (GSV.maxS+1) x hist_bins counts */
+static int hist_bins = 0;
+static int hist_min = 0;       /* bins of smallest and largest time */
+static int hist_max = 0;
+
+#if HAVE_PTHREAD_H && HAVE_OPEN_MEMSTREAM
+static int num_started = 0;
+static pthread_mutex_t traj_mtx = PTHREAD_MUTEX_INITIALIZER;
+#endif
 
 /* PRIVAT FUNCTIONS */
 static void ini_energy_model(void);
 static void read_data(void);
 static void clean_up(void);
+static void ini_seeds(void);
+static void ini_sim(SimState *sim);
+static void clean_up_sim(SimState *sim);
+static void simulate(SimState *sim, int n);
+static void write_results(void);
+static void ini_hist(void);
+static void add_to_hist(int found_stop, double fpt);
+static void write_hist(void);
+#if HAVE_PTHREAD_H && HAVE_OPEN_MEMSTREAM
+static void *worker(void *arg);
+#endif
 
 /**/
 int main(int argc, char *argv[]) {
   int i;
-  char * start, *tmp;
+  char logFN[256], *tmp;
+  SimState sim;
   
   /*
     process command-line optiones
@@ -71,64 +112,335 @@ int main(int argc, char *argv[]) {
 #endif
 
   /*
-    perform GSV.num simulations
+    energies of start and stop structure(s)
   */
-    
-  start = strdup(GAV.startform); /* remember startform for next run */
-  for (i = 0; i < GSV.num; i++) {
+  ini_start_stop();
 
-    /*
-      initialize or reset ringlist to start conditions
-    */
-    ini_or_reset_rl();
-    if (GSV.grow>0) {
-      if (strlen(GAV.farbe)>GSV.glen) {
-	start[GSV.glen] = '\0';
-	GAV.farbe[GSV.glen] = '\0';
-	strcpy(GAV.startform,start);
-	strcpy(GAV.currform,start);
-	GSV.len=GSV.glen;
+  /* open log-file and log initial condition */
+  logFP = fopen(strcat(strcpy(logFN, GAV.BaseName), ".log"), "a+");
+  assert(logFP != NULL);
+  log_prog_params(logFP);
+  log_start_stop(logFP);
 
-#if HAVE_LIBRNA_API3
-        GAV.vc->length = GSV.len;
+  ini_seeds();
+  ini_hist();
+
+  /*
+    perform GSV.num simulations, each trajectory uses its own
+    random-number stream so the results do not depend on the
+    number of parallel threads
+  */
+  results = (TrajOut *)calloc(GSV.num, sizeof(TrajOut));
+  assert(results != NULL);
+
+  num_jobs = GSV.jobs;
+#if HAVE_PTHREAD_H && HAVE_OPEN_MEMSTREAM && HAVE_LIBRNA_API3
+  if (num_jobs == 0)
+    num_jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (num_jobs > GSV.num)
+    num_jobs = GSV.num;
+#else
+  /* no thread support or energy evaluation is not thread-safe */
+  num_jobs = 1;
 #endif
-      }
-      clean_up_rl();
-      ini_or_reset_rl();
-    }
+  if (num_jobs < 1)
+    num_jobs = 1;
 
-    /*
-      perform simulation
-    */
-    for (GSV.steps = 1;; GSV.steps++) {
-      cache_entry *c;
-
-      /*
-	take neighbourhood of current structure from cache if there
-	else generate it from scratch
-      */
-      if ( (c = lookup_cache(GAV.currform)) ) get_from_cache(c);
-      else move_it();
-	
-      /*
-	select a structure from neighbourhood of current structure
-	and make it to the new current structure.
-	stop simulation if stop condition is met.
-      */
-      if ( sel_nb() > 0 ) break;
-
-      /* if (GSV.grow>0) grow_chain(); */
+  if (num_jobs == 1) {
+    ini_sim(&sim);
+    sim.out = stdout;
+    sim.log = logFP;
+    for (i = 0; i < GSV.num; i++) {
+      simulate(&sim, i);
+      results[i].found_stop = sim.found_stop;
+      results[i].fpt = sim.fpt;
+      results[i].done = 1;
+      write_results();
     }
+    clean_up_sim(&sim);
   }
+#if HAVE_PTHREAD_H && HAVE_OPEN_MEMSTREAM
+  else {
+    pthread_t *threads;
+    int started = 0;
+
+    threads = (pthread_t *)calloc(num_jobs, sizeof(pthread_t));
+    assert(threads != NULL);
+    for (i = 1; i < num_jobs; i++)
+      if (pthread_create(&threads[started], NULL, worker, NULL) == 0)
+	started++;
+
+    /* the main thread takes part in the simulations as well */
+    worker(NULL);
+
+    for (i = 0; i < started; i++)
+      pthread_join(threads[i], NULL);
+    free(threads);
+  }
+#endif
+
+  write_hist();
   
   /*
     clean up memory
   */
-  free(start);
   clean_up();
   return(0);
 }
 
+#if HAVE_PTHREAD_H && HAVE_OPEN_MEMSTREAM
+/*
+  run trajectories until all are started; the output of each trajectory
+  is collected in memory and written in order of the trajectories
+*/
+static void *worker(void *arg) {
+  int n;
+  SimState sim;
+  TrajOut r;
+
+  ini_sim(&sim);
+  for (;;) {
+    pthread_mutex_lock(&traj_mtx);
+    n = num_started++;
+    pthread_mutex_unlock(&traj_mtx);
+    if (n >= GSV.num) break;
+
+    memset(&r, 0, sizeof(TrajOut));
+    sim.out = open_memstream(&r.out, &r.out_size);
+    sim.log = open_memstream(&r.log, &r.log_size);
+    assert(sim.out != NULL && sim.log != NULL);
+
+    simulate(&sim, n);
+
+    fclose(sim.out);
+    fclose(sim.log);
+    r.found_stop = sim.found_stop;
+    r.fpt = sim.fpt;
+    r.done = 1;
+
+    pthread_mutex_lock(&traj_mtx);
+    results[n] = r;
+    write_results();
+    pthread_mutex_unlock(&traj_mtx);
+  }
+  clean_up_sim(&sim);
+
+  return NULL;
+}
+#endif
+
+/* run trajectory n */
+static void simulate(SimState *sim, int n) {
+  cache_entry *c;
+
+  sim->subi[0] = seeds[n][0];
+  sim->subi[1] = seeds[n][1];
+  sim->subi[2] = seeds[n][2];
+
+  /* no local minimum printed so far */
+  sim->prevform[0] = '\0';
+  sim->lmin = 1;
+
+  /*
+    initialize or reset ringlist to start conditions
+  */
+  if (GSV.grow>0) {
+    /* chain growth starts over with the initial chain */
+    clean_up_rl(sim);
+    strcpy(sim->farbe, GAV.farbe);
+    strcpy(sim->startform, GAV.startform);
+    sim->len = GSV.len;
+    if (GSV.len>GSV.glen) {
+      sim->startform[GSV.glen] = '\0';
+      sim->farbe[GSV.glen] = '\0';
+      sim->len = GSV.glen;
+    }
+#if HAVE_LIBRNA_API3
+    sim->vc->length = sim->len;
+#endif
+  }
+  ini_or_reset_rl(sim);
+
+  /*
+    perform simulation
+  */
+  for (sim->steps = 1;; sim->steps++) {
+
+    /*
+      update the neighbourhood of current structure, the moves that
+      depend on loops changed by the last move are taken from cache
+      if the structure is there, else they are generated anew
+    */
+    if ( (c = lookup_cache(sim->cache, sim->currform)) ) get_from_cache(sim, c);
+    else move_it(sim);
+
+    /*
+      select a structure from neighbourhood of current structure
+      and make it to the new current structure.
+      stop simulation if stop condition is met.
+    */
+    if ( sel_nb(sim) > 0 ) break;
+  }
+
+  /* seed to continue with the next trajectory */
+  fprintf(sim->log, "(%5hu %5hu %5hu)", seeds[n+1][0], seeds[n+1][1], seeds[n+1][2]);
+  fflush(sim->log);
+}
+
+/* write the output of all finished trajectories that are next in line */
+static void write_results(void) {
+  TrajOut *r;
+
+  while (num_written < GSV.num && results[num_written].done) {
+    r = &results[num_written];
+    if (r->out) {
+      fwrite(r->out, 1, r->out_size, stdout);
+      fflush(stdout);
+      free(r->out);
+      r->out = NULL;
+    }
+    if (r->log) {
+      fwrite(r->log, 1, r->log_size, logFP);
+      fflush(logFP);
+      free(r->log);
+      r->log = NULL;
+    }
+    add_to_hist(r->found_stop, r->fpt);
+    num_written++;
+  }
+}
+
+/*
+  the seed of trajectory n+1 is derived from the one of trajectory n,
+  i.e. a run can be continued from the seed logged after a trajectory
+*/
+static void ini_seeds(void) {
+  int i;
+  unsigned long long x;
+
+  seeds = calloc(GSV.num+1, sizeof(*seeds));
+  assert(seeds != NULL);
+  seeds[0][0] = GAV.subi[0];
+  seeds[0][1] = GAV.subi[1];
+  seeds[0][2] = GAV.subi[2];
+  for (i = 0; i < GSV.num; i++) {
+    x = (unsigned long long)seeds[i][0]
+      | ((unsigned long long)seeds[i][1] << 16)
+      | ((unsigned long long)seeds[i][2] << 32);
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    seeds[i+1][0] = (unsigned short)x;
+    seeds[i+1][1] = (unsigned short)(x >> 16);
+    seeds[i+1][2] = (unsigned short)(x >> 32);
+  }
+}
+
+/* allocate the working copies of a simulation */
+static void ini_sim(SimState *sim) {
+  memset(sim, 0, sizeof(SimState));
+  sim->len = GSV.len;
+  sim->farbe = strdup(GAV.farbe);
+  sim->startform = strdup(GAV.startform);
+  sim->currform = (char *)calloc(GSV.len+1, sizeof(char));
+  sim->prevform = (char *)calloc(GSV.len+1, sizeof(char));
+  assert(sim->farbe && sim->startform && sim->currform && sim->prevform);
+#if HAVE_LIBRNA_API3
+  {
+    char *tmp = vrna_cut_point_insert(GAV.farbe, cut_point);
+    sim->vc = vrna_fold_compound(tmp, &(GAV.md), VRNA_OPTION_EVAL_ONLY);
+    free(tmp);
+  }
+#endif
+  sim->cache = initialize_cache(GSV.cache);
+}
+
+/**/
+static void clean_up_sim(SimState *sim) {
+  clean_up_rl(sim);
+  clean_up_nbList(sim);
+  kill_cache(sim->cache);
+#if HAVE_LIBRNA_API3
+  vrna_fold_compound_free(sim->vc);
+#endif
+  free(sim->farbe);
+  free(sim->startform);
+  free(sim->currform);
+  free(sim->prevform);
+}
+
+/*
+  histogram of first passage times with logarithmic bins, i.e. bin k
+  holds times in [10^(k/hist_bins), 10^((k+1)/hist_bins)); shorter
+  times go to the first bin
+*/
+static void ini_hist(void) {
+
+  if (GSV.hist <= 0) return;
+
+  hist_bins = GSV.hist;
+  hist_min = -3*hist_bins;
+  hist_max = (int)floor(hist_bins*log10(GSV.time > 1. ? GSV.time : 1.)) + 1;
+  hist = (int *)calloc((size_t)(GSV.maxS+1)*(hist_max-hist_min+1), sizeof(int));
+  assert(hist != NULL);
+}
+
+/* column 0 counts the trajectories without stop structure */
+static void add_to_hist(int found_stop, double fpt) {
+  int k;
+
+  if (hist == NULL) return;
+
+  k = (fpt > 0) ? (int)floor(hist_bins*log10(fpt)) : hist_min;
+  if (k < hist_min) k = hist_min;
+  if (k > hist_max) k = hist_max;
+  hist[(k-hist_min)*(GSV.maxS+1) + found_stop]++;
+}
+
+/**/
+static void write_hist(void) {
+  char histFN[256];
+  int i, k, n, first = 0, last = -1, none = 0;
+  int *row;
+  FILE *fp;
+
+  if (hist == NULL) return;
+
+  /* skip empty bins on both ends */
+  for (k = hist_min; k <= hist_max; k++) {
+    row = hist + (size_t)(k-hist_min)*(GSV.maxS+1);
+    none += row[0];
+    for (n = 0, i = 1; i <= GSV.maxS; i++) n += row[i];
+    if (n > 0) {
+      if (last < first) first = k;
+      last = k;
+    }
+  }
+
+  fp = fopen(strcat(strcpy(histFN, GAV.BaseName), ".hist"), "w");
+  if (fp == NULL) {
+    fprintf(stderr, "can't open file %s\n", histFN);
+    free(hist);
+    return;
+  }
+  fprintf(fp, "# first passage times of %d trajectories (%d bins per decade)\n",
+	  GSV.num, hist_bins);
+  fprintf(fp, "#%11s %12s", "from", "to");
+  for (i = 1; i <= GSV.maxS; i++) fprintf(fp, "    X%02d", i);
+  fprintf(fp, "\n");
+  for (k = first; k <= last; k++) {
+    row = hist + (size_t)(k-hist_min)*(GSV.maxS+1);
+    fprintf(fp, "%12.5g %12.5g", pow(10., (double)k/hist_bins),
+	    pow(10., (double)(k+1)/hist_bins));
+    for (i = 1; i <= GSV.maxS; i++) fprintf(fp, " %6d", row[i]);
+    fprintf(fp, "\n");
+  }
+  fprintf(fp, "# no stop structure reached: %d\n", none);
+  fclose(fp);
+  free(hist);
+}
+
 /**/
 static void ini_energy_model(void) {
 
@@ -183,10 +495,6 @@ static void read_data(void) {
   for (i = 0; i < len; i++) GAV.farbe[i] = toupper(GAV.farbe[i]);
   free (ctmp);
   /* allocate some global arrays */
-  GAV.currform = (char *)calloc(GSV.len +1, sizeof(char));
-  assert(GAV.currform != NULL);
-  GAV.prevform = (char *)calloc(GSV.len +1, sizeof(char));
-  assert(GAV.prevform != NULL);
   GAV.startform = (char *)calloc(GSV.len +1, sizeof(char));
   assert(GAV.startform != NULL);
 
@@ -255,8 +563,9 @@ static void read_data(void) {
 
 /**/
 void clean_up(void) {
+  fprintf(logFP,"\n");
+  fclose(logFP);
+  free(seeds);
+  free(results);
   clean_up_globals();
-  clean_up_rl();
-  clean_up_nbList();
-  kill_cache();
 }
@@ -24,307 +24,418 @@
 #include <utils.h>
 #endif
 
-#include "cache_util.h"
 #include "baum.h"
+#include "cache_util.h"
 
 static char UNUSED rcsid[]="$Id: nachbar.c,v 1.8 2008/06/03 21:55:11 ivo Exp $";
 
-/* arrays */
-static short *neighbor_list=NULL;
-static float *bmf=NULL; /* boltzmann weight of structure */
-static const char *costring(const char *str);
-
-/* globals for laplace stuff */
-static double L = 0.0;
-static double D = 0.0;
-static double sumT = 0.0;
-static double sumK = 0.0;
-static double sumKK = 0.0;
-static double sumD = 0.0;
-static double *energies=NULL; /* energies of neighbors */
-
-/* variables */
-/*  static double highestE = -1000.0; */
-/*  static double OhighestE = -1000.0; */
-/*  static char *highestS, *OhighestS; */
-static int lmin = 1;
-static int top = 0;
-static int is_from_cache = 0;
-/*  static double meanE = 0.0; */
-static double totalflux = 0.0;
-static double Zeit = 0.0;
-static double zeitInc = 0.0;
-static double _RT = 0.6;
-
 /* public functiones */
-void ini_nbList(int chords);
-void update_nbList(int i, int j, int iE);
-int sel_nb(void);
-void clean_up_nbList(void);
-extern void update_tree(int i, int j);
+void ini_nbList(SimState *sim, int groups);
+void clear_nbList(SimState *sim);
+void reset_group(SimState *sim, int g);
+void update_nbList(SimState *sim, int i, int j, int dE);
+void get_from_cache(SimState *sim, cache_entry *c);
+void put_in_cache(SimState *sim);
+int sel_nb(SimState *sim);
+void clean_up_nbList(SimState *sim);
 
 /* privat functiones */
-static void reset_nbList(void);
-static void grow_chain(void);
-static FILE *logFP=NULL;
-
-/**/
-void ini_nbList(int chords) {
-  char logFN[256];
+static void add_move(SimState *sim, int i, int j, int dE, double p);
+static void set_rate(SimState *sim, int s, double p);
+static void zero_released(SimState *sim);
+static int find_slot(SimState *sim, double x);
+static void grow_nbList(SimState *sim);
+static int grow_chain(SimState *sim);
+static const char *costring(SimState *sim, const char *str);
 
-  _RT = (((temperature + K0) * GASCONST) / 1000.0);
-  if (neighbor_list!=NULL) return;
-  /*
-    list for move coding
-    make room for 2*chords neighbors (safe bet)
-  */
-  if (chords == 0) chords = 1;
-  neighbor_list = (short *)calloc(4*chords, sizeof(short));
-  assert(neighbor_list != NULL);
-  /*
-    list for Boltzmann-factors
-  */
-  bmf = (float *)calloc(2*chords, sizeof(double));
-  assert(bmf != NULL);
+/*
+  The moves of the current structure are kept in slots. The slots of
+  all moves that belong to the same base pair (or to the exterior loop)
+  form a group, which baum.c generates anew whenever one of the loops
+  the moves depend on has changed. The rates of all slots are the
+  leaves of a binary tree, whose inner nodes hold the sum of their
+  children, so a move is selected and a rate is changed in O(log n).
+  A freed slot keeps its rate until the next move is selected, since it
+  is mostly taken again by the same move when its group is refilled.
+  The moves of visited structures are kept in the cache by group, so
+  on returning to a structure the groups that changed are copied from
+  there instead of being generated anew.
+*/
 
-  /* list of neighbor energies */
-  energies = (double*)calloc(2*chords, sizeof(double));
-  assert(energies != NULL);
-  
-  /* open log-file */
-  logFP = fopen(strcat(strcpy(logFN, GAV.BaseName), ".log"), "a+");
-  assert(logFP != NULL);
+/**/
+void ini_nbList(SimState *sim, int groups) {
+
+  sim->RT = (((temperature + K0) * GASCONST) / 1000.0);
+  if (sim->neighbor_list!=NULL) return;
+
+  /* one group per base pair, group 0 is the exterior loop */
+  sim->groups = groups;
+  sim->group_first = (int *)malloc(groups*sizeof(int));
+  sim->dirty = (char *)calloc(groups, sizeof(char));
+  sim->dirty_list = (int *)malloc(groups*sizeof(int));
+  sim->stale = (char *)calloc(groups, sizeof(char));
+  sim->stale_list = (int *)malloc(groups*sizeof(int));
+  assert(sim->group_first && sim->dirty && sim->dirty_list);
+  assert(sim->stale && sim->stale_list);
+
+  /* start with some slots, grow_nbList() makes room for more */
+  for (sim->slots = 64; sim->slots < 4*groups; sim->slots <<= 1);
+  sim->neighbor_list = (short *)malloc(2*sim->slots*sizeof(short));
+  sim->dE = (int *)malloc(sim->slots*sizeof(int));
+  sim->slot_next = (int *)malloc(sim->slots*sizeof(int));
+  sim->rate_tree = (double *)calloc(2*sim->slots, sizeof(double));
+  sim->used = (char *)calloc(sim->slots, sizeof(char));
+  sim->released = (int *)malloc(sim->slots*sizeof(int));
+  assert(sim->neighbor_list && sim->dE && sim->slot_next && sim->rate_tree);
+  assert(sim->used && sim->released);
+
+  clear_nbList(sim);
+}
 
-  /* log initial condition */
-  log_prog_params(logFP);
-  log_start_stop(logFP);
+/* remove all moves */
+void clear_nbList(SimState *sim) {
+  int s;
+
+  memset(sim->rate_tree, 0, 2*sim->slots*sizeof(double));
+  memset(sim->used, 0, sim->slots*sizeof(char));
+  sim->num_released = 0;
+  for (s = 0; s < sim->slots; s++) sim->slot_next[s] = s+1;
+  sim->slot_next[sim->slots-1] = -1;
+  sim->free_slot = 0;
+  for (s = 0; s < sim->groups; s++) sim->group_first[s] = -1;
+  sim->group = 0;
+  sim->top = 0;
+  sim->num_down = sim->num_flat = 0;
+  sim->sum_dE = 0;
 }
 
-/**/
-void update_nbList(int i, int j, int iE) {
-  double E, dE, p;
+/* remove all moves of group g, update_nbList() adds moves to g */
+void reset_group(SimState *sim, int g) {
+  int s, next;
+
+  for (s = sim->group_first[g]; s >= 0; s = next) {
+    next = sim->slot_next[s];
+    sim->used[s] = 0;
+    sim->released[sim->num_released++] = s;
+    sim->top--;
+    sim->sum_dE -= sim->dE[s];
+    if (sim->dE[s] < 0) sim->num_down--;
+    else if (sim->dE[s] == 0) sim->num_flat--;
+    sim->slot_next[s] = sim->free_slot;
+    sim->free_slot = s;
+  }
+  sim->group_first[g] = -1;
+  sim->group = g;
+}
 
-  E = (double)iE/100.;
-  neighbor_list[2*top] = (short )i;
-  neighbor_list[2*top+1] = (short )j;
-  
-  /* compute rates and some statistics */
-  /*    meanE += E; */
-  dE = E-GSV.currE;
+/* add move (i,j) with energy change dE (in dcal/mol) */
+void update_nbList(SimState *sim, int i, int j, int dE) {
+  double p, E;
 
-  /* laplace stuff */
-  energies[top] = E;
-  L += GSV.currE-E;
-  D++;
-  /* fprintf(stderr, ">>%g %g<<\n", L, D); */
-  
+  /* compute rates */
+  E = (double)dE/100.;
   if( GTV.mc ) {
     /* metropolis rule */
-    if (dE < 0) p = 1;
-    else p = exp(-(dE / _RT*GSV.phi));
+    if (E < 0) p = 1;
+    else p = exp(-(E / sim->RT*GSV.phi));
   }
   else  /* kawasaki rule */
-    p = exp(-0.5 * (dE / _RT*GSV.phi));
+    p = exp(-0.5 * (E / sim->RT*GSV.phi));
 
-  totalflux += p;
-  bmf[top++] = (float )p;
-  if (dE < 0) lmin = 0;
-  if ((dE == 0) && (lmin==1)) lmin = 2;
+  add_move(sim, i, j, dE, p);
 }
 
-/**/
-void get_from_cache(cache_entry *c) {
-  top = c->top;
-  totalflux = c->flux;
-  GSV.currE = c->energy;
-  lmin = c->lmin;
-  memcpy(neighbor_list, c->neighbors, 2*top*sizeof(short));
-  memcpy(bmf, c->rates, top*sizeof(float));
-  memcpy(energies, c->energies, top*sizeof(double));
-  is_from_cache = 1;
+/* put move (i,j) with rate p into a free slot of the current group */
+static void add_move(SimState *sim, int i, int j, int dE, double p) {
+  int s;
+
+  if (sim->free_slot < 0) grow_nbList(sim);
+  s = sim->free_slot;
+  sim->free_slot = sim->slot_next[s];
+  sim->slot_next[s] = sim->group_first[sim->group];
+  sim->group_first[sim->group] = s;
+
+  sim->neighbor_list[2*s] = (short )i;
+  sim->neighbor_list[2*s+1] = (short )j;
+  sim->dE[s] = dE;
+  sim->used[s] = 1;
+
+  /* some statistics */
+  if (sim->rate_tree[sim->slots+s] != p) set_rate(sim, s, p);
+  sim->top++;
+  sim->sum_dE += dE;
+  if (dE < 0) sim->num_down++;
+  else if (dE == 0) sim->num_flat++;
 }
 
-/**/
-void put_in_cache(void) {
+/*
+  the current structure is in the cache: refill the groups that would
+  have to be generated anew. The moves are added in the order they were
+  generated in, so the slots and the trajectory are the same as without
+  the cache.
+*/
+void get_from_cache(SimState *sim, cache_entry *c) {
+  int k, g, m;
+
+  set_loop_energies(sim, c->loop_energy);
+  for (k = 0; k < sim->num_dirty; k++) {
+    g = sim->dirty_list[k];
+    sim->dirty[g] = 0;
+    reset_group(sim, g);
+    for (m = c->first[g]; m < c->first[g+1]; m++)
+      add_move(sim, c->neighbors[2*m], c->neighbors[2*m+1], c->dE[m], c->rates[m]);
+  }
+  sim->num_dirty = 0;
+  sim->currE = c->energy;
+  sim->is_from_cache = 1;
+}
+
+/* store the moves of the current structure group by group */
+void put_in_cache(SimState *sim) {
+  int g, s, m, k;
   cache_entry *c;
 
-  if ((c = (cache_entry *) malloc(sizeof(cache_entry)))==NULL) {
-    fprintf(stderr, "out of memory\n"); exit(255);
+  c = new_cache_entry(sim->currform, sim->top, sim->groups);
+  for (m = 0, g = 0; g < sim->groups; g++) {
+    c->first[g] = m;
+    for (s = sim->group_first[g]; s >= 0; s = sim->slot_next[s]) m++;
+    /* the list of a group starts with its last move */
+    for (k = m, s = sim->group_first[g]; s >= 0; s = sim->slot_next[s]) {
+      k--;
+      c->neighbors[2*k] = sim->neighbor_list[2*s];
+      c->neighbors[2*k+1] = sim->neighbor_list[2*s+1];
+      c->dE[k] = sim->dE[s];
+      c->rates[k] = sim->rate_tree[sim->slots+s];
+    }
+  }
+  c->first[g] = m;
+  get_loop_energies(sim, c->loop_energy);
+  c->energy = sim->currE;
+  write_cache(sim->cache, c);
+}
+
+/* set the rate of slot s and the sums above it */
+static void set_rate(SimState *sim, int s, double p) {
+  int k;
+
+  k = sim->slots + s;
+  sim->rate_tree[k] = p;
+  for (k >>= 1; k > 0; k >>= 1)
+    sim->rate_tree[k] = sim->rate_tree[2*k] + sim->rate_tree[2*k+1];
+}
+
+/* set the rates of released slots that were not taken again to 0 */
+static void zero_released(SimState *sim) {
+  int k, s;
+
+  for (k = 0; k < sim->num_released; k++) {
+    s = sim->released[k];
+    if (!sim->used[s] && sim->rate_tree[sim->slots+s] != 0.) set_rate(sim, s, 0.);
+  }
+  sim->num_released = 0;
+}
+
+/* slot in which the cumulative rate exceeds x */
+static int find_slot(SimState *sim, double x) {
+  int k;
+
+  for (k = 1; k < sim->slots;) {
+    /* never descend into an empty subtree because of rounding errors */
+    if (x < sim->rate_tree[2*k] || sim->rate_tree[2*k+1] <= 0.) k = 2*k;
+    else {
+      x -= sim->rate_tree[2*k];
+      k = 2*k+1;
+    }
+  }
+  return k - sim->slots;
+}
+
+/* double the number of slots */
+static void grow_nbList(SimState *sim) {
+  int s, k, slots;
+  double *tree;
+
+  slots = 2*sim->slots;
+  sim->neighbor_list = (short *)realloc(sim->neighbor_list, 2*slots*sizeof(short));
+  sim->dE = (int *)realloc(sim->dE, slots*sizeof(int));
+  sim->slot_next = (int *)realloc(sim->slot_next, slots*sizeof(int));
+  sim->used = (char *)realloc(sim->used, slots*sizeof(char));
+  sim->released = (int *)realloc(sim->released, slots*sizeof(int));
+  tree = (double *)calloc(2*slots, sizeof(double));
+  assert(sim->neighbor_list && sim->dE && sim->slot_next && tree);
+  assert(sim->used && sim->released);
+
+  /* copy the leaves and rebuild the sums */
+  memcpy(tree+slots, sim->rate_tree+sim->slots, sim->slots*sizeof(double));
+  for (k = slots-1; k > 0; k--) tree[k] = tree[2*k] + tree[2*k+1];
+  free(sim->rate_tree);
+  sim->rate_tree = tree;
+
+  /* all old slots are taken */
+  for (s = sim->slots; s < slots; s++) {
+    sim->slot_next[s] = s+1;
+    sim->used[s] = 0;
   }
-/*    c->structure = strdup(GAV.currform); */
-  c->structure = (char *) calloc(GSV.len+1, sizeof(char));
-  strcpy(c->structure, GAV.currform);
-  c->neighbors = (short *) malloc(top*2*sizeof(short));
-  memcpy(c->neighbors,neighbor_list,top*2*sizeof(short));
-  c->rates = (float *) malloc(top*sizeof(float));
-  memcpy(c->rates, bmf, top*sizeof(float));
-  c->energies = (double*)malloc(top*sizeof(double));
-  memcpy(c->energies, energies, top*sizeof(double));
-  c->top = top;
-  c->lmin = lmin;
-  c->flux = totalflux;
-  c->energy = GSV.currE;
-  write_cache(c);
+  sim->slot_next[slots-1] = -1;
+  sim->free_slot = sim->slots;
+  sim->slots = slots;
 }
 
 /*============*/
 
-int sel_nb(void) {
+int sel_nb(SimState *sim) {
 
   char trans, **s;
-  int next, i;
-  double pegel = 0.0, schwelle = 0.0, zufall = 0.0;
+  int next, grown = 0;
+  double schwelle = 0.0, zufall = 0.0;
   int found_stop=0;
 
   /* before we select a move, store current conformation in cache */
   /* ... unless it just came from there */
-  if ( !is_from_cache ) put_in_cache();
-  else
-    /* laplace stuff */
-    for (i=0; i<top; i++) {
-      L += (GSV.currE - energies[i]);
-      D++;
-    }
-  is_from_cache = 0;
+  if ( !sim->is_from_cache ) put_in_cache(sim);
+  sim->is_from_cache = 0;
+
+  /* laplace stuff */
+  sim->L -= (double)sim->sum_dE/100.;
+  sim->D += sim->top;
+
+  /* is the current structure a local minimum ? */
+  if (sim->num_down > 0) sim->lmin = 0;
+  else if (sim->num_flat > 0) sim->lmin = 2;
+  else sim->lmin = 1;
+
+  zero_released(sim);
+  sim->totalflux = sim->rate_tree[1];
 
   /* draw 2 different a random number */
-  schwelle = urn();
-  while ( zufall==0 ) zufall = urn();
+  schwelle = erand48(sim->subi);
+  while ( zufall==0 ) zufall = erand48(sim->subi);
 
   /* advance internal clock */
-  if (totalflux>0)
-    zeitInc = (log(1. / zufall) / totalflux);
+  if (sim->totalflux>0)
+    sim->zeitInc = (log(1. / zufall) / sim->totalflux);
   else {
-    if (GSV.grow>0) zeitInc=GSV.grow;
-    else zeitInc = GSV.time;
+    if (GSV.grow>0) sim->zeitInc=GSV.grow;
+    else sim->zeitInc = GSV.time;
   }
 
-  Zeit += zeitInc;
+  sim->Zeit += sim->zeitInc;
 
   /* laplace stuff */
-  sumK  += L*zeitInc;
-  sumKK += L*L*zeitInc;
-  sumD  += D*zeitInc;
+  sim->sumK  += sim->L*sim->zeitInc;
+  sim->sumKK += sim->L*sim->L*sim->zeitInc;
+  sim->sumD  += sim->D*sim->zeitInc;
   
-  if (GSV.grow>0 && GSV.len < strlen(GAV.farbe_full)) grow_chain();
+  if (GSV.grow>0 && sim->len < strlen(GAV.farbe_full)) grown = grow_chain(sim);
 
   /* meanE /= (double)top; */
 
-  /* normalize boltzmann weights */
-  schwelle *=totalflux;
-
-  /* and choose a neighbour structure next */
-  for (next = 0; next < top; next++) {
-    pegel += bmf[next];
-    if (pegel > schwelle) break;
-  }
-
-  /* in case of rounding errors */
-  if (next==top) next=top-1;
+  /* and choose a neighbour structure next, no structure move
+     if there is no neighbour or the chain has grown */
+  if (grown || sim->top == 0) next = -1;
+  else next = find_slot(sim, schwelle*sim->totalflux);
 
   /*
     process termination contitiones
   */
   /* is current structure identical to a stop structure ?*/
   for (found_stop = 0, s = GAV.stopform; *s; s++) {
-    if (strcmp(*s, GAV.currform) == 0) {
+    if (strcmp(*s, sim->currform) == 0) {
       found_stop = (s - GAV.stopform) + 1;
       break;
     }
   }
 
-  if ( ((found_stop > 0) && (GTV.fpt == 1)) || (Zeit > GSV.time) ) {
+  if ( ((found_stop > 0) && (GTV.fpt == 1)) || (sim->Zeit > GSV.time) ) {
     /* met condition to stop simulation */
 
     /* laplace stuff */
     double K, KK, N, sigma;
-    K = sumK/Zeit;
-    KK = sumKK/Zeit;
-    N = sumD/Zeit;
+    K = sim->sumK/sim->Zeit;
+    KK = sim->sumKK/sim->Zeit;
+    N = sim->sumD/sim->Zeit;
     /* graph Laplacian is - Laplace-Beltrami operator */
     sigma = -1.0*sqrt((KK-K*K)/N)/(K/N);
     
     /* this goes to stdout */
     if ( !GTV.silent ) {
-      printf("%s %6.2f %10.3f", costring(GAV.currform), GSV.currE, Zeit);
+      fprintf(sim->out, "%s %6.2f %10.3f", costring(sim, sim->currform), sim->currE, sim->Zeit);
 
       /* laplace stuff*/
-      if (GTV.phi) printf(" %8.3f %8.3f %3g", zeitInc, L, D); 
+      if (GTV.phi) fprintf(sim->out, " %8.3f %8.3f %3g", sim->zeitInc, sim->L, sim->D); 
 
-      if (GTV.verbose) printf(" %4d _ %d", top, lmin);
-      if (found_stop) printf(" X%d\n", found_stop);/* found a stop structure */
-      else printf(" O\n"); /* time for simulation is exceeded */
+      if (GTV.verbose) fprintf(sim->out, " %4d _ %d", sim->top, sim->lmin);
+      if (found_stop) fprintf(sim->out, " X%d\n", found_stop);/* found a stop structure */
+      else fprintf(sim->out, " O\n"); /* time for simulation is exceeded */
 
       /* laplace stuff */
-      if (GTV.phi) printf("Curvature fluctuation sigma = %7.5f\n", sigma);
+      if (GTV.phi) fprintf(sim->out, "Curvature fluctuation sigma = %7.5f\n", sigma);
 
-      fflush(stdout);
+      fflush(sim->out);
     }
 
     /* this goes to log */
     /* comment log steps of simulation as well !!! %6.2f  round */
     if ( found_stop ) {
-      fprintf(logFP," X%02d %12.3f", found_stop, Zeit);
+      fprintf(sim->log," X%02d %12.3f", found_stop, sim->Zeit);
 
       /* laplace stuff */
-      if (GTV.phi) fprintf(logFP, " %3g %7.5f", GSV.phi, sigma);
+      if (GTV.phi) fprintf(sim->log, " %3g %7.5f", GSV.phi, sigma);
 
-      fprintf(logFP,"\n");
+      fprintf(sim->log,"\n");
     }
     else {
-      fprintf(logFP," O   %12.3f", Zeit);
+      fprintf(sim->log," O   %12.3f", sim->Zeit);
 
       /* laplace stuff */
-      if (GTV.phi) fprintf(logFP, " %3g %7.5f", GSV.phi, sigma);      
+      if (GTV.phi) fprintf(sim->log, " %3g %7.5f", GSV.phi, sigma);      
 
-      fprintf(logFP," %d %s\n", lmin, costring(GAV.currform));
+      fprintf(sim->log," %d %s\n", sim->lmin, costring(sim, sim->currform));
     }
-    GAV.subi[0] = xsubi[0];
-    GAV.subi[1] = xsubi[1];
-    GAV.subi[2] = xsubi[2];
-    fprintf(logFP, "(%5hu %5hu %5hu)", GAV.subi[0], GAV.subi[1], GAV.subi[2]);
-    fflush(logFP);
-    
-    Zeit = 0.0;
+    fflush(sim->log);
+
+    /* remember result for statistics */
+    sim->found_stop = found_stop;
+    sim->fpt = sim->Zeit;
+    sim->Zeit = 0.0;
 
     /* reset laplace stuff for next trajectory */
-    sumT = 0.0;
-    sumK = 0.0;
-    sumKK = 0.0;
-    sumD = 0.0;
-    L = 0.0;
-    D = 0.0;
+    sim->sumT = 0.0;
+    sim->sumK = 0.0;
+    sim->sumKK = 0.0;
+    sim->sumD = 0.0;
+    sim->L = 0.0;
+    sim->D = 0.0;
     
     /*  highestE = OhighestE = -1000.0; */
-    reset_nbList();
-    costring(NULL);
+    costring(sim, NULL);
     return(1);
   }
   else {
     /* continue simulation */
     int flag = 0;
-    if( (!GTV.silent) && (GSV.currE <= GSV.stopE+GSV.cut) ) {
+    if( (!GTV.silent) && (sim->currE <= GSV.stopE+GSV.cut) ) {
 
-      if (!GTV.lmin || (lmin==1 && strcmp(GAV.prevform, GAV.currform) != 0)) {
+      if (!GTV.lmin || (sim->lmin==1 && strcmp(sim->prevform, sim->currform) != 0)) {
 	char format[64];
 	flag = 1;
 	sprintf(format, "%%-%ds %%6.2f %%10.3f", strlen(GAV.farbe_full)+1);
-	printf(format, costring(GAV.currform), GSV.currE, Zeit);
+	fprintf(sim->out, format, costring(sim, sim->currform), sim->currE, sim->Zeit);
       }
 
       /* laplace stuff */
       if (GTV.phi) {
-	printf(" %8.3f %8.3f %3g", zeitInc, L, D);
-	L = D = 0.0; /* reset L and D for next structure */
+	fprintf(sim->out, " %8.3f %8.3f %3g", sim->zeitInc, sim->L, sim->D);
+	sim->L = sim->D = 0.0; /* reset L and D for next structure */
       }
 
       if ( flag && GTV.verbose ) {
 	int ii, jj;
 	if (next<0) trans='g'; /* growth */
 	else {
-	  ii = neighbor_list[2*next];
-	  jj = neighbor_list[2*next+1];
-	  if (abs(ii) < GSV.len) {
+	  ii = sim->neighbor_list[2*next];
+	  jj = sim->neighbor_list[2*next+1];
+	  if (abs(ii) < sim->len) {
 	    if ((ii > 0) && (jj > 0)) trans = 'i';
 	    else if ((ii < 0) && (jj < 0)) trans = 'd';
 	    else if ((ii > 0) && (jj < 0)) trans = 's';
@@ -334,113 +445,119 @@ int sel_nb(void) {
 	    else trans = 'D';
 	  }
 	}
-	printf(" %4d %c %d", top, trans, lmin);
+	fprintf(sim->out, " %4d %c %d", sim->top, trans, sim->lmin);
       }
-      if (flag) printf("\n");
+      if (flag) fprintf(sim->out, "\n");
     }
   }
 
 
   /* store last lmin seen, so we can avoid printing the same lmin twice */
-  if (lmin==1)
-    strcpy(GAV.prevform, GAV.currform);
+  if (sim->lmin==1)
+    strcpy(sim->prevform, sim->currform);
 
 #if 0
-  if (lmin==1) {
+  if (sim->lmin==1) {
     /* went back to previous lmin */
-    if (strcmp(GAV.prevform, GAV.currform) == 0) {
+    if (strcmp(sim->prevform, sim->currform) == 0) {
       if (OhighestE < highestE) {
 	highestE = OhighestE;  /* delete loop */
 	strcpy(highestS, OhighestS);
       }
     } else {
-      strcpy(GAV.prevform, GAV.currform);
+      strcpy(sim->prevform, sim->currform);
       OhighestE = 10000.;
     }
   }
 
-  if ( strcmp(GAV.currform, GAV.startform)==0 ) {
+  if ( strcmp(sim->currform, sim->startform)==0 ) {
     OhighestE = highestE = -1000.;
     highestS[0] = 0;
   }
 
   /* log highes energy */
-  if (GSV.currE > highestE) {
+  if (sim->currE > highestE) {
     OhighestE = highestE;
-    highestE = GSV.currE;
+    highestE = sim->currE;
     strcpy(OhighestS, highestS);
-    strcpy(highestS, GAV.currform);
+    strcpy(highestS, sim->currform);
   }
 #endif
 
-  if (next>=0) update_tree(neighbor_list[2*next], neighbor_list[2*next+1]);
+  if (next>=0) {
+    update_tree(sim, sim->neighbor_list[2*next], sim->neighbor_list[2*next+1]);
+    sim->currE = (float)((int) (sim->currE*100 + ((sim->currE<0)?-0.4:0.4)) + sim->dE[next]) / 100.;
+  }
   else {
-    clean_up_rl(); ini_or_reset_rl();
+    clean_up_rl(sim); ini_or_reset_rl(sim);
   }
 
-  reset_nbList();
   return(0);
 }
 
-/*==========================*/
-static void reset_nbList(void) {
-
-  top = 0;
-  totalflux = 0.0;
-  /*    meanE = 0.0; */
-  lmin = 1;
-}
-
 /*======================*/
-void clean_up_nbList(void){
-
-  free(neighbor_list);
-  free(bmf);
-  free(energies);
-  fprintf(logFP,"\n");
-  fclose(logFP);
+void clean_up_nbList(SimState *sim){
+
+  free(sim->neighbor_list);
+  free(sim->dE);
+  free(sim->slot_next);
+  free(sim->rate_tree);
+  free(sim->used);
+  free(sim->released);
+  free(sim->group_first);
+  free(sim->dirty);
+  free(sim->dirty_list);
+  free(sim->stale);
+  free(sim->stale_list);
+  sim->neighbor_list = NULL;
+  sim->dE = sim->slot_next = sim->group_first = sim->dirty_list = NULL;
+  sim->stale_list = sim->released = NULL;
+  sim->rate_tree = NULL;
+  sim->dirty = sim->stale = sim->used = NULL;
+  costring(sim, NULL);
 }
 
 /*======================*/
-static void grow_chain(void){
+/* returns 1 if the chain has grown */
+static int grow_chain(SimState *sim){
   int newl;
   /* note Zeit=0 corresponds to chain length GSV.glen */
-  if (Zeit<(GSV.len+1-GSV.glen) * GSV.grow) return;
-  newl = GSV.len+1;
-  Zeit = (newl-GSV.glen) * GSV.grow;
-  top=0; /* prevent structure move in sel_nb */
-
-  if (GSV.len<newl) {
-    strncpy(GAV.farbe, GAV.farbe_full, newl);
-    GAV.farbe[newl] = '\0';
-    strcpy(GAV.startform, GAV.currform);
-    strcat(GAV.startform, ".");
-
-    GSV.len = newl;
+  if (sim->Zeit<(sim->len+1-GSV.glen) * GSV.grow) return 0;
+  newl = sim->len+1;
+  sim->Zeit = (newl-GSV.glen) * GSV.grow;
+
+  if (sim->len<newl) {
+    strncpy(sim->farbe, GAV.farbe_full, newl);
+    sim->farbe[newl] = '\0';
+    strcpy(sim->startform, sim->currform);
+    strcat(sim->startform, ".");
+
+    sim->len = newl;
 #if HAVE_LIBRNA_API3
-    /* fake actual length of sequence in GAV.vc */
-    GAV.vc->length = newl;
+    /* fake actual length of sequence in sim->vc */
+    sim->vc->length = newl;
 #endif
   }
+  return 1;
 }
 
-static const char *costring(const char *str) {
-  static char* buffer=NULL;
-  static int size=0;
+static const char *costring(SimState *sim, const char *str) {
+  char *buffer;
   int n;
   if (str==NULL) {
-    if (buffer) {
+    if (sim->costring) {
       /* make it possible to free buffer */
-      free(buffer);
-      size = 0; buffer = NULL;
+      free(sim->costring);
+      sim->costring_size = 0; sim->costring = NULL;
     }
     return NULL;
   }
   n=strlen(str);
-  if (n>=size) {
-    size = n+2;
-    buffer = realloc(buffer, size);
+  if (n>=sim->costring_size) {
+    sim->costring_size = n+2;
+    sim->costring = realloc(sim->costring, sim->costring_size);
   }
+  buffer = sim->costring;
   if ((cut_point>0)&&(cut_point<=n)) {
     strncpy(buffer, str, cut_point-1);
     buffer[cut_point-1] = '&';
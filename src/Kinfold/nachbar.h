@@ -9,13 +9,17 @@
 #ifndef NACHBAR_H
 #define NACHBAR_H
 
+#include "globals.h"
+#include "cache_util.h"
+
 /* used in baum.c */
-extern void ini_nbList(int chords);
-extern void update_nbList(int i,int j, int iE);
+extern void ini_nbList(SimState *sim, int groups);
+extern void clear_nbList(SimState *sim);
+extern void reset_group(SimState *sim, int g);
+extern void update_nbList(SimState *sim, int i,int j, int dE);
 
 /* used in main.c */
-extern int sel_nb(void);
-extern void clean_up_nbList(void);
-
-extern void grow_chain(void);
+extern int sel_nb(SimState *sim);
+extern void get_from_cache(SimState *sim, cache_entry *c);
+extern void clean_up_nbList(SimState *sim);
 #endif
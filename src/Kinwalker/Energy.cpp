@@ -6,6 +6,7 @@
 #include <iostream>
 #include <string>
 #include <cstring>
+#include <map>
 #include "Energy.h"
 
 
@@ -14,6 +15,9 @@ extern "C" {
 #include "fold_vars.h"
 #include "utils.h"
 #include "pair_mat.h"
+#include "model.h"
+#include "fold_compound.h"
+#include "eval.h"
 }
 extern short * S;
 extern short * S1;
@@ -22,12 +26,89 @@ extern short * pair_table;
 static float
 (*EnergyModel)(std::string sequence, std::string structure) = NULL;
 
+/* upper limit for the bytes kept in the energy memo */
+#define ENERGY_MEMO_BYTES (64 * 1024 * 1024)
 
+static vrna_fold_compound_t *prefix_compound = NULL;
 
+/* energies of the structures already evaluated on the transcribed prefix,
+ * keyed by the raw content of their pair table */
+static std::map<std::string, int> prefix_energies;
+static size_t prefix_energies_bytes = 0;
 
+
+/**
+ * Returns the memory taken by a memo entry with a key of key_size
+ * bytes: the tree node with its three links and color, the key and
+ * energy it holds, the key buffer, and the bookkeeping of malloc for
+ * both allocations.
+ */
+static size_t
+MemoEntryBytes(size_t key_size)
+{
+  return 4 * sizeof(void *) + sizeof(std::map<std::string, int>::value_type)
+         + key_size + 1 + 2 * 2 * sizeof(void *);
+}
+
+
+/**
+ * Drops all memoized energies
+ */
+static void
+ClearMemo()
+{
+  prefix_energies.clear();
+  prefix_energies_bytes = 0;
+}
+
+
+/**
+ * Returns the fold compound used to evaluate structures of the
+ * transcribed prefix. All evaluations between two transcription steps
+ * are done on the same prefix, so the compound, and with it the
+ * energy parameters, is only re-created once a base is appended.
+ */
+static vrna_fold_compound_t *
+PrefixCompound(const std::string & sequence)
+{
+  if (prefix_compound == NULL || sequence != prefix_compound->sequence) {
+    vrna_md_t md;
+
+    vrna_fold_compound_free(prefix_compound);
+    ClearMemo();
+    set_model_details(&md);
+    prefix_compound = vrna_fold_compound(sequence.c_str(), &md, VRNA_OPTION_EVAL_ONLY);
+  }
+
+  return (prefix_compound);
+}
+
+
+/**
+ * Evaluates the structure in pair_table. The barrier heuristics walk
+ * through the same structures over and over again while they search
+ * for the best order of base pair moves, so energies are looked up in
+ * a memo that is valid until the next base is transcribed.
+ */
 double
 FastEvalEnergy(std::string sequence){
-  return energy_of_struct_pt(const_cast<char*>(sequence.c_str()), pair_table, S, S1)/100.;
+  vrna_fold_compound_t *fc = PrefixCompound(sequence);
+
+  if (eos_debug > 0)
+    return vrna_eval_structure_pt_v(fc, pair_table, eos_debug, NULL)/100.;
+
+  std::string key(reinterpret_cast<const char *>(pair_table), (fc->length + 1) * sizeof(short));
+  std::map<std::string, int>::iterator it = prefix_energies.find(key);
+  if (it == prefix_energies.end()) {
+    int energy = vrna_eval_structure_pt(fc, pair_table);
+    size_t bytes = MemoEntryBytes(key.size());
+    if (prefix_energies_bytes + bytes > ENERGY_MEMO_BYTES)
+      ClearMemo();
+    it = prefix_energies.insert(std::make_pair(key, energy)).first;
+    prefix_energies_bytes += bytes;
+  }
+
+  return it->second/100.;
   //= energy_of_struct(sequence.c_str(), structure.c_str());
 }
 //operation: einfuege, wegnehmen
@@ -158,12 +239,27 @@ FullEnergyModel(std::string sequence, std::string structure)
 {
   // initialize_fold(sequence.length());
  
-  float energy = energy_of_struct(sequence.c_str(), structure.c_str());
+  vrna_fold_compound_t *fc = PrefixCompound(sequence);
+  float energy = (eos_debug > 0) ?
+                 vrna_eval_structure_verbose(fc, structure.c_str(), NULL) :
+                 vrna_eval_structure(fc, structure.c_str());
   // free_arrays();
 
   return (energy);
 }
 
+/**
+ * Frees the fold compound of the transcribed prefix
+ */
+void
+FreeEnergyModel()
+{
+  vrna_fold_compound_free(prefix_compound);
+  prefix_compound = NULL;
+  ClearMemo();
+}
+
+
 /**
  * Calculates the energy of a nucleic acid using the Nussinov-Jacobson Model
  */
@@ -36,6 +36,8 @@ std::vector<int>
 EncodeSequence(std::string sequence);
 void
 InitializeViennaRNA(std::string sequence,int dangle,int transcribed);
+void
+FreeEnergyModel();
 float
 FullEnergyModel(std::string sequence, std::string structure);
 float
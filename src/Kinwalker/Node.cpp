@@ -900,10 +900,9 @@ void Node::BacktrackFront(std::pair<double,std::string> & ret,std::string node_s
 
 
 std::string Node::BacktrackNode(Node* n){
-  if(n->IsMfE()) {
-    Node::CalculateMfe();
-    return Node::mfe_structure;
-  }
+  //the mfe structure of the whole sequence is computed once at the start,
+  //and the fold arrays backtracked below are never overwritten
+  if(n->IsMfE()) return Node::mfe_structure;
   else {
     char *s = backtrack_fold_from_pair(const_cast<char*>(Node::sequence.c_str()),
                                        n->i, n->j);
@@ -1057,6 +1056,7 @@ void Node::CleanUpNode(void)
   delete [] pair_table;
   delete [] S;
   delete [] S1;
+  FreeEnergyModel();
 }
 
 
@@ -161,9 +161,11 @@ template<class R,class L,class AL>
 class AlignmentLinear : public Alignment<R,L,AL> {
 	private:
 		TAD_DP_TableLinear<R> *mtrx_;
+		bool ownMtrx_;
     const Algebra<R,L> *alg_;
     const RNA_Algebra<R,L> *rnaAlg_;
 
+		void initMtrx(TAD_DP_TableLinear<R> *table, R init);
     void compareCSFPair(CSFPair p, bool RNA, bool speedup);
 		void compareCSFPairTD(CSFPair p, bool speedup);
 
@@ -171,8 +173,10 @@ class AlignmentLinear : public Alignment<R,L,AL> {
 
 		void print(std::ostream &out) const { out << "linear ali's matrix" << std::endl << *mtrx_; };
 
-    AlignmentLinear(const Forest<L> *f1, const Forest<L> *f2,const Algebra<R,L> &alg, const bool topdown, const bool anchored, bool local, bool printBacktrace, bool speedup=SPEEDUP);
-    AlignmentLinear(const Forest<L> *f1, const Forest<L> *f2,const RNA_Algebra<R,L> &rnaAlg, const bool topdown, const bool anchored, bool local, bool printBacktrace, bool speedup=SPEEDUP);
+		// if table is given, it is used instead of allocating a new one, such that
+		// the memory can be re-used for a series of alignments
+    AlignmentLinear(const Forest<L> *f1, const Forest<L> *f2,const Algebra<R,L> &alg, const bool topdown, const bool anchored, bool local, bool printBacktrace, bool speedup=SPEEDUP, TAD_DP_TableLinear<R> *table=NULL);
+    AlignmentLinear(const Forest<L> *f1, const Forest<L> *f2,const RNA_Algebra<R,L> &rnaAlg, const bool topdown, const bool anchored, bool local, bool printBacktrace, bool speedup=SPEEDUP, TAD_DP_TableLinear<R> *table=NULL);
     void makeFirstCell();
     void makeFirstRow();
     void makeFirstCol();
@@ -204,7 +208,10 @@ class AlignmentLinear : public Alignment<R,L,AL> {
 		bool computed(const unsigned long i, const unsigned long j) const { return mtrx_->computed(i,j); }; 
 		void setComputed(const unsigned long i, const unsigned long j) { mtrx_->setComputed(i,j); }; 
 
-    virtual ~AlignmentLinear() {};
+    virtual ~AlignmentLinear() {
+			if (ownMtrx_)
+				delete mtrx_;
+		};
 
     // virtual, for replacepair
     virtual inline R computeReplacementScore(CSFPair p, std::string & backtrack_as) const {
@@ -474,10 +481,12 @@ template<class R,class L,class AL>
 class AlignmentAffine : public Alignment<R,L,AL> {
 	private:
 		TAD_DP_TableAffine<R> *mtrx_;
+		bool ownMtrx_;
     const AlgebraAffine<R,L> *alg_;
     const RNA_AlgebraAffine<R,L> *rnaAlg_;
 		int localOptimumTable_;
 
+		void initMtrx(TAD_DP_TableAffine<R> *table, R init);
     void compareCSFPair(CSFPair p, bool RNA, bool speedup);
 		void compareCSFPairTD(CSFPair p, bool speedup);
 
@@ -494,10 +503,11 @@ class AlignmentAffine : public Alignment<R,L,AL> {
 
 		void print(std::ostream &out) const { out << "affine ali's matrix" << std::endl << *mtrx_; };
 
+		// if table is given, it is used instead of allocating new tables
     AlignmentAffine(const Forest<L> *f1, const Forest<L> *f2,const AlgebraAffine<R,L> &alg, 
-				const bool topdown, const bool anchored, bool local, bool printBacktrace, bool speedup=SPEEDUP);
+				const bool topdown, const bool anchored, bool local, bool printBacktrace, bool speedup=SPEEDUP, TAD_DP_TableAffine<R> *table=NULL);
     AlignmentAffine(const Forest<L> *f1, const Forest<L> *f2,const RNA_AlgebraAffine<R,L> &rnaAlg, 
-				const bool topdown, const bool anchored, bool local, bool printBacktrace, bool speedup=SPEEDUP);
+				const bool topdown, const bool anchored, bool local, bool printBacktrace, bool speedup=SPEEDUP, TAD_DP_TableAffine<R> *table=NULL);
     void makeFirstCell();
     void makeFirstRow();
     void makeFirstCol();
@@ -530,7 +540,10 @@ class AlignmentAffine : public Alignment<R,L,AL> {
 
 		bool computed(const unsigned long i, const unsigned long j) const { return mtrx_->computed(i,j); }; 
 		void setComputed(const unsigned long i, const unsigned long j) { mtrx_->setComputed(i,j); }; 
-    virtual ~AlignmentAffine() {};
+    virtual ~AlignmentAffine() {
+			if (ownMtrx_)
+				delete mtrx_;
+		};
 };
 
 #endif
@@ -144,12 +144,12 @@ void Alignment<R, L, AL>::recursiveFill(CSFPair p, bool RNA, bool speedup) {
 
 
 template<class R,class L,class AL>
-AlignmentLinear<R,L,AL>::AlignmentLinear(const Forest<L> *f1, const Forest<L> *f2, const Algebra<R,L> &alg, const bool topdown, const bool anchored, const bool local, const bool printBacktrace, bool speedup)
+AlignmentLinear<R,L,AL>::AlignmentLinear(const Forest<L> *f1, const Forest<L> *f2, const Algebra<R,L> &alg, const bool topdown, const bool anchored, const bool local, const bool printBacktrace, bool speedup, TAD_DP_TableLinear<R> *table)
         : Alignment<R,L,AL>(f1,f2,topdown,anchored,printBacktrace) {
 
     // alloc space for the score matrix, backtrace structure,
     // and , if wanted, for the calculation-order-matrix
-		mtrx_ = new TAD_DP_TableLinear<R>(this->f1_->getNumCSFs(),this->f2_->getNumCSFs(),alg.worst_score());
+		initMtrx(table, alg.worst_score());
     // initialize variables
     alg_ = &alg;
     rnaAlg_ = NULL;
@@ -165,12 +165,12 @@ AlignmentLinear<R,L,AL>::AlignmentLinear(const Forest<L> *f1, const Forest<L> *f
 
 // constructor for RNA alignments
 template<class R,class L,class AL>
-AlignmentLinear<R,L,AL>::AlignmentLinear(const Forest<L> *f1, const Forest<L> *f2, const RNA_Algebra<R,L> &rnaAlg, const bool topdown, const bool anchored, const bool local, const bool printBacktrace, bool speedup)
+AlignmentLinear<R,L,AL>::AlignmentLinear(const Forest<L> *f1, const Forest<L> *f2, const RNA_Algebra<R,L> &rnaAlg, const bool topdown, const bool anchored, const bool local, const bool printBacktrace, bool speedup, TAD_DP_TableLinear<R> *table)
         : Alignment<R,L,AL>(f1,f2,topdown,anchored,printBacktrace) {
 
     // alloc space for the score matrix, backtrace structure and,
     // if wanted, for the calculation-order-matrix
-		mtrx_ = new TAD_DP_TableLinear<R>(this->f1_->getNumCSFs(),this->f2_->getNumCSFs(),rnaAlg.worst_score());
+		initMtrx(table, rnaAlg.worst_score());
     // initialize variables
     rnaAlg_ = &rnaAlg;
     alg_ = (const Algebra<R,L>*)&rnaAlg;
@@ -185,6 +185,16 @@ AlignmentLinear<R,L,AL>::AlignmentLinear(const Forest<L> *f1, const Forest<L> *f
 
 // Private functions
 
+template<class R, class L, class AL>
+void AlignmentLinear<R, L, AL>::initMtrx(TAD_DP_TableLinear<R> *table, R init) {
+    ownMtrx_ = (table == NULL);
+    if (ownMtrx_) {
+        mtrx_ = new TAD_DP_TableLinear<R>(this->f1_->getNumCSFs(),this->f2_->getNumCSFs(),init);
+    } else {
+        table->resize(this->f1_->getNumCSFs(),this->f2_->getNumCSFs(),init);
+        mtrx_ = table;
+    }
+}
 
 template<class R, class L, class AL>
 void AlignmentLinear<R, L, AL>::makeFirstCell() {
@@ -308,10 +318,12 @@ void AlignmentLinear<R, L, AL>::compareCSFPairTD(CSFPair p, bool speedup) {
     }
     else {
         unsigned long h = p.k;               // h is the node where the suffix of the split begins
+        const R *dwnRow = mtrx_->row(this->f1_->down(p.i));
+        const R *ovrRow = mtrx_->row(this->f1_->over(p.i,p.j));
         for (unsigned int r=0; r<=p.l; r++) { // for all splits of f2_
             h_score = alg_->del(this->f1_->label(p.i),
-                                getMtrxVal(this->f1_->down(p.i),this->f2_->indexpos(p.k,r)),
-                                getMtrxVal(this->f1_->over(p.i,p.j),this->f2_->indexpos(h,p.l-r)));
+                                TAD_DP_TableLinear<R>::rowVal(dwnRow,this->f2_->indexpos(p.k,r)),
+                                TAD_DP_TableLinear<R>::rowVal(ovrRow,this->f2_->indexpos(h,p.l-r)));
             score = alg_->choice(score,h_score);
             h = this->f2_->rb(h);
         }
@@ -374,10 +386,12 @@ void AlignmentLinear<R, L, AL>::compareCSFPair(CSFPair p, bool RNA, bool speedup
     } 
 		else {
         unsigned long h = p.k;               // h is the node where the suffix of the split begins
+        const R *dwnRow = mtrx_->row(this->f1_->down(p.i));
+        const R *ovrRow = mtrx_->row(this->f1_->over(p.i,p.j));
         for (unsigned int r=0; r<=p.l; r++) { // for all splits of f2_
             h_score = alg_->del(this->f1_->label(p.i),
-                                getMtrxVal(this->f1_->down(p.i),this->f2_->indexpos(p.k,r)),
-                                getMtrxVal(this->f1_->over(p.i,p.j),this->f2_->indexpos(h,p.l-r)));
+                                TAD_DP_TableLinear<R>::rowVal(dwnRow,this->f2_->indexpos(p.k,r)),
+                                TAD_DP_TableLinear<R>::rowVal(ovrRow,this->f2_->indexpos(h,p.l-r)));
             score = alg_->choice(score,h_score);
             h = this->f2_->rb(h);
         }
@@ -906,12 +920,12 @@ found:
 
 template<class R, class L, class AL>
 AlignmentAffine<R,L,AL>::AlignmentAffine(const Forest<L> *f1, const Forest<L> *f2, const AlgebraAffine<R,L> &alg, 
-		const bool topdown, const bool anchored, const bool local, const bool printBacktrace, bool speedup)
+		const bool topdown, const bool anchored, const bool local, const bool printBacktrace, bool speedup, TAD_DP_TableAffine<R> *table)
         : Alignment<R,L,AL>(f1, f2, topdown, anchored, printBacktrace) {
 
     // alloc space for the score matrix, backtrace structure,
     // and , if wanted, for the calculation-order-matrix
-		mtrx_ = new TAD_DP_TableAffine<R>(this->f1_->getNumCSFs(),this->f2_->getNumCSFs(),alg.worst_score());
+		initMtrx(table, alg.worst_score());
     // initialize variables
     alg_ = &alg;
     rnaAlg_ = NULL;
@@ -928,12 +942,12 @@ AlignmentAffine<R,L,AL>::AlignmentAffine(const Forest<L> *f1, const Forest<L> *f
 // constructor for RNA alignments
 template<class R,class L,class AL>
 AlignmentAffine<R,L,AL>::AlignmentAffine(const Forest<L> *f1, const Forest<L> *f2, const RNA_AlgebraAffine<R,L> &rnaAlg, 
-		const bool topdown, const bool anchored, const bool local, const bool printBacktrace, bool speedup)
+		const bool topdown, const bool anchored, const bool local, const bool printBacktrace, bool speedup, TAD_DP_TableAffine<R> *table)
         : Alignment<R,L,AL>(f1, f2, topdown, anchored, printBacktrace) {
 
     // alloc space for the score matrix, backtrace structure and,
     // if wanted, for the calculation-order-matrix
-		mtrx_ = new TAD_DP_TableAffine<R>(this->f1_->getNumCSFs(),this->f2_->getNumCSFs(),rnaAlg.worst_score());
+		initMtrx(table, rnaAlg.worst_score());
     // initialize variables
     rnaAlg_ = &rnaAlg;
     alg_ = (const AlgebraAffine<R,L>*)&rnaAlg;
@@ -946,6 +960,17 @@ AlignmentAffine<R,L,AL>::AlignmentAffine(const Forest<L> *f1, const Forest<L> *f
 			this->fillMatricesBottomUp(local, RNA, speedup);
 }
 
+template<class R, class L, class AL>
+void AlignmentAffine<R, L, AL>::initMtrx(TAD_DP_TableAffine<R> *table, R init) {
+    ownMtrx_ = (table == NULL);
+    if (ownMtrx_) {
+        mtrx_ = new TAD_DP_TableAffine<R>(this->f1_->getNumCSFs(),this->f2_->getNumCSFs(),init);
+    } else {
+        table->resize(this->f1_->getNumCSFs(),this->f2_->getNumCSFs(),init);
+        mtrx_ = table;
+    }
+}
+
 template<class R, class L, class AL>
 void AlignmentAffine<R, L, AL>::makeFirstCell() {
   // the easiest case ..
@@ -1410,10 +1435,12 @@ void AlignmentAffine<R, L, AL>::compareCSFPair(CSFPair p, bool RNA, bool speedup
     } 
 		else {
 			unsigned int h = p.k;
+			const R *dwnRow = mtrx_->row(this->f1_->down(p.i));
+			const R *ovrRow = mtrx_->row(this->f1_->over(p.i, p.j));
 			// for all splits of f2
 	  	for (unsigned int r = 0; r <= p.l; r++) {
-					R dwn = getMtrxVal(t_c, this->f1_->down(p.i), this->f2_->indexpos(p.k, r));
-					R ovr = getMtrxVal(t_rb, this->f1_->over(p.i, p.j), this->f2_->indexpos(h, p.l - r));
+					R dwn = TAD_DP_TableAffine<R>::rowVal(t_c, dwnRow, this->f2_->indexpos(p.k, r));
+					R ovr = TAD_DP_TableAffine<R>::rowVal(t_rb, ovrRow, this->f2_->indexpos(h, p.l - r));
 			    if (open) 
 			        h_score = alg_->delO(lbl, dwn, ovr);
 			    else 
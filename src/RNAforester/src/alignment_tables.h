@@ -7,104 +7,159 @@
 #include <fstream>
 #include <cstdlib>
 #include <climits>
+#include <cstddef>
+#include <algorithm>
 
-// superclass of tables, has the row start info
+// Layout of the tables: the T values of cell (i,j) are stored next to each
+// other, and the cells are stored row by row in a single array that starts
+// at a cache line boundary. The number of slots per cell is rounded up to a
+// power of two, so a cell never spans two cache lines if sizeof(R) is a power
+// of two. The computed flags of the top down recursion are kept in a bitmap.
 
-template<class R> 
+#define TAD_DP_CACHE_LINE 64
+
+template<unsigned int T>
+struct TAD_DP_Stride {
+	enum { value = (T <= 1) ? 1 : ((T <= 2) ? 2 : ((T <= 4) ? 4 : 8)) };
+};
+
+// superclass of tables, T is the number of values per cell
+
+template<class R, unsigned int T>
 class TAD_DP_Table {
-	public: 
-		friend std::ostream& operator<<(std::ostream &out, const TAD_DP_Table<R> &table) {
+	public:
+		friend std::ostream& operator<<(std::ostream &out, const TAD_DP_Table<R,T> &table) {
 			table.print(out);
 			return out;
 		}
 
-		TAD_DP_Table(unsigned long rows, unsigned long cols, R init) 
-			: rows_(rows),
-			cols_(cols),
-			mtrxSize_(rows*cols) {
-	    rowStart_ = new unsigned long[rows];
-	    rowStart_[0] = 0;
-	    for (unsigned long h = 1; h < rows; h++) {
-	        rowStart_[h] = rowStart_[h - 1] + cols;
-	    }
-			//TODO if (topdown)
-			computed_ = new bool[mtrxSize_];
+		TAD_DP_Table(unsigned long rows, unsigned long cols)
+			: rows_(0),
+			cols_(0),
+			mtrxSize_(0),
+			mtrxCapacity_(0),
+			mem_(NULL),
+			mtrx_(NULL),
+			computed_(NULL) {
+			reshape(rows,cols);
 		}
 
-		~TAD_DP_Table(){
-			delete[] rowStart_;
+		virtual ~TAD_DP_Table(){
+			delete[] mem_;
+			delete[] computed_;
 		}
 
-		virtual void checkSpaceConsumption() = 0;
     virtual void print(std::ostream &s) const = 0;
 
 		// TODO if nicht topdown dann was?
 	  inline bool computed(const unsigned long i, const unsigned long j) const {
-        assert(this->rowStart_[i] + j < this->mtrxSize_);
-        return computed_[this->rowStart_[i] + j];
+        unsigned long k = i*cols_ + j;
+        assert(k < this->mtrxSize_);
+        return (computed_[k / BITS] >> (k % BITS)) & 1UL;
     };
 
     inline void setComputed(const unsigned long i, const unsigned long j) {
-      assert(this->rowStart_[i] + j < this->mtrxSize_);
-      computed_[this->rowStart_[i] + j] = true;
+      unsigned long k = i*cols_ + j;
+      assert(k < this->mtrxSize_);
+      computed_[k / BITS] |= 1UL << (k % BITS);
     };
 
+		// first cell of row i, for loops that walk along a single row
+		inline const R *row(const unsigned long i) const {
+			assert(i < this->rows_);
+			return mtrx_ + i*cols_*STRIDE;
+		}
+
 
 	protected:
+		enum { STRIDE = TAD_DP_Stride<T>::value, BITS = sizeof(unsigned long)*CHAR_BIT };
+
 		unsigned long rows_;
 		unsigned long cols_;
     unsigned long mtrxSize_;
-    unsigned long *rowStart_;
-		bool *computed_;
-
-};
+    unsigned long mtrxCapacity_;
+		char *mem_;
+    R *mtrx_;
+		unsigned long *computed_;
 
+		// first value of cell (i,j)
+		inline R *cell(const unsigned long i, const unsigned long j) const {
+			assert(i*cols_ + j < this->mtrxSize_);
+			return mtrx_ + (i*cols_ + j)*STRIDE;
+		}
 
-// table for linear alignment
+		void checkSpaceConsumption() {
+	    // check for an overflow
+	    if (this->rows_ > ULONG_MAX / this->cols_) {
+	        std::cerr << "Error: Overflow in calculation matrix multiplication. Calculation terminated." << std::endl;
+	        exit(EXIT_FAILURE);
+	    }
+	    // maximum array size is 2GB
+	    if (T*this->mtrxSize_ > 2000000000 || T*this->rows_ > 2000000000) {
+	        std::cerr << "Error: Maximum size of 2GB for the calculation tables exceeded due to large input data. Calculation terminated." << std::endl;
+	        exit(EXIT_FAILURE);
+	    }
+		}
 
-template<class R> 
-class TAD_DP_TableLinear : public TAD_DP_Table<R> {
-	private:
-    R *mtrx_;
+		// re-use the table for rows x cols cells, memory is only allocated
+		// if the table has to grow, returns true in that case
+		bool reshape(unsigned long rows, unsigned long cols) {
+			bool grown = false;
 
-	public:
-		TAD_DP_TableLinear(unsigned long rows, unsigned long cols, R init) 
-			: TAD_DP_Table<R>(rows,cols,init) {
+			rows_ = rows;
+			cols_ = cols;
+			mtrxSize_ = rows*cols;
 			checkSpaceConsumption();
-			mtrx_ = new R[this->mtrxSize_];
+			if (mtrxSize_ > mtrxCapacity_) {
+				delete[] mem_;
+				delete[] computed_;
+				mem_ = new char[mtrxSize_*STRIDE*sizeof(R) + TAD_DP_CACHE_LINE];
+				mtrx_ = (R *)(mem_ + (TAD_DP_CACHE_LINE - reinterpret_cast<size_t>(mem_) % TAD_DP_CACHE_LINE) % TAD_DP_CACHE_LINE);
+				computed_ = new unsigned long[mtrxSize_ / BITS + 1];
+				mtrxCapacity_ = mtrxSize_;
+				grown = true;
+			}
+			std::fill(computed_, computed_ + mtrxSize_ / BITS + 1, 0UL);
+			return grown;
 		}
 
-		~TAD_DP_TableLinear() {
-			delete[] mtrx_;
+	private:
+		TAD_DP_Table(const TAD_DP_Table &);
+		TAD_DP_Table &operator=(const TAD_DP_Table &);
+};
+
+
+// table for linear alignment
+
+template<class R>
+class TAD_DP_TableLinear : public TAD_DP_Table<R,1> {
+	public:
+		TAD_DP_TableLinear(unsigned long rows, unsigned long cols, R init)
+			: TAD_DP_Table<R,1>(rows,cols) {
 		}
 
-		void checkSpaceConsumption() {
-		    // check for an overflow
-		    if (this->rows_ > ULONG_MAX / this->cols_) {
-		        std::cerr << "Error: Overflow in calculation matrix multiplication. Calculation terminated." << std::endl;
-		        exit(EXIT_FAILURE);
-		    }
-		    // maximum array size is 2GB
-		    if (this->mtrxSize_ > 2000000000 || this->rows_ > 2000000000) {
-		        std::cerr << "Error: Maximum array size of 2GB exceeded due to large input data. Calculation terminated." << std::endl;
-		        exit(EXIT_FAILURE);
-		    }
+		// prepare the table for another alignment of rows x cols CSFs
+		void resize(unsigned long rows, unsigned long cols, R init) {
+			this->reshape(rows,cols);
 		}
 
     inline R getMtrxVal(const unsigned long i, const unsigned long j) const {
-        assert(this->rowStart_[i] + j < this->mtrxSize_);
-        return mtrx_[this->rowStart_[i] + j];
+        return *this->cell(i,j);
 		}
 
 		inline void setMtrxVal(const unsigned long i, const unsigned long j, R& val) {
-      assert(this->rowStart_[i] + j < this->mtrxSize_);
-      mtrx_[this->rowStart_[i] + j] = val;
+      *this->cell(i,j) = val;
+		}
+
+		// value of column j in a row returned by row()
+		static inline R rowVal(const R *row, const unsigned long j) {
+			return row[j];
 		}
 
     void print(std::ostream &s) const {
 			for (unsigned int i = 0; i < this->rows_; i++) {
 				for (unsigned int j = 0; j < this->cols_; j++) {
-					 s << mtrx_[this->rowStart_[i] + j] << " ";
+					 s << getMtrxVal(i,j) << " ";
 				}
 				s << std::endl;
 			}
@@ -113,98 +168,56 @@ class TAD_DP_TableLinear : public TAD_DP_Table<R> {
 };
 
 
-// tables for affine alignment
+// tables for affine alignment, the seven values of a cell are kept together
 
 const int S = 0, V = 1, H = 2, V_ = 3, H_ = 4, V_H = 5, VH_ = 6;
 const std::string table_name[] =  {"S","V","H","V'","H'","V'H","VH'"};
 
-template<class R> 
-class TAD_DP_TableAffine : public TAD_DP_Table<R> {
+template<class R>
+class TAD_DP_TableAffine : public TAD_DP_Table<R,7> {
 	private:
-    R *mtrxS_;
-    R *mtrxV_;
-    R *mtrxH_;
-    R *mtrxV__;
-    R *mtrxH__;
-    R *mtrxV_H_;
-    R *mtrxVH__;
 		int localOptimumTable_;
 
-    inline R* getMtrx(int table) const {
-        switch (table) {
-          case S:
-            return mtrxS_;
-          case V:
-            return mtrxV_;
-          case H:
-            return mtrxH_;
-          case V_:
-            return mtrxV__;
-          case H_:
-            return mtrxH__;
-          case V_H:
-            return mtrxV_H_;
-          case VH_:
-            return mtrxVH__;
-        }
-				return 0;
-    }
+		// the unused slot of each cell is filled as well, which is cheaper than
+		// skipping it
+		void fill(R init) {
+			std::fill(this->mtrx_, this->mtrx_ + this->mtrxSize_*this->STRIDE, init);
+		}
 
 	public:
     TAD_DP_TableAffine(unsigned long rows, unsigned long cols, R init)
-      : TAD_DP_Table<R>(rows,cols,init) {
-      checkSpaceConsumption();
-      mtrxS_ = new R[this->mtrxSize_];
-      mtrxV_ = new R[this->mtrxSize_];
-      mtrxH_ = new R[this->mtrxSize_];
-      mtrxV__ = new R[this->mtrxSize_];
-      mtrxH__ = new R[this->mtrxSize_];
-      mtrxV_H_ = new R[this->mtrxSize_];
-      mtrxVH__ = new R[this->mtrxSize_];
-			// TODO quicker way to init array?
-			//std::cout << "filling with " << init << std::endl;
-			std::fill( mtrxS_, mtrxS_ + this->mtrxSize_, init );
-			std::fill( mtrxV_, mtrxV_ + this->mtrxSize_, init );
-			std::fill( mtrxH_, mtrxH_ + this->mtrxSize_, init );
-			std::fill( mtrxV__, mtrxV__ + this->mtrxSize_, init );
-			std::fill( mtrxH__, mtrxH__ + this->mtrxSize_, init );
-			std::fill( mtrxV_H_, mtrxV_H_ + this->mtrxSize_, init );
-			std::fill( mtrxVH__, mtrxVH__ + this->mtrxSize_, init );
+      : TAD_DP_Table<R,7>(rows,cols) {
+			fill(init);
     }
 
-		void checkSpaceConsumption() {
-			// check for an overflow
-			if (this->rows_ > ULONG_MAX / this->cols_) {
-				std::cerr << "Error: Overflow in calculation matrix multiplication. Calculation terminated." << std::endl;
-				exit(EXIT_FAILURE);
-			}
-			// maximum array size for 7 arrays is 2GB
-			if ((7*this->mtrxSize_) > 2000000000 || (7*this->rows_) > 2000000000) {
-        std::cerr << "Error: Maximum size of 2GB for the calculation tables exceeded due to large input data. Calculation terminated." << std::endl;
-        exit(EXIT_FAILURE);
-			}
+		// prepare the tables for another alignment of rows x cols CSFs
+		void resize(unsigned long rows, unsigned long cols, R init) {
+			this->reshape(rows,cols);
+			fill(init);
 		}
 
 		inline R getMtrxVal(int table, const unsigned long i, const unsigned long j) const {
-        assert(this->rowStart_[i] + j < this->mtrxSize_);
-				R *mtrx = getMtrx(table);
-				return mtrx[this->rowStart_[i] + j];
+				assert(table >= S && table <= VH_);
+				return this->cell(i,j)[table];
     }
 
 		// TODO alg noch nicht am start
     inline void setMtrxVal(int table, const unsigned long i, const unsigned long j, const R val) {
-      	assert(this->rowStart_[i] + j < this->mtrxSize_);
-				R *mtrx = getMtrx(table);
-				mtrx[this->rowStart_[i] + j] = val;
+				assert(table >= S && table <= VH_);
+				this->cell(i,j)[table] = val;
     }
 
+		// value of table at column j in a row returned by row()
+		static inline R rowVal(int table, const R *row, const unsigned long j) {
+				return row[j*TAD_DP_Table<R,7>::STRIDE + table];
+		}
+
     void print(std::ostream &s) const {
 			for (int table = S; table <= VH_; table++) {
 				s << table_name[table] << std::endl;
-				R *mtrx = getMtrx(table);
 				for (unsigned int i = 0; i < this->rows_; i++) {
 					for (unsigned int j = 0; j < this->cols_; j++) {
-						 s << mtrx[this->rowStart_[i] + j] << " ";
+						 s << getMtrxVal(table,i,j) << " ";
 					}
 					s << std::endl;
 				}
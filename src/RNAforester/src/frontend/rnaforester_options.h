@@ -52,6 +52,7 @@ public:
         ConsensusMinPairProb,
         ClusterThreshold,
         ClusterJoinCutoff,
+        NumThreads,
 #ifdef HAVE_LIBRNA
         PredictProfile,
         PredictMinPairProb,
@@ -1,5 +1,8 @@
 #include <algorithm>
 #include <fstream>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "alignment.h"
 #include "progressive_align.h"
 #include "alignment.t.cpp"
@@ -13,11 +16,120 @@ bool operator < (std::pair<double,RNAProfileAlignment*> &l, std::pair<double,RNA
         return true;
 }
 
+// Computes alignment scores of pairs of profiles. The dynamic programming
+// tables are kept and re-used for all alignments, use one instance per thread.
+class ProfileAligner {
+private:
+    const Algebra<double,RNA_Alphabet_Profile> *alg_;
+    const AlgebraAffine<double,RNA_Alphabet_Profile> *alg_affine_;
+    const bool topdown_;
+    const bool anchored_;
+    const bool local_;
+    TAD_DP_TableLinear<double> *table_;
+    TAD_DP_TableAffine<double> *table_affine_;
+
+    ProfileAligner(const ProfileAligner &);
+    ProfileAligner &operator=(const ProfileAligner &);
+
+public:
+    ProfileAligner(const Algebra<double,RNA_Alphabet_Profile> *alg, const AlgebraAffine<double,RNA_Alphabet_Profile> *alg_affine, bool topdown, bool anchored, bool local)
+        : alg_(alg), alg_affine_(alg_affine), topdown_(topdown), anchored_(anchored), local_(local), table_(NULL), table_affine_(NULL) {
+        if (alg_affine_)
+            table_affine_ = new TAD_DP_TableAffine<double>(1,1,alg_affine_->worst_score());
+        else
+            table_ = new TAD_DP_TableLinear<double>(1,1,alg_->worst_score());
+    }
+
+    ~ProfileAligner() {
+        delete table_;
+        delete table_affine_;
+    }
+
+    double score(const RNAProfileAlignment *f1, const RNAProfileAlignment *f2) {
+        Alignment<double,RNA_Alphabet_Profile,RNA_Alphabet_Profile> * ali = NULL;
+        double s;
+
+        if (alg_affine_)
+            ali = new AlignmentAffine<double,RNA_Alphabet_Profile,RNA_Alphabet_Profile>(f1,f2,*alg_affine_,topdown_,anchored_,local_,false,SPEEDUP,table_affine_);
+        else
+            ali = new AlignmentLinear<double,RNA_Alphabet_Profile,RNA_Alphabet_Profile>(f1,f2,*alg_,topdown_,anchored_,local_,false,SPEEDUP,table_);
+        if (local_)
+            s = ali->getLocalOptimum();
+        else
+            s = ali->getGlobalOptimumRelative();
+        delete ali;
+        return s;
+    }
+};
+
+// the score of the profiles with keys x and y is stored in the lower triangle of the matrix
+static inline double getScore(const Matrix<double> *score_mtrx, long x, long y) {
+    return (x > y) ? score_mtrx->getAt(x-1,y-1) : score_mtrx->getAt(y-1,x-1);
+}
+
+static inline void setScore(Matrix<double> *score_mtrx, long x, long y, double val) {
+    if (x > y)
+        score_mtrx->setAt(x-1,y-1,val);
+    else
+        score_mtrx->setAt(y-1,x-1,val);
+}
+
+// returns the first key y<x with the best score in row x (0 if there is no score better than the worst score)
+static long bestInRow(const RNAProfileAliMapType &inputMapProfile, const Matrix<double> *score_mtrx, const Algebra<double,RNA_Alphabet_Profile> *alg, long x) {
+    RNAProfileAliMapType::const_iterator it;
+    double bestScore = alg->worst_score();
+    long best = 0;
+
+    for (it=inputMapProfile.begin(); it!=inputMapProfile.end() && it->first < x; it++) {
+        double old_bestScore = bestScore;
+
+        bestScore = alg->choice(bestScore,getScore(score_mtrx,x,it->first));
+        if (bestScore != old_bestScore)
+            best = it->first;
+    }
+    return best;
+}
+
+// removes profile x from the map, the rows that had their best score with x are searched again
+static RNAProfileAlignment *takeProfile(RNAProfileAliMapType &inputMapProfile, std::vector<long> &rowBest, long x) {
+    RNAProfileAliMapType::iterator it;
+    RNAProfileAlignment *f = inputMapProfile[x];
+
+    inputMapProfile.erase(x);
+    for (it=inputMapProfile.upper_bound(x); it!=inputMapProfile.end(); it++) {
+        if (rowBest[it->first] == x)
+            rowBest[it->first] = -1;
+    }
+    return f;
+}
+
+// adds profile x whose scores are already in the matrix and updates the best scores of the rows y>x
+static void putProfile(RNAProfileAliMapType &inputMapProfile, std::vector<long> &rowBest, const Matrix<double> *score_mtrx, const Algebra<double,RNA_Alphabet_Profile> *alg, long x, RNAProfileAlignment *f) {
+    RNAProfileAliMapType::iterator it;
+
+    for (it=inputMapProfile.upper_bound(x); it!=inputMapProfile.end(); it++) {
+        long y = it->first, b = rowBest[y];
+        double s = getScore(score_mtrx,y,x);
+        double bestScore;
+
+        if (b < 0)
+            continue;
+
+        bestScore = (b == 0) ? alg->worst_score() : getScore(score_mtrx,y,b);
+        // ties are resolved in favour of the smaller key
+        if (alg->choice(bestScore,s) != bestScore || (b > 0 && s == bestScore && x < b))
+            rowBest[y] = x;
+    }
+    rowBest[x] = -1;
+    inputMapProfile.insert(std::make_pair(x,f));
+}
+
 void progressiveAlign(std::vector<RNAProfileAlignment*> &inputList, 
 											std::vector<std::pair<double,RNAProfileAlignment*> > &resultList, const Score& score, const Options &options, bool anchored) {
 
 		Algebra<double,RNA_Alphabet_Profile> *alg = NULL;
 		AlgebraAffine<double,RNA_Alphabet_Profile> *alg_affine = NULL;
+		const Algebra<double,RNA_Alphabet_Profile> *alg_choice = NULL;
 
     if (options.has(Options::Affine)) {
 			if (options.has(Options::CalculateDistance)) {
@@ -34,6 +146,18 @@ void progressiveAlign(std::vector<RNAProfileAlignment*> &inputList,
 			else
         alg = new DoubleSimiProfileAlgebra(score);
 		}
+		// the choice function is the same for both
+		if (options.has(Options::Affine))
+			alg_choice = alg_affine;
+		else
+			alg_choice = alg;
+
+		int numThreads = 1;
+		options.get(Options::NumThreads, numThreads, 1);
+#ifdef _OPENMP
+		if (numThreads <= 0)
+			numThreads = omp_get_num_procs();
+#endif
 
     std::cout << "*** Calculation ***" << std::endl << std::endl;
 
@@ -45,15 +169,12 @@ void progressiveAlign(std::vector<RNAProfileAlignment*> &inputList,
         inputMapProfile[i]=*inpIt;
         i++;
     }
-    inputList.clear();
 
     // create matrix for all against all comparison
-		double bestScore;
-		if (options.has(Options::Affine))
-			bestScore = alg_affine->worst_score();
-		else
-			bestScore = alg->worst_score();
+		double bestScore = alg_choice->worst_score();
     Matrix<double> *score_mtrx = new Matrix<double>(inputMapProfile.size(),inputMapProfile.size());
+    // key of the best partner y<x for each row x of the matrix, -1 if it has to be searched
+    std::vector<long> rowBest(inputMapProfile.size()+1,-1);
 
     // set threshold for the clustering algorithm
     double threshold = 0; 
@@ -92,40 +213,34 @@ void progressiveAlign(std::vector<RNAProfileAlignment*> &inputList,
     }
 
 		// compute all pairwise alignment scores
-    // !! NOTE !! iterating through the map is ordered by key number
-    // as i only calculate a triangle matrix this is a prerequisite
+    // the rows of the triangle matrix are distributed over the threads, longest rows first
 		long x = 0, y = 0;
 		RNAProfileAlignment *f1 = NULL, *f2 = NULL;
     std::cout << "Computing all pairwise similarities" << std::endl;
 
+#ifdef _OPENMP
+#pragma omp parallel num_threads(numThreads)
+#endif
+    {
+        ProfileAligner aligner(alg,alg_affine,topdown,anchored,local);
+        long r, c;
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic,1)
+#endif
+        for (r=(long)inputList.size(); r>1; r--) {
+            for (c=1; c<r; c++)
+                setScore(score_mtrx,r,c,aligner.score(inputList[r-1],inputList[c-1]));
+        }
+    }
+    inputList.clear();
+
     RNAProfileAliMapType::iterator it2;
     for (it=inputMapProfile.begin(); it!=inputMapProfile.end(); it++) {
         x = it->first;
-        f1 = it->second;
         for (it2=inputMapProfile.begin(); it2->first<it->first; it2++) {
             y = it2->first;
-            f2 = it2->second;
-
-						if (options.has(Options::Affine)) {
-							AlignmentAffine<double,RNA_Alphabet_Profile,RNA_Alphabet_Profile> * ali = new AlignmentAffine<double,RNA_Alphabet_Profile,RNA_Alphabet_Profile>(f1,f2,*alg_affine,topdown,anchored,local,printBT);
-	            if (local)
-		              score_mtrx->setAt(x-1,y-1,ali->getLocalOptimum());
-			        else
-				          score_mtrx->setAt(x-1,y-1,ali->getGlobalOptimumRelative());
-
-					    std::cout << x << "," << y << ": " << score_mtrx->getAt(x-1,y-1) << std::endl;
-							delete ali;
-						}
-						else {
-							AlignmentLinear<double,RNA_Alphabet_Profile,RNA_Alphabet_Profile> * ali = new AlignmentLinear<double,RNA_Alphabet_Profile,RNA_Alphabet_Profile>(f1,f2,*alg,topdown,anchored,local,printBT);
-							if (local)
-								  score_mtrx->setAt(x-1,y-1,ali->getLocalOptimum());
-							else
-								  score_mtrx->setAt(x-1,y-1,ali->getGlobalOptimumRelative());
-
-							std::cout << x << "," << y << ": " << score_mtrx->getAt(x-1,y-1) << std::endl;
-							delete ali;
-						}
+            std::cout << x << "," << y << ": " << getScore(score_mtrx,x,y) << std::endl;
         }
     }
     std::cout << std::endl;
@@ -137,28 +252,22 @@ void progressiveAlign(std::vector<RNAProfileAlignment*> &inputList,
 
 
     while (inputMapProfile.size()>1) {
-        // find the best score of all pairwise alignments
-				if (options.has(Options::Affine))
-					bestScore = alg_affine->worst_score();
-				else
-					bestScore = alg->worst_score();
+        // find the best score of all pairwise alignments, only the rows
+        // that are affected by the last joins are searched again
+				bestScore = alg_choice->worst_score();
         for (it=inputMapProfile.begin(); it!=inputMapProfile.end(); it++) {
-            x = it->first;
-            for (it2=inputMapProfile.begin(); it2->first < it->first; it2++) {
-                double old_bestScore = bestScore;
-
-                y = it2->first;
-
-								if (options.has(Options::Affine))
-									bestScore = alg_affine->choice(bestScore,score_mtrx->getAt(x-1,y-1));
-								else
-									bestScore = alg->choice(bestScore,score_mtrx->getAt(x-1,y-1));
+            double old_bestScore = bestScore;
 
-                if (bestScore != old_bestScore) {
-                    bestx = it->first;
-                    besty = it2->first;
-                    old_bestScore = bestScore;
-                }
+            x = it->first;
+            if (rowBest[x] < 0)
+                rowBest[x] = bestInRow(inputMapProfile,score_mtrx,alg_choice,x);
+            if (rowBest[x] == 0)
+                continue;
+
+            bestScore = alg_choice->choice(bestScore,getScore(score_mtrx,x,rowBest[x]));
+            if (bestScore != old_bestScore) {
+                bestx = x;
+                besty = rowBest[x];
             }
         }
 
@@ -190,11 +299,9 @@ void progressiveAlign(std::vector<RNAProfileAlignment*> &inputList,
             for (x=1; x<=score_mtrx->xDim(); x++) { // !! begins at 1 !!
                 if (x<mate[x]) {
                     // if it is a best pair put it in the align vector
-                    f1 = inputMapProfile[x];
-                    inputMapProfile.erase(x);
+                    f1 = takeProfile(inputMapProfile,rowBest,x);
                     inputListMult.push_back(std::make_pair(x,f1));
-                    f2 = inputMapProfile[mate[x]];
-                    inputMapProfile.erase(mate[x]);
+                    f2 = takeProfile(inputMapProfile,rowBest,mate[x]);
                     inputListMult.push_back(std::make_pair(mate[x],f2));
                 }
             }
@@ -203,10 +310,8 @@ void progressiveAlign(std::vector<RNAProfileAlignment*> &inputList,
         } else {
             // if there us no pair below the threshold
             // combine those two profile forests, that produced the best score
-            f1 = inputMapProfile[bestx];
-            f2 = inputMapProfile[besty];
-            inputMapProfile.erase(bestx);
-            inputMapProfile.erase(besty);
+            f1 = takeProfile(inputMapProfile,rowBest,bestx);
+            f2 = takeProfile(inputMapProfile,rowBest,besty);
             inputListMult.push_back(std::make_pair(bestx,f1));
             inputListMult.push_back(std::make_pair(besty,f2));
         }
@@ -295,32 +400,32 @@ void progressiveAlign(std::vector<RNAProfileAlignment*> &inputList,
 
                 // calculate distance to all forests in the vector
                 std::cout << "Calculate similarities to other clusters" << std::endl;
-                f1 = f;
                 // x remains x !!
 								x = joinedClusterNumber;
+
+                std::vector<RNAProfileAliKeyPairType> others(inputMapProfile.begin(),inputMapProfile.end());
+#ifdef _OPENMP
+#pragma omp parallel num_threads(numThreads)
+#endif
+                {
+                    ProfileAligner aligner(alg,alg_affine,topdown,anchored,local);
+                    long c;
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic,1)
+#endif
+                    for (c=0; c<(long)others.size(); c++)
+                        setScore(score_mtrx,x,others[c].first,aligner.score(f,others[c].second));
+                }
+
                 for (it=inputMapProfile.begin(); it!=inputMapProfile.end(); it++) {
                     y = it->first;
-                    f2 = it->second;
-
-										Alignment<double,RNA_Alphabet_Profile,RNA_Alphabet_Profile> * ali = NULL;
-										if (options.has(Options::Affine))
-											ali = new AlignmentAffine<double,RNA_Alphabet_Profile,RNA_Alphabet_Profile>(f1,f2,*alg_affine,topdown,anchored,local,printBT);
-										else
-											ali = new AlignmentLinear<double,RNA_Alphabet_Profile,RNA_Alphabet_Profile>(f1,f2,*alg,topdown,anchored,local,printBT);
-                    if (local) {
-                        score_mtrx->setAt(std::min(x-1,y-1),std::max(x-1,y-1),ali->getLocalOptimum());  // min - max = fill the upper triangle
-                        std::cout << std::min(x,y) << "," << std::max(x,y) << ": " << ali->getLocalOptimum() <<  std::endl;
-                    } 
-										else {
-                        score_mtrx->setAt(std::min(x-1,y-1),std::max(x-1,y-1),ali->getGlobalOptimumRelative());  // min - max = fill the upper triangle
-                        std::cout << std::min(x,y) << "," << std::max(x,y) << ": " << ali->getGlobalOptimumRelative() <<  std::endl;
-                    }
-										delete ali;
+                    std::cout << std::min(x,y) << "," << std::max(x,y) << ": " << getScore(score_mtrx,x,y) <<  std::endl;
                 }
                 std::cout << std::endl;
 
                 // ... and append it to the vector
-                inputMapProfile.insert(std::make_pair(x,f));
+                putProfile(inputMapProfile,rowBest,score_mtrx,alg_choice,x,f);
             }
 						delete bestali;
         }
@@ -129,7 +129,6 @@ int move_set(struct_en &input, SeqInfo &sqi)
   } else {
     if (Opt.neighs) {
       Neighborhood neigh(sqi.seq, sqi.s0, sqi.s1, input.structure);
-      Neighborhood::debug = verbose;
       int length = 0;
       if (Opt.rand) while (neigh.MoveRandom());
       else while (neigh.MoveLowest(Opt.first)) length++;
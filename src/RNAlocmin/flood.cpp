@@ -14,22 +14,22 @@ extern "C" {
 
 using namespace std;
 
-// global priority queue for stuff in flooding (does not hold memory - memory is in hash)
-priority_queue<struct_en*, vector<struct_en*>, comps_entries_rev> neighs;
-priority_queue<Structure*, vector<Structure*>, comps_entries_rev> neighs2;
-int energy_lvl;
-bool debugg;
-int top_lvl;
-int min_lvl;
-bool minh_total;
-bool found_exit;
-// hash for the flooding
-unordered_set<struct_en*, hash_fncts, hash_eq> hash_flood (HASHSIZE);
-unordered_set<struct_en*, hash_fncts, hash_eq>::iterator it_hash;
-
-unordered_set<Structure*, hash_fncts, hash_eq> hash_flood2 (HASHSIZE);
-unordered_set<Structure*, hash_fncts, hash_eq>::iterator it_hash2;
-
+// priority queue for stuff in flooding (does not hold memory - memory is in hash)
+// all the flooding state is per thread, so minima can be flooded in parallel
+thread_local priority_queue<struct_en*, vector<struct_en*>, comps_entries_rev> neighs;
+thread_local priority_queue<Structure*, vector<Structure*>, comps_entries_rev> neighs2;
+thread_local int energy_lvl;
+thread_local bool debugg;
+thread_local int top_lvl;
+thread_local int min_lvl;
+thread_local bool minh_total;
+thread_local bool found_exit;
+// hash for the flooding (grows up to floodMax entries, so no need to preallocate HASHSIZE buckets in every thread)
+thread_local unordered_set<struct_en*, hash_fncts, hash_eq> hash_flood;
+thread_local unordered_set<struct_en*, hash_fncts, hash_eq>::iterator it_hash;
+
+thread_local unordered_set<Structure*, hash_fncts, hash_eq> hash_flood2;
+thread_local unordered_set<Structure*, hash_fncts, hash_eq>::iterator it_hash2;
 
 void copy_se(struct_en *dest, const struct_en *src) {
   copy_arr(dest->structure, src->structure);
@@ -156,14 +156,11 @@ int flood_func2(Structure *input, Structure *output)
 struct_en* flood(const struct_en &he, SeqInfo &sqi, int &saddle_en, int maxh, bool pknots, bool flood_total)
 {
   int count = 0;
+  int saddle_lvl = he.energy;
   debugg = Opt.verbose_lvl>2;
 
   struct_en *res = NULL;
 
-  // save deg.first + create deg
-  bool first = Opt.first;
-  Opt.first = true;
-
   // if minh specified, assign top_lvl and flood_total
   if (maxh>0) {
     top_lvl = he.energy + maxh;
@@ -201,12 +198,16 @@ struct_en* flood(const struct_en &he, SeqInfo &sqi, int &saddle_en, int maxh, bo
       Structure *he_top = neighs2.top();
       neighs2.pop();
       energy_lvl = he_top->energy;
+      if (energy_lvl > saddle_lvl) saddle_lvl = energy_lvl;
 
       if (Opt.verbose_lvl>2) fprintf(stderr, "  neighbours of: %s %.2f (%d)\n", pt_to_str(he_top->str).c_str(), he_top->energy/100.0, (int)neighs2.size());
 
       int verbose = Opt.verbose_lvl<2?0:Opt.verbose_lvl-2;
       he_top->energy = browse_neighs_pk_pt(sqi.seq, he_top, sqi.s0, sqi.s1, Opt.shift, verbose, flood_func2);
 
+      // the saddle is the highest structure flooded so far
+      if (found_exit) saddle_en = saddle_lvl;
+
       if (found_exit && Opt.verbose_lvl>2) fprintf(stderr, "sad= %6.2f    : %s %.2f\n", saddle_en/100.0, pt_to_str(he_top->str).c_str(), he_top->energy/100.0);
 
       // did we find exit from basin?
@@ -261,12 +262,16 @@ struct_en* flood(const struct_en &he, SeqInfo &sqi, int &saddle_en, int maxh, bo
       struct_en *he_top = neighs.top();
       neighs.pop();
       energy_lvl = he_top->energy;
+      if (energy_lvl > saddle_lvl) saddle_lvl = energy_lvl;
 
       if (Opt.verbose_lvl>2) fprintf(stderr, "  neighbours of: %s %.2f\n", pt_to_str(he_top->structure).c_str(), he_top->energy/100.0);
 
       int verbose = Opt.verbose_lvl<2?0:Opt.verbose_lvl-2;
       he_top->energy = browse_neighs_pt(sqi.seq, he_top->structure, sqi.s0, sqi.s1, verbose, Opt.shift, Opt.noLP, flood_func);
 
+      // the saddle is the highest structure flooded so far
+      if (found_exit) saddle_en = saddle_lvl;
+
       if (found_exit && Opt.verbose_lvl>2) fprintf(stderr, "sad= %6.2f    : %s %.2f\n", saddle_en/100.0, pt_to_str(he_top->structure).c_str(), he_top->energy/100.0);
 
       // did we find exit from basin?
@@ -293,9 +298,6 @@ struct_en* flood(const struct_en &he, SeqInfo &sqi, int &saddle_en, int maxh, bo
     free_hash(hash_flood);
   }  /// #### END OF PKNOTS BRANCH
 
-  // restore deg options
-  Opt.first = first;
-
   // return found? structure
   return res;
 }
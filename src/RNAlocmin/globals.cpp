@@ -6,6 +6,7 @@
 #include <time.h>
 
 #include <stack>
+#include <thread>
 
 extern "C" {
   #include "pair_mat.h"
@@ -106,6 +107,11 @@ int Options::Init(gengetopt_args_info &args_info)
     ret = -1;
   }
 
+  if (args_info.jobs_given && args_info.jobs_arg<0) {
+    fprintf(stderr, "Number of parallel threads should be non-negative integer (jobs)\n");
+    ret = -1;
+  }
+
   if (ret ==-1) return -1;
 
   // adjust options
@@ -120,6 +126,13 @@ int Options::Init(gengetopt_args_info &args_info)
   pknots = args_info.pseudoknots_flag;
   neighs = args_info.neighborhood_flag;
 
+  num_threads = 1;
+  if (args_info.jobs_given) {
+    num_threads = args_info.jobs_arg;
+    if (num_threads==0) num_threads = std::thread::hardware_concurrency();
+    if (num_threads<1) num_threads = 1;
+  }
+
   return ret;
 }
 
@@ -43,6 +43,8 @@ public:
 
   bool pknots; // flag for pseudoknots.
 
+  int num_threads; // number of parallel threads (1 == serial)
+
 public:
   Options();
 
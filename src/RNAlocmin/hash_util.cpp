@@ -50,17 +50,185 @@ bool compf_entries_rev (const struct_en *lhs, const struct_en *rhs) {
   return compf_short_rev(lhs->structure, rhs->structure);
 }
 
-void print_stats(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs)
+StructHash::StructHash(int length, bool pknots, int capacity):
+  shards(HASHSHARDS)
+{
+  bits = (pknots ? 4 : 2);
+  words = (length*bits + 63)/64;
+  if (words == 0) words = 1;
+
+  int cap = 16;
+  while (cap*HASHSHARDS < capacity) cap *= 2;
+  for (int i=0; i<HASHSHARDS; i++) {
+    Slot empty = {0, -1};
+    shards[i].slots.assign(cap, empty);
+    shards[i].size = 0;
+  }
+}
+
+void StructHash::Pack(const short *structure, uint64_t *key) const
+{
+  for (int w=0; w<words; w++) key[w] = 0;
+
+  if (bits == 2) {
+    for (int i=1; i<=structure[0]; i++) {
+      uint64_t c = (structure[i]==0 ? 0 : (structure[i]>i ? 1 : 2));
+      key[((i-1)*2)>>6] |= c << (((i-1)*2) & 63);
+    }
+  } else {
+    const char *chars = ".([{<)]}>";
+    string str = pt_to_str_pk(structure);
+    // pt_to_str_pk() appends a terminating '\0', so stay within the length
+    for (int i=0; i<structure[0]; i++) {
+      uint64_t c = strchr(chars, str[i]) - chars;
+      key[(i*4)>>6] |= c << ((i*4) & 63);
+    }
+  }
+}
+
+unsigned StructHash::Hash(const uint64_t *key, int words)
+{
+  uint64_t h = 0x9e3779b97f4a7c15ULL;
+  for (int w=0; w<words; w++) {
+    h ^= key[w];
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+  }
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return (unsigned)h;
+}
+
+void StructHash::Grow(Shard &shard)
+{
+  vector<Slot> old;
+  old.swap(shard.slots);
+
+  Slot empty = {0, -1};
+  shard.slots.assign(old.size()*2, empty);
+  unsigned mask = shard.slots.size()-1;
+
+  for (unsigned i=0; i<old.size(); i++) {
+    if (old[i].index < 0) continue;
+    unsigned pos = old[i].hash & mask;
+    while (shard.slots[pos].index >= 0) pos = (pos+1) & mask;
+    shard.slots[pos] = old[i];
+  }
+}
+
+StructHash::Entry &StructHash::Insert(const struct_en &str, int index, bool &inserted)
+{
+  static thread_local vector<uint64_t> key;
+  key.resize(words);
+  Pack(str.structure, key.data());
+  unsigned hash = Hash(key.data(), words);
+
+  Shard &shard = shards[hash >> (32-HASHSHARDBITS)];
+  lock_guard<mutex> guard(shard.lock);
+
+  // look it up
+  unsigned mask = shard.slots.size()-1;
+  unsigned pos = hash & mask;
+  while (shard.slots[pos].index >= 0) {
+    Slot &slot = shard.slots[pos];
+    if (slot.hash == hash && memcmp(&shard.keys[(size_t)slot.index*words], key.data(), words*sizeof(uint64_t)) == 0) {
+      Entry &entry = shard.entries[slot.index];
+      inserted = false;
+      if (entry.gw.owner >= 0 && index < entry.gw.owner) entry.gw.owner = index;
+      return entry;
+    }
+    pos = (pos+1) & mask;
+  }
+
+  // insert it
+  int idx;
+  if (!shard.unused.empty()) {
+    idx = shard.unused.back();
+    shard.unused.pop_back();
+  } else {
+    idx = shard.entries.size();
+    shard.entries.push_back(Entry());
+    shard.keys.resize(shard.keys.size()+words);
+  }
+  memcpy(&shard.keys[(size_t)idx*words], key.data(), words*sizeof(uint64_t));
+
+  Entry &entry = shard.entries[idx];
+  entry.gw = gw_struct();
+  entry.gw.owner = index;
+  entry.energy = str.energy;
+  entry.hash = hash;
+  entry.index = idx;
+
+  shard.slots[pos].hash = hash;
+  shard.slots[pos].index = idx;
+  shard.size++;
+  if (shard.size*10 > (int)shard.slots.size()*7) Grow(shard);
+
+  inserted = true;
+  return entry;
+}
+
+void StructHash::Erase(Entry &entry)
+{
+  Shard &shard = shards[entry.hash >> (32-HASHSHARDBITS)];
+  lock_guard<mutex> guard(shard.lock);
+
+  unsigned mask = shard.slots.size()-1;
+  unsigned i = entry.hash & mask;
+  while (shard.slots[i].index != entry.index) {
+    if (shard.slots[i].index < 0) return;
+    i = (i+1) & mask;
+  }
+
+  // shift back the following entries of the cluster that would not be found otherwise
+  unsigned j = i;
+  while (true) {
+    j = (j+1) & mask;
+    if (shard.slots[j].index < 0) break;
+    unsigned home = shard.slots[j].hash & mask;
+    if (i<=j ? (i<home && home<=j) : (i<home || home<=j)) continue;
+    shard.slots[i] = shard.slots[j];
+    i = j;
+  }
+  shard.slots[i].index = -1;
+
+  shard.unused.push_back(entry.index);
+  shard.size--;
+}
+
+void StructHash::Clear()
+{
+  for (int i=0; i<HASHSHARDS; i++) {
+    Shard &shard = shards[i];
+    Slot empty = {0, -1};
+    shard.slots.assign(16, empty);
+    shard.entries.clear();
+    vector<uint64_t>().swap(shard.keys);
+    shard.unused.clear();
+    shard.size = 0;
+  }
+}
+
+void StructHash::ForEach(const function<void(Entry&)> &func)
+{
+  for (int i=0; i<HASHSHARDS; i++) {
+    Shard &shard = shards[i];
+    for (unsigned j=0; j<shard.slots.size(); j++) {
+      if (shard.slots[j].index >= 0) func(shard.entries[shard.slots[j].index]);
+    }
+  }
+}
+
+void print_stats(StructHash &structs)
 {
   double mean = 0.0;
   int count = 0;
   double entropy = 0.0;
-  unordered_map<struct_en, gw_struct, hash_fncts>::iterator it;
-  for (it=structs.begin(); it!=structs.end(); it++) {
-    count += it->second.count;
-    mean += (it->first.energy)*(it->second.count);
-    entropy += it->second.count*log(it->second.count);
-  }
+  structs.ForEach([&](StructHash::Entry &entry) {
+    count += entry.gw.count;
+    mean += (entry.energy)*(entry.gw.count);
+    entropy += entry.gw.count*log(entry.gw.count);
+  });
 
   mean /= (double)count*100.0;
   entropy = entropy/(double)count - log(count);
@@ -68,29 +236,24 @@ void print_stats(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &struc
   fprintf(stderr, "Mean  : %.3f (Entrpy: %.3f)\n", mean, entropy);
 }
 
-void add_stats(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs, map<struct_en, int, comps_entries> &output)
+void add_stats(StructHash &structs, map<struct_en, int, comps_entries> &output)
 {
-  unordered_map<struct_en, gw_struct, hash_fncts>::iterator it;
-  for (it=structs.begin(); it!=structs.end(); it++) {
+  structs.ForEach([&](StructHash::Entry &entry) {
     // add stats:
-    //fprintf(stderr, "struct: %s %6.2f %d\n", pt_to_str(it->second.he.structure).c_str(), it->second.he.energy/100.0, it->second.count);
+    //fprintf(stderr, "struct: %s %6.2f %d\n", pt_to_str(entry.gw.he.structure).c_str(), entry.gw.he.energy/100.0, entry.gw.count);
 
-    if (output.count(it->second.he) == 0) {
+    if (output.count(entry.gw.he) == 0) {
       fprintf(stderr, "ERROR: output does not contain structure it should!!!\n");
       //if (!Opt.pknots) exit(EXIT_FAILURE);
     }
-    output[it->second.he] += it->second.count-1;
-  }
+    output[entry.gw.he] += entry.gw.count-1;
+  });
 }
 
 // free hash
-void free_hash(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs)
+void free_hash(StructHash &structs)
 {
-  unordered_map<struct_en, gw_struct, hash_fncts>::iterator it;
-  for (it=structs.begin(); it!=structs.end(); it++) {
-    free(it->first.structure);
-  }
-  structs.clear();
+  structs.Clear();
 }
 
 // free hash
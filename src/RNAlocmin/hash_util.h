@@ -4,6 +4,11 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <map>
+#include <mutex>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <stdint.h>
 
 extern "C" {
   #include "utils.h"
@@ -16,9 +21,11 @@ extern "C" {
 struct gw_struct {
   int count;
   struct_en he; // does not contain memory
+  int owner;    // index of the first occurrence in the batch of input structures, it descends for all (-1 after merging)
   gw_struct(){
     he.structure = NULL;
     count = 0;
+    owner = -1;
   }
 };
 
@@ -295,14 +302,68 @@ struct comps_entries_rev {
   }
 };
 
+// structures to minima map, split into shards with their own locks, so parallel descents can look up and insert concurrently
+// structures are stored as packed keys: 2 bits per position for dot-bracket, 4 bits with pseudoknots (as in pt_to_str_pk())
+// each shard is an open addressing table (linear probing) that grows when it is filled to 70%
+#define HASHSHARDBITS 6
+#define HASHSHARDS (1<<HASHSHARDBITS)
+
+class StructHash {
+public:
+  struct Entry {
+    gw_struct gw;
+    int energy;       // energy of the structure
+    unsigned hash;
+    int index;        // position of entry and key in its shard
+  };
+
+private:
+  struct Slot {
+    unsigned hash;
+    int index;        // -1 == empty
+  };
+
+  struct Shard {
+    std::mutex lock;
+    std::vector<Slot> slots;
+    std::deque<Entry> entries;      // references stay valid on growth
+    std::vector<uint64_t> keys;
+    std::vector<int> unused;        // positions of erased entries
+    int size;
+  };
+  std::vector<Shard> shards;
+
+  int bits;     // bits per position
+  int words;    // words per key
+
+  void Pack(const short *structure, uint64_t *key) const;
+  static unsigned Hash(const uint64_t *key, int words);
+  static void Grow(Shard &shard);
+
+public:
+  // length of the structures, initial number of slots
+  StructHash(int length, bool pknots, int capacity = 1<<16);
+
+  // entry of the structure, inserted if not present (then inserted is set to true)
+  // index is the position of str in the current batch, the lowest one becomes the owner of a new entry
+  Entry &Insert(const struct_en &str, int index, bool &inserted);
+  // remove the entry
+  void Erase(Entry &entry);
+  // remove all
+  void Clear();
+
+  // call func on all entries (not thread-safe, only for processing after the parallel part)
+  void ForEach(const std::function<void(Entry&)> &func);
+};
+
 // print stats about hash
-void print_stats(std::unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs);
+void print_stats(StructHash &structs);
 // add stats from hash to output map
-void add_stats(std::unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs, std::map<struct_en, int, comps_entries> &output);
+void add_stats(StructHash &structs, std::map<struct_en, int, comps_entries> &output);
 
 
 // free hash
-void free_hash(std::unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs);
+void free_hash(StructHash &structs);
 //void free_hash(unordered_map<Structure, gw_struct, hash_fncts, hash_eq> &structs);
 void free_hash(std::unordered_set<struct_en*, hash_fncts, hash_eq> &structs);
 void free_hash(std::unordered_set<Structure*, hash_fncts, hash_eq> &structs);
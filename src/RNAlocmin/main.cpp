@@ -34,6 +34,7 @@ extern "C" {
 #include "neighbourhood.h"
 
 #include "barrier_tree.h"
+#include "parallel.h"
 
 using namespace std;
 
@@ -102,9 +103,26 @@ struct barr_info { // info taken from barriers
   }
 };
 
+// input structure on its way through the (parallel) descent
+struct input_struct {
+  int status;       // 1 = to process, 0 = skip, -2 = non-canonical
+  int num_move;     // number of moves so far (for verbose output)
+  struct_en str;    // the structure as read
+  struct_en lm;     // its local minimum (if descended)
+  int gw_length;    // length of gradient walk (if descended)
+  StructHash::Entry *entry; // its entry in the hash
+};
+
+// input structures are read in batches, descended in parallel, and merged in the order of input
+static const int batch_per_thread = 256;
+static const int flood_per_thread = 4;
+
 // functions that are down in file ;-)
 char *read_seq(char *seq_arg, char **name_out);
-int move(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs, map<struct_en, int, comps_entries> &output, set<struct_en, comps_entries> &output_shallow, SeqInfo &sqi, bool pure_output);
+bool read_batch(vector<input_struct> &batch, int batch_size, SeqInfo &sqi);
+void descend_batch(Workers &workers, vector<input_struct> &batch, StructHash &structs, SeqInfo &sqi, bool pure_output);
+int merge(input_struct &in, int i, vector<StructHash::Entry*> &invalid, map<struct_en, int, comps_entries> &output, bool pure_output);
+void discard(input_struct &in, int i, vector<StructHash::Entry*> &invalid, bool pure_output);
 char *read_previous(char *previous, map<struct_en, int, comps_entries> &output);
 char *read_barr(char *previous, map<struct_en, barr_info, comps_entries> &output);
 
@@ -156,6 +174,7 @@ int main(int argc, char **argv)
     degeneracy_handling(0);
     Neighborhood::SwitchOffDegen();
   }
+  Neighborhood::debug = (Opt.verbose_lvl-2<0?0:Opt.verbose_lvl-2);
 
   //try_pk();
   //exit(0);
@@ -211,19 +230,41 @@ int main(int argc, char **argv)
     if (args_info.just_output_flag) printf("%s\n", seq);
 
     // hash
-    unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> structs (HASHSIZE); // structures to minima map
-    while ((!args_info.find_num_given || count != args_info.find_num_arg) && !args_info.just_read_flag) {
-      int res = move(structs, output, output_shallow, sqi, args_info.just_output_flag);
+    StructHash structs(seq_len, Opt.pknots); // structures to minima map
+    Workers workers(Opt.num_threads);
+    int batch_size = (workers.Size()>1 ? batch_per_thread*workers.Size() : 1);
+    vector<input_struct> batch;
+    vector<StructHash::Entry*> invalid;
+    bool end = false;
+    while (!end && (!args_info.find_num_given || count != args_info.find_num_arg) && !args_info.just_read_flag) {
+      end = read_batch(batch, batch_size, sqi);
+      descend_batch(workers, batch, structs, sqi, args_info.just_output_flag);
+
+      for (int i=0; i<(int)batch.size(); i++) {
+        // stop after enough minima found
+        if (args_info.find_num_given && count == args_info.find_num_arg) {
+          discard(batch[i], i, invalid, args_info.just_output_flag);
+          end = true;
+          continue;
+        }
+
+        int res = merge(batch[i], i, invalid, output, args_info.just_output_flag);
 
-      // print out
-      //if (Opt.verbose_lvl>0 && num_moves%10000==0) fprintf(stderr, "processed %d, minima %d, time %f secs.\n", num_moves, count, (clock()-clck1)/(double)CLOCKS_PER_SEC);
-      if (Opt.verbose_lvl>0 && num_moves%(Opt.pknots?1000:10000)==0 && num_moves!=0) fprintf(stderr, "processed %d, minima %d, time %f secs.\n", num_moves, (int)output.size(), (clock()-clck1)/(double)CLOCKS_PER_SEC);
+        // print out
+        //if (Opt.verbose_lvl>0 && num_moves%10000==0) fprintf(stderr, "processed %d, minima %d, time %f secs.\n", num_moves, count, (clock()-clck1)/(double)CLOCKS_PER_SEC);
+        if (Opt.verbose_lvl>0 && batch[i].num_move%(Opt.pknots?1000:10000)==0 && batch[i].num_move!=0) fprintf(stderr, "processed %d, minima %d, time %f secs.\n", batch[i].num_move, (int)output.size(), (clock()-clck1)/(double)CLOCKS_PER_SEC);
 
-      // evaluate results
-      if (res==0)   continue; // same structure has been processed already
-      if (res==-1)  break; // error or end
-      if (res==-2)  not_canonical++;
-      if (res==1)   count=output.size();
+        // evaluate results
+        if (res==0)   continue; // same structure has been processed already
+        if (res==-2)  not_canonical++;
+        if (res==1)   count=output.size();
+      }
+
+      // structures without valid minimum are not kept in hash
+      for (unsigned int i=0; i<invalid.size(); i++) {
+        structs.Erase(*invalid[i]);
+      }
+      invalid.clear();
     }
 
     if (args_info.just_output_flag) {
@@ -273,6 +314,10 @@ int main(int argc, char **argv)
     // threshold for flooding
     int threshold;
 
+    // shallow minima are flooded in parallel, a batch ahead
+    vector<struct_en*> escapes;
+    int escapes_from = 0;
+
     int i=0;
     int ii=0;
     for (map<struct_en, int, comps_entries>::iterator it=output.begin(); it!=output.end(); it++) {
@@ -281,8 +326,20 @@ int main(int argc, char **argv)
       if (i<num) {
         // first check if the output is not shallow
         if (Opt.minh>0) {
-          int saddle;
-          struct_en *escape = flood(it->first, sqi, saddle, Opt.minh, args_info.pseudoknots_flag, !args_info.minh_lite_flag);
+          if (ii-1 >= escapes_from+(int)escapes.size()) {
+            vector<map<struct_en, int, comps_entries>::iterator> to_flood;
+            for (map<struct_en, int, comps_entries>::iterator it2=it; it2!=output.end() && (int)to_flood.size()<(workers.Size()>1 ? flood_per_thread*workers.Size() : 1); it2++) {
+              to_flood.push_back(it2);
+            }
+            escapes_from = ii-1;
+            escapes.assign(to_flood.size(), NULL);
+            workers.Run(to_flood.size(), [&](int j) {
+              int saddle;
+              escapes[j] = flood(to_flood[j]->first, sqi, saddle, Opt.minh, args_info.pseudoknots_flag, !args_info.minh_lite_flag);
+            });
+          }
+          struct_en *escape = escapes[ii-1-escapes_from];
+          escapes[ii-1-escapes_from] = NULL;
 
           if (args_info.verbose_lvl_arg>0 && ii%100 == 0) {
             fprintf(stderr, "non-shallow remained: %d / %d; time: %.2f secs.\n", i, ii, (clock()-clck1)/(double)CLOCKS_PER_SEC);
@@ -316,15 +373,25 @@ int main(int argc, char **argv)
     }
     output.clear();
 
+    // flooded in vain
+    for (unsigned int j=0; j<escapes.size(); j++) {
+      if (escapes[j]) {
+        free(escapes[j]->structure);
+        free(escapes[j]);
+      }
+    }
+
     // allegiance:
     if (allegiance) {
       for (int i=0; i<(int)structures.size(); i++) {
         fprintf(alleg, "%6d %s %6.2f %6d\n", i+1, pt_to_str_pk(structures[i].structure).c_str(), structures[i].energy/100.0, LM_to_LMnum[str_to_LM[structures[i]]]);
-        //free(structures[i].structure);
       }
-      structures.clear();
       LM_to_LMnum.clear();
       str_to_LM.clear();
+      for (int i=0; i<(int)structures.size(); i++) {
+        free(structures[i].structure);
+      }
+      structures.clear();
     }
 
     // erase possible NULL elements...
@@ -834,8 +901,13 @@ char *read_seq(char *seq_arg, char **name_out)
 }
 
 
-int move(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs, map<struct_en, int, comps_entries> &output, set<struct_en, comps_entries> &output_shallow, SeqInfo &sqi, bool pure_output)
+int read_structure(input_struct &in, SeqInfo &sqi)
 {
+  in.str.structure = NULL;
+  in.lm.structure = NULL;
+  in.entry = NULL;
+  in.num_move = num_moves;
+
   // read a line
   char *line = my_getline(stdin);
   if (line == NULL) return -1;
@@ -881,6 +953,7 @@ int move(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs, map<
 
   // count moves
   num_moves++;
+  in.num_move = num_moves;
 
   // find length of structure
   int len=0;
@@ -893,116 +966,169 @@ int move(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs, map<
   }
 
   // make make_pair
-  struct_en str;
-  str.structure = Opt.pknots? make_pair_table_PK(p):make_pair_table(p);
+  in.str.structure = Opt.pknots? make_pair_table_PK(p):make_pair_table(p);
+  free(line);
 
   // only H,K,L,M types allowed:
-  if (!str.structure) {
-    free(line);
-    return 0;
-  } else {
-    str.energy = Opt.pknots? energy_of_struct_pk(sqi.seq, str.structure, sqi.s0, sqi.s1, Opt.verbose_lvl>3):energy_of_structure_pt(sqi.seq, str.structure, sqi.s0, sqi.s1, 0);
-    free(line);
+  if (!in.str.structure) return 0;
+
+  return 1;
+}
+
+bool read_batch(vector<input_struct> &batch, int batch_size, SeqInfo &sqi)
+{
+  batch.clear();
+  while ((int)batch.size() < batch_size) {
+    input_struct in;
+    in.status = read_structure(in, sqi);
+    if (in.status == -1) return true;
+    batch.push_back(in);
   }
+  return false;
+}
+
+void descend_batch(Workers &workers, vector<input_struct> &batch, StructHash &structs, SeqInfo &sqi, bool pure_output)
+{
+  // evaluate, check canonicity and look up in the hash
+  workers.Run(batch.size(), [&](int i) {
+    input_struct &in = batch[i];
+    if (in.status != 1) return;
+
+    in.str.energy = Opt.pknots? energy_of_struct_pk(sqi.seq, in.str.structure, sqi.s0, sqi.s1, Opt.verbose_lvl>3):energy_of_structure_pt(sqi.seq, in.str.structure, sqi.s0, sqi.s1, 0);
 
-  // if pure, just do descend and print it:
-  if (pure_output) {
     //is it canonical (noLP)
-    if (Opt.noLP && find_lone_pair(str.structure)!=-1) {
-      if (Opt.verbose_lvl>0) fprintf(stderr, "WARNING: structure \"%s\" has lone pairs, skipping...\n", pt_to_str_pk(str.structure).c_str());
-      free(str.structure);
-      return -2;
+    if (Opt.noLP && find_lone_pair(in.str.structure)!=-1) {
+      in.status = -2;
+      return;
+    }
+
+    // if pure, there is no hash
+    if (!pure_output) {
+      bool inserted;
+      in.entry = &structs.Insert(in.str, i, inserted);
     }
+  });
+
+  // descend (only the first occurrence of each new structure)
+  workers.Run(batch.size(), [&](int i) {
+    input_struct &in = batch[i];
+    if (in.status != 1) return;
+    if (!pure_output && in.entry->gw.owner != i) return;
+
+    // copy it anew
+    in.lm.structure = allocopy(in.str.structure);
+    in.lm.energy = in.str.energy;
 
     //debugging
-    if (Opt.verbose_lvl>1) fprintf(stderr, "proc(pure): %d %s\n", num_moves, pt_to_str_pk(str.structure).c_str());
+    if (Opt.verbose_lvl>1) fprintf(stderr, "%s: %d %s\n", pure_output?"proc(pure)":"processing", in.num_move, pt_to_str_pk(in.lm.structure).c_str());
+
+    in.gw_length = move_set(in.lm, sqi);
+  });
+}
+
+int merge(input_struct &in, int i, vector<StructHash::Entry*> &invalid, map<struct_en, int, comps_entries> &output, bool pure_output)
+{
+  if (in.status == 0) return 0;
+
+  // non-canonical
+  if (in.status == -2) {
+    if (Opt.verbose_lvl>0) fprintf(stderr, "WARNING: structure \"%s\" has lone pairs, skipping...\n", pt_to_str_pk(in.str.structure).c_str());
+    // allegiance hack:
+    if (allegiance && !pure_output) structures.push_back(in.str);
+    else free(in.str.structure);
+    return -2;
+  }
 
-    // descend
-    int gw_length = move_set(str, sqi);
+  // if pure, just print it:
+  if (pure_output) {
+    free(in.str.structure);
     // only some types of PK allowed!!!
-    if (Opt.pknots && str.energy == INT_MAX) {
-      free(str.structure);
+    if (Opt.pknots && in.lm.energy == INT_MAX) {
+      free(in.lm.structure);
       return 0;
     }
 
-    if (Opt.verbose_lvl>2) fprintf(stderr, "\n  %s %d %d\n", pt_to_str_pk(str.structure).c_str(), str.energy, gw_length);
-    printf("%s %6.2f %4d\n", pt_to_str_pk(str.structure).c_str(), str.energy/100.0, gw_length);
-    free(str.structure);
+    if (Opt.verbose_lvl>2) fprintf(stderr, "\n  %s %d %d\n", pt_to_str_pk(in.lm.structure).c_str(), in.lm.energy, in.gw_length);
+    printf("%s %6.2f %4d\n", pt_to_str_pk(in.lm.structure).c_str(), in.lm.energy/100.0, in.gw_length);
+    free(in.lm.structure);
     return 1;
   }
 
-  // check if it was before
-  unordered_map<struct_en, gw_struct, hash_fncts, hash_eq>::iterator it_s = structs.find(str);
+  // the hash keeps only a packed copy of the structure
+  struct_en he_str = in.str;
+  gw_struct &lm = in.entry->gw;
 
-  // if it was - release memory + get another
-  if (it_s != structs.end()) {
-    it_s->second.count++;
-    free(str.structure);
+  // invalid (PK) minimum -- it is not in hash (removed after the batch) and it is processed anew every time
+  if (lm.owner == -2) {
+    if (allegiance) structures.push_back(he_str);
+    else free(he_str.structure);
     return 0;
-  } else {
-    // find energy only if not in input (not working - does energy_of_move require energy_of_struct run first???)
-    //str.energy = Enc.Energy(str);
-    //printf("\n%s\n%s %7.2f\n\n", Enc.seq, pt_to_str_pk(str.structure).c_str(), str.energy/100.0);
-    /*if (1 || !energy_found) str.energy = Enc.Energy(str);
-    else str.energy = (int)(energy*100.0+(energy<0.0 ? -0.5 : 0.5));*/
+  }
 
-    // allegiance hack:
-    struct_en he_str = str;
-    if (allegiance) {
-      structures.push_back(he_str);
-    }
+  // if it was - just count it
+  if (lm.owner != i) {
+    lm.count++;
+    free(he_str.structure);
+    return 0;
+  }
 
-    //is it canonical (noLP)
-    if (Opt.noLP && find_lone_pair(str.structure)!=-1) {
-      if (Opt.verbose_lvl>0) fprintf(stderr, "WARNING: structure \"%s\" has lone pairs, skipping...\n", pt_to_str_pk(str.structure).c_str());
-      free(str.structure);
-      return -2;
-    }
+  // only some types of PK allowed!!!
+  if (Opt.pknots && in.lm.energy == INT_MAX) {
+    free(in.lm.structure);
+    lm.owner = -2;
+    invalid.push_back(in.entry);
+    if (allegiance) structures.push_back(he_str);
+    else free(he_str.structure);
+    return 0;
+  }
 
-    // copy it anew
-    struct_en old = str;
-    str.structure = allocopy(str.structure);
+  // allegiance hack:
+  if (allegiance) {
+    structures.push_back(he_str);
+  } else {
+    free(he_str.structure);
+  }
 
-    //debugging
-    if (Opt.verbose_lvl>1) fprintf(stderr, "processing: %d %s\n", num_moves, pt_to_str_pk(str.structure).c_str());
+  // hash entry
+  lm.count = 1;
+  lm.owner = -1;
 
-    // descend
-    move_set(str, sqi);
-    // only some types of PK allowed!!!
-    if (Opt.pknots && str.energy == INT_MAX) {
-      free(str.structure);
-      free(old.structure);
-      return 0;
-    }
+  if (Opt.verbose_lvl>2) fprintf(stderr, "\n  %s %d\n", pt_to_str_pk(in.lm.structure).c_str(), in.lm.energy);
 
-    // insert into hash (memory is here only on left side)
-    gw_struct &lm = structs[old];
-    lm.count = 1;
-    /*
-    int i;
-    while ((i = (Opt.rand? move_rand(str) : move_set(str)))!=0) {
-      Deg.Clear();
-    }
-    Deg.Clear();*/
+  // save for output
+  map<struct_en, int, comps_entries>::iterator it;
+  if ((it = output.find(in.lm)) != output.end()) {
+    it->second++;
+    lm.he = it->first;
+    free(in.lm.structure);
+    // allegiance hack:
+    if (allegiance) str_to_LM[he_str] = it->first;
+  } else {
+    //str.num = output.size();
+    lm.he = in.lm;
+    output.insert(make_pair(in.lm, 1));
+    // allegiance hack:
+    if (allegiance) str_to_LM[he_str] = in.lm;
+  }
 
-    if (Opt.verbose_lvl>2) fprintf(stderr, "\n  %s %d\n", pt_to_str_pk(str.structure).c_str(), str.energy);
+  return 1;
+}
 
-    // save for output
-    map<struct_en, int, comps_entries>::iterator it;
-    if ((it = output.find(str)) != output.end()) {
-      it->second++;
-      lm.he = it->first;
-      free(str.structure);
-      // allegiance hack:
-      if (allegiance) str_to_LM[he_str] = it->first;
-    } else {
-      //str.num = output.size();
-      lm.he = str;
-      output.insert(make_pair(str, 1));
-      // allegiance hack:
-      if (allegiance) str_to_LM[he_str] = str;
-    }
+void discard(input_struct &in, int i, vector<StructHash::Entry*> &invalid, bool pure_output)
+{
+  if (in.status != 1 && in.status != -2) return;
+
+  if (pure_output || in.status == -2) {
+    free(in.str.structure);
+    if (in.lm.structure) free(in.lm.structure);
+    return;
   }
 
-  return 1;
+  // structures first seen in here were never inserted in the serial run
+  if (in.entry->gw.owner == i) {
+    free(in.lm.structure);
+    in.entry->gw.owner = -2;
+    invalid.push_back(in.entry);
+  }
+  free(in.str.structure);
 }
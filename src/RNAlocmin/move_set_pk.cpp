@@ -48,7 +48,7 @@ int equals(const Structure *first, const Structure *second)
 /* ############################## DECLARATION #####################################*/
 /* private functions & declarations*/
 
-static int cnt_move = 0;
+static thread_local int cnt_move = 0;
 int count_move() {return cnt_move;}
 
 void print_str_pk(FILE *out, short *str);
@@ -17,16 +17,16 @@ extern "C" {
 #define MINGAP 3
 
 // declare static members:
-char *Neighborhood::seq = NULL;
-short *Neighborhood::s0 = NULL;
-short *Neighborhood::s1 = NULL;
+thread_local char *Neighborhood::seq = NULL;
+thread_local short *Neighborhood::s0 = NULL;
+thread_local short *Neighborhood::s1 = NULL;
 int Neighborhood::debug = 0;
 
 // for degeneracy:
-int Neighborhood::energy_deg = 0;
+thread_local int Neighborhood::energy_deg = 0;
 bool Neighborhood::deal_degen = 1;
-std::vector<Neighborhood*> Neighborhood::degen_todo;
-std::vector<Neighborhood*> Neighborhood::degen_done;
+thread_local std::vector<Neighborhood*> Neighborhood::degen_todo;
+thread_local std::vector<Neighborhood*> Neighborhood::degen_done;
 
 void error_message(char *str, int i = -1, int j = -1, int k = -1, int l = -1)
 {
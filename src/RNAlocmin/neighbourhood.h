@@ -5,6 +5,7 @@
 
 // ###############
 // Neighborhood routines -- note that if you need to have more INDEPENDENT instances of Neighborhood with different degeneracies, you would have to do a bit of coding... since they are static now and need to be static.
+// (they are static per thread, so independent descents can run in parallel threads)
 // ###############
 
 
@@ -42,9 +43,9 @@ struct Loop
 class Neighborhood
 {
 private:
-  static char *seq;
-  static short *s0;
-  static short *s1;
+  static thread_local char *seq;
+  static thread_local short *s0;
+  static thread_local short *s1;
 
   std::vector<Loop*> loops;
 
@@ -55,9 +56,9 @@ private:
   bool deletes;
 
   // for degeneracy:
-  static int energy_deg;
-  static std::vector<Neighborhood*> degen_todo;
-  static std::vector<Neighborhood*> degen_done;
+  static thread_local int energy_deg;
+  static thread_local std::vector<Neighborhood*> degen_todo;
+  static thread_local std::vector<Neighborhood*> degen_done;
   static bool deal_degen;
 
 public:
@@ -0,0 +1,81 @@
+#include "parallel.h"
+
+using namespace std;
+
+Workers::Workers(int num_threads)
+{
+  job = NULL;
+  num = 0;
+  next = 0;
+  generation = 0;
+  busy = 0;
+  quit = false;
+
+  for (int i=1; i<num_threads; i++) {
+    threads.push_back(thread(&Workers::Work, this));
+  }
+}
+
+Workers::~Workers()
+{
+  {
+    lock_guard<mutex> guard(lock);
+    quit = true;
+  }
+  start.notify_all();
+
+  for (unsigned int i=0; i<threads.size(); i++) {
+    threads[i].join();
+  }
+}
+
+void Workers::Chunk()
+{
+  int i;
+  while ((i = next++) < num) {
+    (*job)(i);
+  }
+}
+
+void Workers::Work()
+{
+  int seen = 0;
+
+  while (true) {
+    unique_lock<mutex> guard(lock);
+    start.wait(guard, [&]{ return quit || generation != seen; });
+    if (quit) return;
+    seen = generation;
+    guard.unlock();
+
+    Chunk();
+
+    guard.lock();
+    if (--busy == 0) done.notify_one();
+  }
+}
+
+void Workers::Run(int num, const function<void(int)> &job)
+{
+  // serial fallback
+  if (threads.empty() || num <= 1) {
+    for (int i=0; i<num; i++) job(i);
+    return;
+  }
+
+  {
+    lock_guard<mutex> guard(lock);
+    this->job = &job;
+    this->num = num;
+    next = 0;
+    busy = (int)threads.size();
+    generation++;
+  }
+  start.notify_all();
+
+  Chunk();
+
+  // wait for the others to finish their last index
+  unique_lock<mutex> guard(lock);
+  done.wait(guard, [&]{ return busy == 0; });
+}
@@ -0,0 +1,45 @@
+#ifndef __PARALLEL_H
+#define __PARALLEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// pool of worker threads that live as long as the pool does, so their
+// thread-local state (flooding hashes, degeneracy lists, energy evaluation
+// in RNAlib) is set up only once per thread
+class Workers
+{
+private:
+  std::vector<std::thread> threads;
+
+  std::mutex lock;
+  std::condition_variable start;
+  std::condition_variable done;
+
+  // current job:
+  const std::function<void(int)> *job;
+  int num;
+  std::atomic<int> next;
+  int generation;
+  int busy;
+  bool quit;
+
+  void Work();
+  void Chunk();
+
+public:
+  Workers(int num_threads);
+  ~Workers();
+
+  // number of threads (including the calling one)
+  int Size() const { return (int)threads.size()+1; }
+
+  // call job(i) for all i in [0, num) -- indices are handed out dynamically, the calling thread takes part in the work
+  void Run(int num, const std::function<void(int)> &job);
+};
+
+#endif
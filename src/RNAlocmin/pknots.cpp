@@ -8,6 +8,8 @@
 #include <algorithm>
 #include <vector>
 #include <ctime>
+#include <atomic>
+#include <mutex>
 
 extern "C" {
   #include "pair_mat.h"
@@ -19,13 +21,31 @@ extern "C" {
 
 #include "pknots.h"
 
-static float time_eos = 0.0;
-static paramT *P = NULL;
+static thread_local float time_eos = 0.0;
+static std::atomic<paramT*> P_shared(NULL);
+static std::mutex P_lock;
+
+// energy parameters, scaled on first use by whichever thread comes first
+static paramT *get_P()
+{
+  paramT *P = P_shared.load(std::memory_order_acquire);
+  if (P == NULL) {
+    std::lock_guard<std::mutex> guard(P_lock);
+    P = P_shared.load(std::memory_order_relaxed);
+    if (P == NULL) {
+      make_pair_matrix();
+      update_fold_params();
+      P = scale_parameters();
+      P_shared.store(P, std::memory_order_release);
+    }
+  }
+  return P;
+}
 
 void freeP()
 {
+  paramT *P = P_shared.exchange(NULL);
   if (P) free(P);
-  P = NULL;
 }
 
 float get_eos_time()
@@ -519,11 +539,7 @@ void Helpers::Create(int length)
 
 int energy_of_struct_pk(const char *seq, char *structure, int verbose)
 {
-  if (P == NULL) {
-    make_pair_matrix();
-    update_fold_params();
-    P = scale_parameters();
-  }
+  get_P();
   short *str = make_pair_table_PK(structure);
   int res = energy_of_struct_pk(seq, str, verbose);
   free(str);
@@ -532,11 +548,7 @@ int energy_of_struct_pk(const char *seq, char *structure, int verbose)
 
 int energy_of_struct_pk(const char *seq, short *structure, int verbose)
 {
-  if (P == NULL) {
-    make_pair_matrix();
-    update_fold_params();
-    P = scale_parameters();
-  }
+  get_P();
   short *s0 = encode_sequence(seq, 0);
   short *s1 = encode_sequence(seq, 1);
 
@@ -552,11 +564,7 @@ int energy_of_struct_pk(const char *seq, short *structure, short *s0, short *s1,
 {
   clock_t time = clock();
 
-  if (P == NULL) {
-    make_pair_matrix();
-    update_fold_params();
-    P = scale_parameters();
-  }
+  paramT *P = get_P();
   short *str = structure;
 
   // some debug/helper arrays:
@@ -22,8 +22,29 @@
 #include "ViennaRNA/params/basic.h"
 #ifdef _OPENMP
 #include <omp.h>
+#elif VRNA_WITH_PTHREADS
+#include <unistd.h>
 #endif
 #include "ViennaRNA/2Dfold.h"
+#include "ViennaRNA/dp_matrices_hooks.h"
+
+#include "2Dparallel.inc"
+
+/*
+ *  Check whether the distance class (k,l) lies within the scope of the
+ *  computations, i.e. within maxD1, maxD2 (local copies of the respective
+ *  fold compound attributes) and the band restriction (if any)
+ */
+#define IN_SCOPE(vc, k, l)  (((unsigned int)(k) <= maxD1) && \
+                             ((unsigned int)(l) <= maxD2) && \
+                             (!(vc)->band_l_max || ((int)(l) <= (vc)->band_l_max[(k)])))
+
+/*
+ *  Size of the row pointers in front of a (k,l) matrix block, padded such
+ *  that the subsequent rows of the respective type are properly aligned
+ */
+#define ROW_POINTERS_SIZE(num, type)  ((sizeof(type *) * (size_t)(num) + _Alignof(type) - 1) / \
+                                       _Alignof(type) * _Alignof(type))
 
 /*
  #################################
@@ -43,10 +64,21 @@ int compute_2Dfold_F3 = 0;
  # PRIVATE FUNCTION DECLARATIONS #
  #################################
  */
-PRIVATE void  mfe_linear(vrna_fold_compound_t *vc);
+PRIVATE void  mfe_linear(vrna_fold_compound_t *vc,
+                         twoD_pool_t          *pool);
+
+
+PRIVATE void  mfe_linear_cell(vrna_fold_compound_t  *vc,
+                              unsigned int          i,
+                              unsigned int          j);
 
 
-PRIVATE void  mfe_circ(vrna_fold_compound_t *vc);
+PRIVATE void  mfe_circ(vrna_fold_compound_t *vc,
+                       twoD_pool_t          *pool);
+
+
+PRIVATE void  mfe_circ_M2(void          *data,
+                          unsigned int  idx);
 
 
 PUBLIC void  update_TwoDfold_params(TwoDfold_vars *vars);
@@ -123,15 +155,16 @@ INLINE PRIVATE void  updatePosteriorBoundaries(int  d1,
                                                int  **max_l);
 
 
-INLINE PRIVATE void  prepareBoundaries(int  min_k_pre,
-                                       int  max_k_pre,
-                                       int  min_l_pre,
-                                       int  max_l_pre,
-                                       int  bpdist,
-                                       int  *min_k,
-                                       int  *max_k,
-                                       int  **min_l,
-                                       int  **max_l);
+INLINE PRIVATE void  prepareBoundaries(vrna_fold_compound_t  *vc,
+                                       int                   min_k_pre,
+                                       int                   max_k_pre,
+                                       int                   min_l_pre,
+                                       int                   max_l_pre,
+                                       int                   bpdist,
+                                       int                   *min_k,
+                                       int                   *max_k,
+                                       int                   **min_l,
+                                       int                   **max_l);
 
 
 INLINE PRIVATE void  prepareArray(int ***array,
@@ -267,6 +300,7 @@ vrna_mfe_TwoD(vrna_fold_compound_t  *vars,
   vrna_sol_TwoD_t *output;
   vrna_md_t       *md;
   vrna_mx_mfe_t   *matrices;
+  twoD_pool_t     pool;
 
   maxD1     = vars->maxD1;
   maxD2     = vars->maxD2;
@@ -291,11 +325,20 @@ vrna_mfe_TwoD(vrna_fold_compound_t  *vars,
 
   vars->maxD1 = maxD1;
   vars->maxD2 = maxD2;
-  output      = (vrna_sol_TwoD_t *)vrna_alloc((((vars->maxD1 + 1) * (vars->maxD2 + 2)) / 2 + 2) * sizeof(vrna_sol_TwoD_t));
 
-  mfe_linear(vars);
+  /* the distance classes are allocated on demand, so check their upper bound against the memory budget first */
+  if (!vrna_mx_TwoD_reserve(vars, VRNA_OPTION_MFE))
+    return NULL;
+
+  output = (vrna_sol_TwoD_t *)vrna_alloc((((vars->maxD1 + 1) * (vars->maxD2 + 2)) / 2 + 2) * sizeof(vrna_sol_TwoD_t));
+
+  twoD_pool_init(&pool, vars);
+
+  mfe_linear(vars, &pool);
   if (md->circ)
-    mfe_circ(vars);
+    mfe_circ(vars, &pool);
+
+  twoD_pool_free(&pool);
 
   length = vars->length;
 
@@ -309,6 +352,9 @@ vrna_mfe_TwoD(vrna_fold_compound_t  *vars,
         if (en == INF)
           continue;
 
+        if ((vars->band) && (!vars->band[d1][d2]))
+          continue;
+
         output[counter].k   = d1;
         output[counter].l   = d2;
         output[counter].en  = (float)en / (float)100.;
@@ -379,11 +425,104 @@ vrna_backtrack5_TwoD(vrna_fold_compound_t *vc,
 }
 
 
+PUBLIC int
+vrna_TwoD_set_band(vrna_fold_compound_t     *fc,
+                   vrna_callback_TwoD_band  *in_band,
+                   void                     *data)
+{
+  int           k, l, l_max, num;
+  unsigned char *row;
+
+  if ((!fc) || (!fc->reference_pt1) || (!fc->reference_pt2)) {
+    vrna_message_warning("vrna_TwoD_set_band: "
+                         "fold compound not prepared for distance class computations");
+    return 0;
+  }
+
+  free(fc->band);
+  free(fc->band_l_max);
+  fc->band        = NULL;
+  fc->band_l_max  = NULL;
+
+  if (!in_band)
+    return 1;
+
+  /* row pointers and rows in a single memory block */
+  fc->band = (unsigned char **)vrna_alloc(sizeof(unsigned char *) * (fc->maxD1 + 1) +
+                                          sizeof(unsigned char) * (fc->maxD1 + 1) * (fc->maxD2 + 1));
+  fc->band_l_max  = (int *)vrna_alloc(sizeof(int) * (fc->maxD1 + 1));
+  row             = (unsigned char *)(fc->band + fc->maxD1 + 1);
+
+  for (num = 0, k = 0; k <= (int)fc->maxD1; k++, row += fc->maxD2 + 1) {
+    fc->band[k] = row;
+    for (l = 0; l <= (int)fc->maxD2; l++)
+      if (in_band((unsigned int)k, (unsigned int)l, data)) {
+        row[l] = 1;
+        num++;
+      }
+  }
+
+  if (num == 0) {
+    vrna_message_warning("vrna_TwoD_set_band: "
+                         "band does not contain any distance class");
+    free(fc->band);
+    free(fc->band_l_max);
+    fc->band        = NULL;
+    fc->band_l_max  = NULL;
+    return 0;
+  }
+
+  /* class (k,l) requires all classes (k',l') with k' <= k and l' <= l */
+  for (l_max = -1, k = (int)fc->maxD1; k >= 0; k--) {
+    for (l = (int)fc->maxD2; l > l_max; l--)
+      if (fc->band[k][l]) {
+        l_max = l;
+        break;
+      }
+
+    fc->band_l_max[k] = l_max;
+  }
+
+  return 1;
+}
+
+
+PUBLIC void
+vrna_TwoD_set_num_threads(vrna_fold_compound_t  *fc,
+                          int                   num_threads)
+{
+  if (fc)
+    fc->num_threads = (num_threads > 0) ? num_threads : 0;
+}
+
+
+PUBLIC int
+vrna_TwoD_get_num_threads(vrna_fold_compound_t *fc)
+{
+  if ((fc) && (fc->num_threads > 0))
+    return fc->num_threads;
+
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#elif VRNA_WITH_PTHREADS
+  long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return (num_cores > 0) ? (int)num_cores : 1;
+#else
+  return 1;
+#endif
+}
+
+
 PRIVATE void
-mfe_linear(vrna_fold_compound_t *vc)
+mfe_linear_cell(vrna_fold_compound_t *vc,
+                unsigned int         i,
+                unsigned int         j)
 {
-  unsigned int  d, i, j, ij, maxD1, maxD2, seq_length, dia, dib, dja, djb, *referenceBPs1, *referenceBPs2, *mm1, *mm2, *bpdist;
-  int           cnt1, cnt2, cnt3, cnt4, d1, d2, energy, dangles, temp2, type, additional_en, *my_iindx, *jindx, circ, *rtype;
+  unsigned int  ij, maxD1, maxD2, seq_length, dia, dib, dja, djb, *referenceBPs1, *referenceBPs2, *mm1, *mm2, *bpdist,
+                p, q, pq, u, maxp, dij;
+  int           cnt1, cnt2, cnt3, cnt4, d1, d2, energy, dangles, temp2, type, *my_iindx, *jindx, circ, *rtype,
+                type_2, tt, no_close, base_d1, base_d2;
   short         *S1, *reference_pt1, *reference_pt2;
   char          *sequence, *ptype;
   vrna_param_t  *P;
@@ -413,673 +552,697 @@ mfe_linear(vrna_fold_compound_t *vc)
   dangles       = md->dangles;
   circ          = md->circ;
 
-  for (d = TURN + 2; d <= seq_length; d++) {
-    /* i,j in [1..length] */
-#ifdef _OPENMP
-#pragma omp parallel for private(additional_en, j, energy, temp2, i, ij, dia,dib,dja,djb,cnt1,cnt2,cnt3,cnt4, d1, d2)
-#endif
-    for (j = d; j <= seq_length; j++) {
-      unsigned int  p, q, pq, u, maxp, dij;
-      int           type_2, type, tt, no_close, base_d1, base_d2;
-
-      i     = j - d + 1;
-      dij   = j - i - 1;
-      ij    = my_iindx[i] - j;
-      type  = ptype[jindx[j] + i];
-
-      no_close = (((type == 3) || (type == 4)) && no_closingGU);
-
-      if (type) {
-        /* we have a pair */
-        /* increase or decrease distance-to-reference value depending whether (i,j) is included in
-         *  reference or has to be introduced
-         */
-        base_d1 = ((unsigned int)reference_pt1[i] != j) ? 1 : -1;
-        base_d2 = ((unsigned int)reference_pt2[i] != j) ? 1 : -1;
-
-        /* HAIRPIN STRUCTURES */
-
-        /* get distance to reference if closing the hairpin
-         *  d = dbp(T_{i,j}, {i,j})
-         */
-        d1  = base_d1 + referenceBPs1[ij];
-        d2  = base_d2 + referenceBPs2[ij];
+  dij   = j - i - 1;
+  ij    = my_iindx[i] - j;
+  type  = ptype[jindx[j] + i];
 
-        int min_k, max_k, min_l, max_l;
-        int real_min_k, real_max_k, *min_l_real, *max_l_real;
+  no_close = (((type == 3) || (type == 4)) && no_closingGU);
 
-        min_l = min_k = 0;
-        max_k = mm1[ij] + referenceBPs1[ij];
-        max_l = mm2[ij] + referenceBPs2[ij];
+  if (type) {
+    /* we have a pair */
+    /* increase or decrease distance-to-reference value depending whether (i,j) is included in
+     *  reference or has to be introduced
+     */
+    base_d1 = ((unsigned int)reference_pt1[i] != j) ? 1 : -1;
+    base_d2 = ((unsigned int)reference_pt2[i] != j) ? 1 : -1;
+
+    /* HAIRPIN STRUCTURES */
+
+    /* get distance to reference if closing the hairpin
+     *  d = dbp(T_{i,j}, {i,j})
+     */
+    d1  = base_d1 + referenceBPs1[ij];
+    d2  = base_d2 + referenceBPs2[ij];
+
+    int min_k, max_k, min_l, max_l;
+    int real_min_k, real_max_k, *min_l_real, *max_l_real;
+
+    min_l = min_k = 0;
+    max_k = mm1[ij] + referenceBPs1[ij];
+    max_l = mm2[ij] + referenceBPs2[ij];
+
+    prepareBoundaries(vc,
+                      min_k,
+                      max_k,
+                      min_l,
+                      max_l,
+                      bpdist[ij],
+                      &matrices->k_min_C[ij],
+                      &matrices->k_max_C[ij],
+                      &matrices->l_min_C[ij],
+                      &matrices->l_max_C[ij]
+                      );
 
-        prepareBoundaries(min_k,
-                          max_k,
-                          min_l,
-                          max_l,
-                          bpdist[ij],
-                          &matrices->k_min_C[ij],
-                          &matrices->k_max_C[ij],
-                          &matrices->l_min_C[ij],
-                          &matrices->l_max_C[ij]
-                          );
+    preparePosteriorBoundaries(matrices->k_max_C[ij] - matrices->k_min_C[ij] + 1,
+                               matrices->k_min_C[ij],
+                               &real_min_k,
+                               &real_max_k,
+                               &min_l_real,
+                               &max_l_real
+                               );
 
-        preparePosteriorBoundaries(matrices->k_max_C[ij] - matrices->k_min_C[ij] + 1,
-                                   matrices->k_min_C[ij],
-                                   &real_min_k,
-                                   &real_max_k,
-                                   &min_l_real,
-                                   &max_l_real
-                                   );
-
-        prepareArray(&matrices->E_C[ij],
-                     matrices->k_min_C[ij],
-                     matrices->k_max_C[ij],
-                     matrices->l_min_C[ij],
-                     matrices->l_max_C[ij]
-                     );
+    prepareArray(&matrices->E_C[ij],
+                 matrices->k_min_C[ij],
+                 matrices->k_max_C[ij],
+                 matrices->l_min_C[ij],
+                 matrices->l_max_C[ij]
+                 );
 
 #ifdef COUNT_STATES
-        prepareArray2(&matrices->N_C[ij],
-                      matrices->k_min_C[ij],
-                      matrices->k_max_C[ij],
-                      matrices->l_min_C[ij],
-                      matrices->l_max_C[ij]
-                      );
+    prepareArray2(&matrices->N_C[ij],
+                  matrices->k_min_C[ij],
+                  matrices->k_max_C[ij],
+                  matrices->l_min_C[ij],
+                  matrices->l_max_C[ij]
+                  );
 #endif
 
-        /* d1 and d2 are the distancies to both references introduced by closing a hairpin structure at (i,j) */
-        if ((d1 >= 0) && (d2 >= 0)) {
-          if (((unsigned int)d1 <= maxD1) && ((unsigned int)d2 <= maxD2)) {
-            matrices->E_C[ij][d1][d2 / 2] = (no_close) ? FORBIDDEN : E_Hairpin(dij, type, S1[i + 1], S1[j - 1], sequence + i - 1, P);
-            updatePosteriorBoundaries(d1,
-                                      d2,
-                                      &real_min_k,
-                                      &real_max_k,
-                                      &min_l_real,
-                                      &max_l_real
-                                      );
+    /* d1 and d2 are the distancies to both references introduced by closing a hairpin structure at (i,j) */
+    if ((d1 >= 0) && (d2 >= 0)) {
+      if (IN_SCOPE(vc, d1, d2)) {
+        matrices->E_C[ij][d1][d2 / 2] = (no_close) ? FORBIDDEN : E_Hairpin(dij, type, S1[i + 1], S1[j - 1], sequence + i - 1, P);
+        updatePosteriorBoundaries(d1,
+                                  d2,
+                                  &real_min_k,
+                                  &real_max_k,
+                                  &min_l_real,
+                                  &max_l_real
+                                  );
 #ifdef COUNT_STATES
-            matrices->N_C[ij][d1][d2 / 2] = 1;
+        matrices->N_C[ij][d1][d2 / 2] = 1;
 #endif
-          } else {
-            matrices->E_C_rem[ij] = (no_close) ? FORBIDDEN : E_Hairpin(dij, type, S1[i + 1], S1[j - 1], sequence + i - 1, P);
-          }
-        }
+      } else {
+        matrices->E_C_rem[ij] = (no_close) ? FORBIDDEN : E_Hairpin(dij, type, S1[i + 1], S1[j - 1], sequence + i - 1, P);
+      }
+    }
 
-        /* INTERIOR LOOP STRUCTURES */
-        maxp = MIN2(j - 2 - TURN, i + MAXLOOP + 1);
-        for (p = i + 1; p <= maxp; p++) {
-          unsigned int  minq    = p + TURN + 1;
-          unsigned int  ln_pre  = dij + p;
-          if (ln_pre > minq + MAXLOOP)
-            minq = ln_pre - MAXLOOP - 1;
+    /* INTERIOR LOOP STRUCTURES */
+    maxp = MIN2(j - 2 - TURN, i + MAXLOOP + 1);
+    for (p = i + 1; p <= maxp; p++) {
+      unsigned int  minq    = p + TURN + 1;
+      unsigned int  ln_pre  = dij + p;
+      if (ln_pre > minq + MAXLOOP)
+        minq = ln_pre - MAXLOOP - 1;
 
-          for (q = minq; q < j; q++) {
-            pq = my_iindx[p] - q;
-            /* set distance to reference structure... */
-            type_2 = ptype[jindx[q] + p];
+      for (q = minq; q < j; q++) {
+        pq = my_iindx[p] - q;
+        /* set distance to reference structure... */
+        type_2 = ptype[jindx[q] + p];
 
-            if (type_2 == 0)
+        if (type_2 == 0)
+          continue;
+
+        type_2 = rtype[type_2];
+
+        /* get distance to reference if closing the interior loop
+         *  d2 = dbp(S_{i,j}, S_{p.q} + {i,j})
+         */
+        d1  = base_d1 + referenceBPs1[ij] - referenceBPs1[pq];
+        d2  = base_d2 + referenceBPs2[ij] - referenceBPs2[pq];
+
+        if (no_closingGU)
+          if (no_close || (type_2 == 3) || (type_2 == 4))
+            if ((p > i + 1) || (q < j - 1))
               continue;
 
-            type_2 = rtype[type_2];
+        /* continue unless stack */
 
-            /* get distance to reference if closing the interior loop
-             *  d2 = dbp(S_{i,j}, S_{p.q} + {i,j})
-             */
-            d1  = base_d1 + referenceBPs1[ij] - referenceBPs1[pq];
-            d2  = base_d2 + referenceBPs2[ij] - referenceBPs2[pq];
-
-            if (no_closingGU)
-              if (no_close || (type_2 == 3) || (type_2 == 4))
-                if ((p > i + 1) || (q < j - 1))
-                  continue;
-
-            /* continue unless stack */
-
-            energy = E_IntLoop(p - i - 1, j - q - 1, type, type_2, S1[i + 1], S1[j - 1], S1[p - 1], S1[q + 1], P);
-
-            if (matrices->E_C[pq] != NULL) {
-              for (cnt1 = matrices->k_min_C[pq]; cnt1 <= matrices->k_max_C[pq]; cnt1++) {
-                for (cnt2 = matrices->l_min_C[pq][cnt1]; cnt2 <= matrices->l_max_C[pq][cnt1]; cnt2 += 2) {
-                  if (matrices->E_C[pq][cnt1][cnt2 / 2] != INF) {
-                    if (((cnt1 + d1) <= maxD1) && ((cnt2 + d2) <= maxD2)) {
-                      matrices->E_C[ij][cnt1 + d1][(cnt2 + d2) / 2] = MIN2(matrices->E_C[ij][cnt1 + d1][(cnt2 + d2) / 2],
-                                                                           matrices->E_C[pq][cnt1][cnt2 / 2] + energy
-                                                                           );
-                      updatePosteriorBoundaries(cnt1 + d1,
-                                                cnt2 + d2,
-                                                &real_min_k,
-                                                &real_max_k,
-                                                &min_l_real,
-                                                &max_l_real
-                                                );
+        energy = E_IntLoop(p - i - 1, j - q - 1, type, type_2, S1[i + 1], S1[j - 1], S1[p - 1], S1[q + 1], P);
+
+        if (matrices->E_C[pq] != NULL) {
+          for (cnt1 = matrices->k_min_C[pq]; cnt1 <= matrices->k_max_C[pq]; cnt1++) {
+            for (cnt2 = matrices->l_min_C[pq][cnt1]; cnt2 <= matrices->l_max_C[pq][cnt1]; cnt2 += 2) {
+              if (matrices->E_C[pq][cnt1][cnt2 / 2] != INF) {
+                if (IN_SCOPE(vc, cnt1 + d1, cnt2 + d2)) {
+                  matrices->E_C[ij][cnt1 + d1][(cnt2 + d2) / 2] = MIN2(matrices->E_C[ij][cnt1 + d1][(cnt2 + d2) / 2],
+                                                                       matrices->E_C[pq][cnt1][cnt2 / 2] + energy
+                                                                       );
+                  updatePosteriorBoundaries(cnt1 + d1,
+                                            cnt2 + d2,
+                                            &real_min_k,
+                                            &real_max_k,
+                                            &min_l_real,
+                                            &max_l_real
+                                            );
 #ifdef COUNT_STATES
-                      matrices->N_C[ij][cnt1 + d1][(cnt2 + d2) / 2] += matrices->N_C[pq][cnt1][cnt2 / 2];
+                  matrices->N_C[ij][cnt1 + d1][(cnt2 + d2) / 2] += matrices->N_C[pq][cnt1][cnt2 / 2];
 #endif
-                    }
-                    /* collect all cases where d1+cnt1 or d2+cnt2 exceeds maxD1, maxD2, respectively */
-                    else {
-                      matrices->E_C_rem[ij] = MIN2(matrices->E_C_rem[ij], matrices->E_C[pq][cnt1][cnt2 / 2] + energy);
-                    }
-                  }
+                }
+                /* collect all cases where d1+cnt1 or d2+cnt2 exceeds maxD1, maxD2, respectively */
+                else {
+                  matrices->E_C_rem[ij] = MIN2(matrices->E_C_rem[ij], matrices->E_C[pq][cnt1][cnt2 / 2] + energy);
                 }
               }
             }
+          }
+        }
 
-            /* collect all contributions where C[pq] already lies outside k_max, l_max boundary */
-            if (matrices->E_C_rem[pq] != INF)
-              matrices->E_C_rem[ij] = MIN2(matrices->E_C_rem[ij], matrices->E_C_rem[pq] + energy);
-          } /* end q-loop */
-        }   /* end p-loop */
+        /* collect all contributions where C[pq] already lies outside k_max, l_max boundary */
+        if (matrices->E_C_rem[pq] != INF)
+          matrices->E_C_rem[ij] = MIN2(matrices->E_C_rem[ij], matrices->E_C_rem[pq] + energy);
+      } /* end q-loop */
+    }   /* end p-loop */
 
 
-        /* MULTI LOOP STRUCTURES */
-        if (!no_close) {
-          /* dangle energies for multiloop closing stem */
-          tt    = rtype[type];
-          temp2 = P->MLclosing;
-          if (dangles == 2)
-            temp2 += E_MLstem(tt, S1[j - 1], S1[i + 1], P);
-          else
-            temp2 += E_MLstem(tt, -1, -1, P);
-
-          for (u = i + TURN + 2; u < j - TURN - 2; u++) {
-            int i1u   = my_iindx[i + 1] - u;
-            int u1j1  = my_iindx[u + 1] - j + 1;
-            /* check all cases where either M or M1 are already out of scope of maxD1 and/or maxD2 */
-            if (matrices->E_M_rem[i1u] != INF) {
-              for (cnt3 = matrices->k_min_M1[u1j1];
-                   cnt3 <= matrices->k_max_M1[u1j1];
-                   cnt3++)
-                for (cnt4 = matrices->l_min_M1[u1j1][cnt3];
-                     cnt4 <= matrices->l_max_M1[u1j1][cnt3];
-                     cnt4 += 2) {
-                  if (matrices->E_M1[u1j1][cnt3][cnt4 / 2] != INF) {
-                    matrices->E_C_rem[ij] = MIN2(matrices->E_C_rem[ij],
-                                                 matrices->E_M_rem[i1u]
-                                                 + matrices->E_M1[u1j1][cnt3][cnt4 / 2]
-                                                 + temp2
-                                                 );
-                  }
-                }
-              if (matrices->E_M1_rem[u1j1] != INF) {
+    /* MULTI LOOP STRUCTURES */
+    if (!no_close) {
+      /* dangle energies for multiloop closing stem */
+      tt    = rtype[type];
+      temp2 = P->MLclosing;
+      if (dangles == 2)
+        temp2 += E_MLstem(tt, S1[j - 1], S1[i + 1], P);
+      else
+        temp2 += E_MLstem(tt, -1, -1, P);
+
+      for (u = i + TURN + 2; u < j - TURN - 2; u++) {
+        int i1u   = my_iindx[i + 1] - u;
+        int u1j1  = my_iindx[u + 1] - j + 1;
+        /* check all cases where either M or M1 are already out of scope of maxD1 and/or maxD2 */
+        if (matrices->E_M_rem[i1u] != INF) {
+          for (cnt3 = matrices->k_min_M1[u1j1];
+               cnt3 <= matrices->k_max_M1[u1j1];
+               cnt3++)
+            for (cnt4 = matrices->l_min_M1[u1j1][cnt3];
+                 cnt4 <= matrices->l_max_M1[u1j1][cnt3];
+                 cnt4 += 2) {
+              if (matrices->E_M1[u1j1][cnt3][cnt4 / 2] != INF) {
                 matrices->E_C_rem[ij] = MIN2(matrices->E_C_rem[ij],
                                              matrices->E_M_rem[i1u]
-                                             + matrices->E_M1_rem[u1j1]
+                                             + matrices->E_M1[u1j1][cnt3][cnt4 / 2]
                                              + temp2
                                              );
               }
             }
+          if (matrices->E_M1_rem[u1j1] != INF) {
+            matrices->E_C_rem[ij] = MIN2(matrices->E_C_rem[ij],
+                                         matrices->E_M_rem[i1u]
+                                         + matrices->E_M1_rem[u1j1]
+                                         + temp2
+                                         );
+          }
+        }
 
-            if (matrices->E_M1_rem[u1j1] != INF) {
-              for (cnt1 = matrices->k_min_M[i1u];
-                   cnt1 <= matrices->k_max_M[i1u];
-                   cnt1++)
-                for (cnt2 = matrices->l_min_M[i1u][cnt1];
-                     cnt2 <= matrices->l_max_M[i1u][cnt1];
-                     cnt2 += 2)
-                  if (matrices->E_M[i1u][cnt1][cnt2 / 2] != INF) {
-                    matrices->E_C_rem[ij] = MIN2(matrices->E_C_rem[ij],
-                                                 matrices->E_M[i1u][cnt1][cnt2 / 2]
-                                                 + matrices->E_M1_rem[u1j1]
-                                                 + temp2
-                                                 );
-                  }
-            }
+        if (matrices->E_M1_rem[u1j1] != INF) {
+          for (cnt1 = matrices->k_min_M[i1u];
+               cnt1 <= matrices->k_max_M[i1u];
+               cnt1++)
+            for (cnt2 = matrices->l_min_M[i1u][cnt1];
+                 cnt2 <= matrices->l_max_M[i1u][cnt1];
+                 cnt2 += 2)
+              if (matrices->E_M[i1u][cnt1][cnt2 / 2] != INF) {
+                matrices->E_C_rem[ij] = MIN2(matrices->E_C_rem[ij],
+                                             matrices->E_M[i1u][cnt1][cnt2 / 2]
+                                             + matrices->E_M1_rem[u1j1]
+                                             + temp2
+                                             );
+              }
+        }
 
-            /* get distance to reference if closing the multiloop
-             *  d = dbp(S_{i,j}, {i,j} + S_{i+1,u} + S_{u+1,j-1})
-             */
-            if (!matrices->E_M[i1u])
-              continue;
+        /* get distance to reference if closing the multiloop
+         *  d = dbp(S_{i,j}, {i,j} + S_{i+1,u} + S_{u+1,j-1})
+         */
+        if (!matrices->E_M[i1u])
+          continue;
 
-            if (!matrices->E_M1[u1j1])
-              continue;
+        if (!matrices->E_M1[u1j1])
+          continue;
 
-            d1  = base_d1 + referenceBPs1[ij] - referenceBPs1[i1u] - referenceBPs1[u1j1];
-            d2  = base_d2 + referenceBPs2[ij] - referenceBPs2[i1u] - referenceBPs2[u1j1];
+        d1  = base_d1 + referenceBPs1[ij] - referenceBPs1[i1u] - referenceBPs1[u1j1];
+        d2  = base_d2 + referenceBPs2[ij] - referenceBPs2[i1u] - referenceBPs2[u1j1];
 
-            for (cnt1 = matrices->k_min_M[i1u];
-                 cnt1 <= matrices->k_max_M[i1u];
-                 cnt1++)
-              for (cnt2 = matrices->l_min_M[i1u][cnt1];
-                   cnt2 <= matrices->l_max_M[i1u][cnt1];
-                   cnt2 += 2)
-                for (cnt3 = matrices->k_min_M1[u1j1];
-                     cnt3 <= matrices->k_max_M1[u1j1];
-                     cnt3++)
-                  for (cnt4 = matrices->l_min_M1[u1j1][cnt3];
-                       cnt4 <= matrices->l_max_M1[u1j1][cnt3];
-                       cnt4 += 2) {
-                    if ((matrices->E_M[i1u][cnt1][cnt2 / 2] != INF) && (matrices->E_M1[u1j1][cnt3][cnt4 / 2] != INF)) {
-                      if (((cnt1 + cnt3 + d1) <= maxD1) && ((cnt2 + cnt4 + d2) <= maxD2)) {
-                        matrices->E_C[ij][cnt1 + cnt3 + d1][(cnt2 + cnt4 + d2) / 2] = MIN2(matrices->E_C[ij][cnt1 + cnt3 + d1][(cnt2 + cnt4 + d2) / 2],
-                                                                                           matrices->E_M[i1u][cnt1][cnt2 / 2]
-                                                                                           + matrices->E_M1[u1j1][cnt3][cnt4 / 2]
-                                                                                           + temp2
-                                                                                           );
-                        updatePosteriorBoundaries(cnt1 + cnt3 + d1,
-                                                  cnt2 + cnt4 + d2,
-                                                  &real_min_k,
-                                                  &real_max_k,
-                                                  &min_l_real,
-                                                  &max_l_real
-                                                  );
+        for (cnt1 = matrices->k_min_M[i1u];
+             cnt1 <= matrices->k_max_M[i1u];
+             cnt1++)
+          for (cnt2 = matrices->l_min_M[i1u][cnt1];
+               cnt2 <= matrices->l_max_M[i1u][cnt1];
+               cnt2 += 2)
+            for (cnt3 = matrices->k_min_M1[u1j1];
+                 cnt3 <= matrices->k_max_M1[u1j1];
+                 cnt3++)
+              for (cnt4 = matrices->l_min_M1[u1j1][cnt3];
+                   cnt4 <= matrices->l_max_M1[u1j1][cnt3];
+                   cnt4 += 2) {
+                if ((matrices->E_M[i1u][cnt1][cnt2 / 2] != INF) && (matrices->E_M1[u1j1][cnt3][cnt4 / 2] != INF)) {
+                  if (IN_SCOPE(vc, cnt1 + cnt3 + d1, cnt2 + cnt4 + d2)) {
+                    matrices->E_C[ij][cnt1 + cnt3 + d1][(cnt2 + cnt4 + d2) / 2] = MIN2(matrices->E_C[ij][cnt1 + cnt3 + d1][(cnt2 + cnt4 + d2) / 2],
+                                                                                       matrices->E_M[i1u][cnt1][cnt2 / 2]
+                                                                                       + matrices->E_M1[u1j1][cnt3][cnt4 / 2]
+                                                                                       + temp2
+                                                                                       );
+                    updatePosteriorBoundaries(cnt1 + cnt3 + d1,
+                                              cnt2 + cnt4 + d2,
+                                              &real_min_k,
+                                              &real_max_k,
+                                              &min_l_real,
+                                              &max_l_real
+                                              );
 #ifdef COUNT_STATES
-                        matrices->N_C[ij][cnt1 + cnt3 + d1][(cnt2 + cnt4 + d2) / 2] += matrices->N_M[i1u][cnt1][cnt2 / 2] * matrices->N_M1[u1j1][cnt3][cnt4 / 2];
+                    matrices->N_C[ij][cnt1 + cnt3 + d1][(cnt2 + cnt4 + d2) / 2] += matrices->N_M[i1u][cnt1][cnt2 / 2] * matrices->N_M1[u1j1][cnt3][cnt4 / 2];
 #endif
-                      }
-                      /* collect all cases where d1+cnt1+cnt3 or d2+cnt2+cnt4 exceeds maxD1, maxD2, respectively */
-                      else {
-                        matrices->E_C_rem[ij] = MIN2(matrices->E_C_rem[ij],
-                                                     matrices->E_M[i1u][cnt1][cnt2 / 2]
-                                                     + matrices->E_M1[u1j1][cnt3][cnt4 / 2]
-                                                     + temp2
-                                                     );
-                      }
-                    }
                   }
-          }
-        }
+                  /* collect all cases where d1+cnt1+cnt3 or d2+cnt2+cnt4 exceeds maxD1, maxD2, respectively */
+                  else {
+                    matrices->E_C_rem[ij] = MIN2(matrices->E_C_rem[ij],
+                                                 matrices->E_M[i1u][cnt1][cnt2 / 2]
+                                                 + matrices->E_M1[u1j1][cnt3][cnt4 / 2]
+                                                 + temp2
+                                                 );
+                  }
+                }
+              }
+      }
+    }
 
-        /* resize and move memory portions of energy matrix E_C */
-        adjustArrayBoundaries(&matrices->E_C[ij],
-                              &matrices->k_min_C[ij],
-                              &matrices->k_max_C[ij],
-                              &matrices->l_min_C[ij],
-                              &matrices->l_max_C[ij],
-                              real_min_k,
-                              real_max_k,
-                              min_l_real,
-                              max_l_real
-                              );
+    /* resize and move memory portions of energy matrix E_C */
+    adjustArrayBoundaries(&matrices->E_C[ij],
+                          &matrices->k_min_C[ij],
+                          &matrices->k_max_C[ij],
+                          &matrices->l_min_C[ij],
+                          &matrices->l_max_C[ij],
+                          real_min_k,
+                          real_max_k,
+                          min_l_real,
+                          max_l_real
+                          );
 #ifdef COUNT_STATES
-        /* actually we should adjust the array boundaries here but we might never use the count states option more than once so what....*/
+    /* actually we should adjust the array boundaries here but we might never use the count states option more than once so what....*/
 #endif
-      } /* end >> if (pair) << */
+  } /* end >> if (pair) << */
 
-      /* done with c[i,j], now compute fML[i,j] */
-      /* free ends ? -----------------------------------------*/
+  /* done with c[i,j], now compute fML[i,j] */
+  /* free ends ? -----------------------------------------*/
 
 
-      dia = referenceBPs1[ij] - referenceBPs1[my_iindx[i + 1] - j];
-      dib = referenceBPs2[ij] - referenceBPs2[my_iindx[i + 1] - j];
-      dja = referenceBPs1[ij] - referenceBPs1[ij + 1];
-      djb = referenceBPs2[ij] - referenceBPs2[ij + 1];
+  dia = referenceBPs1[ij] - referenceBPs1[my_iindx[i + 1] - j];
+  dib = referenceBPs2[ij] - referenceBPs2[my_iindx[i + 1] - j];
+  dja = referenceBPs1[ij] - referenceBPs1[ij + 1];
+  djb = referenceBPs2[ij] - referenceBPs2[ij + 1];
 
-      if (dangles == 2)
-        temp2 = E_MLstem(type, ((i > 1) || circ) ? S1[i - 1] : -1, ((j < seq_length) || circ) ? S1[j + 1] : -1, P);
-      else
-        temp2 = E_MLstem(type, -1, -1, P);
-
-      int min_k_guess, max_k_guess, min_l_guess, max_l_guess;
-      int min_k_real_m, max_k_real_m, *min_l_real_m, *max_l_real_m;
-      int min_k_real_m1, max_k_real_m1, *min_l_real_m1, *max_l_real_m1;
-
-      min_k_guess = min_l_guess = 0;
-      max_k_guess = mm1[ij] + referenceBPs1[ij];
-      max_l_guess = mm2[ij] + referenceBPs2[ij];
-
-      prepareBoundaries(min_k_guess,
-                        max_k_guess,
-                        min_l_guess,
-                        max_l_guess,
-                        bpdist[ij],
-                        &matrices->k_min_M[ij],
-                        &matrices->k_max_M[ij],
-                        &matrices->l_min_M[ij],
-                        &matrices->l_max_M[ij]
-                        );
+  if (dangles == 2)
+    temp2 = E_MLstem(type, ((i > 1) || circ) ? S1[i - 1] : -1, ((j < seq_length) || circ) ? S1[j + 1] : -1, P);
+  else
+    temp2 = E_MLstem(type, -1, -1, P);
+
+  int min_k_guess, max_k_guess, min_l_guess, max_l_guess;
+  int min_k_real_m, max_k_real_m, *min_l_real_m, *max_l_real_m;
+  int min_k_real_m1, max_k_real_m1, *min_l_real_m1, *max_l_real_m1;
+
+  min_k_guess = min_l_guess = 0;
+  max_k_guess = mm1[ij] + referenceBPs1[ij];
+  max_l_guess = mm2[ij] + referenceBPs2[ij];
+
+  prepareBoundaries(vc,
+                    min_k_guess,
+                    max_k_guess,
+                    min_l_guess,
+                    max_l_guess,
+                    bpdist[ij],
+                    &matrices->k_min_M[ij],
+                    &matrices->k_max_M[ij],
+                    &matrices->l_min_M[ij],
+                    &matrices->l_max_M[ij]
+                    );
 
-      prepareBoundaries(min_k_guess,
-                        max_k_guess,
-                        min_l_guess,
-                        max_l_guess,
-                        bpdist[ij],
-                        &matrices->k_min_M1[ij],
-                        &matrices->k_max_M1[ij],
-                        &matrices->l_min_M1[ij],
-                        &matrices->l_max_M1[ij]
-                        );
+  prepareBoundaries(vc,
+                    min_k_guess,
+                    max_k_guess,
+                    min_l_guess,
+                    max_l_guess,
+                    bpdist[ij],
+                    &matrices->k_min_M1[ij],
+                    &matrices->k_max_M1[ij],
+                    &matrices->l_min_M1[ij],
+                    &matrices->l_max_M1[ij]
+                    );
 
-      preparePosteriorBoundaries(matrices->k_max_M[ij] - matrices->k_min_M[ij] + 1,
-                                 matrices->k_min_M[ij],
-                                 &min_k_real_m,
-                                 &max_k_real_m,
-                                 &min_l_real_m,
-                                 &max_l_real_m
-                                 );
-      preparePosteriorBoundaries(matrices->k_max_M1[ij] - matrices->k_min_M1[ij] + 1,
-                                 matrices->k_min_M1[ij],
-                                 &min_k_real_m1,
-                                 &max_k_real_m1,
-                                 &min_l_real_m1,
-                                 &max_l_real_m1
-                                 );
+  preparePosteriorBoundaries(matrices->k_max_M[ij] - matrices->k_min_M[ij] + 1,
+                             matrices->k_min_M[ij],
+                             &min_k_real_m,
+                             &max_k_real_m,
+                             &min_l_real_m,
+                             &max_l_real_m
+                             );
+  preparePosteriorBoundaries(matrices->k_max_M1[ij] - matrices->k_min_M1[ij] + 1,
+                             matrices->k_min_M1[ij],
+                             &min_k_real_m1,
+                             &max_k_real_m1,
+                             &min_l_real_m1,
+                             &max_l_real_m1
+                             );
 
-      prepareArray(&matrices->E_M[ij],
-                   matrices->k_min_M[ij],
-                   matrices->k_max_M[ij],
-                   matrices->l_min_M[ij],
-                   matrices->l_max_M[ij]
-                   );
+  prepareArray(&matrices->E_M[ij],
+               matrices->k_min_M[ij],
+               matrices->k_max_M[ij],
+               matrices->l_min_M[ij],
+               matrices->l_max_M[ij]
+               );
 
-      prepareArray(&matrices->E_M1[ij],
-                   matrices->k_min_M1[ij],
-                   matrices->k_max_M1[ij],
-                   matrices->l_min_M1[ij],
-                   matrices->l_max_M1[ij]
-                   );
+  prepareArray(&matrices->E_M1[ij],
+               matrices->k_min_M1[ij],
+               matrices->k_max_M1[ij],
+               matrices->l_min_M1[ij],
+               matrices->l_max_M1[ij]
+               );
 #ifdef COUNT_STATES
-      prepareArray2(&matrices->N_M[ij],
-                    matrices->k_min_M[ij],
-                    matrices->k_max_M[ij],
-                    matrices->l_min_M[ij],
-                    matrices->l_max_M[ij]
-                    );
-      prepareArray2(&matrices->N_M1[ij],
-                    matrices->k_min_M1[ij],
-                    matrices->k_max_M1[ij],
-                    matrices->l_min_M1[ij],
-                    matrices->l_max_M1[ij]
-                    );
+  prepareArray2(&matrices->N_M[ij],
+                matrices->k_min_M[ij],
+                matrices->k_max_M[ij],
+                matrices->l_min_M[ij],
+                matrices->l_max_M[ij]
+                );
+  prepareArray2(&matrices->N_M1[ij],
+                matrices->k_min_M1[ij],
+                matrices->k_max_M1[ij],
+                matrices->l_min_M1[ij],
+                matrices->l_max_M1[ij]
+                );
 #endif
 
-      /* now to the actual computations... */
-      /* 1st E_M[ij] = E_M1[ij] = E_C[ij] + b */
-      if (matrices->E_C_rem[ij] != INF)
-        matrices->E_M_rem[ij] = matrices->E_M1_rem[ij] = temp2 + matrices->E_C_rem[ij];
-
-      if (matrices->E_C[ij]) {
-        for (cnt1 = matrices->k_min_C[ij]; cnt1 <= matrices->k_max_C[ij]; cnt1++) {
-          for (cnt2 = matrices->l_min_C[ij][cnt1]; cnt2 <= matrices->l_max_C[ij][cnt1]; cnt2 += 2) {
-            if (matrices->E_C[ij][cnt1][cnt2 / 2] != INF) {
-              matrices->E_M[ij][cnt1][cnt2 / 2] = matrices->E_M1[ij][cnt1][cnt2 / 2] = temp2 + matrices->E_C[ij][cnt1][cnt2 / 2];
-              updatePosteriorBoundaries(cnt1,
-                                        cnt2,
-                                        &min_k_real_m,
-                                        &max_k_real_m,
-                                        &min_l_real_m,
-                                        &max_l_real_m
-                                        );
-              updatePosteriorBoundaries(cnt1,
-                                        cnt2,
-                                        &min_k_real_m1,
-                                        &max_k_real_m1,
-                                        &min_l_real_m1,
-                                        &max_l_real_m1
-                                        );
+  /* now to the actual computations... */
+  /* 1st E_M[ij] = E_M1[ij] = E_C[ij] + b */
+  if (matrices->E_C_rem[ij] != INF)
+    matrices->E_M_rem[ij] = matrices->E_M1_rem[ij] = temp2 + matrices->E_C_rem[ij];
+
+  if (matrices->E_C[ij]) {
+    for (cnt1 = matrices->k_min_C[ij]; cnt1 <= matrices->k_max_C[ij]; cnt1++) {
+      for (cnt2 = matrices->l_min_C[ij][cnt1]; cnt2 <= matrices->l_max_C[ij][cnt1]; cnt2 += 2) {
+        if (matrices->E_C[ij][cnt1][cnt2 / 2] != INF) {
+          matrices->E_M[ij][cnt1][cnt2 / 2] = matrices->E_M1[ij][cnt1][cnt2 / 2] = temp2 + matrices->E_C[ij][cnt1][cnt2 / 2];
+          updatePosteriorBoundaries(cnt1,
+                                    cnt2,
+                                    &min_k_real_m,
+                                    &max_k_real_m,
+                                    &min_l_real_m,
+                                    &max_l_real_m
+                                    );
+          updatePosteriorBoundaries(cnt1,
+                                    cnt2,
+                                    &min_k_real_m1,
+                                    &max_k_real_m1,
+                                    &min_l_real_m1,
+                                    &max_l_real_m1
+                                    );
 #ifdef COUNT_STATES
-              matrices->N_M[ij][cnt1][cnt2 / 2] = matrices->N_M1[ij][cnt1][cnt2 / 2] = matrices->N_C[ij][cnt1][cnt2 / 2];
+          matrices->N_M[ij][cnt1][cnt2 / 2] = matrices->N_M1[ij][cnt1][cnt2 / 2] = matrices->N_C[ij][cnt1][cnt2 / 2];
 #endif
-            }
-          }
         }
       }
+    }
+  }
 
-      /* 2nd E_M[ij] = MIN(E_M[ij], E_M[i+1,j] + c) */
-      if (matrices->E_M_rem[my_iindx[i + 1] - j] != INF) {
-        matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
-                                     matrices->E_M_rem[my_iindx[i + 1] - j] + P->MLbase
-                                     );
-      }
+  /* 2nd E_M[ij] = MIN(E_M[ij], E_M[i+1,j] + c) */
+  if (matrices->E_M_rem[my_iindx[i + 1] - j] != INF) {
+    matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
+                                 matrices->E_M_rem[my_iindx[i + 1] - j] + P->MLbase
+                                 );
+  }
 
-      if (matrices->E_M[my_iindx[i + 1] - j]) {
-        for (cnt1 = matrices->k_min_M[my_iindx[i + 1] - j];
-             cnt1 <= matrices->k_max_M[my_iindx[i + 1] - j];
-             cnt1++) {
-          for (cnt2 = matrices->l_min_M[my_iindx[i + 1] - j][cnt1];
-               cnt2 <= matrices->l_max_M[my_iindx[i + 1] - j][cnt1];
-               cnt2 += 2) {
-            if (matrices->E_M[my_iindx[i + 1] - j][cnt1][cnt2 / 2] != INF) {
-              if (((cnt1 + dia) <= maxD1) && ((cnt2 + dib) <= maxD2)) {
-                matrices->E_M[ij][cnt1 + dia][(cnt2 + dib) / 2] = MIN2(matrices->E_M[ij][cnt1 + dia][(cnt2 + dib) / 2],
-                                                                       matrices->E_M[my_iindx[i + 1] - j][cnt1][cnt2 / 2] + P->MLbase
-                                                                       );
-                updatePosteriorBoundaries(cnt1 + dia,
-                                          cnt2 + dib,
-                                          &min_k_real_m,
-                                          &max_k_real_m,
-                                          &min_l_real_m,
-                                          &max_l_real_m
-                                          );
+  if (matrices->E_M[my_iindx[i + 1] - j]) {
+    for (cnt1 = matrices->k_min_M[my_iindx[i + 1] - j];
+         cnt1 <= matrices->k_max_M[my_iindx[i + 1] - j];
+         cnt1++) {
+      for (cnt2 = matrices->l_min_M[my_iindx[i + 1] - j][cnt1];
+           cnt2 <= matrices->l_max_M[my_iindx[i + 1] - j][cnt1];
+           cnt2 += 2) {
+        if (matrices->E_M[my_iindx[i + 1] - j][cnt1][cnt2 / 2] != INF) {
+          if (IN_SCOPE(vc, cnt1 + dia, cnt2 + dib)) {
+            matrices->E_M[ij][cnt1 + dia][(cnt2 + dib) / 2] = MIN2(matrices->E_M[ij][cnt1 + dia][(cnt2 + dib) / 2],
+                                                                   matrices->E_M[my_iindx[i + 1] - j][cnt1][cnt2 / 2] + P->MLbase
+                                                                   );
+            updatePosteriorBoundaries(cnt1 + dia,
+                                      cnt2 + dib,
+                                      &min_k_real_m,
+                                      &max_k_real_m,
+                                      &min_l_real_m,
+                                      &max_l_real_m
+                                      );
 #ifdef COUNT_STATES
-                matrices->N_M[ij][cnt1 + dia][(cnt2 + dib) / 2] += matrices->N_M[my_iindx[i + 1] - j][cnt1][cnt2 / 2];
+            matrices->N_M[ij][cnt1 + dia][(cnt2 + dib) / 2] += matrices->N_M[my_iindx[i + 1] - j][cnt1][cnt2 / 2];
 #endif
-              }
-              /* collect all cases where dia+cnt1 or dib+cnt2 exceeds maxD1, maxD2, respectively */
-              else {
-                matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
-                                             matrices->E_M[my_iindx[i + 1] - j][cnt1][cnt2 / 2] + P->MLbase
-                                             );
-              }
-            }
+          }
+          /* collect all cases where dia+cnt1 or dib+cnt2 exceeds maxD1, maxD2, respectively */
+          else {
+            matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
+                                         matrices->E_M[my_iindx[i + 1] - j][cnt1][cnt2 / 2] + P->MLbase
+                                         );
           }
         }
       }
+    }
+  }
 
-      /* 3rd E_M[ij] = MIN(E_M[ij], E_M[i,j-1] + c) */
-      if (matrices->E_M_rem[ij + 1] != INF) {
-        matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
-                                     matrices->E_M_rem[ij + 1] + P->MLbase
-                                     );
-      }
+  /* 3rd E_M[ij] = MIN(E_M[ij], E_M[i,j-1] + c) */
+  if (matrices->E_M_rem[ij + 1] != INF) {
+    matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
+                                 matrices->E_M_rem[ij + 1] + P->MLbase
+                                 );
+  }
 
-      if (matrices->E_M[ij + 1]) {
-        for (cnt1 = matrices->k_min_M[ij + 1];
-             cnt1 <= matrices->k_max_M[ij + 1];
-             cnt1++) {
-          for (cnt2 = matrices->l_min_M[ij + 1][cnt1];
-               cnt2 <= matrices->l_max_M[ij + 1][cnt1];
-               cnt2 += 2) {
-            if (matrices->E_M[ij + 1][cnt1][cnt2 / 2] != INF) {
-              if (((cnt1 + dja) <= maxD1) && ((cnt2 + djb) <= maxD2)) {
-                matrices->E_M[ij][cnt1 + dja][(cnt2 + djb) / 2] = MIN2(matrices->E_M[ij][cnt1 + dja][(cnt2 + djb) / 2],
-                                                                       matrices->E_M[ij + 1][cnt1][cnt2 / 2] + P->MLbase
-                                                                       );
-                updatePosteriorBoundaries(cnt1 + dja,
-                                          cnt2 + djb,
-                                          &min_k_real_m,
-                                          &max_k_real_m,
-                                          &min_l_real_m,
-                                          &max_l_real_m
-                                          );
+  if (matrices->E_M[ij + 1]) {
+    for (cnt1 = matrices->k_min_M[ij + 1];
+         cnt1 <= matrices->k_max_M[ij + 1];
+         cnt1++) {
+      for (cnt2 = matrices->l_min_M[ij + 1][cnt1];
+           cnt2 <= matrices->l_max_M[ij + 1][cnt1];
+           cnt2 += 2) {
+        if (matrices->E_M[ij + 1][cnt1][cnt2 / 2] != INF) {
+          if (IN_SCOPE(vc, cnt1 + dja, cnt2 + djb)) {
+            matrices->E_M[ij][cnt1 + dja][(cnt2 + djb) / 2] = MIN2(matrices->E_M[ij][cnt1 + dja][(cnt2 + djb) / 2],
+                                                                   matrices->E_M[ij + 1][cnt1][cnt2 / 2] + P->MLbase
+                                                                   );
+            updatePosteriorBoundaries(cnt1 + dja,
+                                      cnt2 + djb,
+                                      &min_k_real_m,
+                                      &max_k_real_m,
+                                      &min_l_real_m,
+                                      &max_l_real_m
+                                      );
 #ifdef COUNT_STATES
-                matrices->N_M[ij][cnt1 + dja][(cnt2 + djb) / 2] += matrices->N_M[ij + 1][cnt1][cnt2 / 2];
+            matrices->N_M[ij][cnt1 + dja][(cnt2 + djb) / 2] += matrices->N_M[ij + 1][cnt1][cnt2 / 2];
 #endif
-              }
-              /* collect all cases where dja+cnt1 or djb+cnt2 exceeds maxD1, maxD2, respectively */
-              else {
-                matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
-                                             matrices->E_M[ij + 1][cnt1][cnt2 / 2] + P->MLbase
-                                             );
-              }
-            }
+          }
+          /* collect all cases where dja+cnt1 or djb+cnt2 exceeds maxD1, maxD2, respectively */
+          else {
+            matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
+                                         matrices->E_M[ij + 1][cnt1][cnt2 / 2] + P->MLbase
+                                         );
           }
         }
       }
+    }
+  }
 
-      /* 4th E_M1[ij] = MIN(E_M1[ij], E_M1[i,j-1] + c) */
-      if (matrices->E_M1_rem[ij + 1] != INF) {
-        matrices->E_M1_rem[ij] = MIN2(matrices->E_M1_rem[ij],
-                                      matrices->E_M1_rem[ij + 1] + P->MLbase
-                                      );
-      }
+  /* 4th E_M1[ij] = MIN(E_M1[ij], E_M1[i,j-1] + c) */
+  if (matrices->E_M1_rem[ij + 1] != INF) {
+    matrices->E_M1_rem[ij] = MIN2(matrices->E_M1_rem[ij],
+                                  matrices->E_M1_rem[ij + 1] + P->MLbase
+                                  );
+  }
 
-      if (matrices->E_M1[ij + 1]) {
-        for (cnt1 = matrices->k_min_M1[ij + 1];
-             cnt1 <= matrices->k_max_M1[ij + 1];
-             cnt1++) {
-          for (cnt2 = matrices->l_min_M1[ij + 1][cnt1];
-               cnt2 <= matrices->l_max_M1[ij + 1][cnt1];
-               cnt2 += 2) {
-            if (matrices->E_M1[ij + 1][cnt1][cnt2 / 2] != INF) {
-              if (((cnt1 + dja) <= maxD1) && ((cnt2 + djb) <= maxD2)) {
-                matrices->E_M1[ij][cnt1 + dja][(cnt2 + djb) / 2] = MIN2(matrices->E_M1[ij][cnt1 + dja][(cnt2 + djb) / 2],
-                                                                        matrices->E_M1[ij + 1][cnt1][cnt2 / 2] + P->MLbase
-                                                                        );
-                updatePosteriorBoundaries(cnt1 + dja,
-                                          cnt2 + djb,
-                                          &min_k_real_m1,
-                                          &max_k_real_m1,
-                                          &min_l_real_m1,
-                                          &max_l_real_m1
-                                          );
+  if (matrices->E_M1[ij + 1]) {
+    for (cnt1 = matrices->k_min_M1[ij + 1];
+         cnt1 <= matrices->k_max_M1[ij + 1];
+         cnt1++) {
+      for (cnt2 = matrices->l_min_M1[ij + 1][cnt1];
+           cnt2 <= matrices->l_max_M1[ij + 1][cnt1];
+           cnt2 += 2) {
+        if (matrices->E_M1[ij + 1][cnt1][cnt2 / 2] != INF) {
+          if (IN_SCOPE(vc, cnt1 + dja, cnt2 + djb)) {
+            matrices->E_M1[ij][cnt1 + dja][(cnt2 + djb) / 2] = MIN2(matrices->E_M1[ij][cnt1 + dja][(cnt2 + djb) / 2],
+                                                                    matrices->E_M1[ij + 1][cnt1][cnt2 / 2] + P->MLbase
+                                                                    );
+            updatePosteriorBoundaries(cnt1 + dja,
+                                      cnt2 + djb,
+                                      &min_k_real_m1,
+                                      &max_k_real_m1,
+                                      &min_l_real_m1,
+                                      &max_l_real_m1
+                                      );
 #ifdef COUNT_STATES
-                matrices->N_M1[ij][cnt1 + dja][(cnt2 + djb) / 2] += matrices->N_M1[ij + 1][cnt1][cnt2 / 2];
+            matrices->N_M1[ij][cnt1 + dja][(cnt2 + djb) / 2] += matrices->N_M1[ij + 1][cnt1][cnt2 / 2];
 #endif
-              }
-              /* collect all cases where dja+cnt1 or djb+cnt2 exceeds maxD1, maxD2, respectively */
-              else {
-                matrices->E_M1_rem[ij] = MIN2(matrices->E_M1_rem[ij],
-                                              matrices->E_M1[ij + 1][cnt1][cnt2 / 2] + P->MLbase
-                                              );
-              }
+          }
+          /* collect all cases where dja+cnt1 or djb+cnt2 exceeds maxD1, maxD2, respectively */
+          else {
+            matrices->E_M1_rem[ij] = MIN2(matrices->E_M1_rem[ij],
+                                          matrices->E_M1[ij + 1][cnt1][cnt2 / 2] + P->MLbase
+                                          );
+          }
+        }
+      }
+    }
+  }
+
+  /* 5th E_M[ij] = MIN(E_M[ij], min(E_M[i,k] + E_M[k+1,j])) */
+  if (j > TURN + 2) {
+    for (u = i + 1 + TURN; u <= j - 2 - TURN; u++) {
+      /* check all cases where M(i,u) and/or M(u+1,j) are already out of scope of maxD1 and/or maxD2 */
+      if (matrices->E_M_rem[my_iindx[i] - u] != INF) {
+        for (cnt3 = matrices->k_min_M[my_iindx[u + 1] - j];
+             cnt3 <= matrices->k_max_M[my_iindx[u + 1] - j];
+             cnt3++) {
+          for (cnt4 = matrices->l_min_M[my_iindx[u + 1] - j][cnt3];
+               cnt4 <= matrices->l_max_M[my_iindx[u + 1] - j][cnt3];
+               cnt4 += 2) {
+            if (matrices->E_M[my_iindx[u + 1] - j][cnt3][cnt4 / 2] != INF) {
+              matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
+                                           matrices->E_M_rem[my_iindx[i] - u] + matrices->E_M[my_iindx[u + 1] - j][cnt3][cnt4 / 2]
+                                           );
             }
           }
         }
+        if (matrices->E_M_rem[my_iindx[u + 1] - j] != INF) {
+          matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
+                                       matrices->E_M_rem[my_iindx[i] - u] + matrices->E_M_rem[my_iindx[u + 1] - j]
+                                       );
+        }
       }
 
-      /* 5th E_M[ij] = MIN(E_M[ij], min(E_M[i,k] + E_M[k+1,j])) */
-      if (j > TURN + 2) {
-        for (u = i + 1 + TURN; u <= j - 2 - TURN; u++) {
-          /* check all cases where M(i,u) and/or M(u+1,j) are already out of scope of maxD1 and/or maxD2 */
-          if (matrices->E_M_rem[my_iindx[i] - u] != INF) {
-            for (cnt3 = matrices->k_min_M[my_iindx[u + 1] - j];
-                 cnt3 <= matrices->k_max_M[my_iindx[u + 1] - j];
-                 cnt3++) {
-              for (cnt4 = matrices->l_min_M[my_iindx[u + 1] - j][cnt3];
-                   cnt4 <= matrices->l_max_M[my_iindx[u + 1] - j][cnt3];
-                   cnt4 += 2) {
-                if (matrices->E_M[my_iindx[u + 1] - j][cnt3][cnt4 / 2] != INF) {
-                  matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
-                                               matrices->E_M_rem[my_iindx[i] - u] + matrices->E_M[my_iindx[u + 1] - j][cnt3][cnt4 / 2]
-                                               );
-                }
-              }
-            }
-            if (matrices->E_M_rem[my_iindx[u + 1] - j] != INF) {
+      if (matrices->E_M_rem[my_iindx[u + 1] - j] != INF) {
+        for (cnt1 = matrices->k_min_M[my_iindx[i] - u];
+             cnt1 <= matrices->k_max_M[my_iindx[i] - u];
+             cnt1++) {
+          for (cnt2 = matrices->l_min_M[my_iindx[i] - u][cnt1];
+               cnt2 <= matrices->l_max_M[my_iindx[i] - u][cnt1];
+               cnt2 += 2) {
+            if (matrices->E_M[my_iindx[i] - u][cnt1][cnt2 / 2] != INF) {
               matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
-                                           matrices->E_M_rem[my_iindx[i] - u] + matrices->E_M_rem[my_iindx[u + 1] - j]
+                                           matrices->E_M[my_iindx[i] - u][cnt1][cnt2 / 2] + matrices->E_M_rem[my_iindx[u + 1] - j]
                                            );
             }
           }
+        }
+      }
 
-          if (matrices->E_M_rem[my_iindx[u + 1] - j] != INF) {
-            for (cnt1 = matrices->k_min_M[my_iindx[i] - u];
-                 cnt1 <= matrices->k_max_M[my_iindx[i] - u];
-                 cnt1++) {
-              for (cnt2 = matrices->l_min_M[my_iindx[i] - u][cnt1];
-                   cnt2 <= matrices->l_max_M[my_iindx[i] - u][cnt1];
-                   cnt2 += 2) {
-                if (matrices->E_M[my_iindx[i] - u][cnt1][cnt2 / 2] != INF) {
-                  matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
-                                               matrices->E_M[my_iindx[i] - u][cnt1][cnt2 / 2] + matrices->E_M_rem[my_iindx[u + 1] - j]
-                                               );
-                }
-              }
-            }
-          }
-
-          if (!matrices->E_M[my_iindx[i] - u])
-            continue;
+      if (!matrices->E_M[my_iindx[i] - u])
+        continue;
 
-          if (!matrices->E_M[my_iindx[u + 1] - j])
-            continue;
+      if (!matrices->E_M[my_iindx[u + 1] - j])
+        continue;
 
-          dia = referenceBPs1[ij] - referenceBPs1[my_iindx[i] - u] - referenceBPs1[my_iindx[u + 1] - j];
-          dib = referenceBPs2[ij] - referenceBPs2[my_iindx[i] - u] - referenceBPs2[my_iindx[u + 1] - j];
+      dia = referenceBPs1[ij] - referenceBPs1[my_iindx[i] - u] - referenceBPs1[my_iindx[u + 1] - j];
+      dib = referenceBPs2[ij] - referenceBPs2[my_iindx[i] - u] - referenceBPs2[my_iindx[u + 1] - j];
 
-          for (cnt1 = matrices->k_min_M[my_iindx[i] - u];
-               cnt1 <= matrices->k_max_M[my_iindx[i] - u];
-               cnt1++) {
-            for (cnt2 = matrices->l_min_M[my_iindx[i] - u][cnt1];
-                 cnt2 <= matrices->l_max_M[my_iindx[i] - u][cnt1];
-                 cnt2 += 2) {
-              for (cnt3 = matrices->k_min_M[my_iindx[u + 1] - j];
-                   cnt3 <= matrices->k_max_M[my_iindx[u + 1] - j];
-                   cnt3++) {
-                for (cnt4 = matrices->l_min_M[my_iindx[u + 1] - j][cnt3];
-                     cnt4 <= matrices->l_max_M[my_iindx[u + 1] - j][cnt3];
-                     cnt4 += 2) {
-                  if ((matrices->E_M[my_iindx[i] - u][cnt1][cnt2 / 2] != INF) && (matrices->E_M[my_iindx[u + 1] - j][cnt3][cnt4 / 2] != INF)) {
-                    if (((cnt1 + cnt3 + dia) <= maxD1) && ((cnt2 + cnt4 + dib) <= maxD2)) {
-                      matrices->E_M[ij][cnt1 + cnt3 + dia][(cnt2 + cnt4 + dib) / 2] = MIN2(matrices->E_M[ij][cnt1 + cnt3 + dia][(cnt2 + cnt4 + dib) / 2],
-                                                                                           matrices->E_M[my_iindx[i] - u][cnt1][cnt2 / 2]
-                                                                                           + matrices->E_M[my_iindx[u + 1] - j][cnt3][cnt4 / 2]
-                                                                                           );
-                      updatePosteriorBoundaries(cnt1 + cnt3 + dia,
-                                                cnt2 + cnt4 + dib,
-                                                &min_k_real_m,
-                                                &max_k_real_m,
-                                                &min_l_real_m,
-                                                &max_l_real_m
-                                                );
+      for (cnt1 = matrices->k_min_M[my_iindx[i] - u];
+           cnt1 <= matrices->k_max_M[my_iindx[i] - u];
+           cnt1++) {
+        for (cnt2 = matrices->l_min_M[my_iindx[i] - u][cnt1];
+             cnt2 <= matrices->l_max_M[my_iindx[i] - u][cnt1];
+             cnt2 += 2) {
+          for (cnt3 = matrices->k_min_M[my_iindx[u + 1] - j];
+               cnt3 <= matrices->k_max_M[my_iindx[u + 1] - j];
+               cnt3++) {
+            for (cnt4 = matrices->l_min_M[my_iindx[u + 1] - j][cnt3];
+                 cnt4 <= matrices->l_max_M[my_iindx[u + 1] - j][cnt3];
+                 cnt4 += 2) {
+              if ((matrices->E_M[my_iindx[i] - u][cnt1][cnt2 / 2] != INF) && (matrices->E_M[my_iindx[u + 1] - j][cnt3][cnt4 / 2] != INF)) {
+                if (IN_SCOPE(vc, cnt1 + cnt3 + dia, cnt2 + cnt4 + dib)) {
+                  matrices->E_M[ij][cnt1 + cnt3 + dia][(cnt2 + cnt4 + dib) / 2] = MIN2(matrices->E_M[ij][cnt1 + cnt3 + dia][(cnt2 + cnt4 + dib) / 2],
+                                                                                       matrices->E_M[my_iindx[i] - u][cnt1][cnt2 / 2]
+                                                                                       + matrices->E_M[my_iindx[u + 1] - j][cnt3][cnt4 / 2]
+                                                                                       );
+                  updatePosteriorBoundaries(cnt1 + cnt3 + dia,
+                                            cnt2 + cnt4 + dib,
+                                            &min_k_real_m,
+                                            &max_k_real_m,
+                                            &min_l_real_m,
+                                            &max_l_real_m
+                                            );
 #ifdef COUNT_STATES
-                      matrices->N_M[ij][cnt1 + cnt3 + dia][(cnt2 + cnt4 + dib) / 2] += matrices->N_M[my_iindx[i] - u][cnt1][cnt2 / 2] * matrices->N_M1[my_iindx[u + 1] - j][cnt3][cnt4 / 2];
+                  matrices->N_M[ij][cnt1 + cnt3 + dia][(cnt2 + cnt4 + dib) / 2] += matrices->N_M[my_iindx[i] - u][cnt1][cnt2 / 2] * matrices->N_M1[my_iindx[u + 1] - j][cnt3][cnt4 / 2];
 #endif
-                    }
-                    /* collect all cases where dia+cnt1+cnt3 or dib+cnt2+cnt4 exceeds maxD1, maxD2, respectively */
-                    else {
-                      matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
-                                                   matrices->E_M[my_iindx[i] - u][cnt1][cnt2 / 2] + matrices->E_M[my_iindx[u + 1] - j][cnt3][cnt4 / 2]
-                                                   );
-                    }
-                  }
+                }
+                /* collect all cases where dia+cnt1+cnt3 or dib+cnt2+cnt4 exceeds maxD1, maxD2, respectively */
+                else {
+                  matrices->E_M_rem[ij] = MIN2(matrices->E_M_rem[ij],
+                                               matrices->E_M[my_iindx[i] - u][cnt1][cnt2 / 2] + matrices->E_M[my_iindx[u + 1] - j][cnt3][cnt4 / 2]
+                                               );
                 }
               }
             }
           }
         }
       }
+    }
+  }
 
-      /* thats all folks for the multiloop decomposition... */
-
-      adjustArrayBoundaries(&matrices->E_M[ij],
-                            &matrices->k_min_M[ij],
-                            &matrices->k_max_M[ij],
-                            &matrices->l_min_M[ij],
-                            &matrices->l_max_M[ij],
-                            min_k_real_m,
-                            max_k_real_m,
-                            min_l_real_m,
-                            max_l_real_m
-                            );
+  /* thats all folks for the multiloop decomposition... */
 
-      adjustArrayBoundaries(&matrices->E_M1[ij],
-                            &matrices->k_min_M1[ij],
-                            &matrices->k_max_M1[ij],
-                            &matrices->l_min_M1[ij],
-                            &matrices->l_max_M1[ij],
-                            min_k_real_m1,
-                            max_k_real_m1,
-                            min_l_real_m1,
-                            max_l_real_m1
-                            );
+  adjustArrayBoundaries(&matrices->E_M[ij],
+                        &matrices->k_min_M[ij],
+                        &matrices->k_max_M[ij],
+                        &matrices->l_min_M[ij],
+                        &matrices->l_max_M[ij],
+                        min_k_real_m,
+                        max_k_real_m,
+                        min_l_real_m,
+                        max_l_real_m
+                        );
+
+  adjustArrayBoundaries(&matrices->E_M1[ij],
+                        &matrices->k_min_M1[ij],
+                        &matrices->k_max_M1[ij],
+                        &matrices->l_min_M1[ij],
+                        &matrices->l_max_M1[ij],
+                        min_k_real_m1,
+                        max_k_real_m1,
+                        min_l_real_m1,
+                        max_l_real_m1
+                        );
 
 #ifdef COUNT_STATES
-      /* actually we should adjust the array boundaries here but we might never use the count states option more than once so what....*/
+  /* actually we should adjust the array boundaries here but we might never use the count states option more than once so what....*/
 #endif
-    } /* end of j-loop */
-  }
+}
+
+
+PRIVATE void
+mfe_linear(vrna_fold_compound_t *vc,
+           twoD_pool_t          *pool)
+{
+  unsigned int  i, j, ij, maxD1, maxD2, seq_length, *referenceBPs1, *referenceBPs2, *mm1, *mm2, *bpdist;
+  int           cnt1, cnt2, cnt3, cnt4, dangles, type, additional_en, *my_iindx, *jindx;
+  short         *S1;
+  char          *ptype;
+  vrna_param_t  *P;
+  vrna_mx_mfe_t *matrices;
+  vrna_md_t     *md;
+
+  /* dereferenciate things we often need */
+  P             = vc->params;
+  md            = &(P->model_details);
+  matrices      = vc->matrices;
+  seq_length    = vc->length;
+  maxD1         = vc->maxD1;
+  maxD2         = vc->maxD2;
+  S1            = vc->sequence_encoding;
+  ptype         = vc->ptype;
+  my_iindx      = vc->iindx;
+  jindx         = vc->jindx;
+  referenceBPs1 = vc->referenceBPs1;
+  referenceBPs2 = vc->referenceBPs2;
+  mm1           = vc->mm1;
+  mm2           = vc->mm2;
+  bpdist        = vc->bpdist;
+  dangles       = md->dangles;
+
+  /* fill E_C, E_M, and E_M1 for all (i,j) in parallel, diagonal by diagonal */
+  twoD_fill_diagonals(vc, pool, &mfe_linear_cell);
 
   /* calculate energies of 5' and 3' fragments */
 
   /* prepare first entries in E_F5 */
   for (cnt1 = 1; cnt1 <= TURN + 1; cnt1++) {
-    matrices->E_F5[cnt1]        = (int **)vrna_alloc(sizeof(int *));
-    matrices->E_F5[cnt1][0]     = (int *)vrna_alloc(sizeof(int));
-    matrices->E_F5[cnt1][0][0]  = 0;
     matrices->E_F5_rem[cnt1]    = INF;
     matrices->k_min_F5[cnt1]    = matrices->k_max_F5[cnt1] = 0;
     matrices->l_min_F5[cnt1]    = (int *)vrna_alloc(sizeof(int));
     matrices->l_max_F5[cnt1]    = (int *)vrna_alloc(sizeof(int));
     matrices->l_min_F5[cnt1][0] = matrices->l_max_F5[cnt1][0] = 0;
+    prepareArray(&matrices->E_F5[cnt1], 0, 0, matrices->l_min_F5[cnt1], matrices->l_max_F5[cnt1]);
+    matrices->E_F5[cnt1][0][0] = 0;
 #ifdef COUNT_STATES
-    matrices->N_F5[cnt1]        = (unsigned long **)vrna_alloc(sizeof(unsigned long *));
-    matrices->N_F5[cnt1][0]     = (unsigned long *)vrna_alloc(sizeof(unsigned long));
-    matrices->N_F5[cnt1][0][0]  = 1;
+    prepareArray2(&matrices->N_F5[cnt1], 0, 0, matrices->l_min_F5[cnt1], matrices->l_max_F5[cnt1]);
+    matrices->N_F5[cnt1][0][0] = 1;
 #endif
   }
 
@@ -1105,7 +1268,8 @@ mfe_linear(vrna_fold_compound_t *vc)
     max_k_guess = referenceBPs1[my_iindx[1] - j] + mm1[my_iindx[1] - j];
     max_l_guess = referenceBPs2[my_iindx[1] - j] + mm2[my_iindx[1] - j];
 
-    prepareBoundaries(min_k_guess,
+    prepareBoundaries(vc,
+                      min_k_guess,
                       max_k_guess,
                       min_l_guess,
                       max_l_guess,
@@ -1145,7 +1309,7 @@ mfe_linear(vrna_fold_compound_t *vc)
     matrices->E_F5_rem[j] = matrices->E_F5_rem[j - 1];
     for (cnt1 = matrices->k_min_F5[j - 1]; cnt1 <= matrices->k_max_F5[j - 1]; cnt1++) {
       for (cnt2 = matrices->l_min_F5[j - 1][cnt1]; cnt2 <= matrices->l_max_F5[j - 1][cnt1]; cnt2 += 2) {
-        if (((cnt1 + da) <= maxD1) && ((cnt2 + db) <= maxD2)) {
+        if (IN_SCOPE(vc, cnt1 + da, cnt2 + db)) {
           matrices->E_F5[j][cnt1 + da][(cnt2 + db) / 2] = MIN2(matrices->E_F5[j][cnt1 + da][(cnt2 + db) / 2],
                                                                matrices->E_F5[j - 1][cnt1][cnt2 / 2]
                                                                );
@@ -1238,7 +1402,7 @@ mfe_linear(vrna_fold_compound_t *vc)
             for (cnt3 = matrices->k_min_F5[i - 1]; cnt3 <= matrices->k_max_F5[i - 1]; cnt3++)
               for (cnt4 = matrices->l_min_F5[i - 1][cnt3]; cnt4 <= matrices->l_max_F5[i - 1][cnt3]; cnt4 += 2) {
                 if (matrices->E_F5[i - 1][cnt3][cnt4 / 2] != INF && matrices->E_C[ij][cnt1][cnt2 / 2] != INF) {
-                  if (((cnt1 + cnt3 + d1a) <= maxD1) && ((cnt2 + cnt4 + d1b) <= maxD2)) {
+                  if (IN_SCOPE(vc, cnt1 + cnt3 + d1a, cnt2 + cnt4 + d1b)) {
                     matrices->E_F5[j][cnt1 + cnt3 + d1a][(cnt2 + cnt4 + d1b) / 2] = MIN2(matrices->E_F5[j][cnt1 + cnt3 + d1a][(cnt2 + cnt4 + d1b) / 2],
                                                                                          matrices->E_F5[i - 1][cnt3][cnt4 / 2] + matrices->E_C[ij][cnt1][cnt2 / 2] + additional_en
                                                                                          );
@@ -1281,13 +1445,12 @@ mfe_linear(vrna_fold_compound_t *vc)
   if (compute_2Dfold_F3) {
     /* prepare first entries in E_F3 */
     for (cnt1 = seq_length; cnt1 >= seq_length - TURN - 1; cnt1--) {
-      matrices->E_F3[cnt1]        = (int **)vrna_alloc(sizeof(int *));
-      matrices->E_F3[cnt1][0]     = (int *)vrna_alloc(sizeof(int));
-      matrices->E_F3[cnt1][0][0]  = 0;
       matrices->k_min_F3[cnt1]    = matrices->k_max_F3[cnt1] = 0;
       matrices->l_min_F3[cnt1]    = (int *)vrna_alloc(sizeof(int));
       matrices->l_max_F3[cnt1]    = (int *)vrna_alloc(sizeof(int));
       matrices->l_min_F3[cnt1][0] = matrices->l_max_F3[cnt1][0] = 0;
+      prepareArray(&matrices->E_F3[cnt1], 0, 0, matrices->l_min_F3[cnt1], matrices->l_max_F3[cnt1]);
+      matrices->E_F3[cnt1][0][0] = 0;
     }
     /* begin calculations */
     for (j = seq_length - TURN - 2; j >= 1; j--) {
@@ -1311,7 +1474,8 @@ mfe_linear(vrna_fold_compound_t *vc)
       max_k_guess = referenceBPs1[my_iindx[j] - seq_length] + mm1[my_iindx[j] - seq_length];
       max_l_guess = referenceBPs2[my_iindx[j] - seq_length] + mm2[my_iindx[j] - seq_length];
 
-      prepareBoundaries(min_k_guess,
+      prepareBoundaries(vc,
+                        min_k_guess,
                         max_k_guess,
                         min_l_guess,
                         max_l_guess,
@@ -1411,12 +1575,12 @@ mfe_linear(vrna_fold_compound_t *vc)
         }
       }
 
-      /* resize and move memory portions of energy matrix E_F5 */
-      adjustArrayBoundaries(&matrices->E_F5[j],
-                            &matrices->k_min_F5[j],
-                            &matrices->k_max_F5[j],
-                            &matrices->l_min_F5[j],
-                            &matrices->l_max_F5[j],
+      /* resize and move memory portions of energy matrix E_F3 */
+      adjustArrayBoundaries(&matrices->E_F3[j],
+                            &matrices->k_min_F3[j],
+                            &matrices->k_max_F3[j],
+                            &matrices->l_min_F3[j],
+                            &matrices->l_max_F3[j],
                             min_k_real,
                             max_k_real,
                             min_l_real,
@@ -1500,7 +1664,7 @@ backtrack_f5(unsigned int         j,
         for (cnt2 = l_min_F5[j - 1][cnt1];
              cnt2 <= l_max_F5[j - 1][cnt1];
              cnt2 += 2) {
-          if (((cnt1 + da) > maxD1) || ((cnt2 + db) > maxD2)) {
+          if (!IN_SCOPE(vc, cnt1 + da, cnt2 + db)) {
             if (E_F5_rem[j] == E_F5[j - 1][cnt1][cnt2 / 2]) {
               backtrack_f5(j - 1, cnt1, cnt2, structure, vc);
               return;
@@ -1606,7 +1770,7 @@ backtrack_f5(unsigned int         j,
               for (cnt4 = l_min_C[ij][cnt3];
                    cnt4 <= l_max_C[ij][cnt3];
                    cnt4 += 2) {
-                if (((cnt1 + cnt3 + d1a) > maxD1) || ((cnt2 + cnt4 + d1b) > maxD2)) {
+                if (!IN_SCOPE(vc, cnt1 + cnt3 + d1a, cnt2 + cnt4 + d1b)) {
                   if (E_F5_rem[j] == (E_F5[i - 1][cnt1][cnt2 / 2] + E_C[ij][cnt3][cnt4 / 2] + energy)) {
                     backtrack_f5(i - 1, cnt1, cnt2, structure, vc);
                     backtrack_c(i, j, cnt3, cnt4, structure, vc);
@@ -1715,7 +1879,7 @@ backtrack_c(unsigned int          i,
   base_d2 += referenceBPs2[ij];
 
   if (k == -1) {
-    if (((unsigned int)base_d1 > maxD1) || ((unsigned int)base_d2 > maxD2))
+    if (!IN_SCOPE(vc, base_d1, base_d2))
       if (e == E_Hairpin(j - i - 1, type, S1[i + 1], S1[j - 1], sequence + i - 1, P))
         return;
   } else {
@@ -1763,7 +1927,7 @@ backtrack_c(unsigned int          i,
             for (cnt2 = l_min_C[pq][cnt1];
                  cnt2 <= l_max_C[pq][cnt1];
                  cnt2 += 2) {
-              if (((cnt1 + d1) > maxD1) || ((cnt2 + d2) > maxD2)) {
+              if (!IN_SCOPE(vc, cnt1 + d1, cnt2 + d2)) {
                 if (e == (E_C[pq][cnt1][cnt2 / 2] + energy)) {
                   backtrack_c(p, q, cnt1, cnt2, structure, vc);
                   return;
@@ -1871,7 +2035,7 @@ backtrack_c(unsigned int          i,
               for (cnt4 = matrices->l_min_M1[u1j1][cnt3];
                    cnt4 <= matrices->l_max_M1[u1j1][cnt3];
                    cnt4 += 2) {
-                if (((cnt1 + cnt3 + d1) > maxD1) || ((cnt2 + cnt4 + d2) > maxD2)) {
+                if (!IN_SCOPE(vc, cnt1 + cnt3 + d1, cnt2 + cnt4 + d2)) {
                   if (e == (E_M[i1u][cnt1][cnt2 / 2] + E_M1[u1j1][cnt3][cnt4 / 2] + energy)) {
                     backtrack_m(i + 1, u, cnt1, cnt2, structure, vc);
                     backtrack_m1(u + 1, j - 1, cnt3, cnt4, structure, vc);
@@ -2005,7 +2169,7 @@ backtrack_m(unsigned int          i,
         for (cnt2 = l_min_M[my_iindx[i + 1] - j][cnt1];
              cnt2 <= l_max_M[my_iindx[i + 1] - j][cnt1];
              cnt2 += 2)
-          if (((cnt1 + d1) > maxD1) || ((cnt2 + d2) > maxD2)) {
+          if (!IN_SCOPE(vc, cnt1 + d1, cnt2 + d2)) {
             if (e == (E_M[my_iindx[i + 1] - j][cnt1][cnt2 / 2] + P->MLbase)) {
               backtrack_m(i + 1, j, cnt1, cnt2, structure, vc);
               return;
@@ -2030,7 +2194,7 @@ backtrack_m(unsigned int          i,
         for (cnt2 = l_min_M[ij + 1][cnt1];
              cnt2 <= l_max_M[ij + 1][cnt1];
              cnt2 += 2)
-          if (((cnt1 + d1) > maxD1) || ((cnt2 + d2) > maxD2)) {
+          if (!IN_SCOPE(vc, cnt1 + d1, cnt2 + d2)) {
             if (e == (E_M[ij + 1][cnt1][cnt2 / 2] + P->MLbase)) {
               backtrack_m(i, j - 1, cnt1, cnt2, structure, vc);
               return;
@@ -2125,7 +2289,7 @@ backtrack_m(unsigned int          i,
             for (cnt4 = l_min_C[uj][cnt3];
                  cnt4 <= l_max_C[uj][cnt3];
                  cnt4 += 2)
-              if (((cnt1 + cnt3 + d1) > maxD1) || ((cnt2 + cnt4 + d2) > maxD2)) {
+              if (!IN_SCOPE(vc, cnt1 + cnt3 + d1, cnt2 + cnt4 + d2)) {
                 if (e == (E_M[iu][cnt1][cnt2 / 2] + E_C[uj][cnt3][cnt4 / 2] + energy)) {
                   backtrack_m(i, u, cnt1, cnt2, structure, vc);
                   backtrack_c(u + 1, j, cnt3, cnt4, structure, vc);
@@ -2307,7 +2471,7 @@ backtrack_m1(unsigned int         i,
       for (cnt2 = l_min_M1[ij + 1][cnt1];
            cnt2 <= l_max_M1[ij + 1][cnt1];
            cnt2 += 2)
-        if (((cnt1 + d1) > maxD1) || ((cnt2 + d2) > maxD2)) {
+        if (!IN_SCOPE(vc, cnt1 + d1, cnt2 + d2)) {
           if (e_m1 == (E_M1[ij + 1][cnt1][cnt2 / 2] + P->MLbase)) {
             backtrack_m1(i, j - 1, cnt1, cnt2, structure, vc);
             return;
@@ -2432,7 +2596,7 @@ backtrack_fc(int                  k,
   if (k == -1) {
     /* check if mfe might be open chain */
     if (E_Fc_rem == 0)
-      if ((referenceBPs1[my_iindx[1] - seq_length] > maxD1) || (referenceBPs2[my_iindx[1] - seq_length] > maxD2))
+      if (!IN_SCOPE(vc, referenceBPs1[my_iindx[1] - seq_length], referenceBPs2[my_iindx[1] - seq_length]))
         return;
 
     /* check for hairpin configurations */
@@ -2480,7 +2644,7 @@ backtrack_fc(int                  k,
               for (cnt2 = l_min_C[ij][cnt1];
                    cnt2 <= l_max_C[ij][cnt1];
                    cnt2 += 2)
-                if (((cnt1 + d1) > maxD1) || ((cnt2 + d2) > maxD2)) {
+                if (!IN_SCOPE(vc, cnt1 + d1, cnt2 + d2)) {
                   if (E_Fc_rem == (E_C[ij][cnt1][cnt2 / 2] + energy)) {
                     backtrack_c(i, j, cnt1, cnt2, structure, vc);
                     return;
@@ -2593,7 +2757,7 @@ backtrack_fc(int                  k,
                     for (cnt4 = l_min_C[pq][cnt3];
                          cnt4 <= l_max_C[pq][cnt3];
                          cnt4 += 2)
-                      if (((cnt1 + cnt3 + d1) > maxD1) || ((cnt2 + cnt4 + d2) > maxD2)) {
+                      if (!IN_SCOPE(vc, cnt1 + cnt3 + d1, cnt2 + cnt4 + d2)) {
                         if (E_Fc_rem == (E_C[ij][cnt1][cnt2 / 2] + E_C[pq][cnt3][cnt4 / 2] + energy)) {
                           backtrack_c(i, j, cnt1, cnt2, structure, vc);
                           backtrack_c(p, q, cnt3, cnt4, structure, vc);
@@ -2673,7 +2837,7 @@ backtrack_fc(int                  k,
                 for (cnt4 = l_min_M2[i + 1][cnt3];
                      cnt4 <= l_max_M2[i + 1][cnt3];
                      cnt4 += 2)
-                  if (((cnt1 + cnt3 + d1) > maxD1) || ((cnt2 + cnt4 + d2) > maxD2)) {
+                  if (!IN_SCOPE(vc, cnt1 + cnt3 + d1, cnt2 + cnt4 + d2)) {
                     if (E_Fc_rem == (E_M[my_iindx[1] - i][cnt1][cnt2 / 2] + E_M2[i + 1][cnt3][cnt4 / 2] + P->MLclosing)) {
                       backtrack_m(1, i, cnt1, cnt2, structure, vc);
                       backtrack_m2(i + 1, cnt3, cnt4, structure, vc);
@@ -2952,7 +3116,7 @@ backtrack_m2(unsigned int         i,
         for (cnt2 = l_min_M1[my_iindx[i] - j][cnt1]; cnt2 <= l_max_M1[my_iindx[i] - j][cnt1]; cnt2 += 2) {
           for (cnt3 = k_min_M1[my_iindx[j + 1] - n]; cnt3 <= k_max_M1[my_iindx[j + 1] - n]; cnt3++)
             for (cnt4 = l_min_M1[my_iindx[j + 1] - n][cnt3]; cnt4 <= l_max_M1[my_iindx[j + 1] - n][cnt3]; cnt4 += 2) {
-              if (((cnt1 + cnt3 + d1) > maxD1) || ((cnt2 + cnt4 + d2) > maxD2)) {
+              if (!IN_SCOPE(vc, cnt1 + cnt3 + d1, cnt2 + cnt4 + d2)) {
                 if (e == E_M1[my_iindx[i] - j][cnt1][cnt2 / 2] + E_M1[my_iindx[j + 1] - n][cnt3][cnt4 / 2]) {
                   backtrack_m1(i, j, cnt1, cnt2, structure, vc);
                   backtrack_m1(j + 1, n, cnt3, cnt4, structure, vc);
@@ -2994,16 +3158,17 @@ backtrack_m2(unsigned int         i,
 
 
 PRIVATE void
-mfe_circ(vrna_fold_compound_t *vc)
+mfe_circ(vrna_fold_compound_t *vc,
+         twoD_pool_t          *pool)
 {
   unsigned int  d, i, j, maxD1, maxD2, seq_length, *referenceBPs1, *referenceBPs2, d1, d2, base_d1, base_d2, *mm1, *mm2, *bpdist;
   int           *my_iindx, *jindx, energy, cnt1, cnt2, cnt3, cnt4, *rtype;
   short         *S1;
   char          *sequence, *ptype;
-  int           ***E_C, ***E_M, ***E_M1;
-  int           *E_C_rem, *E_M_rem, *E_M1_rem;
-  int           **l_min_C, **l_max_C, **l_min_M, **l_max_M, **l_min_M1, **l_max_M1;
-  int           *k_min_C, *k_max_C, *k_min_M, *k_max_M, *k_min_M1, *k_max_M1;
+  int           ***E_C, ***E_M;
+  int           *E_C_rem, *E_M_rem;
+  int           **l_min_C, **l_max_C, **l_min_M, **l_max_M;
+  int           *k_min_C, *k_max_C, *k_min_M, *k_max_M;
 
   vrna_param_t  *P;
   vrna_md_t     *md;
@@ -3039,133 +3204,12 @@ mfe_circ(vrna_fold_compound_t *vc)
   k_min_M = matrices->k_min_M;
   k_max_M = matrices->k_max_M;
 
-  E_M1      = matrices->E_M1;
-  l_min_M1  = matrices->l_min_M1;
-  l_max_M1  = matrices->l_max_M1;
-  k_min_M1  = matrices->k_min_M1;
-  k_max_M1  = matrices->k_max_M1;
-
-  E_C_rem   = matrices->E_C_rem;
-  E_M_rem   = matrices->E_M_rem;
-  E_M1_rem  = matrices->E_M1_rem;
-
-#ifdef _OPENMP
-#pragma omp parallel for private(d1,d2,cnt1,cnt2,cnt3,cnt4,j, i)
-#endif
-  for (i = 1; i < seq_length - TURN - 1; i++) {
-    /* guess memory requirements for M2 */
-
-    int min_k, max_k, max_l, min_l;
-    int min_k_real, max_k_real, *min_l_real, *max_l_real;
-
-    min_k = min_l = 0;
-    max_k = mm1[my_iindx[i] - seq_length] + referenceBPs1[my_iindx[i] - seq_length];
-    max_l = mm2[my_iindx[i] - seq_length] + referenceBPs2[my_iindx[i] - seq_length];
-
-    prepareBoundaries(min_k,
-                      max_k,
-                      min_l,
-                      max_l,
-                      bpdist[my_iindx[i] - seq_length],
-                      &matrices->k_min_M2[i],
-                      &matrices->k_max_M2[i],
-                      &matrices->l_min_M2[i],
-                      &matrices->l_max_M2[i]
-                      );
-
-    prepareArray(&matrices->E_M2[i],
-                 matrices->k_min_M2[i],
-                 matrices->k_max_M2[i],
-                 matrices->l_min_M2[i],
-                 matrices->l_max_M2[i]
-                 );
-
-    preparePosteriorBoundaries(matrices->k_max_M2[i] - matrices->k_min_M2[i] + 1,
-                               matrices->k_min_M2[i],
-                               &min_k_real,
-                               &max_k_real,
-                               &min_l_real,
-                               &max_l_real
-                               );
-
-    /* begin filling of M2 array */
-    for (j = i + TURN + 1; j < seq_length - TURN - 1; j++) {
-      if (E_M1_rem[my_iindx[i] - j] != INF) {
-        if (E_M1[my_iindx[j + 1] - seq_length]) {
-          for (cnt1 = k_min_M1[my_iindx[j + 1] - seq_length];
-               cnt1 <= k_max_M1[my_iindx[j + 1] - seq_length];
-               cnt1++)
-            for (cnt2 = l_min_M1[my_iindx[j + 1] - seq_length][cnt1];
-                 cnt2 <= l_max_M1[my_iindx[j + 1] - seq_length][cnt1];
-                 cnt2++)
-              matrices->E_M2_rem[i] = MIN2(matrices->E_M2_rem[i],
-                                           E_M1_rem[my_iindx[i] - j] + E_M1[my_iindx[j + 1] - seq_length][cnt1][cnt2 / 2]
-                                           );
-        }
-
-        if (E_M1_rem[my_iindx[j + 1] - seq_length] != INF)
-          matrices->E_M2_rem[i] = MIN2(matrices->E_M2_rem[i], E_M1_rem[my_iindx[i] - j] + E_M1_rem[my_iindx[j + 1] - seq_length]);
-      }
-
-      if (E_M1_rem[my_iindx[j + 1] - seq_length] != INF) {
-        if (E_M1[my_iindx[i] - j]) {
-          for (cnt1 = k_min_M1[my_iindx[i] - j];
-               cnt1 <= k_max_M1[my_iindx[i] - j];
-               cnt1++)
-            for (cnt2 = l_min_M1[my_iindx[i] - j][cnt1];
-                 cnt2 <= l_max_M1[my_iindx[i] - j][cnt1];
-                 cnt2 += 2)
-              matrices->E_M2_rem[i] = MIN2(matrices->E_M2_rem[i],
-                                           E_M1[my_iindx[i] - j][cnt1][cnt2 / 2] + E_M1_rem[my_iindx[j + 1] - seq_length]
-                                           );
-        }
-      }
-
-      if (!E_M1[my_iindx[i] - j])
-        continue;
-
-      if (!E_M1[my_iindx[j + 1] - seq_length])
-        continue;
-
-      d1  = referenceBPs1[my_iindx[i] - seq_length] - referenceBPs1[my_iindx[i] - j] - referenceBPs1[my_iindx[j + 1] - seq_length];
-      d2  = referenceBPs2[my_iindx[i] - seq_length] - referenceBPs2[my_iindx[i] - j] - referenceBPs2[my_iindx[j + 1] - seq_length];
-
-      for (cnt1 = k_min_M1[my_iindx[i] - j]; cnt1 <= k_max_M1[my_iindx[i] - j]; cnt1++)
-        for (cnt2 = l_min_M1[my_iindx[i] - j][cnt1]; cnt2 <= l_max_M1[my_iindx[i] - j][cnt1]; cnt2 += 2) {
-          for (cnt3 = k_min_M1[my_iindx[j + 1] - seq_length]; cnt3 <= k_max_M1[my_iindx[j + 1] - seq_length]; cnt3++)
-            for (cnt4 = l_min_M1[my_iindx[j + 1] - seq_length][cnt3]; cnt4 <= l_max_M1[my_iindx[j + 1] - seq_length][cnt3]; cnt4 += 2) {
-              if (((cnt1 + cnt3 + d1) <= maxD1) && ((cnt2 + cnt4 + d2) <= maxD2)) {
-                matrices->E_M2[i][cnt1 + cnt3 + d1][(cnt2 + cnt4 + d2) / 2] = MIN2(matrices->E_M2[i][cnt1 + cnt3 + d1][(cnt2 + cnt4 + d2) / 2],
-                                                                                   E_M1[my_iindx[i] - j][cnt1][cnt2 / 2] + E_M1[my_iindx[j + 1] - seq_length][cnt3][cnt4 / 2]
-                                                                                   );
-                updatePosteriorBoundaries(cnt1 + cnt3 + d1,
-                                          cnt2 + cnt4 + d2,
-                                          &min_k_real,
-                                          &max_k_real,
-                                          &min_l_real,
-                                          &max_l_real
-                                          );
-              } else {
-                matrices->E_M2_rem[i] = MIN2(matrices->E_M2_rem[i],
-                                             E_M1[my_iindx[i] - j][cnt1][cnt2 / 2] + E_M1[my_iindx[j + 1] - seq_length][cnt3][cnt4 / 2]
-                                             );
-              }
-            }
-        }
-    }
+  E_C_rem = matrices->E_C_rem;
+  E_M_rem = matrices->E_M_rem;
 
-    /* resize and move memory portions of energy matrix E_M2 */
-    adjustArrayBoundaries(&matrices->E_M2[i],
-                          &matrices->k_min_M2[i],
-                          &matrices->k_max_M2[i],
-                          &matrices->l_min_M2[i],
-                          &matrices->l_max_M2[i],
-                          min_k_real,
-                          max_k_real,
-                          min_l_real,
-                          max_l_real
-                          );
-  } /* end for i */
+  /* fill E_M2 for all i in parallel */
+  if (seq_length > TURN + 2)
+    twoD_pool_for(pool, seq_length - TURN - 2, NULL, &mfe_circ_M2, (void *)vc);
 
   base_d1 = referenceBPs1[my_iindx[1] - seq_length];
   base_d2 = referenceBPs2[my_iindx[1] - seq_length];
@@ -3191,7 +3235,8 @@ mfe_circ(vrna_fold_compound_t *vc)
 #pragma omp section
     {
 #endif
-  prepareBoundaries(min_k,
+  prepareBoundaries(vc,
+                    min_k,
                     max_k,
                     min_l,
                     max_l,
@@ -3214,7 +3259,8 @@ mfe_circ(vrna_fold_compound_t *vc)
 #pragma omp section
 {
 #endif
-  prepareBoundaries(min_k,
+  prepareBoundaries(vc,
+                    min_k,
                     max_k,
                     min_l,
                     max_l,
@@ -3235,7 +3281,8 @@ mfe_circ(vrna_fold_compound_t *vc)
 #pragma omp section
 {
 #endif
-  prepareBoundaries(min_k,
+  prepareBoundaries(vc,
+                    min_k,
                     max_k,
                     min_l,
                     max_l,
@@ -3256,7 +3303,8 @@ mfe_circ(vrna_fold_compound_t *vc)
 #pragma omp section
 {
 #endif
-  prepareBoundaries(min_k,
+  prepareBoundaries(vc,
+                    min_k,
                     max_k,
                     min_l,
                     max_l,
@@ -3373,7 +3421,7 @@ mfe_circ(vrna_fold_compound_t *vc)
 
       for (cnt1 = k_min_C[ij]; cnt1 <= k_max_C[ij]; cnt1++)
         for (cnt2 = l_min_C[ij][cnt1]; cnt2 <= l_max_C[ij][cnt1]; cnt2 += 2) {
-          if (((cnt1 + d1) <= maxD1) && ((cnt2 + d2) <= maxD2)) {
+          if (IN_SCOPE(vc, cnt1 + d1, cnt2 + d2)) {
             matrices->E_FcH[cnt1 + d1][(cnt2 + d2) / 2] = MIN2(matrices->E_FcH[cnt1 + d1][(cnt2 + d2) / 2],
                                                                energy + E_C[ij][cnt1][cnt2 / 2]
                                                                );
@@ -3529,7 +3577,7 @@ mfe_circ(vrna_fold_compound_t *vc)
                     for (cnt4 = l_min_C[pq][cnt3];
                          cnt4 <= l_max_C[pq][cnt3];
                          cnt4 += 2) {
-                      if (((cnt1 + cnt3 + d1) <= maxD1) && ((cnt2 + cnt4 + d2) <= maxD2)) {
+                      if (IN_SCOPE(vc, cnt1 + cnt3 + d1, cnt2 + cnt4 + d2)) {
                         matrices->E_FcI[cnt1 + cnt3 + d1][(cnt2 + cnt4 + d2) / 2] = MIN2(
                           matrices->E_FcI[cnt1 + cnt3 + d1][(cnt2 + cnt4 + d2) / 2],
                           E_C[ij][cnt1][cnt2 / 2]
@@ -3621,7 +3669,7 @@ mfe_circ(vrna_fold_compound_t *vc)
         for (cnt2 = l_min_M[my_iindx[1] - i][cnt1]; cnt2 <= l_max_M[my_iindx[1] - i][cnt1]; cnt2 += 2)
           for (cnt3 = matrices->k_min_M2[i + 1]; cnt3 <= matrices->k_max_M2[i + 1]; cnt3++)
             for (cnt4 = matrices->l_min_M2[i + 1][cnt3]; cnt4 <= matrices->l_max_M2[i + 1][cnt3]; cnt4 += 2) {
-              if (((cnt1 + cnt3 + d1) <= maxD1) && ((cnt2 + cnt4 + d2) <= maxD2)) {
+              if (IN_SCOPE(vc, cnt1 + cnt3 + d1, cnt2 + cnt4 + d2)) {
                 matrices->E_FcM[cnt1 + cnt3 + d1][(cnt2 + cnt4 + d2) / 2] = MIN2(
                   matrices->E_FcM[cnt1 + cnt3 + d1][(cnt2 + cnt4 + d2) / 2],
                   E_M[my_iindx[1] - i][cnt1][cnt2 / 2]
@@ -3668,7 +3716,7 @@ mfe_circ(vrna_fold_compound_t *vc)
   matrices->E_Fc_rem  = MIN2(matrices->E_FcH_rem, matrices->E_FcI_rem);
   matrices->E_Fc_rem  = MIN2(matrices->E_Fc_rem, matrices->E_FcM_rem);
   /* add the case were structure is unfolded chain */
-  if ((referenceBPs1[my_iindx[1] - seq_length] > maxD1) || (referenceBPs2[my_iindx[1] - seq_length] > maxD2))
+  if (!IN_SCOPE(vc, referenceBPs1[my_iindx[1] - seq_length], referenceBPs2[my_iindx[1] - seq_length]))
     matrices->E_Fc_rem = MIN2(matrices->E_Fc_rem, 0);
 
   /* compute all E_Fc */
@@ -3736,6 +3784,152 @@ mfe_circ(vrna_fold_compound_t *vc)
 }
 
 
+/* fill E_M2[i] for i = idx + 1 of a circular RNA */
+PRIVATE void
+mfe_circ_M2(void          *data,
+            unsigned int  idx)
+{
+  unsigned int          i, j, maxD1, maxD2, seq_length, *referenceBPs1, *referenceBPs2, d1, d2, *mm1, *mm2, *bpdist;
+  int                   *my_iindx, cnt1, cnt2, cnt3, cnt4;
+  int                   ***E_M1, *E_M1_rem, **l_min_M1, **l_max_M1, *k_min_M1, *k_max_M1;
+  int                   min_k, max_k, max_l, min_l;
+  int                   min_k_real, max_k_real, *min_l_real, *max_l_real;
+  vrna_fold_compound_t  *vc;
+  vrna_mx_mfe_t         *matrices;
+
+  vc            = (vrna_fold_compound_t *)data;
+  matrices      = vc->matrices;
+  seq_length    = vc->length;
+  maxD1         = vc->maxD1;
+  maxD2         = vc->maxD2;
+  my_iindx      = vc->iindx;
+  referenceBPs1 = vc->referenceBPs1;
+  referenceBPs2 = vc->referenceBPs2;
+  mm1           = vc->mm1;
+  mm2           = vc->mm2;
+  bpdist        = vc->bpdist;
+
+  E_M1      = matrices->E_M1;
+  l_min_M1  = matrices->l_min_M1;
+  l_max_M1  = matrices->l_max_M1;
+  k_min_M1  = matrices->k_min_M1;
+  k_max_M1  = matrices->k_max_M1;
+  E_M1_rem  = matrices->E_M1_rem;
+
+  i = idx + 1;
+
+  /* guess memory requirements for M2 */
+  min_k = min_l = 0;
+  max_k = mm1[my_iindx[i] - seq_length] + referenceBPs1[my_iindx[i] - seq_length];
+  max_l = mm2[my_iindx[i] - seq_length] + referenceBPs2[my_iindx[i] - seq_length];
+
+  prepareBoundaries(vc,
+                    min_k,
+                    max_k,
+                    min_l,
+                    max_l,
+                    bpdist[my_iindx[i] - seq_length],
+                    &matrices->k_min_M2[i],
+                    &matrices->k_max_M2[i],
+                    &matrices->l_min_M2[i],
+                    &matrices->l_max_M2[i]
+                    );
+
+  prepareArray(&matrices->E_M2[i],
+               matrices->k_min_M2[i],
+               matrices->k_max_M2[i],
+               matrices->l_min_M2[i],
+               matrices->l_max_M2[i]
+               );
+
+  preparePosteriorBoundaries(matrices->k_max_M2[i] - matrices->k_min_M2[i] + 1,
+                             matrices->k_min_M2[i],
+                             &min_k_real,
+                             &max_k_real,
+                             &min_l_real,
+                             &max_l_real
+                             );
+
+  /* begin filling of M2 array */
+  for (j = i + TURN + 1; j < seq_length - TURN - 1; j++) {
+    if (E_M1_rem[my_iindx[i] - j] != INF) {
+      if (E_M1[my_iindx[j + 1] - seq_length]) {
+        for (cnt1 = k_min_M1[my_iindx[j + 1] - seq_length];
+             cnt1 <= k_max_M1[my_iindx[j + 1] - seq_length];
+             cnt1++)
+          for (cnt2 = l_min_M1[my_iindx[j + 1] - seq_length][cnt1];
+               cnt2 <= l_max_M1[my_iindx[j + 1] - seq_length][cnt1];
+               cnt2++)
+            matrices->E_M2_rem[i] = MIN2(matrices->E_M2_rem[i],
+                                         E_M1_rem[my_iindx[i] - j] + E_M1[my_iindx[j + 1] - seq_length][cnt1][cnt2 / 2]
+                                         );
+      }
+
+      if (E_M1_rem[my_iindx[j + 1] - seq_length] != INF)
+        matrices->E_M2_rem[i] = MIN2(matrices->E_M2_rem[i], E_M1_rem[my_iindx[i] - j] + E_M1_rem[my_iindx[j + 1] - seq_length]);
+    }
+
+    if (E_M1_rem[my_iindx[j + 1] - seq_length] != INF) {
+      if (E_M1[my_iindx[i] - j]) {
+        for (cnt1 = k_min_M1[my_iindx[i] - j];
+             cnt1 <= k_max_M1[my_iindx[i] - j];
+             cnt1++)
+          for (cnt2 = l_min_M1[my_iindx[i] - j][cnt1];
+               cnt2 <= l_max_M1[my_iindx[i] - j][cnt1];
+               cnt2 += 2)
+            matrices->E_M2_rem[i] = MIN2(matrices->E_M2_rem[i],
+                                         E_M1[my_iindx[i] - j][cnt1][cnt2 / 2] + E_M1_rem[my_iindx[j + 1] - seq_length]
+                                         );
+      }
+    }
+
+    if (!E_M1[my_iindx[i] - j])
+      continue;
+
+    if (!E_M1[my_iindx[j + 1] - seq_length])
+      continue;
+
+    d1  = referenceBPs1[my_iindx[i] - seq_length] - referenceBPs1[my_iindx[i] - j] - referenceBPs1[my_iindx[j + 1] - seq_length];
+    d2  = referenceBPs2[my_iindx[i] - seq_length] - referenceBPs2[my_iindx[i] - j] - referenceBPs2[my_iindx[j + 1] - seq_length];
+
+    for (cnt1 = k_min_M1[my_iindx[i] - j]; cnt1 <= k_max_M1[my_iindx[i] - j]; cnt1++)
+      for (cnt2 = l_min_M1[my_iindx[i] - j][cnt1]; cnt2 <= l_max_M1[my_iindx[i] - j][cnt1]; cnt2 += 2) {
+        for (cnt3 = k_min_M1[my_iindx[j + 1] - seq_length]; cnt3 <= k_max_M1[my_iindx[j + 1] - seq_length]; cnt3++)
+          for (cnt4 = l_min_M1[my_iindx[j + 1] - seq_length][cnt3]; cnt4 <= l_max_M1[my_iindx[j + 1] - seq_length][cnt3]; cnt4 += 2) {
+            if (IN_SCOPE(vc, cnt1 + cnt3 + d1, cnt2 + cnt4 + d2)) {
+              matrices->E_M2[i][cnt1 + cnt3 + d1][(cnt2 + cnt4 + d2) / 2] = MIN2(matrices->E_M2[i][cnt1 + cnt3 + d1][(cnt2 + cnt4 + d2) / 2],
+                                                                                 E_M1[my_iindx[i] - j][cnt1][cnt2 / 2] + E_M1[my_iindx[j + 1] - seq_length][cnt3][cnt4 / 2]
+                                                                                 );
+              updatePosteriorBoundaries(cnt1 + cnt3 + d1,
+                                        cnt2 + cnt4 + d2,
+                                        &min_k_real,
+                                        &max_k_real,
+                                        &min_l_real,
+                                        &max_l_real
+                                        );
+            } else {
+              matrices->E_M2_rem[i] = MIN2(matrices->E_M2_rem[i],
+                                           E_M1[my_iindx[i] - j][cnt1][cnt2 / 2] + E_M1[my_iindx[j + 1] - seq_length][cnt3][cnt4 / 2]
+                                           );
+            }
+          }
+      }
+  }
+
+  /* resize and move memory portions of energy matrix E_M2 */
+  adjustArrayBoundaries(&matrices->E_M2[i],
+                        &matrices->k_min_M2[i],
+                        &matrices->k_max_M2[i],
+                        &matrices->l_min_M2[i],
+                        &matrices->l_max_M2[i],
+                        min_k_real,
+                        max_k_real,
+                        min_l_real,
+                        max_l_real
+                        );
+}
+
+
 PRIVATE void
 adjustArrayBoundaries(int ***array,
                       int *k_min,
@@ -3747,34 +3941,62 @@ adjustArrayBoundaries(int ***array,
                       int *l_min_post,
                       int *l_max_post)
 {
-  int cnt1;
-  int k_diff_pre  = k_min_post - *k_min;
-  int mem_size    = k_max_post - k_min_post + 1;
+  int     cnt1, shift, *row;
+  int     k_diff_pre  = k_min_post - *k_min;
+  int     mem_size    = k_max_post - k_min_post + 1;
+  size_t  src, dst, row_size;
+  char    *block, *tmp;
 
   if (k_min_post < INF) {
-    /* free all the unused memory behind actual data */
-    for (cnt1 = k_max_post + 1; cnt1 <= *k_max; cnt1++) {
-      (*array)[cnt1] += (*l_min)[cnt1] / 2;
-      free((*array)[cnt1]);
+    /*
+     *  compact the actual data within the block allocated by prepareArray().
+     *  Rows are moved towards the front in order of increasing k, so each
+     *  row only overwrites data that has been moved already. The offsets of
+     *  the source rows follow from the previous boundaries, since the row
+     *  pointers themselves may be overwritten in the course
+     */
+    block = (char *)((*array) + *k_min);
+    src   = ROW_POINTERS_SIZE(*k_max - *k_min + 1, int);
+    dst   = ROW_POINTERS_SIZE(mem_size, int);
+
+    for (cnt1 = *k_min; cnt1 <= *k_max; cnt1++) {
+      if ((cnt1 >= k_min_post) && (cnt1 <= k_max_post) && (l_min_post[cnt1] < INF)) {
+        row_size  = (l_max_post[cnt1] - l_min_post[cnt1] + 1) / 2 + 1;
+        shift     = (l_min_post[cnt1] % 2 == (*l_min)[cnt1] % 2) ? 0 : 1;
+        memmove(block + dst,
+                block + src + sizeof(int) * ((l_min_post[cnt1] - (*l_min)[cnt1]) / 2 + shift),
+                sizeof(int) * row_size);
+        dst += sizeof(int) * row_size;
+      }
+
+      src += sizeof(int) * (((*l_max)[cnt1] - (*l_min)[cnt1] + 1) / 2 + 1);
     }
 
-    /* free unused memory before actual data */
-    for (cnt1 = *k_min; cnt1 < k_min_post; cnt1++) {
-      (*array)[cnt1] += (*l_min)[cnt1] / 2;
-      free((*array)[cnt1]);
+    /* release the unused tail of the block */
+    tmp = (char *)realloc(block, dst);
+    if (tmp)
+      block = tmp;
+
+    /* (re-)set the row pointers */
+    *array  = (int **)block - k_min_post;
+    row     = (int *)(block + ROW_POINTERS_SIZE(mem_size, int));
+
+    for (cnt1 = k_min_post; cnt1 <= k_max_post; cnt1++) {
+      if (l_min_post[cnt1] < INF) {
+        (*array)[cnt1]  = row - l_min_post[cnt1] / 2;
+        row             += (l_max_post[cnt1] - l_min_post[cnt1] + 1) / 2 + 1;
+      } else {
+        (*array)[cnt1] = NULL;
+      }
     }
-    /* move data to front and thereby eliminating unused memory in front of actual data */
+
+    /* move boundaries to front and thereby eliminating unused memory in front of actual data */
     if (k_diff_pre > 0) {
-      memmove((int **)(*array), ((int **)(*array)) + k_diff_pre, sizeof(int *) * mem_size);
       memmove((int *)(*l_min), ((int *)(*l_min)) + k_diff_pre, sizeof(int) * mem_size);
       memmove((int *)(*l_max), ((int *)(*l_max)) + k_diff_pre, sizeof(int) * mem_size);
     }
 
     /* reallocating memory to actual size used */
-    *array  += *k_min;
-    *array  = (int **)realloc(*array, sizeof(int *) * mem_size);
-    *array  -= k_min_post;
-
     *l_min  += *k_min;
     *l_min  = (int *)realloc(*l_min, sizeof(int) * mem_size);
     *l_min  -= k_min_post;
@@ -3783,38 +4005,12 @@ adjustArrayBoundaries(int ***array,
     *l_max  = (int *)realloc(*l_max, sizeof(int) * mem_size);
     *l_max  -= k_min_post;
 
-    /* adjust l dimension of array */
     for (cnt1 = k_min_post; cnt1 <= k_max_post; cnt1++) {
-      if (l_min_post[cnt1] < INF) {
-        /* new memsize */
-        mem_size = (l_max_post[cnt1] - l_min_post[cnt1] + 1) / 2 + 1;
-        /* reshift the pointer */
-        (*array)[cnt1] += (*l_min)[cnt1] / 2;
-
-        int shift = (l_min_post[cnt1] % 2 == (*l_min)[cnt1] % 2) ? 0 : 1;
-        /* eliminate unused memory in front of actual data */
-        unsigned int start = (l_min_post[cnt1] - (*l_min)[cnt1]) / 2 + shift;
-        if (start > 0)
-          memmove((int *)((*array)[cnt1]), (int *)((*array)[cnt1]) + start, sizeof(int) * mem_size);
-
-        (*array)[cnt1] = (int *)realloc((*array)[cnt1], sizeof(int) * mem_size);
-
-        (*array)[cnt1] -= l_min_post[cnt1] / 2;
-      } else {
-        /* free according memory */
-        (*array)[cnt1] += (*l_min)[cnt1] / 2;
-        free((*array)[cnt1]);
-      }
-
       (*l_min)[cnt1]  = l_min_post[cnt1];
       (*l_max)[cnt1]  = l_max_post[cnt1];
     }
   } else {
     /* we have to free all unused memory */
-    for (cnt1 = *k_min; cnt1 <= *k_max; cnt1++) {
-      (*array)[cnt1] += (*l_min)[cnt1] / 2;
-      free((*array)[cnt1]);
-    }
     (*l_min)  += *k_min;
     (*l_max)  += *k_min;
     free(*l_min);
@@ -3875,17 +4071,18 @@ updatePosteriorBoundaries(int d1,
 
 
 INLINE PRIVATE void
-prepareBoundaries(int min_k_pre,
-                  int max_k_pre,
-                  int min_l_pre,
-                  int max_l_pre,
-                  int bpdist,
-                  int *min_k,
-                  int *max_k,
-                  int **min_l,
-                  int **max_l)
+prepareBoundaries(vrna_fold_compound_t  *vc,
+                  int                   min_k_pre,
+                  int                   max_k_pre,
+                  int                   min_l_pre,
+                  int                   max_l_pre,
+                  int                   bpdist,
+                  int                   *min_k,
+                  int                   *max_k,
+                  int                   **min_l,
+                  int                   **max_l)
 {
-  int cnt;
+  int cnt, l_lim;
   int mem = max_k_pre - min_k_pre + 1;
 
   *min_k  = min_k_pre;
@@ -3904,10 +4101,27 @@ prepareBoundaries(int min_k_pre,
       (*min_l)[cnt]++;
     if ((bpdist % 2) != (((*min_l)[cnt] + cnt) % 2))
       (*min_l)[cnt]++;
+
+    /* no need to reserve memory for classes out of scope */
+    if ((unsigned int)cnt > vc->maxD1)
+      l_lim = (*min_l)[cnt];
+    else if (vc->band_l_max)
+      l_lim = MIN2((int)vc->maxD2, vc->band_l_max[cnt]);
+    else
+      l_lim = (int)vc->maxD2;
+
+    if ((*max_l)[cnt] > l_lim)
+      (*max_l)[cnt] = MAX2(l_lim, (*min_l)[cnt]);
   }
 }
 
 
+/*
+ *  Allocate a (k,l) matrix as a single memory block. The block starts with
+ *  the (offset) row pointers for each k, followed by the rows themselves.
+ *  Hence, the entire matrix can be released with a single free() of
+ *  (*array) + min_k, and adjustArrayBoundaries() can shrink it in place.
+ */
 INLINE PRIVATE void
 prepareArray(int  ***array,
              int  min_k,
@@ -3915,17 +4129,24 @@ prepareArray(int  ***array,
              int  *min_l,
              int  *max_l)
 {
-  int i, j, mem;
+  int     i, j, mem, *row;
+  size_t  mem_total;
+
+  mem_total = 0;
+  for (i = min_k; i <= max_k; i++)
+    mem_total += (max_l[i] - min_l[i] + 1) / 2 + 1;
 
-  *array  = (int **)vrna_alloc(sizeof(int *) * (max_k - min_k + 1));
+  *array  = (int **)vrna_alloc(ROW_POINTERS_SIZE(max_k - min_k + 1, int) + sizeof(int) * mem_total);
+  row     = (int *)((char *)(*array) + ROW_POINTERS_SIZE(max_k - min_k + 1, int));
   *array  -= min_k;
 
   for (i = min_k; i <= max_k; i++) {
     mem         = (max_l[i] - min_l[i] + 1) / 2 + 1;
-    (*array)[i] = (int *)vrna_alloc(sizeof(int) * mem);
+    (*array)[i] = row;
     for (j = 0; j < mem; j++)
       (*array)[i][j] = INF;
     (*array)[i] -= min_l[i] / 2;
+    row         += mem;
   }
 }
 
@@ -3937,15 +4158,23 @@ prepareArray2(unsigned long ***array,
               int           *min_l,
               int           *max_l)
 {
-  int i, mem;
+  int           i, mem;
+  unsigned long *row;
+  size_t        mem_total;
 
-  *array  = (unsigned long **)vrna_alloc(sizeof(unsigned long *) * (max_k - min_k + 1));
+  mem_total = 0;
+  for (i = min_k; i <= max_k; i++)
+    mem_total += (max_l[i] - min_l[i] + 1) / 2 + 1;
+
+  *array  = (unsigned long **)vrna_alloc(ROW_POINTERS_SIZE(max_k - min_k + 1, unsigned long) +
+                                         sizeof(unsigned long) * mem_total);
+  row     = (unsigned long *)((char *)(*array) + ROW_POINTERS_SIZE(max_k - min_k + 1, unsigned long));
   *array  -= min_k;
 
   for (i = min_k; i <= max_k; i++) {
     mem         = (max_l[i] - min_l[i] + 1) / 2 + 1;
-    (*array)[i] = (unsigned long *)vrna_alloc(sizeof(unsigned long) * mem);
-    (*array)[i] -= min_l[i] / 2;
+    (*array)[i] = row - min_l[i] / 2;
+    row         += mem;
   }
 }
 
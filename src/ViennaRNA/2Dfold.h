@@ -57,6 +57,21 @@ typedef struct vrna_sol_TwoD_t {
 } vrna_sol_TwoD_t;
 
 
+/**
+ *  @brief Callback to decide whether a distance class belongs to a band
+ *
+ *  @see vrna_TwoD_set_band()
+ *
+ *  @param k      Distance to first reference
+ *  @param l      Distance to second reference
+ *  @param data   Auxiliary data as passed to vrna_TwoD_set_band()
+ *  @return       Non-zero if the distance class (k,l) is requested, 0 otherwise
+ */
+typedef int (vrna_callback_TwoD_band)(unsigned int  k,
+                                      unsigned int  l,
+                                      void          *data);
+
+
 /**
  * @brief Compute MFE's and representative for distance partitioning
  *
@@ -82,7 +97,8 @@ typedef struct vrna_sol_TwoD_t {
  *  @param distance1  maximum distance to reference1 (-1 means no restriction)
  *  @param distance2  maximum distance to reference2 (-1 means no restriction)
  *  @return           A list of minimum free energies (and corresponding structures)
- *                    for each distance class
+ *                    for each distance class, or NULL if the distance classes
+ *                    would exceed the memory budget (see vrna_mx_memory_budget_set())
  */
 vrna_sol_TwoD_t *
 vrna_mfe_TwoD(vrna_fold_compound_t  *vc,
@@ -115,6 +131,74 @@ vrna_backtrack5_TwoD(vrna_fold_compound_t *vc,
                      unsigned int         j);
 
 
+/**
+ * @brief Restrict distance class computations to a band of requested classes
+ *
+ * Instead of all distance classes up to the maximum base pair distances, only
+ * the classes (k,l) for which the callback @p in_band returns a non-zero value
+ * are requested from subsequent calls to vrna_mfe_TwoD() and vrna_pf_TwoD(),
+ * e.g. a corridor @f$ k + l \leq c @f$ along a folding path, or a band
+ * @f$ |k - l| \leq c @f$. The callback is evaluated for all classes within the
+ * current maximum base pair distances of @p fc.
+ *
+ * Since the distances of a structure to both references never decrease when
+ * substructures are combined, class (k,l) requires all classes (k',l') with
+ * @f$ k' \leq k @f$ and @f$ l' \leq l @f$. The recursions therefore neither allocate
+ * nor compute any class beyond the largest requested l for each k. Structures
+ * beyond that limit are collected in the class k=l=-1, and only the requested
+ * classes are part of the returned lists. Hence, runtime and memory shrink with
+ * the area of the band only if it is closed towards smaller distances, as for
+ * the corridor above.
+ *
+ * The band must be set before the matrices are filled. Passing NULL as @p in_band
+ * removes any previously set band.
+ *
+ * @see vrna_mfe_TwoD(), vrna_pf_TwoD(), vrna_fold_compound_TwoD()
+ *
+ * @param fc        The fold compound as obtained from vrna_fold_compound_TwoD()
+ * @param in_band   The callback that decides whether a class (k,l) is requested (may be NULL)
+ * @param data      Auxiliary data passed through to @p in_band
+ * @return          1 on success, 0 on error, e.g. if the band is empty
+ */
+int
+vrna_TwoD_set_band(vrna_fold_compound_t     *fc,
+                   vrna_callback_TwoD_band  *in_band,
+                   void                     *data);
+
+
+/**
+ * @brief Set the number of threads used for distance class computations
+ *
+ * The cells of the dynamic programming matrices in vrna_mfe_TwoD() and vrna_pf_TwoD()
+ * are distributed over this number of threads, and so are the samples drawn by
+ * vrna_pbacktrack_TwoD_num(). The setting only affects the fold compound @p fc, i.e.
+ * different fold compounds may be processed with different numbers of threads at the
+ * same time. If the library was compiled with OpenMP support, the threads are taken
+ * from the OpenMP runtime, otherwise POSIX threads are used. The threads are started
+ * once per computation and wait between the diagonals of the matrices.
+ *
+ * @see vrna_TwoD_get_num_threads(), vrna_mfe_TwoD(), vrna_pf_TwoD()
+ *
+ * @param fc            The fold compound as obtained from vrna_fold_compound_TwoD()
+ * @param num_threads   The number of threads (0 to use as many as cores are available)
+ */
+void
+vrna_TwoD_set_num_threads(vrna_fold_compound_t  *fc,
+                          int                   num_threads);
+
+
+/**
+ * @brief Get the number of threads used for distance class computations
+ *
+ * @see vrna_TwoD_set_num_threads()
+ *
+ * @param fc  The fold compound as obtained from vrna_fold_compound_TwoD()
+ * @return    The number of threads
+ */
+int
+vrna_TwoD_get_num_threads(vrna_fold_compound_t *fc);
+
+
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
 #define TwoDfold_solution       vrna_sol_TwoD_t         /* restore compatibility of struct rename */
@@ -20,7 +20,27 @@
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/loops/all.h"
+#include "ViennaRNA/2Dfold.h"
 #include "ViennaRNA/2Dpfold.h"
+#include "ViennaRNA/dp_matrices_hooks.h"
+
+#include "2Dparallel.inc"
+
+/*
+ *  Check whether the distance class (k,l) lies within the scope of the
+ *  computations, i.e. within maxD1, maxD2 (local copies of the respective
+ *  fold compound attributes) and the band restriction (if any)
+ */
+#define IN_SCOPE(vc, k, l)  (((unsigned int)(k) <= maxD1) && \
+                             ((unsigned int)(l) <= maxD2) && \
+                             (!(vc)->band_l_max || ((int)(l) <= (vc)->band_l_max[(k)])))
+
+/*
+ *  Size of the row pointers in front of a (k,l) matrix block, padded such
+ *  that the subsequent rows of the respective type are properly aligned
+ */
+#define ROW_POINTERS_SIZE(num, type)  ((sizeof(type *) * (size_t)(num) + _Alignof(type) - 1) / \
+                                       _Alignof(type) * _Alignof(type))
 
 /*
  #################################
@@ -42,15 +62,102 @@
 PRIVATE void  crosslink(TwoDpfold_vars *vars);
 
 
-PRIVATE void  pf2D_linear(vrna_fold_compound_t *vc);
+PRIVATE void  pf2D_linear(vrna_fold_compound_t *vc,
+                          twoD_pool_t          *pool);
+
+
+PRIVATE void  pf2D_linear_cell(vrna_fold_compound_t *vc,
+                               unsigned int         i,
+                               unsigned int         j);
+
+
+PRIVATE void  pf2D_circ(vrna_fold_compound_t *vc,
+                        twoD_pool_t          *pool);
+
+
+PRIVATE void  pf2D_circ_M2(void         *data,
+                           unsigned int idx);
+
+
+/* partial sums of the exterior loop contributions of a circular RNA, see pf2D_circ() */
+typedef struct {
+  FLT_OR_DBL  **Q_cH;
+  FLT_OR_DBL  **Q_cI;
+  FLT_OR_DBL  **Q_cM;
+  FLT_OR_DBL  Q_cH_rem;
+  FLT_OR_DBL  Q_cI_rem;
+  FLT_OR_DBL  Q_cM_rem;
+  int         k_min_cH, k_max_cH, *l_min_cH, *l_max_cH; /* posterior boundaries */
+  int         k_min_cI, k_max_cI, *l_min_cI, *l_max_cI;
+  int         k_min_cM, k_max_cM, *l_min_cM, *l_max_cM;
+} circ_partial_t;
+
+
+typedef struct {
+  vrna_fold_compound_t  *vc;
+  unsigned int          num;
+  circ_partial_t        *partials;
+  int                   update_cH;
+  int                   update_cI;
+  int                   update_cM;
+} circ_batch_t;
+
+
+PRIVATE void  pf2D_circ_exterior(void         *data,
+                                 unsigned int c);
+
+
+PRIVATE void  pf2D_circ_exterior_pair(circ_batch_t    *batch,
+                                      circ_partial_t  *part,
+                                      unsigned int    p,
+                                      unsigned int    q);
+
+
+PRIVATE void  pf2D_circ_exterior_ML(circ_batch_t    *batch,
+                                    circ_partial_t  *part,
+                                    unsigned int    k);
+
+
+PRIVATE void  prepare_circ_partial(vrna_mx_pf_t   *matrices,
+                                   circ_batch_t   *batch,
+                                   circ_partial_t *part,
+                                   int            size,
+                                   int            shift);
+
+
+PRIVATE void  merge_circ_partial(vrna_mx_pf_t   *matrices,
+                                 circ_batch_t   *batch,
+                                 circ_partial_t *part,
+                                 int            shift);
+
+
+typedef struct {
+  vrna_fold_compound_t  *vc;
+  int                   d1;
+  int                   d2;
+  unsigned short        *seeds;
+  char                  **structures;
+} sample_batch_t;
+
+
+PRIVATE char *pbacktrack5(vrna_fold_compound_t  *vc,
+                          int                   d1,
+                          int                   d2,
+                          unsigned int          length,
+                          unsigned short        *rng);
+
 
+PRIVATE void  sample_job(void         *data,
+                         unsigned int s);
 
-PRIVATE void  pf2D_circ(vrna_fold_compound_t *vc);
+
+PRIVATE INLINE double sample_urn(unsigned short *rng);
 
 
 PRIVATE char *pbacktrack_circ(vrna_fold_compound_t  *vc,
                               int                   d1,
-                              int                   d2);
+                              int                   d2,
+                              unsigned short        *rng);
 
 
 PRIVATE void  backtrack(vrna_fold_compound_t  *vc,
@@ -58,7 +165,8 @@ PRIVATE void  backtrack(vrna_fold_compound_t  *vc,
                         int                   d1,
                         int                   d2,
                         unsigned int          i,
-                        unsigned int          j);
+                        unsigned int          j,
+                        unsigned short        *rng);
 
 
 PRIVATE void  backtrack_qm(vrna_fold_compound_t *vc,
@@ -66,7 +174,8 @@ PRIVATE void  backtrack_qm(vrna_fold_compound_t *vc,
                            int                  d1,
                            int                  d2,
                            unsigned int         i,
-                           unsigned int         j);
+                           unsigned int         j,
+                           unsigned short       *rng);
 
 
 PRIVATE void  backtrack_qm1(vrna_fold_compound_t  *vc,
@@ -74,32 +183,37 @@ PRIVATE void  backtrack_qm1(vrna_fold_compound_t  *vc,
                             int                   d1,
                             int                   d2,
                             unsigned int          i,
-                            unsigned int          j);
+                            unsigned int          j,
+                            unsigned short        *rng);
 
 
 PRIVATE void  backtrack_qm2(vrna_fold_compound_t  *vc,
                             char                  *pstruc,
                             int                   d1,
                             int                   d2,
-                            unsigned int          k);
+                            unsigned int          k,
+                            unsigned short        *rng);
 
 
 PRIVATE void  backtrack_qcH(vrna_fold_compound_t  *vc,
                             char                  *pstruc,
                             int                   d1,
-                            int                   d2);
+                            int                   d2,
+                            unsigned short        *rng);
 
 
 PRIVATE void  backtrack_qcI(vrna_fold_compound_t  *vc,
                             char                  *pstruc,
                             int                   d1,
-                            int                   d2);
+                            int                   d2,
+                            unsigned short        *rng);
 
 
 PRIVATE void  backtrack_qcM(vrna_fold_compound_t  *vc,
                             char                  *pstruc,
                             int                   d1,
-                            int                   d2);
+                            int                   d2,
+                            unsigned short        *rng);
 
 
 PRIVATE void  adjustArrayBoundaries(FLT_OR_DBL  ***array,
@@ -129,15 +243,16 @@ INLINE PRIVATE void  updatePosteriorBoundaries(int  d1,
                                                int  **max_l);
 
 
-INLINE PRIVATE void  prepareBoundaries(int  min_k_pre,
-                                       int  max_k_pre,
-                                       int  min_l_pre,
-                                       int  max_l_pre,
-                                       int  bpdist,
-                                       int  *min_k,
-                                       int  *max_k,
-                                       int  **min_l,
-                                       int  **max_l);
+INLINE PRIVATE void  prepareBoundaries(vrna_fold_compound_t  *vc,
+                                       int                   min_k_pre,
+                                       int                   max_k_pre,
+                                       int                   min_l_pre,
+                                       int                   max_l_pre,
+                                       int                   bpdist,
+                                       int                   *min_k,
+                                       int                   *max_k,
+                                       int                   **min_l,
+                                       int                   **max_l);
 
 
 INLINE PRIVATE void  prepareArray(FLT_OR_DBL  ***array,
@@ -164,6 +279,7 @@ vrna_pf_TwoD(vrna_fold_compound_t *vc,
   vrna_sol_TwoD_pf_t  *output;
   vrna_md_t           *md;
   vrna_mx_pf_t        *matrices;
+  twoD_pool_t         pool;
 
   maxD1     = vc->maxD1;
   maxD2     = vc->maxD2;
@@ -189,11 +305,19 @@ vrna_pf_TwoD(vrna_fold_compound_t *vc,
   vc->maxD1 = maxD1;
   vc->maxD2 = maxD2;
 
+  /* the distance classes are allocated on demand, so check their upper bound against the memory budget first */
+  if (!vrna_mx_TwoD_reserve(vc, VRNA_OPTION_PF))
+    return NULL;
+
   output = (vrna_sol_TwoD_pf_t *)vrna_alloc((((maxD1 + 1) * (maxD2 + 2)) / 2 + 2) * sizeof(vrna_sol_TwoD_pf_t));
 
-  pf2D_linear(vc);
+  twoD_pool_init(&pool, vc);
+
+  pf2D_linear(vc, &pool);
   if (md->circ)
-    pf2D_circ(vc);
+    pf2D_circ(vc, &pool);
+
+  twoD_pool_free(&pool);
 
   ndx   = vc->iindx[1] - vc->length;
   k_min = (md->circ) ? matrices->k_min_Q_c : matrices->k_min_Q[ndx];
@@ -211,6 +335,9 @@ vrna_pf_TwoD(vrna_fold_compound_t *vc,
       if (q == 0.)
         continue;
 
+      if ((vc->band) && (!vc->band[cnt1][cnt2]))
+        continue;
+
       output[counter].k = cnt1;
       output[counter].l = cnt2;
       output[counter].q = q;
@@ -362,16 +489,18 @@ TwoDpfold_circ(TwoDpfold_vars *vars,
 #endif
 
 PRIVATE void
-pf2D_linear(vrna_fold_compound_t *vc)
+pf2D_linear_cell(vrna_fold_compound_t *vc,
+                 unsigned int         i,
+                 unsigned int         j)
 {
   char              *sequence, *ptype;
   short             *S1, *reference_pt1, *reference_pt2;
-  unsigned int      *referenceBPs1, *referenceBPs2,
-                    d, i, j, ij, seq_length, maxD1,
-                    maxD2, *mm1, *mm2, *bpdist;
-  int               *my_iindx, *jindx, circ, cnt1, cnt2, cnt3, cnt4, *rtype;
+  unsigned int      *referenceBPs1, *referenceBPs2, ij, seq_length, maxD1,
+                    maxD2, *mm1, *mm2, *bpdist, k, l, kl, u, ii, dij;
+  int               *my_iindx, *jindx, circ, cnt1, cnt2, cnt3, cnt4, *rtype,
+                    no_close, type, type_2, tt, da, db, base_da, base_db;
   double            max_real;
-  FLT_OR_DBL        *scale, Qmax;
+  FLT_OR_DBL        *scale, Qmax, temp2, aux_en;
   vrna_exp_param_t  *pf_params;
   vrna_mx_pf_t      *matrices;
   vrna_md_t         *md;
@@ -395,106 +524,133 @@ pf2D_linear(vrna_fold_compound_t *vc)
   jindx         = vc->jindx;
   referenceBPs1 = vc->referenceBPs1;
   referenceBPs2 = vc->referenceBPs2;
-  dangles       = md->dangles;
   circ          = md->circ;
   mm1           = vc->mm1;
   mm2           = vc->mm2;
   bpdist        = vc->bpdist;
   Qmax          = 0.;
 
-  /*array initialization ; qb,qm,q
-   * qb,qm,q (i,j) are stored as ((n+1-i)*(n-i) div 2 + n+1-j */
+  ij    = my_iindx[i] - j;
+  dij   = j - i - 1;
+  type  = ptype[jindx[j] + i];
 
-  for (j = 1; j <= seq_length; j++)
-    for (i = (j > TURN ? (j - TURN) : 1); i <= j; i++) {
-      ij                        = my_iindx[i] - j;
-      matrices->k_min_Q[ij]     = 0;
-      matrices->k_max_Q[ij]     = 0;
-      matrices->l_min_Q[ij]     = (int *)vrna_alloc(sizeof(int));
-      matrices->l_max_Q[ij]     = (int *)vrna_alloc(sizeof(int));
-      matrices->l_min_Q[ij][0]  = 0;
-      matrices->l_max_Q[ij][0]  = 0;
-      matrices->Q[ij]           = (FLT_OR_DBL **)vrna_alloc(sizeof(FLT_OR_DBL *));
-      matrices->Q[ij][0]        = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL));
-      matrices->Q[ij][0][0]     = 1.0 * scale[j - i + 1];
-    }
 
+  no_close = (((type == 3) || (type == 4)) && no_closingGU);
 
-  for (d = TURN + 2; d <= seq_length; d++) {
-    /* i,j in [1..seq_length] */
-#ifdef _OPENMP
-#pragma omp parallel for private(i, j, ij, cnt1, cnt2, cnt3, cnt4)
-#endif
-    for (j = d; j <= seq_length; j++) {
-      unsigned int  k, l, kl, u, ii, dij;
-      int           no_close, type, type_2, tt, da, db, base_da, base_db;
-      FLT_OR_DBL    temp2, aux_en;
+  if (type) {
+    /* we have a pair */
 
-      i     = j - d + 1;
-      ij    = my_iindx[i] - j;
-      dij   = j - i - 1;
-      type  = ptype[jindx[j] + i];
+    int k_min_Q_B, k_max_Q_B, l_min_Q_B, l_max_Q_B;
+    int k_min_post_b, k_max_post_b, *l_min_post_b, *l_max_post_b;
+    int update_b = 0;
 
+    if (!matrices->Q_B[ij]) {
+      update_b  = 1;
+      k_min_Q_B = l_min_Q_B = 0;
+      k_max_Q_B = mm1[ij] + referenceBPs1[ij];
+      l_max_Q_B = mm2[ij] + referenceBPs2[ij];
 
-      no_close = (((type == 3) || (type == 4)) && no_closingGU);
+      prepareBoundaries(vc,
+                        k_min_Q_B,
+                        k_max_Q_B,
+                        l_min_Q_B,
+                        l_max_Q_B,
+                        bpdist[ij],
+                        &matrices->k_min_Q_B[ij],
+                        &matrices->k_max_Q_B[ij],
+                        &matrices->l_min_Q_B[ij],
+                        &matrices->l_max_Q_B[ij]
+                        );
+      preparePosteriorBoundaries(matrices->k_max_Q_B[ij] - matrices->k_min_Q_B[ij] + 1,
+                                 matrices->k_min_Q_B[ij],
+                                 &k_min_post_b,
+                                 &k_max_post_b,
+                                 &l_min_post_b,
+                                 &l_max_post_b
+                                 );
 
-      if (type) {
-        /* we have a pair */
-
-        int k_min_Q_B, k_max_Q_B, l_min_Q_B, l_max_Q_B;
-        int k_min_post_b, k_max_post_b, *l_min_post_b, *l_max_post_b;
-        int update_b = 0;
-
-        if (!matrices->Q_B[ij]) {
-          update_b  = 1;
-          k_min_Q_B = l_min_Q_B = 0;
-          k_max_Q_B = mm1[ij] + referenceBPs1[ij];
-          l_max_Q_B = mm2[ij] + referenceBPs2[ij];
-
-          prepareBoundaries(k_min_Q_B,
-                            k_max_Q_B,
-                            l_min_Q_B,
-                            l_max_Q_B,
-                            bpdist[ij],
-                            &matrices->k_min_Q_B[ij],
-                            &matrices->k_max_Q_B[ij],
-                            &matrices->l_min_Q_B[ij],
-                            &matrices->l_max_Q_B[ij]
-                            );
-          preparePosteriorBoundaries(matrices->k_max_Q_B[ij] - matrices->k_min_Q_B[ij] + 1,
-                                     matrices->k_min_Q_B[ij],
-                                     &k_min_post_b,
-                                     &k_max_post_b,
-                                     &l_min_post_b,
-                                     &l_max_post_b
-                                     );
-
-          prepareArray(&matrices->Q_B[ij],
-                       matrices->k_min_Q_B[ij],
-                       matrices->k_max_Q_B[ij],
-                       matrices->l_min_Q_B[ij],
-                       matrices->l_max_Q_B[ij]
-                       );
+      prepareArray(&matrices->Q_B[ij],
+                   matrices->k_min_Q_B[ij],
+                   matrices->k_max_Q_B[ij],
+                   matrices->l_min_Q_B[ij],
+                   matrices->l_max_Q_B[ij]
+                   );
+    }
+
+    /* hairpin ----------------------------------------------*/
+
+    /* get distance to reference if closing the hairpin
+     *  d1a = dbp(T1_{i,j}, {i,j})
+     */
+    base_da = ((unsigned int)reference_pt1[i] != j) ? 1 : -1;
+    base_db = ((unsigned int)reference_pt2[i] != j) ? 1 : -1;
+
+    da  = base_da + referenceBPs1[ij];
+    db  = base_db + referenceBPs2[ij];
+
+    if (!no_close) {
+      if ((da >= 0) && (db >= 0)) {
+        if (IN_SCOPE(vc, da, db)) {
+          matrices->Q_B[ij][da][db / 2] = exp_E_Hairpin(dij, type, S1[i + 1], S1[j - 1], sequence + i - 1, pf_params) * scale[dij + 2];
+          if (update_b) {
+            updatePosteriorBoundaries(da,
+                                      db,
+                                      &k_min_post_b,
+                                      &k_max_post_b,
+                                      &l_min_post_b,
+                                      &l_max_post_b
+                                      );
+          }
+        } else {
+          matrices->Q_B_rem[ij] = exp_E_Hairpin(dij, type, S1[i + 1], S1[j - 1], sequence + i - 1, pf_params) * scale[dij + 2];
         }
+      }
+    }
+
+    /*--------------------------------------------------------
+     *  check for elementary structures involving more than one
+     *  closing pair.
+     *  --------------------------------------------------------*/
+    for (k = i + 1; k <= MIN2(j - 2 - TURN, i + MAXLOOP + 1); k++) {
+      unsigned int minl, ln_pre;
+      minl    = k + TURN + 1;
+      ln_pre  = dij + k;
+      if (ln_pre > minl + MAXLOOP)
+        minl = ln_pre - MAXLOOP - 1;
+
+      for (l = minl; l < j; l++) {
+        kl      = my_iindx[k] - l;
+        type_2  = ptype[jindx[l] + k];
+
+        if (type_2 == 0)
+          continue;
 
-        /* hairpin ----------------------------------------------*/
+        type_2  = rtype[type_2];
+        aux_en  = exp_E_IntLoop(k - i - 1, j - l - 1, type, type_2, S1[i + 1], S1[j - 1], S1[k - 1], S1[l + 1], pf_params) * scale[k - i + j - l];
 
-        /* get distance to reference if closing the hairpin
-         *  d1a = dbp(T1_{i,j}, {i,j})
+        /* get distance to reference if closing the interior loop
+         *  d2 = dbp(S_{i,j}, S_{k,l} + {i,j})
          */
-        base_da = ((unsigned int)reference_pt1[i] != j) ? 1 : -1;
-        base_db = ((unsigned int)reference_pt2[i] != j) ? 1 : -1;
+        da  = base_da + referenceBPs1[ij] - referenceBPs1[kl];
+        db  = base_db + referenceBPs2[ij] - referenceBPs2[kl];
+
+        if (matrices->Q_B_rem[kl])
+          matrices->Q_B_rem[ij] += matrices->Q_B_rem[kl] * aux_en;
 
-        da  = base_da + referenceBPs1[ij];
-        db  = base_db + referenceBPs2[ij];
+        if (!matrices->Q_B[kl])
+          continue;
 
-        if (!no_close) {
-          if ((da >= 0) && (db >= 0)) {
-            if (((unsigned int)da <= maxD1) && ((unsigned int)db <= maxD2)) {
-              matrices->Q_B[ij][da][db / 2] = exp_E_Hairpin(dij, type, S1[i + 1], S1[j - 1], sequence + i - 1, pf_params) * scale[dij + 2];
+        for (cnt1 = matrices->k_min_Q_B[kl];
+             cnt1 <= matrices->k_max_Q_B[kl];
+             cnt1++)
+          for (cnt2 = matrices->l_min_Q_B[kl][cnt1];
+               cnt2 <= matrices->l_max_Q_B[kl][cnt1];
+               cnt2 += 2) {
+            if (IN_SCOPE(vc, cnt1 + da, cnt2 + db)) {
+              matrices->Q_B[ij][cnt1 + da][(cnt2 + db) / 2] += matrices->Q_B[kl][cnt1][cnt2 / 2] * aux_en;
               if (update_b) {
-                updatePosteriorBoundaries(da,
-                                          db,
+                updatePosteriorBoundaries(da + cnt1,
+                                          db + cnt2,
                                           &k_min_post_b,
                                           &k_max_post_b,
                                           &l_min_post_b,
@@ -502,55 +658,76 @@ pf2D_linear(vrna_fold_compound_t *vc)
                                           );
               }
             } else {
-              matrices->Q_B_rem[ij] = exp_E_Hairpin(dij, type, S1[i + 1], S1[j - 1], sequence + i - 1, pf_params) * scale[dij + 2];
+              matrices->Q_B_rem[ij] += matrices->Q_B[kl][cnt1][cnt2 / 2] * aux_en;
             }
           }
-        }
+      } /* end l-loop */
+    }   /* end k-loop */
+
+    /* multi-loop contribution ------------------------*/
+    if (!no_close) {
+      for (u = i + TURN + 2; u < j - TURN - 2; u++) {
+        tt    = rtype[type];
+        temp2 = pf_params->expMLclosing * exp_E_MLstem(tt, S1[j - 1], S1[i + 1], pf_params) * scale[2];
+
+        if (matrices->Q_M_rem[my_iindx[i + 1] - u]) {
+          if (matrices->Q_M1[jindx[j - 1] + u + 1]) {
+            for (cnt1 = matrices->k_min_Q_M1[jindx[j - 1] + u + 1];
+                 cnt1 <= matrices->k_max_Q_M1[jindx[j - 1] + u + 1];
+                 cnt1++)
+              for (cnt2 = matrices->l_min_Q_M1[jindx[j - 1] + u + 1][cnt1];
+                   cnt2 <= matrices->l_max_Q_M1[jindx[j - 1] + u + 1][cnt1];
+                   cnt2 += 2)
+                matrices->Q_B_rem[ij] += matrices->Q_M_rem[my_iindx[i + 1] - u] * matrices->Q_M1[jindx[j - 1] + u + 1][cnt1][cnt2 / 2] * temp2;
+          }
 
-        /*--------------------------------------------------------
-         *  check for elementary structures involving more than one
-         *  closing pair.
-         *  --------------------------------------------------------*/
-        for (k = i + 1; k <= MIN2(j - 2 - TURN, i + MAXLOOP + 1); k++) {
-          unsigned int minl, ln_pre;
-          minl    = k + TURN + 1;
-          ln_pre  = dij + k;
-          if (ln_pre > minl + MAXLOOP)
-            minl = ln_pre - MAXLOOP - 1;
-
-          for (l = minl; l < j; l++) {
-            kl      = my_iindx[k] - l;
-            type_2  = ptype[jindx[l] + k];
-
-            if (type_2 == 0)
-              continue;
+          if (matrices->Q_M1_rem[jindx[j - 1] + u + 1])
+            matrices->Q_B_rem[ij] += matrices->Q_M_rem[my_iindx[i + 1] - u] * matrices->Q_M1_rem[jindx[j - 1] + u + 1] * temp2;
+        }
 
-            type_2  = rtype[type_2];
-            aux_en  = exp_E_IntLoop(k - i - 1, j - l - 1, type, type_2, S1[i + 1], S1[j - 1], S1[k - 1], S1[l + 1], pf_params) * scale[k - i + j - l];
+        if (matrices->Q_M1_rem[jindx[j - 1] + u + 1]) {
+          if (matrices->Q_M[my_iindx[i + 1] - u]) {
+            for (cnt1 = matrices->k_min_Q_M[my_iindx[i + 1] - u];
+                 cnt1 <= matrices->k_max_Q_M[my_iindx[i + 1] - u];
+                 cnt1++)
+              for (cnt2 = matrices->l_min_Q_M[my_iindx[i + 1] - u][cnt1];
+                   cnt2 <= matrices->l_max_Q_M[my_iindx[i + 1] - u][cnt1];
+                   cnt2 += 2)
+                matrices->Q_B_rem[ij] += matrices->Q_M[my_iindx[i + 1] - u][cnt1][cnt2 / 2] * matrices->Q_M1_rem[jindx[j - 1] + u + 1] * temp2;
+          }
+        }
 
-            /* get distance to reference if closing the interior loop
-             *  d2 = dbp(S_{i,j}, S_{k,l} + {i,j})
-             */
-            da  = base_da + referenceBPs1[ij] - referenceBPs1[kl];
-            db  = base_db + referenceBPs2[ij] - referenceBPs2[kl];
+        /* get distance to reference if closing the multiloop
+         *  dist3 = dbp(S_{i,j}, {i,j} + S_{i+1,u} + S_{u+1,j-1})
+         */
+        da  = base_da + referenceBPs1[ij] - referenceBPs1[my_iindx[i + 1] - u] - referenceBPs1[my_iindx[u + 1] - j + 1];
+        db  = base_db + referenceBPs2[ij] - referenceBPs2[my_iindx[i + 1] - u] - referenceBPs2[my_iindx[u + 1] - j + 1];
 
-            if (matrices->Q_B_rem[kl])
-              matrices->Q_B_rem[ij] += matrices->Q_B_rem[kl] * aux_en;
+        if (!matrices->Q_M[my_iindx[i + 1] - u])
+          continue;
 
-            if (!matrices->Q_B[kl])
-              continue;
+        if (!matrices->Q_M1[jindx[j - 1] + u + 1])
+          continue;
 
-            for (cnt1 = matrices->k_min_Q_B[kl];
-                 cnt1 <= matrices->k_max_Q_B[kl];
-                 cnt1++)
-              for (cnt2 = matrices->l_min_Q_B[kl][cnt1];
-                   cnt2 <= matrices->l_max_Q_B[kl][cnt1];
-                   cnt2 += 2) {
-                if (((cnt1 + da) <= maxD1) && ((cnt2 + db) <= maxD2)) {
-                  matrices->Q_B[ij][cnt1 + da][(cnt2 + db) / 2] += matrices->Q_B[kl][cnt1][cnt2 / 2] * aux_en;
+        for (cnt1 = matrices->k_min_Q_M[my_iindx[i + 1] - u];
+             cnt1 <= matrices->k_max_Q_M[my_iindx[i + 1] - u];
+             cnt1++)
+          for (cnt2 = matrices->l_min_Q_M[my_iindx[i + 1] - u][cnt1];
+               cnt2 <= matrices->l_max_Q_M[my_iindx[i + 1] - u][cnt1];
+               cnt2 += 2) {
+            for (cnt3 = matrices->k_min_Q_M1[jindx[j - 1] + u + 1];
+                 cnt3 <= matrices->k_max_Q_M1[jindx[j - 1] + u + 1];
+                 cnt3++)
+              for (cnt4 = matrices->l_min_Q_M1[jindx[j - 1] + u + 1][cnt3];
+                   cnt4 <= matrices->l_max_Q_M1[jindx[j - 1] + u + 1][cnt3];
+                   cnt4 += 2) {
+                if (IN_SCOPE(vc, cnt1 + cnt3 + da, cnt2 + cnt4 + db)) {
+                  matrices->Q_B[ij][cnt1 + cnt3 + da][(cnt2 + cnt4 + db) / 2] += matrices->Q_M[my_iindx[i + 1] - u][cnt1][cnt2 / 2]
+                                                                                 * matrices->Q_M1[jindx[j - 1] + u + 1][cnt3][cnt4 / 2]
+                                                                                 * temp2;
                   if (update_b) {
-                    updatePosteriorBoundaries(da + cnt1,
-                                              db + cnt2,
+                    updatePosteriorBoundaries(cnt1 + cnt3 + da,
+                                              cnt2 + cnt4 + db,
                                               &k_min_post_b,
                                               &k_max_post_b,
                                               &l_min_post_b,
@@ -558,493 +735,492 @@ pf2D_linear(vrna_fold_compound_t *vc)
                                               );
                   }
                 } else {
-                  matrices->Q_B_rem[ij] += matrices->Q_B[kl][cnt1][cnt2 / 2] * aux_en;
+                  matrices->Q_B_rem[ij] += matrices->Q_M[my_iindx[i + 1] - u][cnt1][cnt2 / 2]
+                                           * matrices->Q_M1[jindx[j - 1] + u + 1][cnt3][cnt4 / 2]
+                                           * temp2;
                 }
               }
-          } /* end l-loop */
-        }   /* end k-loop */
-
-        /* multi-loop contribution ------------------------*/
-        if (!no_close) {
-          for (u = i + TURN + 2; u < j - TURN - 2; u++) {
-            tt    = rtype[type];
-            temp2 = pf_params->expMLclosing * exp_E_MLstem(tt, S1[j - 1], S1[i + 1], pf_params) * scale[2];
-
-            if (matrices->Q_M_rem[my_iindx[i + 1] - u]) {
-              if (matrices->Q_M1[jindx[j - 1] + u + 1]) {
-                for (cnt1 = matrices->k_min_Q_M1[jindx[j - 1] + u + 1];
-                     cnt1 <= matrices->k_max_Q_M1[jindx[j - 1] + u + 1];
-                     cnt1++)
-                  for (cnt2 = matrices->l_min_Q_M1[jindx[j - 1] + u + 1][cnt1];
-                       cnt2 <= matrices->l_max_Q_M1[jindx[j - 1] + u + 1][cnt1];
-                       cnt2 += 2)
-                    matrices->Q_B_rem[ij] += matrices->Q_M_rem[my_iindx[i + 1] - u] * matrices->Q_M1[jindx[j - 1] + u + 1][cnt1][cnt2 / 2] * temp2;
-              }
-
-              if (matrices->Q_M1_rem[jindx[j - 1] + u + 1])
-                matrices->Q_B_rem[ij] += matrices->Q_M_rem[my_iindx[i + 1] - u] * matrices->Q_M1_rem[jindx[j - 1] + u + 1] * temp2;
-            }
+          }
+      }
+    }
 
-            if (matrices->Q_M1_rem[jindx[j - 1] + u + 1]) {
-              if (matrices->Q_M[my_iindx[i + 1] - u]) {
-                for (cnt1 = matrices->k_min_Q_M[my_iindx[i + 1] - u];
-                     cnt1 <= matrices->k_max_Q_M[my_iindx[i + 1] - u];
-                     cnt1++)
-                  for (cnt2 = matrices->l_min_Q_M[my_iindx[i + 1] - u][cnt1];
-                       cnt2 <= matrices->l_max_Q_M[my_iindx[i + 1] - u][cnt1];
-                       cnt2 += 2)
-                    matrices->Q_B_rem[ij] += matrices->Q_M[my_iindx[i + 1] - u][cnt1][cnt2 / 2] * matrices->Q_M1_rem[jindx[j - 1] + u + 1] * temp2;
-              }
-            }
+    if (update_b) {
+      adjustArrayBoundaries(&matrices->Q_B[ij],
+                            &matrices->k_min_Q_B[ij],
+                            &matrices->k_max_Q_B[ij],
+                            &matrices->l_min_Q_B[ij],
+                            &matrices->l_max_Q_B[ij],
+                            k_min_post_b,
+                            k_max_post_b,
+                            l_min_post_b,
+                            l_max_post_b
+                            );
+    }
+  } /* end >> if (pair) << */
+
+  /* free ends ? -----------------------------------------*/
+
+  int k_min_Q_M, k_max_Q_M, l_min_Q_M, l_max_Q_M;
+  int k_min_post_m, k_max_post_m, *l_min_post_m, *l_max_post_m;
+  int update_m = 0;
+  int k_min_Q_M1, k_max_Q_M1, l_min_Q_M1, l_max_Q_M1;
+  int k_min_post_m1, k_max_post_m1, *l_min_post_m1, *l_max_post_m1;
+  int update_m1 = 0;
+
+  if (!matrices->Q_M[ij]) {
+    update_m  = 1;
+    k_min_Q_M = l_min_Q_M = 0;
+    k_max_Q_M = mm1[ij] + referenceBPs1[ij];
+    l_max_Q_M = mm2[ij] + referenceBPs2[ij];
+
+    prepareBoundaries(vc,
+                      k_min_Q_M,
+                      k_max_Q_M,
+                      l_min_Q_M,
+                      l_max_Q_M,
+                      bpdist[ij],
+                      &matrices->k_min_Q_M[ij],
+                      &matrices->k_max_Q_M[ij],
+                      &matrices->l_min_Q_M[ij],
+                      &matrices->l_max_Q_M[ij]
+                      );
+    preparePosteriorBoundaries(matrices->k_max_Q_M[ij] - matrices->k_min_Q_M[ij] + 1,
+                               matrices->k_min_Q_M[ij],
+                               &k_min_post_m,
+                               &k_max_post_m,
+                               &l_min_post_m,
+                               &l_max_post_m
+                               );
 
-            /* get distance to reference if closing the multiloop
-             *  dist3 = dbp(S_{i,j}, {i,j} + S_{i+1,u} + S_{u+1,j-1})
-             */
-            da  = base_da + referenceBPs1[ij] - referenceBPs1[my_iindx[i + 1] - u] - referenceBPs1[my_iindx[u + 1] - j + 1];
-            db  = base_db + referenceBPs2[ij] - referenceBPs2[my_iindx[i + 1] - u] - referenceBPs2[my_iindx[u + 1] - j + 1];
+    prepareArray(&matrices->Q_M[ij],
+                 matrices->k_min_Q_M[ij],
+                 matrices->k_max_Q_M[ij],
+                 matrices->l_min_Q_M[ij],
+                 matrices->l_max_Q_M[ij]
+                 );
+  }
 
-            if (!matrices->Q_M[my_iindx[i + 1] - u])
-              continue;
+  if (!matrices->Q_M1[jindx[j] + i]) {
+    update_m1   = 1;
+    k_min_Q_M1  = l_min_Q_M1 = 0;
+    k_max_Q_M1  = mm1[ij] + referenceBPs1[ij];
+    l_max_Q_M1  = mm2[ij] + referenceBPs2[ij];
+
+    prepareBoundaries(vc,
+                      k_min_Q_M1,
+                      k_max_Q_M1,
+                      l_min_Q_M1,
+                      l_max_Q_M1,
+                      bpdist[ij],
+                      &matrices->k_min_Q_M1[jindx[j] + i],
+                      &matrices->k_max_Q_M1[jindx[j] + i],
+                      &matrices->l_min_Q_M1[jindx[j] + i],
+                      &matrices->l_max_Q_M1[jindx[j] + i]
+                      );
+    preparePosteriorBoundaries(matrices->k_max_Q_M1[jindx[j] + i] - matrices->k_min_Q_M1[jindx[j] + i] + 1,
+                               matrices->k_min_Q_M1[jindx[j] + i],
+                               &k_min_post_m1,
+                               &k_max_post_m1,
+                               &l_min_post_m1,
+                               &l_max_post_m1
+                               );
 
-            if (!matrices->Q_M1[jindx[j - 1] + u + 1])
-              continue;
+    prepareArray(&matrices->Q_M1[jindx[j] + i],
+                 matrices->k_min_Q_M1[jindx[j] + i],
+                 matrices->k_max_Q_M1[jindx[j] + i],
+                 matrices->l_min_Q_M1[jindx[j] + i],
+                 matrices->l_max_Q_M1[jindx[j] + i]
+                 );
+  }
 
-            for (cnt1 = matrices->k_min_Q_M[my_iindx[i + 1] - u];
-                 cnt1 <= matrices->k_max_Q_M[my_iindx[i + 1] - u];
-                 cnt1++)
-              for (cnt2 = matrices->l_min_Q_M[my_iindx[i + 1] - u][cnt1];
-                   cnt2 <= matrices->l_max_Q_M[my_iindx[i + 1] - u][cnt1];
-                   cnt2 += 2) {
-                for (cnt3 = matrices->k_min_Q_M1[jindx[j - 1] + u + 1];
-                     cnt3 <= matrices->k_max_Q_M1[jindx[j - 1] + u + 1];
-                     cnt3++)
-                  for (cnt4 = matrices->l_min_Q_M1[jindx[j - 1] + u + 1][cnt3];
-                       cnt4 <= matrices->l_max_Q_M1[jindx[j - 1] + u + 1][cnt3];
-                       cnt4 += 2) {
-                    if (((cnt1 + cnt3 + da) <= maxD1) && ((cnt2 + cnt4 + db) <= maxD2)) {
-                      matrices->Q_B[ij][cnt1 + cnt3 + da][(cnt2 + cnt4 + db) / 2] += matrices->Q_M[my_iindx[i + 1] - u][cnt1][cnt2 / 2]
-                                                                                     * matrices->Q_M1[jindx[j - 1] + u + 1][cnt3][cnt4 / 2]
-                                                                                     * temp2;
-                      if (update_b) {
-                        updatePosteriorBoundaries(cnt1 + cnt3 + da,
-                                                  cnt2 + cnt4 + db,
-                                                  &k_min_post_b,
-                                                  &k_max_post_b,
-                                                  &l_min_post_b,
-                                                  &l_max_post_b
-                                                  );
-                      }
-                    } else {
-                      matrices->Q_B_rem[ij] += matrices->Q_M[my_iindx[i + 1] - u][cnt1][cnt2 / 2]
-                                               * matrices->Q_M1[jindx[j - 1] + u + 1][cnt3][cnt4 / 2]
-                                               * temp2;
-                    }
-                  }
-              }
+  /* j is unpaired */
+  da  = referenceBPs1[ij] - referenceBPs1[ij + 1];
+  db  = referenceBPs2[ij] - referenceBPs2[ij + 1];
+
+  if (matrices->Q_M_rem[ij + 1])
+    matrices->Q_M_rem[ij] += matrices->Q_M_rem[ij + 1] * pf_params->expMLbase * scale[1];
+
+  if (matrices->Q_M[ij + 1]) {
+    for (cnt1 = matrices->k_min_Q_M[ij + 1];
+         cnt1 <= matrices->k_max_Q_M[ij + 1];
+         cnt1++) {
+      for (cnt2 = matrices->l_min_Q_M[ij + 1][cnt1];
+           cnt2 <= matrices->l_max_Q_M[ij + 1][cnt1];
+           cnt2 += 2) {
+        if (IN_SCOPE(vc, cnt1 + da, cnt2 + db)) {
+          matrices->Q_M[ij][cnt1 + da][(cnt2 + db) / 2] += matrices->Q_M[ij + 1][cnt1][cnt2 / 2] * pf_params->expMLbase * scale[1];
+          if (update_m) {
+            updatePosteriorBoundaries(cnt1 + da,
+                                      cnt2 + db,
+                                      &k_min_post_m,
+                                      &k_max_post_m,
+                                      &l_min_post_m,
+                                      &l_max_post_m
+                                      );
           }
+        } else {
+          matrices->Q_M_rem[ij] += matrices->Q_M[ij + 1][cnt1][cnt2 / 2] * pf_params->expMLbase * scale[1];
         }
+      }
+    }
+  }
 
-        if (update_b) {
-          adjustArrayBoundaries(&matrices->Q_B[ij],
-                                &matrices->k_min_Q_B[ij],
-                                &matrices->k_max_Q_B[ij],
-                                &matrices->l_min_Q_B[ij],
-                                &matrices->l_max_Q_B[ij],
-                                k_min_post_b,
-                                k_max_post_b,
-                                l_min_post_b,
-                                l_max_post_b
-                                );
+  if (matrices->Q_M1_rem[jindx[j - 1] + i])
+    matrices->Q_M1_rem[jindx[j] + i] += matrices->Q_M1_rem[jindx[j - 1] + i] * pf_params->expMLbase * scale[1];
+
+  if (matrices->Q_M1[jindx[j - 1] + i]) {
+    for (cnt1 = matrices->k_min_Q_M1[jindx[j - 1] + i];
+         cnt1 <= matrices->k_max_Q_M1[jindx[j - 1] + i];
+         cnt1++)
+      for (cnt2 = matrices->l_min_Q_M1[jindx[j - 1] + i][cnt1];
+           cnt2 <= matrices->l_max_Q_M1[jindx[j - 1] + i][cnt1];
+           cnt2 += 2) {
+        if (IN_SCOPE(vc, cnt1 + da, cnt2 + db)) {
+          matrices->Q_M1[jindx[j] + i][cnt1 + da][(cnt2 + db) / 2] += matrices->Q_M1[jindx[j - 1] + i][cnt1][cnt2 / 2] * pf_params->expMLbase * scale[1];
+          if (update_m1) {
+            updatePosteriorBoundaries(cnt1 + da,
+                                      cnt2 + db,
+                                      &k_min_post_m1,
+                                      &k_max_post_m1,
+                                      &l_min_post_m1,
+                                      &l_max_post_m1
+                                      );
+          }
+        } else {
+          matrices->Q_M1_rem[jindx[j] + i] += matrices->Q_M1[jindx[j - 1] + i][cnt1][cnt2 / 2] * pf_params->expMLbase * scale[1];
         }
-      } /* end >> if (pair) << */
-
-      /* free ends ? -----------------------------------------*/
-
-      int k_min_Q_M, k_max_Q_M, l_min_Q_M, l_max_Q_M;
-      int k_min_post_m, k_max_post_m, *l_min_post_m, *l_max_post_m;
-      int update_m = 0;
-      int k_min_Q_M1, k_max_Q_M1, l_min_Q_M1, l_max_Q_M1;
-      int k_min_post_m1, k_max_post_m1, *l_min_post_m1, *l_max_post_m1;
-      int update_m1 = 0;
-
-      if (!matrices->Q_M[ij]) {
-        update_m  = 1;
-        k_min_Q_M = l_min_Q_M = 0;
-        k_max_Q_M = mm1[ij] + referenceBPs1[ij];
-        l_max_Q_M = mm2[ij] + referenceBPs2[ij];
-
-        prepareBoundaries(k_min_Q_M,
-                          k_max_Q_M,
-                          l_min_Q_M,
-                          l_max_Q_M,
-                          bpdist[ij],
-                          &matrices->k_min_Q_M[ij],
-                          &matrices->k_max_Q_M[ij],
-                          &matrices->l_min_Q_M[ij],
-                          &matrices->l_max_Q_M[ij]
-                          );
-        preparePosteriorBoundaries(matrices->k_max_Q_M[ij] - matrices->k_min_Q_M[ij] + 1,
-                                   matrices->k_min_Q_M[ij],
-                                   &k_min_post_m,
-                                   &k_max_post_m,
-                                   &l_min_post_m,
-                                   &l_max_post_m
-                                   );
-
-        prepareArray(&matrices->Q_M[ij],
-                     matrices->k_min_Q_M[ij],
-                     matrices->k_max_Q_M[ij],
-                     matrices->l_min_Q_M[ij],
-                     matrices->l_max_Q_M[ij]
-                     );
       }
+  }
 
-      if (!matrices->Q_M1[jindx[j] + i]) {
-        update_m1   = 1;
-        k_min_Q_M1  = l_min_Q_M1 = 0;
-        k_max_Q_M1  = mm1[ij] + referenceBPs1[ij];
-        l_max_Q_M1  = mm2[ij] + referenceBPs2[ij];
-
-        prepareBoundaries(k_min_Q_M1,
-                          k_max_Q_M1,
-                          l_min_Q_M1,
-                          l_max_Q_M1,
-                          bpdist[ij],
-                          &matrices->k_min_Q_M1[jindx[j] + i],
-                          &matrices->k_max_Q_M1[jindx[j] + i],
-                          &matrices->l_min_Q_M1[jindx[j] + i],
-                          &matrices->l_max_Q_M1[jindx[j] + i]
-                          );
-        preparePosteriorBoundaries(matrices->k_max_Q_M1[jindx[j] + i] - matrices->k_min_Q_M1[jindx[j] + i] + 1,
-                                   matrices->k_min_Q_M1[jindx[j] + i],
-                                   &k_min_post_m1,
-                                   &k_max_post_m1,
-                                   &l_min_post_m1,
-                                   &l_max_post_m1
-                                   );
-
-        prepareArray(&matrices->Q_M1[jindx[j] + i],
-                     matrices->k_min_Q_M1[jindx[j] + i],
-                     matrices->k_max_Q_M1[jindx[j] + i],
-                     matrices->l_min_Q_M1[jindx[j] + i],
-                     matrices->l_max_Q_M1[jindx[j] + i]
-                     );
-      }
+  /* j pairs with i */
+  if ((!no_close) && type) {
+    FLT_OR_DBL aux_en = exp_E_MLstem(type, (i > 1) || circ ? S1[i - 1] : -1, (j < seq_length) || circ ? S1[j + 1] : -1, pf_params);
 
-      /* j is unpaired */
-      da  = referenceBPs1[ij] - referenceBPs1[ij + 1];
-      db  = referenceBPs2[ij] - referenceBPs2[ij + 1];
+    if (matrices->Q_B_rem[ij]) {
+      matrices->Q_M_rem[ij]             += matrices->Q_B_rem[ij] * aux_en;
+      matrices->Q_M1_rem[jindx[j] + i]  += matrices->Q_B_rem[ij] * aux_en;
+    }
 
-      if (matrices->Q_M_rem[ij + 1])
-        matrices->Q_M_rem[ij] += matrices->Q_M_rem[ij + 1] * pf_params->expMLbase * scale[1];
+    if (matrices->Q_B[ij]) {
+      for (cnt1 = matrices->k_min_Q_B[ij];
+           cnt1 <= matrices->k_max_Q_B[ij];
+           cnt1++)
+        for (cnt2 = matrices->l_min_Q_B[ij][cnt1];
+             cnt2 <= matrices->l_max_Q_B[ij][cnt1];
+             cnt2 += 2) {
+          matrices->Q_M[ij][cnt1][cnt2 / 2] += matrices->Q_B[ij][cnt1][cnt2 / 2] * aux_en;
+          if (update_m) {
+            updatePosteriorBoundaries(cnt1,
+                                      cnt2,
+                                      &k_min_post_m,
+                                      &k_max_post_m,
+                                      &l_min_post_m,
+                                      &l_max_post_m
+                                      );
+          }
 
-      if (matrices->Q_M[ij + 1]) {
-        for (cnt1 = matrices->k_min_Q_M[ij + 1];
-             cnt1 <= matrices->k_max_Q_M[ij + 1];
-             cnt1++) {
-          for (cnt2 = matrices->l_min_Q_M[ij + 1][cnt1];
-               cnt2 <= matrices->l_max_Q_M[ij + 1][cnt1];
-               cnt2 += 2) {
-            if (((cnt1 + da) <= maxD1) && ((cnt2 + db) <= maxD2)) {
-              matrices->Q_M[ij][cnt1 + da][(cnt2 + db) / 2] += matrices->Q_M[ij + 1][cnt1][cnt2 / 2] * pf_params->expMLbase * scale[1];
-              if (update_m) {
-                updatePosteriorBoundaries(cnt1 + da,
-                                          cnt2 + db,
-                                          &k_min_post_m,
-                                          &k_max_post_m,
-                                          &l_min_post_m,
-                                          &l_max_post_m
-                                          );
-              }
-            } else {
-              matrices->Q_M_rem[ij] += matrices->Q_M[ij + 1][cnt1][cnt2 / 2] * pf_params->expMLbase * scale[1];
-            }
+          matrices->Q_M1[jindx[j] + i][cnt1][cnt2 / 2] += matrices->Q_B[ij][cnt1][cnt2 / 2] * aux_en;
+          if (update_m1) {
+            updatePosteriorBoundaries(cnt1,
+                                      cnt2,
+                                      &k_min_post_m1,
+                                      &k_max_post_m1,
+                                      &l_min_post_m1,
+                                      &l_max_post_m1
+                                      );
           }
         }
-      }
+    }
+  }
 
-      if (matrices->Q_M1_rem[jindx[j - 1] + i])
-        matrices->Q_M1_rem[jindx[j] + i] += matrices->Q_M1_rem[jindx[j - 1] + i] * pf_params->expMLbase * scale[1];
+  /* j pairs with k: i<k<j */
+  ii = my_iindx[i];
+  for (k = i + 1; k <= j; k++) {
+    tt    = ptype[jindx[j] + k];
+    temp2 = exp_E_MLstem(tt, S1[k - 1], (j < seq_length) || circ ? S1[j + 1] : -1, pf_params);
 
-      if (matrices->Q_M1[jindx[j - 1] + i]) {
-        for (cnt1 = matrices->k_min_Q_M1[jindx[j - 1] + i];
-             cnt1 <= matrices->k_max_Q_M1[jindx[j - 1] + i];
+    if (matrices->Q_B_rem[my_iindx[k] - j]) {
+      matrices->Q_M_rem[ij] += matrices->Q_B_rem[my_iindx[k] - j] * pow(pf_params->expMLbase, (double)(k - i)) * scale[k - i] * temp2;
+      if (matrices->Q_M[ii - k + 1]) {
+        for (cnt1 = matrices->k_min_Q_M[ii - k + 1];
+             cnt1 <= matrices->k_max_Q_M[ii - k + 1];
              cnt1++)
-          for (cnt2 = matrices->l_min_Q_M1[jindx[j - 1] + i][cnt1];
-               cnt2 <= matrices->l_max_Q_M1[jindx[j - 1] + i][cnt1];
-               cnt2 += 2) {
-            if (((cnt1 + da) <= maxD1) && ((cnt2 + db) <= maxD2)) {
-              matrices->Q_M1[jindx[j] + i][cnt1 + da][(cnt2 + db) / 2] += matrices->Q_M1[jindx[j - 1] + i][cnt1][cnt2 / 2] * pf_params->expMLbase * scale[1];
-              if (update_m1) {
-                updatePosteriorBoundaries(cnt1 + da,
-                                          cnt2 + db,
-                                          &k_min_post_m1,
-                                          &k_max_post_m1,
-                                          &l_min_post_m1,
-                                          &l_max_post_m1
-                                          );
-              }
-            } else {
-              matrices->Q_M1_rem[jindx[j] + i] += matrices->Q_M1[jindx[j - 1] + i][cnt1][cnt2 / 2] * pf_params->expMLbase * scale[1];
-            }
-          }
+          for (cnt2 = matrices->l_min_Q_M[ii - k + 1][cnt1];
+               cnt2 <= matrices->l_max_Q_M[ii - k + 1][cnt1];
+               cnt2 += 2)
+            matrices->Q_M_rem[ij] += matrices->Q_M[ii - k + 1][cnt1][cnt2 / 2] * matrices->Q_B_rem[my_iindx[k] - j] * temp2;
       }
 
-      /* j pairs with i */
-      if ((!no_close) && type) {
-        FLT_OR_DBL aux_en = exp_E_MLstem(type, (i > 1) || circ ? S1[i - 1] : -1, (j < seq_length) || circ ? S1[j + 1] : -1, pf_params);
+      if (matrices->Q_M_rem[ii - k + 1])
+        matrices->Q_M_rem[ij] += matrices->Q_M_rem[ii - k + 1] * matrices->Q_B_rem[my_iindx[k] - j] * temp2;
+    }
+
+    if (matrices->Q_M_rem[ii - k + 1]) {
+      if (matrices->Q_B[my_iindx[k] - j]) {
+        for (cnt1 = matrices->k_min_Q_B[my_iindx[k] - j];
+             cnt1 <= matrices->k_max_Q_B[my_iindx[k] - j];
+             cnt1++)
+          for (cnt2 = matrices->l_min_Q_B[my_iindx[k] - j][cnt1];
+               cnt2 <= matrices->l_max_Q_B[my_iindx[k] - j][cnt1];
+               cnt2 += 2)
+            matrices->Q_M_rem[ij] += matrices->Q_M_rem[my_iindx[k] - j] * matrices->Q_B[my_iindx[k] - j][cnt1][cnt2 / 2] * temp2;
+      }
+    }
 
-        if (matrices->Q_B_rem[ij]) {
-          matrices->Q_M_rem[ij]             += matrices->Q_B_rem[ij] * aux_en;
-          matrices->Q_M1_rem[jindx[j] + i]  += matrices->Q_B_rem[ij] * aux_en;
+    /* add contributions of QM(i,k-1)*QB(k,j)*e^b and
+     *  e^((k-i) * c) * QB(k,j) * e^b
+     *  therefor we need d1a = dbp(T1_{i,j}, T1_{i,k-1} + T1_{k,j}),
+     *  d1b = dbp(T2_{i,j}, T2_{i,k-1} + T2_{k,j})
+     *  d1c = dbp(T1_{i,j}, T1_{k,j})circ = 0;
+     *  d1d = dbp(T2_{i,j}, T2_{k,j})
+     */
+    da  = referenceBPs1[ij] - referenceBPs1[my_iindx[k] - j];
+    db  = referenceBPs2[ij] - referenceBPs2[my_iindx[k] - j];
+
+    if (!matrices->Q_B[my_iindx[k] - j])
+      continue;
+
+    for (cnt1 = matrices->k_min_Q_B[my_iindx[k] - j];
+         cnt1 <= matrices->k_max_Q_B[my_iindx[k] - j];
+         cnt1++)
+      for (cnt2 = matrices->l_min_Q_B[my_iindx[k] - j][cnt1];
+           cnt2 <= matrices->l_max_Q_B[my_iindx[k] - j][cnt1];
+           cnt2 += 2) {
+        if (IN_SCOPE(vc, cnt1 + da, cnt2 + db)) {
+          matrices->Q_M[ij][cnt1 + da][(cnt2 + db) / 2] += matrices->Q_B[my_iindx[k] - j][cnt1][cnt2 / 2] * pow(pf_params->expMLbase, (double)(k - i)) * scale[k - i] * temp2;
+          if (update_m) {
+            updatePosteriorBoundaries(cnt1 + da,
+                                      cnt2 + db,
+                                      &k_min_post_m,
+                                      &k_max_post_m,
+                                      &l_min_post_m,
+                                      &l_max_post_m
+                                      );
+          }
+        } else {
+          matrices->Q_M_rem[ij] += matrices->Q_B[my_iindx[k] - j][cnt1][cnt2 / 2] * pow(pf_params->expMLbase, (double)(k - i)) * scale[k - i] * temp2;
         }
+      }
 
-        if (matrices->Q_B[ij]) {
-          for (cnt1 = matrices->k_min_Q_B[ij];
-               cnt1 <= matrices->k_max_Q_B[ij];
-               cnt1++)
-            for (cnt2 = matrices->l_min_Q_B[ij][cnt1];
-                 cnt2 <= matrices->l_max_Q_B[ij][cnt1];
-                 cnt2 += 2) {
-              matrices->Q_M[ij][cnt1][cnt2 / 2] += matrices->Q_B[ij][cnt1][cnt2 / 2] * aux_en;
+    if (!matrices->Q_M[ii - k + 1])
+      continue;
+
+    da  -= referenceBPs1[ii - k + 1];
+    db  -= referenceBPs2[ii - k + 1];
+
+    for (cnt1 = matrices->k_min_Q_M[ii - k + 1];
+         cnt1 <= matrices->k_max_Q_M[ii - k + 1];
+         cnt1++)
+      for (cnt2 = matrices->l_min_Q_M[ii - k + 1][cnt1];
+           cnt2 <= matrices->l_max_Q_M[ii - k + 1][cnt1];
+           cnt2 += 2)
+        for (cnt3 = matrices->k_min_Q_B[my_iindx[k] - j];
+             cnt3 <= matrices->k_max_Q_B[my_iindx[k] - j];
+             cnt3++)
+          for (cnt4 = matrices->l_min_Q_B[my_iindx[k] - j][cnt3];
+               cnt4 <= matrices->l_max_Q_B[my_iindx[k] - j][cnt3];
+               cnt4 += 2) {
+            if (IN_SCOPE(vc, cnt1 + cnt3 + da, cnt2 + cnt4 + db)) {
+              matrices->Q_M[ij][cnt1 + cnt3 + da][(cnt2 + cnt4 + db) / 2] += matrices->Q_M[ii - k + 1][cnt1][cnt2 / 2] * matrices->Q_B[my_iindx[k] - j][cnt3][cnt4 / 2] * temp2;
               if (update_m) {
-                updatePosteriorBoundaries(cnt1,
-                                          cnt2,
+                updatePosteriorBoundaries(cnt1 + cnt3 + da,
+                                          cnt2 + cnt4 + db,
                                           &k_min_post_m,
                                           &k_max_post_m,
                                           &l_min_post_m,
                                           &l_max_post_m
                                           );
               }
-
-              matrices->Q_M1[jindx[j] + i][cnt1][cnt2 / 2] += matrices->Q_B[ij][cnt1][cnt2 / 2] * aux_en;
-              if (update_m1) {
-                updatePosteriorBoundaries(cnt1,
-                                          cnt2,
-                                          &k_min_post_m1,
-                                          &k_max_post_m1,
-                                          &l_min_post_m1,
-                                          &l_max_post_m1
-                                          );
-              }
+            } else {
+              matrices->Q_M_rem[ij] += matrices->Q_M[ii - k + 1][cnt1][cnt2 / 2] * matrices->Q_B[my_iindx[k] - j][cnt3][cnt4 / 2] * temp2;
             }
-        }
-      }
-
-      /* j pairs with k: i<k<j */
-      ii = my_iindx[i];
-      for (k = i + 1; k <= j; k++) {
-        tt    = ptype[jindx[j] + k];
-        temp2 = exp_E_MLstem(tt, S1[k - 1], (j < seq_length) || circ ? S1[j + 1] : -1, pf_params);
-
-        if (matrices->Q_B_rem[my_iindx[k] - j]) {
-          matrices->Q_M_rem[ij] += matrices->Q_B_rem[my_iindx[k] - j] * pow(pf_params->expMLbase, (double)(k - i)) * scale[k - i] * temp2;
-          if (matrices->Q_M[ii - k + 1]) {
-            for (cnt1 = matrices->k_min_Q_M[ii - k + 1];
-                 cnt1 <= matrices->k_max_Q_M[ii - k + 1];
-                 cnt1++)
-              for (cnt2 = matrices->l_min_Q_M[ii - k + 1][cnt1];
-                   cnt2 <= matrices->l_max_Q_M[ii - k + 1][cnt1];
-                   cnt2 += 2)
-                matrices->Q_M_rem[ij] += matrices->Q_M[ii - k + 1][cnt1][cnt2 / 2] * matrices->Q_B_rem[my_iindx[k] - j] * temp2;
           }
+  }
 
-          if (matrices->Q_M_rem[ii - k + 1])
-            matrices->Q_M_rem[ij] += matrices->Q_M_rem[ii - k + 1] * matrices->Q_B_rem[my_iindx[k] - j] * temp2;
-        }
+  if (update_m) {
+    adjustArrayBoundaries(&matrices->Q_M[ij],
+                          &matrices->k_min_Q_M[ij],
+                          &matrices->k_max_Q_M[ij],
+                          &matrices->l_min_Q_M[ij],
+                          &matrices->l_max_Q_M[ij],
+                          k_min_post_m,
+                          k_max_post_m,
+                          l_min_post_m,
+                          l_max_post_m
+                          );
+  }
 
-        if (matrices->Q_M_rem[ii - k + 1]) {
-          if (matrices->Q_B[my_iindx[k] - j]) {
-            for (cnt1 = matrices->k_min_Q_B[my_iindx[k] - j];
-                 cnt1 <= matrices->k_max_Q_B[my_iindx[k] - j];
-                 cnt1++)
-              for (cnt2 = matrices->l_min_Q_B[my_iindx[k] - j][cnt1];
-                   cnt2 <= matrices->l_max_Q_B[my_iindx[k] - j][cnt1];
-                   cnt2 += 2)
-                matrices->Q_M_rem[ij] += matrices->Q_M_rem[my_iindx[k] - j] * matrices->Q_B[my_iindx[k] - j][cnt1][cnt2 / 2] * temp2;
+  if (update_m1) {
+    adjustArrayBoundaries(&matrices->Q_M1[jindx[j] + i],
+                          &matrices->k_min_Q_M1[jindx[j] + i],
+                          &matrices->k_max_Q_M1[jindx[j] + i],
+                          &matrices->l_min_Q_M1[jindx[j] + i],
+                          &matrices->l_max_Q_M1[jindx[j] + i],
+                          k_min_post_m1,
+                          k_max_post_m1,
+                          l_min_post_m1,
+                          l_max_post_m1
+                          );
+  }
+
+  /* compute contributions for Q(i,j) */
+  int k_min, k_max, l_min, l_max;
+  int k_min_post, k_max_post, *l_min_post, *l_max_post;
+  int update_q = 0;
+  if (!matrices->Q[ij]) {
+    update_q  = 1;
+    k_min     = l_min = 0;
+    k_max     = mm1[ij] + referenceBPs1[ij];
+    l_max     = mm2[ij] + referenceBPs2[ij];
+
+    prepareBoundaries(vc,
+                      k_min,
+                      k_max,
+                      l_min,
+                      l_max,
+                      bpdist[ij],
+                      &matrices->k_min_Q[ij],
+                      &matrices->k_max_Q[ij],
+                      &matrices->l_min_Q[ij],
+                      &matrices->l_max_Q[ij]
+                      );
+    preparePosteriorBoundaries(matrices->k_max_Q[ij] - matrices->k_min_Q[ij] + 1,
+                               matrices->k_min_Q[ij],
+                               &k_min_post,
+                               &k_max_post,
+                               &l_min_post,
+                               &l_max_post
+                               );
+
+    prepareArray(&matrices->Q[ij],
+                 matrices->k_min_Q[ij],
+                 matrices->k_max_Q[ij],
+                 matrices->l_min_Q[ij],
+                 matrices->l_max_Q[ij]
+                 );
+  }
+
+  if (type) {
+    aux_en = exp_E_ExtLoop(type, (i > 1) || circ ? S1[i - 1] : -1, (j < seq_length) || circ ? S1[j + 1] : -1, pf_params);
+
+    if (matrices->Q_B_rem[ij])
+      matrices->Q_rem[ij] += matrices->Q_B_rem[ij] * aux_en;
+
+    if (matrices->Q_B[ij]) {
+      for (cnt1 = matrices->k_min_Q_B[ij];
+           cnt1 <= matrices->k_max_Q_B[ij];
+           cnt1++)
+        for (cnt2 = matrices->l_min_Q_B[ij][cnt1];
+             cnt2 <= matrices->l_max_Q_B[ij][cnt1];
+             cnt2 += 2) {
+          matrices->Q[ij][cnt1][cnt2 / 2] += matrices->Q_B[ij][cnt1][cnt2 / 2] * aux_en;
+          if (update_q) {
+            updatePosteriorBoundaries(cnt1,
+                                      cnt2,
+                                      &k_min_post,
+                                      &k_max_post,
+                                      &l_min_post,
+                                      &l_max_post
+                                      );
           }
         }
+    }
+  }
 
-        /* add contributions of QM(i,k-1)*QB(k,j)*e^b and
-         *  e^((k-i) * c) * QB(k,j) * e^b
-         *  therefor we need d1a = dbp(T1_{i,j}, T1_{i,k-1} + T1_{k,j}),
-         *  d1b = dbp(T2_{i,j}, T2_{i,k-1} + T2_{k,j})
-         *  d1c = dbp(T1_{i,j}, T1_{k,j})circ = 0;
-         *  d1d = dbp(T2_{i,j}, T2_{k,j})
-         */
-        da  = referenceBPs1[ij] - referenceBPs1[my_iindx[k] - j];
-        db  = referenceBPs2[ij] - referenceBPs2[my_iindx[k] - j];
+  /* j is unpaired */
+  if (matrices->Q_rem[ij + 1])
+    matrices->Q_rem[ij] += matrices->Q_rem[ij + 1] * scale[1];
+
+  /* da = dbp(T1_{i,j}, T1_{i,j-1})
+   *  db = dbp(T2_{i,j}, T2_{i,j-1})
+   */
+  da  = referenceBPs1[ij] - referenceBPs1[ij + 1];
+  db  = referenceBPs2[ij] - referenceBPs2[ij + 1];
+  if (matrices->Q[ij + 1]) {
+    for (cnt1 = matrices->k_min_Q[ij + 1];
+         cnt1 <= matrices->k_max_Q[ij + 1];
+         cnt1++)
+      for (cnt2 = matrices->l_min_Q[ij + 1][cnt1];
+           cnt2 <= matrices->l_max_Q[ij + 1][cnt1];
+           cnt2 += 2) {
+        if (IN_SCOPE(vc, cnt1 + da, cnt2 + db)) {
+          matrices->Q[ij][cnt1 + da][(cnt2 + db) / 2] += matrices->Q[ij + 1][cnt1][cnt2 / 2] * scale[1];
+          if (update_q) {
+            updatePosteriorBoundaries(cnt1 + da,
+                                      cnt2 + db,
+                                      &k_min_post,
+                                      &k_max_post,
+                                      &l_min_post,
+                                      &l_max_post
+                                      );
+          }
+        } else {
+          matrices->Q_rem[ij] += matrices->Q[ij + 1][cnt1][cnt2 / 2] * scale[1];
+        }
+      }
+  }
 
-        if (!matrices->Q_B[my_iindx[k] - j])
-          continue;
+  for (k = j - TURN - 1; k > i; k--) {
+    tt    = ptype[jindx[j] + k];
+    temp2 = exp_E_ExtLoop(tt, S1[k - 1], (j < seq_length) || circ ? S1[j + 1] : -1, pf_params);
 
+    if (matrices->Q_rem[my_iindx[i] - k + 1]) {
+      if (matrices->Q_B[my_iindx[k] - j]) {
         for (cnt1 = matrices->k_min_Q_B[my_iindx[k] - j];
              cnt1 <= matrices->k_max_Q_B[my_iindx[k] - j];
              cnt1++)
           for (cnt2 = matrices->l_min_Q_B[my_iindx[k] - j][cnt1];
                cnt2 <= matrices->l_max_Q_B[my_iindx[k] - j][cnt1];
-               cnt2 += 2) {
-            if (((cnt1 + da) <= maxD1) && ((cnt2 + db) <= maxD2)) {
-              matrices->Q_M[ij][cnt1 + da][(cnt2 + db) / 2] += matrices->Q_B[my_iindx[k] - j][cnt1][cnt2 / 2] * pow(pf_params->expMLbase, (double)(k - i)) * scale[k - i] * temp2;
-              if (update_m) {
-                updatePosteriorBoundaries(cnt1 + da,
-                                          cnt2 + db,
-                                          &k_min_post_m,
-                                          &k_max_post_m,
-                                          &l_min_post_m,
-                                          &l_max_post_m
-                                          );
-              }
-            } else {
-              matrices->Q_M_rem[ij] += matrices->Q_B[my_iindx[k] - j][cnt1][cnt2 / 2] * pow(pf_params->expMLbase, (double)(k - i)) * scale[k - i] * temp2;
-            }
-          }
-
-        if (!matrices->Q_M[ii - k + 1])
-          continue;
-
-        da  -= referenceBPs1[ii - k + 1];
-        db  -= referenceBPs2[ii - k + 1];
-
-        for (cnt1 = matrices->k_min_Q_M[ii - k + 1];
-             cnt1 <= matrices->k_max_Q_M[ii - k + 1];
-             cnt1++)
-          for (cnt2 = matrices->l_min_Q_M[ii - k + 1][cnt1];
-               cnt2 <= matrices->l_max_Q_M[ii - k + 1][cnt1];
                cnt2 += 2)
-            for (cnt3 = matrices->k_min_Q_B[my_iindx[k] - j];
-                 cnt3 <= matrices->k_max_Q_B[my_iindx[k] - j];
-                 cnt3++)
-              for (cnt4 = matrices->l_min_Q_B[my_iindx[k] - j][cnt3];
-                   cnt4 <= matrices->l_max_Q_B[my_iindx[k] - j][cnt3];
-                   cnt4 += 2) {
-                if (((cnt1 + cnt3 + da) <= maxD1) && ((cnt2 + cnt4 + db) <= maxD2)) {
-                  matrices->Q_M[ij][cnt1 + cnt3 + da][(cnt2 + cnt4 + db) / 2] += matrices->Q_M[ii - k + 1][cnt1][cnt2 / 2] * matrices->Q_B[my_iindx[k] - j][cnt3][cnt4 / 2] * temp2;
-                  if (update_m) {
-                    updatePosteriorBoundaries(cnt1 + cnt3 + da,
-                                              cnt2 + cnt4 + db,
-                                              &k_min_post_m,
-                                              &k_max_post_m,
-                                              &l_min_post_m,
-                                              &l_max_post_m
-                                              );
-                  }
-                } else {
-                  matrices->Q_M_rem[ij] += matrices->Q_M[ii - k + 1][cnt1][cnt2 / 2] * matrices->Q_B[my_iindx[k] - j][cnt3][cnt4 / 2] * temp2;
-                }
-              }
-      }
-
-      if (update_m) {
-        adjustArrayBoundaries(&matrices->Q_M[ij],
-                              &matrices->k_min_Q_M[ij],
-                              &matrices->k_max_Q_M[ij],
-                              &matrices->l_min_Q_M[ij],
-                              &matrices->l_max_Q_M[ij],
-                              k_min_post_m,
-                              k_max_post_m,
-                              l_min_post_m,
-                              l_max_post_m
-                              );
-      }
-
-      if (update_m1) {
-        adjustArrayBoundaries(&matrices->Q_M1[jindx[j] + i],
-                              &matrices->k_min_Q_M1[jindx[j] + i],
-                              &matrices->k_max_Q_M1[jindx[j] + i],
-                              &matrices->l_min_Q_M1[jindx[j] + i],
-                              &matrices->l_max_Q_M1[jindx[j] + i],
-                              k_min_post_m1,
-                              k_max_post_m1,
-                              l_min_post_m1,
-                              l_max_post_m1
-                              );
-      }
-
-      /* compute contributions for Q(i,j) */
-      int k_min, k_max, l_min, l_max;
-      int k_min_post, k_max_post, *l_min_post, *l_max_post;
-      int update_q = 0;
-      if (!matrices->Q[ij]) {
-        update_q  = 1;
-        k_min     = l_min = 0;
-        k_max     = mm1[ij] + referenceBPs1[ij];
-        l_max     = mm2[ij] + referenceBPs2[ij];
-
-        prepareBoundaries(k_min,
-                          k_max,
-                          l_min,
-                          l_max,
-                          bpdist[ij],
-                          &matrices->k_min_Q[ij],
-                          &matrices->k_max_Q[ij],
-                          &matrices->l_min_Q[ij],
-                          &matrices->l_max_Q[ij]
-                          );
-        preparePosteriorBoundaries(matrices->k_max_Q[ij] - matrices->k_min_Q[ij] + 1,
-                                   matrices->k_min_Q[ij],
-                                   &k_min_post,
-                                   &k_max_post,
-                                   &l_min_post,
-                                   &l_max_post
-                                   );
-
-        prepareArray(&matrices->Q[ij],
-                     matrices->k_min_Q[ij],
-                     matrices->k_max_Q[ij],
-                     matrices->l_min_Q[ij],
-                     matrices->l_max_Q[ij]
-                     );
+            matrices->Q_rem[ij] += matrices->Q_rem[my_iindx[i] - k + 1] * matrices->Q_B[my_iindx[k] - j][cnt1][cnt2 / 2] * temp2;
       }
 
-      if (type) {
-        aux_en = exp_E_ExtLoop(type, (i > 1) || circ ? S1[i - 1] : -1, (j < seq_length) || circ ? S1[j + 1] : -1, pf_params);
-
-        if (matrices->Q_B_rem[ij])
-          matrices->Q_rem[ij] += matrices->Q_B_rem[ij] * aux_en;
+      if (matrices->Q_B_rem[my_iindx[k] - j])
+        matrices->Q_rem[ij] += matrices->Q_rem[my_iindx[i] - k + 1] * matrices->Q_B_rem[my_iindx[k] - j] * temp2;
+    }
 
-        if (matrices->Q_B[ij]) {
-          for (cnt1 = matrices->k_min_Q_B[ij];
-               cnt1 <= matrices->k_max_Q_B[ij];
-               cnt1++)
-            for (cnt2 = matrices->l_min_Q_B[ij][cnt1];
-                 cnt2 <= matrices->l_max_Q_B[ij][cnt1];
-                 cnt2 += 2) {
-              matrices->Q[ij][cnt1][cnt2 / 2] += matrices->Q_B[ij][cnt1][cnt2 / 2] * aux_en;
-              if (update_q) {
-                updatePosteriorBoundaries(cnt1,
-                                          cnt2,
-                                          &k_min_post,
-                                          &k_max_post,
-                                          &l_min_post,
-                                          &l_max_post
-                                          );
-              }
-            }
-        }
+    if (matrices->Q_B_rem[my_iindx[k] - j]) {
+      if (matrices->Q[my_iindx[i] - k + 1]) {
+        for (cnt1 = matrices->k_min_Q[my_iindx[i] - k + 1];
+             cnt1 <= matrices->k_max_Q[my_iindx[i] - k + 1];
+             cnt1++)
+          for (cnt2 = matrices->l_min_Q[my_iindx[i] - k + 1][cnt1];
+               cnt2 <= matrices->l_max_Q[my_iindx[i] - k + 1][cnt1];
+               cnt2 += 2)
+            matrices->Q_rem[ij] += matrices->Q[my_iindx[i] - k + 1][cnt1][cnt2 / 2] * matrices->Q_B_rem[my_iindx[k] - j] * temp2;
       }
+    }
 
-      /* j is unpaired */
-      if (matrices->Q_rem[ij + 1])
-        matrices->Q_rem[ij] += matrices->Q_rem[ij + 1] * scale[1];
-
-      /* da = dbp(T1_{i,j}, T1_{i,j-1})
-       *  db = dbp(T2_{i,j}, T2_{i,j-1})
-       */
-      da  = referenceBPs1[ij] - referenceBPs1[ij + 1];
-      db  = referenceBPs2[ij] - referenceBPs2[ij + 1];
-      if (matrices->Q[ij + 1]) {
-        for (cnt1 = matrices->k_min_Q[ij + 1];
-             cnt1 <= matrices->k_max_Q[ij + 1];
-             cnt1++)
-          for (cnt2 = matrices->l_min_Q[ij + 1][cnt1];
-               cnt2 <= matrices->l_max_Q[ij + 1][cnt1];
-               cnt2 += 2) {
-            if (((cnt1 + da) <= maxD1) && ((cnt2 + db) <= maxD2)) {
-              matrices->Q[ij][cnt1 + da][(cnt2 + db) / 2] += matrices->Q[ij + 1][cnt1][cnt2 / 2] * scale[1];
+    /* da = dbp{T1_{i,j}, T1_{k,j}
+     *  db = dbp{T2_{i,j}, T2_{k,j}}
+     */
+    da  = referenceBPs1[ij] - referenceBPs1[my_iindx[k] - j] - referenceBPs1[my_iindx[i] - k + 1];
+    db  = referenceBPs2[ij] - referenceBPs2[my_iindx[k] - j] - referenceBPs2[my_iindx[i] - k + 1];
+
+
+    if (!matrices->Q[my_iindx[i] - k + 1])
+      continue;
+
+    if (!matrices->Q_B[my_iindx[k] - j])
+      continue;
+
+    for (cnt1 = matrices->k_min_Q[my_iindx[i] - k + 1];
+         cnt1 <= matrices->k_max_Q[my_iindx[i] - k + 1];
+         cnt1++)
+      for (cnt2 = matrices->l_min_Q[my_iindx[i] - k + 1][cnt1];
+           cnt2 <= matrices->l_max_Q[my_iindx[i] - k + 1][cnt1];
+           cnt2 += 2)
+        for (cnt3 = matrices->k_min_Q_B[my_iindx[k] - j];
+             cnt3 <= matrices->k_max_Q_B[my_iindx[k] - j];
+             cnt3++)
+          for (cnt4 = matrices->l_min_Q_B[my_iindx[k] - j][cnt3];
+               cnt4 <= matrices->l_max_Q_B[my_iindx[k] - j][cnt3];
+               cnt4 += 2) {
+            if (IN_SCOPE(vc, cnt1 + cnt3 + da, cnt2 + cnt4 + db)) {
+              matrices->Q[ij][cnt1 + cnt3 + da][(cnt2 + cnt4 + db) / 2] += matrices->Q[my_iindx[i] - k + 1][cnt1][cnt2 / 2] * matrices->Q_B[my_iindx[k] - j][cnt3][cnt4 / 2] * temp2;
               if (update_q) {
-                updatePosteriorBoundaries(cnt1 + da,
-                                          cnt2 + db,
+                updatePosteriorBoundaries(cnt1 + cnt3 + da,
+                                          cnt2 + cnt4 + db,
                                           &k_min_post,
                                           &k_max_post,
                                           &l_min_post,
@@ -1052,118 +1228,80 @@ pf2D_linear(vrna_fold_compound_t *vc)
                                           );
               }
             } else {
-              matrices->Q_rem[ij] += matrices->Q[ij + 1][cnt1][cnt2 / 2] * scale[1];
+              matrices->Q_rem[ij] += matrices->Q[my_iindx[i] - k + 1][cnt1][cnt2 / 2] * matrices->Q_B[my_iindx[k] - j][cnt3][cnt4 / 2] * temp2;
             }
           }
-      }
-
-      for (k = j - TURN - 1; k > i; k--) {
-        tt    = ptype[jindx[j] + k];
-        temp2 = exp_E_ExtLoop(tt, S1[k - 1], (j < seq_length) || circ ? S1[j + 1] : -1, pf_params);
-
-        if (matrices->Q_rem[my_iindx[i] - k + 1]) {
-          if (matrices->Q_B[my_iindx[k] - j]) {
-            for (cnt1 = matrices->k_min_Q_B[my_iindx[k] - j];
-                 cnt1 <= matrices->k_max_Q_B[my_iindx[k] - j];
-                 cnt1++)
-              for (cnt2 = matrices->l_min_Q_B[my_iindx[k] - j][cnt1];
-                   cnt2 <= matrices->l_max_Q_B[my_iindx[k] - j][cnt1];
-                   cnt2 += 2)
-                matrices->Q_rem[ij] += matrices->Q_rem[my_iindx[i] - k + 1] * matrices->Q_B[my_iindx[k] - j][cnt1][cnt2 / 2] * temp2;
-          }
+  }
 
-          if (matrices->Q_B_rem[my_iindx[k] - j])
-            matrices->Q_rem[ij] += matrices->Q_rem[my_iindx[i] - k + 1] * matrices->Q_B_rem[my_iindx[k] - j] * temp2;
-        }
+  if (update_q) {
+    adjustArrayBoundaries(&matrices->Q[ij],
+                          &matrices->k_min_Q[ij],
+                          &matrices->k_max_Q[ij],
+                          &matrices->l_min_Q[ij],
+                          &matrices->l_max_Q[ij],
+                          k_min_post,
+                          k_max_post,
+                          l_min_post,
+                          l_max_post
+                          );
+  }
 
-        if (matrices->Q_B_rem[my_iindx[k] - j]) {
-          if (matrices->Q[my_iindx[i] - k + 1]) {
-            for (cnt1 = matrices->k_min_Q[my_iindx[i] - k + 1];
-                 cnt1 <= matrices->k_max_Q[my_iindx[i] - k + 1];
-                 cnt1++)
-              for (cnt2 = matrices->l_min_Q[my_iindx[i] - k + 1][cnt1];
-                   cnt2 <= matrices->l_max_Q[my_iindx[i] - k + 1][cnt1];
-                   cnt2 += 2)
-                matrices->Q_rem[ij] += matrices->Q[my_iindx[i] - k + 1][cnt1][cnt2 / 2] * matrices->Q_B_rem[my_iindx[k] - j] * temp2;
-          }
-        }
+#if 1
+  for (cnt1 = matrices->k_min_Q[ij];
+       cnt1 <= matrices->k_max_Q[ij];
+       cnt1++) {
+    for (cnt2 = matrices->l_min_Q[ij][cnt1];
+         cnt2 <= matrices->l_max_Q[ij][cnt1];
+         cnt2 += 2) {
+      if (matrices->Q[ij][cnt1][cnt2 / 2] > Qmax) {
+        Qmax = matrices->Q[ij][cnt1][cnt2 / 2];
+        if (Qmax > max_real / 10.)
+          vrna_message_warning("Q close to overflow: %u %u %g\n", i, j, matrices->Q[ij][cnt1][cnt2 / 2]);
+      }
 
-        /* da = dbp{T1_{i,j}, T1_{k,j}
-         *  db = dbp{T2_{i,j}, T2_{k,j}}
-         */
-        da  = referenceBPs1[ij] - referenceBPs1[my_iindx[k] - j] - referenceBPs1[my_iindx[i] - k + 1];
-        db  = referenceBPs2[ij] - referenceBPs2[my_iindx[k] - j] - referenceBPs2[my_iindx[i] - k + 1];
+      if (matrices->Q[ij][cnt1][cnt2 / 2] >= max_real)
+        vrna_message_error("overflow in pf_fold while calculating q[%u,%u]\n"
+                           "use larger pf_scale", i, j);
+    }
+  }
+#endif
+}
 
 
-        if (!matrices->Q[my_iindx[i] - k + 1])
-          continue;
+PRIVATE void
+pf2D_linear(vrna_fold_compound_t *vc,
+            twoD_pool_t          *pool)
+{
+  unsigned int  i, j, ij, seq_length;
+  int           *my_iindx;
+  FLT_OR_DBL    *scale;
+  vrna_mx_pf_t  *matrices;
 
-        if (!matrices->Q_B[my_iindx[k] - j])
-          continue;
+  matrices    = vc->exp_matrices;
+  seq_length  = vc->length;
+  scale       = matrices->scale;
+  my_iindx    = vc->iindx;
+  dangles     = vc->exp_params->model_details.dangles;
 
-        for (cnt1 = matrices->k_min_Q[my_iindx[i] - k + 1];
-             cnt1 <= matrices->k_max_Q[my_iindx[i] - k + 1];
-             cnt1++)
-          for (cnt2 = matrices->l_min_Q[my_iindx[i] - k + 1][cnt1];
-               cnt2 <= matrices->l_max_Q[my_iindx[i] - k + 1][cnt1];
-               cnt2 += 2)
-            for (cnt3 = matrices->k_min_Q_B[my_iindx[k] - j];
-                 cnt3 <= matrices->k_max_Q_B[my_iindx[k] - j];
-                 cnt3++)
-              for (cnt4 = matrices->l_min_Q_B[my_iindx[k] - j][cnt3];
-                   cnt4 <= matrices->l_max_Q_B[my_iindx[k] - j][cnt3];
-                   cnt4 += 2) {
-                if (((cnt1 + cnt3 + da) <= maxD1) && ((cnt2 + cnt4 + db) <= maxD2)) {
-                  matrices->Q[ij][cnt1 + cnt3 + da][(cnt2 + cnt4 + db) / 2] += matrices->Q[my_iindx[i] - k + 1][cnt1][cnt2 / 2] * matrices->Q_B[my_iindx[k] - j][cnt3][cnt4 / 2] * temp2;
-                  if (update_q) {
-                    updatePosteriorBoundaries(cnt1 + cnt3 + da,
-                                              cnt2 + cnt4 + db,
-                                              &k_min_post,
-                                              &k_max_post,
-                                              &l_min_post,
-                                              &l_max_post
-                                              );
-                  }
-                } else {
-                  matrices->Q_rem[ij] += matrices->Q[my_iindx[i] - k + 1][cnt1][cnt2 / 2] * matrices->Q_B[my_iindx[k] - j][cnt3][cnt4 / 2] * temp2;
-                }
-              }
-      }
+  /*array initialization ; qb,qm,q
+   * qb,qm,q (i,j) are stored as ((n+1-i)*(n-i) div 2 + n+1-j */
 
-      if (update_q) {
-        adjustArrayBoundaries(&matrices->Q[ij],
-                              &matrices->k_min_Q[ij],
-                              &matrices->k_max_Q[ij],
-                              &matrices->l_min_Q[ij],
-                              &matrices->l_max_Q[ij],
-                              k_min_post,
-                              k_max_post,
-                              l_min_post,
-                              l_max_post
-                              );
-      }
+  for (j = 1; j <= seq_length; j++)
+    for (i = (j > TURN ? (j - TURN) : 1); i <= j; i++) {
+      ij                        = my_iindx[i] - j;
+      matrices->k_min_Q[ij]     = 0;
+      matrices->k_max_Q[ij]     = 0;
+      matrices->l_min_Q[ij]     = (int *)vrna_alloc(sizeof(int));
+      matrices->l_max_Q[ij]     = (int *)vrna_alloc(sizeof(int));
+      matrices->l_min_Q[ij][0]  = 0;
+      matrices->l_max_Q[ij][0]  = 0;
+      prepareArray(&matrices->Q[ij], 0, 0, matrices->l_min_Q[ij], matrices->l_max_Q[ij]);
+      matrices->Q[ij][0][0] = 1.0 * scale[j - i + 1];
+    }
 
-#if 1
-      for (cnt1 = matrices->k_min_Q[ij];
-           cnt1 <= matrices->k_max_Q[ij];
-           cnt1++) {
-        for (cnt2 = matrices->l_min_Q[ij][cnt1];
-             cnt2 <= matrices->l_max_Q[ij][cnt1];
-             cnt2 += 2) {
-          if (matrices->Q[ij][cnt1][cnt2 / 2] > Qmax) {
-            Qmax = matrices->Q[ij][cnt1][cnt2 / 2];
-            if (Qmax > max_real / 10.)
-              vrna_message_warning("Q close to overflow: %u %u %g\n", i, j, matrices->Q[ij][cnt1][cnt2 / 2]);
-          }
 
-          if (matrices->Q[ij][cnt1][cnt2 / 2] >= max_real)
-            vrna_message_error("overflow in pf_fold while calculating q[%u,%u]\n"
-                               "use larger pf_scale", i, j);
-        }
-      }
-#endif
-    } /* end of j-loop */
-  }
+  /* fill Q_B, Q_M, Q_M1, and Q for all (i,j) in parallel, diagonal by diagonal */
+  twoD_fill_diagonals(vc, pool, &pf2D_linear_cell);
 }
 
 
@@ -1172,13 +1310,12 @@ pf2D_linear(vrna_fold_compound_t *vc)
 /* You have to call pf2D_linear first to calculate  */
 /* complete circular case!!!                      */
 PRIVATE void
-pf2D_circ(vrna_fold_compound_t *vc)
+pf2D_circ(vrna_fold_compound_t *vc,
+          twoD_pool_t          *pool)
 {
-  unsigned int      d, p, q, pq, k, l, kl, u, da, db, seq_length, maxD1, maxD2, base_d1, base_d2, *mm1, *mm2, *bpdist;
-  int               *my_iindx, *jindx, type, cnt1, cnt2, cnt3, cnt4, *rtype;
-  short             *S1;
+  unsigned int      seq_length, maxD1, maxD2, *mm1, *mm2, *bpdist;
+  int               *my_iindx, cnt1, cnt2;
   unsigned int      *referenceBPs1, *referenceBPs2;
-  char              *sequence, *ptype;
   FLT_OR_DBL        *scale;
   vrna_exp_param_t  *pf_params;     /* holds all [unscaled] pf parameters */
   vrna_md_t         *md;
@@ -1187,16 +1324,11 @@ pf2D_circ(vrna_fold_compound_t *vc)
   pf_params     = vc->exp_params;
   md            = &(pf_params->model_details);
   matrices      = vc->exp_matrices;
-  sequence      = vc->sequence;
   seq_length    = vc->length;
   maxD1         = vc->maxD1;
   maxD2         = vc->maxD2;
-  S1            = vc->sequence_encoding;
-  ptype         = vc->ptype;
-  rtype         = &(md->rtype[0]);
   scale         = matrices->scale;
   my_iindx      = vc->iindx;
-  jindx         = vc->jindx;
   referenceBPs1 = vc->referenceBPs1;
   referenceBPs2 = vc->referenceBPs2;
   dangles       = md->dangles;
@@ -1204,158 +1336,22 @@ pf2D_circ(vrna_fold_compound_t *vc)
   mm2           = vc->mm2;
   bpdist        = vc->bpdist;
 
-  FLT_OR_DBL  ***Q_B, ***Q_M, ***Q_M1;
-  FLT_OR_DBL  *Q_B_rem, *Q_M_rem, *Q_M1_rem;
-  int         **l_min_Q_B, **l_max_Q_B, **l_min_Q_M, **l_max_Q_M, **l_min_Q_M1, **l_max_Q_M1;
-  int         *k_min_Q_B, *k_max_Q_B, *k_min_Q_M, *k_max_Q_M, *k_min_Q_M1, *k_max_Q_M1;
-
-  Q_B       = matrices->Q_B;
-  l_min_Q_B = matrices->l_min_Q_B;
-  l_max_Q_B = matrices->l_max_Q_B;
-  k_min_Q_B = matrices->k_min_Q_B;
-  k_max_Q_B = matrices->k_max_Q_B;
-
-  Q_M       = matrices->Q_M;
-  l_min_Q_M = matrices->l_min_Q_M;
-  l_max_Q_M = matrices->l_max_Q_M;
-  k_min_Q_M = matrices->k_min_Q_M;
-  k_max_Q_M = matrices->k_max_Q_M;
-
-  Q_M1        = matrices->Q_M1;
-  l_min_Q_M1  = matrices->l_min_Q_M1;
-  l_max_Q_M1  = matrices->l_max_Q_M1;
-  k_min_Q_M1  = matrices->k_min_Q_M1;
-  k_max_Q_M1  = matrices->k_max_Q_M1;
-
-
-  Q_B_rem   = matrices->Q_B_rem;
-  Q_M_rem   = matrices->Q_M_rem;
-  Q_M1_rem  = matrices->Q_M1_rem;
-
   matrices->Q_c_rem   = 0.;
   matrices->Q_cH_rem  = 0.;
   matrices->Q_cI_rem  = 0.;
   matrices->Q_cM_rem  = 0.;
 
 
-  /* construct qm2 matrix from qm1 entries  */
-#ifdef _OPENMP
-#pragma omp parallel for private(d, k, l, da, db, cnt1, cnt2, cnt3, cnt4)
-#endif
-  for (k = 1; k < seq_length - TURN - 1; k++) {
-    int k_min_Q_M2, k_max_Q_M2, l_min_Q_M2, l_max_Q_M2;
-    int k_min_post_m2, k_max_post_m2, *l_min_post_m2, *l_max_post_m2;
-    int update_m2 = 0;
-
-    l_min_post_m2 = l_max_post_m2 = NULL;
-
-    if (!matrices->Q_M2[k]) {
-      update_m2   = 1;
-      k_min_Q_M2  = l_min_Q_M2 = 0;
-      k_max_Q_M2  = mm1[my_iindx[k] - seq_length] + referenceBPs1[my_iindx[k] - seq_length];
-      l_max_Q_M2  = mm2[my_iindx[k] - seq_length] + referenceBPs2[my_iindx[k] - seq_length];
-
-      prepareBoundaries(k_min_Q_M2,
-                        k_max_Q_M2,
-                        l_min_Q_M2,
-                        l_max_Q_M2,
-                        bpdist[my_iindx[k] - seq_length],
-                        &matrices->k_min_Q_M2[k],
-                        &matrices->k_max_Q_M2[k],
-                        &matrices->l_min_Q_M2[k],
-                        &matrices->l_max_Q_M2[k]
-                        );
-      preparePosteriorBoundaries(matrices->k_max_Q_M2[k] - matrices->k_min_Q_M2[k] + 1,
-                                 matrices->k_min_Q_M2[k],
-                                 &k_min_post_m2,
-                                 &k_max_post_m2,
-                                 &l_min_post_m2,
-                                 &l_max_post_m2
-                                 );
-
-      prepareArray(&matrices->Q_M2[k],
-                   matrices->k_min_Q_M2[k],
-                   matrices->k_max_Q_M2[k],
-                   matrices->l_min_Q_M2[k],
-                   matrices->l_max_Q_M2[k]
-                   );
-    }
-
-    /* construct Q_M2 */
-    for (l = k + TURN + 1; l < seq_length - TURN - 1; l++) {
-      if (Q_M1_rem[jindx[l] + k]) {
-        if (Q_M1[jindx[seq_length] + l + 1]) {
-          for (cnt1 = k_min_Q_M1[jindx[seq_length] + l + 1];
-               cnt1 <= k_max_Q_M1[jindx[seq_length] + l + 1];
-               cnt1++)
-            for (cnt2 = l_min_Q_M1[jindx[seq_length] + l + 1][cnt1];
-                 cnt2 <= l_max_Q_M1[jindx[seq_length] + l + 1][cnt1];
-                 cnt2 += 2)
-              matrices->Q_M2_rem[k] += Q_M1_rem[jindx[l] + k] * Q_M1[jindx[seq_length] + l + 1][cnt1][cnt2 / 2];
-        }
-
-        if (Q_M1_rem[jindx[seq_length] + l + 1])
-          matrices->Q_M2_rem[k] += Q_M1_rem[jindx[l] + k] * Q_M1_rem[jindx[seq_length] + l + 1];
-      }
-
-      if (Q_M1_rem[jindx[seq_length] + l + 1]) {
-        if (Q_M1[jindx[l] + k]) {
-          for (cnt1 = k_min_Q_M1[jindx[l] + k];
-               cnt1 <= k_max_Q_M1[jindx[l] + k];
-               cnt1++)
-            for (cnt2 = l_min_Q_M1[jindx[l] + k][cnt1];
-                 cnt2 <= l_max_Q_M1[jindx[l] + k][cnt1];
-                 cnt2 += 2)
-              matrices->Q_M2_rem[k] += Q_M1[jindx[l] + k][cnt1][cnt2 / 2] * Q_M1_rem[jindx[seq_length] + l + 1];
-        }
-      }
-
-      if (matrices->Q_M1[jindx[l] + k] && matrices->Q_M1[jindx[seq_length] + l + 1]) {
-        da  = referenceBPs1[my_iindx[k] - seq_length] - referenceBPs1[my_iindx[k] - l] - referenceBPs1[my_iindx[l + 1] - seq_length];
-        db  = referenceBPs2[my_iindx[k] - seq_length] - referenceBPs2[my_iindx[k] - l] - referenceBPs2[my_iindx[l + 1] - seq_length];
-        for (cnt1 = k_min_Q_M1[jindx[l] + k]; cnt1 <= k_max_Q_M1[jindx[l] + k]; cnt1++)
-          for (cnt2 = l_min_Q_M1[jindx[l] + k][cnt1]; cnt2 <= l_max_Q_M1[jindx[l] + k][cnt1]; cnt2 += 2) {
-            for (cnt3 = k_min_Q_M1[jindx[seq_length] + l + 1]; cnt3 <= k_max_Q_M1[jindx[seq_length] + l + 1]; cnt3++)
-              for (cnt4 = l_min_Q_M1[jindx[seq_length] + l + 1][cnt3]; cnt4 <= l_max_Q_M1[jindx[seq_length] + l + 1][cnt3]; cnt4 += 2) {
-                if (((cnt1 + cnt3 + da) <= maxD1) && ((cnt2 + cnt4 + db) <= maxD2)) {
-                  matrices->Q_M2[k][cnt1 + cnt3 + da][(cnt2 + cnt4 + db) / 2] += Q_M1[jindx[l] + k][cnt1][cnt2 / 2] * Q_M1[jindx[seq_length] + l + 1][cnt3][cnt4 / 2];
-                  if (update_m2) {
-                    updatePosteriorBoundaries(cnt1 + cnt3 + da,
-                                              cnt2 + cnt4 + db,
-                                              &k_min_post_m2,
-                                              &k_max_post_m2,
-                                              &l_min_post_m2,
-                                              &l_max_post_m2
-                                              );
-                  }
-                } else {
-                  matrices->Q_M2_rem[k] += Q_M1[jindx[l] + k][cnt1][cnt2 / 2] * Q_M1[jindx[seq_length] + l + 1][cnt3][cnt4 / 2];
-                }
-              }
-          }
-      }
-    }
-    if (update_m2) {
-      adjustArrayBoundaries(&matrices->Q_M2[k],
-                            &matrices->k_min_Q_M2[k],
-                            &matrices->k_max_Q_M2[k],
-                            &matrices->l_min_Q_M2[k],
-                            &matrices->l_max_Q_M2[k],
-                            k_min_post_m2,
-                            k_max_post_m2,
-                            l_min_post_m2,
-                            l_max_post_m2
-                            );
-    }
-  }
-
-  base_d1 = referenceBPs1[my_iindx[1] - seq_length];
-  base_d2 = referenceBPs2[my_iindx[1] - seq_length];
+  /* construct qm2 matrix from qm1 entries for all k in parallel */
+  if (seq_length > TURN + 2)
+    twoD_pool_for(pool, seq_length - TURN - 2, NULL, &pf2D_circ_M2, (void *)vc);
 
   int min_k, max_k, max_l, min_l;
   int min_k_real, max_k_real, min_k_real_qcH, max_k_real_qcH, min_k_real_qcI, max_k_real_qcI, min_k_real_qcM, max_k_real_qcM;
   int *min_l_real, *max_l_real, *min_l_real_qcH, *max_l_real_qcH, *min_l_real_qcI, *max_l_real_qcI, *min_l_real_qcM, *max_l_real_qcM;
   int update_c, update_cH, update_cI, update_cM;
+  unsigned int c;
+  circ_batch_t batch;
 
   max_l_real_qcM = min_l_real_qcM = NULL;
   max_l_real_qcI = min_l_real_qcI = NULL;
@@ -1377,7 +1373,8 @@ pf2D_circ(vrna_fold_compound_t *vc)
 #endif
   if (!matrices->Q_c) {
     update_c = 1;
-    prepareBoundaries(min_k,
+    prepareBoundaries(vc,
+                      min_k,
                       max_k,
                       min_l,
                       max_l,
@@ -1411,7 +1408,8 @@ pf2D_circ(vrna_fold_compound_t *vc)
 #endif
   if (!matrices->Q_cH) {
     update_cH = 1;
-    prepareBoundaries(min_k,
+    prepareBoundaries(vc,
+                      min_k,
                       max_k,
                       min_l,
                       max_l,
@@ -1443,7 +1441,8 @@ pf2D_circ(vrna_fold_compound_t *vc)
 #endif
   if (!matrices->Q_cI) {
     update_cI = 1;
-    prepareBoundaries(min_k,
+    prepareBoundaries(vc,
+                      min_k,
                       max_k,
                       min_l,
                       max_l,
@@ -1475,7 +1474,8 @@ pf2D_circ(vrna_fold_compound_t *vc)
 #endif
   if (!matrices->Q_cM) {
     update_cM = 1;
-    prepareBoundaries(min_k,
+    prepareBoundaries(vc,
+                      min_k,
                       max_k,
                       min_l,
                       max_l,
@@ -1506,371 +1506,780 @@ pf2D_circ(vrna_fold_compound_t *vc)
 #endif
 
 
-  for (d = TURN + 2; d <= seq_length; d++) /* i,j in [1..length] */
-#ifdef _OPENMP
-#pragma omp parallel for private(p, q, pq, k, l, kl, u, da, db, type, cnt1, cnt2, cnt3, cnt4)
-#endif
-    for (q = d; q <= seq_length; q++) {
-      FLT_OR_DBL  qot;
-      char        loopseq[10];
-      p   = q - d + 1;
-      pq  = my_iindx[p] - q;
-
-      /* 1. get exterior hairpin contribution  */
-      u = seq_length - q + p - 1;
-      if (u < TURN)
-        continue;
+  /*
+   *  The exterior loop contributions of all pairs (p,q) and all multiloop
+   *  splits k end up in the same distance classes. Each thread therefore
+   *  sums up an interleaved subset of them into a partial sum of its own,
+   *  and the partial sums are merged in a fixed order afterwards. The first
+   *  partial sum is accumulated in the matrices directly.
+   */
+  batch.vc        = vc;
+  batch.num       = (pool->num_threads > 1) ? (unsigned int)pool->num_threads : 1;
+  batch.update_cH = update_cH;
+  batch.update_cI = update_cI;
+  batch.update_cM = update_cM;
+  batch.partials  = (circ_partial_t *)vrna_alloc(sizeof(circ_partial_t) * batch.num);
+
+  batch.partials[0].Q_cH      = matrices->Q_cH;
+  batch.partials[0].Q_cI      = matrices->Q_cI;
+  batch.partials[0].Q_cM      = matrices->Q_cM;
+  batch.partials[0].k_min_cH  = min_k_real_qcH;
+  batch.partials[0].k_max_cH  = max_k_real_qcH;
+  batch.partials[0].l_min_cH  = min_l_real_qcH;
+  batch.partials[0].l_max_cH  = max_l_real_qcH;
+  batch.partials[0].k_min_cI  = min_k_real_qcI;
+  batch.partials[0].k_max_cI  = max_k_real_qcI;
+  batch.partials[0].l_min_cI  = min_l_real_qcI;
+  batch.partials[0].l_max_cI  = max_l_real_qcI;
+  batch.partials[0].k_min_cM  = min_k_real_qcM;
+  batch.partials[0].k_max_cM  = max_k_real_qcM;
+  batch.partials[0].l_min_cM  = min_l_real_qcM;
+  batch.partials[0].l_max_cM  = max_l_real_qcM;
+
+  for (c = 1; c < batch.num; c++)
+    prepare_circ_partial(matrices, &batch, batch.partials + c, max_k - min_k + 1, min_k);
+
+  twoD_pool_for(pool, batch.num, NULL, &pf2D_circ_exterior, (void *)&batch);
+
+  for (c = 0; c < batch.num; c++) {
+    matrices->Q_cH_rem  += batch.partials[c].Q_cH_rem;
+    matrices->Q_cI_rem  += batch.partials[c].Q_cI_rem;
+    matrices->Q_cM_rem  += batch.partials[c].Q_cM_rem;
+    if (c > 0)
+      merge_circ_partial(matrices, &batch, batch.partials + c, min_k);
+  }
 
-      type = ptype[jindx[q] + p];
-      if (!type)
-        continue;
+  min_k_real_qcH  = batch.partials[0].k_min_cH;
+  max_k_real_qcH  = batch.partials[0].k_max_cH;
+  min_k_real_qcI  = batch.partials[0].k_min_cI;
+  max_k_real_qcI  = batch.partials[0].k_max_cI;
+  min_k_real_qcM  = batch.partials[0].k_min_cM;
+  max_k_real_qcM  = batch.partials[0].k_max_cM;
 
-      if (((type == 3) || (type == 4)) && no_closingGU)
-        continue;
+  free(batch.partials);
 
-      /* cause we want to calc the exterior loops, we need the reversed pair type from now on  */
-      type = rtype[type];
+  if (update_cH) {
+    adjustArrayBoundaries(&matrices->Q_cH,
+                          &matrices->k_min_Q_cH,
+                          &matrices->k_max_Q_cH,
+                          &matrices->l_min_Q_cH,
+                          &matrices->l_max_Q_cH,
+                          min_k_real_qcH,
+                          max_k_real_qcH,
+                          min_l_real_qcH,
+                          max_l_real_qcH
+                          );
+  }
 
-      if (u < 7) {
-        strcpy(loopseq, sequence + q - 1);
-        strncat(loopseq, sequence, p);
+  if (update_cI) {
+    adjustArrayBoundaries(&matrices->Q_cI,
+                          &matrices->k_min_Q_cI,
+                          &matrices->k_max_Q_cI,
+                          &matrices->l_min_Q_cI,
+                          &matrices->l_max_Q_cI,
+                          min_k_real_qcI,
+                          max_k_real_qcI,
+                          min_l_real_qcI,
+                          max_l_real_qcI
+                          );
+  }
+
+  if (update_cM) {
+    adjustArrayBoundaries(&matrices->Q_cM,
+                          &matrices->k_min_Q_cM,
+                          &matrices->k_max_Q_cM,
+                          &matrices->l_min_Q_cM,
+                          &matrices->l_max_Q_cM,
+                          min_k_real_qcM,
+                          max_k_real_qcM,
+                          min_l_real_qcM,
+                          max_l_real_qcM
+                          );
+  }
+
+  for (cnt1 = matrices->k_min_Q_cH;
+       cnt1 <= matrices->k_max_Q_cH;
+       cnt1++)
+    for (cnt2 = matrices->l_min_Q_cH[cnt1];
+         cnt2 <= matrices->l_max_Q_cH[cnt1];
+         cnt2 += 2) {
+      matrices->Q_c[cnt1][cnt2 / 2] += matrices->Q_cH[cnt1][cnt2 / 2];
+      if (update_c) {
+        updatePosteriorBoundaries(cnt1,
+                                  cnt2,
+                                  &min_k_real,
+                                  &max_k_real,
+                                  &min_l_real,
+                                  &max_l_real
+                                  );
+      }
+    }
+  for (cnt1 = matrices->k_min_Q_cI;
+       cnt1 <= matrices->k_max_Q_cI;
+       cnt1++)
+    for (cnt2 = matrices->l_min_Q_cI[cnt1];
+         cnt2 <= matrices->l_max_Q_cI[cnt1];
+         cnt2 += 2) {
+      matrices->Q_c[cnt1][cnt2 / 2] += matrices->Q_cI[cnt1][cnt2 / 2];
+      if (update_c) {
+        updatePosteriorBoundaries(cnt1,
+                                  cnt2,
+                                  &min_k_real,
+                                  &max_k_real,
+                                  &min_l_real,
+                                  &max_l_real
+                                  );
+      }
+    }
+  for (cnt1 = matrices->k_min_Q_cM;
+       cnt1 <= matrices->k_max_Q_cM;
+       cnt1++)
+    for (cnt2 = matrices->l_min_Q_cM[cnt1];
+         cnt2 <= matrices->l_max_Q_cM[cnt1];
+         cnt2 += 2) {
+      matrices->Q_c[cnt1][cnt2 / 2] += matrices->Q_cM[cnt1][cnt2 / 2];
+      if (update_c) {
+        updatePosteriorBoundaries(cnt1,
+                                  cnt2,
+                                  &min_k_real,
+                                  &max_k_real,
+                                  &min_l_real,
+                                  &max_l_real
+                                  );
       }
+    }
 
-      /* get distance to reference if closing the hairpin
-       *  da = dbp(T1_[1,n}, T1_{p,q})
-       *  db = dbp(T2_{1,n}, T2_{p,q})
-       */
-      da  = base_d1 - referenceBPs1[pq];
-      db  = base_d2 - referenceBPs2[pq];
-      qot = exp_E_Hairpin(u, type, S1[q + 1], S1[p - 1], loopseq, pf_params) * scale[u];
+  matrices->Q_c_rem = matrices->Q_cH_rem + matrices->Q_cI_rem + matrices->Q_cM_rem;
 
-      if (Q_B_rem[pq])
-        matrices->Q_cH_rem += Q_B_rem[pq] * qot;
+  /* add the case were structure is unfolded chain */
+  if (IN_SCOPE(vc, referenceBPs1[my_iindx[1] - seq_length], referenceBPs2[my_iindx[1] - seq_length])) {
+    matrices->Q_c[referenceBPs1[my_iindx[1] - seq_length]][referenceBPs2[my_iindx[1] - seq_length] / 2] += 1.0 * scale[seq_length];
+    if (update_c) {
+      updatePosteriorBoundaries(referenceBPs1[my_iindx[1] - seq_length],
+                                referenceBPs2[my_iindx[1] - seq_length],
+                                &min_k_real,
+                                &max_k_real,
+                                &min_l_real,
+                                &max_l_real
+                                );
+    }
+  } else {
+    matrices->Q_c_rem += 1.0 * scale[seq_length];
+  }
 
-      if (Q_B[pq]) {
-        for (cnt1 = k_min_Q_B[pq];
-             cnt1 <= k_max_Q_B[pq];
-             cnt1++)
-          for (cnt2 = l_min_Q_B[pq][cnt1];
-               cnt2 <= l_max_Q_B[pq][cnt1];
-               cnt2 += 2) {
-            if (((cnt1 + da) <= maxD1) && ((cnt2 + db) <= maxD2)) {
-              matrices->Q_cH[cnt1 + da][(cnt2 + db) / 2] += Q_B[pq][cnt1][cnt2 / 2] * qot;
-              if (update_cH) {
-                updatePosteriorBoundaries(cnt1 + da,
-                                          cnt2 + db,
-                                          &min_k_real_qcH,
-                                          &max_k_real_qcH,
-                                          &min_l_real_qcH,
-                                          &max_l_real_qcH
-                                          );
-              }
-            } else {
-              matrices->Q_cH_rem += Q_B[pq][cnt1][cnt2 / 2] * qot;
-            }
-          }
-      }
+  adjustArrayBoundaries(&matrices->Q_c,
+                        &matrices->k_min_Q_c,
+                        &matrices->k_max_Q_c,
+                        &matrices->l_min_Q_c,
+                        &matrices->l_max_Q_c,
+                        min_k_real,
+                        max_k_real,
+                        min_l_real,
+                        max_l_real
+                        );
+}
 
-      /* 2. exterior interior loops, i "define" the (k,l) pair as "outer pair"  */
-      /* so "outer type" is rtype[type[k,l]] and inner type is type[p,q]        */
-      if (Q_B_rem[pq]) {
-        for (k = q + 1; k < seq_length; k++) {
-          unsigned int ln1, lstart, ln_pre;
-          ln1 = k - q - 1;
-          if (ln1 + p - 1 > MAXLOOP)
-            break;
+/* sum up the contributions of an interleaved subset c of all exterior loops of a circular RNA */
+PRIVATE void
+pf2D_circ_exterior(void         *data,
+                   unsigned int c)
+{
+  unsigned int  d, p, q, k, n, idx;
+  circ_batch_t  *batch = (circ_batch_t *)data;
 
-          lstart  = k + TURN + 1;
-          ln_pre  = ln1 + p + seq_length;
-          if (ln_pre > lstart + MAXLOOP)
-            lstart = ln_pre - MAXLOOP - 1;
+  n = batch->vc->length;
 
-          for (l = lstart; l <= seq_length; l++) {
-            unsigned int  ln2;
-            int           type2;
-            kl  = my_iindx[k] - l;
-            ln2 = (p - 1) + (seq_length - l);
+  for (idx = 0, d = TURN + 2; d <= n; d++)
+    for (q = d; q <= n; q++, idx++) {
+      p = q - d + 1;
+      if (idx % batch->num == c)
+        pf2D_circ_exterior_pair(batch, batch->partials + c, p, q);
+    }
 
-            if ((ln1 + ln2) > MAXLOOP)
-              continue;
+  if (n > 2 * TURN - 3) {
+    for (k = TURN + 2; k < n - 2 * TURN - 3; k++)
+      if (k % batch->num == c)
+        pf2D_circ_exterior_ML(batch, batch->partials + c, k);
+  }
+}
 
-            type2 = ptype[jindx[l] + k];
-            if (!type2)
-              continue;
 
-            qot = exp_E_IntLoop(ln2, ln1, rtype[type2], type, S1[l + 1], S1[k - 1], S1[p - 1], S1[q + 1], pf_params) * scale[ln1 + ln2];
+/* exterior hairpin and interior loops closed by pair (p,q) */
+PRIVATE void
+pf2D_circ_exterior_pair(circ_batch_t    *batch,
+                        circ_partial_t  *part,
+                        unsigned int    p,
+                        unsigned int    q)
+{
+  unsigned int          pq, k, l, kl, u, da, db, seq_length, maxD1, maxD2, base_d1, base_d2;
+  unsigned int          *referenceBPs1, *referenceBPs2;
+  int                   *my_iindx, *jindx, type, cnt1, cnt2, cnt3, cnt4, *rtype;
+  int                   **l_min_Q_B, **l_max_Q_B, *k_min_Q_B, *k_max_Q_B;
+  short                 *S1;
+  char                  *sequence, *ptype, loopseq[10];
+  FLT_OR_DBL            qot, *scale, ***Q_B, *Q_B_rem;
+  vrna_exp_param_t      *pf_params;
+  vrna_md_t             *md;
+  vrna_mx_pf_t          *matrices;
+  vrna_fold_compound_t  *vc;
+
+  vc            = batch->vc;
+  pf_params     = vc->exp_params;
+  md            = &(pf_params->model_details);
+  matrices      = vc->exp_matrices;
+  seq_length    = vc->length;
+  maxD1         = vc->maxD1;
+  maxD2         = vc->maxD2;
+  my_iindx      = vc->iindx;
+  referenceBPs1 = vc->referenceBPs1;
+  referenceBPs2 = vc->referenceBPs2;
+  base_d1       = referenceBPs1[my_iindx[1] - seq_length];
+  base_d2       = referenceBPs2[my_iindx[1] - seq_length];
+  sequence      = vc->sequence;
+  S1            = vc->sequence_encoding;
+  ptype         = vc->ptype;
+  rtype         = &(md->rtype[0]);
+  scale         = matrices->scale;
+  jindx         = vc->jindx;
 
-            if (Q_B_rem[kl])
-              matrices->Q_cI_rem += Q_B_rem[pq] * Q_B_rem[kl] * qot;
+  Q_B       = matrices->Q_B;
+  l_min_Q_B = matrices->l_min_Q_B;
+  l_max_Q_B = matrices->l_max_Q_B;
+  k_min_Q_B = matrices->k_min_Q_B;
+  k_max_Q_B = matrices->k_max_Q_B;
+  Q_B_rem   = matrices->Q_B_rem;
 
-            if (Q_B[kl]) {
-              for (cnt1 = k_min_Q_B[kl];
-                   cnt1 <= k_max_Q_B[kl];
-                   cnt1++)
-                for (cnt2 = l_min_Q_B[kl][cnt1];
-                     cnt2 <= l_max_Q_B[kl][cnt1];
-                     cnt2 += 2)
-                  matrices->Q_cI_rem += Q_B_rem[pq] * Q_B[kl][cnt1][cnt2 / 2] * qot;
-            }
+  pq = my_iindx[p] - q;
+
+
+  /* 1. get exterior hairpin contribution  */
+  u = seq_length - q + p - 1;
+  if (u < TURN)
+    return;
+
+  type = ptype[jindx[q] + p];
+  if (!type)
+    return;
+
+  if (((type == 3) || (type == 4)) && no_closingGU)
+    return;
+
+  /* cause we want to calc the exterior loops, we need the reversed pair type from now on  */
+  type = rtype[type];
+
+  if (u < 7) {
+    strcpy(loopseq, sequence + q - 1);
+    strncat(loopseq, sequence, p);
+  }
+
+  /* get distance to reference if closing the hairpin
+   *  da = dbp(T1_[1,n}, T1_{p,q})
+   *  db = dbp(T2_{1,n}, T2_{p,q})
+   */
+  da  = base_d1 - referenceBPs1[pq];
+  db  = base_d2 - referenceBPs2[pq];
+  qot = exp_E_Hairpin(u, type, S1[q + 1], S1[p - 1], loopseq, pf_params) * scale[u];
+
+  if (Q_B_rem[pq])
+    part->Q_cH_rem += Q_B_rem[pq] * qot;
+
+  if (Q_B[pq]) {
+    for (cnt1 = k_min_Q_B[pq];
+         cnt1 <= k_max_Q_B[pq];
+         cnt1++)
+      for (cnt2 = l_min_Q_B[pq][cnt1];
+           cnt2 <= l_max_Q_B[pq][cnt1];
+           cnt2 += 2) {
+        if (IN_SCOPE(vc, cnt1 + da, cnt2 + db)) {
+          part->Q_cH[cnt1 + da][(cnt2 + db) / 2] += Q_B[pq][cnt1][cnt2 / 2] * qot;
+          if (batch->update_cH) {
+            updatePosteriorBoundaries(cnt1 + da,
+                                      cnt2 + db,
+                                      &part->k_min_cH,
+                                      &part->k_max_cH,
+                                      &part->l_min_cH,
+                                      &part->l_max_cH
+                                      );
           }
+        } else {
+          part->Q_cH_rem += Q_B[pq][cnt1][cnt2 / 2] * qot;
         }
       }
+  }
 
-      if (Q_B[pq]) {
-        for (k = q + 1; k < seq_length; k++) {
-          unsigned int ln1, lstart, ln_pre;
-          ln1 = k - q - 1;
-          if (ln1 + p - 1 > MAXLOOP)
-            break;
+  /* 2. exterior interior loops, i "define" the (k,l) pair as "outer pair"  */
+  /* so "outer type" is rtype[type[k,l]] and inner type is type[p,q]        */
+  if (Q_B_rem[pq]) {
+    for (k = q + 1; k < seq_length; k++) {
+      unsigned int ln1, lstart, ln_pre;
+      ln1 = k - q - 1;
+      if (ln1 + p - 1 > MAXLOOP)
+        break;
 
-          lstart  = k + TURN + 1;
-          ln_pre  = ln1 + p + seq_length;
-          if (ln_pre > lstart + MAXLOOP)
-            lstart = ln_pre - MAXLOOP - 1;
+      lstart  = k + TURN + 1;
+      ln_pre  = ln1 + p + seq_length;
+      if (ln_pre > lstart + MAXLOOP)
+        lstart = ln_pre - MAXLOOP - 1;
 
-          for (l = lstart; l <= seq_length; l++) {
-            unsigned int  ln2;
-            int           type2;
-            kl  = my_iindx[k] - l;
-            ln2 = (p - 1) + (seq_length - l);
+      for (l = lstart; l <= seq_length; l++) {
+        unsigned int  ln2;
+        int           type2;
+        kl  = my_iindx[k] - l;
+        ln2 = (p - 1) + (seq_length - l);
 
-            if ((ln1 + ln2) > MAXLOOP)
-              continue;
-
-            type2 = ptype[jindx[l] + k];
-            if (!type2)
-              continue;
+        if ((ln1 + ln2) > MAXLOOP)
+          continue;
 
-            qot = exp_E_IntLoop(ln2, ln1, rtype[type2], type, S1[l + 1], S1[k - 1], S1[p - 1], S1[q + 1], pf_params) * scale[ln1 + ln2];
+        type2 = ptype[jindx[l] + k];
+        if (!type2)
+          continue;
 
-            if (Q_B_rem[kl]) {
-              for (cnt1 = k_min_Q_B[pq];
-                   cnt1 <= k_max_Q_B[pq];
-                   cnt1++)
-                for (cnt2 = l_min_Q_B[pq][cnt1];
-                     cnt2 <= l_max_Q_B[pq][cnt1];
-                     cnt2 += 2)
-                  matrices->Q_cI_rem += Q_B[pq][cnt1][cnt2 / 2] * Q_B_rem[kl] * qot;
-            }
+        qot = exp_E_IntLoop(ln2, ln1, rtype[type2], type, S1[l + 1], S1[k - 1], S1[p - 1], S1[q + 1], pf_params) * scale[ln1 + ln2];
 
-            if (!Q_B[kl])
-              continue;
+        if (Q_B_rem[kl])
+          part->Q_cI_rem += Q_B_rem[pq] * Q_B_rem[kl] * qot;
 
-            /* get distance to reference if closing the interior loop
-             *  d2a = dbp(T1_[1,n}, T1_{p,q} + T1_{k,l})
-             *  d2b = dbp(T2_[1,n}, T2_{p,q} + T2_{k,l})
-             */
-            da  = base_d1 - referenceBPs1[pq] - referenceBPs1[kl];
-            db  = base_d2 - referenceBPs2[pq] - referenceBPs2[kl];
-
-            for (cnt1 = k_min_Q_B[pq]; cnt1 <= k_max_Q_B[pq]; cnt1++)
-              for (cnt2 = l_min_Q_B[pq][cnt1]; cnt2 <= l_max_Q_B[pq][cnt1]; cnt2 += 2)
-                for (cnt3 = k_min_Q_B[kl]; cnt3 <= k_max_Q_B[kl]; cnt3++)
-                  for (cnt4 = l_min_Q_B[kl][cnt3]; cnt4 <= l_max_Q_B[kl][cnt3]; cnt4 += 2) {
-                    if (((cnt1 + cnt3 + da) <= maxD1) && ((cnt2 + cnt4 + db) <= maxD2)) {
-                      matrices->Q_cI[cnt1 + cnt3 + da][(cnt2 + cnt4 + db) / 2] += Q_B[pq][cnt1][cnt2 / 2] * Q_B[kl][cnt3][cnt4 / 2] * qot;
-                      if (update_cI) {
-                        updatePosteriorBoundaries(cnt1 + cnt3 + da,
-                                                  cnt2 + cnt4 + db,
-                                                  &min_k_real_qcI,
-                                                  &max_k_real_qcI,
-                                                  &min_l_real_qcI,
-                                                  &max_l_real_qcI
-                                                  );
-                      }
-                    } else {
-                      matrices->Q_cI_rem += Q_B[pq][cnt1][cnt2 / 2] * Q_B[kl][cnt3][cnt4 / 2] * qot;
-                    }
-                  }
-          }
+        if (Q_B[kl]) {
+          for (cnt1 = k_min_Q_B[kl];
+               cnt1 <= k_max_Q_B[kl];
+               cnt1++)
+            for (cnt2 = l_min_Q_B[kl][cnt1];
+                 cnt2 <= l_max_Q_B[kl][cnt1];
+                 cnt2 += 2)
+              part->Q_cI_rem += Q_B_rem[pq] * Q_B[kl][cnt1][cnt2 / 2] * qot;
         }
       }
     }
-
-  if (update_cH) {
-    adjustArrayBoundaries(&matrices->Q_cH,
-                          &matrices->k_min_Q_cH,
-                          &matrices->k_max_Q_cH,
-                          &matrices->l_min_Q_cH,
-                          &matrices->l_max_Q_cH,
-                          min_k_real_qcH,
-                          max_k_real_qcH,
-                          min_l_real_qcH,
-                          max_l_real_qcH
-                          );
   }
 
-  if (update_cI) {
-    adjustArrayBoundaries(&matrices->Q_cI,
-                          &matrices->k_min_Q_cI,
-                          &matrices->k_max_Q_cI,
-                          &matrices->l_min_Q_cI,
-                          &matrices->l_max_Q_cI,
-                          min_k_real_qcI,
-                          max_k_real_qcI,
-                          min_l_real_qcI,
-                          max_l_real_qcI
-                          );
-  }
+  if (Q_B[pq]) {
+    for (k = q + 1; k < seq_length; k++) {
+      unsigned int ln1, lstart, ln_pre;
+      ln1 = k - q - 1;
+      if (ln1 + p - 1 > MAXLOOP)
+        break;
+
+      lstart  = k + TURN + 1;
+      ln_pre  = ln1 + p + seq_length;
+      if (ln_pre > lstart + MAXLOOP)
+        lstart = ln_pre - MAXLOOP - 1;
+
+      for (l = lstart; l <= seq_length; l++) {
+        unsigned int  ln2;
+        int           type2;
+        kl  = my_iindx[k] - l;
+        ln2 = (p - 1) + (seq_length - l);
+
+        if ((ln1 + ln2) > MAXLOOP)
+          continue;
 
-  /* 3. Multiloops  */
-  if (seq_length > 2 * TURN - 3) {
-#ifdef _OPENMP
-#pragma omp parallel for private(k, da, db, cnt1, cnt2, cnt3, cnt4)
-#endif
-    for (k = TURN + 2; k < seq_length - 2 * TURN - 3; k++) {
-      if (Q_M_rem[my_iindx[1] - k]) {
-        if (matrices->Q_M2[k + 1]) {
-          for (cnt1 = matrices->k_min_Q_M2[k + 1];
-               cnt1 <= matrices->k_max_Q_M2[k + 1];
-               cnt1++)
-            for (cnt2 = matrices->l_min_Q_M2[k + 1][cnt1];
-                 cnt2 <= matrices->l_max_Q_M2[k + 1][cnt1];
-                 cnt2 += 2)
-              matrices->Q_cM_rem += Q_M_rem[my_iindx[1] - k] * matrices->Q_M2[k + 1][cnt1][cnt2 / 2] * pf_params->expMLclosing;
-        }
+        type2 = ptype[jindx[l] + k];
+        if (!type2)
+          continue;
 
-        if (matrices->Q_M2_rem[k + 1])
-          matrices->Q_cM_rem += Q_M_rem[my_iindx[1] - k] * matrices->Q_M2_rem[k + 1] * pf_params->expMLclosing;
-      }
+        qot = exp_E_IntLoop(ln2, ln1, rtype[type2], type, S1[l + 1], S1[k - 1], S1[p - 1], S1[q + 1], pf_params) * scale[ln1 + ln2];
 
-      if (matrices->Q_M2_rem[k + 1]) {
-        if (Q_M[my_iindx[1] - k]) {
-          for (cnt1 = k_min_Q_M[my_iindx[1] - k];
-               cnt1 <= k_max_Q_M[my_iindx[1] - k];
+        if (Q_B_rem[kl]) {
+          for (cnt1 = k_min_Q_B[pq];
+               cnt1 <= k_max_Q_B[pq];
                cnt1++)
-            for (cnt2 = l_min_Q_M[my_iindx[1] - k][cnt1];
-                 cnt2 <= l_max_Q_M[my_iindx[1] - k][cnt1];
+            for (cnt2 = l_min_Q_B[pq][cnt1];
+                 cnt2 <= l_max_Q_B[pq][cnt1];
                  cnt2 += 2)
-              matrices->Q_cM_rem += Q_M[my_iindx[1] - k][cnt1][cnt2 / 2] * matrices->Q_M2_rem[k + 1] * pf_params->expMLclosing;
+              part->Q_cI_rem += Q_B[pq][cnt1][cnt2 / 2] * Q_B_rem[kl] * qot;
         }
-      }
 
-      /* get distancies to references
-       * d3a = dbp(T1_[1,n}, T1_{1,k} + T1_{k+1, n})
-       * d3b = dbp(T2_[1,n}, T2_{1,k} + T2_{k+1, n})
-       */
-      da  = base_d1 - referenceBPs1[my_iindx[1] - k] - referenceBPs1[my_iindx[k + 1] - seq_length];
-      db  = base_d2 - referenceBPs2[my_iindx[1] - k] - referenceBPs2[my_iindx[k + 1] - seq_length];
-      if (Q_M[my_iindx[1] - k] && matrices->Q_M2[k + 1]) {
-        for (cnt1 = k_min_Q_M[my_iindx[1] - k]; cnt1 <= k_max_Q_M[my_iindx[1] - k]; cnt1++)
-          for (cnt2 = l_min_Q_M[my_iindx[1] - k][cnt1]; cnt2 <= l_max_Q_M[my_iindx[1] - k][cnt1]; cnt2 += 2)
-            for (cnt3 = matrices->k_min_Q_M2[k + 1]; cnt3 <= matrices->k_max_Q_M2[k + 1]; cnt3++)
-              for (cnt4 = matrices->l_min_Q_M2[k + 1][cnt3]; cnt4 <= matrices->l_max_Q_M2[k + 1][cnt3]; cnt4 += 2) {
-                if (((cnt1 + cnt3 + da) <= maxD1) && ((cnt2 + cnt4 + db) <= maxD2)) {
-                  matrices->Q_cM[cnt1 + cnt3 + da][(cnt2 + cnt4 + db) / 2] += Q_M[my_iindx[1] - k][cnt1][cnt2 / 2] * matrices->Q_M2[k + 1][cnt3][cnt4 / 2] * pf_params->expMLclosing;
-                  if (update_cM) {
+        if (!Q_B[kl])
+          continue;
+
+        /* get distance to reference if closing the interior loop
+         *  d2a = dbp(T1_[1,n}, T1_{p,q} + T1_{k,l})
+         *  d2b = dbp(T2_[1,n}, T2_{p,q} + T2_{k,l})
+         */
+        da  = base_d1 - referenceBPs1[pq] - referenceBPs1[kl];
+        db  = base_d2 - referenceBPs2[pq] - referenceBPs2[kl];
+
+        for (cnt1 = k_min_Q_B[pq]; cnt1 <= k_max_Q_B[pq]; cnt1++)
+          for (cnt2 = l_min_Q_B[pq][cnt1]; cnt2 <= l_max_Q_B[pq][cnt1]; cnt2 += 2)
+            for (cnt3 = k_min_Q_B[kl]; cnt3 <= k_max_Q_B[kl]; cnt3++)
+              for (cnt4 = l_min_Q_B[kl][cnt3]; cnt4 <= l_max_Q_B[kl][cnt3]; cnt4 += 2) {
+                if (IN_SCOPE(vc, cnt1 + cnt3 + da, cnt2 + cnt4 + db)) {
+                  part->Q_cI[cnt1 + cnt3 + da][(cnt2 + cnt4 + db) / 2] += Q_B[pq][cnt1][cnt2 / 2] * Q_B[kl][cnt3][cnt4 / 2] * qot;
+                  if (batch->update_cI) {
                     updatePosteriorBoundaries(cnt1 + cnt3 + da,
                                               cnt2 + cnt4 + db,
-                                              &min_k_real_qcM,
-                                              &max_k_real_qcM,
-                                              &min_l_real_qcM,
-                                              &max_l_real_qcM
+                                              &part->k_min_cI,
+                                              &part->k_max_cI,
+                                              &part->l_min_cI,
+                                              &part->l_max_cI
                                               );
                   }
                 } else {
-                  matrices->Q_cM_rem += Q_M[my_iindx[1] - k][cnt1][cnt2 / 2] * matrices->Q_M2[k + 1][cnt3][cnt4 / 2] * pf_params->expMLclosing;
+                  part->Q_cI_rem += Q_B[pq][cnt1][cnt2 / 2] * Q_B[kl][cnt3][cnt4 / 2] * qot;
                 }
               }
       }
     }
   }
+}
 
-  if (update_cM) {
-    adjustArrayBoundaries(&matrices->Q_cM,
-                          &matrices->k_min_Q_cM,
-                          &matrices->k_max_Q_cM,
-                          &matrices->l_min_Q_cM,
-                          &matrices->l_max_Q_cM,
-                          min_k_real_qcM,
-                          max_k_real_qcM,
-                          min_l_real_qcM,
-                          max_l_real_qcM
-                          );
+
+/* exterior multiloop split into Q_M[1,k] and Q_M2[k+1] */
+PRIVATE void
+pf2D_circ_exterior_ML(circ_batch_t    *batch,
+                      circ_partial_t  *part,
+                      unsigned int    k)
+{
+  unsigned int          da, db, seq_length, maxD1, maxD2, base_d1, base_d2;
+  unsigned int          *referenceBPs1, *referenceBPs2;
+  int                   *my_iindx, cnt1, cnt2, cnt3, cnt4;
+  int                   **l_min_Q_M, **l_max_Q_M, *k_min_Q_M, *k_max_Q_M;
+  FLT_OR_DBL            ***Q_M, *Q_M_rem;
+  vrna_exp_param_t      *pf_params;
+  vrna_mx_pf_t          *matrices;
+  vrna_fold_compound_t  *vc;
+
+  vc            = batch->vc;
+  pf_params     = vc->exp_params;
+  matrices      = vc->exp_matrices;
+  seq_length    = vc->length;
+  maxD1         = vc->maxD1;
+  maxD2         = vc->maxD2;
+  my_iindx      = vc->iindx;
+  referenceBPs1 = vc->referenceBPs1;
+  referenceBPs2 = vc->referenceBPs2;
+  base_d1       = referenceBPs1[my_iindx[1] - seq_length];
+  base_d2       = referenceBPs2[my_iindx[1] - seq_length];
+
+  Q_M       = matrices->Q_M;
+  l_min_Q_M = matrices->l_min_Q_M;
+  l_max_Q_M = matrices->l_max_Q_M;
+  k_min_Q_M = matrices->k_min_Q_M;
+  k_max_Q_M = matrices->k_max_Q_M;
+  Q_M_rem   = matrices->Q_M_rem;
+
+  if (Q_M_rem[my_iindx[1] - k]) {
+    if (matrices->Q_M2[k + 1]) {
+      for (cnt1 = matrices->k_min_Q_M2[k + 1];
+           cnt1 <= matrices->k_max_Q_M2[k + 1];
+           cnt1++)
+        for (cnt2 = matrices->l_min_Q_M2[k + 1][cnt1];
+             cnt2 <= matrices->l_max_Q_M2[k + 1][cnt1];
+             cnt2 += 2)
+          part->Q_cM_rem += Q_M_rem[my_iindx[1] - k] * matrices->Q_M2[k + 1][cnt1][cnt2 / 2] * pf_params->expMLclosing;
+    }
+
+    if (matrices->Q_M2_rem[k + 1])
+      part->Q_cM_rem += Q_M_rem[my_iindx[1] - k] * matrices->Q_M2_rem[k + 1] * pf_params->expMLclosing;
   }
 
-  for (cnt1 = matrices->k_min_Q_cH;
-       cnt1 <= matrices->k_max_Q_cH;
-       cnt1++)
-    for (cnt2 = matrices->l_min_Q_cH[cnt1];
-         cnt2 <= matrices->l_max_Q_cH[cnt1];
-         cnt2 += 2) {
-      matrices->Q_c[cnt1][cnt2 / 2] += matrices->Q_cH[cnt1][cnt2 / 2];
-      if (update_c) {
-        updatePosteriorBoundaries(cnt1,
-                                  cnt2,
-                                  &min_k_real,
-                                  &max_k_real,
-                                  &min_l_real,
-                                  &max_l_real
-                                  );
-      }
+  if (matrices->Q_M2_rem[k + 1]) {
+    if (Q_M[my_iindx[1] - k]) {
+      for (cnt1 = k_min_Q_M[my_iindx[1] - k];
+           cnt1 <= k_max_Q_M[my_iindx[1] - k];
+           cnt1++)
+        for (cnt2 = l_min_Q_M[my_iindx[1] - k][cnt1];
+             cnt2 <= l_max_Q_M[my_iindx[1] - k][cnt1];
+             cnt2 += 2)
+          part->Q_cM_rem += Q_M[my_iindx[1] - k][cnt1][cnt2 / 2] * matrices->Q_M2_rem[k + 1] * pf_params->expMLclosing;
     }
-  for (cnt1 = matrices->k_min_Q_cI;
-       cnt1 <= matrices->k_max_Q_cI;
-       cnt1++)
-    for (cnt2 = matrices->l_min_Q_cI[cnt1];
-         cnt2 <= matrices->l_max_Q_cI[cnt1];
-         cnt2 += 2) {
-      matrices->Q_c[cnt1][cnt2 / 2] += matrices->Q_cI[cnt1][cnt2 / 2];
-      if (update_c) {
-        updatePosteriorBoundaries(cnt1,
-                                  cnt2,
-                                  &min_k_real,
-                                  &max_k_real,
-                                  &min_l_real,
-                                  &max_l_real
-                                  );
-      }
+  }
+
+  /* get distancies to references
+   * d3a = dbp(T1_[1,n}, T1_{1,k} + T1_{k+1, n})
+   * d3b = dbp(T2_[1,n}, T2_{1,k} + T2_{k+1, n})
+   */
+  da  = base_d1 - referenceBPs1[my_iindx[1] - k] - referenceBPs1[my_iindx[k + 1] - seq_length];
+  db  = base_d2 - referenceBPs2[my_iindx[1] - k] - referenceBPs2[my_iindx[k + 1] - seq_length];
+  if (Q_M[my_iindx[1] - k] && matrices->Q_M2[k + 1]) {
+    for (cnt1 = k_min_Q_M[my_iindx[1] - k]; cnt1 <= k_max_Q_M[my_iindx[1] - k]; cnt1++)
+      for (cnt2 = l_min_Q_M[my_iindx[1] - k][cnt1]; cnt2 <= l_max_Q_M[my_iindx[1] - k][cnt1]; cnt2 += 2)
+        for (cnt3 = matrices->k_min_Q_M2[k + 1]; cnt3 <= matrices->k_max_Q_M2[k + 1]; cnt3++)
+          for (cnt4 = matrices->l_min_Q_M2[k + 1][cnt3]; cnt4 <= matrices->l_max_Q_M2[k + 1][cnt3]; cnt4 += 2) {
+            if (IN_SCOPE(vc, cnt1 + cnt3 + da, cnt2 + cnt4 + db)) {
+              part->Q_cM[cnt1 + cnt3 + da][(cnt2 + cnt4 + db) / 2] += Q_M[my_iindx[1] - k][cnt1][cnt2 / 2] * matrices->Q_M2[k + 1][cnt3][cnt4 / 2] * pf_params->expMLclosing;
+              if (batch->update_cM) {
+                updatePosteriorBoundaries(cnt1 + cnt3 + da,
+                                          cnt2 + cnt4 + db,
+                                          &part->k_min_cM,
+                                          &part->k_max_cM,
+                                          &part->l_min_cM,
+                                          &part->l_max_cM
+                                          );
+              }
+            } else {
+              part->Q_cM_rem += Q_M[my_iindx[1] - k][cnt1][cnt2 / 2] * matrices->Q_M2[k + 1][cnt3][cnt4 / 2] * pf_params->expMLclosing;
+            }
+          }
+  }
+}
+
+
+/* allocate a partial sum of the same shape as the circular exterior loop matrices */
+PRIVATE void
+prepare_circ_partial(vrna_mx_pf_t   *matrices,
+                     circ_batch_t   *batch,
+                     circ_partial_t *part,
+                     int            size,
+                     int            shift)
+{
+  prepareArray(&part->Q_cH,
+               matrices->k_min_Q_cH,
+               matrices->k_max_Q_cH,
+               matrices->l_min_Q_cH,
+               matrices->l_max_Q_cH
+               );
+  prepareArray(&part->Q_cI,
+               matrices->k_min_Q_cI,
+               matrices->k_max_Q_cI,
+               matrices->l_min_Q_cI,
+               matrices->l_max_Q_cI
+               );
+  prepareArray(&part->Q_cM,
+               matrices->k_min_Q_cM,
+               matrices->k_max_Q_cM,
+               matrices->l_min_Q_cM,
+               matrices->l_max_Q_cM
+               );
+
+  if (batch->update_cH)
+    preparePosteriorBoundaries(size, shift, &part->k_min_cH, &part->k_max_cH, &part->l_min_cH, &part->l_max_cH);
+
+  if (batch->update_cI)
+    preparePosteriorBoundaries(size, shift, &part->k_min_cI, &part->k_max_cI, &part->l_min_cI, &part->l_max_cI);
+
+  if (batch->update_cM)
+    preparePosteriorBoundaries(size, shift, &part->k_min_cM, &part->k_max_cM, &part->l_min_cM, &part->l_max_cM);
+}
+
+
+PRIVATE INLINE void
+merge_circ_grid(FLT_OR_DBL  **grid,
+                int         k_min,
+                int         k_max,
+                int         *l_min,
+                int         *l_max,
+                FLT_OR_DBL  **partial)
+{
+  int k, l;
+
+  for (k = k_min; k <= k_max; k++)
+    for (l = l_min[k]; l <= l_max[k]; l += 2)
+      grid[k][l / 2] += partial[k][l / 2];
+
+  free(partial + k_min);
+}
+
+
+PRIVATE INLINE void
+merge_circ_boundaries(int *k_min,
+                      int *k_max,
+                      int **l_min,
+                      int **l_max,
+                      int k_min_part,
+                      int k_max_part,
+                      int *l_min_part,
+                      int *l_max_part,
+                      int shift)
+{
+  int k;
+
+  for (k = k_min_part; k <= k_max_part; k++)
+    if (l_min_part[k] < INF) {
+      updatePosteriorBoundaries(k, l_min_part[k], k_min, k_max, l_min, l_max);
+      updatePosteriorBoundaries(k, l_max_part[k], k_min, k_max, l_min, l_max);
     }
-  for (cnt1 = matrices->k_min_Q_cM;
-       cnt1 <= matrices->k_max_Q_cM;
-       cnt1++)
-    for (cnt2 = matrices->l_min_Q_cM[cnt1];
-         cnt2 <= matrices->l_max_Q_cM[cnt1];
-         cnt2 += 2) {
-      matrices->Q_c[cnt1][cnt2 / 2] += matrices->Q_cM[cnt1][cnt2 / 2];
-      if (update_c) {
-        updatePosteriorBoundaries(cnt1,
-                                  cnt2,
-                                  &min_k_real,
-                                  &max_k_real,
-                                  &min_l_real,
-                                  &max_l_real
-                                  );
+
+  free(l_min_part + shift);
+  free(l_max_part + shift);
+}
+
+
+/* add a partial sum to the first one and release its memory */
+PRIVATE void
+merge_circ_partial(vrna_mx_pf_t   *matrices,
+                   circ_batch_t   *batch,
+                   circ_partial_t *part,
+                   int            shift)
+{
+  circ_partial_t *first = batch->partials;
+
+  merge_circ_grid(matrices->Q_cH,
+                  matrices->k_min_Q_cH,
+                  matrices->k_max_Q_cH,
+                  matrices->l_min_Q_cH,
+                  matrices->l_max_Q_cH,
+                  part->Q_cH);
+  merge_circ_grid(matrices->Q_cI,
+                  matrices->k_min_Q_cI,
+                  matrices->k_max_Q_cI,
+                  matrices->l_min_Q_cI,
+                  matrices->l_max_Q_cI,
+                  part->Q_cI);
+  merge_circ_grid(matrices->Q_cM,
+                  matrices->k_min_Q_cM,
+                  matrices->k_max_Q_cM,
+                  matrices->l_min_Q_cM,
+                  matrices->l_max_Q_cM,
+                  part->Q_cM);
+
+  if (batch->update_cH)
+    merge_circ_boundaries(&first->k_min_cH, &first->k_max_cH, &first->l_min_cH, &first->l_max_cH,
+                          part->k_min_cH, part->k_max_cH, part->l_min_cH, part->l_max_cH,
+                          shift);
+
+  if (batch->update_cI)
+    merge_circ_boundaries(&first->k_min_cI, &first->k_max_cI, &first->l_min_cI, &first->l_max_cI,
+                          part->k_min_cI, part->k_max_cI, part->l_min_cI, part->l_max_cI,
+                          shift);
+
+  if (batch->update_cM)
+    merge_circ_boundaries(&first->k_min_cM, &first->k_max_cM, &first->l_min_cM, &first->l_max_cM,
+                          part->k_min_cM, part->k_max_cM, part->l_min_cM, part->l_max_cM,
+                          shift);
+}
+
+
+/* construct Q_M2[k] for k = idx + 1 of a circular RNA */
+PRIVATE void
+pf2D_circ_M2(void         *data,
+             unsigned int idx)
+{
+  unsigned int          k, l, da, db, seq_length, maxD1, maxD2, *referenceBPs1, *referenceBPs2, *mm1, *mm2, *bpdist;
+  int                   *my_iindx, *jindx, cnt1, cnt2, cnt3, cnt4;
+  int                   k_min_Q_M2, k_max_Q_M2, l_min_Q_M2, l_max_Q_M2;
+  int                   k_min_post_m2, k_max_post_m2, *l_min_post_m2, *l_max_post_m2, update_m2;
+  int                   **l_min_Q_M1, **l_max_Q_M1, *k_min_Q_M1, *k_max_Q_M1;
+  FLT_OR_DBL            ***Q_M1, *Q_M1_rem;
+  vrna_fold_compound_t  *vc;
+  vrna_mx_pf_t          *matrices;
+
+  vc            = (vrna_fold_compound_t *)data;
+  matrices      = vc->exp_matrices;
+  seq_length    = vc->length;
+  maxD1         = vc->maxD1;
+  maxD2         = vc->maxD2;
+  my_iindx      = vc->iindx;
+  jindx         = vc->jindx;
+  referenceBPs1 = vc->referenceBPs1;
+  referenceBPs2 = vc->referenceBPs2;
+  mm1           = vc->mm1;
+  mm2           = vc->mm2;
+  bpdist        = vc->bpdist;
+
+  Q_M1        = matrices->Q_M1;
+  l_min_Q_M1  = matrices->l_min_Q_M1;
+  l_max_Q_M1  = matrices->l_max_Q_M1;
+  k_min_Q_M1  = matrices->k_min_Q_M1;
+  k_max_Q_M1  = matrices->k_max_Q_M1;
+  Q_M1_rem    = matrices->Q_M1_rem;
+
+  k             = idx + 1;
+  update_m2     = 0;
+  l_min_post_m2 = l_max_post_m2 = NULL;
+
+  if (!matrices->Q_M2[k]) {
+    update_m2   = 1;
+    k_min_Q_M2  = l_min_Q_M2 = 0;
+    k_max_Q_M2  = mm1[my_iindx[k] - seq_length] + referenceBPs1[my_iindx[k] - seq_length];
+    l_max_Q_M2  = mm2[my_iindx[k] - seq_length] + referenceBPs2[my_iindx[k] - seq_length];
+
+    prepareBoundaries(vc,
+                      k_min_Q_M2,
+                      k_max_Q_M2,
+                      l_min_Q_M2,
+                      l_max_Q_M2,
+                      bpdist[my_iindx[k] - seq_length],
+                      &matrices->k_min_Q_M2[k],
+                      &matrices->k_max_Q_M2[k],
+                      &matrices->l_min_Q_M2[k],
+                      &matrices->l_max_Q_M2[k]
+                      );
+    preparePosteriorBoundaries(matrices->k_max_Q_M2[k] - matrices->k_min_Q_M2[k] + 1,
+                               matrices->k_min_Q_M2[k],
+                               &k_min_post_m2,
+                               &k_max_post_m2,
+                               &l_min_post_m2,
+                               &l_max_post_m2
+                               );
+
+    prepareArray(&matrices->Q_M2[k],
+                 matrices->k_min_Q_M2[k],
+                 matrices->k_max_Q_M2[k],
+                 matrices->l_min_Q_M2[k],
+                 matrices->l_max_Q_M2[k]
+                 );
+  }
+
+  /* construct Q_M2 */
+  for (l = k + TURN + 1; l < seq_length - TURN - 1; l++) {
+    if (Q_M1_rem[jindx[l] + k]) {
+      if (Q_M1[jindx[seq_length] + l + 1]) {
+        for (cnt1 = k_min_Q_M1[jindx[seq_length] + l + 1];
+             cnt1 <= k_max_Q_M1[jindx[seq_length] + l + 1];
+             cnt1++)
+          for (cnt2 = l_min_Q_M1[jindx[seq_length] + l + 1][cnt1];
+               cnt2 <= l_max_Q_M1[jindx[seq_length] + l + 1][cnt1];
+               cnt2 += 2)
+            matrices->Q_M2_rem[k] += Q_M1_rem[jindx[l] + k] * Q_M1[jindx[seq_length] + l + 1][cnt1][cnt2 / 2];
       }
+
+      if (Q_M1_rem[jindx[seq_length] + l + 1])
+        matrices->Q_M2_rem[k] += Q_M1_rem[jindx[l] + k] * Q_M1_rem[jindx[seq_length] + l + 1];
     }
 
-  matrices->Q_c_rem = matrices->Q_cH_rem + matrices->Q_cI_rem + matrices->Q_cM_rem;
+    if (Q_M1_rem[jindx[seq_length] + l + 1]) {
+      if (Q_M1[jindx[l] + k]) {
+        for (cnt1 = k_min_Q_M1[jindx[l] + k];
+             cnt1 <= k_max_Q_M1[jindx[l] + k];
+             cnt1++)
+          for (cnt2 = l_min_Q_M1[jindx[l] + k][cnt1];
+               cnt2 <= l_max_Q_M1[jindx[l] + k][cnt1];
+               cnt2 += 2)
+            matrices->Q_M2_rem[k] += Q_M1[jindx[l] + k][cnt1][cnt2 / 2] * Q_M1_rem[jindx[seq_length] + l + 1];
+      }
+    }
 
-  /* add the case were structure is unfolded chain */
-  if ((referenceBPs1[my_iindx[1] - seq_length] <= maxD1) && (referenceBPs2[my_iindx[1] - seq_length] <= maxD2)) {
-    matrices->Q_c[referenceBPs1[my_iindx[1] - seq_length]][referenceBPs2[my_iindx[1] - seq_length] / 2] += 1.0 * scale[seq_length];
-    if (update_c) {
-      updatePosteriorBoundaries(referenceBPs1[my_iindx[1] - seq_length],
-                                referenceBPs2[my_iindx[1] - seq_length],
-                                &min_k_real,
-                                &max_k_real,
-                                &min_l_real,
-                                &max_l_real
-                                );
+    if (matrices->Q_M1[jindx[l] + k] && matrices->Q_M1[jindx[seq_length] + l + 1]) {
+      da  = referenceBPs1[my_iindx[k] - seq_length] - referenceBPs1[my_iindx[k] - l] - referenceBPs1[my_iindx[l + 1] - seq_length];
+      db  = referenceBPs2[my_iindx[k] - seq_length] - referenceBPs2[my_iindx[k] - l] - referenceBPs2[my_iindx[l + 1] - seq_length];
+      for (cnt1 = k_min_Q_M1[jindx[l] + k]; cnt1 <= k_max_Q_M1[jindx[l] + k]; cnt1++)
+        for (cnt2 = l_min_Q_M1[jindx[l] + k][cnt1]; cnt2 <= l_max_Q_M1[jindx[l] + k][cnt1]; cnt2 += 2) {
+          for (cnt3 = k_min_Q_M1[jindx[seq_length] + l + 1]; cnt3 <= k_max_Q_M1[jindx[seq_length] + l + 1]; cnt3++)
+            for (cnt4 = l_min_Q_M1[jindx[seq_length] + l + 1][cnt3]; cnt4 <= l_max_Q_M1[jindx[seq_length] + l + 1][cnt3]; cnt4 += 2) {
+              if (IN_SCOPE(vc, cnt1 + cnt3 + da, cnt2 + cnt4 + db)) {
+                matrices->Q_M2[k][cnt1 + cnt3 + da][(cnt2 + cnt4 + db) / 2] += Q_M1[jindx[l] + k][cnt1][cnt2 / 2] * Q_M1[jindx[seq_length] + l + 1][cnt3][cnt4 / 2];
+                if (update_m2) {
+                  updatePosteriorBoundaries(cnt1 + cnt3 + da,
+                                            cnt2 + cnt4 + db,
+                                            &k_min_post_m2,
+                                            &k_max_post_m2,
+                                            &l_min_post_m2,
+                                            &l_max_post_m2
+                                            );
+                }
+              } else {
+                matrices->Q_M2_rem[k] += Q_M1[jindx[l] + k][cnt1][cnt2 / 2] * Q_M1[jindx[seq_length] + l + 1][cnt3][cnt4 / 2];
+              }
+            }
+        }
     }
-  } else {
-    matrices->Q_c_rem += 1.0 * scale[seq_length];
   }
-
-  adjustArrayBoundaries(&matrices->Q_c,
-                        &matrices->k_min_Q_c,
-                        &matrices->k_max_Q_c,
-                        &matrices->l_min_Q_c,
-                        &matrices->l_max_Q_c,
-                        min_k_real,
-                        max_k_real,
-                        min_l_real,
-                        max_l_real
-                        );
+  if (update_m2) {
+    adjustArrayBoundaries(&matrices->Q_M2[k],
+                          &matrices->k_min_Q_M2[k],
+                          &matrices->k_max_Q_M2[k],
+                          &matrices->l_min_Q_M2[k],
+                          &matrices->l_max_Q_M2[k],
+                          k_min_post_m2,
+                          k_max_post_m2,
+                          l_min_post_m2,
+                          l_max_post_m2
+                          );
+  }
 }
 
+
 /*
  * ###################################################
  * stochastic backtracking
@@ -1881,7 +2290,7 @@ vrna_pbacktrack_TwoD(vrna_fold_compound_t *vc,
                      int                  d1,
                      int                  d2)
 {
-  return vrna_pbacktrack5_TwoD(vc, d1, d2, vc->length);
+  return pbacktrack5(vc, d1, d2, vc->length, NULL);
 }
 
 
@@ -1890,6 +2299,83 @@ vrna_pbacktrack5_TwoD(vrna_fold_compound_t  *vc,
                       int                   d1,
                       int                   d2,
                       unsigned int          length)
+{
+  return pbacktrack5(vc, d1, d2, length, NULL);
+}
+
+
+PUBLIC char **
+vrna_pbacktrack_TwoD_num(vrna_fold_compound_t *vc,
+                         int                  d1,
+                         int                  d2,
+                         unsigned int         num)
+{
+  unsigned int    s;
+  unsigned short  *seeds;
+  char            **structures;
+  sample_batch_t  batch;
+  twoD_pool_t     pool;
+
+  if ((!vc) || (!vc->exp_matrices)) {
+    vrna_message_warning("vrna_pbacktrack_TwoD_num@2Dpfold.c: "
+                         "missing partition function matrices!");
+    return NULL;
+  }
+
+  structures = (char **)vrna_alloc(sizeof(char *) * (num + 1));
+
+  /*
+   *  draw the seeds of all samples from the global random number
+   *  generator first. This way, the samples only depend on the state
+   *  of the generator, but not on the number of threads
+   */
+  seeds = (unsigned short *)vrna_alloc(sizeof(unsigned short) * 3 * (num + 1));
+  for (s = 0; s < 3 * num; s++)
+    seeds[s] = (unsigned short)vrna_int_urn(0, 65535);
+
+  batch.vc          = vc;
+  batch.d1          = d1;
+  batch.d2          = d2;
+  batch.seeds       = seeds;
+  batch.structures  = structures;
+
+  twoD_pool_init(&pool, vc);
+  twoD_pool_for(&pool, num, NULL, &sample_job, (void *)&batch);
+  twoD_pool_free(&pool);
+
+  free(seeds);
+
+  return structures;
+}
+
+
+PRIVATE void
+sample_job(void         *data,
+           unsigned int s)
+{
+  sample_batch_t *batch = (sample_batch_t *)data;
+
+  batch->structures[s] = pbacktrack5(batch->vc,
+                                     batch->d1,
+                                     batch->d2,
+                                     batch->vc->length,
+                                     batch->seeds + 3 * s);
+}
+
+
+PRIVATE INLINE double
+sample_urn(unsigned short *rng)
+{
+  return (rng) ? erand48(rng) : vrna_urn();
+}
+
+
+PRIVATE char *
+pbacktrack5(vrna_fold_compound_t  *vc,
+            int                   d1,
+            int                   d2,
+            unsigned int          length,
+            unsigned short        *rng)
 {
   char *pstruc, *ptype;
   short *S1;
@@ -1940,7 +2426,7 @@ vrna_pbacktrack5_TwoD(vrna_fold_compound_t  *vc,
     if (n != length)
       vrna_message_error("vrna_pbacktrack_TwoD@2Dfold.c: cotranscriptional backtracking for circular RNAs not supported!");
 
-    return pbacktrack_circ(vc, d1, d2);
+    return pbacktrack_circ(vc, d1, d2, rng);
   }
 
   if (length > n)
@@ -1991,16 +2477,15 @@ vrna_pbacktrack5_TwoD(vrna_fold_compound_t  *vc,
       qln_i = Q_rem[sn];
 
       /* open chain ? */
-      if ((maxD1 > referenceBPs1[sn])
-          && (maxD2 > referenceBPs2[sn])) {
-        r = vrna_urn() * qln_i;
+      if (!IN_SCOPE(vc, referenceBPs1[sn], referenceBPs2[sn])) {
+        r = sample_urn(rng) * qln_i;
         if (scale[length - start + 1] > r)
           return pstruc;
       }
 
       /* lets see if we find a base pair with i involved */
       for (i = start; i < length; i++) {
-        r = vrna_urn() * qln_i;
+        r = sample_urn(rng) * qln_i;
 
         qln_i1 = Q_rem[my_iindx[i + 1] - length];
 
@@ -2013,7 +2498,7 @@ vrna_pbacktrack5_TwoD(vrna_fold_compound_t  *vc,
           for (cnt2 = l_min_Q[my_iindx[i + 1] - length][cnt1];
                cnt2 <= l_max_Q[my_iindx[i + 1] - length][cnt1];
                cnt2 += 2)
-            if (((cnt1 + da) > maxD1) || ((cnt2 + db) > maxD2))
+            if (!IN_SCOPE(vc, cnt1 + da, cnt2 + db))
               qln_i1 += Q[my_iindx[i + 1] - length][cnt1][cnt2 / 2];
 
         if (r > qln_i1 * scale[1])
@@ -2025,7 +2510,7 @@ vrna_pbacktrack5_TwoD(vrna_fold_compound_t  *vc,
         break;              /* no more pairs */
 
       /* i is paired, find pairing partner j */
-      r = vrna_urn() * (qln_i - qln_i1 * scale[1]);
+      r = sample_urn(rng) * (qln_i - qln_i1 * scale[1]);
       for (qt = 0, j = i + TURN + 1; j < length; j++) {
         ij    = my_iindx[i] - j;
         type  = ptype[jindx[j] + i];
@@ -2086,7 +2571,7 @@ vrna_pbacktrack5_TwoD(vrna_fold_compound_t  *vc,
                   for (cnt4 = l_min_Q[my_iindx[j + 1] - length][cnt3];
                        cnt4 <= l_max_Q[my_iindx[j + 1] - length][cnt3];
                        cnt4 += 2)
-                    if (((cnt1 + cnt3 + da) > maxD1) || ((cnt2 + cnt4 + db) > maxD2)) {
+                    if (!IN_SCOPE(vc, cnt1 + cnt3 + da, cnt2 + cnt4 + db)) {
                       qt += qkl * Q_B[ij][cnt1][cnt2 / 2] * Q[my_iindx[j + 1] - length][cnt3][cnt4 / 2];
                       if (qt >= r)
                         goto pbacktrack_ext_loop_early_escape_rem;
@@ -2117,7 +2602,7 @@ vrna_pbacktrack5_TwoD(vrna_fold_compound_t  *vc,
             for (cnt2 = l_min_Q_B[ij][cnt1];
                  cnt2 <= l_max_Q_B[ij][cnt1];
                  cnt2 += 2)
-              if (((cnt1 + da) > maxD1) || ((cnt2 + db) > maxD2)) {
+              if (!IN_SCOPE(vc, cnt1 + da, cnt2 + db)) {
                 qt += qkl * Q_B[ij][cnt1][cnt2 / 2];
                 if (qt >= r)
                   goto pbacktrack_ext_loop_early_escape_rem;
@@ -2133,7 +2618,7 @@ pbacktrack_ext_loop_early_escape_rem:
         vrna_message_error("pbacktrack@2Dpfold.c: backtracking failed in ext loop (rem)");
 
       /* finally start backtracking the first exterior stem */
-      backtrack(vc, pstruc, cnt1, cnt2, i, j);
+      backtrack(vc, pstruc, cnt1, cnt2, i, j, rng);
       if (j == length)
         break;
 
@@ -2147,13 +2632,13 @@ pbacktrack_ext_loop_early_escape_rem:
       /* open chain ? */
       if ((d1 == referenceBPs1[sn])
           && (d2 == referenceBPs2[sn])) {
-        r = vrna_urn() * qln_i;
+        r = sample_urn(rng) * qln_i;
         if (scale[length - start + 1] > r)
           return pstruc;
       }
 
       for (i = start; i < length; i++) {
-        r       = vrna_urn() * qln_i;
+        r       = sample_urn(rng) * qln_i;
         da      = referenceBPs1[sn] - referenceBPs1[my_iindx[i + 1] - length];
         db      = referenceBPs2[sn] - referenceBPs2[my_iindx[i + 1] - length];
         qln_i1  = 0;
@@ -2178,7 +2663,7 @@ pbacktrack_ext_loop_early_escape_rem:
         break;              /* no more pairs */
 
       /* now find the pairing partner j */
-      r = vrna_urn() * (qln_i - qln_i1 * scale[1]);
+      r = sample_urn(rng) * (qln_i - qln_i1 * scale[1]);
 
       for (qt = 0, j = i + 1; j < length; j++) {
         int type;
@@ -2244,7 +2729,7 @@ pbacktrack_ext_loop_early_escape:
       if (j == length + 1)
         vrna_message_error("pbacktrack@2Dpfold.c: backtracking failed in ext loop");
 
-      backtrack(vc, pstruc, cnt1, cnt2, i, j);
+      backtrack(vc, pstruc, cnt1, cnt2, i, j, rng);
 
       if (j == length)
         break;
@@ -2261,7 +2746,8 @@ pbacktrack_ext_loop_early_escape:
 PRIVATE char *
 pbacktrack_circ(vrna_fold_compound_t  *vc,
                 int                   d1,
-                int                   d2)
+                int                   d2,
+                unsigned short        *rng)
 {
   char *pstruc;
   unsigned int i, n, maxD1, maxD2,
@@ -2348,9 +2834,9 @@ pbacktrack_circ(vrna_fold_compound_t  *vc,
   qot = 0.;
   /* backtrack in rest-partition */
   if (d1 == -1) {
-    r = vrna_urn() * Q_c_rem;
+    r = sample_urn(rng) * Q_c_rem;
     /* open chain ? */
-    if ((referenceBPs1[my_iindx[1] - n] > maxD1) || (referenceBPs2[my_iindx[1] - n] > maxD2)) {
+    if (!IN_SCOPE(vc, referenceBPs1[my_iindx[1] - n], referenceBPs2[my_iindx[1] - n])) {
       qot = 1.0 * scale[n];
       if (qot >= r)
         goto pbacktrack_circ_escape;
@@ -2358,19 +2844,19 @@ pbacktrack_circ(vrna_fold_compound_t  *vc,
 
     qot += Q_cH_rem;
     if (qot >= r) {
-      backtrack_qcH(vc, pstruc, d1, d2);
+      backtrack_qcH(vc, pstruc, d1, d2, rng);
       goto pbacktrack_circ_escape;
     }
 
     qot += Q_cI_rem;
     if (qot >= r) {
-      backtrack_qcI(vc, pstruc, d1, d2);
+      backtrack_qcI(vc, pstruc, d1, d2, rng);
       goto pbacktrack_circ_escape;
     }
 
     qot += Q_cM_rem;
     if (qot >= r) {
-      backtrack_qcM(vc, pstruc, d1, d2);
+      backtrack_qcM(vc, pstruc, d1, d2, rng);
       goto pbacktrack_circ_escape;
     }
 
@@ -2378,7 +2864,7 @@ pbacktrack_circ(vrna_fold_compound_t  *vc,
   }
   /* normal backtracking */
   else {
-    r = vrna_urn() * Q_c[d1][d2 / 2];
+    r = sample_urn(rng) * Q_c[d1][d2 / 2];
 
     /* open chain ? */
     if ((referenceBPs1[my_iindx[1] - n] == d1) && (referenceBPs2[my_iindx[1] - n] == d2)) {
@@ -2394,7 +2880,7 @@ pbacktrack_circ(vrna_fold_compound_t  *vc,
         if ((l_min <= d2) && (l_max_Q_cH[d1] >= d2)) {
           qot += Q_cH[d1][d2 / 2];
           if (qot >= r) {
-            backtrack_qcH(vc, pstruc, d1, d2);
+            backtrack_qcH(vc, pstruc, d1, d2, rng);
             goto pbacktrack_circ_escape;
           }
         }
@@ -2408,7 +2894,7 @@ pbacktrack_circ(vrna_fold_compound_t  *vc,
         if ((l_min <= d2) && (l_max_Q_cI[d1] >= d2)) {
           qot += Q_cI[d1][d2 / 2];
           if (qot >= r) {
-            backtrack_qcI(vc, pstruc, d1, d2);
+            backtrack_qcI(vc, pstruc, d1, d2, rng);
             goto pbacktrack_circ_escape;
           }
         }
@@ -2422,7 +2908,7 @@ pbacktrack_circ(vrna_fold_compound_t  *vc,
         if ((l_min <= d2) && (l_max_Q_cM[d1] >= d2)) {
           qot += Q_cM[d1][d2 / 2];
           if (qot >= r) {
-            backtrack_qcM(vc, pstruc, d1, d2);
+            backtrack_qcM(vc, pstruc, d1, d2, rng);
             goto pbacktrack_circ_escape;
           }
         }
@@ -2439,7 +2925,8 @@ PRIVATE void
 backtrack_qcH(vrna_fold_compound_t  *vc,
               char                  *pstruc,
               int                   d1,
-              int                   d2)
+              int                   d2,
+              unsigned short        *rng)
 {
   char *ptype, *sequence;
   short *S1;
@@ -2489,7 +2976,7 @@ backtrack_qcH(vrna_fold_compound_t  *vc,
   base_d2 = referenceBPs2[my_iindx[1] - n];
 
   if (d1 == -1) {
-    r = vrna_urn() * Q_cH_rem;
+    r = sample_urn(rng) * Q_cH_rem;
     for (i = 1; i < n; i++)
       for (j = i + TURN + 1; j <= n; j++) {
         char loopseq[10];
@@ -2519,7 +3006,7 @@ backtrack_qcH(vrna_fold_compound_t  *vc,
         if (Q_B_rem[ij]) {
           qot += Q_B_rem[ij] * qt;
           if (qot >= r) {
-            backtrack(vc, pstruc, d1, d2, i, j);
+            backtrack(vc, pstruc, d1, d2, i, j, rng);
             return;
           }
         }
@@ -2534,11 +3021,10 @@ backtrack_qcH(vrna_fold_compound_t  *vc,
             for (cnt2 = l_min_Q_B[ij][cnt1];
                  cnt2 <= l_max_Q_B[ij][cnt1];
                  cnt2 += 2) {
-              if (((cnt1 + da) > maxD1)
-                  || ((cnt2 + db) > maxD2)) {
+              if (!IN_SCOPE(vc, cnt1 + da, cnt2 + db)) {
                 qot += Q_B[ij][cnt1][cnt2 / 2] * qt;
                 if (qot >= r) {
-                  backtrack(vc, pstruc, cnt1, cnt2, i, j);
+                  backtrack(vc, pstruc, cnt1, cnt2, i, j, rng);
                   return;
                 }
               }
@@ -2546,7 +3032,7 @@ backtrack_qcH(vrna_fold_compound_t  *vc,
         }
       }
   } else {
-    r = vrna_urn() * Q_cH[d1][d2 / 2];
+    r = sample_urn(rng) * Q_cH[d1][d2 / 2];
     for (i = 1; i < n; i++)
       for (j = i + TURN + 1; j <= n; j++) {
         char loopseq[10];
@@ -2588,7 +3074,7 @@ backtrack_qcH(vrna_fold_compound_t  *vc,
                 && ((cnt2 + db) == d2)) {
               qot += Q_B[ij][cnt1][cnt2 / 2] * qt;
               if (qot >= r) {
-                backtrack(vc, pstruc, cnt1, cnt2, i, j);
+                backtrack(vc, pstruc, cnt1, cnt2, i, j, rng);
                 return;
               }
             }
@@ -2604,7 +3090,8 @@ PRIVATE void
 backtrack_qcI(vrna_fold_compound_t  *vc,
               char                  *pstruc,
               int                   d1,
-              int                   d2)
+              int                   d2,
+              unsigned short        *rng)
 {
   char *ptype;
   short *S1;
@@ -2652,7 +3139,7 @@ backtrack_qcI(vrna_fold_compound_t  *vc,
   base_d2 = referenceBPs2[my_iindx[1] - n];
 
   if (d1 == -1) {
-    r = vrna_urn() * Q_cI_rem;
+    r = sample_urn(rng) * Q_cI_rem;
     for (i = 1; i < n; i++)
       for (j = i + TURN + 1; j <= n; j++) {
         ij    = my_iindx[i] - j;
@@ -2693,8 +3180,8 @@ backtrack_qcI(vrna_fold_compound_t  *vc,
               if (Q_B_rem[pq]) {
                 qot += Q_B_rem[ij] * Q_B_rem[pq] * qt;
                 if (qot > r) {
-                  backtrack(vc, pstruc, d1, d2, i, j);
-                  backtrack(vc, pstruc, d1, d2, p, q);
+                  backtrack(vc, pstruc, d1, d2, i, j, rng);
+                  backtrack(vc, pstruc, d1, d2, p, q, rng);
                   return;
                 }
               }
@@ -2708,8 +3195,8 @@ backtrack_qcI(vrna_fold_compound_t  *vc,
                        cnt2 += 2) {
                     qot += Q_B_rem[ij] * Q_B[pq][cnt1][cnt2 / 2] * qt;
                     if (qot > r) {
-                      backtrack(vc, pstruc, d1, d2, i, j);
-                      backtrack(vc, pstruc, cnt1, cnt2, p, q);
+                      backtrack(vc, pstruc, d1, d2, i, j, rng);
+                      backtrack(vc, pstruc, cnt1, cnt2, p, q, rng);
                       return;
                     }
                   }
@@ -2757,8 +3244,8 @@ backtrack_qcI(vrna_fold_compound_t  *vc,
                        cnt2 += 2) {
                     qot += Q_B[ij][cnt1][cnt2 / 2] * Q_B_rem[pq] * qt;
                     if (qot > r) {
-                      backtrack(vc, pstruc, cnt1, cnt2, i, j);
-                      backtrack(vc, pstruc, d1, d2, p, q);
+                      backtrack(vc, pstruc, cnt1, cnt2, i, j, rng);
+                      backtrack(vc, pstruc, d1, d2, p, q, rng);
                       return;
                     }
                   }
@@ -2783,14 +3270,13 @@ backtrack_qcI(vrna_fold_compound_t  *vc,
                       for (cnt4 = l_min_Q_B[pq][cnt3];
                            cnt4 <= l_max_Q_B[pq][cnt3];
                            cnt4 += 2) {
-                        if (((cnt1 + cnt3 + da) > maxD1)
-                            || ((cnt2 + cnt4 + db) > maxD2)) {
+                        if (!IN_SCOPE(vc, cnt1 + cnt3 + da, cnt2 + cnt4 + db)) {
                           qot += Q_B[ij][cnt1][cnt2 / 2]
                                  * Q_B[pq][cnt3][cnt4 / 2]
                                  * qt;
                           if (qot > r) {
-                            backtrack(vc, pstruc, cnt1, cnt2, i, j);
-                            backtrack(vc, pstruc, cnt3, cnt4, p, q);
+                            backtrack(vc, pstruc, cnt1, cnt2, i, j, rng);
+                            backtrack(vc, pstruc, cnt3, cnt4, p, q, rng);
                             return;
                           }
                         }
@@ -2801,7 +3287,7 @@ backtrack_qcI(vrna_fold_compound_t  *vc,
         }
       }
   } else {
-    r = vrna_urn() * Q_cI[d1][d2 / 2];
+    r = sample_urn(rng) * Q_cI[d1][d2 / 2];
     for (i = 1; i < n; i++)
       for (j = i + TURN + 1; j <= n; j++) {
         ij    = my_iindx[i] - j;
@@ -2868,8 +3354,8 @@ backtrack_qcI(vrna_fold_compound_t  *vc,
                              * Q_B[pq][cnt3][cnt4 / 2]
                              * qt;
                       if (qot > r) {
-                        backtrack(vc, pstruc, cnt1, cnt2, i, j);
-                        backtrack(vc, pstruc, cnt3, cnt4, p, q);
+                        backtrack(vc, pstruc, cnt1, cnt2, i, j, rng);
+                        backtrack(vc, pstruc, cnt3, cnt4, p, q, rng);
                         return;
                       }
                     }
@@ -2885,7 +3371,8 @@ PRIVATE void
 backtrack_qcM(vrna_fold_compound_t  *vc,
               char                  *pstruc,
               int                   d1,
-              int                   d2)
+              int                   d2,
+              unsigned short        *rng)
 {
   unsigned int k, n, maxD1, maxD2, base_d1, base_d2,
                da, db, *referenceBPs1, *referenceBPs2;
@@ -2932,7 +3419,7 @@ backtrack_qcM(vrna_fold_compound_t  *vc,
   qot     = qt = 0.;
 
   if (d1 == -1) {
-    r = vrna_urn() * Q_cM_rem;
+    r = sample_urn(rng) * Q_cM_rem;
     for (k = TURN + 2;
          k < n - 2 * TURN - 3;
          k++) {
@@ -2948,8 +3435,8 @@ backtrack_qcM(vrna_fold_compound_t  *vc,
                      * Q_M2[k + 1][cnt1][cnt2 / 2]
                      * pf_params->expMLclosing;
               if (qot > r) {
-                backtrack_qm(vc, pstruc, d1, d2, 1, k);
-                backtrack_qm2(vc, pstruc, cnt1, cnt2, k + 1);
+                backtrack_qm(vc, pstruc, d1, d2, 1, k, rng);
+                backtrack_qm2(vc, pstruc, cnt1, cnt2, k + 1, rng);
                 return;
               }
             }
@@ -2960,8 +3447,8 @@ backtrack_qcM(vrna_fold_compound_t  *vc,
                  * Q_M2_rem[k + 1]
                  * pf_params->expMLclosing;
           if (qot > r) {
-            backtrack_qm(vc, pstruc, d1, d2, 1, k);
-            backtrack_qm2(vc, pstruc, d1, d2, k + 1);
+            backtrack_qm(vc, pstruc, d1, d2, 1, k, rng);
+            backtrack_qm2(vc, pstruc, d1, d2, k + 1, rng);
             return;
           }
         }
@@ -2979,8 +3466,8 @@ backtrack_qcM(vrna_fold_compound_t  *vc,
                      * Q_M2_rem[k + 1]
                      * pf_params->expMLclosing;
               if (qot > r) {
-                backtrack_qm(vc, pstruc, cnt1, cnt2, 1, k);
-                backtrack_qm2(vc, pstruc, d1, d2, k + 1);
+                backtrack_qm(vc, pstruc, cnt1, cnt2, 1, k, rng);
+                backtrack_qm2(vc, pstruc, d1, d2, k + 1, rng);
                 return;
               }
             }
@@ -3008,14 +3495,13 @@ backtrack_qcM(vrna_fold_compound_t  *vc,
               for (cnt4 = l_min_Q_M2[k + 1][cnt3];
                    cnt4 <= l_max_Q_M2[k + 1][cnt3];
                    cnt4 += 2) {
-                if (((cnt1 + cnt3 + da) > maxD1)
-                    || ((cnt2 + cnt4 + db) > maxD2)) {
+                if (!IN_SCOPE(vc, cnt1 + cnt3 + da, cnt2 + cnt4 + db)) {
                   qot += Q_M[my_iindx[1] - k][cnt1][cnt2 / 2]
                          * Q_M2[k + 1][cnt3][cnt4 / 2]
                          * pf_params->expMLclosing;
                   if (qot > r) {
-                    backtrack_qm(vc, pstruc, cnt1, cnt2, 1, k);
-                    backtrack_qm2(vc, pstruc, cnt3, cnt4, k + 1);
+                    backtrack_qm(vc, pstruc, cnt1, cnt2, 1, k, rng);
+                    backtrack_qm2(vc, pstruc, cnt3, cnt4, k + 1, rng);
                     return;
                   }
                 }
@@ -3023,7 +3509,7 @@ backtrack_qcM(vrna_fold_compound_t  *vc,
       }
     }
   } else {
-    r = vrna_urn() * Q_cM[d1][d2 / 2];
+    r = sample_urn(rng) * Q_cM[d1][d2 / 2];
     for (k = TURN + 2;
          k < n - 2 * TURN - 3;
          k++) {
@@ -3053,8 +3539,8 @@ backtrack_qcM(vrna_fold_compound_t  *vc,
                          * Q_M2[k + 1][cnt3][cnt4 / 2]
                          * pf_params->expMLclosing;
                   if (qot > r) {
-                    backtrack_qm(vc, pstruc, cnt1, cnt2, 1, k);
-                    backtrack_qm2(vc, pstruc, cnt3, cnt4, k + 1);
+                    backtrack_qm(vc, pstruc, cnt1, cnt2, 1, k, rng);
+                    backtrack_qm2(vc, pstruc, cnt3, cnt4, k + 1, rng);
                     return;
                   }
                 }
@@ -3071,7 +3557,8 @@ backtrack_qm2(vrna_fold_compound_t  *vc,
               char                  *pstruc,
               int                   d1,
               int                   d2,
-              unsigned int          k)
+              unsigned int          k,
+              unsigned short        *rng)
 {
   unsigned int l, n, maxD1, maxD2, da, db,
                *referenceBPs1, *referenceBPs2;
@@ -3105,7 +3592,7 @@ backtrack_qm2(vrna_fold_compound_t  *vc,
   qot = qt = 0.;
 
   if (d1 == -1) {
-    r = vrna_urn() * Q_M2_rem[k];
+    r = sample_urn(rng) * Q_M2_rem[k];
     for (l = k + TURN + 1; l < n - TURN - 1; l++) {
       if (Q_M1_rem[jindx[l] + k]) {
         if (Q_M1[jindx[n] + l + 1]) {
@@ -3117,8 +3604,8 @@ backtrack_qm2(vrna_fold_compound_t  *vc,
                  cnt2 += 2) {
               qot += Q_M1_rem[jindx[l] + k] * Q_M1[jindx[n] + l + 1][cnt1][cnt2 / 2];
               if (qot > r) {
-                backtrack_qm1(vc, pstruc, d1, d2, k, l);
-                backtrack_qm1(vc, pstruc, cnt1, cnt2, l + 1, n);
+                backtrack_qm1(vc, pstruc, d1, d2, k, l, rng);
+                backtrack_qm1(vc, pstruc, cnt1, cnt2, l + 1, n, rng);
                 return;
               }
             }
@@ -3128,8 +3615,8 @@ backtrack_qm2(vrna_fold_compound_t  *vc,
           qot += Q_M1_rem[jindx[l] + k]
                  * Q_M1_rem[jindx[n] + l + 1];
           if (qot > r) {
-            backtrack_qm1(vc, pstruc, d1, d2, k, l);
-            backtrack_qm1(vc, pstruc, d1, d2, l + 1, n);
+            backtrack_qm1(vc, pstruc, d1, d2, k, l, rng);
+            backtrack_qm1(vc, pstruc, d1, d2, l + 1, n, rng);
             return;
           }
         }
@@ -3146,8 +3633,8 @@ backtrack_qm2(vrna_fold_compound_t  *vc,
               qot += Q_M1[jindx[l] + k][cnt1][cnt2 / 2]
                      * Q_M1_rem[jindx[n] + l + 1];
               if (qot > r) {
-                backtrack_qm1(vc, pstruc, cnt1, cnt2, k, l);
-                backtrack_qm1(vc, pstruc, d1, d2, l + 1, n);
+                backtrack_qm1(vc, pstruc, cnt1, cnt2, k, l, rng);
+                backtrack_qm1(vc, pstruc, d1, d2, l + 1, n, rng);
                 return;
               }
             }
@@ -3178,13 +3665,12 @@ backtrack_qm2(vrna_fold_compound_t  *vc,
             for (cnt4 = l_min_Q_M1[jindx[n] + l + 1][cnt3];
                  cnt4 <= l_max_Q_M1[jindx[n] + l + 1][cnt3];
                  cnt4 += 2) {
-              if (((cnt1 + cnt3 + da) > maxD1)
-                  || ((cnt2 + cnt4 + db) > maxD2)) {
+              if (!IN_SCOPE(vc, cnt1 + cnt3 + da, cnt2 + cnt4 + db)) {
                 qot += Q_M1[jindx[l] + k][cnt1][cnt2 / 2]
                        * Q_M1[jindx[n] + l + 1][cnt3][cnt4 / 2];
                 if (qot > r) {
-                  backtrack_qm1(vc, pstruc, cnt1, cnt2, k, l);
-                  backtrack_qm1(vc, pstruc, cnt3, cnt4, l + 1, n);
+                  backtrack_qm1(vc, pstruc, cnt1, cnt2, k, l, rng);
+                  backtrack_qm1(vc, pstruc, cnt3, cnt4, l + 1, n, rng);
                   return;
                 }
               }
@@ -3192,7 +3678,7 @@ backtrack_qm2(vrna_fold_compound_t  *vc,
         }
     }
   } else {
-    r = vrna_urn() * Q_M2[k][d1][d2 / 2];
+    r = sample_urn(rng) * Q_M2[k][d1][d2 / 2];
     for (l = k + TURN + 1; l < n - TURN - 1; l++) {
       if (!Q_M1[jindx[l] + k])
         continue;
@@ -3223,8 +3709,8 @@ backtrack_qm2(vrna_fold_compound_t  *vc,
                 qot += Q_M1[jindx[l] + k][cnt1][cnt2 / 2]
                        * Q_M1[jindx[n] + l + 1][cnt3][cnt4 / 2];
                 if (qot > r) {
-                  backtrack_qm1(vc, pstruc, cnt1, cnt2, k, l);
-                  backtrack_qm1(vc, pstruc, cnt3, cnt4, l + 1, n);
+                  backtrack_qm1(vc, pstruc, cnt1, cnt2, k, l, rng);
+                  backtrack_qm1(vc, pstruc, cnt3, cnt4, l + 1, n, rng);
                   return;
                 }
               }
@@ -3243,7 +3729,8 @@ backtrack(vrna_fold_compound_t  *vc,
           int                   d1,
           int                   d2,
           unsigned int          i,
-          unsigned int          j)
+          unsigned int          j,
+          unsigned short        *rng)
 {
   FLT_OR_DBL *scale;
   unsigned int maxD1, maxD2, base_d1, base_d2, da, db;
@@ -3313,7 +3800,7 @@ backtrack(vrna_fold_compound_t  *vc,
     l   = INF;
 
     if (d1 == -1) {
-      r = vrna_urn() * Q_B_rem[ij];
+      r = sample_urn(rng) * Q_B_rem[ij];
       if (r == 0.)
         vrna_message_error("backtrack@2Dpfold.c: backtracking failed\n");
 
@@ -3326,7 +3813,7 @@ backtrack(vrna_fold_compound_t  *vc,
       db  = base_d2 + referenceBPs2[ij];
 
       /* hairpin ? */
-      if ((da > maxD1) || (db > maxD2))
+      if (!IN_SCOPE(vc, da, db))
         if (!(((type == 3) || (type == 4)) && no_closingGU))
           qbt1 = exp_E_Hairpin(u, type, S1[i + 1], S1[j - 1], sequence + i - 1, pf_params) * scale[u + 2];
 
@@ -3366,7 +3853,7 @@ backtrack(vrna_fold_compound_t  *vc,
                 for (cnt2 = l_min_Q_B[my_iindx[k] - l][cnt1];
                      cnt2 <= l_max_Q_B[my_iindx[k] - l][cnt1];
                      cnt2 += 2)
-                  if (((cnt1 + da) > maxD1) || ((cnt2 + db) > maxD2)) {
+                  if (!IN_SCOPE(vc, cnt1 + da, cnt2 + db)) {
                     qbt1 += Q_B[my_iindx[k] - l][cnt1][cnt2 / 2] * tmp_en;
                     if (qbt1 > r)
                       goto backtrack_int_early_escape_rem;
@@ -3387,7 +3874,7 @@ backtrack_int_early_escape_rem:
     } else {
       if ((d1 >= k_min_Q_B[ij]) && (d1 <= k_max_Q_B[ij]))
         if ((d2 >= l_min_Q_B[ij][d1]) && (d2 <= l_max_Q_B[ij][d1]))
-          r = vrna_urn() * Q_B[ij][d1][d2 / 2];
+          r = sample_urn(rng) * Q_B[ij][d1][d2 / 2];
 
       if (r == 0.)
         vrna_message_error("backtrack@2Dpfold.c: backtracking failed\n");
@@ -3520,11 +4007,11 @@ backtrack_int_early_escape:
               for (cnt4 = l_min_Q_M1[jj + k][cnt3];
                    cnt4 <= l_max_Q_M1[jj + k][cnt3];
                    cnt4 += 2)
-                if (((cnt1 + cnt3 + da) > maxD1) || ((cnt2 + cnt4 + db) > maxD2))
+                if (!IN_SCOPE(vc, cnt1 + cnt3 + da, cnt2 + cnt4 + db))
                   qt += Q_M[ii - k + 1][cnt1][cnt2 / 2] * Q_M1[jj + k][cnt3][cnt4 / 2];
       }
       /* throw the dice */
-      r = vrna_urn() * qt;
+      r = sample_urn(rng) * qt;
       for (qt = 0., k = i + 1; k < j; k++) {
         cnt1 = cnt2 = cnt3 = cnt4 = -1;
         if (Q_M_rem[ii - k + 1] != 0.) {
@@ -3586,7 +4073,7 @@ backtrack_int_early_escape:
               for (cnt4 = l_min_Q_M1[jj + k][cnt3];
                    cnt4 <= l_max_Q_M1[jj + k][cnt3];
                    cnt4 += 2)
-                if (((cnt1 + cnt3 + da) > maxD1) || ((cnt2 + cnt4 + db) > maxD2)) {
+                if (!IN_SCOPE(vc, cnt1 + cnt3 + da, cnt2 + cnt4 + db)) {
                   qt += Q_M[ii - k + 1][cnt1][cnt2 / 2] * Q_M1[jj + k][cnt3][cnt4 / 2];
                   if (qt >= r)
                     goto backtrack_ml_early_escape;
@@ -3607,7 +4094,7 @@ backtrack_int_early_escape:
                   qt += Q_M[ii - k + 1][cnt1][cnt2 / 2] * Q_M1[jj + k][d1 - da - cnt1][(d2 - db - cnt2) / 2];
         }
       }
-      r = vrna_urn() * qt;
+      r = sample_urn(rng) * qt;
       for (qt = 0., k = i + 1; k < j; k++) {
         /* calculate introduced distance to reference structures */
         da  = base_d1 - referenceBPs1[my_iindx[i] - k + 1] - referenceBPs1[my_iindx[k] - j];
@@ -3634,10 +4121,10 @@ backtrack_int_early_escape:
 
 backtrack_ml_early_escape:
 
-    backtrack_qm1(vc, pstruc, cnt3, cnt4, k, j);
+    backtrack_qm1(vc, pstruc, cnt3, cnt4, k, j, rng);
 
     j = k - 1;
-    backtrack_qm(vc, pstruc, cnt1, cnt2, i, j);
+    backtrack_qm(vc, pstruc, cnt1, cnt2, i, j, rng);
   }
 }
 
@@ -3648,7 +4135,8 @@ backtrack_qm1(vrna_fold_compound_t  *vc,
               int                   d1,
               int                   d2,
               unsigned int          i,
-              unsigned int          j)
+              unsigned int          j,
+              unsigned short        *rng)
 {
   /* i is paired to l, i<l<j; backtrack in qm1 to find l */
   FLT_OR_DBL r, qt, *scale;
@@ -3700,11 +4188,11 @@ backtrack_qm1(vrna_fold_compound_t  *vc,
 
   /* find qm1 contribution */
   if (d1 == -1) {
-    r = vrna_urn() * Q_M1_rem[jindx[j] + i];
+    r = sample_urn(rng) * Q_M1_rem[jindx[j] + i];
   } else {
     if ((d1 >= k_min_Q_M1[jindx[j] + i]) && (d1 <= k_max_Q_M1[jindx[j] + i]))
       if ((d2 >= l_min_Q_M1[jindx[j] + i][d1]) && (d2 <= l_max_Q_M1[jindx[j] + i][d1]))
-        r = vrna_urn() * Q_M1[jindx[j] + i][d1][d2 / 2];
+        r = sample_urn(rng) * Q_M1[jindx[j] + i][d1][d2 / 2];
   }
 
   if (r == 0.)
@@ -3733,7 +4221,7 @@ backtrack_qm1(vrna_fold_compound_t  *vc,
             for (cnt2 = l_min_Q_B[ii - l][cnt1];
                  cnt2 <= l_max_Q_B[ii - l][cnt1];
                  cnt2 += 2)
-              if (((cnt1 + da) > maxD1) || ((cnt2 + db) > maxD2)) {
+              if (!IN_SCOPE(vc, cnt1 + da, cnt2 + db)) {
                 qt += Q_B[ii - l][cnt1][cnt2 / 2] * tmp;
                 if (qt >= r)
                   goto backtrack_qm1_early_escape;
@@ -3760,7 +4248,7 @@ backtrack_qm1(vrna_fold_compound_t  *vc,
 
 backtrack_qm1_early_escape:
 
-  backtrack(vc, pstruc, cnt1, cnt2, i, l);
+  backtrack(vc, pstruc, cnt1, cnt2, i, l, rng);
 }
 
 
@@ -3770,7 +4258,8 @@ backtrack_qm(vrna_fold_compound_t *vc,
              int                  d1,
              int                  d2,
              unsigned int         i,
-             unsigned int         j)
+             unsigned int         j,
+             unsigned short       *rng)
 {
   /* divide multiloop into qm and qm1  */
   FLT_OR_DBL r, *scale;
@@ -3820,12 +4309,12 @@ backtrack_qm(vrna_fold_compound_t *vc,
 
     /* find qm contribution */
     if (d1 == -1) {
-      r = vrna_urn() * Q_M_rem[my_iindx[i] - j];
+      r = sample_urn(rng) * Q_M_rem[my_iindx[i] - j];
     } else {
       if (Q_M[my_iindx[i] - j])
         if ((d1 >= k_min_Q_M[my_iindx[i] - j]) && (d1 <= k_max_Q_M[my_iindx[i] - j]))
           if ((d2 >= l_min_Q_M[my_iindx[i] - j][d1]) && (d2 <= l_max_Q_M[my_iindx[i] - j][d1]))
-            r = vrna_urn() * Q_M[my_iindx[i] - j][d1][d2 / 2];
+            r = sample_urn(rng) * Q_M[my_iindx[i] - j][d1][d2 / 2];
     }
 
     if (r == 0.)
@@ -3836,7 +4325,7 @@ backtrack_qm(vrna_fold_compound_t *vc,
       if (Q_M1_rem[jindx[j] + i] != 0.) {
         qmt += Q_M1_rem[jindx[j] + i];
         if (qmt >= r) {
-          backtrack_qm1(vc, pstruc, d1, d2, i, j);
+          backtrack_qm1(vc, pstruc, d1, d2, i, j, rng);
           return;
         }
       }
@@ -3846,7 +4335,7 @@ backtrack_qm(vrna_fold_compound_t *vc,
         if (Q_M1_rem[jindx[j] + k] != 0.) {
           qmt += Q_M1_rem[jindx[j] + k] * tmp;
           if (qmt >= r) {
-            backtrack_qm1(vc, pstruc, d1, d2, k, j);
+            backtrack_qm1(vc, pstruc, d1, d2, k, j, rng);
             return;
           }
         }
@@ -3860,10 +4349,10 @@ backtrack_qm(vrna_fold_compound_t *vc,
             for (cnt2 = l_min_Q_M1[jindx[j] + k][cnt1];
                  cnt2 <= l_max_Q_M1[jindx[j] + k][cnt1];
                  cnt2 += 2)
-              if (((cnt1 + da2) > maxD1) || ((cnt2 + db2) > maxD2)) {
+              if (!IN_SCOPE(vc, cnt1 + da2, cnt2 + db2)) {
                 qmt += Q_M1[jindx[j] + k][cnt1][cnt2 / 2] * tmp;
                 if (qmt >= r) {
-                  backtrack_qm1(vc, pstruc, cnt1, cnt2, k, j);
+                  backtrack_qm1(vc, pstruc, cnt1, cnt2, k, j, rng);
                   return;
                 }
               }
@@ -3928,7 +4417,7 @@ backtrack_qm(vrna_fold_compound_t *vc,
               for (cnt4 = l_min_Q_M1[jindx[j] + k][cnt3];
                    cnt4 <= l_max_Q_M1[jindx[j] + k][cnt3];
                    cnt4 += 2)
-                if (((cnt1 + cnt3 + da) > maxD1) || ((cnt2 + cnt4 + db) > maxD2)) {
+                if (!IN_SCOPE(vc, cnt1 + cnt3 + da, cnt2 + cnt4 + db)) {
                   qmt += Q_M[my_iindx[i] - k + 1][cnt1][cnt2 / 2] * Q_M1[jindx[j] + k][cnt3][cnt4 / 2];
                   if (qmt >= r)
                     goto backtrack_qm_early_escape;
@@ -3962,7 +4451,7 @@ backtrack_qm(vrna_fold_compound_t *vc,
                 cnt4  = d2 - db2;
                 qmt   += Q_M1[jindx[j] + k][cnt3][cnt4 / 2] * tmp;
                 if (qmt >= r) {
-                  backtrack_qm1(vc, pstruc, cnt3, cnt4, k, j);
+                  backtrack_qm1(vc, pstruc, cnt3, cnt4, k, j, rng);
                   return;
                 }
               }
@@ -3985,7 +4474,7 @@ backtrack_qm(vrna_fold_compound_t *vc,
           }
         }
       } else {
-        backtrack_qm1(vc, pstruc, d1, d2, k, j);
+        backtrack_qm1(vc, pstruc, d1, d2, k, j, rng);
         return;
       }
     }
@@ -3995,7 +4484,7 @@ backtrack_qm(vrna_fold_compound_t *vc,
 
 backtrack_qm_early_escape:
 
-    backtrack_qm1(vc, pstruc, cnt3, cnt4, k, j);
+    backtrack_qm1(vc, pstruc, cnt3, cnt4, k, j, rng);
 
     if (k < i + TURN)
       break;            /* no more pairs */
@@ -4007,7 +4496,7 @@ backtrack_qm_early_escape:
     if (d1 == referenceBPs1[my_iindx[i] - k + 1] && d2 == referenceBPs2[my_iindx[i] - k + 1]) {
       /* is interval [i,k] totally unpaired? */
       FLT_OR_DBL tmp = pow(pf_params->expMLbase, k - i) * scale[k - i];
-      r = vrna_urn() * (Q_M[my_iindx[i] - k + 1][d1][d2 / 2] + tmp);
+      r = sample_urn(rng) * (Q_M[my_iindx[i] - k + 1][d1][d2 / 2] + tmp);
       if (tmp >= r)
         return;            /* no more pairs */
     }
@@ -4028,34 +4517,63 @@ adjustArrayBoundaries(FLT_OR_DBL  ***array,
                       int         *l_min_post,
                       int         *l_max_post)
 {
-  int cnt1;
-  int k_diff_pre  = k_min_post - *k_min;
-  int mem_size    = k_max_post - k_min_post + 1;
+  int         cnt1, shift;
+  int         k_diff_pre  = k_min_post - *k_min;
+  int         mem_size    = k_max_post - k_min_post + 1;
+  size_t      src, dst, row_size;
+  char        *block, *tmp;
+  FLT_OR_DBL  *row;
 
   if (k_min_post < INF) {
-    /* free all the unused memory behind actual data */
-    for (cnt1 = k_max_post + 1; cnt1 <= *k_max; cnt1++) {
-      (*array)[cnt1] += (*l_min)[cnt1] / 2;
-      free((*array)[cnt1]);
+    /*
+     *  compact the actual data within the block allocated by prepareArray().
+     *  Rows are moved towards the front in order of increasing k, so each
+     *  row only overwrites data that has been moved already. The offsets of
+     *  the source rows follow from the previous boundaries, since the row
+     *  pointers themselves may be overwritten in the course
+     */
+    block = (char *)((*array) + *k_min);
+    src   = ROW_POINTERS_SIZE(*k_max - *k_min + 1, FLT_OR_DBL);
+    dst   = ROW_POINTERS_SIZE(mem_size, FLT_OR_DBL);
+
+    for (cnt1 = *k_min; cnt1 <= *k_max; cnt1++) {
+      if ((cnt1 >= k_min_post) && (cnt1 <= k_max_post) && (l_min_post[cnt1] < INF)) {
+        row_size  = (l_max_post[cnt1] - l_min_post[cnt1] + 1) / 2 + 1;
+        shift     = (l_min_post[cnt1] % 2 == (*l_min)[cnt1] % 2) ? 0 : 1;
+        memmove(block + dst,
+                block + src + sizeof(FLT_OR_DBL) * ((l_min_post[cnt1] - (*l_min)[cnt1]) / 2 + shift),
+                sizeof(FLT_OR_DBL) * row_size);
+        dst += sizeof(FLT_OR_DBL) * row_size;
+      }
+
+      src += sizeof(FLT_OR_DBL) * (((*l_max)[cnt1] - (*l_min)[cnt1] + 1) / 2 + 1);
     }
 
-    /* free unused memory before actual data */
-    for (cnt1 = *k_min; cnt1 < k_min_post; cnt1++) {
-      (*array)[cnt1] += (*l_min)[cnt1] / 2;
-      free((*array)[cnt1]);
+    /* release the unused tail of the block */
+    tmp = (char *)realloc(block, dst);
+    if (tmp)
+      block = tmp;
+
+    /* (re-)set the row pointers */
+    *array  = (FLT_OR_DBL **)block - k_min_post;
+    row     = (FLT_OR_DBL *)(block + ROW_POINTERS_SIZE(mem_size, FLT_OR_DBL));
+
+    for (cnt1 = k_min_post; cnt1 <= k_max_post; cnt1++) {
+      if (l_min_post[cnt1] < INF) {
+        (*array)[cnt1]  = row - l_min_post[cnt1] / 2;
+        row             += (l_max_post[cnt1] - l_min_post[cnt1] + 1) / 2 + 1;
+      } else {
+        (*array)[cnt1] = NULL;
+      }
     }
-    /* move data to front and thereby eliminating unused memory in front of actual data */
+
+    /* move boundaries to front and thereby eliminating unused memory in front of actual data */
     if (k_diff_pre > 0) {
-      memmove((FLT_OR_DBL **)(*array), ((FLT_OR_DBL **)(*array)) + k_diff_pre, sizeof(FLT_OR_DBL *) * mem_size);
       memmove((int *)(*l_min), ((int *)(*l_min)) + k_diff_pre, sizeof(int) * mem_size);
       memmove((int *)(*l_max), ((int *)(*l_max)) + k_diff_pre, sizeof(int) * mem_size);
     }
 
     /* reallocating memory to actual size used */
-    *array  += *k_min;
-    *array  = (FLT_OR_DBL **)realloc(*array, sizeof(FLT_OR_DBL *) * mem_size);
-    *array  -= k_min_post;
-
     *l_min  += *k_min;
     *l_min  = (int *)realloc(*l_min, sizeof(int) * mem_size);
     *l_min  -= k_min_post;
@@ -4064,38 +4582,12 @@ adjustArrayBoundaries(FLT_OR_DBL  ***array,
     *l_max  = (int *)realloc(*l_max, sizeof(int) * mem_size);
     *l_max  -= k_min_post;
 
-
     for (cnt1 = k_min_post; cnt1 <= k_max_post; cnt1++) {
-      if (l_min_post[cnt1] < INF) {
-        /* new memsize */
-        mem_size = (l_max_post[cnt1] - l_min_post[cnt1] + 1) / 2 + 1;
-        /* reshift the pointer */
-        (*array)[cnt1] += (*l_min)[cnt1] / 2;
-
-        int shift = (l_min_post[cnt1] % 2 == (*l_min)[cnt1] % 2) ? 0 : 1;
-        /* eliminate unused memory in front of actual data */
-        unsigned int start = (l_min_post[cnt1] - (*l_min)[cnt1]) / 2 + shift;
-        if (start > 0)
-          memmove((FLT_OR_DBL *)((*array)[cnt1]), (FLT_OR_DBL *)((*array)[cnt1]) + start, sizeof(FLT_OR_DBL) * mem_size);
-
-        (*array)[cnt1] = (FLT_OR_DBL *)realloc((*array)[cnt1], sizeof(FLT_OR_DBL) * mem_size);
-
-        (*array)[cnt1] -= l_min_post[cnt1] / 2;
-      } else {
-        /* free according memory */
-        (*array)[cnt1] += (*l_min)[cnt1] / 2;
-        free((*array)[cnt1]);
-      }
-
       (*l_min)[cnt1]  = l_min_post[cnt1];
       (*l_max)[cnt1]  = l_max_post[cnt1];
     }
   } else {
     /* we have to free all unused memory */
-    for (cnt1 = *k_min; cnt1 <= *k_max; cnt1++) {
-      (*array)[cnt1] += (*l_min)[cnt1] / 2;
-      free((*array)[cnt1]);
-    }
     (*l_min)  += *k_min;
     (*l_max)  += *k_min;
     free(*l_min);
@@ -4157,17 +4649,18 @@ updatePosteriorBoundaries(int d1,
 
 
 PRIVATE INLINE void
-prepareBoundaries(int min_k_pre,
-                  int max_k_pre,
-                  int min_l_pre,
-                  int max_l_pre,
-                  int bpdist,
-                  int *min_k,
-                  int *max_k,
-                  int **min_l,
-                  int **max_l)
+prepareBoundaries(vrna_fold_compound_t  *vc,
+                  int                   min_k_pre,
+                  int                   max_k_pre,
+                  int                   min_l_pre,
+                  int                   max_l_pre,
+                  int                   bpdist,
+                  int                   *min_k,
+                  int                   *max_k,
+                  int                   **min_l,
+                  int                   **max_l)
 {
-  int cnt;
+  int cnt, l_lim;
   int mem = max_k_pre - min_k_pre + 1;
 
   *min_k  = min_k_pre;
@@ -4186,10 +4679,27 @@ prepareBoundaries(int min_k_pre,
       (*min_l)[cnt]++;
     if ((bpdist % 2) != (((*min_l)[cnt] + cnt) % 2))
       (*min_l)[cnt]++;
+
+    /* no need to reserve memory for classes out of scope */
+    if ((unsigned int)cnt > vc->maxD1)
+      l_lim = (*min_l)[cnt];
+    else if (vc->band_l_max)
+      l_lim = MIN2((int)vc->maxD2, vc->band_l_max[cnt]);
+    else
+      l_lim = (int)vc->maxD2;
+
+    if ((*max_l)[cnt] > l_lim)
+      (*max_l)[cnt] = MAX2(l_lim, (*min_l)[cnt]);
   }
 }
 
 
+/*
+ *  Allocate a (k,l) matrix as a single memory block. The block starts with
+ *  the (offset) row pointers for each k, followed by the rows themselves.
+ *  Hence, the entire matrix can be released with a single free() of
+ *  (*array) + min_k, and adjustArrayBoundaries() can shrink it in place.
+ */
 PRIVATE INLINE void
 prepareArray(FLT_OR_DBL ***array,
              int        min_k,
@@ -4197,15 +4707,23 @@ prepareArray(FLT_OR_DBL ***array,
              int        *min_l,
              int        *max_l)
 {
-  int i, mem;
+  int         i, mem;
+  size_t      mem_total;
+  FLT_OR_DBL  *row;
+
+  mem_total = 0;
+  for (i = min_k; i <= max_k; i++)
+    mem_total += (max_l[i] - min_l[i] + 1) / 2 + 1;
 
-  *array  = (FLT_OR_DBL **)vrna_alloc(sizeof(FLT_OR_DBL *) * (max_k - min_k + 1));
+  *array  = (FLT_OR_DBL **)vrna_alloc(ROW_POINTERS_SIZE(max_k - min_k + 1, FLT_OR_DBL) +
+                                      sizeof(FLT_OR_DBL) * mem_total);
+  row     = (FLT_OR_DBL *)((char *)(*array) + ROW_POINTERS_SIZE(max_k - min_k + 1, FLT_OR_DBL));
   *array  -= min_k;
 
   for (i = min_k; i <= max_k; i++) {
     mem         = (max_l[i] - min_l[i] + 1) / 2 + 1;
-    (*array)[i] = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * mem);
-    (*array)[i] -= min_l[i] / 2;
+    (*array)[i] = row - min_l[i] / 2;
+    row         += mem;
   }
 }
 
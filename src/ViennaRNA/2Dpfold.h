@@ -69,7 +69,8 @@ typedef struct vrna_sol_TwoD_pf_t {
  * @param vc            The datastructure containing all necessary folding attributes and matrices
  * @param maxDistance1  The maximum basepair distance to reference1 (may be -1)
  * @param maxDistance2  The maximum basepair distance to reference2 (may be -1)
- * @returns             A list of partition funtions for the corresponding distance classes
+ * @returns             A list of partition funtions for the corresponding distance classes,
+ *                      or NULL if they would exceed the memory budget (see vrna_mx_memory_budget_set())
  */
 vrna_sol_TwoD_pf_t *
 vrna_pf_TwoD(vrna_fold_compound_t *vc,
@@ -134,6 +135,33 @@ vrna_pbacktrack5_TwoD(vrna_fold_compound_t  *vc,
                       unsigned int          length);
 
 
+/**
+ *  @brief Sample multiple secondary structure representatives from a distance class in parallel
+ *
+ *  This function draws @p num samples from the same distance class as vrna_pbacktrack_TwoD()
+ *  would do, but distributes them over vrna_TwoD_get_num_threads() threads. Each sample uses
+ *  its own random number stream, seeded from the global random number generator (see vrna_urn())
+ *  before sampling starts. Hence, the result only depends on the state of the global generator,
+ *  but not on the number of threads.
+ *
+ *  @pre      The argument 'vars' must contain precalculated partition function matrices,
+ *            i.e. a call to vrna_pf_TwoD() preceding this function is mandatory!
+ *
+ *  @see      vrna_pbacktrack_TwoD(), vrna_pf_TwoD(), vrna_TwoD_set_num_threads()
+ *
+ *  @param[inout]  vc The #vrna_fold_compound_t datastructure containing all necessary folding attributes and matrices
+ *  @param[in]  d1    The distance to reference1 (may be -1)
+ *  @param[in]  d2    The distance to reference2
+ *  @param[in]  num   The number of samples
+ *  @returns    A NULL-terminated list of @p num sampled secondary structures in dot-bracket notation
+ */
+char **
+vrna_pbacktrack_TwoD_num(vrna_fold_compound_t *vc,
+                         int                  d1,
+                         int                  d2,
+                         unsigned int         num);
+
+
 /**
  *  @}
  */ /* End of group kl_neighborhood_stochbt */
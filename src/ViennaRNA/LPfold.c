@@ -30,6 +30,7 @@
 #include "ViennaRNA/Lfold.h"
 #include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/part_func_window.h"
+#include "ViennaRNA/utils/timing_hooks.h"
 
 /*
  #################################
@@ -559,6 +560,25 @@ init_dp_matrices(vrna_fold_compound_t *vc,
 
   for (j = 1; j <= max_j; j++)
     allocate_dp_matrices(vc, j, options);
+
+#ifdef VRNA_WITH_TIMING
+  if (vc->timing) {
+    /* rows are re-allocated while the window slides, so this is what resides in memory */
+    size_t rows = (size_t)max_j * (size_t)(winSize + 1) * sizeof(FLT_OR_DBL);
+
+    VRNA_TIMING_MX(vc, "pR", rows);
+    VRNA_TIMING_MX(vc, "q_local", rows);
+    VRNA_TIMING_MX(vc, "qb_local", rows);
+    VRNA_TIMING_MX(vc, "qm_local", rows);
+    if (options & VRNA_PROBS_WINDOW_UP) {
+      VRNA_TIMING_MX(vc, "qm2_local", rows);
+      VRNA_TIMING_MX(vc, "QI5", rows);
+      VRNA_TIMING_MX(vc, "qmb", rows);
+      VRNA_TIMING_MX(vc, "q2l", rows);
+    }
+  }
+
+#endif
 }
 
 
@@ -757,6 +777,9 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
   /* start recursions */
   for (j = turn + 2; j <= n + winSize; j++) {
     if (j <= n) {
+      VRNA_TIMING_START(vc, VRNA_TIMING_PF_FILL);
+      VRNA_TIMING_CELLS(vc, VRNA_TIMING_PF_FILL, MAX2(0, j - turn - MAX2(1, j - winSize + 1)));
+
       vrna_exp_E_ext_fast_update(vc, j, aux_mx_el);
       for (i = j - turn - 1; i >= MAX2(1, (j - winSize + 1)); i--) {
         hc_decompose  = hc->matrix_local[i][j - i];
@@ -807,6 +830,7 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
                                i,
                                j);
 
+          VRNA_TIMING_STOP(vc, VRNA_TIMING_PF_FILL);
           vrna_exp_E_ml_fast_free(aux_mx_ml);
           vrna_exp_E_ext_fast_free(aux_mx_el);
           free_helper_arrays(vc, ulength, &aux_arrays, options);
@@ -847,9 +871,13 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
       /* rotate auxiliary arrays */
       vrna_exp_E_ext_fast_rotate(aux_mx_el);
       vrna_exp_E_ml_fast_rotate(aux_mx_ml);
+
+      VRNA_TIMING_STOP(vc, VRNA_TIMING_PF_FILL);
     }
 
     if (j > winSize) {
+      VRNA_TIMING_START(vc, VRNA_TIMING_PF_OUTSIDE);
+
       compute_probs(vc, j, &aux_arrays, ulength, cb, data, options, &ov);
 
       if ((options & VRNA_PROBS_WINDOW_UP) && (j > winSize + MAXLOOP + 1))
@@ -886,9 +914,13 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
         rotate_dp_matrices(vc, j, options);
         rotate_constraints(vc, j, options);
       }
+
+      VRNA_TIMING_STOP(vc, VRNA_TIMING_PF_OUTSIDE);
     } /* end if (do_backtrack) */
   }   /* end for j */
 
+  VRNA_TIMING_START(vc, VRNA_TIMING_PF_OUTSIDE);
+
   /* finish output */
   if (options & VRNA_PROBS_WINDOW_UP)
     for (j = MAX2(1, n - MAXLOOP); j <= n; j++)
@@ -922,6 +954,8 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
     }
   }
 
+  VRNA_TIMING_STOP(vc, VRNA_TIMING_PF_OUTSIDE);
+
   if (ov > 0)
     vrna_message_warning("vrna_probs_window: "
                          "%d overflows occurred while backtracking;\n"
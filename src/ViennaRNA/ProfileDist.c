@@ -21,6 +21,13 @@
 
 PRIVATE int *alignment[2];
 
+#ifdef _OPENMP
+/* NOTE: all variables are assumed to be uninitialized if they are declared as threadprivate */
+#pragma omp threadprivate(alignment)
+#endif
+
+#include "dist_matrix.inc"
+
 PRIVATE void
 sprint_aligned_bppm(const float *T1,
                     const float *T2);
@@ -169,6 +176,100 @@ profile_edit_distance(const float *T1,
 }
 
 
+/*---------------------------------------------------------------------------*/
+
+/*
+ *  per-thread scratch memory for profile_edit_distance_matrix(), only two
+ *  rows of the distance table are kept since no backtracking is done
+ */
+typedef struct {
+  float *rows[2];
+  int   length;
+} profile_scratch;
+
+
+PRIVATE void *
+profile_scratch_get(void *data)
+{
+  return vrna_alloc(sizeof(profile_scratch));
+}
+
+
+PRIVATE void
+profile_scratch_free(void *scratch)
+{
+  profile_scratch *s = (profile_scratch *)scratch;
+
+  free(s->rows[0]);
+  free(s->rows[1]);
+  free(s);
+}
+
+
+PRIVATE float
+profile_pair_dist(void  *data,
+                  void  *scratch,
+                  int   i,
+                  int   j)
+{
+  int             k, l, length1, length2;
+  float           *prev, *cur, *tmp, minus, plus, change;
+  const float     *T1, *T2, **profiles = (const float **)data;
+  profile_scratch *s = (profile_scratch *)scratch;
+
+  /* same argument order as the lower triangle matrix of RNApdist */
+  T1      = profiles[j];
+  T2      = profiles[i];
+  length1 = (int)T1[0];
+  length2 = (int)T2[0];
+
+  if (length2 + 1 > s->length) {
+    s->rows[0]  = (float *)vrna_realloc(s->rows[0], sizeof(float) * (length2 + 1));
+    s->rows[1]  = (float *)vrna_realloc(s->rows[1], sizeof(float) * (length2 + 1));
+    s->length   = length2 + 1;
+  }
+
+  prev    = s->rows[0];
+  cur     = s->rows[1];
+  prev[0] = 0.;
+
+  for (l = 1; l <= length2; l++)
+    prev[l] = prev[l - 1] + PrfEditCost(0, l, T1, T2);
+
+  for (k = 1; k <= length1; k++) {
+    cur[0] = prev[0] + PrfEditCost(k, 0, T1, T2);
+    for (l = 1; l <= length2; l++) {
+      minus   = prev[l] + PrfEditCost(k, 0, T1, T2);
+      plus    = cur[l - 1] + PrfEditCost(0, l, T1, T2);
+      change  = prev[l - 1] + PrfEditCost(k, l, T1, T2);
+      cur[l]  = MIN3(minus, plus, change);
+    }
+    tmp   = prev;
+    prev  = cur;
+    cur   = tmp;
+  }
+
+  return prev[length2];
+}
+
+
+PUBLIC float *
+profile_edit_distance_matrix(float  **profiles,
+                             int    n,
+                             int    num_threads)
+{
+  if ((!profiles) || (n < 0))
+    return NULL;
+
+  return distance_matrix_tiled(n,
+                               num_threads,
+                               (void *)profiles,
+                               &profile_scratch_get,
+                               &profile_pair_dist,
+                               &profile_scratch_free);
+}
+
+
 /*---------------------------------------------------------------------------*/
 
 PRIVATE double
@@ -24,9 +24,11 @@
 #include "ViennaRNA/constraints/soft.h"
 #include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/boltzmann_sampling.h"
+#include "ViennaRNA/utils/timing_hooks.h"
 
 
 #include "ViennaRNA/data_structures_nonred.inc"
+#include "ViennaRNA/sequence_weights.inc"
 
 /*
  #################################
@@ -209,24 +211,27 @@ vrna_pbacktrack(vrna_fold_compound_t *vc)
       return NULL;
     }
 
+    VRNA_TIMING_START(vc, VRNA_TIMING_SAMPLING);
+
     switch (vc->type) {
       case VRNA_FC_TYPE_SINGLE:
         if (vc->exp_params->model_details.circ)
-          return wrap_pbacktrack_circ(vc);
+          structure = wrap_pbacktrack_circ(vc);
         else
-          return vrna_pbacktrack5(vc, vc->length);
+          structure = vrna_pbacktrack5(vc, vc->length);
 
         break;
 
       case VRNA_FC_TYPE_COMPARATIVE:
-        return pbacktrack_comparative(vc, &prob);
+        structure = pbacktrack_comparative(vc, &prob);
         break;
 
       default:
         vrna_message_warning("unrecognized fold compound type");
-        return structure;
         break;
     }
+
+    VRNA_TIMING_STOP(vc, VRNA_TIMING_SAMPLING);
   }
 
   return structure;
@@ -238,7 +243,15 @@ PUBLIC char *
 vrna_pbacktrack5(vrna_fold_compound_t *vc,
                  int                  length)
 {
-  return pbacktrack5_gen(vc, length, NULL, NULL, NULL);
+  char *structure;
+
+  VRNA_TIMING_START(vc, VRNA_TIMING_SAMPLING);
+
+  structure = pbacktrack5_gen(vc, length, NULL, NULL, NULL);
+
+  VRNA_TIMING_STOP(vc, VRNA_TIMING_SAMPLING);
+
+  return structure;
 }
 
 
@@ -287,6 +300,8 @@ vrna_pbacktrack_nr_cb(vrna_fold_compound_t              *vc,
       NR_NODE           *root_node;
       struct nr_memory  *memory_dat;
 
+      VRNA_TIMING_START(vc, VRNA_TIMING_SAMPLING);
+
       memory_dat  = NULL;
       block_size  = 5000 * sizeof(NR_NODE);
       q_remain    = 0;
@@ -347,6 +362,8 @@ vrna_pbacktrack_nr_cb(vrna_fold_compound_t              *vc,
 #else
       free_all_nrll(&memory_dat);
 #endif
+
+      VRNA_TIMING_STOP(vc, VRNA_TIMING_SAMPLING);
     }
   }
 }
@@ -1861,6 +1878,7 @@ pbacktrack_comparative(vrna_fold_compound_t *vc,
   char              *pstruc = NULL;
 
   int               n_seq       = vc->n_seq;
+  unsigned int      *w          = vc->seq_weights;
   int               n           = vc->length;
   short             **S         = vc->S;
   short             **S5        = vc->S5;     /*S5[s][i] holds next base 5' of i in sequence s*/
@@ -1936,10 +1954,10 @@ pbacktrack_comparative(vrna_fold_compound_t *vc,
         for (s = 0; s < n_seq; s++) {
           xtype = vrna_get_ptype_md(S[s][i], S[s][j], md);
           qkl   *=
-            exp_E_ExtLoop(xtype,
-                          (a2s[s][i] > 1) ? S5[s][i] : -1,
-                          (a2s[s][j] < a2s[s][S[0][0]]) ? S3[s][j] : -1,
-                          pf_params);
+            exp_weighted(exp_E_ExtLoop(xtype,
+                                       (a2s[s][i] > 1) ? S5[s][i] : -1,
+                                       (a2s[s][j] < a2s[s][S[0][0]]) ? S3[s][j] : -1,
+                                       pf_params), w[s]);
         }
         qt += qkl;                                                  /*?*exp(pscore[jindx[j]+i]/kTn)*/
         if (qt > r) {
@@ -1967,6 +1985,7 @@ backtrack_comparative(vrna_fold_compound_t  *vc,
                       double                *prob)
 {
   int               n_seq       = vc->n_seq;
+  unsigned int      *w          = vc->seq_weights;
   short             **S         = vc->S;
   short             **S5        = vc->S5;     /*S5[s][i] holds next base 5' of i in sequence s*/
   short             **S3        = vc->S3;     /*Sl[s][i] holds next base 3' of i in sequence s*/
@@ -2013,7 +2032,7 @@ backtrack_comparative(vrna_fold_compound_t  *vc,
       if (u < 9)
         strncpy(loopseq, Ss[s] + a2s[s][i] - 1, 9);
 
-      qbt1 *= exp_E_Hairpin(u, type[s], S3[s][i], S5[s][j], loopseq, pf_params);
+      qbt1 *= exp_weighted(exp_E_Hairpin(u, type[s], S3[s][i], S5[s][j], loopseq, pf_params), w[s]);
     }
     qbt1 *= scale[j - i + 1];
 
@@ -2040,15 +2059,15 @@ backtrack_comparative(vrna_fold_compound_t  *vc,
           u1      = a2s[s][k - 1] - a2s[s][i] /*??*/;
           u2      = a2s[s][j - 1] - a2s[s][l];
           type_2  = vrna_get_ptype_md(S[s][l], S[s][k], md);
-          qloop   *= exp_E_IntLoop(u1,
-                                   u2,
-                                   type[s],
-                                   type_2,
-                                   S3[s][i],
-                                   S5[s][j],
-                                   S5[s][k],
-                                   S3[s][l],
-                                   pf_params);
+          qloop   *= exp_weighted(exp_E_IntLoop(u1,
+                                                u2,
+                                                type[s],
+                                                type_2,
+                                                S3[s][i],
+                                                S5[s][j],
+                                                S5[s][k],
+                                                S3[s][l],
+                                                pf_params), w[s]);
         }
 
         if (sc) {
@@ -2182,6 +2201,7 @@ backtrack_qm1_comparative(vrna_fold_compound_t  *vc,
                           double                *prob)
 {
   int               n_seq       = vc->n_seq;
+  unsigned int      *w          = vc->seq_weights;
   short             **S         = vc->S;
   short             **S5        = vc->S5;     /*S5[s][i] holds next base 5' of i in sequence s*/
   short             **S3        = vc->S3;     /*Sl[s][i] holds next base 3' of i in sequence s*/
@@ -2207,7 +2227,7 @@ backtrack_qm1_comparative(vrna_fold_compound_t  *vc,
     tempz = 1.;
     for (s = 0; s < n_seq; s++) {
       xtype = vrna_get_ptype_md(S[s][i], S[s][l], md);
-      tempz *= exp_E_MLstem(xtype, S5[s][i], S3[s][l], pf_params);
+      tempz *= exp_weighted(exp_E_MLstem(xtype, S5[s][i], S3[s][l], pf_params), w[s]);
     }
     qt += qb[ii - l] * tempz * expMLbase[j - l];
     if (qt >= r) {
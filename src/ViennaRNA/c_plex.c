@@ -50,6 +50,17 @@
 #include "ViennaRNA/ali_plex.h"
 #include "ViennaRNA/loops/all.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* thread-local storage for builds that use POSIX threads but not OpenMP */
+#if !defined(_OPENMP) && VRNA_WITH_PTHREADS && defined(__GNUC__)
+# define C_PLEX_THREAD_LOCAL __thread
+#else
+# define C_PLEX_THREAD_LOCAL
+#endif
+
 /* int subopt_sorted=0; */
 
 #define PUBLIC
@@ -179,11 +190,11 @@ duplexfold_CXS(const char *s1,
 #define MIN2(A, B)      ((A) < (B) ? (A) : (B))
 #define MAX2(A, B)      ((A) > (B) ? (A) : (B))
 
-PRIVATE vrna_param_t  *P  = NULL;
-PRIVATE int           **c = NULL;/*, **in, **bx, **by;*/      /* energy array used in duplexfold */
+PRIVATE C_PLEX_THREAD_LOCAL vrna_param_t  *P  = NULL;
+PRIVATE C_PLEX_THREAD_LOCAL int           **c = NULL;/*, **in, **bx, **by;*/      /* energy array used in duplexfold */
 /* PRIVATE int ****c_XS; */
-PRIVATE int           **lc = NULL, **lin = NULL, **lbx = NULL, **lby = NULL, **linx = NULL,
-                      **liny = NULL;                                                                /* energy array used in Lduplexfold
+PRIVATE C_PLEX_THREAD_LOCAL int           **lc = NULL, **lin = NULL, **lbx = NULL, **lby = NULL,
+                                          **linx = NULL, **liny = NULL;                             /* energy array used in Lduplexfold
                                                                                                      * this arrays contains only 3 columns
                                                                                                      * In this way I reduce my memory use and
                                                                                                      * I can make most of my computation and
@@ -197,10 +208,19 @@ PRIVATE int           **lc = NULL, **lin = NULL, **lbx = NULL, **lby = NULL, **l
  *                                          which extends till the last nucleotide of
  *                                          the long sequence*/
 
-PRIVATE short *S1 = NULL, *SS1 = NULL, *S2 = NULL, *SS2 = NULL; /*contains the sequences*/
-PRIVATE int   n1, n2;                                           /* sequence lengths */
-PRIVATE int   n3, n4; /*sequence length for the duplex*/;
-PRIVATE int   delay_free = 0;
+PRIVATE C_PLEX_THREAD_LOCAL short *S1 = NULL, *SS1 = NULL, *S2 = NULL, *SS2 = NULL; /*contains the sequences*/
+PRIVATE C_PLEX_THREAD_LOCAL int   n1, n2;                                           /* sequence lengths */
+PRIVATE C_PLEX_THREAD_LOCAL int   n3, n4; /*sequence length for the duplex*/;
+PRIVATE C_PLEX_THREAD_LOCAL int   delay_free = 0;
+
+#ifdef _OPENMP
+
+/* NOTE: all variables are assumed to be uninitialized if they are declared as threadprivate
+ */
+#pragma omp threadprivate(P, c, lc, lin, lbx, lby, linx, liny, \
+  S1, SS1, S2, SS2, n1, n2, n3, n4, delay_free)
+
+#endif
 
 
 /*-----------------------------------------------------------------------duplexfold_XS---------------------------------------------------------------------------*/
@@ -262,7 +282,7 @@ duplexfold_CXS(const char *s1,
   j     = 2;
   type  = pair[S1[i]][S2[j]];
   if (!type) {
-    printf("Error during initialization of the duplex in duplexfold_XS\n");
+    plex_output_printf("Error during initialization of the duplex in duplexfold_XS\n");
     mfe.structure = NULL;
     mfe.energy    = INF;
     return mfe;
@@ -866,10 +886,10 @@ find_max_CXS(const int  *position,
         max_pos_j = position_j[pos + delta];
         int max;
         max = position[pos + delta];
-        printf("target upper bound %d: query lower bound %d  (%5.2f) \n",
-               pos - 10,
-               max_pos_j - 10,
-               ((double)max) / 100);
+        plex_output_printf("target upper bound %d: query lower bound %d  (%5.2f) \n",
+                           pos - 10,
+                           max_pos_j - 10,
+                           ((double)max) / 100);
         pos = MAX2(10, pos + temp_min - delta);
       }
     }
@@ -918,8 +938,8 @@ find_max_CXS(const int  *position,
           int dL  = strrchr(structure, '|') - strchr(structure, '|');
           dL += 1;
           if (dL <= strlen(test.structure) - l1 - 1) {
-            printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f)\n", test.structure,
-                   test.tb, test.te, test.qb, test.qe, test.ddG, test.energy, test.dG1, test.dG2);
+            plex_output_printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f)\n", test.structure,
+                               test.tb, test.te, test.qb, test.qe, test.ddG, test.energy, test.dG1, test.dG2);
             pos = MAX2(10, pos + temp_min - delta);
           }
         }
@@ -947,8 +967,8 @@ plot_max_CXS(const int  max,
              const char *structure)
 {
   if (fast == 1) {
-    printf("target upper bound %d: query lower bound %d (%5.2f)\n", max_pos - 3, max_pos_j,
-           ((double)max) / 100);
+    plex_output_printf("target upper bound %d: query lower bound %d (%5.2f)\n", max_pos - 3, max_pos_j,
+                       ((double)max) / 100);
   } else {
     int   begin_t           = MAX2(9, max_pos - alignment_length);
     int   end_t             = max_pos;
@@ -969,8 +989,8 @@ plot_max_CXS(const int  max,
     int     dL  = strrchr(structure, '|') - strchr(structure, '|');
     dL += 1;
     if (dL <= strlen(test.structure) - l1 - 1)
-      printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f)\n", test.structure,
-             test.tb, test.te, test.qb, test.qe, test.ddG, test.energy, test.dG1, test.dG2);
+      plex_output_printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f)\n", test.structure,
+                         test.tb, test.te, test.qb, test.qe, test.ddG, test.energy, test.dG1, test.dG2);
 
     free(s3);
     free(s4);
@@ -1537,10 +1557,10 @@ find_max_C(const int  *position,
         max_pos_j = position_j[pos + delta];
         int max;
         max = position[pos + delta];
-        printf("target upper bound %d: query lower bound %d  (%5.2f) \n",
-               pos - 10,
-               max_pos_j - 10,
-               ((double)max) / 100);
+        plex_output_printf("target upper bound %d: query lower bound %d  (%5.2f) \n",
+                           pos - 10,
+                           max_pos_j - 10,
+                           ((double)max) / 100);
         pos = MAX2(10, pos - delta);
       }
     }
@@ -1583,12 +1603,12 @@ find_max_C(const int  *position,
           int dL  = strrchr(structure, '|') - strchr(structure, '|');
           dL += 1;
           if (dL <= strlen(test.structure) - l1 - 1) {
-            printf("%s %3d,%-3d : %3d,%-3d (%5.2f)\n", test.structure,
-                   begin_t - 10 + test.i - l1,
-                   begin_t - 10 + test.i - 1,
-                   begin_q - 10 + test.j - 1,
-                   (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2,
-                   test.energy);
+            plex_output_printf("%s %3d,%-3d : %3d,%-3d (%5.2f)\n", test.structure,
+                               begin_t - 10 + test.i - l1,
+                               begin_t - 10 + test.i - 1,
+                               begin_q - 10 + test.j - 1,
+                               (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2,
+                               test.energy);
             pos = MAX2(10, pos - delta);
           }
         }
@@ -1615,8 +1635,8 @@ plot_max_C(const int  max,
            const char *structure)
 {
   if (fast == 1) {
-    printf("target upper bound %d: query lower bound %d (%5.2f)\n", max_pos - 10, max_pos_j - 10,
-           ((double)max) / 100);
+    plex_output_printf("target upper bound %d: query lower bound %d (%5.2f)\n", max_pos - 10, max_pos_j - 10,
+                       ((double)max) / 100);
   } else {
     duplexT test;
     int     begin_t           = MAX2(11, max_pos - alignment_length + 1);
@@ -1637,9 +1657,9 @@ plot_max_C(const int  max,
     int dL  = strrchr(structure, '|') - strchr(structure, '|');
     dL += 1;
     if (dL <= strlen(test.structure) - l1 - 1) {
-      printf("%s %3d,%-3d : %3d,%-3d (%5.2f)\n", test.structure,
-             begin_t - 10 + test.i - l1, begin_t - 10 + test.i - 1, begin_q - 10 + test.j - 1,
-             (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2, test.energy);
+      plex_output_printf("%s %3d,%-3d : %3d,%-3d (%5.2f)\n", test.structure,
+                         begin_t - 10 + test.i - l1, begin_t - 10 + test.i - 1, begin_q - 10 + test.j - 1,
+                         (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2, test.energy);
       free(s3);
       free(s4);
       free(test.structure);
@@ -38,6 +38,24 @@
  #################################
  */
 
+#define HC_DEPOT_UP           1
+#define HC_DEPOT_BP           2
+#define HC_DEPOT_BP_NONSPEC   3
+
+/* a single user-defined constraint, as passed to the vrna_hc_add_*() functions */
+struct hc_depot_entry {
+  unsigned char type;
+  int           i;
+  int           j;
+  unsigned char option;
+};
+
+struct vrna_hc_depot_s {
+  size_t                num;
+  size_t                size;
+  struct hc_depot_entry *entries;
+};
+
 /*
  #################################
  # PRIVATE VARIABLES             #
@@ -111,6 +129,36 @@ hc_add_up(vrna_fold_compound_t  *vc,
           unsigned char         option);
 
 
+PRIVATE void
+hc_add_bp(vrna_fold_compound_t  *vc,
+          int                   i,
+          int                   j,
+          unsigned char         option);
+
+
+PRIVATE void
+hc_add_bp_nonspecific(vrna_fold_compound_t  *vc,
+                      int                   i,
+                      int                   d,
+                      unsigned char         option);
+
+
+PRIVATE void
+hc_depot_store(vrna_hc_t      *hc,
+               unsigned char  type,
+               int            i,
+               int            j,
+               unsigned char  option);
+
+
+PRIVATE void
+hc_depot_apply(vrna_fold_compound_t *fc);
+
+
+PRIVATE void
+hc_depot_free(vrna_hc_depot_t *depot);
+
+
 PRIVATE void
 apply_DB_constraint(vrna_fold_compound_t  *vc,
                     const char            *constraint,
@@ -200,6 +248,7 @@ vrna_hc_init(vrna_fold_compound_t *vc)
   hc->f         = NULL;
   hc->data      = NULL;
   hc->free_data = NULL;
+  hc->depot     = NULL;
 
   /* update */
   hc_update_up(vc);
@@ -236,6 +285,67 @@ vrna_hc_init_window(vrna_fold_compound_t *vc)
   hc->f         = NULL;
   hc->data      = NULL;
   hc->free_data = NULL;
+  hc->depot     = NULL;
+}
+
+
+PUBLIC void
+vrna_hc_reset_pairs(vrna_fold_compound_t  *fc,
+                    const unsigned int    *positions)
+{
+  unsigned char *touched, constraint;
+  unsigned int  i, j, n, p, min, max;
+  int           *idx;
+  vrna_hc_t     *hc;
+
+  if ((fc) && (fc->hc) && (fc->hc->type == VRNA_HC_DEFAULT) && (positions)) {
+    n   = fc->length;
+    hc  = fc->hc;
+    idx = fc->jindx;
+
+    touched = (unsigned char *)vrna_alloc(sizeof(unsigned char) * (n + 2));
+
+    for (i = 0; positions[i]; i++) {
+      p = positions[i];
+      if (p > n)
+        continue;
+
+      touched[p] = 1;
+
+      /* with noLP, the default of a pair also depends on the stacking neighbors */
+      if (fc->params->model_details.noLP) {
+        touched[p - 1]  = 1;
+        touched[p + 1]  = 1;
+      }
+    }
+
+    for (i = 1; i <= n; i++) {
+      if (!touched[i])
+        continue;
+
+      for (j = 1; j <= n; j++) {
+        if (j == i)
+          continue;
+
+        min = MIN2(i, j);
+        max = MAX2(i, j);
+
+        constraint                  = default_pair_constraint(fc, min, max);
+        hc->matrix[idx[max] + min]  = constraint;
+        hc->mx[n * min + max]       = constraint;
+        hc->mx[n * max + min]       = constraint;
+      }
+    }
+
+    /*
+     *  re-apply user-defined constraints on top of the new defaults. Each of
+     *  them maps an entry x to (x & A) | B, so repeating them does not alter
+     *  any of the pairs that have not been reset
+     */
+    hc_depot_apply(fc);
+
+    free(touched);
+  }
 }
 
 
@@ -286,6 +396,7 @@ vrna_hc_add_up(vrna_fold_compound_t *vc,
       }
 
       hc_add_up(vc, i, option);
+      hc_depot_store(vc->hc, HC_DEPOT_UP, i, 0, option);
 
       if (vc->hc->type != VRNA_HC_WINDOW)
         hc_update_up(vc);
@@ -314,6 +425,7 @@ vrna_hc_add_up_batch(vrna_fold_compound_t *vc,
         }
 
         hc_add_up(vc, pos, options);
+        hc_depot_store(vc->hc, HC_DEPOT_UP, pos, 0, options);
       }
 
       if (vc->hc->type != VRNA_HC_WINDOW)
@@ -333,11 +445,6 @@ vrna_hc_add_bp_nonspecific(vrna_fold_compound_t *vc,
                            int                  d,
                            unsigned char        option)
 {
-  unsigned char type, t1, t2;
-  unsigned int  n;
-  int           p;
-  vrna_hc_t     *hc;
-
   if (vc) {
     if (vc->hc) {
       if ((i <= 0) || (i > vc->length)) {
@@ -345,58 +452,8 @@ vrna_hc_add_bp_nonspecific(vrna_fold_compound_t *vc,
         return;
       }
 
-      hc  = vc->hc;
-      n   = hc->n;
-
-      /* position i may pair in provided contexts */
-      type = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
-      /* acknowledge pairing direction */
-      t1  = (d <= 0) ? type : VRNA_CONSTRAINT_CONTEXT_NONE;
-      t2  = (d >= 0) ? type : VRNA_CONSTRAINT_CONTEXT_NONE;
-
-      if (hc->type == VRNA_HC_WINDOW) {
-        /* nucleotide mustn't be unpaired */
-        hc_init_up_storage(hc);
-        hc->up_storage[i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-        /* force pairing direction */
-        hc_init_bp_storage(hc);
-        for (p = 1; p < i; p++)
-          hc_store_bp_add(hc->bp_storage, p, i, i, t1);
-
-        hc_store_bp_add(hc->bp_storage, i, i + 1, n, t2);
-      } else {
-        if (option & VRNA_CONSTRAINT_CONTEXT_NO_REMOVE) {
-          /* only allow for possibly non-canonical pairs, do not enforce them */
-          for (p = 1; p < i; p++) {
-            hc->matrix[vc->jindx[i] + p]  |= t1;
-            hc->mx[n * i + p]             |= t1;
-            hc->mx[n * p + i]             |= t1;
-          }
-          for (p = i + 1; p <= vc->length; p++) {
-            hc->matrix[vc->jindx[p] + i]  |= t2;
-            hc->mx[n * i + p]             |= t2;
-            hc->mx[n * p + i]             |= t2;
-          }
-        } else {
-          /* force pairing direction */
-          for (p = 1; p < i; p++) {
-            hc->matrix[vc->jindx[i] + p]  &= t1;
-            hc->mx[n * i + p]             &= t1;
-            hc->mx[n * p + i]             &= t1;
-          }
-          for (p = i + 1; p <= vc->length; p++) {
-            hc->matrix[vc->jindx[p] + i]  &= t2;
-            hc->mx[n * i + p]             &= t2;
-            hc->mx[n * p + i]             &= t2;
-          }
-          /* nucleotide mustn't be unpaired */
-          hc->matrix[vc->jindx[i] + i]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-          hc->mx[n * i + i]             = VRNA_CONSTRAINT_CONTEXT_NONE;
-        }
-
-        hc_update_up(vc);
-      }
+      hc_add_bp_nonspecific(vc, i, d, option);
+      hc_depot_store(vc->hc, HC_DEPOT_BP_NONSPEC, i, d, option);
     }
   }
 }
@@ -408,10 +465,6 @@ vrna_hc_add_bp(vrna_fold_compound_t *vc,
                int                  j,
                unsigned char        option)
 {
-  unsigned int  n;
-  int           k, l;
-  vrna_hc_t     *hc;
-
   if (vc) {
     if (vc->hc) {
       if ((i <= 0) || (j <= i) || (j > vc->length)) {
@@ -426,112 +479,8 @@ vrna_hc_add_bp(vrna_fold_compound_t *vc,
         return;
       }
 
-      hc  = vc->hc;
-      n   = hc->n;
-
-      if (hc->type == VRNA_HC_WINDOW) {
-        hc_init_bp_storage(hc);
-        hc_store_bp_override(hc->bp_storage, i, j, j,
-                             option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
-
-        if (!(option & VRNA_CONSTRAINT_CONTEXT_NO_REMOVE)) {
-          /*
-           * remove all conflicting base pairs, i.e. do not allow i or j to pair
-           * with any other nucleotide k
-           */
-          for (k = 1; k < i; k++)
-            hc_store_bp_add(hc->bp_storage, k, i, j, VRNA_CONSTRAINT_CONTEXT_NONE);             /* (k, i), (k, i + 1), ..., (k, j) with 1 <= k < i */
-
-          hc_store_bp_add(hc->bp_storage, i, i + 1, j - 1, VRNA_CONSTRAINT_CONTEXT_NONE);       /* (i, k), i < k < j */
-
-          for (k = i + 1; k < j; k++)
-            hc_store_bp_add(hc->bp_storage, k, j, vc->length, VRNA_CONSTRAINT_CONTEXT_NONE);    /* (i + 1, k), (i + 1, k), ..., (j - 1, k) with (j < k <= n */
-
-          hc_store_bp_add(hc->bp_storage, i, j + 1, vc->length, VRNA_CONSTRAINT_CONTEXT_NONE);  /* (i, k), j < k <= n */
-          hc_store_bp_add(hc->bp_storage, j, j + 1, vc->length, VRNA_CONSTRAINT_CONTEXT_NONE);  /* (j, k), j < k <= n */
-        }
-
-        if (option & VRNA_CONSTRAINT_CONTEXT_ENFORCE) {
-          /* do not allow i,j to be unpaired */
-          hc_init_up_storage(hc);
-          hc->up_storage[i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-          hc->up_storage[j] = VRNA_CONSTRAINT_CONTEXT_NONE;
-        }
-      } else {
-        /* reset ptype in case (i,j) is a non-canonical pair */
-        if ((vc->type == VRNA_FC_TYPE_SINGLE) && (option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS)) {
-          if (hc->matrix[vc->jindx[j] + i])
-            if (vc->ptype[vc->jindx[j] + i] == 0)
-              vc->ptype[vc->jindx[j] + i] = 7;
-
-          if (hc->mx[n * i + j])
-            if (vc->ptype[vc->jindx[j] + i] == 0)
-              vc->ptype[vc->jindx[j] + i] = 7;
-        }
-
-        hc->matrix[vc->jindx[j] + i]  = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
-        hc->mx[n * i + j]             = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
-        hc->mx[n * j + i]             = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
-
-        if (!(option & VRNA_CONSTRAINT_CONTEXT_NO_REMOVE)) {
-          /*
-           * remove all conflicting base pairs, i.e. do not allow i,j to pair
-           * with any other nucleotide k
-           */
-          for (k = 1; k < i; k++) {
-            hc->matrix[vc->jindx[i] + k]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->matrix[vc->jindx[j] + k]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-            hc->mx[n * i + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * k + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * j + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * k + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-            for (l = i + 1; l < j; l++) {
-              hc->matrix[vc->jindx[l] + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-              hc->mx[n * k + l] = VRNA_CONSTRAINT_CONTEXT_NONE;
-              hc->mx[n * l + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            }
-          }
-          for (k = i + 1; k < j; k++) {
-            hc->matrix[vc->jindx[k] + i]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->matrix[vc->jindx[j] + k]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-            hc->mx[n * i + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * k + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * j + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * k + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-            for (l = j + 1; l <= vc->length; l++) {
-              hc->matrix[vc->jindx[l] + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-              hc->mx[n * k + l] = VRNA_CONSTRAINT_CONTEXT_NONE;
-              hc->mx[n * l + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            }
-          }
-          for (k = j + 1; k <= vc->length; k++) {
-            hc->matrix[vc->jindx[k] + i]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->matrix[vc->jindx[k] + j]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-            hc->mx[n * i + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * k + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * j + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * k + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
-          }
-        }
-
-        if (option & VRNA_CONSTRAINT_CONTEXT_ENFORCE) {
-          /* do not allow i,j to be unpaired */
-          hc->matrix[vc->jindx[i] + i]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-          hc->matrix[vc->jindx[j] + j]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-          hc->mx[n * i + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-          hc->mx[n * j + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-          hc_update_up(vc);
-        }
-      }
+      hc_add_bp(vc, i, j, option);
+      hc_depot_store(vc->hc, HC_DEPOT_BP, i, j, option);
     }
   }
 }
@@ -563,6 +512,8 @@ vrna_hc_free(vrna_hc_t *hc)
     if (hc->free_data)
       hc->free_data(hc->data);
 
+    hc_depot_free(hc->depot);
+
     free(hc);
   }
 }
@@ -1027,6 +978,260 @@ hc_add_up(vrna_fold_compound_t  *vc,
 }
 
 
+PRIVATE void
+hc_add_bp_nonspecific(vrna_fold_compound_t  *vc,
+                      int                   i,
+                      int                   d,
+                      unsigned char         option)
+{
+  unsigned char type, t1, t2;
+  unsigned int  n;
+  int           p;
+  vrna_hc_t     *hc;
+
+  hc  = vc->hc;
+  n   = hc->n;
+
+  /* position i may pair in provided contexts */
+  type = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
+  /* acknowledge pairing direction */
+  t1  = (d <= 0) ? type : VRNA_CONSTRAINT_CONTEXT_NONE;
+  t2  = (d >= 0) ? type : VRNA_CONSTRAINT_CONTEXT_NONE;
+
+  if (hc->type == VRNA_HC_WINDOW) {
+    /* nucleotide mustn't be unpaired */
+    hc_init_up_storage(hc);
+    hc->up_storage[i] = VRNA_CONSTRAINT_CONTEXT_NONE;
+
+    /* force pairing direction */
+    hc_init_bp_storage(hc);
+    for (p = 1; p < i; p++)
+      hc_store_bp_add(hc->bp_storage, p, i, i, t1);
+
+    hc_store_bp_add(hc->bp_storage, i, i + 1, n, t2);
+  } else {
+    if (option & VRNA_CONSTRAINT_CONTEXT_NO_REMOVE) {
+      /* only allow for possibly non-canonical pairs, do not enforce them */
+      for (p = 1; p < i; p++) {
+        hc->matrix[vc->jindx[i] + p]  |= t1;
+        hc->mx[n * i + p]             |= t1;
+        hc->mx[n * p + i]             |= t1;
+      }
+      for (p = i + 1; p <= vc->length; p++) {
+        hc->matrix[vc->jindx[p] + i]  |= t2;
+        hc->mx[n * i + p]             |= t2;
+        hc->mx[n * p + i]             |= t2;
+      }
+    } else {
+      /* force pairing direction */
+      for (p = 1; p < i; p++) {
+        hc->matrix[vc->jindx[i] + p]  &= t1;
+        hc->mx[n * i + p]             &= t1;
+        hc->mx[n * p + i]             &= t1;
+      }
+      for (p = i + 1; p <= vc->length; p++) {
+        hc->matrix[vc->jindx[p] + i]  &= t2;
+        hc->mx[n * i + p]             &= t2;
+        hc->mx[n * p + i]             &= t2;
+      }
+      /* nucleotide mustn't be unpaired */
+      hc->matrix[vc->jindx[i] + i]  = VRNA_CONSTRAINT_CONTEXT_NONE;
+      hc->mx[n * i + i]             = VRNA_CONSTRAINT_CONTEXT_NONE;
+    }
+
+    hc_update_up(vc);
+  }
+}
+
+
+PRIVATE void
+hc_add_bp(vrna_fold_compound_t  *vc,
+          int                   i,
+          int                   j,
+          unsigned char         option)
+{
+  unsigned int  n;
+  int           k, l;
+  vrna_hc_t     *hc;
+
+  hc  = vc->hc;
+  n   = hc->n;
+
+  if (hc->type == VRNA_HC_WINDOW) {
+    hc_init_bp_storage(hc);
+    hc_store_bp_override(hc->bp_storage, i, j, j,
+                         option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
+
+    if (!(option & VRNA_CONSTRAINT_CONTEXT_NO_REMOVE)) {
+      /*
+       * remove all conflicting base pairs, i.e. do not allow i or j to pair
+       * with any other nucleotide k
+       */
+      for (k = 1; k < i; k++)
+        hc_store_bp_add(hc->bp_storage, k, i, j, VRNA_CONSTRAINT_CONTEXT_NONE);             /* (k, i), (k, i + 1), ..., (k, j) with 1 <= k < i */
+
+      hc_store_bp_add(hc->bp_storage, i, i + 1, j - 1, VRNA_CONSTRAINT_CONTEXT_NONE);       /* (i, k), i < k < j */
+
+      for (k = i + 1; k < j; k++)
+        hc_store_bp_add(hc->bp_storage, k, j, vc->length, VRNA_CONSTRAINT_CONTEXT_NONE);    /* (i + 1, k), (i + 1, k), ..., (j - 1, k) with (j < k <= n */
+
+      hc_store_bp_add(hc->bp_storage, i, j + 1, vc->length, VRNA_CONSTRAINT_CONTEXT_NONE);  /* (i, k), j < k <= n */
+      hc_store_bp_add(hc->bp_storage, j, j + 1, vc->length, VRNA_CONSTRAINT_CONTEXT_NONE);  /* (j, k), j < k <= n */
+    }
+
+    if (option & VRNA_CONSTRAINT_CONTEXT_ENFORCE) {
+      /* do not allow i,j to be unpaired */
+      hc_init_up_storage(hc);
+      hc->up_storage[i] = VRNA_CONSTRAINT_CONTEXT_NONE;
+      hc->up_storage[j] = VRNA_CONSTRAINT_CONTEXT_NONE;
+    }
+  } else {
+    /* reset ptype in case (i,j) is a non-canonical pair */
+    if ((vc->type == VRNA_FC_TYPE_SINGLE) && (option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS)) {
+      if (hc->matrix[vc->jindx[j] + i])
+        if (vc->ptype[vc->jindx[j] + i] == 0)
+          vc->ptype[vc->jindx[j] + i] = 7;
+
+      if (hc->mx[n * i + j])
+        if (vc->ptype[vc->jindx[j] + i] == 0)
+          vc->ptype[vc->jindx[j] + i] = 7;
+    }
+
+    hc->matrix[vc->jindx[j] + i]  = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
+    hc->mx[n * i + j]             = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
+    hc->mx[n * j + i]             = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
+
+    if (!(option & VRNA_CONSTRAINT_CONTEXT_NO_REMOVE)) {
+      /*
+       * remove all conflicting base pairs, i.e. do not allow i,j to pair
+       * with any other nucleotide k
+       */
+      for (k = 1; k < i; k++) {
+        hc->matrix[vc->jindx[i] + k]  = VRNA_CONSTRAINT_CONTEXT_NONE;
+        hc->matrix[vc->jindx[j] + k]  = VRNA_CONSTRAINT_CONTEXT_NONE;
+
+        hc->mx[n * i + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
+        hc->mx[n * k + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
+        hc->mx[n * j + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
+        hc->mx[n * k + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
+
+        for (l = i + 1; l < j; l++) {
+          hc->matrix[vc->jindx[l] + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
+
+          hc->mx[n * k + l] = VRNA_CONSTRAINT_CONTEXT_NONE;
+          hc->mx[n * l + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
+        }
+      }
+      for (k = i + 1; k < j; k++) {
+        hc->matrix[vc->jindx[k] + i]  = VRNA_CONSTRAINT_CONTEXT_NONE;
+        hc->matrix[vc->jindx[j] + k]  = VRNA_CONSTRAINT_CONTEXT_NONE;
+
+        hc->mx[n * i + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
+        hc->mx[n * k + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
+        hc->mx[n * j + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
+        hc->mx[n * k + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
+
+        for (l = j + 1; l <= vc->length; l++) {
+          hc->matrix[vc->jindx[l] + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
+
+          hc->mx[n * k + l] = VRNA_CONSTRAINT_CONTEXT_NONE;
+          hc->mx[n * l + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
+        }
+      }
+      for (k = j + 1; k <= vc->length; k++) {
+        hc->matrix[vc->jindx[k] + i]  = VRNA_CONSTRAINT_CONTEXT_NONE;
+        hc->matrix[vc->jindx[k] + j]  = VRNA_CONSTRAINT_CONTEXT_NONE;
+
+        hc->mx[n * i + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
+        hc->mx[n * k + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
+        hc->mx[n * j + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
+        hc->mx[n * k + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
+      }
+    }
+
+    if (option & VRNA_CONSTRAINT_CONTEXT_ENFORCE) {
+      /* do not allow i,j to be unpaired */
+      hc->matrix[vc->jindx[i] + i]  = VRNA_CONSTRAINT_CONTEXT_NONE;
+      hc->matrix[vc->jindx[j] + j]  = VRNA_CONSTRAINT_CONTEXT_NONE;
+
+      hc->mx[n * i + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
+      hc->mx[n * j + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
+
+      hc_update_up(vc);
+    }
+  }
+}
+
+
+PRIVATE void
+hc_depot_store(vrna_hc_t      *hc,
+               unsigned char  type,
+               int            i,
+               int            j,
+               unsigned char  option)
+{
+  vrna_hc_depot_t *depot;
+
+  if (!hc->depot)
+    hc->depot = (vrna_hc_depot_t *)vrna_alloc(sizeof(vrna_hc_depot_t));
+
+  depot = hc->depot;
+
+  if (depot->num == depot->size) {
+    depot->size     = (depot->size) ? 2 * depot->size : 16;
+    depot->entries  = (struct hc_depot_entry *)vrna_realloc(depot->entries,
+                                                             sizeof(struct hc_depot_entry) *
+                                                             depot->size);
+  }
+
+  depot->entries[depot->num].type   = type;
+  depot->entries[depot->num].i      = i;
+  depot->entries[depot->num].j      = j;
+  depot->entries[depot->num].option = option;
+  depot->num++;
+}
+
+
+PRIVATE void
+hc_depot_apply(vrna_fold_compound_t *fc)
+{
+  size_t                k;
+  struct hc_depot_entry *e;
+
+  if (!fc->hc->depot)
+    return;
+
+  for (k = 0; k < fc->hc->depot->num; k++) {
+    e = &(fc->hc->depot->entries[k]);
+    switch (e->type) {
+      case HC_DEPOT_UP:
+        hc_add_up(fc, e->i, e->option);
+        break;
+
+      case HC_DEPOT_BP:
+        hc_add_bp(fc, e->i, e->j, e->option);
+        break;
+
+      case HC_DEPOT_BP_NONSPEC:
+        hc_add_bp_nonspecific(fc, e->i, e->j, e->option);
+        break;
+    }
+  }
+
+  hc_update_up(fc);
+}
+
+
+PRIVATE void
+hc_depot_free(vrna_hc_depot_t *depot)
+{
+  if (depot) {
+    free(depot->entries);
+    free(depot);
+  }
+}
+
+
 struct hc_bp {
   int           i;
   int           j;
@@ -41,6 +41,12 @@ typedef struct  vrna_hc_s vrna_hc_t;
  */
 typedef struct vrna_hc_up_s vrna_hc_up_t;
 
+/**
+ *  @brief  Typename for the opaque record of user-defined hard constraints
+ *  @ingroup  hard_constraints
+ */
+typedef struct vrna_hc_depot_s vrna_hc_depot_t;
+
 /**
  * @brief Callback to evaluate whether or not a particular decomposition step is contributing to the solution space
  *
@@ -425,6 +431,13 @@ struct vrna_hc_s {
                                            *    memory, the user may use this pointer to free
                                            *    memory occupied by auxiliary data.
                                            */
+
+  vrna_hc_depot_t             *depot;     /**<  @brief  Record of the user-defined constraints
+                                           *
+                                           *    Filled by vrna_hc_add_up(), vrna_hc_add_bp(),
+                                           *    and friends, and used by vrna_hc_reset_pairs()
+                                           *    to re-apply the constraints after a mutation.
+                                           */
 };
 
 /**
@@ -500,6 +513,27 @@ vrna_hc_update(vrna_fold_compound_t *fc,
                unsigned int         i);
 
 
+/**
+ *  @brief  Reset the hard constraints of all base pairs that involve particular nucleotides
+ *
+ *  Re-evaluates the default, sequence dependent, pairing rules for any base pair (i,j) where
+ *  either i or j is listed in @p positions. This is useful after point mutations of the
+ *  sequence stored in the fold compound, see vrna_sequence_mutate(). User-defined
+ *  constraints added through vrna_hc_add_up(), vrna_hc_add_bp(), vrna_hc_add_bp_nonspecific(),
+ *  or vrna_hc_add_from_db() are re-applied afterwards, so they survive the reset.
+ *
+ *  @ingroup  hard_constraints
+ *
+ *  @see  vrna_hc_init(), vrna_sequence_mutate()
+ *
+ *  @param  fc          The fold compound
+ *  @param  positions   A 0-terminated list of (1-based) sequence positions
+ */
+void
+vrna_hc_reset_pairs(vrna_fold_compound_t  *fc,
+                    const unsigned int    *positions);
+
+
 /**
  *  @brief  Make a certain nucleotide unpaired
  *
@@ -0,0 +1,140 @@
+/*
+ *  dist_matrix.c
+ *
+ *  Utilities for packed all-vs-all distance matrices
+ *
+ *  Vienna RNA package
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/dist_matrix.h"
+
+/*
+ #################################
+ # PRIVATE FUNCTION DECLARATIONS #
+ #################################
+ */
+
+PRIVATE int
+write_phylip(FILE         *file,
+             const float  *matrix,
+             unsigned int n,
+             const char   **labels);
+
+
+PRIVATE int
+write_binary(FILE         *file,
+             const float  *matrix,
+             unsigned int n);
+
+
+/*
+ #################################
+ # BEGIN OF FUNCTION DEFINITIONS #
+ #################################
+ */
+PUBLIC float
+vrna_dist_matrix_get(const float  *matrix,
+                     unsigned int n,
+                     unsigned int i,
+                     unsigned int j)
+{
+  unsigned int tmp;
+
+  if ((!matrix) || (i == j) || (i >= n) || (j >= n))
+    return 0.;
+
+  if (i > j) {
+    tmp = i;
+    i   = j;
+    j   = tmp;
+  }
+
+  return matrix[VRNA_DIST_MATRIX_INDEX(n, i, j)];
+}
+
+
+PUBLIC int
+vrna_file_distance_matrix(FILE          *file,
+                          const float   *matrix,
+                          unsigned int  n,
+                          const char    **labels,
+                          unsigned int  options)
+{
+  if ((!file) || ((!matrix) && (n > 1))) {
+    vrna_message_warning("vrna_file_distance_matrix: missing file handle or matrix");
+    return 0;
+  }
+
+  if (options & VRNA_DIST_MATRIX_BINARY)
+    return write_binary(file, matrix, n);
+
+  return write_phylip(file, matrix, n, labels);
+}
+
+
+/*
+ #####################################
+ # BEGIN OF STATIC HELPER FUNCTIONS  #
+ #####################################
+ */
+PRIVATE int
+write_phylip(FILE         *file,
+             const float  *matrix,
+             unsigned int n,
+             const char   **labels)
+{
+  unsigned int  i, j;
+  char          name[11];
+
+  fprintf(file, "%5u\n", n);
+
+  for (i = 0; i < n; i++) {
+    if ((labels) && (labels[i]))
+      snprintf(name, sizeof(name), "%s", labels[i]);
+    else
+      snprintf(name, sizeof(name), "%u", i + 1);
+
+    /* PHYLIP names are blank padded to exactly 10 characters */
+    fprintf(file, "%-10s", name);
+
+    for (j = 0; j < n; j++)
+      fprintf(file, " %g", vrna_dist_matrix_get(matrix, n, i, j));
+
+    fprintf(file, "\n");
+  }
+
+  return ferror(file) ? 0 : 1;
+}
+
+
+PRIVATE int
+write_binary(FILE         *file,
+             const float  *matrix,
+             unsigned int n)
+{
+  uint32_t  header[2];
+  size_t    size;
+
+  header[0] = 1;
+  header[1] = (uint32_t)n;
+  size      = ((size_t)n * (size_t)((n > 0) ? n - 1 : 0)) / 2;
+
+  if ((fwrite("VRNADIST", sizeof(char), 8, file) != 8) ||
+      (fwrite(header, sizeof(uint32_t), 2, file) != 2) ||
+      ((size > 0) && (fwrite(matrix, sizeof(float), size, file) != size))) {
+    vrna_message_warning("vrna_file_distance_matrix: failed to write binary matrix");
+    return 0;
+  }
+
+  return 1;
+}
@@ -0,0 +1,88 @@
+#ifndef VIENNA_RNA_PACKAGE_DIST_MATRIX_H
+#define VIENNA_RNA_PACKAGE_DIST_MATRIX_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/**
+ *  @file     dist_matrix.h
+ *  @brief    Packed all-vs-all distance matrices
+ *
+ *  The functions tree_edit_distance_matrix(), string_edit_distance_matrix(),
+ *  and profile_edit_distance_matrix() return the distances between all pairs
+ *  of @f$ n @f$ objects as a packed upper triangular matrix, i.e. a linear
+ *  array of @f$ n (n - 1) / 2 @f$ values where the distances of the first
+ *  object to all others come first, followed by the distances of the second
+ *  object to all objects with larger index, and so on.
+ */
+
+/**
+ *  @brief  Write the distance matrix in PHYLIP format
+ *
+ *  The file starts with the number of objects, followed by one line per object
+ *  with its label (at most 10 characters) and its distances to all other objects
+ *  (square matrix).
+ *
+ *  @see vrna_file_distance_matrix()
+ */
+#define VRNA_DIST_MATRIX_PHYLIP   1U
+
+/**
+ *  @brief  Write the distance matrix in binary format
+ *
+ *  The file starts with the 8 characters "VRNADIST", followed by the format
+ *  version (1) and the number of objects @f$ n @f$, both as 32-bit unsigned
+ *  integers, and the @f$ n (n - 1) / 2 @f$ values of the packed upper triangular
+ *  matrix as 32-bit floats. All numbers are stored in the byte order of the
+ *  host.
+ *
+ *  @see vrna_file_distance_matrix()
+ */
+#define VRNA_DIST_MATRIX_BINARY   2U
+
+/**
+ *  @brief  Get the index of the distance between objects @p i and @p j in a packed matrix
+ *
+ *  Objects are numbered from 0 to @f$ n - 1 @f$, and @p i must be smaller than @p j.
+ */
+#define VRNA_DIST_MATRIX_INDEX(n, i, j)  \
+  ((size_t)(i) * (size_t)(n) - ((size_t)(i) * ((size_t)(i) + 1)) / 2 + (size_t)((j) - (i) - 1))
+
+
+/**
+ *  @brief  Get the distance between two objects from a packed distance matrix
+ *
+ *  @param  matrix  The packed upper triangular distance matrix
+ *  @param  n       The number of objects
+ *  @param  i       The first object (0-based)
+ *  @param  j       The second object (0-based)
+ *  @return         The distance between objects @p i and @p j
+ */
+float
+vrna_dist_matrix_get(const float  *matrix,
+                     unsigned int n,
+                     unsigned int i,
+                     unsigned int j);
+
+
+/**
+ *  @brief  Write a packed distance matrix to a file
+ *
+ *  @see #VRNA_DIST_MATRIX_PHYLIP, #VRNA_DIST_MATRIX_BINARY
+ *
+ *  @param  file    The file handle to write to
+ *  @param  matrix  The packed upper triangular distance matrix
+ *  @param  n       The number of objects
+ *  @param  labels  The names of the objects for PHYLIP output (may be NULL to use running numbers)
+ *  @param  options Either #VRNA_DIST_MATRIX_PHYLIP, or #VRNA_DIST_MATRIX_BINARY
+ *  @return         1 on success, 0 otherwise
+ */
+int
+vrna_file_distance_matrix(FILE          *file,
+                          const float   *matrix,
+                          unsigned int  n,
+                          const char    **labels,
+                          unsigned int  options);
+
+
+#endif
@@ -20,11 +20,17 @@
 #include <stdlib.h>
 #include <math.h>
 
+#if VRNA_WITH_PTHREADS
+# include <pthread.h>
+#endif
+
 #include "ViennaRNA/datastructures/basic.h"
 #include "ViennaRNA/model.h"
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/gquad.h"
 #include "ViennaRNA/dp_matrices.h"
+#include "ViennaRNA/dp_matrices_hooks.h"
+#include "ViennaRNA/utils/timing_hooks.h"
 
 /*
  #################################
@@ -54,6 +60,13 @@
 #define ALLOC_PF_WO_PROBS         (ALLOC_F | ALLOC_C | ALLOC_FML)
 #define ALLOC_PF_DEFAULT          (ALLOC_PF_WO_PROBS | ALLOC_PROBS | ALLOC_AUX)
 
+/* DP matrices referenced through vrna_mx_mfe_ref() or vrna_mx_pf_ref() */
+typedef struct {
+  void          *mx;
+  unsigned int  refs;
+  int           released;   /* detached from their fold compound */
+} mx_reference_t;
+
 /*
  #################################
  # GLOBAL VARIABLES              #
@@ -65,6 +78,17 @@
  # PRIVATE VARIABLES             #
  #################################
  */
+PRIVATE size_t          mx_memory_budget  = 0;  /* 0 means unlimited */
+PRIVATE size_t          mx_memory_used    = 0;
+
+PRIVATE mx_reference_t  *mx_refs      = NULL;
+PRIVATE unsigned int    mx_refs_num   = 0;
+PRIVATE unsigned int    mx_refs_size  = 0;
+
+#if VRNA_WITH_PTHREADS
+PRIVATE pthread_mutex_t mx_memory_mtx = PTHREAD_MUTEX_INITIALIZER;
+PRIVATE pthread_mutex_t mx_refs_mtx   = PTHREAD_MUTEX_INITIALIZER;
+#endif
 
 /*
  #################################
@@ -153,6 +177,69 @@ PRIVATE vrna_mx_pf_t *get_pf_matrices_alloc(unsigned int    n,
                                             unsigned int    alloc_vector);
 
 
+PRIVATE size_t
+mfe_matrices_size(vrna_mx_type_e  type,
+                  unsigned int    n,
+                  unsigned int    window_size,
+                  unsigned int    alloc_vector,
+                  int             gquad);
+
+
+PRIVATE size_t
+pf_matrices_size(vrna_mx_type_e type,
+                 unsigned int   n,
+                 unsigned int   window_size,
+                 unsigned int   alloc_vector,
+                 int            gquad);
+
+
+PRIVATE size_t
+distance_classes_size(vrna_fold_compound_t  *fc,
+                      unsigned int          alloc_vector,
+                      size_t                elem_size);
+
+
+PRIVATE size_t
+distance_class_block_size(vrna_fold_compound_t  *fc,
+                          unsigned int          i,
+                          unsigned int          j,
+                          size_t                elem_size);
+
+
+PRIVATE int
+mx_memory_reserve(size_t bytes);
+
+
+PRIVATE void
+mx_memory_release(size_t bytes);
+
+
+PRIVATE mx_reference_t *
+mx_reference(void *mx);
+
+
+PRIVATE void
+mx_ref(void *mx);
+
+
+PRIVATE int
+mx_unref(void *mx);
+
+
+PRIVATE int
+mx_release(void *mx);
+
+
+PRIVATE void
+mfe_matrices_free(vrna_mx_mfe_t         *self,
+                  vrna_fold_compound_t  *vc);
+
+
+PRIVATE void
+pf_matrices_free(vrna_mx_pf_t         *self,
+                 vrna_fold_compound_t *vc);
+
+
 PRIVATE int
 add_pf_matrices(vrna_fold_compound_t  *vc,
                 vrna_mx_type_e        type,
@@ -165,6 +252,18 @@ add_mfe_matrices(vrna_fold_compound_t *vc,
                  unsigned int         alloc_vector);
 
 
+#ifdef VRNA_WITH_TIMING
+
+PRIVATE void
+timing_mfe_matrices(vrna_fold_compound_t *vc);
+
+
+PRIVATE void
+timing_pf_matrices(vrna_fold_compound_t *vc);
+
+
+#endif
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -176,24 +275,10 @@ vrna_mx_mfe_free(vrna_fold_compound_t *vc)
   if (vc) {
     vrna_mx_mfe_t *self = vc->matrices;
     if (self) {
-      switch (self->type) {
-        case VRNA_MX_DEFAULT:
-          mfe_matrices_free_default(self);
-          break;
-
-        case VRNA_MX_WINDOW:
-          mfe_matrices_free_window(self, vc->length, vc->window_size);
-          break;
-
-        case VRNA_MX_2DFOLD:
-          mfe_matrices_free_2Dfold(self, vc->length, vc->iindx);
-          break;
-
-        default:                /* do nothing */
-          break;
-      }
-      free(self);
       vc->matrices = NULL;
+      /* referenced matrices are freed by the last call to vrna_mx_mfe_unref() */
+      if (mx_release((void *)self))
+        mfe_matrices_free(self, vc);
     }
   }
 }
@@ -205,30 +290,55 @@ vrna_mx_pf_free(vrna_fold_compound_t *vc)
   if (vc) {
     vrna_mx_pf_t *self = vc->exp_matrices;
     if (self) {
-      switch (self->type) {
-        case VRNA_MX_DEFAULT:
-          pf_matrices_free_default(self);
-          break;
+      vc->exp_matrices = NULL;
+      if (mx_release((void *)self))
+        pf_matrices_free(self, vc);
+    }
+  }
+}
 
-        case VRNA_MX_WINDOW:
-          pf_matrices_free_window(self, vc->length, vc->window_size);
-          break;
 
-        case VRNA_MX_2DFOLD:
-          pf_matrices_free_2Dfold(self, vc->length, vc->iindx, vc->jindx);
-          break;
+PUBLIC vrna_mx_mfe_t *
+vrna_mx_mfe_ref(vrna_fold_compound_t *fc)
+{
+  vrna_mx_mfe_t *mx = NULL;
 
-        default:                /* do nothing */
-          break;
-      }
+  if ((fc) && (fc->matrices) && (fc->matrices->type == VRNA_MX_DEFAULT)) {
+    mx = fc->matrices;
+    mx_ref((void *)mx);
+  }
 
-      free(self->expMLbase);
-      free(self->scale);
+  return mx;
+}
 
-      free(self);
-      vc->exp_matrices = NULL;
-    }
+
+PUBLIC void
+vrna_mx_mfe_unref(vrna_mx_mfe_t *mx)
+{
+  if ((mx) && (mx_unref((void *)mx)))
+    mfe_matrices_free(mx, NULL);
+}
+
+
+PUBLIC vrna_mx_pf_t *
+vrna_mx_pf_ref(vrna_fold_compound_t *fc)
+{
+  vrna_mx_pf_t *mx = NULL;
+
+  if ((fc) && (fc->exp_matrices) && (fc->exp_matrices->type == VRNA_MX_DEFAULT)) {
+    mx = fc->exp_matrices;
+    mx_ref((void *)mx);
   }
+
+  return mx;
+}
+
+
+PUBLIC void
+vrna_mx_pf_unref(vrna_mx_pf_t *mx)
+{
+  if ((mx) && (mx_unref((void *)mx)))
+    pf_matrices_free(mx, NULL);
 }
 
 
@@ -304,6 +414,8 @@ vrna_mx_prepare(vrna_fold_compound_t  *vc,
   ret = 1;
 
   if (vc) {
+    VRNA_TIMING_START(vc, VRNA_TIMING_MX_PREPARE);
+
     /*  check whether we have the correct DP matrices attached, and if there is
      *  enough memory allocated
      */
@@ -335,8 +447,10 @@ vrna_mx_prepare(vrna_fold_compound_t  *vc,
 
     if (options & VRNA_OPTION_PF) {
       /* prepare for partition function computations */
-      if (!vc->exp_params) /* return failure if exp_params data is not present */
+      if (!vc->exp_params) { /* return failure if exp_params data is not present */
+        VRNA_TIMING_STOP(vc, VRNA_TIMING_MX_PREPARE);
         return 0;
+      }
 
       if (options & VRNA_OPTION_WINDOW) /* Windowing approach, a.k.a. locally optimal */
         mx_type = VRNA_MX_WINDOW;
@@ -370,6 +484,8 @@ vrna_mx_prepare(vrna_fold_compound_t  *vc,
 
 #endif
     }
+
+    VRNA_TIMING_STOP(vc, VRNA_TIMING_MX_PREPARE);
   } else {
     ret = 0;
   }
@@ -378,6 +494,143 @@ vrna_mx_prepare(vrna_fold_compound_t  *vc,
 }
 
 
+PUBLIC size_t
+vrna_mx_memory(vrna_mx_type_e   mx_type,
+               unsigned int     length,
+               const vrna_md_t  *md,
+               unsigned int     options)
+{
+  unsigned int  window_size, alloc_vector;
+  size_t        bytes;
+  vrna_md_t     md_copy;
+
+  /* get_mx_alloc_vector() may alter the model details */
+  if (md)
+    md_copy = *md;
+  else
+    vrna_md_set_default(&md_copy);
+
+  window_size = length;
+  if ((mx_type == VRNA_MX_WINDOW) &&
+      (md_copy.window_size > 0) &&
+      (md_copy.window_size < (int)length))
+    window_size = (unsigned int)md_copy.window_size;
+
+  bytes = 0;
+
+  if (options & VRNA_OPTION_MFE) {
+    alloc_vector  = get_mx_alloc_vector(&md_copy,
+                                        mx_type,
+                                        (options & ~VRNA_OPTION_PF) | VRNA_OPTION_MFE);
+    bytes         += mfe_matrices_size(mx_type, length, window_size, alloc_vector, md_copy.gquad);
+  }
+
+  if (options & VRNA_OPTION_PF) {
+    alloc_vector  = get_mx_alloc_vector(&md_copy,
+                                        mx_type,
+                                        (options & ~(VRNA_OPTION_MFE | VRNA_OPTION_HYBRID)) |
+                                        VRNA_OPTION_PF);
+    bytes         += pf_matrices_size(mx_type, length, window_size, alloc_vector, md_copy.gquad);
+  }
+
+  return bytes;
+}
+
+
+PUBLIC void
+vrna_mx_memory_budget_set(size_t bytes)
+{
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&mx_memory_mtx);
+#endif
+
+  mx_memory_budget = bytes;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&mx_memory_mtx);
+#endif
+}
+
+
+PUBLIC size_t
+vrna_mx_memory_budget(void)
+{
+  return mx_memory_budget;
+}
+
+
+PUBLIC size_t
+vrna_mx_memory_used(void)
+{
+  size_t used;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&mx_memory_mtx);
+#endif
+
+  used = mx_memory_used;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&mx_memory_mtx);
+#endif
+
+  return used;
+}
+
+
+int
+vrna_mx_TwoD_reserve(vrna_fold_compound_t *fc,
+                     unsigned int         options)
+{
+  unsigned int  alloc_vector;
+  size_t        bytes, *reserved;
+
+  if ((!fc) || (!fc->mm1) || (!fc->mm2))
+    return 1;
+
+  if (options & VRNA_OPTION_PF) {
+    if ((!fc->exp_matrices) || (fc->exp_matrices->type != VRNA_MX_2DFOLD))
+      return 1;
+
+    alloc_vector  = get_mx_pf_alloc_vector_current(fc->exp_matrices, VRNA_MX_2DFOLD);
+    bytes         = pf_matrices_size(VRNA_MX_2DFOLD, fc->length, fc->length, alloc_vector, 0) +
+                    distance_classes_size(fc, alloc_vector, sizeof(FLT_OR_DBL));
+    reserved      = &(fc->exp_matrices->bytes);
+  } else {
+    if ((!fc->matrices) || (fc->matrices->type != VRNA_MX_2DFOLD))
+      return 1;
+
+    alloc_vector  = get_mx_mfe_alloc_vector_current(fc->matrices, VRNA_MX_2DFOLD);
+    bytes         = mfe_matrices_size(VRNA_MX_2DFOLD,
+                                      fc->length,
+                                      fc->length,
+                                      alloc_vector,
+                                      fc->params->model_details.gquad) +
+                    distance_classes_size(fc, alloc_vector, sizeof(int));
+    reserved = &(fc->matrices->bytes);
+  }
+
+  /* replace the previous reservation of the matrices */
+  if (bytes > *reserved) {
+    if (!mx_memory_reserve(bytes - *reserved)) {
+      vrna_message_warning("vrna_mx_TwoD_reserve: "
+                           "distance classes of up to %lu bytes exceed the memory budget "
+                           "(%lu of %lu bytes in use)",
+                           (unsigned long)(bytes - *reserved),
+                           (unsigned long)vrna_mx_memory_used(),
+                           (unsigned long)vrna_mx_memory_budget());
+      return 0;
+    }
+  } else {
+    mx_memory_release(*reserved - bytes);
+  }
+
+  *reserved = bytes;
+
+  return 1;
+}
+
+
 /*
  #####################################
  # BEGIN OF STATIC HELPER FUNCTIONS  #
@@ -415,6 +668,27 @@ get_mx_mfe_alloc_vector_current(vrna_mx_mfe_t   *mx,
 
         break;
 
+      case VRNA_MX_2DFOLD:
+        if (mx->E_F5)
+          mx_alloc_vector |= ALLOC_F5;
+
+        if (mx->E_F3)
+          mx_alloc_vector |= ALLOC_F3;
+
+        if (mx->E_C)
+          mx_alloc_vector |= ALLOC_C;
+
+        if (mx->E_M)
+          mx_alloc_vector |= ALLOC_FML;
+
+        if (mx->E_M1)
+          mx_alloc_vector |= ALLOC_UNIQ;
+
+        if (mx->E_M2)
+          mx_alloc_vector |= ALLOC_CIRC;
+
+        break;
+
       default:
         break;
     }
@@ -456,6 +730,24 @@ get_mx_pf_alloc_vector_current(vrna_mx_pf_t   *mx,
 
         break;
 
+      case VRNA_MX_2DFOLD:
+        if (mx->Q)
+          mx_alloc_vector |= ALLOC_F;
+
+        if (mx->Q_B)
+          mx_alloc_vector |= ALLOC_C;
+
+        if (mx->Q_M)
+          mx_alloc_vector |= ALLOC_FML;
+
+        if (mx->Q_M1)
+          mx_alloc_vector |= ALLOC_UNIQ;
+
+        if (mx->Q_M2)
+          mx_alloc_vector |= ALLOC_CIRC;
+
+        break;
+
       default:
         break;
     }
@@ -470,7 +762,25 @@ add_pf_matrices(vrna_fold_compound_t  *vc,
                 vrna_mx_type_e        mx_type,
                 unsigned int          alloc_vector)
 {
+  size_t bytes;
+
   if (vc) {
+    bytes = pf_matrices_size(mx_type,
+                             vc->length,
+                             vc->window_size,
+                             alloc_vector,
+                             vc->exp_params->model_details.gquad);
+
+    if (!mx_memory_reserve(bytes)) {
+      vrna_message_warning("add_pf_matrices: "
+                           "DP matrices of %lu bytes exceed the memory budget "
+                           "(%lu of %lu bytes in use)",
+                           (unsigned long)bytes,
+                           (unsigned long)vrna_mx_memory_used(),
+                           (unsigned long)vrna_mx_memory_budget());
+      return 0;
+    }
+
     switch (mx_type) {
       case VRNA_MX_WINDOW:
         vc->exp_matrices = get_pf_matrices_alloc(vc->length,
@@ -486,8 +796,12 @@ add_pf_matrices(vrna_fold_compound_t  *vc,
         break;
     }
 
-    if (!vc->exp_matrices)
+    if (!vc->exp_matrices) {
+      mx_memory_release(bytes);
       return 0;
+    }
+
+    vc->exp_matrices->bytes = bytes;
 
     if (vc->exp_params->model_details.gquad) {
       switch (vc->type) {
@@ -502,6 +816,12 @@ add_pf_matrices(vrna_fold_compound_t  *vc,
       }
     }
 
+#ifdef VRNA_WITH_TIMING
+    if (vc->timing)
+      timing_pf_matrices(vc);
+
+#endif
+
     vrna_exp_params_rescale(vc, NULL);
   }
 
@@ -514,7 +834,25 @@ add_mfe_matrices(vrna_fold_compound_t *vc,
                  vrna_mx_type_e       mx_type,
                  unsigned int         alloc_vector)
 {
+  size_t bytes;
+
   if (vc) {
+    bytes = mfe_matrices_size(mx_type,
+                              vc->length,
+                              vc->window_size,
+                              alloc_vector,
+                              vc->params->model_details.gquad);
+
+    if (!mx_memory_reserve(bytes)) {
+      vrna_message_warning("add_mfe_matrices: "
+                           "DP matrices of %lu bytes exceed the memory budget "
+                           "(%lu of %lu bytes in use)",
+                           (unsigned long)bytes,
+                           (unsigned long)vrna_mx_memory_used(),
+                           (unsigned long)vrna_mx_memory_budget());
+      return 0;
+    }
+
     switch (mx_type) {
       case VRNA_MX_WINDOW:
         vc->matrices = get_mfe_matrices_alloc(vc->length, vc->window_size, mx_type, alloc_vector);
@@ -524,8 +862,12 @@ add_mfe_matrices(vrna_fold_compound_t *vc,
         break;
     }
 
-    if (!vc->matrices)
+    if (!vc->matrices) {
+      mx_memory_release(bytes);
       return 0;
+    }
+
+    vc->matrices->bytes = bytes;
 
     if (vc->params->model_details.gquad) {
       switch (vc->type) {
@@ -555,12 +897,571 @@ add_mfe_matrices(vrna_fold_compound_t *vc,
           break;
       }
     }
+
+#ifdef VRNA_WITH_TIMING
+    if (vc->timing)
+      timing_mfe_matrices(vc);
+
+#endif
   }
 
   return 1;
 }
 
 
+#ifdef VRNA_WITH_TIMING
+
+void
+vrna_timing_mx_current(vrna_fold_compound_t *fc)
+{
+  if (fc->matrices)
+    timing_mfe_matrices(fc);
+
+  if (fc->exp_matrices)
+    timing_pf_matrices(fc);
+}
+
+
+/* record the memory allocated for each matrix, rows of local partition function matrices are counted in LPfold.c */
+PRIVATE void
+timing_mfe_matrices(vrna_fold_compound_t *vc)
+{
+  size_t        size, lin_size;
+  vrna_mx_mfe_t *mx;
+
+  mx        = vc->matrices;
+  size      = ((size_t)(mx->length + 1) * (size_t)(mx->length + 2)) / 2;
+  lin_size  = (size_t)mx->length + 2;
+
+  switch (mx->type) {
+    case VRNA_MX_DEFAULT:
+      VRNA_TIMING_MX(vc, "f5", (mx->f5) ? sizeof(int) * lin_size : 0);
+      VRNA_TIMING_MX(vc, "f3", (mx->f3) ? sizeof(int) * lin_size : 0);
+      VRNA_TIMING_MX(vc, "fc", (mx->fc) ? sizeof(int) * lin_size : 0);
+      VRNA_TIMING_MX(vc, "c", (mx->c) ? sizeof(int) * size : 0);
+      VRNA_TIMING_MX(vc, "fML", (mx->fML) ? sizeof(int) * size : 0);
+      VRNA_TIMING_MX(vc, "fM1", (mx->fM1) ? sizeof(int) * size : 0);
+      VRNA_TIMING_MX(vc, "fM2", (mx->fM2) ? sizeof(int) * lin_size : 0);
+      break;
+
+    case VRNA_MX_WINDOW:
+      VRNA_TIMING_MX(vc, "f3_local", (mx->f3_local) ? sizeof(int) * lin_size : 0);
+      VRNA_TIMING_MX(vc, "c_local", (mx->c_local) ? sizeof(int *) * lin_size : 0);
+      VRNA_TIMING_MX(vc, "fML_local", (mx->fML_local) ? sizeof(int *) * lin_size : 0);
+      break;
+
+    default:
+      break;
+  }
+}
+
+
+PRIVATE void
+timing_pf_matrices(vrna_fold_compound_t *vc)
+{
+  size_t        size, lin_size;
+  vrna_mx_pf_t  *mx;
+
+  mx        = vc->exp_matrices;
+  size      = ((size_t)(mx->length + 1) * (size_t)(mx->length + 2)) / 2;
+  lin_size  = (size_t)mx->length + 2;
+
+  switch (mx->type) {
+    case VRNA_MX_DEFAULT:
+      VRNA_TIMING_MX(vc, "q", (mx->q) ? sizeof(FLT_OR_DBL) * size : 0);
+      VRNA_TIMING_MX(vc, "qb", (mx->qb) ? sizeof(FLT_OR_DBL) * size : 0);
+      VRNA_TIMING_MX(vc, "qm", (mx->qm) ? sizeof(FLT_OR_DBL) * size : 0);
+      VRNA_TIMING_MX(vc, "qm1", (mx->qm1) ? sizeof(FLT_OR_DBL) * size : 0);
+      VRNA_TIMING_MX(vc, "qm2", (mx->qm2) ? sizeof(FLT_OR_DBL) * lin_size : 0);
+      VRNA_TIMING_MX(vc, "probs", (mx->probs) ? sizeof(FLT_OR_DBL) * size : 0);
+      VRNA_TIMING_MX(vc, "q1k", (mx->q1k) ? sizeof(FLT_OR_DBL) * lin_size : 0);
+      VRNA_TIMING_MX(vc, "qln", (mx->qln) ? sizeof(FLT_OR_DBL) * lin_size : 0);
+      break;
+
+    case VRNA_MX_WINDOW:
+      VRNA_TIMING_MX(vc, "q_local", (mx->q_local) ? sizeof(FLT_OR_DBL *) * lin_size : 0);
+      VRNA_TIMING_MX(vc, "qb_local", (mx->qb_local) ? sizeof(FLT_OR_DBL *) * lin_size : 0);
+      VRNA_TIMING_MX(vc, "qm_local", (mx->qm_local) ? sizeof(FLT_OR_DBL *) * lin_size : 0);
+      VRNA_TIMING_MX(vc, "qm2_local", (mx->qm2_local) ? sizeof(FLT_OR_DBL *) * lin_size : 0);
+      VRNA_TIMING_MX(vc, "pR", (mx->pR) ? sizeof(FLT_OR_DBL *) * lin_size : 0);
+      break;
+
+    default:
+      break;
+  }
+
+  VRNA_TIMING_MX(vc, "scale", (mx->scale) ? sizeof(FLT_OR_DBL) * lin_size : 0);
+  VRNA_TIMING_MX(vc, "expMLbase", (mx->expMLbase) ? sizeof(FLT_OR_DBL) * lin_size : 0);
+}
+
+
+#endif
+
+
+/*
+ *  The functions below mirror the allocations in the *_alloc_* functions,
+ *  including the G-Quadruplex matrices and the rows of local folding
+ *  matrices that are allocated elsewhere
+ */
+PRIVATE size_t
+mfe_matrices_size(vrna_mx_type_e  type,
+                  unsigned int    n,
+                  unsigned int    window_size,
+                  unsigned int    alloc_vector,
+                  int             gquad)
+{
+  size_t bytes, size, lin_size, rows, cols, cell;
+
+  bytes     = sizeof(vrna_mx_mfe_t);
+  size      = ((size_t)(n + 1) * (size_t)(n + 2)) / 2;
+  lin_size  = (size_t)n + 2;
+
+  switch (type) {
+    case VRNA_MX_DEFAULT:
+      if (alloc_vector & ALLOC_F5)
+        bytes += sizeof(int) * lin_size;
+
+      if (alloc_vector & ALLOC_F3)
+        bytes += sizeof(int) * lin_size;
+
+      if (alloc_vector & ALLOC_HYBRID)
+        bytes += sizeof(int) * lin_size;
+
+      if (alloc_vector & ALLOC_C)
+        bytes += sizeof(int) * size;
+
+      if (alloc_vector & ALLOC_FML)
+        bytes += sizeof(int) * size;
+
+      if (alloc_vector & ALLOC_UNIQ)
+        bytes += sizeof(int) * size;
+
+      if (alloc_vector & ALLOC_CIRC)
+        bytes += sizeof(int) * lin_size;
+
+      if (gquad) /* see get_gquad_matrix() */
+        bytes += sizeof(int) * (((size_t)n * (size_t)(n + 1)) / 2 + 2);
+
+      break;
+
+    case VRNA_MX_WINDOW:
+      /* rows of c and fML are allocated in mfe_window.c */
+      cols  = (size_t)MIN2(window_size, n) + 5;
+      rows  = MIN2(cols, (size_t)n + 1);
+
+      if (alloc_vector & ALLOC_F3)
+        bytes += sizeof(int) * lin_size;
+
+      if (alloc_vector & ALLOC_C)
+        bytes += sizeof(int *) * lin_size + sizeof(int) * rows * cols;
+
+      if (alloc_vector & ALLOC_FML)
+        bytes += sizeof(int *) * lin_size + sizeof(int) * rows * cols;
+
+      break;
+
+    case VRNA_MX_2DFOLD:
+      /* energies, bounds of l, bounds of k, and remaining energy of each cell */
+      cell = sizeof(int **) + 2 * sizeof(int *) + 3 * sizeof(int);
+
+      if (alloc_vector & ALLOC_F5)
+        bytes += cell * lin_size;
+
+      if (alloc_vector & ALLOC_F3)
+        bytes += cell * lin_size;
+
+      if (alloc_vector & ALLOC_C)
+        bytes += cell * size;
+
+      if (alloc_vector & ALLOC_FML)
+        bytes += cell * size;
+
+      if (alloc_vector & ALLOC_UNIQ)
+        bytes += cell * size;
+
+      if (alloc_vector & ALLOC_CIRC)
+        bytes += cell * lin_size;
+
+      if (gquad)
+        bytes += sizeof(int) * (((size_t)n * (size_t)(n + 1)) / 2 + 2);
+
+      break;
+
+    default:
+      break;
+  }
+
+  return bytes;
+}
+
+
+PRIVATE size_t
+pf_matrices_size(vrna_mx_type_e type,
+                 unsigned int   n,
+                 unsigned int   window_size,
+                 unsigned int   alloc_vector,
+                 int            gquad)
+{
+  size_t bytes, size, lin_size, rows, cols, cell;
+
+  size      = ((size_t)(n + 1) * (size_t)(n + 2)) / 2;
+  lin_size  = (size_t)n + 2;
+  /* the struct itself, scale, and expMLbase */
+  bytes     = sizeof(vrna_mx_pf_t) + 2 * sizeof(FLT_OR_DBL) * lin_size;
+
+  switch (type) {
+    case VRNA_MX_DEFAULT:
+      if (alloc_vector & ALLOC_F)
+        bytes += sizeof(FLT_OR_DBL) * size;
+
+      if (alloc_vector & ALLOC_C)
+        bytes += sizeof(FLT_OR_DBL) * size;
+
+      if (alloc_vector & ALLOC_FML)
+        bytes += sizeof(FLT_OR_DBL) * size;
+
+      if (alloc_vector & ALLOC_UNIQ)
+        bytes += sizeof(FLT_OR_DBL) * size;
+
+      if (alloc_vector & ALLOC_CIRC)
+        bytes += sizeof(FLT_OR_DBL) * lin_size;
+
+      if (alloc_vector & ALLOC_PROBS)
+        bytes += sizeof(FLT_OR_DBL) * size;
+
+      if (alloc_vector & ALLOC_AUX)
+        bytes += 2 * sizeof(FLT_OR_DBL) * lin_size;
+
+      if (gquad) /* see get_gquad_pf_matrix(), allocated in vrna_pf() */
+        bytes += sizeof(FLT_OR_DBL) * (((size_t)n * (size_t)(n + 1)) / 2 + 2);
+
+      break;
+
+    case VRNA_MX_WINDOW:
+      /* rows are allocated in LPfold.c, which keeps at most 2 * winSize + MAXLOOP + 2 of them */
+      cols  = (size_t)MIN2(window_size, n) + 1;
+      rows  = MIN2((size_t)n, 2 * (cols - 1) + MAXLOOP + 2);
+
+      if (alloc_vector & ALLOC_F)
+        bytes += sizeof(FLT_OR_DBL *) * lin_size + sizeof(FLT_OR_DBL) * rows * cols;
+
+      if (alloc_vector & ALLOC_C)
+        bytes += sizeof(FLT_OR_DBL *) * lin_size + sizeof(FLT_OR_DBL) * rows * cols;
+
+      if (alloc_vector & ALLOC_FML)
+        bytes += sizeof(FLT_OR_DBL *) * lin_size + sizeof(FLT_OR_DBL) * rows * cols;
+
+      /* pR */
+      bytes += sizeof(FLT_OR_DBL *) * lin_size + sizeof(FLT_OR_DBL) * rows * cols;
+
+      /* QI5, qmb, qm2_local, and q2l, rows only if unpaired probabilities are requested */
+      if (alloc_vector & ALLOC_PROBS)
+        bytes += 4 * (sizeof(FLT_OR_DBL *) * lin_size + sizeof(FLT_OR_DBL) * rows * cols);
+
+      break;
+
+    case VRNA_MX_2DFOLD:
+      /* partition functions, bounds of l, bounds of k, and remaining partition function of each cell */
+      cell = sizeof(FLT_OR_DBL **) + 2 * sizeof(int *) + 2 * sizeof(int) + sizeof(FLT_OR_DBL);
+
+      if (alloc_vector & ALLOC_F)
+        bytes += cell * size;
+
+      if (alloc_vector & ALLOC_C)
+        bytes += cell * size;
+
+      if (alloc_vector & ALLOC_FML)
+        bytes += cell * size;
+
+      if (alloc_vector & ALLOC_UNIQ)
+        bytes += cell * size;
+
+      if (alloc_vector & ALLOC_CIRC)
+        bytes += cell * lin_size;
+
+      break;
+
+    default:
+      break;
+  }
+
+  return bytes;
+}
+
+
+/*
+ *  Upper bound for the distance class blocks of the 2D folding matrices that
+ *  2Dfold.c and 2Dpfold.c allocate on demand, one block per matrix cell
+ */
+PRIVATE size_t
+distance_classes_size(vrna_fold_compound_t  *fc,
+                      unsigned int          alloc_vector,
+                      size_t                elem_size)
+{
+  unsigned int  i, j, n, num_tri;
+  size_t        bytes;
+
+  n       = fc->length;
+  bytes   = 0;
+  num_tri = ((alloc_vector & ALLOC_F) ? 1 : 0) +
+            ((alloc_vector & ALLOC_C) ? 1 : 0) +
+            ((alloc_vector & ALLOC_FML) ? 1 : 0) +
+            ((alloc_vector & ALLOC_UNIQ) ? 1 : 0);
+
+  for (i = 1; i <= n; i++) {
+    for (j = i; j <= n; j++)
+      bytes += num_tri * distance_class_block_size(fc, i, j, elem_size);
+
+    /* E_F5[i], E_F3[i], and E_M2[i] or Q_M2[i] */
+    if (alloc_vector & ALLOC_F5)
+      bytes += distance_class_block_size(fc, 1, i, elem_size);
+
+    if (alloc_vector & ALLOC_F3)
+      bytes += distance_class_block_size(fc, i, n, elem_size);
+
+    if (alloc_vector & ALLOC_CIRC)
+      bytes += distance_class_block_size(fc, i, n, elem_size);
+  }
+
+  /* the exterior loop decompositions of circular RNAs */
+  if (alloc_vector & ALLOC_CIRC)
+    bytes += 4 * distance_class_block_size(fc, 1, n, elem_size);
+
+  return bytes;
+}
+
+
+/*
+ *  Distance class block of cell [i,j]. Its k-range is bounded by the maximum
+ *  matching mm1 plus the base pairs of reference 1 within the cell, but rows
+ *  with k > maxD1 hold a single entry only. The l-range of the other rows is
+ *  bounded likewise and by maxD2, where only every other l is stored. Cells
+ *  too small to enclose a base pair only hold the class (0,0)
+ */
+PRIVATE size_t
+distance_class_block_size(vrna_fold_compound_t  *fc,
+                          unsigned int          i,
+                          unsigned int          j,
+                          size_t                elem_size)
+{
+  int     ij;
+  size_t  k_num, k_in_scope, l_max, l_num;
+
+  if (j <= i + TURN)
+    return sizeof(void *) + 2 * sizeof(int) + elem_size;
+
+  ij          = fc->iindx[i] - j;
+  k_num       = (size_t)fc->mm1[ij] + (size_t)fc->referenceBPs1[ij] + 1;
+  k_in_scope  = MIN2(k_num, (size_t)fc->maxD1 + 1);
+  l_max       = MIN2((size_t)fc->mm2[ij] + (size_t)fc->referenceBPs2[ij], (size_t)fc->maxD2);
+  l_num       = (l_max + 1) / 2 + 1;
+
+  /* row pointers, their alignment padding, bounds of l, and the rows */
+  return k_num * (sizeof(void *) + 2 * sizeof(int)) + elem_size +
+         elem_size * (k_in_scope * l_num + (k_num - k_in_scope));
+}
+
+
+PRIVATE int
+mx_memory_reserve(size_t bytes)
+{
+  int ret = 1;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&mx_memory_mtx);
+#endif
+
+  if ((mx_memory_budget > 0) &&
+      ((bytes > mx_memory_budget) || (mx_memory_used > mx_memory_budget - bytes)))
+    ret = 0;
+  else
+    mx_memory_used += bytes;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&mx_memory_mtx);
+#endif
+
+  return ret;
+}
+
+
+PRIVATE void
+mx_memory_release(size_t bytes)
+{
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&mx_memory_mtx);
+#endif
+
+  mx_memory_used = (bytes < mx_memory_used) ? mx_memory_used - bytes : 0;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&mx_memory_mtx);
+#endif
+}
+
+
+/* find the entry of referenced DP matrices, call with mx_refs_mtx locked */
+PRIVATE mx_reference_t *
+mx_reference(void *mx)
+{
+  unsigned int i;
+
+  for (i = 0; i < mx_refs_num; i++)
+    if (mx_refs[i].mx == mx)
+      return &(mx_refs[i]);
+
+  return NULL;
+}
+
+
+PRIVATE void
+mx_ref(void *mx)
+{
+  mx_reference_t *r;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&mx_refs_mtx);
+#endif
+
+  if ((r = mx_reference(mx))) {
+    r->refs++;
+  } else {
+    if (mx_refs_num == mx_refs_size) {
+      mx_refs_size  = (mx_refs_size > 0) ? 2 * mx_refs_size : 8;
+      mx_refs       = (mx_reference_t *)vrna_realloc(mx_refs, sizeof(mx_reference_t) * mx_refs_size);
+    }
+
+    mx_refs[mx_refs_num].mx       = mx;
+    mx_refs[mx_refs_num].refs     = 1;
+    mx_refs[mx_refs_num].released = 0;
+    mx_refs_num++;
+  }
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&mx_refs_mtx);
+#endif
+}
+
+
+/* drop a reference, returns non-zero if the matrices are to be freed by the caller */
+PRIVATE int
+mx_unref(void *mx)
+{
+  int             ret;
+  mx_reference_t  *r;
+
+  ret = 0;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&mx_refs_mtx);
+#endif
+
+  if ((r = mx_reference(mx)) && (--(r->refs) == 0)) {
+    ret = r->released;
+    *r  = mx_refs[--mx_refs_num];
+
+    if (mx_refs_num == 0) {
+      free(mx_refs);
+      mx_refs       = NULL;
+      mx_refs_size  = 0;
+    }
+  }
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&mx_refs_mtx);
+#endif
+
+  return ret;
+}
+
+
+/*
+ *  detach the matrices from their fold compound, returns non-zero if
+ *  they are not referenced and thus are to be freed by the caller
+ */
+PRIVATE int
+mx_release(void *mx)
+{
+  int             ret;
+  mx_reference_t  *r;
+
+  ret = 1;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&mx_refs_mtx);
+#endif
+
+  if ((r = mx_reference(mx))) {
+    r->released = 1;
+    ret         = 0;
+  }
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&mx_refs_mtx);
+#endif
+
+  return ret;
+}
+
+
+/*
+ *  the fold compound is only required for matrices other than
+ *  VRNA_MX_DEFAULT, which can not be referenced by vrna_mx_mfe_ref()
+ */
+PRIVATE void
+mfe_matrices_free(vrna_mx_mfe_t         *self,
+                  vrna_fold_compound_t  *vc)
+{
+  switch (self->type) {
+    case VRNA_MX_DEFAULT:
+      mfe_matrices_free_default(self);
+      break;
+
+    case VRNA_MX_WINDOW:
+      mfe_matrices_free_window(self, vc->length, vc->window_size);
+      break;
+
+    case VRNA_MX_2DFOLD:
+      mfe_matrices_free_2Dfold(self, vc->length, vc->iindx);
+      break;
+
+    default:                /* do nothing */
+      break;
+  }
+  mx_memory_release(self->bytes);
+  free(self);
+}
+
+
+PRIVATE void
+pf_matrices_free(vrna_mx_pf_t         *self,
+                 vrna_fold_compound_t *vc)
+{
+  switch (self->type) {
+    case VRNA_MX_DEFAULT:
+      pf_matrices_free_default(self);
+      break;
+
+    case VRNA_MX_WINDOW:
+      pf_matrices_free_window(self, vc->length, vc->window_size);
+      break;
+
+    case VRNA_MX_2DFOLD:
+      pf_matrices_free_2Dfold(self, vc->length, vc->iindx, vc->jindx);
+      break;
+
+    default:                /* do nothing */
+      break;
+  }
+
+  free(self->expMLbase);
+  free(self->scale);
+
+  mx_memory_release(self->bytes);
+  free(self);
+}
+
+
 PRIVATE vrna_mx_mfe_t *
 get_mfe_matrices_alloc(unsigned int   n,
                        unsigned int   m,
@@ -927,7 +1828,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
                          int            *indx)
 {
   unsigned int  i, j, ij;
-  int           cnt1;
 
   /* This will be some fun... */
 #ifdef COUNT_STATES
@@ -936,18 +1836,12 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
       if (!self->N_F5[i])
         continue;
 
-      for (cnt1 = self->k_min_F5[i]; cnt1 <= vars->k_max_F5[i]; cnt1++)
-        if (vars->l_min_F5[i][cnt1] < INF) {
-          vars->N_F5[i][cnt1] += vars->l_min_F5[i][cnt1] / 2;
-          free(vars->N_F5[i][cnt1]);
-        }
-
-      if (vars->k_min_F5[i] < INF) {
-        vars->N_F5[i] += vars->k_min_F5[i];
-        free(vars->N_F5[i]);
+      if (self->k_min_F5[i] < INF) {
+        self->N_F5[i] += self->k_min_F5[i];
+        free(self->N_F5[i]);
       }
     }
-    free(vars->N_F5);
+    free(self->N_F5);
   }
 
 #endif
@@ -957,12 +1851,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
       if (!self->E_F5[i])
         continue;
 
-      for (cnt1 = self->k_min_F5[i]; cnt1 <= self->k_max_F5[i]; cnt1++)
-        if (self->l_min_F5[i][cnt1] < INF) {
-          self->E_F5[i][cnt1] += self->l_min_F5[i][cnt1] / 2;
-          free(self->E_F5[i][cnt1]);
-        }
-
       if (self->k_min_F5[i] < INF) {
         self->E_F5[i] += self->k_min_F5[i];
         free(self->E_F5[i]);
@@ -984,12 +1872,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
       if (!self->E_F3[i])
         continue;
 
-      for (cnt1 = self->k_min_F3[i]; cnt1 <= self->k_max_F3[i]; cnt1++)
-        if (self->l_min_F3[i][cnt1] < INF) {
-          self->E_F3[i][cnt1] += self->l_min_F3[i][cnt1] / 2;
-          free(self->E_F3[i][cnt1]);
-        }
-
       if (self->k_min_F3[i] < INF) {
         self->E_F3[i] += self->k_min_F3[i];
         free(self->E_F3[i]);
@@ -1014,12 +1896,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
         if (!self->N_C[ij])
           continue;
 
-        for (cnt1 = self->k_min_C[ij]; cnt1 <= self->k_max_C[ij]; cnt1++)
-          if (self->l_min_C[ij][cnt1] < INF) {
-            self->N_C[ij][cnt1] += self->l_min_C[ij][cnt1] / 2;
-            free(self->N_C[ij][cnt1]);
-          }
-
         if (self->k_min_C[ij] < INF) {
           self->N_C[ij] += self->k_min_C[ij];
           free(self->N_C[ij]);
@@ -1038,12 +1914,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
         if (!self->E_C[ij])
           continue;
 
-        for (cnt1 = self->k_min_C[ij]; cnt1 <= self->k_max_C[ij]; cnt1++)
-          if (self->l_min_C[ij][cnt1] < INF) {
-            self->E_C[ij][cnt1] += self->l_min_C[ij][cnt1] / 2;
-            free(self->E_C[ij][cnt1]);
-          }
-
         if (self->k_min_C[ij] < INF) {
           self->E_C[ij] += self->k_min_C[ij];
           free(self->E_C[ij]);
@@ -1069,12 +1939,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
         if (!self->N_M[ij])
           continue;
 
-        for (cnt1 = self->k_min_M[ij]; cnt1 <= self->k_max_M[ij]; cnt1++)
-          if (self->l_min_M[ij][cnt1] < INF) {
-            self->N_M[ij][cnt1] += self->l_min_M[ij][cnt1] / 2;
-            free(self->N_M[ij][cnt1]);
-          }
-
         if (self->k_min_M[ij] < INF) {
           self->N_M[ij] += self->k_min_M[ij];
           free(self->N_M[ij]);
@@ -1093,12 +1957,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
         if (!self->E_M[ij])
           continue;
 
-        for (cnt1 = self->k_min_M[ij]; cnt1 <= self->k_max_M[ij]; cnt1++)
-          if (self->l_min_M[ij][cnt1] < INF) {
-            self->E_M[ij][cnt1] += self->l_min_M[ij][cnt1] / 2;
-            free(self->E_M[ij][cnt1]);
-          }
-
         if (self->k_min_M[ij] < INF) {
           self->E_M[ij] += self->k_min_M[ij];
           free(self->E_M[ij]);
@@ -1124,12 +1982,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
         if (!self->N_M1[ij])
           continue;
 
-        for (cnt1 = self->k_min_M1[ij]; cnt1 <= self->k_max_M1[ij]; cnt1++)
-          if (self->l_min_M1[ij][cnt1] < INF) {
-            self->N_M1[ij][cnt1] += self->l_min_M1[ij][cnt1] / 2;
-            free(self->N_M1[ij][cnt1]);
-          }
-
         if (self->k_min_M1[ij] < INF) {
           self->N_M1[ij] += self->k_min_M1[ij];
           free(self->N_M1[ij]);
@@ -1148,12 +2000,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
         if (!self->E_M1[ij])
           continue;
 
-        for (cnt1 = self->k_min_M1[ij]; cnt1 <= self->k_max_M1[ij]; cnt1++)
-          if (self->l_min_M1[ij][cnt1] < INF) {
-            self->E_M1[ij][cnt1] += self->l_min_M1[ij][cnt1] / 2;
-            free(self->E_M1[ij][cnt1]);
-          }
-
         if (self->k_min_M1[ij] < INF) {
           self->E_M1[ij] += self->k_min_M1[ij];
           free(self->E_M1[ij]);
@@ -1176,12 +2022,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
       if (!self->E_M2[i])
         continue;
 
-      for (cnt1 = self->k_min_M2[i]; cnt1 <= self->k_max_M2[i]; cnt1++)
-        if (self->l_min_M2[i][cnt1] < INF) {
-          self->E_M2[i][cnt1] += self->l_min_M2[i][cnt1] / 2;
-          free(self->E_M2[i][cnt1]);
-        }
-
       if (self->k_min_M2[i] < INF) {
         self->E_M2[i] += self->k_min_M2[i];
         free(self->E_M2[i]);
@@ -1199,12 +2039,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
   }
 
   if (self->E_Fc != NULL) {
-    for (cnt1 = self->k_min_Fc; cnt1 <= self->k_max_Fc; cnt1++)
-      if (self->l_min_Fc[cnt1] < INF) {
-        self->E_Fc[cnt1] += self->l_min_Fc[cnt1] / 2;
-        free(self->E_Fc[cnt1]);
-      }
-
     if (self->k_min_Fc < INF) {
       self->E_Fc += self->k_min_Fc;
       free(self->E_Fc);
@@ -1216,12 +2050,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
   }
 
   if (self->E_FcI != NULL) {
-    for (cnt1 = self->k_min_FcI; cnt1 <= self->k_max_FcI; cnt1++)
-      if (self->l_min_FcI[cnt1] < INF) {
-        self->E_FcI[cnt1] += self->l_min_FcI[cnt1] / 2;
-        free(self->E_FcI[cnt1]);
-      }
-
     if (self->k_min_FcI < INF) {
       self->E_FcI += self->k_min_FcI;
       free(self->E_FcI);
@@ -1233,12 +2061,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
   }
 
   if (self->E_FcH != NULL) {
-    for (cnt1 = self->k_min_FcH; cnt1 <= self->k_max_FcH; cnt1++)
-      if (self->l_min_FcH[cnt1] < INF) {
-        self->E_FcH[cnt1] += self->l_min_FcH[cnt1] / 2;
-        free(self->E_FcH[cnt1]);
-      }
-
     if (self->k_min_FcH < INF) {
       self->E_FcH += self->k_min_FcH;
       free(self->E_FcH);
@@ -1250,12 +2072,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
   }
 
   if (self->E_FcM != NULL) {
-    for (cnt1 = self->k_min_FcM; cnt1 <= self->k_max_FcM; cnt1++)
-      if (self->l_min_FcM[cnt1] < INF) {
-        self->E_FcM[cnt1] += self->l_min_FcM[cnt1] / 2;
-        free(self->E_FcM[cnt1]);
-      }
-
     if (self->k_min_FcM < INF) {
       self->E_FcM += self->k_min_FcM;
       free(self->E_FcM);
@@ -1501,7 +2317,6 @@ pf_matrices_free_2Dfold(vrna_mx_pf_t  *self,
                         int           *jindx)
 {
   unsigned int  i, j, ij;
-  int           cnt1;
 
   /* This will be some fun... */
   if (self->Q != NULL) {
@@ -1511,12 +2326,6 @@ pf_matrices_free_2Dfold(vrna_mx_pf_t  *self,
         if (!self->Q[ij])
           continue;
 
-        for (cnt1 = self->k_min_Q[ij]; cnt1 <= self->k_max_Q[ij]; cnt1++)
-          if (self->l_min_Q[ij][cnt1] < INF) {
-            self->Q[ij][cnt1] += self->l_min_Q[ij][cnt1] / 2;
-            free(self->Q[ij][cnt1]);
-          }
-
         if (self->k_min_Q[ij] < INF) {
           self->Q[ij] += self->k_min_Q[ij];
           free(self->Q[ij]);
@@ -1542,12 +2351,6 @@ pf_matrices_free_2Dfold(vrna_mx_pf_t  *self,
         if (!self->Q_B[ij])
           continue;
 
-        for (cnt1 = self->k_min_Q_B[ij]; cnt1 <= self->k_max_Q_B[ij]; cnt1++)
-          if (self->l_min_Q_B[ij][cnt1] < INF) {
-            self->Q_B[ij][cnt1] += self->l_min_Q_B[ij][cnt1] / 2;
-            free(self->Q_B[ij][cnt1]);
-          }
-
         if (self->k_min_Q_B[ij] < INF) {
           self->Q_B[ij] += self->k_min_Q_B[ij];
           free(self->Q_B[ij]);
@@ -1573,12 +2376,6 @@ pf_matrices_free_2Dfold(vrna_mx_pf_t  *self,
         if (!self->Q_M[ij])
           continue;
 
-        for (cnt1 = self->k_min_Q_M[ij]; cnt1 <= self->k_max_Q_M[ij]; cnt1++)
-          if (self->l_min_Q_M[ij][cnt1] < INF) {
-            self->Q_M[ij][cnt1] += self->l_min_Q_M[ij][cnt1] / 2;
-            free(self->Q_M[ij][cnt1]);
-          }
-
         if (self->k_min_Q_M[ij] < INF) {
           self->Q_M[ij] += self->k_min_Q_M[ij];
           free(self->Q_M[ij]);
@@ -1604,12 +2401,6 @@ pf_matrices_free_2Dfold(vrna_mx_pf_t  *self,
         if (!self->Q_M1[ij])
           continue;
 
-        for (cnt1 = self->k_min_Q_M1[ij]; cnt1 <= self->k_max_Q_M1[ij]; cnt1++)
-          if (self->l_min_Q_M1[ij][cnt1] < INF) {
-            self->Q_M1[ij][cnt1] += self->l_min_Q_M1[ij][cnt1] / 2;
-            free(self->Q_M1[ij][cnt1]);
-          }
-
         if (self->k_min_Q_M1[ij] < INF) {
           self->Q_M1[ij] += self->k_min_Q_M1[ij];
           free(self->Q_M1[ij]);
@@ -1633,12 +2424,6 @@ pf_matrices_free_2Dfold(vrna_mx_pf_t  *self,
       if (!self->Q_M2[i])
         continue;
 
-      for (cnt1 = self->k_min_Q_M2[i]; cnt1 <= self->k_max_Q_M2[i]; cnt1++)
-        if (self->l_min_Q_M2[i][cnt1] < INF) {
-          self->Q_M2[i][cnt1] += self->l_min_Q_M2[i][cnt1] / 2;
-          free(self->Q_M2[i][cnt1]);
-        }
-
       if (self->k_min_Q_M2[i] < INF) {
         self->Q_M2[i] += self->k_min_Q_M2[i];
         free(self->Q_M2[i]);
@@ -1657,12 +2442,6 @@ pf_matrices_free_2Dfold(vrna_mx_pf_t  *self,
   free(self->k_max_Q_M2);
 
   if (self->Q_c != NULL) {
-    for (cnt1 = self->k_min_Q_c; cnt1 <= self->k_max_Q_c; cnt1++)
-      if (self->l_min_Q_c[cnt1] < INF) {
-        self->Q_c[cnt1] += self->l_min_Q_c[cnt1] / 2;
-        free(self->Q_c[cnt1]);
-      }
-
     if (self->k_min_Q_c < INF) {
       self->Q_c += self->k_min_Q_c;
       free(self->Q_c);
@@ -1674,12 +2453,6 @@ pf_matrices_free_2Dfold(vrna_mx_pf_t  *self,
   }
 
   if (self->Q_cI != NULL) {
-    for (cnt1 = self->k_min_Q_cI; cnt1 <= self->k_max_Q_cI; cnt1++)
-      if (self->l_min_Q_cI[cnt1] < INF) {
-        self->Q_cI[cnt1] += self->l_min_Q_cI[cnt1] / 2;
-        free(self->Q_cI[cnt1]);
-      }
-
     if (self->k_min_Q_cI < INF) {
       self->Q_cI += self->k_min_Q_cI;
       free(self->Q_cI);
@@ -1691,12 +2464,6 @@ pf_matrices_free_2Dfold(vrna_mx_pf_t  *self,
   }
 
   if (self->Q_cH != NULL) {
-    for (cnt1 = self->k_min_Q_cH; cnt1 <= self->k_max_Q_cH; cnt1++)
-      if (self->l_min_Q_cH[cnt1] < INF) {
-        self->Q_cH[cnt1] += self->l_min_Q_cH[cnt1] / 2;
-        free(self->Q_cH[cnt1]);
-      }
-
     if (self->k_min_Q_cH < INF) {
       self->Q_cH += self->k_min_Q_cH;
       free(self->Q_cH);
@@ -1708,12 +2475,6 @@ pf_matrices_free_2Dfold(vrna_mx_pf_t  *self,
   }
 
   if (self->Q_cM != NULL) {
-    for (cnt1 = self->k_min_Q_cM; cnt1 <= self->k_max_Q_cM; cnt1++)
-      if (self->l_min_Q_cM[cnt1] < INF) {
-        self->Q_cM[cnt1] += self->l_min_Q_cM[cnt1] / 2;
-        free(self->Q_cM[cnt1]);
-      }
-
     if (self->k_min_Q_cM < INF) {
       self->Q_cM += self->k_min_Q_cM;
       free(self->Q_cM);
@@ -48,6 +48,7 @@ struct vrna_mx_mfe_s {
    */
   vrna_mx_type_e  type;
   unsigned int    length;  /**<  @brief  Length of the sequence, therefore an indicator of the size of the DP matrices */
+  size_t          bytes;   /**<  @brief  Memory reserved for the DP matrices, see vrna_mx_memory() */
   /**
    *  @}
    */
@@ -104,6 +105,8 @@ struct {
   /** @name Distance Class DP matrices
    *  @note These data fields are available if
    *        @code vrna_mx_mfe_t.type == VRNA_MX_2DFOLD @endcode
+   *        Each cell, e.g. @p E_C[ij], is a single memory block that starts with the
+   *        row pointers for all distance classes k, followed by the rows of distance classes l.
    * @{
    */
   int           ***E_F5;
@@ -206,6 +209,7 @@ struct vrna_mx_pf_s {
    */
   vrna_mx_type_e type;
   unsigned int length;
+  size_t bytes;           /**<  @brief  Memory reserved for the DP matrices, see vrna_mx_memory() */
   FLT_OR_DBL *scale;
   FLT_OR_DBL *expMLbase;
 
@@ -277,6 +281,8 @@ struct {
   /** @name Distance Class DP matrices
    *  @note These data fields are available if
    *        @code vrna_mx_pf_t.type == VRNA_MX_2DFOLD @endcode
+   *        Each cell, e.g. @p Q_B[ij], is a single memory block that starts with the
+   *        row pointers for all distance classes k, followed by the rows of distance classes l.
    *  @{
    */
   FLT_OR_DBL ***Q;
@@ -430,6 +436,141 @@ void
 vrna_mx_pf_free(vrna_fold_compound_t *vc);
 
 
+/**
+ *  @brief  Acquire a reference to the Minimum Free Energy (MFE) Dynamic Programming (DP) matrices
+ *
+ *  Matrices that are referenced are not released when the fold compound
+ *  frees or re-allocates them, e.g. in vrna_mx_prepare(). Instead, the fold
+ *  compound merely detaches them, and the memory is released once the last
+ *  reference is returned through vrna_mx_mfe_unref(). Thus, the arrays of a
+ *  referenced #vrna_mx_mfe_t stay valid, although they may no longer be
+ *  attached to @p fc. Matrices without references are released right away
+ *  as before. References may be acquired and returned concurrently to
+ *  computations on the fold compound.
+ *
+ *  Only matrices of type #VRNA_MX_DEFAULT can be referenced.
+ *
+ *  @see vrna_mx_mfe_unref(), vrna_mx_pf_ref()
+ *
+ *  @param  fc  The #vrna_fold_compound_t that holds the MFE DP matrices
+ *  @return     The referenced MFE DP matrices, or NULL if @p fc has no matrices of type #VRNA_MX_DEFAULT
+ */
+vrna_mx_mfe_t *
+vrna_mx_mfe_ref(vrna_fold_compound_t *fc);
+
+
+/**
+ *  @brief  Return a reference to the Minimum Free Energy (MFE) Dynamic Programming (DP) matrices
+ *
+ *  @see vrna_mx_mfe_ref()
+ *
+ *  @param  mx  The MFE DP matrices as obtained from vrna_mx_mfe_ref()
+ */
+void
+vrna_mx_mfe_unref(vrna_mx_mfe_t *mx);
+
+
+/**
+ *  @brief  Acquire a reference to the Partition Function (PF) Dynamic Programming (DP) matrices
+ *
+ *  @see vrna_mx_pf_unref(), vrna_mx_mfe_ref()
+ *
+ *  @param  fc  The #vrna_fold_compound_t that holds the PF DP matrices
+ *  @return     The referenced PF DP matrices, or NULL if @p fc has no matrices of type #VRNA_MX_DEFAULT
+ */
+vrna_mx_pf_t *
+vrna_mx_pf_ref(vrna_fold_compound_t *fc);
+
+
+/**
+ *  @brief  Return a reference to the Partition Function (PF) Dynamic Programming (DP) matrices
+ *
+ *  @see vrna_mx_pf_ref()
+ *
+ *  @param  mx  The PF DP matrices as obtained from vrna_mx_pf_ref()
+ */
+void
+vrna_mx_pf_unref(vrna_mx_pf_t *mx);
+
+
+/**
+ *  @brief  Predict the memory required by Dynamic Programming (DP) matrices
+ *
+ *  Returns the number of bytes that vrna_mx_add() reserves for the DP matrices
+ *  of a particular type, given the sequence length, the model details, and the
+ *  kind of computations specified in @p options, i.e. #VRNA_OPTION_MFE, #VRNA_OPTION_PF,
+ *  and #VRNA_OPTION_HYBRID. The prediction takes into account whether unique
+ *  multibranch loop decomposition (@p uniq_ML), G-Quadruplexes (@p gquad), circular
+ *  RNAs (@p circ), and base pair probabilities (@p compute_bpp) are requested in
+ *  the model details.
+ *
+ *  For #VRNA_MX_WINDOW, the rows of the matrices that are allocated while the
+ *  window slides along the sequence are included, assuming that unpaired
+ *  probabilities are computed as well. For #VRNA_MX_2DFOLD, only the
+ *  distance class independent part of the matrices is included, since the
+ *  memory of the individual distance classes is allocated on demand. Once
+ *  the maximum distances are known, vrna_mfe_TwoD() and vrna_pf_TwoD()
+ *  reserve an upper bound for the distance classes in addition.
+ *  G-Quadruplex matrices of the window approach, as well as any data
+ *  outside of the DP matrices, such as hard and soft constraints, are not
+ *  accounted for.
+ *
+ *  @see vrna_mx_memory_budget_set(), vrna_mx_memory_used()
+ *
+ *  @param  mx_type The type of DP matrices
+ *  @param  length  The length of the sequence (or alignment)
+ *  @param  md      The model details (may be NULL to use the defaults)
+ *  @param  options Option flags that specify the kind of DP matrices
+ *  @return         The number of bytes required for the DP matrices
+ */
+size_t
+vrna_mx_memory(vrna_mx_type_e   mx_type,
+               unsigned int     length,
+               const vrna_md_t  *md,
+               unsigned int     options);
+
+
+/**
+ *  @brief  Set a process-wide budget for the memory of Dynamic Programming (DP) matrices
+ *
+ *  Once a budget is set, the DP matrices of all #vrna_fold_compound_t of the
+ *  current process may occupy at most @p bytes of memory, as predicted by
+ *  vrna_mx_memory(). Requests for additional DP matrices that would exceed
+ *  the budget are rejected before any memory is allocated. Consequently,
+ *  vrna_mx_add(), vrna_mx_prepare(), and vrna_fold_compound_prepare() return 0,
+ *  and the prediction functions, e.g. vrna_mfe() or vrna_pf(), fail gracefully
+ *  instead of aborting the program.
+ *
+ *  @see vrna_mx_memory(), vrna_mx_memory_budget(), vrna_mx_memory_used()
+ *
+ *  @param  bytes The memory budget in bytes, or 0 for no limit (default)
+ */
+void
+vrna_mx_memory_budget_set(size_t bytes);
+
+
+/**
+ *  @brief  Get the process-wide budget for the memory of Dynamic Programming (DP) matrices
+ *
+ *  @see vrna_mx_memory_budget_set()
+ *
+ *  @return The memory budget in bytes, or 0 if no limit is set
+ */
+size_t
+vrna_mx_memory_budget(void);
+
+
+/**
+ *  @brief  Get the memory currently reserved by the Dynamic Programming (DP) matrices of all fold compounds
+ *
+ *  @see vrna_mx_memory_budget_set(), vrna_mx_memory()
+ *
+ *  @return The memory in bytes that is currently reserved for DP matrices
+ */
+size_t
+vrna_mx_memory_used(void);
+
+
 /**
  *  @}
  */
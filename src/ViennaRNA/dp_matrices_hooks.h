@@ -0,0 +1,29 @@
+#ifndef VIENNA_RNA_PACKAGE_DP_MATRICES_HOOKS_H
+#define VIENNA_RNA_PACKAGE_DP_MATRICES_HOOKS_H
+
+/*
+ *  Internal hooks into the DP matrix memory budget, see ViennaRNA/dp_matrices.h
+ */
+
+#include "ViennaRNA/fold_compound.h"
+
+/* the hooks are not part of the API, keep them out of the symbol table of shared objects */
+#if defined(__GNUC__) && !defined(_WIN32)
+# define VRNA_MX_INTERNAL __attribute__ ((visibility("hidden")))
+#else
+# define VRNA_MX_INTERNAL
+#endif
+
+/*
+ *  Reserve an upper bound for the distance class blocks of the 2D folding
+ *  matrices (options is either VRNA_OPTION_MFE or VRNA_OPTION_PF). The bound
+ *  follows from fc->maxD1, fc->maxD2 and the maximum matchings fc->mm1, fc->mm2,
+ *  and replaces any bound reserved for the same matrices before. Returns 0 if
+ *  the bound exceeds the memory budget.
+ */
+VRNA_MX_INTERNAL int
+vrna_mx_TwoD_reserve(vrna_fold_compound_t *fc,
+                     unsigned int         options);
+
+
+#endif
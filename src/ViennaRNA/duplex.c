@@ -21,7 +21,7 @@
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/fold.h"
-#include "ViennaRNA/pair_mat.h"
+#include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/alifold.h"
 #include "ViennaRNA/subopt.h"
@@ -40,27 +40,45 @@
 #define MINPSCORE -2 * UNIT
 #define NONE -10000         /* score for forbidden pairs */
 
+/* thread-local storage for builds that use POSIX threads but not OpenMP */
+#if !defined(_OPENMP) && VRNA_WITH_PTHREADS && defined(__GNUC__)
+# define DUPLEX_THREAD_LOCAL __thread
+#else
+# define DUPLEX_THREAD_LOCAL
+#endif
+
+struct vrna_duplex_context_s {
+  vrna_md_t     md;
+  vrna_param_t  *P;
+  int           **c;          /* energy array, given that i-j pair */
+  int           c_n1, c_n2;   /* dimensions the energy array is allocated for */
+  short         *S1, *SS1, *S2, *SS2;
+  int           n1, n2;       /* sequence lengths */
+};
 
 /*
  #################################
  # GLOBAL VARIABLES              #
  #################################
  */
+
 /*
  #################################
  # PRIVATE VARIABLES             #
  #################################
  */
-PRIVATE vrna_param_t  *P = NULL;
-PRIVATE int           **c = NULL;     /* energy array, given that i-j pair */
-PRIVATE short         *S1 = NULL, *SS1 = NULL, *S2 = NULL, *SS2 = NULL;
-PRIVATE int           n1, n2;         /* sequence lengths */
+
+/*
+ *  default context of the legacy functions duplexfold(), duplex_subopt(),
+ *  and their comparative variants, one for each thread
+ */
+PRIVATE DUPLEX_THREAD_LOCAL vrna_duplex_context_t *default_context = NULL;
 
 #ifdef _OPENMP
 
 /* NOTE: all variables are assumed to be uninitialized if they are declared as threadprivate
  */
-#pragma omp threadprivate(P, c, S1, SS1, S2, SS2, n1, n2)
+#pragma omp threadprivate(default_context)
 
 #endif
 
@@ -69,28 +87,45 @@ PRIVATE int           n1, n2;         /* sequence lengths */
  # PRIVATE FUNCTION DECLARATIONS #
  #################################
  */
+PRIVATE vrna_duplex_context_t *
+get_default_context(void);
+
+
+PRIVATE void
+matrices_prepare(vrna_duplex_context_t  *ctx,
+                 int                    n1,
+                 int                    n2);
+
+
+PRIVATE void
+matrices_free(vrna_duplex_context_t *ctx);
+
+
 PRIVATE duplexT
-duplexfold_cu(const char  *s1,
-              const char  *s2,
-              int         clean_up);
+duplexfold_cu(vrna_duplex_context_t *ctx,
+              const char            *s1,
+              const char            *s2,
+              int                   clean_up);
 
 
 PRIVATE duplexT
-aliduplexfold_cu(const char *s1[],
-                 const char *s2[],
-                 int        clean_up);
+aliduplexfold_cu(vrna_duplex_context_t  *ctx,
+                 const char             *s1[],
+                 const char             *s2[]);
 
 
 PRIVATE char *
-backtrack(int i,
-          int j);
+backtrack(vrna_duplex_context_t *ctx,
+          int                   i,
+          int                   j);
 
 
 PRIVATE char *
-alibacktrack(int          i,
-             int          j,
-             const short  **S1,
-             const short  **S2);
+alibacktrack(vrna_duplex_context_t  *ctx,
+             int                    i,
+             int                    j,
+             const short            **S1,
+             const short            **S2);
 
 
 PRIVATE int
@@ -108,49 +143,147 @@ covscore(const int  *types,
  # BEGIN OF FUNCTION DEFINITIONS #
  #################################
  */
+PUBLIC vrna_duplex_context_t *
+vrna_duplex_context(const vrna_md_t *md_p)
+{
+  vrna_duplex_context_t *ctx;
+
+  ctx = (vrna_duplex_context_t *)vrna_alloc(sizeof(vrna_duplex_context_t));
+
+  if (md_p)
+    vrna_md_copy(&(ctx->md), md_p);
+  else
+    set_model_details(&(ctx->md));
+
+  ctx->P = vrna_params(&(ctx->md));
+
+  return ctx;
+}
+
+
+PUBLIC void
+vrna_duplex_context_free(vrna_duplex_context_t *ctx)
+{
+  if (ctx) {
+    matrices_free(ctx);
+    free(ctx->P);
+    free(ctx);
+  }
+}
+
+
+PUBLIC duplexT
+vrna_duplexfold(vrna_duplex_context_t *ctx,
+                const char            *s1,
+                const char            *s2)
+{
+  return duplexfold_cu(ctx, s1, s2, 1);
+}
+
+
 PUBLIC duplexT
 duplexfold(const char *s1,
            const char *s2)
 {
-  return duplexfold_cu(s1, s2, 1);
+  duplexT               mfe;
+  vrna_duplex_context_t *ctx;
+
+  ctx = get_default_context();
+  mfe = duplexfold_cu(ctx, s1, s2, 1);
+  matrices_free(ctx);
+
+  return mfe;
+}
+
+
+PRIVATE vrna_duplex_context_t *
+get_default_context(void)
+{
+  /* re-use the energy parameters of this thread unless the temperature changed */
+  if ((!default_context) ||
+      (fabs(default_context->P->temperature - temperature) > 1e-6)) {
+    vrna_duplex_context_free(default_context);
+    default_context = vrna_duplex_context(NULL);
+  }
+
+  return default_context;
 }
 
 
-PRIVATE duplexT
-duplexfold_cu(const char  *s1,
-              const char  *s2,
-              int         clean_up)
+PRIVATE void
+matrices_prepare(vrna_duplex_context_t  *ctx,
+                 int                    n1,
+                 int                    n2)
 {
-  int       i, j, Emin = INF, i_min = 0, j_min = 0;
-  char      *struc;
-  duplexT   mfe;
-  vrna_md_t md;
+  int i;
 
-  n1  = (int)strlen(s1);
-  n2  = (int)strlen(s2);
+  ctx->n1 = n1;
+  ctx->n2 = n2;
 
-  set_model_details(&md);
-  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
-    if (P)
-      free(P);
+  /* keep the energy array of previous calls if it is large enough */
+  if ((ctx->c) && (n1 <= ctx->c_n1) && (n2 <= ctx->c_n2))
+    return;
 
-    P = vrna_params(&md);
-    make_pair_matrix();
-  }
+  matrices_free(ctx);
 
-  c = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
+  ctx->c = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
   for (i = 1; i <= n1; i++)
-    c[i] = (int *)vrna_alloc(sizeof(int) * (n2 + 1));
+    ctx->c[i] = (int *)vrna_alloc(sizeof(int) * (n2 + 1));
 
-  S1  = encode_sequence(s1, 0);
-  S2  = encode_sequence(s2, 0);
-  SS1 = encode_sequence(s1, 1);
-  SS2 = encode_sequence(s2, 1);
+  ctx->c_n1 = n1;
+  ctx->c_n2 = n2;
+}
+
+
+PRIVATE void
+matrices_free(vrna_duplex_context_t *ctx)
+{
+  int i;
+
+  if (ctx->c) {
+    for (i = 1; i <= ctx->c_n1; i++)
+      free(ctx->c[i]);
+    free(ctx->c);
+  }
+
+  ctx->c    = NULL;
+  ctx->c_n1 = 0;
+  ctx->c_n2 = 0;
+}
+
+
+PRIVATE duplexT
+duplexfold_cu(vrna_duplex_context_t *ctx,
+              const char            *s1,
+              const char            *s2,
+              int                   clean_up)
+{
+  int           i, j, n1, n2, Emin = INF, i_min = 0, j_min = 0;
+  int           **c, *rtype;
+  short         *S1, *SS1, *S2, *SS2;
+  char          *struc;
+  duplexT       mfe;
+  vrna_md_t     *md;
+  vrna_param_t  *P;
+
+  n1  = (int)strlen(s1);
+  n2  = (int)strlen(s2);
+
+  matrices_prepare(ctx, n1, n2);
+
+  P     = ctx->P;
+  md    = &(ctx->md);
+  rtype = &(md->rtype[0]);
+  c     = ctx->c;
+  S1    = ctx->S1 = vrna_seq_encode_simple(s1, md);
+  S2    = ctx->S2 = vrna_seq_encode_simple(s2, md);
+  SS1   = ctx->SS1 = vrna_seq_encode(s1, md);
+  SS2   = ctx->SS2 = vrna_seq_encode(s2, md);
 
   for (i = 1; i <= n1; i++) {
     for (j = n2; j > 0; j--) {
       int type, type2, E, k, l;
-      type    = pair[S1[i]][S2[j]];
+      type    = md->pair[S1[i]][S2[j]];
       c[i][j] = type ? P->DuplexInit : INF;
       if (!type)
         continue;
@@ -161,7 +294,7 @@ duplexfold_cu(const char  *s1,
           if (i - k + l - j - 2 > MAXLOOP)
             break;
 
-          type2 = pair[S1[k]][S2[l]];
+          type2 = md->pair[S1[k]][S2[l]];
           if (!type2)
             continue;
 
@@ -180,7 +313,7 @@ duplexfold_cu(const char  *s1,
     }
   }
 
-  struc = backtrack(i_min, j_min);
+  struc = backtrack(ctx, i_min, j_min);
   if (i_min < n1)
     i_min++;
 
@@ -192,13 +325,11 @@ duplexfold_cu(const char  *s1,
   mfe.energy    = (float)Emin / 100.;
   mfe.structure = struc;
   if (clean_up) {
-    for (i = 1; i <= n1; i++)
-      free(c[i]);
-    free(c);
-    free(S1);
-    free(S2);
-    free(SS1);
-    free(SS2);
+    free(ctx->S1);
+    free(ctx->S2);
+    free(ctx->SS1);
+    free(ctx->SS2);
+    ctx->S1 = ctx->S2 = ctx->SS1 = ctx->SS2 = NULL;
   }
 
   return mfe;
@@ -206,33 +337,94 @@ duplexfold_cu(const char  *s1,
 
 
 PUBLIC duplexT *
-duplex_subopt(const char  *s1,
-              const char  *s2,
-              int         delta,
-              int         w)
+duplexfold_batch(const char **s1,
+                 const char **s2,
+                 int        num_threads)
+{
+  int     n_s1, n_s2, n_pairs;
+  duplexT *results;
+
+  if ((!s1) || (!s2))
+    return NULL;
+
+  for (n_s1 = 0; s1[n_s1]; n_s1++) ;
+  for (n_s2 = 0; s2[n_s2]; n_s2++) ;
+
+  n_pairs = n_s1 * n_s2;
+  results = (duplexT *)vrna_alloc(sizeof(duplexT) * (n_pairs + 1));
+
+#ifdef _OPENMP
+  if (num_threads <= 0)
+    num_threads = omp_get_max_threads();
+
+#pragma omp parallel num_threads(num_threads)
+#endif
+  {
+    int                   i, k;
+    vrna_duplex_context_t *ctx;
+
+    /* each thread processes its pairs within its own context */
+    ctx = vrna_duplex_context(NULL);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (k = 0; k < n_pairs; k++) {
+      i           = k / n_s2;
+      results[k]  = vrna_duplexfold(ctx, s1[i], s2[k - i * n_s2]);
+    }
+
+    vrna_duplex_context_free(ctx);
+  }
+
+  /* mark end of list */
+  results[n_pairs].i          = 0;
+  results[n_pairs].j          = 0;
+  results[n_pairs].structure  = NULL;
+
+  return results;
+}
+
+
+PUBLIC duplexT *
+vrna_duplex_subopt(vrna_duplex_context_t  *ctx,
+                   const char             *s1,
+                   const char             *s2,
+                   int                    delta,
+                   int                    w)
 {
-  int     i, j, n1, n2, thresh, E, n_subopt = 0, n_max;
-  char    *struc;
-  duplexT mfe;
-  duplexT *subopt;
+  int       i, j, n1, n2, thresh, E, n_subopt = 0, n_max;
+  int       **c;
+  short     *S1, *SS1, *S2, *SS2;
+  char      *struc;
+  duplexT   mfe;
+  duplexT   *subopt;
+  vrna_md_t *md;
 
   n_max   = 16;
   subopt  = (duplexT *)vrna_alloc(n_max * sizeof(duplexT));
-  mfe     = duplexfold_cu(s1, s2, 0);
+  mfe     = duplexfold_cu(ctx, s1, s2, 0);
   free(mfe.structure);
 
+  md  = &(ctx->md);
+  c   = ctx->c;
+  S1  = ctx->S1;
+  S2  = ctx->S2;
+  SS1 = ctx->SS1;
+  SS2 = ctx->SS2;
+
   thresh  = (int)mfe.energy * 100 + 0.1 + delta;
   n1      = strlen(s1);
   n2      = strlen(s2);
   for (i = n1; i > 0; i--) {
     for (j = 1; j <= n2; j++) {
       int type, ii, jj, Ed;
-      type = pair[S2[j]][S1[i]];
+      type = md->pair[S2[j]][S1[i]];
       if (!type)
         continue;
 
       E   = Ed = c[i][j];
-      Ed  += E_ExtLoop(type, (j > 1) ? SS2[j - 1] : -1, (i < n1) ? SS1[i + 1] : -1, P);
+      Ed  += E_ExtLoop(type, (j > 1) ? SS2[j - 1] : -1, (i < n1) ? SS1[i + 1] : -1, ctx->P);
       if (Ed > thresh)
         continue;
 
@@ -250,7 +442,7 @@ duplex_subopt(const char  *s1,
       if (!type)
         continue;
 
-      struc = backtrack(i, j);
+      struc = backtrack(ctx, i, j);
       vrna_message_info(stderr, "%d %d %d", i, j, E);
       if (n_subopt + 1 >= n_max) {
         n_max   *= 2;
@@ -263,14 +455,12 @@ duplex_subopt(const char  *s1,
       subopt[n_subopt++].structure  = struc;
     }
   }
-  /* free all static globals */
-  for (i = 1; i <= n1; i++)
-    free(c[i]);
-  free(c);
-  free(S1);
-  free(S2);
-  free(SS1);
-  free(SS2);
+
+  free(ctx->S1);
+  free(ctx->S2);
+  free(ctx->SS1);
+  free(ctx->SS2);
+  ctx->S1 = ctx->S2 = ctx->SS1 = ctx->SS2 = NULL;
 
   if (subopt_sorted)
     qsort(subopt, n_subopt, sizeof(duplexT), compare);
@@ -282,14 +472,47 @@ duplex_subopt(const char  *s1,
 }
 
 
+PUBLIC duplexT *
+duplex_subopt(const char  *s1,
+              const char  *s2,
+              int         delta,
+              int         w)
+{
+  duplexT               *subopt;
+  vrna_duplex_context_t *ctx;
+
+  ctx     = get_default_context();
+  subopt  = vrna_duplex_subopt(ctx, s1, s2, delta, w);
+  matrices_free(ctx);
+
+  return subopt;
+}
+
+
 PRIVATE char *
-backtrack(int i,
-          int j)
+backtrack(vrna_duplex_context_t *ctx,
+          int                   i,
+          int                   j)
 {
   /* backtrack structure going backwards from i, and forwards from j
    * return structure in bracket notation with & as separator */
-  int   k, l, type, type2, E, traced, i0, j0;
-  char  *st1, *st2, *struc;
+  int           k, l, type, type2, E, traced, i0, j0, n1, n2;
+  int           **c, *rtype;
+  short         *S1, *SS1, *S2, *SS2;
+  char          *st1, *st2, *struc;
+  vrna_md_t     *md;
+  vrna_param_t  *P;
+
+  n1    = ctx->n1;
+  n2    = ctx->n2;
+  c     = ctx->c;
+  S1    = ctx->S1;
+  S2    = ctx->S2;
+  SS1   = ctx->SS1;
+  SS2   = ctx->SS2;
+  P     = ctx->P;
+  md    = &(ctx->md);
+  rtype = &(md->rtype[0]);
 
   st1 = (char *)vrna_alloc(sizeof(char) * (n1 + 1));
   st2 = (char *)vrna_alloc(sizeof(char) * (n2 + 1));
@@ -302,7 +525,7 @@ backtrack(int i,
     traced      = 0;
     st1[i - 1]  = '(';
     st2[j - 1]  = ')';
-    type        = pair[S1[i]][S2[j]];
+    type        = md->pair[S1[i]][S2[j]];
     if (!type)
       vrna_message_error("backtrack failed in fold duplex");
 
@@ -312,7 +535,7 @@ backtrack(int i,
         if (i - k + l - j - 2 > MAXLOOP)
           break;
 
-        type2 = pair[S1[k]][S2[l]];
+        type2 = md->pair[S1[k]][S2[l]];
         if (!type2)
           continue;
 
@@ -391,21 +614,30 @@ PUBLIC duplexT
 aliduplexfold(const char  *s1[],
               const char  *s2[])
 {
-  return aliduplexfold_cu(s1, s2, 1);
+  duplexT               mfe;
+  vrna_duplex_context_t *ctx;
+
+  ctx = get_default_context();
+  mfe = aliduplexfold_cu(ctx, s1, s2);
+  matrices_free(ctx);
+
+  return mfe;
 }
 
 
 PRIVATE duplexT
-aliduplexfold_cu(const char *s1[],
-                 const char *s2[],
-                 int        clean_up)
+aliduplexfold_cu(vrna_duplex_context_t  *ctx,
+                 const char             *s1[],
+                 const char             *s2[])
 {
-  int       i, j, s, n_seq, Emin = INF, i_min = 0, j_min = 0;
-  char      *struc;
-  duplexT   mfe;
-  short     **S1, **S2;
-  int       *type;
-  vrna_md_t md;
+  int           i, j, s, n_seq, n1, n2, Emin = INF, i_min = 0, j_min = 0;
+  int           **c, *rtype;
+  char          *struc;
+  duplexT       mfe;
+  short         **S1, **S2;
+  int           *type;
+  vrna_md_t     *md;
+  vrna_param_t  *P;
 
   n1  = (int)strlen(s1[0]);
   n2  = (int)strlen(s2[0]);
@@ -416,18 +648,12 @@ aliduplexfold_cu(const char *s1[],
   if (n_seq != s)
     vrna_message_error("unequal number of sequences in aliduplexfold()\n");
 
-  set_model_details(&md);
-  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
-    if (P)
-      free(P);
+  matrices_prepare(ctx, n1, n2);
 
-    P = vrna_params(&md);
-    make_pair_matrix();
-  }
-
-  c = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
-  for (i = 1; i <= n1; i++)
-    c[i] = (int *)vrna_alloc(sizeof(int) * (n2 + 1));
+  P     = ctx->P;
+  md    = &(ctx->md);
+  rtype = &(md->rtype[0]);
+  c     = ctx->c;
 
   S1  = (short **)vrna_alloc((n_seq + 1) * sizeof(short *));
   S2  = (short **)vrna_alloc((n_seq + 1) * sizeof(short *));
@@ -438,8 +664,8 @@ aliduplexfold_cu(const char *s1[],
     if (strlen(s2[s]) != n2)
       vrna_message_error("uneqal seqence lengths");
 
-    S1[s] = encode_sequence(s1[s], 0);
-    S2[s] = encode_sequence(s2[s], 0);
+    S1[s] = vrna_seq_encode_simple(s1[s], md);
+    S2[s] = vrna_seq_encode_simple(s2[s], md);
   }
   type = (int *)vrna_alloc(n_seq * sizeof(int));
 
@@ -447,7 +673,7 @@ aliduplexfold_cu(const char *s1[],
     for (j = n2; j > 0; j--) {
       int k, l, E, psc;
       for (s = 0; s < n_seq; s++)
-        type[s] = pair[S1[s][i]][S2[s][j]];
+        type[s] = md->pair[S1[s][i]][S2[s][j]];
       psc = covscore(type, n_seq);
       for (s = 0; s < n_seq; s++)
         if (type[s] == 0)
@@ -473,7 +699,7 @@ aliduplexfold_cu(const char *s1[],
             continue;
 
           for (E = s = 0; s < n_seq; s++) {
-            type2 = pair[S1[s][k]][S2[s][l]];
+            type2 = md->pair[S1[s][k]][S2[s][l]];
             if (type2 == 0)
               type2 = 7;
 
@@ -496,7 +722,7 @@ aliduplexfold_cu(const char *s1[],
     }
   }
 
-  struc = alibacktrack(i_min, j_min, (const short **)S1, (const short **)S2);
+  struc = alibacktrack(ctx, i_min, j_min, (const short **)S1, (const short **)S2);
   if (i_min < n1)
     i_min++;
 
@@ -507,11 +733,6 @@ aliduplexfold_cu(const char *s1[],
   mfe.j         = j_min;
   mfe.energy    = (float)(Emin / (100. * n_seq));
   mfe.structure = struc;
-  if (clean_up) {
-    for (i = 1; i <= n1; i++)
-      free(c[i]);
-    free(c);
-  }
 
   for (s = 0; s < n_seq; s++) {
     free(S1[s]);
@@ -530,17 +751,49 @@ aliduplex_subopt(const char *s1[],
                  int        delta,
                  int        w)
 {
-  int     i, j, n1, n2, thresh, E, n_subopt = 0, n_max, s, n_seq, *type;
-  char    *struc;
-  duplexT mfe;
-  duplexT *subopt;
-  short   **S1, **S2;
+  duplexT               *subopt;
+  vrna_duplex_context_t *ctx;
+
+  ctx     = get_default_context();
+  subopt  = vrna_aliduplex_subopt(ctx, s1, s2, delta, w);
+  matrices_free(ctx);
+
+  return subopt;
+}
+
+
+PUBLIC duplexT
+vrna_aliduplexfold(vrna_duplex_context_t  *ctx,
+                   const char             *s1[],
+                   const char             *s2[])
+{
+  return aliduplexfold_cu(ctx, s1, s2);
+}
+
+
+PUBLIC duplexT *
+vrna_aliduplex_subopt(vrna_duplex_context_t *ctx,
+                      const char            *s1[],
+                      const char            *s2[],
+                      int                   delta,
+                      int                   w)
+{
+  int       i, j, n1, n2, thresh, E, n_subopt = 0, n_max, s, n_seq, *type;
+  int       **c;
+  char      *struc;
+  duplexT   mfe;
+  duplexT   *subopt;
+  short     **S1, **S2;
+  vrna_md_t *md;
 
   n_max   = 16;
   subopt  = (duplexT *)vrna_alloc(n_max * sizeof(duplexT));
-  mfe     = aliduplexfold_cu(s1, s2, 0);
+  mfe     = aliduplexfold_cu(ctx, s1, s2);
   free(mfe.structure);
 
+  md  = &(ctx->md);
+  c   = ctx->c;
+
   for (s = 0; s1[s] != NULL; s++) ;
   n_seq = s;
 
@@ -556,8 +809,8 @@ aliduplex_subopt(const char *s1[],
     if (strlen(s2[s]) != n2)
       vrna_message_error("uneqal seqence lengths");
 
-    S1[s] = encode_sequence(s1[s], 0);
-    S2[s] = encode_sequence(s2[s], 0);
+    S1[s] = vrna_seq_encode_simple(s1[s], md);
+    S2[s] = vrna_seq_encode_simple(s2[s], md);
   }
   type = (int *)vrna_alloc(n_seq * sizeof(int));
 
@@ -566,7 +819,7 @@ aliduplex_subopt(const char *s1[],
       int ii, jj, skip, Ed, psc;
 
       for (s = 0; s < n_seq; s++)
-        type[s] = pair[S2[s][j]][S1[s][i]];
+        type[s] = md->pair[S2[s][j]][S1[s][i]];
       psc = covscore(type, n_seq);
       for (s = 0; s < n_seq; s++)
         if (type[s] == 0)
@@ -577,7 +830,10 @@ aliduplex_subopt(const char *s1[],
 
       E = Ed = c[i][j];
       for (s = 0; s < n_seq; s++)
-        Ed += E_ExtLoop(type[s], (j > 1) ? S2[s][j - 1] : -1, (i < n1) ? S1[s][i + 1] : -1, P);
+        Ed += E_ExtLoop(type[s],
+                        (j > 1) ? S2[s][j - 1] : -1,
+                        (i < n1) ? S1[s][i + 1] : -1,
+                        ctx->P);
       if (Ed > thresh)
         continue;
 
@@ -595,7 +851,7 @@ aliduplex_subopt(const char *s1[],
       if (skip)
         continue;
 
-      struc = alibacktrack(i, j, (const short **)S1, (const short **)S2);
+      struc = alibacktrack(ctx, i, j, (const short **)S1, (const short **)S2);
       vrna_message_info(stderr, "%d %d %d", i, j, E);
       if (n_subopt + 1 >= n_max) {
         n_max   *= 2;
@@ -609,9 +865,6 @@ aliduplex_subopt(const char *s1[],
     }
   }
 
-  for (i = 1; i <= n1; i++)
-    free(c[i]);
-  free(c);
   for (s = 0; s < n_seq; s++) {
     free(S1[s]);
     free(S2[s]);
@@ -631,18 +884,26 @@ aliduplex_subopt(const char *s1[],
 
 
 PRIVATE char *
-alibacktrack(int          i,
-             int          j,
-             const short  **S1,
-             const short  **S2)
+alibacktrack(vrna_duplex_context_t  *ctx,
+             int                    i,
+             int                    j,
+             const short            **S1,
+             const short            **S2)
 {
   /* backtrack structure going backwards from i, and forwards from j
    * return structure in bracket notation with & as separator */
-  int   k, l, *type, type2, E, traced, i0, j0, s, n_seq;
-  char  *st1, *st2, *struc;
-
-  n1  = (int)S1[0][0];
-  n2  = (int)S2[0][0];
+  int           k, l, *type, type2, E, traced, i0, j0, s, n_seq, n1, n2;
+  int           **c, *rtype;
+  char          *st1, *st2, *struc;
+  vrna_md_t     *md;
+  vrna_param_t  *P;
+
+  n1    = (int)S1[0][0];
+  n2    = (int)S2[0][0];
+  c     = ctx->c;
+  P     = ctx->P;
+  md    = &(ctx->md);
+  rtype = &(md->rtype[0]);
 
   for (s = 0; S1[s] != NULL; s++) ;
   n_seq = s;
@@ -664,7 +925,7 @@ alibacktrack(int          i,
     st1[i - 1]  = '(';
     st2[j - 1]  = ')';
     for (s = 0; s < n_seq; s++)
-      type[s] = pair[S1[s][i]][S2[s][j]];
+      type[s] = md->pair[S1[s][i]][S2[s][j]];
     psc = covscore(type, n_seq);
     for (s = 0; s < n_seq; s++)
       if (type[s] == 0)
@@ -681,7 +942,7 @@ alibacktrack(int          i,
           continue;
 
         for (s = LE = 0; s < n_seq; s++) {
-          type2 = pair[S1[s][k]][S2[s][l]];
+          type2 = md->pair[S1[s][k]][S2[s][l]];
           if (type2 == 0)
             type2 = 7;
 
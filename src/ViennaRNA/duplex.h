@@ -2,6 +2,7 @@
 #define VIENNA_RNA_PACKAGE_DUPLEX_H
 
 #include <ViennaRNA/datastructures/basic.h>
+#include <ViennaRNA/model.h>
 
 /**
  *  @file     duplex.h
@@ -9,11 +10,138 @@
  *  @brief    Functions for simple RNA-RNA duplex interactions
  */
 
+/**
+ *  @brief  A context for duplex computations
+ *
+ *  The context holds the model details, energy parameters, and DP matrices
+ *  of the duplex functions. Different threads may use different contexts
+ *  concurrently. The DP matrices are kept for subsequent computations of
+ *  the same context and only re-allocated if a longer pair of sequences
+ *  comes in.
+ *
+ *  @see vrna_duplex_context(), vrna_duplex_context_free(), vrna_duplexfold(),
+ *  vrna_duplex_subopt()
+ */
+typedef struct vrna_duplex_context_s vrna_duplex_context_t;
+
 
+/**
+ *  @brief  Create a context for duplex computations
+ *
+ *  @param  md  The model details to use, or @p NULL to use the current global
+ *              model settings
+ *  @return     A new duplex context that must be released with vrna_duplex_context_free()
+ */
+vrna_duplex_context_t *
+vrna_duplex_context(const vrna_md_t *md);
+
+
+/**
+ *  @brief  Release a duplex context and its DP matrices
+ *
+ *  @param  ctx The duplex context
+ */
+void
+vrna_duplex_context_free(vrna_duplex_context_t *ctx);
+
+
+/**
+ *  @brief  Compute the MFE duplex structure of two sequences within a context
+ *
+ *  Same as duplexfold() but uses the model details and DP matrices of @p ctx.
+ *
+ *  @param  ctx The duplex context
+ *  @param  s1  The first sequence
+ *  @param  s2  The second sequence
+ *  @return     The MFE duplex structure
+ */
+duplexT
+vrna_duplexfold(vrna_duplex_context_t *ctx,
+                const char            *s1,
+                const char            *s2);
+
+
+/**
+ *  @brief  Compute suboptimal duplex structures of two sequences within a context
+ *
+ *  Same as duplex_subopt() but uses the model details and DP matrices of @p ctx.
+ *
+ *  @param  ctx   The duplex context
+ *  @param  s1    The first sequence
+ *  @param  s2    The second sequence
+ *  @param  delta The energy range above the MFE in dcal/mol
+ *  @param  w     The minimum distance of non-dominated hits
+ *  @return       A list of duplex structures terminated by an entry with
+ *                @p structure set to @p NULL
+ */
+duplexT *
+vrna_duplex_subopt(vrna_duplex_context_t  *ctx,
+                   const char             *s1,
+                   const char             *s2,
+                   int                    delta,
+                   int                    w);
+
+
+/**
+ *  @brief  Compute the MFE duplex structure of two alignments within a context
+ *
+ *  Same as aliduplexfold() but uses the model details and DP matrices of @p ctx.
+ */
+duplexT
+vrna_aliduplexfold(vrna_duplex_context_t  *ctx,
+                   const char             *s1[],
+                   const char             *s2[]);
+
+
+/**
+ *  @brief  Compute suboptimal duplex structures of two alignments within a context
+ *
+ *  Same as aliduplex_subopt() but uses the model details and DP matrices of @p ctx.
+ */
+duplexT *
+vrna_aliduplex_subopt(vrna_duplex_context_t *ctx,
+                      const char            *s1[],
+                      const char            *s2[],
+                      int                   delta,
+                      int                   w);
+
+
+/**
+ *  @brief  Compute the MFE duplex structure of two sequences
+ *
+ *  Uses the global model settings. Each thread keeps its own energy parameters
+ *  in a default context that is re-used unless the temperature changes.
+ */
 duplexT duplexfold(const char *s1,
                    const char *s2);
 
 
+/**
+ *  @brief  Compute the MFE duplex structures for all pairs of two sets of sequences
+ *
+ *  Computes duplexfold(s1[i], s2[j]) for each pair of sequences from the two
+ *  @p NULL terminated lists @p s1 and @p s2. The individual pairs are distributed
+ *  over @p num_threads parallel threads, if the library has been compiled with
+ *  OpenMP support. A value of @p num_threads <= 0 uses the default number of
+ *  threads.
+ *
+ *  @note   Each thread processes its pairs within its own duplex context, see
+ *          vrna_duplex_context(), and thus re-uses the energy parameters and DP matrices
+ *          for all pairs it processes.
+ *
+ *  @param  s1          A @p NULL terminated list of sequences, e.g. the queries
+ *  @param  s2          A @p NULL terminated list of sequences, e.g. the targets
+ *  @param  num_threads The number of parallel threads to use
+ *  @return             A list of duplex structures where the result for pair (i, j)
+ *                      is stored at position @p i * n2 + @p j, with @p n2 the number of
+ *                      sequences in @p s2. The list is terminated by an entry with
+ *                      @p structure set to @p NULL.
+ */
+duplexT *duplexfold_batch(const char  **s1,
+                          const char  **s2,
+                          int         num_threads);
+
+
 duplexT *duplex_subopt(const char *s1,
                        const char *s2,
                        int        delta,
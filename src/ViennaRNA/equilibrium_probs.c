@@ -28,8 +28,10 @@
 #include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/part_func.h"
 #include "ViennaRNA/equilibrium_probs.h"
+#include "ViennaRNA/utils/timing_hooks.h"
 
 #include "ViennaRNA/loops/external_hc.inc"
+#include "ViennaRNA/sequence_weights.inc"
 
 /*
  #################################
@@ -237,7 +239,7 @@ vrna_pr_structure(vrna_fold_compound_t  *fc,
       e -= vrna_eval_covar_structure(fc, structure);
 
       /* divide ensemble free energy by number of sequences */
-      dG /= fc->n_seq;
+      dG /= fc->n_seq_total;
     }
 
     p = exp((dG - e) / kT);
@@ -265,7 +267,7 @@ vrna_pr_energy(vrna_fold_compound_t *fc,
     dG = (-log(Q) - n * log(params->pf_scale)) * kT;
 
     if (fc->type == VRNA_FC_TYPE_COMPARATIVE)
-      dG /= fc->n_seq;
+      dG /= fc->n_seq_total;
 
     p = exp((dG - e) / kT);
 
@@ -283,10 +285,19 @@ vrna_pairing_probs(vrna_fold_compound_t *vc,
   int ret = 0;
 
   if (vc) {
+    VRNA_TIMING_START(vc, VRNA_TIMING_PF_OUTSIDE);
+
     if (vc->strands > 1)
       ret = pf_co_bppm(vc, structure);
     else
       ret = pf_create_bppm(vc, structure);
+
+    VRNA_TIMING_STOP(vc, VRNA_TIMING_PF_OUTSIDE);
+    VRNA_TIMING_CELLS(vc,
+                      VRNA_TIMING_PF_OUTSIDE,
+                      vrna_timing_cells_triangle((int)vc->length,
+                                                 vc->exp_params->model_details.min_loop_size,
+                                                 (int)vc->length));
   }
 
   return ret;
@@ -932,7 +943,7 @@ contrib_ext_pair_comparative(vrna_fold_compound_t *fc,
 {
   unsigned char     type;
   short             **S, **S5, **S3, s5, s3;
-  unsigned int      **a2s, n, s, n_seq;
+  unsigned int      **a2s, n, s, n_seq, *w;
   int               *jindx, *pscore;
   FLT_OR_DBL        contribution;
   double            kTn;
@@ -942,6 +953,7 @@ contrib_ext_pair_comparative(vrna_fold_compound_t *fc,
 
   n         = fc->length;
   n_seq     = fc->n_seq;
+  w         = fc->seq_weights;
   jindx     = fc->jindx;
   pf_params = fc->exp_params;
   md        = &(pf_params->model_details);
@@ -960,7 +972,7 @@ contrib_ext_pair_comparative(vrna_fold_compound_t *fc,
     s5    = (a2s[s][i] > 1) ? S5[s][i] : -1;
     s3    = (a2s[s][j] < a2s[s][S[0][0]]) ? S3[s][j] : -1;
 
-    contribution *= vrna_exp_E_ext_stem(type, s5, s3, pf_params);
+    contribution *= exp_weighted(vrna_exp_E_ext_stem(type, s5, s3, pf_params), w[s]);
   }
 
   if (scs) {
@@ -1160,7 +1172,7 @@ compute_bpp_internal_comparative(vrna_fold_compound_t *fc,
                                  int                  *ov)
 {
   short             **SS, **S5, **S3;
-  unsigned int      type, *tt, s, n_seq, **a2s;
+  unsigned int      type, *tt, s, n_seq, *w, **a2s;
   int               i, j, k, n, ij, kl, u1, u2, *my_iindx, *jindx, turn, *pscore;
   FLT_OR_DBL        temp, q_temp, *qb, *probs, *scale;
   double            max_real, kTn;
@@ -1171,6 +1183,7 @@ compute_bpp_internal_comparative(vrna_fold_compound_t *fc,
 
   n         = (int)fc->length;
   n_seq     = fc->n_seq;
+  w         = fc->seq_weights;
   pscore    = fc->pscore;
   SS        = fc->S;
   S5        = fc->S5;
@@ -1228,15 +1241,15 @@ compute_bpp_internal_comparative(vrna_fold_compound_t *fc,
               int u1_loc  = a2s[s][k - 1] - a2s[s][i];
               int u2_loc  = a2s[s][j - 1] - a2s[s][l];
               type    = vrna_get_ptype_md(SS[s][i], SS[s][j], md);
-              q_temp  *= exp_E_IntLoop(u1_loc,
-                                       u2_loc,
-                                       type,
-                                       tt[s],
-                                       S3[s][i],
-                                       S5[s][j],
-                                       S5[s][k],
-                                       S3[s][l],
-                                       pf_params);
+              q_temp  *= exp_weighted(exp_E_IntLoop(u1_loc,
+                                                    u2_loc,
+                                                    type,
+                                                    tt[s],
+                                                    S3[s][i],
+                                                    S5[s][j],
+                                                    S5[s][k],
+                                                    S3[s][l],
+                                                    pf_params), w[s]);
             }
 
             if (scs) {
@@ -1585,7 +1598,7 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
 {
   unsigned char     tt;
   short             **S, **S5, **S3;
-  unsigned int      **a2s, s, n_seq;
+  unsigned int      **a2s, s, n_seq, n_seq_total, *w;
   int               i, j, k, n, ii, kl, ll, turn, *my_iindx, *jindx, *pscore, with_gquad;
   FLT_OR_DBL        temp, pp, prm_MLb, prmt, prmt1, *qb, *probs, *qm, *G, *scale,
                     *expMLbase, expMLclosing, expMLstem;
@@ -1597,6 +1610,8 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
 
   n             = (int)fc->length;
   n_seq         = fc->n_seq;
+  n_seq_total   = fc->n_seq_total;
+  w             = fc->seq_weights;
   S             = fc->S;
   S5            = fc->S5;
   S3            = fc->S3;
@@ -1617,7 +1632,7 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
   with_gquad    = md->gquad;
   hc            = fc->hc;
   scs           = fc->scs;
-  expMLstem     = (with_gquad) ? (FLT_OR_DBL)pow(exp_E_MLstem(0, -1, -1, pf_params), (double)n_seq) : 0;
+  expMLstem     = (with_gquad) ? (FLT_OR_DBL)pow(exp_E_MLstem(0, -1, -1, pf_params), (double)n_seq_total) : 0;
 
   prm_MLb   = 0.;
   max_real  = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
@@ -1638,7 +1653,7 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
         prmt1 = probs[ii - (l + 1)];
         for (s = 0; s < n_seq; s++) {
           tt    = vrna_get_ptype_md(S[s][l + 1], S[s][i], md);
-          prmt1 *= exp_E_MLstem(tt, S5[s][l + 1], S3[s][i], pf_params) * expMLclosing;
+          prmt1 *= exp_weighted(exp_E_MLstem(tt, S5[s][l + 1], S3[s][i], pf_params) * expMLclosing, w[s]);
         }
 
         if (scs) {
@@ -1660,7 +1675,7 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
 
         for (s = 0; s < n_seq; s++) {
           tt  = vrna_get_ptype_md(S[s][j], S[s][i], md);
-          pp  *= exp_E_MLstem(tt, S5[s][j], S3[s][i], pf_params) * expMLclosing;
+          pp  *= exp_weighted(exp_E_MLstem(tt, S5[s][j], S3[s][i], pf_params) * expMLclosing, w[s]);
         }
 
         if (scs) {
@@ -1729,7 +1744,7 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
       } else {
         for (s = 0; s < n_seq; s++) {
           tt    = vrna_get_ptype_md(S[s][k], S[s][l], md);
-          temp  *= exp_E_MLstem(tt, S5[s][k], S3[s][l], pf_params);
+          temp  *= exp_weighted(exp_E_MLstem(tt, S5[s][k], S3[s][l], pf_params), w[s]);
         }
       }
 
@@ -3885,7 +3900,7 @@ bppm_circ_comparative(vrna_fold_compound_t *vc)
 {
   unsigned char     *hard_constraints;
   short             **S, **S5, **S3;
-  unsigned int      s, n_seq, *type, **a2s;
+  unsigned int      s, n_seq, n_seq_total, *w, *type, **a2s;
   int               i, j, k, l, n, ij, turn, *my_iindx, *jindx, *pscore, *rtype;
   FLT_OR_DBL        *qb, *qm, *qm1, *probs, qo, *scale, *expMLbase, expMLclosing, tmp2, tmp3;
   double            kTn;
@@ -3896,6 +3911,8 @@ bppm_circ_comparative(vrna_fold_compound_t *vc)
 
   n                 = (int)vc->length;
   n_seq             = vc->n_seq;
+  n_seq_total       = vc->n_seq_total;
+  w                 = vc->seq_weights;
   S                 = vc->S;
   S5                = vc->S5;
   S3                = vc->S3;
@@ -3980,11 +3997,11 @@ bppm_circ_comparative(vrna_fold_compound_t *vc)
                 ln1a    = a2s[s][n] - a2s[s][j];
                 ln1a    += a2s[s][k - 1];
                 type_2  = vrna_get_ptype_md(S[s][l], S[s][k], md);
-                qloop   *= exp_E_IntLoop(ln1a, ln2a, type[s], type_2,
-                                         S3[s][j],
-                                         S5[s][i],
-                                         S5[s][k],
-                                         S3[s][l], pf_params);
+                qloop   *= exp_weighted(exp_E_IntLoop(ln1a, ln2a, type[s], type_2,
+                                                      S3[s][j],
+                                                      S5[s][i],
+                                                      S5[s][k],
+                                                      S3[s][l], pf_params), w[s]);
               }
               if (scs) {
                 for (s = 0; s < n_seq; s++) {
@@ -4058,11 +4075,11 @@ bppm_circ_comparative(vrna_fold_compound_t *vc)
                 ln1a    = a2s[s][k] - a2s[s][j + 1];
                 ln2a    = a2s[s][i - 1] + a2s[s][n] - a2s[s][l];
                 type_2  = vrna_get_ptype_md(S[s][l], S[s][k], md);
-                qloop   *= exp_E_IntLoop(ln2a, ln1a, type_2, type[s],
-                                         S3[s][l],
-                                         S5[s][k],
-                                         S5[s][i],
-                                         S3[s][j], pf_params);
+                qloop   *= exp_weighted(exp_E_IntLoop(ln2a, ln1a, type_2, type[s],
+                                                      S3[s][l],
+                                                      S5[s][k],
+                                                      S5[s][i],
+                                                      S3[s][j], pf_params), w[s]);
               }
               if (scs) {
                 for (s = 0; s < n_seq; s++) {
@@ -4101,9 +4118,9 @@ bppm_circ_comparative(vrna_fold_compound_t *vc)
           /* 1.3.1 Middle part                    */
           if ((i > turn + 2) && (j < n - turn - 1)) {
             for (tmp3 = 1, s = 0; s < n_seq; s++)
-              tmp3 *= exp_E_MLstem(rtype[type[s]], S5[s][i], S3[s][j], pf_params);
+              tmp3 *= exp_weighted(exp_E_MLstem(rtype[type[s]], S5[s][i], S3[s][j], pf_params), w[s]);
             tmp2 += qm[my_iindx[1] - i + 1] * qm[my_iindx[j + 1] - n] *tmp3 *pow(expMLclosing,
-                                                                                 n_seq);
+                                                                                 n_seq_total);
           }
 
           /* 1.3.2 Left part    */
@@ -4112,7 +4129,7 @@ bppm_circ_comparative(vrna_fold_compound_t *vc)
               break;
 
             for (tmp3 = 1, s = 0; s < n_seq; s++)
-              tmp3 *= exp_E_MLstem(rtype[type[s]], S5[s][i], S3[s][j], pf_params);
+              tmp3 *= exp_weighted(exp_E_MLstem(rtype[type[s]], S5[s][i], S3[s][j], pf_params), w[s]);
 
             if (scs) {
               for (s = 0; s < n_seq; s++) {
@@ -4130,7 +4147,7 @@ bppm_circ_comparative(vrna_fold_compound_t *vc)
                     qm[my_iindx[1] - k] *
                     qm1[jindx[i - 1] + k + 1] *
                     expMLbase[n - j] *
-                    pow(expMLclosing, n_seq);
+                    pow(expMLclosing, n_seq_total);
           }
           /* 1.3.3 Right part    */
           for (k = j + turn + 2; k < n - turn - 1; k++) {
@@ -4138,7 +4155,7 @@ bppm_circ_comparative(vrna_fold_compound_t *vc)
               break;
 
             for (tmp3 = 1, s = 0; s < n_seq; s++)
-              tmp3 *= exp_E_MLstem(rtype[type[s]], S5[s][i], S3[s][j], pf_params);
+              tmp3 *= exp_weighted(exp_E_MLstem(rtype[type[s]], S5[s][i], S3[s][j], pf_params), w[s]);
 
             if (scs) {
               for (s = 0; s < n_seq; s++) {
@@ -4153,7 +4170,7 @@ bppm_circ_comparative(vrna_fold_compound_t *vc)
             }
 
             tmp2 += qm[my_iindx[j + 1] - k] * qm1[jindx[n] + k + 1] * tmp3 * expMLbase[i - 1] *
-                    pow(expMLclosing, n_seq);
+                    pow(expMLclosing, n_seq_total);
           }
         }
 
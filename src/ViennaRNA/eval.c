@@ -41,6 +41,7 @@
 #include "ViennaRNA/eval.h"
 
 #include "ViennaRNA/color_output.inc"
+#include "ViennaRNA/sequence_weights.inc"
 
 #ifdef ON_SAME_STRAND
 #undef ON_SAME_STRAND
@@ -241,7 +242,7 @@ vrna_eval_covar_structure(vrna_fold_compound_t  *vc,
   }
 
   free(pt);
-  return (float)res / (100. * (float)vc->n_seq);
+  return (float)res / (100. * (float)vc->n_seq_total);
 }
 
 
@@ -454,7 +455,7 @@ eval_ext_int_loop(vrna_fold_compound_t  *vc,
 {
   unsigned char type, type_2;
   short         **SS, **S5, **S3, *S, si, sj, sp, sq;
-  unsigned int  s, n_seq, **a2s;
+  unsigned int  s, n_seq, *w, **a2s;
   int           e, length;
   vrna_param_t  *P;
   vrna_md_t     *md;
@@ -496,7 +497,7 @@ eval_ext_int_loop(vrna_fold_compound_t  *vc,
       S5    = vc->S5;
       S3    = vc->S3;
       a2s   = vc->a2s;
-      n_seq = vc->n_seq;
+      w     = vc->seq_weights;
       scs   = vc->scs;
 
       for (e = 0, s = 0; s < n_seq; s++) {
@@ -516,6 +517,16 @@ eval_ext_int_loop(vrna_fold_compound_t  *vc,
                                    type, type_2,
                                    a2s[s][length],
                                    P, sc);
+
+        /* remaining copies of a weighted sequence, soft constraints apply only once */
+        if (w[s] > 1)
+          e += (int)(w[s] - 1) *
+               ubf_eval_ext_int_loop(a2s[s][i], a2s[s][j], a2s[s][p], a2s[s][q],
+                                     a2s[s][i - 1], a2s[s][j + 1], a2s[s][p - 1], a2s[s][q + 1],
+                                     S3[s][j], S5[s][i], S5[s][p], S3[s][q],
+                                     type, type_2,
+                                     a2s[s][length],
+                                     P, NULL);
       }
 
       break;
@@ -582,7 +593,7 @@ wrap_eval_structure(vrna_fold_compound_t  *vc,
         free(loop_idx);
       }
 
-      energy = (float)res / (100. * (float)vc->n_seq);
+      energy = (float)res / (100. * (float)vc->n_seq_total);
       break;
 
     default:                      /* do nothing */
@@ -618,7 +629,7 @@ eval_pt(vrna_fold_compound_t  *vc,
   if (verbosity_level > 0) {
     vrna_cstr_print_eval_ext_loop(output_stream,
                                   (vc->type == VRNA_FC_TYPE_COMPARATIVE) ?
-                                  (int)energy / (int)vc->n_seq :
+                                  (int)energy / (int)vc->n_seq_total :
                                   energy);
   }
 
@@ -731,7 +742,7 @@ eval_circ_pt(vrna_fold_compound_t *vc,
   if (verbosity_level > 0) {
     vrna_cstr_print_eval_ext_loop(output_stream,
                                   (vc->type == VRNA_FC_TYPE_COMPARATIVE) ?
-                                  (int)en0 / (int)vc->n_seq :
+                                  (int)en0 / (int)vc->n_seq_total :
                                   en0);
   }
 
@@ -1071,7 +1082,7 @@ stack_energy(vrna_fold_compound_t *vc,
                                     p, q,
                                     string[p - 1], string[q - 1],
                                     (vc->type == VRNA_FC_TYPE_COMPARATIVE) ?
-                                    (int)ee / (int)vc->n_seq :
+                                    (int)ee / (int)vc->n_seq_total :
                                     ee);
     }
 
@@ -1092,7 +1103,7 @@ stack_energy(vrna_fold_compound_t *vc,
                                    i, j,
                                    string[i - 1], string[j - 1],
                                    (vc->type == VRNA_FC_TYPE_COMPARATIVE) ?
-                                   (int)ee / (int)vc->n_seq :
+                                   (int)ee / (int)vc->n_seq_total :
                                    ee);
     }
 
@@ -1129,7 +1140,7 @@ stack_energy(vrna_fold_compound_t *vc,
                                  i, j,
                                  string[i - 1], string[j - 1],
                                  (vc->type == VRNA_FC_TYPE_COMPARATIVE) ?
-                                 (int)ee / (int)vc->n_seq :
+                                 (int)ee / (int)vc->n_seq_total :
                                  ee);
   }
 
@@ -1154,7 +1165,7 @@ energy_of_extLoop_pt(vrna_fold_compound_t *vc,
   int           energy, mm5, mm3, bonus, p, q, q_prev, length, dangle_model, n_seq, cp, ss, u,
                 start;
   short         *s, *s1, **S, **S5, **S3;
-  unsigned int  **a2s;
+  unsigned int  *w, **a2s;
   vrna_param_t  *P;
   vrna_md_t     *md;
   vrna_sc_t     *sc, **scs;
@@ -1179,6 +1190,7 @@ energy_of_extLoop_pt(vrna_fold_compound_t *vc,
   S3            = (vc->type == VRNA_FC_TYPE_SINGLE) ? NULL : vc->S3;
   a2s           = (vc->type == VRNA_FC_TYPE_SINGLE) ? NULL : vc->a2s;
   n_seq         = (vc->type == VRNA_FC_TYPE_SINGLE) ? 1 : vc->n_seq;
+  w             = (vc->type == VRNA_FC_TYPE_SINGLE) ? NULL : vc->seq_weights;
   scs           = (vc->type == VRNA_FC_TYPE_SINGLE) ? NULL : vc->scs;
 
   energy  = 0;
@@ -1288,13 +1300,13 @@ energy_of_extLoop_pt(vrna_fold_compound_t *vc,
 
           switch (dangle_model) {
             case 0:
-              energy += E_ExtLoop(tt, -1, -1, P);
+              energy += E_WEIGHTED(E_ExtLoop(tt, -1, -1, P), w[ss]);
               break;
 
             case 2:
               mm5     = (a2s[ss][p] > 1) ? S5[ss][p] : -1;
               mm3     = (a2s[ss][q] < a2s[ss][S[0][0]]) ? S3[ss][q] : -1;  /* why S[0][0] ??? */
-              energy  += E_ExtLoop(tt, mm5, mm3, P);
+              energy  += E_WEIGHTED(E_ExtLoop(tt, mm5, mm3, P), w[ss]);
               break;
 
             default:
@@ -1376,7 +1388,7 @@ energy_of_ml_pt(vrna_fold_compound_t  *vc,
   int           e_stem, e_stem5, e_stem3, e_stem53;
   int           mlintern[NBPAIRS + 1];
   short         *s, *s1, **S, **S5, **S3;
-  unsigned int  **a2s;
+  unsigned int  *w, **a2s;
   vrna_param_t  *P;
   vrna_md_t     *md;
   vrna_sc_t     *sc, **scs;
@@ -1405,6 +1417,7 @@ energy_of_ml_pt(vrna_fold_compound_t  *vc,
   S3            = (vc->type == VRNA_FC_TYPE_SINGLE) ? NULL : vc->S3;
   a2s           = (vc->type == VRNA_FC_TYPE_SINGLE) ? NULL : vc->a2s;
   n_seq         = (vc->type == VRNA_FC_TYPE_SINGLE) ? 1 : vc->n_seq;
+  w             = (vc->type == VRNA_FC_TYPE_SINGLE) ? NULL : vc->seq_weights;
   scs           = (vc->type == VRNA_FC_TYPE_SINGLE) ? NULL : vc->scs;
 
   bonus = 0;
@@ -1484,11 +1497,11 @@ energy_of_ml_pt(vrna_fold_compound_t  *vc,
           if (scs[ss] && scs[ss]->energy_up)
             bonus += scs[ss]->energy_up[a2s[ss][i + 1]][uu];
 
-          u += uu;
+          u += w[ss] * uu;
         }
       } else {
         for (ss = 0; ss < n_seq; ss++)
-          u += a2s[ss][p] - a2s[ss][i + 1];
+          u += w[ss] * (a2s[ss][p] - a2s[ss][i + 1]);
       }
 
       break;
@@ -1548,7 +1561,7 @@ energy_of_ml_pt(vrna_fold_compound_t  *vc,
               if (tt == 0)
                 tt = 7;
 
-              energy += E_MLstem(tt, -1, -1, P);
+              energy += E_WEIGHTED(E_MLstem(tt, -1, -1, P), w[ss]);
             }
 
             /* seek to the next stem */
@@ -1564,11 +1577,11 @@ energy_of_ml_pt(vrna_fold_compound_t  *vc,
                 if (scs[ss] && scs[ss]->energy_up)
                   bonus += sc->energy_up[a2s[ss][q + 1]][uu];
 
-                u += uu;
+                u += w[ss] * uu;
               }
             } else {
               for (ss = 0; ss < n_seq; ss++)
-                u += a2s[ss][p] - a2s[ss][q + 1];
+                u += w[ss] * (a2s[ss][p] - a2s[ss][q + 1]);
             }
           }
 
@@ -1580,7 +1593,7 @@ energy_of_ml_pt(vrna_fold_compound_t  *vc,
               if (tt == 0)
                 tt = 7;
 
-              energy += E_MLstem(tt, -1, -1, P);
+              energy += E_WEIGHTED(E_MLstem(tt, -1, -1, P), w[ss]);
             }
           }
 
@@ -1646,7 +1659,7 @@ energy_of_ml_pt(vrna_fold_compound_t  *vc,
 
               mm5     = ((a2s[ss][p] > 1) || circular) ? S5[ss][p] : -1;
               mm3     = ((a2s[ss][q] < a2s[ss][S[0][0]]) || circular) ? S3[ss][q] : -1;
-              energy  += E_MLstem(tt, mm5, mm3, P);
+              energy  += E_WEIGHTED(E_MLstem(tt, mm5, mm3, P), w[ss]);
             }
 
             /* seek to the next stem */
@@ -1662,11 +1675,11 @@ energy_of_ml_pt(vrna_fold_compound_t  *vc,
                 if (scs[ss] && scs[ss]->energy_up)
                   bonus += sc->energy_up[a2s[ss][q + 1]][uu];
 
-                u += uu;
+                u += w[ss] * uu;
               }
             } else {
               for (ss = 0; ss < n_seq; ss++)
-                u += a2s[ss][p] - a2s[ss][q + 1];
+                u += w[ss] * (a2s[ss][p] - a2s[ss][q + 1]);
             }
           }
 
@@ -1679,7 +1692,7 @@ energy_of_ml_pt(vrna_fold_compound_t  *vc,
 
               mm5     = S5[ss][j];
               mm3     = S3[ss][i];
-              energy  += E_MLstem(tt, mm5, mm3, P);
+              energy  += E_WEIGHTED(E_MLstem(tt, mm5, mm3, P), w[ss]);
             }
           }
 
@@ -1912,7 +1925,7 @@ energy_of_ml_pt(vrna_fold_compound_t  *vc,
       break;
 
     case VRNA_FC_TYPE_COMPARATIVE:
-      energy += P->MLclosing * n_seq;
+      energy += P->MLclosing * vc->n_seq_total;
       break;
 
     default:
@@ -77,6 +77,13 @@ PRIVATE void
 make_pscores(vrna_fold_compound_t *fc);
 
 
+PRIVATE vrna_fold_compound_t *
+fc_comparative(const char         **sequences,
+               const unsigned int *weights,
+               vrna_md_t          *md_p,
+               unsigned int       options);
+
+
 PRIVATE void
 sanitize_bp_span(vrna_fold_compound_t *fc,
                  unsigned int         options);
@@ -148,6 +155,7 @@ vrna_fold_compound_free(vrna_fold_compound_t *fc)
           free(fc->a2s[s]);
         }
         free(fc->sequences);
+        free(fc->seq_weights);
         free(fc->cons_seq);
         free(fc->S_cons);
         free(fc->S);
@@ -176,6 +184,8 @@ vrna_fold_compound_free(vrna_fold_compound_t *fc)
     free(fc->bpdist);
     free(fc->mm1);
     free(fc->mm2);
+    free(fc->band);
+    free(fc->band_l_max);
 
     /* free local folding related stuff (should be NULL if not used) */
     free(fc->ptype_local);
@@ -184,6 +194,8 @@ vrna_fold_compound_free(vrna_fold_compound_t *fc)
     if (fc->free_auxdata)
       fc->free_auxdata(fc->auxdata);
 
+    free(fc->timing);
+
     free(fc);
   }
 }
@@ -272,96 +284,17 @@ vrna_fold_compound_comparative(const char   **sequences,
                                vrna_md_t    *md_p,
                                unsigned int options)
 {
-  int                   s, n_seq, length;
-  vrna_fold_compound_t  *fc;
-  vrna_md_t             md;
-  unsigned int          aux_options;
-
-  aux_options = 0U;
-
-  if (sequences == NULL)
-    return NULL;
-
-  for (s = 0; sequences[s]; s++);  /* count the sequences */
-
-  n_seq = s;
-
-  length = strlen(sequences[0]);
-  /* sanity check */
-  if (length == 0) {
-    vrna_message_warning("vrna_fold_compound_comparative: "
-                         "sequence length must be greater 0");
-  } else if (length > vrna_sequence_length_max(options)) {
-    vrna_message_warning("vrna_fold_compound_comparative: "
-                         "sequence length of %d exceeds addressable range",
-                         length);
-  }
-
-  for (s = 0; s < n_seq; s++)
-    if (strlen(sequences[s]) != length) {
-      vrna_message_warning("vrna_fold_compound_comparative: "
-                           "uneqal sequence lengths in alignment");
-      return NULL;
-    }
-
-  fc = init_fc_comparative();
-
-  fc->n_seq     = n_seq;
-  fc->length    = length;
-  fc->sequences = vrna_alloc(sizeof(char *) * (fc->n_seq + 1));
-  for (s = 0; sequences[s]; s++)
-    fc->sequences[s] = strdup(sequences[s]);
-
-  /* get a copy of the model details */
-  if (md_p)
-    md = *md_p;
-  else /* this fallback relies on global parameters and thus is not threadsafe */
-    vrna_md_set_default(&md);
-
-  /* now for the energy parameters */
-  add_params(fc, &md, options);
-
-  sanitize_bp_span(fc, options);
-
-  if (options & VRNA_OPTION_WINDOW) {
-    set_fold_compound(fc, options, aux_options);
-
-    fc->pscore_local = vrna_alloc(sizeof(int *) * (fc->length + 1));
-
-#if 0
-    for (i = (int)fc->length; (i > (int)fc->length - fc->window_size - 5) && (i >= 0); i--)
-      fc->pscore_local[i] = vrna_alloc(sizeof(int) * (fc->window_size + 5));
-#endif
-
-    if (!(options & VRNA_OPTION_EVAL_ONLY)) {
-      /* add minimal hard constraint data structure */
-      vrna_hc_init_window(fc);
-
-      /* add DP matrices */
-      vrna_mx_add(fc, VRNA_MX_WINDOW, options);
-    }
-  } else {
-    /* regular global structure prediction */
-
-    aux_options |= WITH_PTYPE;
-
-    if (options & VRNA_OPTION_PF)
-      aux_options |= WITH_PTYPE_COMPAT;
-
-    set_fold_compound(fc, options, aux_options);
-
-    make_pscores(fc);
+  return fc_comparative(sequences, NULL, md_p, options);
+}
 
-    if (!(options & VRNA_OPTION_EVAL_ONLY)) {
-      /* add default hard constraints */
-      vrna_hc_init(fc);
 
-      /* add DP matrices (if required) */
-      vrna_mx_add(fc, VRNA_MX_DEFAULT, options);
-    }
-  }
-
-  return fc;
+PUBLIC vrna_fold_compound_t *
+vrna_fold_compound_comparative_weighted(const char          **sequences,
+                                        const unsigned int  *weights,
+                                        vrna_md_t           *md_p,
+                                        unsigned int        options)
+{
+  return fc_comparative(sequences, weights, md_p, options);
 }
 
 
@@ -540,7 +473,8 @@ vrna_fold_compound_prepare(vrna_fold_compound_t *fc,
   vrna_sc_prepare(fc, options);
 
   /* Add DP matrices, if not they are not present or do not fit current settings */
-  vrna_mx_prepare(fc, options);
+  if (!vrna_mx_prepare(fc, options))
+    ret = 0;
 
   return ret;
 }
@@ -660,7 +594,9 @@ set_fold_compound(vrna_fold_compound_t  *fc,
 
       fc->length = length = fc->length;
 
-      fc->cons_seq  = consensus((const char **)sequences);
+      fc->cons_seq  = vrna_aln_consensus_sequence_weighted((const char **)sequences,
+                                                           fc->seq_weights,
+                                                           md_p);
       fc->S_cons    = vrna_seq_encode_simple(fc->cons_seq, md_p);
 
       fc->pscore = vrna_alloc(sizeof(int) * ((length * (length + 1)) / 2 + 2));
@@ -707,6 +643,129 @@ set_fold_compound(vrna_fold_compound_t  *fc,
 }
 
 
+PRIVATE vrna_fold_compound_t *
+fc_comparative(const char         **sequences,
+               const unsigned int *weights,
+               vrna_md_t          *md_p,
+               unsigned int       options)
+{
+  int                   s, n_seq, length, weighted;
+  vrna_fold_compound_t  *fc;
+  vrna_md_t             md;
+  unsigned int          aux_options;
+
+  aux_options = 0U;
+
+  if (sequences == NULL)
+    return NULL;
+
+  for (s = 0; sequences[s]; s++);  /* count the sequences */
+
+  n_seq = s;
+
+  length = strlen(sequences[0]);
+  /* sanity check */
+  if (length == 0) {
+    vrna_message_warning("vrna_fold_compound_comparative: "
+                         "sequence length must be greater 0");
+  } else if (length > vrna_sequence_length_max(options)) {
+    vrna_message_warning("vrna_fold_compound_comparative: "
+                         "sequence length of %d exceeds addressable range",
+                         length);
+  }
+
+  for (s = 0; s < n_seq; s++)
+    if (strlen(sequences[s]) != length) {
+      vrna_message_warning("vrna_fold_compound_comparative: "
+                           "uneqal sequence lengths in alignment");
+      return NULL;
+    }
+
+  /* get a copy of the model details */
+  if (md_p)
+    md = *md_p;
+  else /* this fallback relies on global parameters and thus is not threadsafe */
+    vrna_md_set_default(&md);
+
+  weighted = 0;
+  if (weights) {
+    for (s = 0; s < n_seq; s++) {
+      if (weights[s] == 0) {
+        vrna_message_warning("vrna_fold_compound_comparative: "
+                             "sequence weights must be positive");
+        return NULL;
+      } else if (weights[s] > 1) {
+        weighted = 1;
+      }
+    }
+
+    if ((weighted) && ((md.gquad) || (options & VRNA_OPTION_WINDOW))) {
+      vrna_message_warning("vrna_fold_compound_comparative: "
+                           "sequence weights are not supported for G-Quadruplexes and sliding-window predictions");
+      return NULL;
+    }
+  }
+
+  fc = init_fc_comparative();
+
+  fc->n_seq       = n_seq;
+  fc->length      = length;
+  fc->sequences   = vrna_alloc(sizeof(char *) * (fc->n_seq + 1));
+  fc->seq_weights = vrna_alloc(sizeof(unsigned int) * (fc->n_seq + 1));
+  fc->n_seq_total = 0;
+  for (s = 0; sequences[s]; s++) {
+    fc->sequences[s]    = strdup(sequences[s]);
+    fc->seq_weights[s]  = (weights) ? weights[s] : 1;
+    fc->n_seq_total     += fc->seq_weights[s];
+  }
+
+  /* now for the energy parameters */
+  add_params(fc, &md, options);
+
+  sanitize_bp_span(fc, options);
+
+  if (options & VRNA_OPTION_WINDOW) {
+    set_fold_compound(fc, options, aux_options);
+
+    fc->pscore_local = vrna_alloc(sizeof(int *) * (fc->length + 1));
+
+#if 0
+    for (i = (int)fc->length; (i > (int)fc->length - fc->window_size - 5) && (i >= 0); i--)
+      fc->pscore_local[i] = vrna_alloc(sizeof(int) * (fc->window_size + 5));
+#endif
+
+    if (!(options & VRNA_OPTION_EVAL_ONLY)) {
+      /* add minimal hard constraint data structure */
+      vrna_hc_init_window(fc);
+
+      /* add DP matrices */
+      vrna_mx_add(fc, VRNA_MX_WINDOW, options);
+    }
+  } else {
+    /* regular global structure prediction */
+
+    aux_options |= WITH_PTYPE;
+
+    if (options & VRNA_OPTION_PF)
+      aux_options |= WITH_PTYPE_COMPAT;
+
+    set_fold_compound(fc, options, aux_options);
+
+    make_pscores(fc);
+
+    if (!(options & VRNA_OPTION_EVAL_ONLY)) {
+      /* add default hard constraints */
+      vrna_hc_init(fc);
+
+      /* add DP matrices (if required) */
+      vrna_mx_add(fc, VRNA_MX_DEFAULT, options);
+    }
+  }
+
+  return fc;
+}
+
+
 PRIVATE void
 make_pscores(vrna_fold_compound_t *fc)
 {
@@ -716,33 +775,48 @@ make_pscores(vrna_fold_compound_t *fc)
 
 #define NONE -10000 /* score for forbidden pairs */
 
-  int       i, j, k, l, s, max_span, turn;
-  float     **dm;
-  int       olddm[7][7] = { { 0, 0, 0, 0, 0, 0, 0 }, /* hamming distance between pairs */
-                            { 0, 0, 2, 2, 1, 2, 2 } /* CG */,
-                            { 0, 2, 0, 1, 2, 2, 2 } /* GC */,
-                            { 0, 2, 1, 0, 2, 1, 2 } /* GU */,
-                            { 0, 1, 2, 2, 0, 2, 1 } /* UG */,
-                            { 0, 2, 2, 1, 2, 0, 2 } /* AU */,
-                            { 0, 2, 2, 2, 1, 2, 0 } /* UA */ };
-
-  short     **S   = fc->S;
-  char      **AS  = fc->sequences;
-  int       n_seq = fc->n_seq;
-  vrna_md_t *md   =
+  int           i, j, k, l, s, max_span, turn;
+  float         **dm;
+  int           olddm[7][7] = { { 0, 0, 0, 0, 0, 0, 0 }, /* hamming distance between pairs */
+                                { 0, 0, 2, 2, 1, 2, 2 } /* CG */,
+                                { 0, 2, 0, 1, 2, 2, 2 } /* GC */,
+                                { 0, 2, 1, 0, 2, 1, 2 } /* GU */,
+                                { 0, 1, 2, 2, 0, 2, 1 } /* UG */,
+                                { 0, 2, 2, 1, 2, 0, 2 } /* AU */,
+                                { 0, 2, 2, 2, 1, 2, 0 } /* UA */ };
+
+  short         **S   = fc->S;
+  char          **AS  = fc->sequences;
+  int           n_seq = fc->n_seq;
+  unsigned int  *w    = fc->seq_weights;                /* sequence weights */
+  int           n_tot = fc->n_seq_total;
+  vrna_md_t     *md   =
     (fc->params) ? &(fc->params->model_details) : &(fc->exp_params->model_details);
-  int       *pscore   = fc->pscore;             /* precomputed array of pair types */
-  int       *indx     = fc->jindx;
-  int       *my_iindx = fc->iindx;
-  int       n         = fc->length;
+  int           *pscore   = fc->pscore;                 /* precomputed array of pair types */
+  int           *indx     = fc->jindx;
+  int           *my_iindx = fc->iindx;
+  int           n         = fc->length;
 
   turn = md->min_loop_size;
 
   if (md->ribo) {
-    if (RibosumFile != NULL)
+    if (RibosumFile != NULL) {
       dm = readribosum(RibosumFile);
-    else
+    } else if (n_tot > n_seq) {
+      /*
+       *  get_ribosum() depends on minimum and maximum pairwise identity
+       *  only. Thus, adding a single duplicate of any sequence with weight
+       *  > 1 suffices to mimic the uncollapsed alignment
+       */
+      const char **AS_dup = (const char **)vrna_alloc(sizeof(char *) * (n_seq + 2));
+      memcpy(AS_dup, AS, sizeof(char *) * n_seq);
+      for (s = 0; w[s] == 1; s++);
+      AS_dup[n_seq] = AS[s];
+      dm            = get_ribosum(AS_dup, n_seq + 1, n);
+      free(AS_dup);
+    } else {
       dm = get_ribosum((const char **)AS, n_seq, n);
+    }
   } else {
     /*use usual matrix*/
     dm = vrna_alloc(7 * sizeof(float *));
@@ -779,9 +853,9 @@ make_pscores(vrna_fold_compound_t *fc)
           }
         }
 
-        pfreq[type]++;
+        pfreq[type] += w[s];
       }
-      if (pfreq[0] * 2 + pfreq[7] > n_seq) {
+      if (pfreq[0] * 2 + pfreq[7] > n_tot) {
         pscore[indx[j] + i] = NONE;
         continue;
       }
@@ -791,7 +865,7 @@ make_pscores(vrna_fold_compound_t *fc)
           score += pfreq[k] * pfreq[l] * dm[k][l];
       /* counter examples score -1, gap-gap scores -0.25   */
       pscore[indx[j] + i] = md->cv_fact *
-                            ((UNIT * score) / n_seq - md->nc_fact * UNIT *
+                            ((UNIT * score) / n_tot - md->nc_fact * UNIT *
                              (pfreq[0] + pfreq[7] * 0.25));
 
       if ((j - i + 1) > max_span)
@@ -894,6 +968,7 @@ nullify(vrna_fold_compound_t *fc)
     fc->stat_cb       = NULL;
     fc->auxdata       = NULL;
     fc->free_auxdata  = NULL;
+    fc->timing        = NULL;
 
     fc->domains_struc = NULL;
     fc->domains_up    = NULL;
@@ -913,6 +988,8 @@ nullify(vrna_fold_compound_t *fc)
       case VRNA_FC_TYPE_COMPARATIVE:
         fc->sequences         = NULL;
         fc->n_seq             = 0;
+        fc->seq_weights       = NULL;
+        fc->n_seq_total       = 0;
         fc->cons_seq          = NULL;
         fc->S_cons            = NULL;
         fc->S                 = NULL;
@@ -938,6 +1015,9 @@ nullify(vrna_fold_compound_t *fc)
     fc->bpdist        = NULL;
     fc->mm1           = NULL;
     fc->mm2           = NULL;
+    fc->band          = NULL;
+    fc->band_l_max    = NULL;
+    fc->num_threads   = 0;
 
     fc->window_size = -1;
     fc->ptype_local = NULL;
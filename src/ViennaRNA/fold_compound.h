@@ -107,6 +107,7 @@ typedef void (vrna_callback_recursion_status)(unsigned char status,
 #include <ViennaRNA/grammar.h>
 #include "ViennaRNA/structured_domains.h"
 #include "ViennaRNA/unstructured_domains.h"
+#include "ViennaRNA/utils/timing.h"
 
 /**
  *  @brief  An enumerator that is used to specify the type of a #vrna_fold_compound_t
@@ -184,6 +185,10 @@ struct vrna_fc_s {
                                                    *    @see  #vrna_fold_compound_t.auxdata, vrna_callback_free_auxdata()
                                                    */
 
+  vrna_timing_t                   *timing;        /**<  @brief  Per-phase timings and counters (NULL unless enabled)
+                                                   *    @see vrna_timing_enable(), vrna_timing()
+                                                   */
+
   /**
    *  @}
    *
@@ -261,6 +266,16 @@ struct vrna_fc_s {
       unsigned int  n_seq;              /**<  @brief  The number of sequences in the alignment
                                          *    @warning   Only available if @verbatim type==VRNA_FC_TYPE_COMPARATIVE @endverbatim
                                          */
+      unsigned int  *seq_weights;       /**<  @brief  The weight (multiplicity) of each sequence in the alignment
+                                         *    @details  Energy contributions of sequence @p s are counted @p seq_weights[s]
+                                         *              times. Unless the #vrna_fold_compound_t has been created through
+                                         *              vrna_fold_compound_comparative_weighted(), all weights are 1.
+                                         *    @warning   Only available if @verbatim type==VRNA_FC_TYPE_COMPARATIVE @endverbatim
+                                         */
+      unsigned int  n_seq_total;        /**<  @brief  The sum of all sequence weights, i.e. the number of sequences
+                                         *            the (possibly collapsed) alignment represents
+                                         *    @warning   Only available if @verbatim type==VRNA_FC_TYPE_COMPARATIVE @endverbatim
+                                         */
       char          *cons_seq;          /**<  @brief  The consensus sequence of the aligned sequences
                                          *    @warning   Only available if @verbatim type==VRNA_FC_TYPE_COMPARATIVE @endverbatim
                                          */
@@ -318,6 +333,9 @@ struct vrna_fc_s {
 
   unsigned int  *mm1;             /**<  @brief  Maximum matching matrix, reference struct 1 disallowed */
   unsigned int  *mm2;             /**<  @brief  Maximum matching matrix, reference struct 2 disallowed */
+  unsigned char **band;           /**<  @brief  Requested distance classes band[k][l] if restricted to a band (NULL otherwise), see vrna_TwoD_set_band() */
+  int           *band_l_max;      /**<  @brief  Maximum distance to reference struct 2 required for each distance k to reference struct 1 to compute the band */
+  int           num_threads;      /**<  @brief  Number of threads for the distance class computations (0 for all available cores), see vrna_TwoD_set_num_threads() */
 
   /**
    *  @}
@@ -467,6 +485,40 @@ vrna_fold_compound_comparative(const char   **sequences,
                                unsigned int options);
 
 
+/**
+ *  @brief  Retrieve a #vrna_fold_compound_t data structure for a weighted sequence alignment
+ *
+ *  This function is the same as vrna_fold_compound_comparative(), but additionally assigns an
+ *  integer weight to each sequence of the alignment. Each sequence then represents @p weights[s]
+ *  copies of itself in all energy sums over the alignment, i.e. MFE, partition function,
+ *  base pair probability, and energy evaluation results are identical to those obtained for an
+ *  alignment where sequence @p s is actually repeated @p weights[s] times, while the per-sequence
+ *  work in the recursions drops by the redundancy factor.
+ *
+ *  Use vrna_aln_collapse() to obtain such a set of weighted representatives from a (deep) alignment
+ *  that contains identical or near-identical sequences.
+ *
+ *  Passing @p NULL as @p weights is equivalent to calling vrna_fold_compound_comparative().
+ *
+ *  @note Weighting is not supported for G-Quadruplexes and local (sliding-window) predictions. In
+ *        these cases, the function issues a warning and returns @p NULL if any weight differs from 1.
+ *        Soft constraints, on the other hand, are applied to each (representative) sequence unweighted.
+ *
+ *  @see  vrna_fold_compound_comparative(), vrna_aln_collapse(), #vrna_fold_compound_t.seq_weights
+ *
+ *  @param    sequences   A sequence alignment including 'gap' characters
+ *  @param    weights     An array of (positive) weights for each of the sequences (may be @p NULL)
+ *  @param    md_p        An optional set of model details
+ *  @param    options     The options for DP matrices memory allocation
+ *  @return               A prefilled vrna_fold_compound_t ready to be used for computations (may be @p NULL on error)
+ */
+vrna_fold_compound_t *
+vrna_fold_compound_comparative_weighted(const char          **sequences,
+                                        const unsigned int  *weights,
+                                        vrna_md_t           *md_p,
+                                        unsigned int        options);
+
+
 vrna_fold_compound_t *
 vrna_fold_compound_TwoD(const char    *sequence,
                         const char    *s1,
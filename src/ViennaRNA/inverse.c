@@ -23,6 +23,14 @@
 #include "ViennaRNA/part_func.h"
 #endif
 #include "ViennaRNA/fold.h"
+#include "ViennaRNA/fold_compound.h"
+#include "ViennaRNA/model.h"
+#include "ViennaRNA/mfe.h"
+#include "ViennaRNA/eval.h"
+#include "ViennaRNA/sequence.h"
+#include "ViennaRNA/alphabet.h"
+#include "ViennaRNA/constraints/hard.h"
+#include "ViennaRNA/params/basic.h"
 #if TDIST
 #include "ViennaRNA/dist_vars.h"
 #include "ViennaRNA/treedist.h"
@@ -30,21 +38,82 @@
 #endif
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/fold_vars.h"
-#include "ViennaRNA/pair_mat.h"
+#include "ViennaRNA/inverse.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __GNUC__
+# define INLINE inline
+#else
+# define INLINE
+#endif
+
+/* pair contexts of the constraint mask that are not restricted at all */
+#define MASK_UNRESTRICTED   (unsigned char)0xFF
+
+/*
+ *  The state of a single design job. Everything an adaptive walk reads or
+ *  writes lives here, so independent jobs may run concurrently.
+ */
+typedef struct {
+  char            symbolset[MAXALPHA + 1];
+  char            pairset[2 * MAXALPHA + 1];
+  int             base;
+  int             npairs;
+  int             nc2;
+  int             fold_type;
+  int             give_up;
+  double          final_cost;
+  int             verbose;
+  double          cost2;
+  char            bt_type;            /* backtrack type used in mfe_cost() */
+  vrna_md_t       md;
+  double          pf_scale;
+  unsigned char   *mask;              /* pair constraints taken from a template fold compound */
+  unsigned int    mask_n;
+  unsigned int    offset;             /* start of the current sub-walk within the target */
+  unsigned short  rng_state[3];
+  unsigned short  *rng;               /* random number stream, or NULL for the global one */
+  int             *stop;              /* set once any multi-start walk succeeded */
+#if TDIST
+  Tree            *T0;
+#endif
+} inverse_ctx;
+
+
+PRIVATE void
+ctx_init(inverse_ctx  *ctx,
+         const char   *alphabet,
+         vrna_md_t    *md);
+
+
+PRIVATE void
+ctx_seed(inverse_ctx  *ctx,
+         unsigned int seed);
+
+
+PRIVATE void
+ctx_from_globals(inverse_ctx *ctx);
+
 
 PRIVATE double
-adaptive_walk(char        *start,
+adaptive_walk(inverse_ctx *ctx,
+              char        *start,
               const char  *target);
 
 
 PRIVATE void
-shuffle(int *list,
-        int len);
+shuffle(inverse_ctx *ctx,
+        int         *list,
+        int         len);
 
 
 PRIVATE void
-make_start(char       *start,
-           const char *structure);
+make_start(inverse_ctx  *ctx,
+           char         *start,
+           const char   *structure);
 
 
 PRIVATE void
@@ -52,20 +121,70 @@ make_ptable(const char  *structure,
             int         *table);
 
 
-PRIVATE void
-make_pairset(void);
+PRIVATE int
+make_pairset(inverse_ctx *ctx);
 
 
 PRIVATE double
-mfe_cost(const char *,
+mfe_cost(inverse_ctx          *ctx,
+         vrna_fold_compound_t **,
+         const char *,
          char *,
          const char *);
 
 
 PRIVATE double
-pf_cost(const char *,
-        char *,
-        const char *);
+pf_cost(inverse_ctx           *ctx,
+        vrna_fold_compound_t  **,
+        const char            *,
+        char                  *,
+        const char            *);
+
+
+PRIVATE double
+mfe_design(inverse_ctx  *ctx,
+           char         *start,
+           const char   *target);
+
+
+PRIVATE double
+pf_walk(inverse_ctx *ctx,
+        char        *start,
+        const char  *target);
+
+
+PRIVATE float
+multistart(inverse_ctx  *ctx,
+           char         *start,
+           const char   *target,
+           unsigned int num_starts,
+           int          num_threads,
+           unsigned int options,
+           int          use_pf);
+
+
+PRIVATE void
+constraints_from_template(inverse_ctx           *ctx,
+                          vrna_fold_compound_t  *fc);
+
+
+PRIVATE void
+constraints_apply(inverse_ctx           *ctx,
+                  vrna_fold_compound_t  *fc);
+
+
+PRIVATE INLINE double
+inv_urn(inverse_ctx *ctx);
+
+
+PRIVATE INLINE int
+inv_int_urn(inverse_ctx *ctx,
+            int         from,
+            int         to);
+
+
+PRIVATE INLINE int
+walk_aborted(inverse_ctx *ctx);
 
 
 PRIVATE char *
@@ -79,23 +198,15 @@ PUBLIC int      give_up           = 0;
 PUBLIC float    final_cost        = 0;  /* when to stop inverse_pf_fold */
 PUBLIC int      inv_verbose       = 0;  /* print out substructure on which inverse_fold() fails */
 
-PRIVATE char    pairset[2 * MAXALPHA + 1];
-PRIVATE int     base, npairs;
-PRIVATE int     nc2;
-
 /*-------------------------------------------------------------------------*/
-PRIVATE int     fold_type;
-#if TDIST
-PRIVATE Tree    *T0;
-#endif
-PRIVATE double  cost2;
 
 PRIVATE double
-adaptive_walk(char        *start,
+adaptive_walk(inverse_ctx *ctx,
+              char        *start,
               const char  *target)
 {
 #ifdef DUMMY
-  printf("%s\n%s %c\n", start, target, backtrack_type);
+  printf("%s\n%s %c\n", start, target, ctx->bt_type);
   return 0.;
 #endif
   int     i, j, p, tt, w1, w2, n_pos, len, flag;
@@ -106,7 +217,10 @@ adaptive_walk(char        *start,
   int     *target_table, *test_table;
   char    cont;
   double  cost, current_cost, ccost2;
-  double  (*cost_function)(const char *,
+  vrna_fold_compound_t  *fc;
+  double  (*cost_function)(inverse_ctx *,
+                           vrna_fold_compound_t **,
+                           const char *,
                            char *,
                            const char *);
 
@@ -128,27 +242,28 @@ adaptive_walk(char        *start,
 
   make_ptable(target, target_table);
 
-  for (i = 0; i < base; i++)
+  for (i = 0; i < ctx->base; i++)
     mut_sym_list[i] = i;
-  for (i = 0; i < npairs; i++)
+  for (i = 0; i < ctx->npairs; i++)
     mut_pair_list[i] = i;
 
   for (i = 0; i < len; i++)
     string[i] = (islower(start[i])) ? toupper(start[i]) : start[i];
-  walk_len = 0;
+  walk_len  = 0;
+  fc        = NULL;
 
-  if (fold_type == 0)
+  if (ctx->fold_type == 0)
     cost_function = mfe_cost;
   else
     cost_function = pf_cost;
 
-  cost = cost_function(string, structure, target);
+  cost = cost_function(ctx, &fc, string, structure, target);
 
-  if (fold_type == 0) {
-    ccost2 = cost2;
+  if (ctx->fold_type == 0) {
+    ccost2 = ctx->cost2;
   } else {
-    ccost2  = -1.;
-    cost2   = 0;
+    ccost2    = -1.;
+    ctx->cost2 = 0;
   }
 
   strcpy(cstring, string);
@@ -158,7 +273,10 @@ adaptive_walk(char        *start,
     do {
       cont = 0;
 
-      if (fold_type == 0) {
+      if (walk_aborted(ctx))
+        break;
+
+      if (ctx->fold_type == 0) {
         /* min free energy fold */
         make_ptable(structure, test_table);
         for (j = w1 = w2 = flag = 0; j < len; j++)
@@ -187,8 +305,8 @@ adaptive_walk(char        *start,
             flag = 0;
           }
 
-        shuffle(w1_list, w1);
-        shuffle(w2_list, w2);
+        shuffle(ctx, w1_list, w1);
+        shuffle(ctx, w2_list, w2);
         for (j = n_pos = 0; j < w1; j++)
           mut_pos_list[n_pos++] = w1_list[j];
         for (j = 0; j < w2; j++)
@@ -200,58 +318,58 @@ adaptive_walk(char        *start,
             if (target_table[j] <= j)
               mut_pos_list[n_pos++] = j;
 
-        shuffle(mut_pos_list, n_pos);
+        shuffle(ctx, mut_pos_list, n_pos);
       }
 
       string2[0] = '\0';
       for (mut_position = 0; mut_position < n_pos; mut_position++) {
         strcpy(string, cstring);
-        shuffle(mut_sym_list, base);
-        shuffle(mut_pair_list, npairs);
+        shuffle(ctx, mut_sym_list, ctx->base);
+        shuffle(ctx, mut_pair_list, ctx->npairs);
 
         i = mut_pos_list[mut_position];
 
         if (target_table[i] < 0) {
           /* unpaired base */
-          for (symbol = 0; symbol < base; symbol++) {
+          for (symbol = 0; symbol < ctx->base; symbol++) {
             if (cstring[i] ==
-                symbolset[mut_sym_list[symbol]])
+                ctx->symbolset[mut_sym_list[symbol]])
               continue;
 
-            string[i] = symbolset[mut_sym_list[symbol]];
+            string[i] = ctx->symbolset[mut_sym_list[symbol]];
 
-            cost = cost_function(string, structure, target);
+            cost = cost_function(ctx, &fc, string, structure, target);
 
             if (cost + DBL_EPSILON < current_cost)
               break;
 
-            if ((cost == current_cost) && (cost2 < ccost2)) {
+            if ((cost == current_cost) && (ctx->cost2 < ccost2)) {
               strcpy(string2, string);
               strcpy(struct2, structure);
-              ccost2 = cost2;
+              ccost2 = ctx->cost2;
             }
           }
         } else {
           /* paired base */
-          for (bp = 0; bp < npairs; bp++) {
+          for (bp = 0; bp < ctx->npairs; bp++) {
             j = target_table[i];
             p = mut_pair_list[bp] * 2;
-            if ((cstring[i] == pairset[p]) &&
-                (cstring[j] == pairset[p + 1]))
+            if ((cstring[i] == ctx->pairset[p]) &&
+                (cstring[j] == ctx->pairset[p + 1]))
               continue;
 
-            string[i] = pairset[p];
-            string[j] = pairset[p + 1];
+            string[i] = ctx->pairset[p];
+            string[j] = ctx->pairset[p + 1];
 
-            cost = cost_function(string, structure, target);
+            cost = cost_function(ctx, &fc, string, structure, target);
 
             if (cost < current_cost)
               break;
 
-            if ((cost == current_cost) && (cost2 < ccost2)) {
+            if ((cost == current_cost) && (ctx->cost2 < ccost2)) {
               strcpy(string2, string);
               strcpy(struct2, structure);
-              ccost2 = cost2;
+              ccost2 = ctx->cost2;
             }
           }
         }
@@ -259,7 +377,7 @@ adaptive_walk(char        *start,
         if (cost < current_cost) {
           strcpy(cstring, string);
           current_cost  = cost;
-          ccost2        = cost2;
+          ccost2        = ctx->cost2;
           walk_len++;
           if (cost > 0)
             cont = 1;
@@ -273,7 +391,7 @@ adaptive_walk(char        *start,
          * cost constant */
         strcpy(cstring, string2);
         strcpy(structure, struct2);
-        nc2++;
+        ctx->nc2++;
         cont = 1;
       }
     } while (cont);
@@ -284,12 +402,13 @@ adaptive_walk(char        *start,
       start[i] = cstring[i];
 
 #if TDIST
-  if (fold_type == 0) {
-    free_tree(T0);
-    T0 = NULL;
+  if (ctx->fold_type == 0) {
+    free_tree(ctx->T0);
+    ctx->T0 = NULL;
   }
 
 #endif
+  vrna_fold_compound_free(fc);
   free(test_table);
   free(target_table);
   free(mut_pos_list);
@@ -309,14 +428,15 @@ adaptive_walk(char        *start,
 
 /* shuffle produces a ronaom list by doing len exchanges */
 PRIVATE void
-shuffle(int *list,
-        int len)
+shuffle(inverse_ctx *ctx,
+        int         *list,
+        int         len)
 {
   int i, rn;
 
   for (i = 0; i < len; i++) {
     int temp;
-    rn = i + (int)(vrna_urn() * (len - i)); /* [i..len-1] */
+    rn = i + (int)(inv_urn(ctx) * (len - i)); /* [i..len-1] */
     /* swap element i and rn */
     temp      = list[i];
     list[i]   = list[rn];
@@ -370,23 +490,41 @@ make_ptable(const char  *structure,
     wstruct[j - i + 1] = '\0'; \
     strncpy(wstring, string + i, j - i + 1); \
     wstring[j - i + 1]  = '\0'; \
-    dist                = adaptive_walk(wstring, wstruct); \
+    ctx->offset         = i; \
+    dist                = adaptive_walk(ctx, wstring, wstruct); \
     strncpy(string + i, wstring, j - i + 1); \
-    if ((dist > 0) && (give_up)) \
+    if ((dist > 0) && ((ctx->give_up) || (walk_aborted(ctx)))) \
       goto adios; \
   }
 
 
 PUBLIC float
-inverse_fold(char *start,
-             char *structure)
+inverse_fold(char       *start,
+             const char *structure)
+{
+  inverse_ctx ctx;
+
+  ctx_from_globals(&ctx);
+
+  if (!make_pairset(&ctx))
+    vrna_message_error("No pairs in this alphabet!");
+
+  return (float)mfe_design(&ctx, start, structure);
+}
+
+
+PRIVATE double
+mfe_design(inverse_ctx  *ctx,
+           char         *start,
+           const char   *structure)
 {
   int     i, j, jj, len, o;
   int     *pt;
   char    *string, *wstring, *wstruct, *aux;
   double  dist = 0;
 
-  nc2 = j = o = fold_type = 0;
+  ctx->nc2        = j = o = ctx->fold_type = 0;
+  ctx->bt_type    = ctx->md.backtrack_type;
 
   len = strlen(structure);
   if (strlen(start) != len)
@@ -402,8 +540,7 @@ inverse_fold(char *start,
 
   aux = aux_struct(structure);
   strcpy(string, start);
-  make_pairset();
-  make_start(string, structure);
+  make_start(ctx, string, structure);
 
   make_ptable(structure, pt);
 
@@ -428,7 +565,7 @@ inverse_fold(char *start,
     }
 
     while (pt[j] == i) {
-      backtrack_type = 'C';
+      ctx->bt_type = 'C';
       if (aux[i] != '[') {
         while (aux[--i] != '[') ;
         while (aux[++j] != ']') ;
@@ -443,7 +580,7 @@ inverse_fold(char *start,
       while ((i >= 0) && (aux[i] == '.'))
         i--;
       if (pt[j] != i) {
-        backtrack_type = (o == 0) ? 'F' : 'M';
+        ctx->bt_type = (o == 0) ? 'F' : 'M';
         if (j - jj > 8)
           WALK((i + 1), (jj));
 
@@ -458,8 +595,7 @@ inverse_fold(char *start,
     }
   }
 adios:
-  backtrack_type = 'F';
-  if ((dist > 0) && (inv_verbose))
+  if ((dist > 0) && (ctx->verbose))
     printf("%s\n%s\n", wstring, wstruct);
 
   /*if ((dist==0)||(give_up==0))*/ strcpy(start, string);
@@ -476,32 +612,327 @@ adios:
 /*-------------------------------------------------------------------------*/
 
 PUBLIC float
-inverse_pf_fold(char  *start,
-                char  *target)
+inverse_pf_fold(char        *start,
+                const char  *target)
+{
+  inverse_ctx ctx;
+
+  ctx_from_globals(&ctx);
+
+  if (!make_pairset(&ctx))
+    vrna_message_error("No pairs in this alphabet!");
+
+  return (float)(pf_walk(&ctx, start, target) + ctx.final_cost);
+}
+
+
+/*-------------------------------------------------------------------------*/
+
+PUBLIC float
+inverse_fold_multistart(char          *start,
+                        const char    *target,
+                        unsigned int  num_starts,
+                        int           num_threads,
+                        unsigned int  options)
+{
+  inverse_ctx ctx;
+
+  ctx_from_globals(&ctx);
+
+  if (!make_pairset(&ctx))
+    vrna_message_error("No pairs in this alphabet!");
+
+  return multistart(&ctx, start, target, num_starts, num_threads, options, 0);
+}
+
+
+PUBLIC float
+inverse_pf_fold_multistart(char         *start,
+                           const char   *target,
+                           unsigned int num_starts,
+                           int          num_threads,
+                           unsigned int options)
+{
+  inverse_ctx ctx;
+
+  ctx_from_globals(&ctx);
+
+  if (!make_pairset(&ctx))
+    vrna_message_error("No pairs in this alphabet!");
+
+  return multistart(&ctx, start, target, num_starts, num_threads, options, 1);
+}
+
+
+/*-------------------------------------------------------------------------*/
+
+PUBLIC void
+vrna_inverse_opt_defaults(vrna_inverse_opt_t *options)
+{
+  if (options) {
+    options->type         = VRNA_INVERSE_MFE;
+    options->alphabet     = NULL;
+    options->give_up      = 0;
+    options->final_cost   = 0.;
+    options->verbose      = 0;
+    options->seed         = 0;
+    options->num_starts   = 1;
+    options->num_threads  = 0;
+    options->flags        = 0;
+  }
+}
+
+
+PUBLIC float
+vrna_inverse(vrna_fold_compound_t     *fc,
+             const char               *target,
+             char                     *sequence,
+             const vrna_inverse_opt_t *options)
+{
+  unsigned int        n;
+  float               dist;
+  vrna_md_t           md;
+  vrna_inverse_opt_t  opt;
+  inverse_ctx         ctx;
+
+  if ((!target) || (!sequence)) {
+    vrna_message_warning("vrna_inverse: missing target structure or start sequence");
+    return -1.;
+  }
+
+  n = (unsigned int)strlen(target);
+  if (strlen(sequence) != n) {
+    vrna_message_warning("vrna_inverse: start sequence and target structure have unequal length");
+    return -1.;
+  }
+
+  if (fc) {
+    if ((fc->type != VRNA_FC_TYPE_SINGLE) || (fc->strands != 1) || (fc->length != n)) {
+      vrna_message_warning("vrna_inverse: "
+                           "fold compound must hold a single strand of the target's length");
+      return -1.;
+    }
+
+    md = fc->params->model_details;
+  } else {
+    vrna_md_set_default(&md);
+  }
+
+  if (options)
+    opt = *options;
+  else
+    vrna_inverse_opt_defaults(&opt);
+
+  if (opt.type == VRNA_INVERSE_PF) {
+    /* partition functions are restricted to dangles 0 or 2 */
+    if (md.dangles != 0)
+      md.dangles = 2;
+
+    md.circ = 0;
+  }
+
+  ctx_init(&ctx, opt.alphabet, &md);
+  ctx.give_up     = opt.give_up;
+  ctx.final_cost  = opt.final_cost;
+  ctx.verbose     = opt.verbose;
+  ctx.pf_scale    = ((fc) && (fc->exp_params)) ? fc->exp_params->pf_scale : -1.;
+
+  if (!make_pairset(&ctx)) {
+    vrna_message_warning("vrna_inverse: no pairs in alphabet \"%s\"", ctx.symbolset);
+    return -1.;
+  }
+
+  ctx_seed(&ctx, (opt.seed) ? opt.seed : (unsigned int)(vrna_urn() * 4294967295.));
+
+  if (fc)
+    constraints_from_template(&ctx, fc);
+
+  if (opt.num_starts > 1)
+    dist = multistart(&ctx,
+                      sequence,
+                      target,
+                      opt.num_starts,
+                      opt.num_threads,
+                      opt.flags,
+                      (opt.type == VRNA_INVERSE_PF) ? 1 : 0);
+  else if (opt.type == VRNA_INVERSE_PF)
+    dist = (float)(pf_walk(&ctx, sequence, target) + ctx.final_cost);
+  else
+    dist = (float)mfe_design(&ctx, sequence, target);
+
+  free(ctx.mask);
+
+  return dist;
+}
+
+
+/*-------------------------------------------------------------------------*/
+
+PRIVATE void
+ctx_init(inverse_ctx  *ctx,
+         const char   *alphabet,
+         vrna_md_t    *md)
+{
+  memset(ctx, 0, sizeof(inverse_ctx));
+
+  strncpy(ctx->symbolset, (alphabet) ? alphabet : "AUGC", MAXALPHA);
+  ctx->md       = *md;
+  ctx->bt_type  = md->backtrack_type;
+  ctx->pf_scale = -1.;
+  ctx->rng      = NULL;
+  ctx->stop     = NULL;
+  ctx->mask     = NULL;
+}
+
+
+/* seed the private random number stream of a design job the same way srand48() would */
+PRIVATE void
+ctx_seed(inverse_ctx  *ctx,
+         unsigned int seed)
+{
+  ctx->rng_state[0] = 0x330E;
+  ctx->rng_state[1] = (unsigned short)(seed & 0xFFFF);
+  ctx->rng_state[2] = (unsigned short)((seed >> 16) & 0xFFFF);
+  ctx->rng          = ctx->rng_state;
+}
+
+
+/* the legacy interface reads its settings from the global variables */
+PRIVATE void
+ctx_from_globals(inverse_ctx *ctx)
+{
+  vrna_md_t md;
+
+  set_model_details(&md);
+
+  ctx_init(ctx, symbolset, &md);
+  ctx->give_up    = give_up;
+  ctx->final_cost = final_cost;
+  ctx->verbose    = inv_verbose;
+  ctx->pf_scale   = pf_scale;
+}
+
+
+/*-------------------------------------------------------------------------*/
+
+PRIVATE double
+pf_walk(inverse_ctx *ctx,
+        char        *start,
+        const char  *target)
+{
+  /* partition functions are restricted to dangles 0 or 2 */
+  if (ctx->md.dangles != 0)
+    ctx->md.dangles = 2;
+
+  ctx->fold_type  = 1;
+  ctx->offset     = 0;
+  make_start(ctx, start, target);
+
+  return adaptive_walk(ctx, start, target);
+}
+
+
+/*
+ *  Run independent adaptive walks for the same target, each with its own
+ *  copy of the start sequence and its own random number stream. The seeds
+ *  of the streams are drawn from the random number stream of the job
+ *  beforehand, so the best solution does not depend on the number of threads.
+ */
+PRIVATE float
+multistart(inverse_ctx  *ctx,
+           char         *start,
+           const char   *target,
+           unsigned int num_starts,
+           int          num_threads,
+           unsigned int options,
+           int          use_pf)
 {
-  double  dist;
-  int     dang;
-
-  dang = dangles;
-  if (dangles != 0)
-    dangles = 2;
-
-  update_fold_params();     /* make sure there is a valid pair matrix */
-  make_pairset();
-  make_start(start, target);
-  fold_type     = 1;
-  do_backtrack  = 0;
-  dist          = adaptive_walk(start, target);
-  dangles       = dang;
-  return dist + final_cost;
+  char            **solutions;
+  inverse_ctx     *walks;
+  int             s, k, n, stop, winner;
+  double          *dist, *cost;
+  float           d;
+
+  n = (num_starts > 0) ? (int)num_starts : 1;
+
+#ifdef _OPENMP
+  if (num_threads <= 0)
+    num_threads = omp_get_max_threads();
+
+#endif
+
+  walks     = (inverse_ctx *)vrna_alloc(sizeof(inverse_ctx) * n);
+  solutions = (char **)vrna_alloc(sizeof(char *) * n);
+  dist      = (double *)vrna_alloc(sizeof(double) * n);
+  cost      = (double *)vrna_alloc(sizeof(double) * n);
+  stop      = 0;
+  winner    = -1;
+
+  for (s = 0; s < n; s++) {
+    walks[s] = *ctx;
+    for (k = 0; k < 3; k++)
+      walks[s].rng_state[k] = (unsigned short)(inv_urn(ctx) * 65536.);
+
+    walks[s].rng  = walks[s].rng_state;
+    walks[s].stop = (options & VRNA_INVERSE_FIRST) ? &stop : NULL;
+    solutions[s]  = strdup(start);
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+#endif
+  for (s = 0; s < n; s++) {
+    if (walk_aborted(walks + s)) {
+      dist[s] = cost[s] = DBL_MAX;
+    } else if (use_pf) {
+      cost[s] = pf_walk(walks + s, solutions[s], target);
+      dist[s] = cost[s] + walks[s].final_cost;
+    } else {
+      cost[s] = dist[s] = mfe_design(walks + s, solutions[s], target);
+    }
+
+    if ((options & VRNA_INVERSE_FIRST) && (cost[s] <= 0)) {
+#ifdef _OPENMP
+#pragma omp critical (inverse_multistart)
+#endif
+      {
+        if (winner < 0)
+          winner = s;
+      }
+
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+      stop = 1;
+    }
+  }
+
+  if (winner < 0)
+    for (winner = 0, s = 1; s < n; s++)
+      if (dist[s] < dist[winner])
+        winner = s;
+
+  strcpy(start, solutions[winner]);
+  d = (float)dist[winner];
+
+  for (s = 0; s < n; s++)
+    free(solutions[s]);
+
+  free(solutions);
+  free(walks);
+  free(dist);
+  free(cost);
+
+  return d;
 }
 
 
 /*-------------------------------------------------------------------------*/
 
 PRIVATE void
-make_start(char       *start,
-           const char *structure)
+make_start(inverse_ctx  *ctx,
+           char         *start,
+           const char   *structure)
 {
   int i, j, k, l, r, length;
   int *table, *S, sym[MAXALPHA], ss;
@@ -512,15 +943,15 @@ make_start(char       *start,
 
   make_ptable(structure, table);
   for (i = 0; i < strlen(start); i++)
-    S[i] = encode_char(toupper(start[i]));
-  for (i = 0; i < strlen(symbolset); i++)
+    S[i] = vrna_nucleotide_encode(toupper(start[i]), &(ctx->md));
+  for (i = 0; i < strlen(ctx->symbolset); i++)
     sym[i] = i;
 
   for (k = 0; k < length; k++) {
     if (table[k] < k)
       continue;
 
-    if (((vrna_urn() < 0.5) && isupper(start[k])) ||
+    if (((inv_urn(ctx) < 0.5) && isupper(start[k])) ||
         islower(start[table[k]])) {
       i = table[k];
       j = k;
@@ -529,21 +960,21 @@ make_start(char       *start,
       j = table[k];
     }
 
-    if (!pair[S[i]][S[j]]) {
+    if (!ctx->md.pair[S[i]][S[j]]) {
       /* make a valid pair by mutating j */
-      shuffle(sym, (int)base);
-      for (l = 0; l < base; l++) {
-        ss = encode_char(symbolset[sym[l]]);
-        if (pair[S[i]][ss])
+      shuffle(ctx, sym, (int)ctx->base);
+      for (l = 0; l < ctx->base; l++) {
+        ss = vrna_nucleotide_encode(ctx->symbolset[sym[l]], &(ctx->md));
+        if (ctx->md.pair[S[i]][ss])
           break;
       }
-      if (l == base) {
+      if (l == ctx->base) {
         /* nothing pairs start[i] */
-        r         = 2 * vrna_int_urn(0, npairs - 1);
-        start[i]  = pairset[r];
-        start[j]  = pairset[r + 1];
+        r         = 2 * inv_int_urn(ctx, 0, ctx->npairs - 1);
+        start[i]  = ctx->pairset[r];
+        start[j]  = ctx->pairset[r + 1];
       } else {
-        start[j] = symbolset[sym[l]];
+        start[j] = ctx->symbolset[sym[l]];
       }
     }
   }
@@ -554,37 +985,38 @@ make_start(char       *start,
 
 /*---------------------------------------------------------------------------*/
 
-PRIVATE void
-make_pairset(void)
+PRIVATE int
+make_pairset(inverse_ctx *ctx)
 {
   int i, j;
   int sym[MAXALPHA];
 
-  make_pair_matrix();
-  base = strlen(symbolset);
+  ctx->base = strlen(ctx->symbolset);
 
-  for (i = 0; i < base; i++)
-    sym[i] = encode_char(symbolset[i]);
+  for (i = 0; i < ctx->base; i++)
+    sym[i] = vrna_nucleotide_encode(ctx->symbolset[i], &(ctx->md));
 
-  for (i = npairs = 0; i < base; i++)
-    for (j = 0; j < base; j++)
-      if (pair[sym[i]][sym[j]]) {
-        pairset[npairs++] = symbolset[i];
-        pairset[npairs++] = symbolset[j];
+  for (i = ctx->npairs = 0; i < ctx->base; i++)
+    for (j = 0; j < ctx->base; j++)
+      if (ctx->md.pair[sym[i]][sym[j]]) {
+        ctx->pairset[ctx->npairs++] = ctx->symbolset[i];
+        ctx->pairset[ctx->npairs++] = ctx->symbolset[j];
       }
 
-  npairs /= 2;
-  if (npairs == 0)
-    vrna_message_error("No pairs in this alphabet!");
+  ctx->npairs /= 2;
+
+  return ctx->npairs;
 }
 
 
 /*---------------------------------------------------------------------------*/
 
 PRIVATE double
-mfe_cost(const char *string,
-         char       *structure,
-         const char *target)
+mfe_cost(inverse_ctx          *ctx,
+         vrna_fold_compound_t **fc_p,
+         const char           *string,
+         char                 *structure,
+         const char           *target)
 {
 #if TDIST
   Tree    *T1;
@@ -595,23 +1027,39 @@ mfe_cost(const char *string,
   if (strlen(string) != strlen(target))
     vrna_message_error("%s\n%s\nunequal length in mfe_cost", string, target);
 
-  energy = fold(string, structure);
+  if ((*fc_p) && (!ctx->mask)) {
+    /* re-use the DP matrices of the previous candidate */
+    energy = vrna_mfe_mutate(*fc_p, string, structure);
+  } else {
+    if (*fc_p) {
+      (void)vrna_sequence_mutate(*fc_p, string, NULL);
+    } else {
+      vrna_md_t md = ctx->md;
+
+      md.backtrack_type = ctx->bt_type;
+      *fc_p             = vrna_fold_compound(string, &md, VRNA_OPTION_DEFAULT);
+    }
+
+    constraints_apply(ctx, *fc_p);
+    energy = vrna_mfe(*fc_p, structure);
+  }
+
 #if TDIST
-  if (T0 == NULL) {
+  if (ctx->T0 == NULL) {
     xstruc  = expand_Full(target);
-    T0      = make_tree(xstruc);
+    ctx->T0 = make_tree(xstruc);
     free(xstruc);
   }
 
   xstruc    = expand_Full(structure);
   T1        = make_tree(xstruc);
-  distance  = tree_edit_distance(T0, T1);
+  distance  = tree_edit_distance(ctx->T0, T1);
   free(xstruc);
   free_tree(T1);
 #else
   distance = (double)vrna_bp_distance(target, structure);
 #endif
-  cost2 = energy_of_structure(string, target, 0) - energy;
+  ctx->cost2 = vrna_eval_structure_v(*fc_p, target, 0, NULL) - energy;
   return (double)distance;
 }
 
@@ -619,16 +1067,33 @@ mfe_cost(const char *string,
 /*---------------------------------------------------------------------------*/
 
 PRIVATE double
-pf_cost(const char  *string,
-        char        *structure,
-        const char  *target)
+pf_cost(inverse_ctx           *ctx,
+        vrna_fold_compound_t  **fc_p,
+        const char            *string,
+        char                  *structure,
+        const char            *target)
 {
 #if PF
   double f, e;
 
-  f = pf_fold(string, structure);
-  e = energy_of_structure(string, target, 0);
-  return (double)(e - f - final_cost);
+  if (*fc_p) {
+    (void)vrna_sequence_mutate(*fc_p, string, NULL);
+  } else {
+    vrna_md_t md = ctx->md;
+
+    md.circ         = 0;
+    md.compute_bpp  = 0;
+    *fc_p           = vrna_fold_compound(string, &md, VRNA_OPTION_DEFAULT);
+
+    (*fc_p)->exp_params           = vrna_exp_params(&((*fc_p)->params->model_details));
+    (*fc_p)->exp_params->pf_scale = ctx->pf_scale;
+  }
+
+  constraints_apply(ctx, *fc_p);
+
+  f = vrna_pf(*fc_p, structure);
+  e = vrna_eval_structure_v(*fc_p, target, 0, NULL);
+  return (double)(e - f - ctx->final_cost);
 #else
   vrna_message_error("this version not linked with pf_fold");
   return 0;
@@ -636,6 +1101,108 @@ pf_cost(const char  *string,
 }
 
 
+/*---------------------------------------------------------------------------*/
+
+/*
+ *  Collect the base pairs the user restricted in the hard constraints of
+ *  the template fold compound. Since the default constraints depend on the
+ *  sequence, only deviations from the defaults of the template's sequence
+ *  are kept. Positions that may not pair at all stay unpaired for any
+ *  candidate sequence.
+ */
+PRIVATE void
+constraints_from_template(inverse_ctx           *ctx,
+                          vrna_fold_compound_t  *fc)
+{
+  unsigned char         *mask, *blocked, user, def;
+  unsigned int          i, j, n, restricted, *canonical, *allowed;
+  vrna_fold_compound_t  *ref;
+
+  if ((!fc->hc) || (fc->hc->type != VRNA_HC_DEFAULT) || (!fc->hc->mx))
+    return;
+
+  n   = fc->length;
+  ref = vrna_fold_compound(fc->sequence, &(fc->params->model_details), VRNA_OPTION_EVAL_ONLY);
+  vrna_hc_init(ref);
+
+  mask        = (unsigned char *)vrna_alloc(sizeof(unsigned char) * (n + 1) * (n + 1));
+  blocked     = (unsigned char *)vrna_alloc(sizeof(unsigned char) * (n + 1));
+  canonical   = (unsigned int *)vrna_alloc(sizeof(unsigned int) * (n + 1));
+  allowed     = (unsigned int *)vrna_alloc(sizeof(unsigned int) * (n + 1));
+  restricted  = 0;
+
+  memset(mask, MASK_UNRESTRICTED, sizeof(unsigned char) * (n + 1) * (n + 1));
+
+  for (i = 1; i < n; i++)
+    for (j = i + 1; j <= n; j++) {
+      def   = ref->hc->mx[n * i + j];
+      user  = fc->hc->mx[n * i + j];
+
+      if (def) {
+        canonical[i]++;
+        canonical[j]++;
+        if (user) {
+          allowed[i]++;
+          allowed[j]++;
+        }
+      }
+
+      if (user != def) {
+        mask[(n + 1) * i + j] = user;
+        restricted            = 1;
+      }
+    }
+
+  for (i = 1; i <= n; i++)
+    blocked[i] = ((canonical[i] > 0) && (allowed[i] == 0)) ? 1 : 0;
+
+  for (i = 1; i < n; i++)
+    for (j = i + 1; j <= n; j++)
+      if ((blocked[i]) || (blocked[j]))
+        mask[(n + 1) * i + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
+
+  if (restricted) {
+    ctx->mask   = mask;
+    ctx->mask_n = n;
+  } else {
+    free(mask);
+  }
+
+  free(allowed);
+  free(canonical);
+  free(blocked);
+  vrna_fold_compound_free(ref);
+}
+
+
+/* restrict the base pairs of a candidate (sub-)sequence according to the template */
+PRIVATE void
+constraints_apply(inverse_ctx           *ctx,
+                  vrna_fold_compound_t  *fc)
+{
+  unsigned char m, c;
+  unsigned int  i, j, n, N, o;
+
+  if (!ctx->mask)
+    return;
+
+  n = fc->length;
+  N = ctx->mask_n + 1;
+  o = ctx->offset;
+
+  for (i = 1; i < n; i++)
+    for (j = i + 1; j <= n; j++) {
+      m = ctx->mask[N * (i + o) + j + o];
+      if (m != MASK_UNRESTRICTED) {
+        c                                 = fc->hc->mx[n * i + j] & m;
+        fc->hc->mx[n * i + j]             = c;
+        fc->hc->mx[n * j + i]             = c;
+        fc->hc->matrix[fc->jindx[j] + i]  = c;
+      }
+    }
+}
+
+
 /*---------------------------------------------------------------------------*/
 
 PRIVATE char *
@@ -676,3 +1243,38 @@ aux_struct(const char *structure)
   free(match_paren);
   return string;
 }
+
+
+/*---------------------------------------------------------------------------*/
+
+PRIVATE INLINE double
+inv_urn(inverse_ctx *ctx)
+{
+  /* design jobs may use their own random number stream */
+  return (ctx->rng) ? erand48(ctx->rng) : vrna_urn();
+}
+
+
+PRIVATE INLINE int
+inv_int_urn(inverse_ctx *ctx,
+            int         from,
+            int         to)
+{
+  return ((int)(inv_urn(ctx) * (to - from + 1))) + from;
+}
+
+
+PRIVATE INLINE int
+walk_aborted(inverse_ctx *ctx)
+{
+  int stop = 0;
+
+  if (ctx->stop) {
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+    stop = *(ctx->stop);
+  }
+
+  return stop;
+}
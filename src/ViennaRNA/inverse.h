@@ -1,6 +1,8 @@
 #ifndef VIENNA_RNA_PACKAGE_INVERSE_H
 #define VIENNA_RNA_PACKAGE_INVERSE_H
 
+#include <ViennaRNA/fold_compound.h>
+
 /**
  *  @file     inverse.h
  *  @ingroup  inverse_fold
@@ -61,6 +63,141 @@ float inverse_fold( char *start,
 float inverse_pf_fold(char *start,
                       const char *target);
 
+
+/**
+ *  @brief  Option flag for the multi-start design functions to stop as soon as
+ *          any of the adaptive walks found a solution
+ *
+ *  @see inverse_fold_multistart(), inverse_pf_fold_multistart()
+ */
+#define VRNA_INVERSE_FIRST    1U
+
+/**
+ *  \brief Find sequences with predefined structure using several independent adaptive walks
+ *
+ *  Runs @p num_starts independent searches of inverse_fold() for the same
+ *  start sequence and target structure, spread over @p num_threads OpenMP
+ *  threads (all available cores if @p num_threads is not positive). Each search
+ *  uses its own random number stream, seeded from the global generator before
+ *  any search starts. By default, the best solution of all searches (the first
+ *  in case of ties) is returned in @p start, which makes the result independent
+ *  of the number of threads. With #VRNA_INVERSE_FIRST, the remaining searches are
+ *  cancelled as soon as one of them succeeded, and the first solution found is
+ *  returned instead.
+ *
+ *  \param  start       The start sequence
+ *  \param  target      The target secondary structure in dot-bracket notation
+ *  \param  num_starts  The number of independent searches
+ *  \param  num_threads The number of parallel threads (<= 0 for all available cores)
+ *  \param  options     Either 0, or #VRNA_INVERSE_FIRST
+ *  \return             The distance of the returned solution as in inverse_fold()
+ */
+float inverse_fold_multistart(char          *start,
+                              const char    *target,
+                              unsigned int  num_starts,
+                              int           num_threads,
+                              unsigned int  options);
+
+/**
+ *  \brief Find sequences that maximize the probability of a predefined structure using
+ *  several independent adaptive walks
+ *
+ *  The partition function variant of inverse_fold_multistart(), see also inverse_pf_fold().
+ *
+ *  \param  start       The start sequence
+ *  \param  target      The target secondary structure in dot-bracket notation
+ *  \param  num_starts  The number of independent searches
+ *  \param  num_threads The number of parallel threads (<= 0 for all available cores)
+ *  \param  options     Either 0, or #VRNA_INVERSE_FIRST
+ *  \return             The distance of the returned solution as in inverse_pf_fold()
+ */
+float inverse_pf_fold_multistart(char         *start,
+                                 const char   *target,
+                                 unsigned int num_starts,
+                                 int          num_threads,
+                                 unsigned int options);
+
+/**
+ *  @brief  Design objective of vrna_inverse(): Find a sequence whose MFE structure is the target
+ *
+ *  @see vrna_inverse(), #vrna_inverse_opt_t.type
+ */
+#define VRNA_INVERSE_MFE      0U
+
+/**
+ *  @brief  Design objective of vrna_inverse(): Maximize the probability of the target structure
+ *
+ *  @see vrna_inverse(), #vrna_inverse_opt_t.type
+ */
+#define VRNA_INVERSE_PF       1U
+
+/**
+ *  @brief  Settings of a single design job of vrna_inverse()
+ *
+ *  Use vrna_inverse_opt_defaults() to initialize the settings before changing
+ *  individual fields.
+ */
+typedef struct {
+  unsigned int  type;         /**<  @brief  Design objective, either #VRNA_INVERSE_MFE or
+                               *            #VRNA_INVERSE_PF
+                               */
+  const char    *alphabet;    /**<  @brief  Nucleotides the design may use (NULL for "AUGC") */
+  int           give_up;      /**<  @brief  Stop as soon as it is clear that no exact solution
+                               *            will be found
+                               */
+  double        final_cost;   /**<  @brief  When to stop the partition function based design */
+  int           verbose;      /**<  @brief  Print the substructure on which the design failed */
+  unsigned int  seed;         /**<  @brief  Seed of the random number stream of the job
+                               *            (0 to draw one from the global generator)
+                               */
+  unsigned int  num_starts;   /**<  @brief  Number of independent adaptive walks */
+  int           num_threads;  /**<  @brief  Number of threads for the walks
+                               *            (<= 0 for all available cores)
+                               */
+  unsigned int  flags;        /**<  @brief  Either 0, or #VRNA_INVERSE_FIRST */
+} vrna_inverse_opt_t;
+
+/**
+ *  @brief  Initialize the settings of a design job with their defaults
+ *
+ *  The defaults design for the MFE structure over the "AUGC" alphabet using a
+ *  single adaptive walk with a randomly drawn seed.
+ *
+ *  @param  options   The settings to initialize
+ */
+void
+vrna_inverse_opt_defaults(vrna_inverse_opt_t *options);
+
+
+/**
+ *  @brief  Find a sequence that folds into a predefined structure
+ *
+ *  This is the re-entrant variant of inverse_fold() and inverse_pf_fold(). All
+ *  settings are taken from @p options and the model details of @p fc instead of
+ *  global variables, and the random number stream is private to the job. Thus,
+ *  several designs may run concurrently, and a job with a fixed
+ *  #vrna_inverse_opt_t.seed yields the same result no matter how many other
+ *  jobs run at the same time.
+ *
+ *  Base pairs that were restricted by hard constraints of @p fc, e.g. through
+ *  vrna_hc_add_bp() or vrna_constraints_add(), remain restricted for every
+ *  candidate sequence of the design. Nucleotides that may not pair at all stay
+ *  unpaired. The target structure itself should comply with these constraints.
+ *  Lowercase letters in @p sequence mark positions that must not be mutated.
+ *
+ *  @param  fc        A fold compound that provides model details and constraints (may be NULL)
+ *  @param  target    The target secondary structure in dot-bracket notation
+ *  @param  sequence  The start sequence, overwritten by the designed sequence
+ *  @param  options   The settings of the design job (NULL for defaults)
+ *  @return           The distance to the target as in inverse_fold() or inverse_pf_fold(),
+ *                    or -1 on error
+ */
+float
+vrna_inverse(vrna_fold_compound_t     *fc,
+             const char               *target,
+             char                     *sequence,
+             const vrna_inverse_opt_t *options);
+
 /**
  *  @}
  */
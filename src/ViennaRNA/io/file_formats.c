@@ -27,6 +27,13 @@
 #endif
 #include "ViennaRNA/io/file_formats.h"
 
+#ifdef VRNA_WITH_ZLIB
+# include <zlib.h>
+# if VRNA_WITH_PTHREADS
+#  include <pthread.h>
+# endif
+#endif
+
 #define DEBUG
 /*
 #################################
@@ -38,6 +45,60 @@ PRIVATE char          *inbuf  = NULL;
 PRIVATE char          *inbuf2 = NULL;
 PRIVATE unsigned int  typebuf = 0;
 
+/* initial size of the read buffer of a fasta reader, it grows with the largest data set */
+#define FASTA_READER_BUFFER         (1 << 20)
+/* size and number of the chunks of decompressed input, and size of the compressed input buffer */
+#define FASTA_READER_INFLATE_CHUNK  (1 << 20)
+#define FASTA_READER_INFLATE_SLOTS  4
+#define FASTA_READER_INFLATE_INPUT  (1 << 18)
+
+#ifdef VRNA_WITH_ZLIB
+typedef struct {
+  z_stream        strm;
+  FILE            *file;
+  unsigned char   *in;
+  int             done;     /* end of the compressed input, or an error occured */
+  int             threaded;
+#if VRNA_WITH_PTHREADS
+  pthread_t       thread;
+  pthread_mutex_t mtx;
+  pthread_cond_t  cond;
+  char            *chunk[FASTA_READER_INFLATE_SLOTS];
+  size_t          chunk_size[FASTA_READER_INFLATE_SLOTS];
+  unsigned int    head;     /* the chunk that is consumed next */
+  unsigned int    count;    /* number of decompressed chunks that wait to be consumed */
+  size_t          consumed; /* number of bytes already consumed from chunk[head] */
+  int             finished; /* the decompression thread has finished */
+  int             stop;     /* ask the decompression thread to finish */
+#endif
+} inflate_source;
+#endif
+
+struct vrna_fasta_reader_s {
+  FILE            *file;
+  int             close_file;
+  char            *buf;         /* read buffer of size + 1 bytes */
+  size_t          size;
+  size_t          pos;          /* beginning of the data not yet consumed */
+  size_t          end;          /* end of the data in the buffer */
+  int             eof;
+#ifdef VRNA_WITH_ZLIB
+  inflate_source  *gz;
+#endif
+
+  /* the data set that is currently read, as offsets relative to pos */
+  int             has_header;
+  size_t          header_offset;
+  size_t          header_length;
+  size_t          sequence_offset;
+  size_t          sequence_length;
+  size_t          *rest_offset;
+  size_t          *rest_length;
+  const char      **rest;
+  unsigned int    rest_count;
+  unsigned int    rest_size;
+};
+
 /*
 #################################
 # PRIVATE FUNCTION DECLARATIONS #
@@ -47,17 +108,29 @@ PRIVATE unsigned int  typebuf = 0;
 PRIVATE unsigned int
 read_multiple_input_lines(char **string, FILE *file, unsigned int option);
 
-PRIVATE void
+PRIVATE int
 elim_trailing_ws(char *string);
 
+PRIVATE void
+append_line(char        **string,
+            int         *length,
+            int         *size,
+            char        **line,
+            int         l);
+
+PRIVATE unsigned int
+reader_parse_record(vrna_fasta_reader_t reader,
+                    size_t              *cursor,
+                    unsigned int        options);
+
 /*
 #################################
 # BEGIN OF FUNCTION DEFINITIONS #
 #################################
 */
 
-/* eliminate whitespaces/non-printable characters at the end of a character string */
-PRIVATE void
+/* eliminate whitespaces/non-printable characters at the end of a character string, returns the new length */
+PRIVATE int
 elim_trailing_ws(char *string)
 {
   int i, l = strlen(string);
@@ -69,6 +142,41 @@ elim_trailing_ws(char *string)
     break;
   }
   string[(i >= 0) ? (i+1) : 0] = '\0';
+
+  return (i >= 0) ? (i+1) : 0;
+}
+
+/*
+ *  append a line of length l to a string of the given length and size
+ *  (allocated bytes). The first line of a block is taken over without
+ *  copying, further lines are appended to a buffer that grows geometrically
+ *  such that the costs for reading a block remain linear in its length.
+ */
+PRIVATE void
+append_line(char        **string,
+            int         *length,
+            int         *size,
+            char        **line,
+            int         l)
+{
+  if(!(*string)){
+    *string = *line;
+    *line   = NULL;
+    *length = l;
+    *size   = l + 1;
+    return;
+  }
+
+  if(*length + l + 1 > *size){
+    *size   = 2 * (*length + l + 1);
+    *string = (char *)vrna_realloc(*string, sizeof(char) * (*size));
+  }
+
+  memcpy(*string + *length,
+         *line,
+         sizeof(char) * l);
+  *length += l;
+  (*string)[*length] = '\0';
 }
 
 PUBLIC void
@@ -241,9 +349,12 @@ read_multiple_input_lines(char **string,
   char  *line;
   int   i, l;
   int   state = 0;
-  int   str_length = 0;
+  int   str_length, str_size;
   FILE  *in = (file) ? file : stdin;
 
+  str_length  = (*string) ? (int) strlen(*string) : 0;
+  str_size    = str_length + 1;
+
   line = (inbuf2) ? inbuf2 : vrna_read_line(in);
   inbuf2 = NULL;
   do{
@@ -254,14 +365,11 @@ read_multiple_input_lines(char **string,
     */
     if(!line) return VRNA_INPUT_ERROR;
 
-    l = (int)strlen(line);
-
     /* eliminate whitespaces at the end of the line read */
     if(!(option & VRNA_INPUT_NO_TRUNCATION))
-      elim_trailing_ws(line);
-
-    l           = (int)strlen(line);
-    str_length  = (*string) ? (int) strlen(*string) : 0;
+      l = elim_trailing_ws(line);
+    else
+      l = (int)strlen(line);
 
     switch(*line){
       case  '@':    /* user abort */
@@ -305,11 +413,7 @@ read_multiple_input_lines(char **string,
                         /* are we in structure mode? Then we remember this line for the next round */
                         if(state == 2){ inbuf2 = line; return VRNA_INPUT_CONSTRAINT;}
                         else{
-                          *string = (char *)vrna_realloc(*string, sizeof(char) * (str_length + l + 1));
-                          memcpy(*string + str_length,
-                                 line,
-                                 sizeof(char) * l);
-                          (*string)[str_length + l] = '\0';
+                          append_line(string, &str_length, &str_size, &line, l);
                           state = 1;
                         }
                         break;
@@ -328,11 +432,7 @@ read_multiple_input_lines(char **string,
                         return VRNA_INPUT_SEQUENCE;
                       }
                       else{
-                        *string = (char *)vrna_realloc(*string, sizeof(char) * (str_length + l + 1));
-                        memcpy(*string + str_length,
-                               line,
-                               sizeof(char) * l);
-                        (*string)[str_length + l] = '\0';
+                        append_line(string, &str_length, &str_size, &line, l);
                         state = 2;
                       }
                     }
@@ -349,11 +449,7 @@ read_multiple_input_lines(char **string,
                         return VRNA_INPUT_CONSTRAINT;
                       }
                       else{
-                        *string = (char *)vrna_realloc(*string, sizeof(char) * (str_length + l + 1));
-                        memcpy(*string + str_length,
-                               line,
-                               sizeof(char) * l);
-                        (*string)[str_length + l] = '\0';
+                        append_line(string, &str_length, &str_size, &line, l);
                         state = 1;
                       }
                     }
@@ -427,6 +523,7 @@ vrna_file_fasta_read_record( char **header,
   } else {
     vrna_message_warning("vrna_file_fasta_read_record: "
                          "sequence input missing!");
+    free(input_string);
     return VRNA_INPUT_ERROR;
   }
 
@@ -455,6 +552,647 @@ vrna_file_fasta_read_record( char **header,
   return (return_type);
 }
 
+#ifdef VRNA_WITH_ZLIB
+
+/*
+ *  Decompress the next at most n bytes of the input into dst. Returns the
+ *  number of bytes written, which is 0 only at the end of the input
+ */
+PRIVATE size_t
+inflate_input(inflate_source  *gz,
+              char            *dst,
+              size_t          n)
+{
+  int ret;
+
+  gz->strm.next_out   = (unsigned char *)dst;
+  gz->strm.avail_out  = n;
+
+  while((gz->strm.avail_out > 0) && (!gz->done)){
+    if(gz->strm.avail_in == 0){
+      gz->strm.next_in  = gz->in;
+      gz->strm.avail_in = fread(gz->in, sizeof(unsigned char), FASTA_READER_INFLATE_INPUT, gz->file);
+      if(gz->strm.avail_in == 0){
+        vrna_message_warning("vrna_file_fasta_reader: "
+                             "unexpected end of compressed input");
+        gz->done = 1;
+        break;
+      }
+    }
+
+    ret = inflate(&(gz->strm), Z_NO_FLUSH);
+
+    if(ret == Z_STREAM_END){
+      /* further gzip members may follow, e.g. in files written by bgzip */
+      if(gz->strm.avail_in == 0){
+        gz->strm.next_in  = gz->in;
+        gz->strm.avail_in = fread(gz->in, sizeof(unsigned char), FASTA_READER_INFLATE_INPUT, gz->file);
+      }
+
+      if(gz->strm.avail_in == 0)
+        gz->done = 1;
+      else
+        inflateReset(&(gz->strm));
+    } else if((ret != Z_OK) && (ret != Z_BUF_ERROR)){
+      vrna_message_warning("vrna_file_fasta_reader: "
+                           "corrupt compressed input (%s)",
+                           (gz->strm.msg) ? gz->strm.msg : "unknown error");
+      gz->done = 1;
+    }
+  }
+
+  return n - gz->strm.avail_out;
+}
+
+
+#if VRNA_WITH_PTHREADS
+
+/* decompress the input ahead of the reader into a ring of chunks */
+PRIVATE void *
+inflate_thread(void *data)
+{
+  inflate_source  *gz = (inflate_source *)data;
+  unsigned int    slot;
+  size_t          n;
+
+  pthread_mutex_lock(&(gz->mtx));
+
+  while((!gz->stop) && (!gz->done)){
+    if(gz->count == FASTA_READER_INFLATE_SLOTS){
+      pthread_cond_wait(&(gz->cond), &(gz->mtx));
+      continue;
+    }
+
+    slot = (gz->head + gz->count) % FASTA_READER_INFLATE_SLOTS;
+    pthread_mutex_unlock(&(gz->mtx));
+
+    n = inflate_input(gz, gz->chunk[slot], FASTA_READER_INFLATE_CHUNK);
+
+    pthread_mutex_lock(&(gz->mtx));
+    if(n > 0){
+      gz->chunk_size[slot] = n;
+      gz->count++;
+      pthread_cond_broadcast(&(gz->cond));
+    }
+  }
+
+  gz->finished = 1;
+  pthread_cond_broadcast(&(gz->cond));
+  pthread_mutex_unlock(&(gz->mtx));
+
+  return NULL;
+}
+
+#endif
+
+
+PRIVATE inflate_source *
+inflate_source_init(FILE        *file,
+                    const char  *data,
+                    size_t      n)
+{
+  inflate_source *gz = (inflate_source *)vrna_alloc(sizeof(inflate_source));
+
+  gz->file  = file;
+  gz->in    = (unsigned char *)vrna_alloc(sizeof(unsigned char) * FASTA_READER_INFLATE_INPUT);
+  memcpy(gz->in, data, sizeof(char) * n);
+  gz->strm.next_in  = gz->in;
+  gz->strm.avail_in = n;
+
+  /* 15 + 16: maximum window size, gzip header */
+  if(inflateInit2(&(gz->strm), 15 + 16) != Z_OK){
+    free(gz->in);
+    free(gz);
+    return NULL;
+  }
+
+#if VRNA_WITH_PTHREADS
+  unsigned int i;
+
+  for(i = 0; i < FASTA_READER_INFLATE_SLOTS; i++)
+    gz->chunk[i] = (char *)vrna_alloc(sizeof(char) * FASTA_READER_INFLATE_CHUNK);
+
+  pthread_mutex_init(&(gz->mtx), NULL);
+  pthread_cond_init(&(gz->cond), NULL);
+
+  /* decompress in the reading thread if no other thread can be started */
+  gz->threaded = (pthread_create(&(gz->thread), NULL, &inflate_thread, (void *)gz) == 0) ? 1 : 0;
+#endif
+
+  return gz;
+}
+
+
+PRIVATE size_t
+inflate_source_read(inflate_source  *gz,
+                    char            *dst,
+                    size_t          n)
+{
+  if(!gz->threaded)
+    return inflate_input(gz, dst, n);
+
+#if VRNA_WITH_PTHREADS
+  char    *src;
+  size_t  avail;
+
+  pthread_mutex_lock(&(gz->mtx));
+  while((gz->count == 0) && (!gz->finished))
+    pthread_cond_wait(&(gz->cond), &(gz->mtx));
+
+  if(gz->count == 0){
+    pthread_mutex_unlock(&(gz->mtx));
+    return 0;
+  }
+
+  /* the chunk at head is not touched by the decompression thread until we release it */
+  src   = gz->chunk[gz->head] + gz->consumed;
+  avail = gz->chunk_size[gz->head] - gz->consumed;
+  pthread_mutex_unlock(&(gz->mtx));
+
+  n = MIN2(n, avail);
+  memcpy(dst, src, sizeof(char) * n);
+
+  pthread_mutex_lock(&(gz->mtx));
+  gz->consumed += n;
+  if(gz->consumed == gz->chunk_size[gz->head]){
+    gz->head      = (gz->head + 1) % FASTA_READER_INFLATE_SLOTS;
+    gz->consumed  = 0;
+    gz->count--;
+    pthread_cond_broadcast(&(gz->cond));
+  }
+  pthread_mutex_unlock(&(gz->mtx));
+#endif
+
+  return n;
+}
+
+
+PRIVATE void
+inflate_source_free(inflate_source *gz)
+{
+#if VRNA_WITH_PTHREADS
+  unsigned int i;
+
+  if(gz->threaded){
+    pthread_mutex_lock(&(gz->mtx));
+    gz->stop = 1;
+    pthread_cond_broadcast(&(gz->cond));
+    pthread_mutex_unlock(&(gz->mtx));
+    pthread_join(gz->thread, NULL);
+  }
+
+  pthread_mutex_destroy(&(gz->mtx));
+  pthread_cond_destroy(&(gz->cond));
+
+  for(i = 0; i < FASTA_READER_INFLATE_SLOTS; i++)
+    free(gz->chunk[i]);
+#endif
+
+  inflateEnd(&(gz->strm));
+  free(gz->in);
+  free(gz);
+}
+
+#endif
+
+
+/*
+ *  Append more input to the read buffer. Data that has already been consumed is
+ *  dropped from the front of the buffer first, or the buffer is enlarged if it
+ *  is completely occupied by the current data set. Returns 0 at the end of the input
+ */
+PRIVATE int
+reader_fill(vrna_fasta_reader_t reader)
+{
+  size_t n;
+
+  if(reader->eof)
+    return 0;
+
+  if(reader->end == reader->size){
+    if(reader->pos > 0){
+      memmove(reader->buf,
+              reader->buf + reader->pos,
+              sizeof(char) * (reader->end - reader->pos));
+      reader->end -= reader->pos;
+      reader->pos  = 0;
+    } else {
+      reader->size *= 2;
+      reader->buf   = (char *)vrna_realloc(reader->buf, sizeof(char) * (reader->size + 1));
+    }
+  }
+
+#ifdef VRNA_WITH_ZLIB
+  if(reader->gz)
+    n = inflate_source_read(reader->gz, reader->buf + reader->end, reader->size - reader->end);
+  else
+#endif
+  n = fread(reader->buf + reader->end, sizeof(char), reader->size - reader->end, reader->file);
+
+  if(n == 0){
+    reader->eof = 1;
+    return 0;
+  }
+
+  reader->end += n;
+
+  return 1;
+}
+
+
+/*
+ *  Find the line that starts at offset cursor (relative to the unconsumed data)
+ *  and store its length without the newline character, and the offset of the
+ *  following line. Returns 0 at the end of the input
+ */
+PRIVATE int
+reader_line(vrna_fasta_reader_t reader,
+            size_t              cursor,
+            size_t              *length,
+            size_t              *next)
+{
+  char    *nl;
+  size_t  scan = cursor;
+
+  while(1){
+    nl = (char *)memchr(reader->buf + reader->pos + scan,
+                        '\n',
+                        reader->end - reader->pos - scan);
+    if(nl){
+      *length = (size_t)(nl - (reader->buf + reader->pos + cursor));
+      *next   = cursor + *length + 1;
+      return 1;
+    }
+
+    scan = reader->end - reader->pos;
+
+    if(!reader_fill(reader)){
+      /* last line without a trailing newline */
+      if(reader->end - reader->pos > cursor){
+        *length = reader->end - reader->pos - cursor;
+        *next   = reader->end - reader->pos;
+        return 1;
+      }
+
+      return 0;
+    }
+  }
+}
+
+
+/* the same as elim_trailing_ws() but without modifying the line */
+PRIVATE size_t
+trailing_ws_length(const char *line,
+                   size_t     l)
+{
+  while((l > 0) &&
+        (isspace((unsigned char)line[l-1]) || (!isprint((unsigned char)line[l-1]))))
+    l--;
+
+  return l;
+}
+
+
+#define BLOCK_TYPE(state, type) (((state) == 2) ? VRNA_INPUT_CONSTRAINT : ((state) == 1) ? VRNA_INPUT_SEQUENCE : (type))
+
+/*
+ *  The counterpart of read_multiple_input_lines() for the read buffer of a reader.
+ *  Lines are consumed by advancing the cursor, a line that belongs to the next
+ *  block is simply left unconsumed. The lines of a block that spans several lines
+ *  are joined in place at the position of its first line
+ */
+PRIVATE unsigned int
+reader_read_block(vrna_fasta_reader_t reader,
+                  size_t              *cursor,
+                  unsigned int        option,
+                  size_t              *offset,
+                  size_t              *length)
+{
+  char    *line;
+  size_t  i, l, line_length, next;
+  int     state, append;
+
+  state   = 0;
+  *offset = *length = 0;
+
+  while(reader_line(reader, *cursor, &line_length, &next)){
+    line    = reader->buf + reader->pos + *cursor;
+    append  = 0;
+
+    /* eliminate whitespaces at the end of the line read */
+    if(!(option & VRNA_INPUT_NO_TRUNCATION))
+      l = trailing_ws_length(line, line_length);
+    else
+      l = line_length;
+
+    switch((l > 0) ? *line : '\0'){
+      case  '@':    /* user abort */
+                    if(state) return BLOCK_TYPE(state, 0);
+                    *cursor = next;
+                    return VRNA_INPUT_QUIT;
+
+      case  '\0':   /* empty line */
+                    if(option & VRNA_INPUT_NOSKIP_BLANK_LINES){
+                      if(state) return BLOCK_TYPE(state, 0);
+                      *cursor = next;
+                      return VRNA_INPUT_BLANK_LINE;
+                    }
+                    break;
+
+      case  '#': case  '%': case  ';': case  '/': case  '*': case ' ':
+                    /* comments */
+                    if(option & VRNA_INPUT_NOSKIP_COMMENTS){
+                      if(state) return BLOCK_TYPE(state, 0);
+                      *offset = *cursor;
+                      *length = l;
+                      *cursor = next;
+                      return VRNA_INPUT_COMMENT;
+                    }
+                    break;
+
+      case  '>':    /* fasta header */
+                    if(state) return BLOCK_TYPE(state, 0);
+                    *offset = *cursor;
+                    *length = l;
+                    *cursor = next;
+                    return VRNA_INPUT_FASTA_HEADER;
+
+      case  'x': case 'e': case 'l': case '&':   /* seems to be a constraint or line starting with second sequence for dimer calculations */
+                    i = 1;
+                    while((i < l) && ((line[i] == 'x') || (line[i] == 'e') || (line[i] == 'l'))) i++;
+                    /* lines solely consisting of 'x's, 'e's or 'l's will be considered as structure constraint */
+                    if((i < l) && (
+                            ((line[i]>64) && (line[i]<91))  /* A-Z */
+                        ||  ((line[i]>96) && (line[i]<123)) /* a-z */
+                      )){
+                      if(option & VRNA_INPUT_FASTA_HEADER){
+                        if(state == 2) return VRNA_INPUT_CONSTRAINT;
+                        state = append = 1;
+                        break;
+                      }
+                      *offset = *cursor;
+                      *length = l;
+                      *cursor = next;
+                      return VRNA_INPUT_SEQUENCE;
+                    }
+                    /* mmmh? it really seems to be a constraint */
+                    /* fallthrough */
+      case  '<': case  '.': case  '|': case  '(': case ')': case '[': case ']': case '{': case '}': case ',': case '+':
+                    /* seems to be a structure or a constraint */
+                    if(option & VRNA_INPUT_FASTA_HEADER){
+                      if(state == 1) return VRNA_INPUT_SEQUENCE;
+                      state   = 2;
+                      append  = 1;
+                      break;
+                    }
+                    *offset = *cursor;
+                    *length = l;
+                    *cursor = next;
+                    return VRNA_INPUT_CONSTRAINT;
+
+      default:      if(option & VRNA_INPUT_FASTA_HEADER){
+                      if(state == 2) return VRNA_INPUT_CONSTRAINT;
+                      state = append = 1;
+                      break;
+                    }
+                    *offset = *cursor;
+                    *length = l;
+                    *cursor = next;
+                    return VRNA_INPUT_SEQUENCE;
+    }
+
+    /* append the line to the current block, unless it was skipped */
+    if(append){
+      if(!(*length)){
+        *offset = *cursor;
+        *length = l;
+      } else {
+        memmove(reader->buf + reader->pos + *offset + *length,
+                reader->buf + reader->pos + *cursor,
+                sizeof(char) * l);
+        *length += l;
+      }
+    }
+
+    *cursor = next;
+  }
+
+  return BLOCK_TYPE(state, VRNA_INPUT_ERROR);
+}
+
+
+/*
+ *  The counterpart of vrna_file_fasta_read_record() for a reader. Offsets of the
+ *  data set are stored in the reader relative to its unconsumed data, the cursor
+ *  is set to the beginning of the next data set
+ */
+PRIVATE unsigned int
+reader_parse_record(vrna_fasta_reader_t reader,
+                    size_t              *cursor,
+                    unsigned int        options)
+{
+  unsigned int  input_type, return_type, tmp_type;
+  size_t        offset, length, last;
+
+  return_type = 0;
+
+  /* remove unnecessary option flags from options variable... */
+  options &= ~VRNA_INPUT_FASTA_HEADER;
+
+  input_type = reader_read_block(reader, cursor, options, &offset, &length);
+  if(input_type & (VRNA_INPUT_QUIT | VRNA_INPUT_ERROR)) return input_type;
+
+  /* skip everything until we read either a fasta header or a sequence */
+  while(input_type & (VRNA_INPUT_MISC | VRNA_INPUT_CONSTRAINT | VRNA_INPUT_BLANK_LINE)){
+    input_type = reader_read_block(reader, cursor, options, &offset, &length);
+    if(input_type & (VRNA_INPUT_QUIT | VRNA_INPUT_ERROR)) return input_type;
+  }
+
+  if(input_type & VRNA_INPUT_FASTA_HEADER){
+    return_type           |= VRNA_INPUT_FASTA_HEADER; /* remember that we've read a fasta header */
+    reader->has_header    = 1;
+    reader->header_offset = offset;
+    reader->header_length = length;
+    /* get next data-block with fasta support if not explicitely forbidden by VRNA_INPUT_NO_SPAN */
+    input_type  = reader_read_block(reader,
+                                    cursor,
+                                    ((options & VRNA_INPUT_NO_SPAN) ? 0 : VRNA_INPUT_FASTA_HEADER) | options,
+                                    &offset,
+                                    &length);
+    if(input_type & (VRNA_INPUT_QUIT | VRNA_INPUT_ERROR)) return (return_type | input_type);
+  }
+
+  if(input_type & VRNA_INPUT_SEQUENCE){
+    return_type             |= VRNA_INPUT_SEQUENCE; /* remember that we've read a sequence */
+    reader->sequence_offset = offset;
+    reader->sequence_length = length;
+  } else {
+    vrna_message_warning("vrna_file_fasta_read_record_view: "
+                         "sequence input missing!");
+    return VRNA_INPUT_ERROR;
+  }
+
+  /* read the rest until we find user abort, EOF, new sequence or new fasta header */
+  if(!(options & VRNA_INPUT_NO_REST)){
+    options |= VRNA_INPUT_NOSKIP_COMMENTS; /* allow commetns to appear in rest output */
+    tmp_type = VRNA_INPUT_QUIT | VRNA_INPUT_ERROR | VRNA_INPUT_SEQUENCE | VRNA_INPUT_FASTA_HEADER;
+    if(options & VRNA_INPUT_NOSKIP_BLANK_LINES) tmp_type |= VRNA_INPUT_BLANK_LINE;
+
+    while(1){
+      last        = *cursor;
+      input_type  = reader_read_block(reader, cursor, options, &offset, &length);
+
+      /* the block belongs to the next data set, so we leave it to the next call */
+      if(input_type & tmp_type){
+        *cursor = last;
+        break;
+      }
+
+      if(reader->rest_count == reader->rest_size){
+        reader->rest_size   = 2 * reader->rest_size + 4;
+        reader->rest_offset = (size_t *)vrna_realloc(reader->rest_offset, sizeof(size_t) * reader->rest_size);
+        reader->rest_length = (size_t *)vrna_realloc(reader->rest_length, sizeof(size_t) * reader->rest_size);
+        reader->rest        = (const char **)vrna_realloc(reader->rest, sizeof(char *) * (reader->rest_size + 1));
+      }
+
+      reader->rest_offset[reader->rest_count]   = offset;
+      reader->rest_length[reader->rest_count++] = length;
+    }
+  }
+
+  return return_type;
+}
+
+
+PUBLIC vrna_fasta_reader_t
+vrna_file_fasta_reader_init(FILE *file)
+{
+  vrna_fasta_reader_t reader;
+
+  reader        = (vrna_fasta_reader_t)vrna_alloc(sizeof(struct vrna_fasta_reader_s));
+  reader->file  = (file) ? file : stdin;
+  reader->size  = FASTA_READER_BUFFER;
+  reader->buf   = (char *)vrna_alloc(sizeof(char) * (reader->size + 1));
+  reader->rest  = (const char **)vrna_alloc(sizeof(char *));
+
+  /* look for the magic bytes of gzip compressed input */
+  reader->end = fread(reader->buf, sizeof(char), 2, reader->file);
+
+  if((reader->end == 2) &&
+     ((unsigned char)reader->buf[0] == 0x1f) &&
+     ((unsigned char)reader->buf[1] == 0x8b)){
+#ifdef VRNA_WITH_ZLIB
+    reader->gz  = inflate_source_init(reader->file, reader->buf, 2);
+    reader->end = 0;
+    if(!reader->gz){
+      vrna_message_warning("vrna_file_fasta_reader_init: "
+                           "failed to initialize decompression of input");
+      vrna_file_fasta_reader_free(reader);
+      return NULL;
+    }
+#else
+    vrna_message_warning("vrna_file_fasta_reader_init: "
+                         "input is gzip compressed but RNAlib was built without zlib support");
+    vrna_file_fasta_reader_free(reader);
+    return NULL;
+#endif
+  }
+
+  return reader;
+}
+
+
+PUBLIC vrna_fasta_reader_t
+vrna_file_fasta_reader_open(const char *filename)
+{
+  FILE                *fp;
+  vrna_fasta_reader_t reader;
+
+  if((!filename) || (!(fp = fopen(filename, "rb"))))
+    return NULL;
+
+  reader = vrna_file_fasta_reader_init(fp);
+  if(reader)
+    reader->close_file = 1;
+  else
+    fclose(fp);
+
+  return reader;
+}
+
+
+PUBLIC unsigned int
+vrna_file_fasta_read_record_view(vrna_fasta_reader_t  reader,
+                                 vrna_fasta_record_t  *record,
+                                 unsigned int         options)
+{
+  unsigned int  i, type;
+  size_t        cursor;
+  char          *data;
+
+  if((!reader) || (!record))
+    return VRNA_INPUT_ERROR;
+
+  reader->has_header  = 0;
+  reader->rest_count  = 0;
+  cursor              = 0;
+
+  type = reader_parse_record(reader, &cursor, options);
+
+  /* all further reads may move the buffer, so we create the views only now */
+  data = reader->buf + reader->pos;
+
+  record->header          = NULL;
+  record->header_length   = 0;
+  record->sequence        = NULL;
+  record->sequence_length = 0;
+  record->rest            = reader->rest;
+  record->rest_count      = reader->rest_count;
+
+  if(reader->has_header){
+    data[reader->header_offset + reader->header_length] = '\0';
+    record->header        = data + reader->header_offset;
+    record->header_length = reader->header_length;
+  }
+
+  if(type & VRNA_INPUT_SEQUENCE){
+    data[reader->sequence_offset + reader->sequence_length] = '\0';
+    record->sequence        = data + reader->sequence_offset;
+    record->sequence_length = reader->sequence_length;
+  }
+
+  for(i = 0; i < reader->rest_count; i++){
+    data[reader->rest_offset[i] + reader->rest_length[i]] = '\0';
+    reader->rest[i] = data + reader->rest_offset[i];
+  }
+  reader->rest[reader->rest_count] = NULL;
+
+  reader->pos += cursor;
+
+  return type;
+}
+
+
+PUBLIC void
+vrna_file_fasta_reader_free(vrna_fasta_reader_t reader)
+{
+  if(reader){
+#ifdef VRNA_WITH_ZLIB
+    if(reader->gz)
+      inflate_source_free(reader->gz);
+#endif
+    if(reader->close_file)
+      fclose(reader->file);
+
+    free(reader->buf);
+    free(reader->rest_offset);
+    free(reader->rest_length);
+    free(reader->rest);
+    free(reader);
+  }
+}
+
+
 PUBLIC char *
 vrna_extract_record_rest_structure( const char **lines,
                                     unsigned int length,
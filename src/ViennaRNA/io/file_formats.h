@@ -187,6 +187,117 @@ unsigned int vrna_file_fasta_read_record(char **header,
                                     FILE *file,
                                     unsigned int options);
 
+
+/**
+ *  @brief  A buffered reader for (fasta) data sets
+ *
+ *  @see  vrna_file_fasta_reader_init(), vrna_file_fasta_reader_open(),
+ *        vrna_file_fasta_read_record_view(), vrna_file_fasta_reader_free()
+ */
+typedef struct vrna_fasta_reader_s *vrna_fasta_reader_t;
+
+/**
+ *  @brief  A (fasta) data set as obtained from vrna_file_fasta_read_record_view()
+ *
+ *  All strings are '\0'-terminated views into the read buffer of the reader. They
+ *  remain valid until the next call of vrna_file_fasta_read_record_view() or
+ *  vrna_file_fasta_reader_free() for the same reader, and must not be freed.
+ */
+typedef struct {
+  const char    *header;          /**< @brief The fasta header including the leading '>', or NULL */
+  size_t        header_length;    /**< @brief The length of the header */
+  const char    *sequence;        /**< @brief The sequence, or NULL */
+  size_t        sequence_length;  /**< @brief The length of the sequence */
+  const char    **rest;           /**< @brief A NULL-terminated list of the remaining lines of the data set */
+  unsigned int  rest_count;       /**< @brief The number of lines in @p rest */
+} vrna_fasta_record_t;
+
+/**
+ *  @brief  Create a buffered reader for (fasta) data sets from a file handle
+ *
+ *  The reader reads the input in large blocks and parses the data sets within its
+ *  read buffer, such that no memory needs to be allocated for the individual lines.
+ *  If the input starts with the magic bytes of gzip, it is decompressed on the fly.
+ *  Where POSIX threads are available, the decompression runs in a separate thread.
+ *
+ *  @note   Since the input is read ahead in large blocks, the reader is not suited
+ *          for interactive input. The file handle should not be read from by other
+ *          means while the reader is in use.
+ *  @note   Reading compressed input requires RNAlib to be built with zlib support.
+ *          Otherwise, this function refuses to read compressed input.
+ *
+ *  @see    vrna_file_fasta_read_record_view(), vrna_file_fasta_reader_free(),
+ *          vrna_file_fasta_reader_open()
+ *
+ *  @param  file  A file handle to read from (if NULL, the reader reads from stdin)
+ *  @return       The reader, or NULL on error
+ */
+vrna_fasta_reader_t
+vrna_file_fasta_reader_init(FILE *file);
+
+
+/**
+ *  @brief  Open a file and create a buffered reader for the (fasta) data sets within
+ *
+ *  Same as vrna_file_fasta_reader_init() for a file handle of the file @p filename.
+ *  The file is closed by vrna_file_fasta_reader_free().
+ *
+ *  @see    vrna_file_fasta_reader_init()
+ *
+ *  @param  filename  The name of the (possibly gzip compressed) file
+ *  @return           The reader, or NULL if the file could not be opened or read
+ */
+vrna_fasta_reader_t
+vrna_file_fasta_reader_open(const char *filename);
+
+
+/**
+ *  @brief  Get the next (fasta) data set from a buffered reader
+ *
+ *  This function parses the input in the same way as vrna_file_fasta_read_record()
+ *  and accepts the same @p options. Instead of copying header, sequence and rest
+ *  of the data set into newly allocated memory, the @p record is set such that it
+ *  points into the read buffer of the reader. A sequence that spans several lines
+ *  is joined in place.
+ *
+ *  Different to vrna_file_fasta_read_record(), all data about the input is kept
+ *  within the reader. Thus, different readers may be used from different threads
+ *  concurrently.
+ *
+ *  @code
+vrna_fasta_reader_t reader = vrna_file_fasta_reader_open("input.fa.gz");
+vrna_fasta_record_t record;
+
+while(!(vrna_file_fasta_read_record_view(reader, &record, 0) & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT))){
+  if(record.header) printf("%s\n", record.header);
+  printf("%s\n", record.sequence);
+}
+vrna_file_fasta_reader_free(reader);
+ *  @endcode
+ *
+ *  @see    vrna_file_fasta_read_record(), vrna_file_fasta_reader_init()
+ *
+ *  @param  reader    The reader
+ *  @param  record    A pointer to the data set that will be set to the data read
+ *  @param  options   Some options which may be passed to alter the behavior of the function, use 0 for no options
+ *  @return           A flag with information about what the function actually did read
+ */
+unsigned int
+vrna_file_fasta_read_record_view(vrna_fasta_reader_t reader,
+                                 vrna_fasta_record_t *record,
+                                 unsigned int        options);
+
+
+/**
+ *  @brief  Free a buffered reader for (fasta) data sets
+ *
+ *  @see    vrna_file_fasta_reader_init(), vrna_file_fasta_reader_open()
+ *
+ *  @param  reader  The reader
+ */
+void
+vrna_file_fasta_reader_free(vrna_fasta_reader_t reader);
+
 /** @brief Extract a dot-bracket structure string from (multiline)character array
  *
  * This function extracts a dot-bracket structure string from the 'rest' array as
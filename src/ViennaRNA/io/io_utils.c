@@ -51,6 +51,9 @@
 #define DIRSEPS "/"
 #endif
 
+/* number of bytes vrna_read_line() reads at once */
+#define READ_LINE_CHUNK 8192
+
 /*
  #################################
  # PRIVATE FUNCTION DECLARATIONS #
@@ -80,24 +83,29 @@ vrna_read_line(FILE *fp)
 {
   /* reads lines of arbitrary length from fp */
 
-  char  s[512], *line, *cp;
+  char  s[READ_LINE_CHUNK], *line, *cp;
   int   len = 0, size = 0, l, l2;
 
   line = NULL;
   do {
-    if (fgets(s, 512, fp) == NULL)
+    if (fgets(s, READ_LINE_CHUNK, fp) == NULL)
       break;
 
     cp = strchr(s, '\n');
     if (cp != NULL)
       *cp = '\0';
 
-    l2  = (int)strlen(s);
+    l2  = (cp != NULL) ? (int)(cp - s) : (int)strlen(s);
     l   = len + l2;
     if (l + 1 > size) {
-      size  = (int)((l + 1) * 1.2);
+      /*
+       *  lines that fit into a single chunk are allocated with their exact
+       *  size, longer ones grow geometrically
+       */
+      size  = (cp != NULL) ? l + 1 : 2 * (l + 1);
       line  = (char *)vrna_realloc(line, size * sizeof(char));
     }
+
     memcpy(line + len,
            s,
            sizeof(char) * l2);
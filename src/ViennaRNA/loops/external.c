@@ -29,6 +29,7 @@
 
 #include "external_hc.inc"
 #include "external_sc.inc"
+#include "ViennaRNA/sequence_weights.inc"
 
 /*
  #################################
@@ -848,7 +849,7 @@ get_stem_contributions_d0(vrna_fold_compound_t      *fc,
 {
   char                    *ptype;
   short                   **S;
-  unsigned int            s, n_seq, type;
+  unsigned int            s, n_seq, *w, type;
   int                     i, ij, *indx, turn, *c, *stems;
   vrna_param_t            *P;
   vrna_md_t               *md;
@@ -866,6 +867,7 @@ get_stem_contributions_d0(vrna_fold_compound_t      *fc,
   ij    = indx[j] + j - turn - 1;
   ptype = (fc->type == VRNA_FC_TYPE_SINGLE) ? fc->ptype : NULL;
   n_seq = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
+  w     = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   S     = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S;
 
   sc_spl_stem = sc_wrapper->decomp_stem;
@@ -894,7 +896,7 @@ get_stem_contributions_d0(vrna_fold_compound_t      *fc,
 
           for (s = 0; s < n_seq; s++) {
             type      = vrna_get_ptype_md(S[s][i], S[s][j], md);
-            stems[i]  += E_ExtLoop(type, -1, -1, P);
+            stems[i]  += E_WEIGHTED(E_ExtLoop(type, -1, -1, P), w[s]);
           }
         }
       }
@@ -922,7 +924,7 @@ get_stem_contributions_d0(vrna_fold_compound_t      *fc,
       case VRNA_FC_TYPE_COMPARATIVE:
         for (s = 0; s < n_seq; s++) {
           type      = vrna_get_ptype_md(S[s][1], S[s][j], md);
-          stems[1]  += E_ExtLoop(type, -1, -1, P);
+          stems[1]  += E_WEIGHTED(E_ExtLoop(type, -1, -1, P), w[s]);
         }
         break;
     }
@@ -944,7 +946,7 @@ f3_get_stem_contributions_d0(vrna_fold_compound_t       *fc,
 {
   char                    **ptype;
   short                   **S, *si;
-  unsigned int            s, n_seq, type, length;
+  unsigned int            s, n_seq, *w, type, length;
   int                     energy, j, max_j, turn, *c, *stems, maxdist;
   vrna_param_t            *P;
   vrna_md_t               *md;
@@ -962,6 +964,7 @@ f3_get_stem_contributions_d0(vrna_fold_compound_t       *fc,
   si      = NULL;
   ptype   = (fc->type == VRNA_FC_TYPE_SINGLE) ? fc->ptype_local : NULL;
   n_seq   = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
+  w       = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   S       = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S;
 
   stems = (int *)vrna_alloc(sizeof(int) * (maxdist + 6));
@@ -998,7 +1001,7 @@ f3_get_stem_contributions_d0(vrna_fold_compound_t       *fc,
           energy = c[j];
           for (s = 0; s < n_seq; s++) {
             type    = vrna_get_ptype_md(si[s], S[s][j], md);
-            energy  += E_ExtLoop(type, -1, -1, P);
+            energy  += E_WEIGHTED(E_ExtLoop(type, -1, -1, P), w[s]);
           }
           stems[j] = energy;
         }
@@ -1030,7 +1033,7 @@ f3_get_stem_contributions_d0(vrna_fold_compound_t       *fc,
         case VRNA_FC_TYPE_COMPARATIVE:
           for (s = 0; s < n_seq; s++) {
             type    = vrna_get_ptype_md(si[s], S[s][j], md);
-            energy  += E_ExtLoop(type, -1, -1, P);
+            energy  += E_WEIGHTED(E_ExtLoop(type, -1, -1, P), w[s]);
           }
 
           break;
@@ -1064,7 +1067,7 @@ get_stem_contributions_d2(vrna_fold_compound_t      *fc,
 {
   char                    *ptype;
   short                   *S, sj1, *si1, **SS, **S5, **S3, *s3j, *sj;
-  unsigned int            s, n_seq, **a2s, type;
+  unsigned int            s, n_seq, *w, **a2s, type;
   int                     n, i, ij, *indx, turn, *c, *stems, mm5;
   vrna_param_t            *P;
   vrna_md_t               *md;
@@ -1123,6 +1126,7 @@ get_stem_contributions_d2(vrna_fold_compound_t      *fc,
 
     case VRNA_FC_TYPE_COMPARATIVE:
       n_seq = fc->n_seq;
+      w     = fc->seq_weights;
       SS    = fc->S;
       S5    = fc->S5;
       S3    = fc->S3;
@@ -1144,7 +1148,7 @@ get_stem_contributions_d2(vrna_fold_compound_t      *fc,
           for (s = 0; s < n_seq; s++) {
             type      = vrna_get_ptype_md(SS[s][i], sj[s], md);
             mm5       = (a2s[s][i] > 1) ? S5[s][i] : -1;
-            stems[i]  += E_ExtLoop(type, mm5, s3j[s], P);
+            stems[i]  += E_WEIGHTED(E_ExtLoop(type, mm5, s3j[s], P), w[s]);
           }
         }
       }
@@ -1162,7 +1166,7 @@ get_stem_contributions_d2(vrna_fold_compound_t      *fc,
 
         for (s = 0; s < n_seq; s++) {
           type      = vrna_get_ptype_md(SS[s][1], sj[s], md);
-          stems[1]  += E_ExtLoop(type, -1, s3j[s], P);
+          stems[1]  += E_WEIGHTED(E_ExtLoop(type, -1, s3j[s], P), w[s]);
         }
 
         if (sc_red_stem)
@@ -1188,7 +1192,7 @@ f3_get_stem_contributions_d2(vrna_fold_compound_t       *fc,
 {
   char                    **ptype;
   short                   **S, **S5, **S3, *S1, si1, sj1, *s5i1, *si;
-  unsigned int            s, n_seq, type, length, **a2s;
+  unsigned int            s, n_seq, *w, type, length, **a2s;
   int                     energy, j, max_j, turn, *c, *stems, maxdist;
   vrna_param_t            *P;
   vrna_md_t               *md;
@@ -1252,6 +1256,7 @@ f3_get_stem_contributions_d2(vrna_fold_compound_t       *fc,
 
     case VRNA_FC_TYPE_COMPARATIVE:
       n_seq = fc->n_seq;
+      w     = fc->seq_weights;
       S     = fc->S;
       S5    = fc->S5;
       S3    = fc->S3;
@@ -1273,7 +1278,7 @@ f3_get_stem_contributions_d2(vrna_fold_compound_t       *fc,
           for (s = 0; s < n_seq; s++) {
             type    = vrna_get_ptype_md(si[s], S[s][j], md);
             sj1     = (a2s[s][j] < a2s[s][S[0][0]]) ? S3[s][j] : -1;
-            energy  += E_ExtLoop(type, s5i1[s], sj1, P);
+            energy  += E_WEIGHTED(E_ExtLoop(type, s5i1[s], sj1, P), w[s]);
           }
           stems[j] = energy;
         }
@@ -1292,7 +1297,7 @@ f3_get_stem_contributions_d2(vrna_fold_compound_t       *fc,
           energy = c[j];
           for (s = 0; s < n_seq; s++) {
             type    = vrna_get_ptype_md(si[s], S[s][j], md);
-            energy  += E_ExtLoop(type, s5i1[s], -1, P);
+            energy  += E_WEIGHTED(E_ExtLoop(type, s5i1[s], -1, P), w[s]);
           }
 
           if (sc_red_stem)
@@ -1321,7 +1326,7 @@ f5_get_stem_contributions_d5(vrna_fold_compound_t       *fc,
 {
   char                    *ptype;
   short                   *S, *si1, **SS, **S5, *sj;
-  unsigned int            s, n_seq, **a2s, type;
+  unsigned int            s, n_seq, *w, **a2s, type;
   int                     i, ij, *indx, turn, *c, *stems, mm5;
   vrna_param_t            *P;
   vrna_md_t               *md;
@@ -1378,6 +1383,7 @@ f5_get_stem_contributions_d5(vrna_fold_compound_t       *fc,
 
     case VRNA_FC_TYPE_COMPARATIVE:
       n_seq = fc->n_seq;
+      w     = fc->seq_weights;
       SS    = fc->S;
       S5    = fc->S5;
       a2s   = fc->a2s;
@@ -1437,7 +1443,7 @@ f3_get_stem_contributions_d3(vrna_fold_compound_t       *fc,
 {
   char                    **ptype;
   short                   *S1, **S, **S3, sj1, *si;
-  unsigned int            s, n_seq, **a2s, type;
+  unsigned int            s, n_seq, *w, **a2s, type;
   int                     energy, j, max_j, turn, *c, *stems, length, maxdist;
   vrna_param_t            *P;
   vrna_md_t               *md;
@@ -1498,6 +1504,7 @@ f3_get_stem_contributions_d3(vrna_fold_compound_t       *fc,
 
     case VRNA_FC_TYPE_COMPARATIVE:
       n_seq = fc->n_seq;
+      w     = fc->seq_weights;
       S     = fc->S;
       S3    = fc->S3;
       a2s   = fc->a2s;
@@ -1515,7 +1522,7 @@ f3_get_stem_contributions_d3(vrna_fold_compound_t       *fc,
           for (s = 0; s < n_seq; s++) {
             type    = vrna_get_ptype_md(si[s], S[s][j - 1], md);
             sj1     = (a2s[s][j - 1] < a2s[s][S[0][0]]) ? S3[s][j - 1] : -1;
-            energy  += E_ExtLoop(type, -1, sj1, P);
+            energy  += E_WEIGHTED(E_ExtLoop(type, -1, sj1, P), w[s]);
           }
           stems[j] = energy;
         }
@@ -1535,7 +1542,7 @@ f3_get_stem_contributions_d3(vrna_fold_compound_t       *fc,
           for (s = 0; s < n_seq; s++) {
             type    = vrna_get_ptype_md(si[s], S[s][j - 1], md);
             sj1     = (a2s[s][j - 1] < a2s[s][S[0][0]]) ? S3[s][j - 1] : -1;
-            energy  += E_ExtLoop(type, -1, sj1, P);
+            energy  += E_WEIGHTED(E_ExtLoop(type, -1, sj1, P), w[s]);
           }
 
           if (sc_red_stem)
@@ -1563,7 +1570,7 @@ f5_get_stem_contributions_d3(vrna_fold_compound_t       *fc,
 {
   char                    *ptype;
   short                   *S, sj1, **SS, **S3, *s3j1, *ssj1;
-  unsigned int            s, n_seq, **a2s, type;
+  unsigned int            s, n_seq, *w, **a2s, type;
   int                     i, ij, *indx, turn, *c, *stems;
   vrna_param_t            *P;
   vrna_md_t               *md;
@@ -1620,6 +1627,7 @@ f5_get_stem_contributions_d3(vrna_fold_compound_t       *fc,
 
     case VRNA_FC_TYPE_COMPARATIVE:
       n_seq = fc->n_seq;
+      w     = fc->seq_weights;
       SS    = fc->S;
       S3    = fc->S3;
       a2s   = fc->a2s;
@@ -1639,7 +1647,7 @@ f5_get_stem_contributions_d3(vrna_fold_compound_t       *fc,
           stems[i] = c[ij];
           for (s = 0; s < n_seq; s++) {
             type      = vrna_get_ptype_md(SS[s][i], ssj1[s], md);
-            stems[i]  += E_ExtLoop(type, -1, s3j1[s], P);
+            stems[i]  += E_WEIGHTED(E_ExtLoop(type, -1, s3j1[s], P), w[s]);
           }
         }
       }
@@ -1657,7 +1665,7 @@ f5_get_stem_contributions_d3(vrna_fold_compound_t       *fc,
 
         for (s = 0; s < n_seq; s++) {
           type      = vrna_get_ptype_md(SS[s][1], ssj1[s], md);
-          stems[1]  += E_ExtLoop(type, -1, s3j1[s], P);
+          stems[1]  += E_WEIGHTED(E_ExtLoop(type, -1, s3j1[s], P), w[s]);
         }
 
         if (sc_red_stem)
@@ -1683,7 +1691,7 @@ f3_get_stem_contributions_d5(vrna_fold_compound_t       *fc,
 {
   char                    **ptype;
   short                   *S1, **S, **S5, *s5i1, si, *si1;
-  unsigned int            s, n_seq, **a2s, type;
+  unsigned int            s, n_seq, *w, **a2s, type;
   int                     energy, j, max_j, turn, *c, *stems, length, maxdist;
   vrna_param_t            *P;
   vrna_md_t               *md;
@@ -1746,6 +1754,7 @@ f3_get_stem_contributions_d5(vrna_fold_compound_t       *fc,
 
     case VRNA_FC_TYPE_COMPARATIVE:
       n_seq = fc->n_seq;
+      w     = fc->seq_weights;
       S     = fc->S;
       S5    = fc->S5;
       a2s   = fc->a2s;
@@ -1766,7 +1775,7 @@ f3_get_stem_contributions_d5(vrna_fold_compound_t       *fc,
           energy = c[j];
           for (s = 0; s < n_seq; s++) {
             type    = vrna_get_ptype_md(si1[s], S[s][j], md);
-            energy  += E_ExtLoop(type, s5i1[s], -1, P);
+            energy  += E_WEIGHTED(E_ExtLoop(type, s5i1[s], -1, P), w[s]);
           }
           stems[j] = energy;
         }
@@ -1786,7 +1795,7 @@ f3_get_stem_contributions_d5(vrna_fold_compound_t       *fc,
           energy = c[j];
           for (s = 0; s < n_seq; s++) {
             type    = vrna_get_ptype_md(si1[s], S[s][j], md);
-            energy  += E_ExtLoop(type, s5i1[s], -1, P);
+            energy  += E_WEIGHTED(E_ExtLoop(type, s5i1[s], -1, P), w[s]);
           }
 
           if (sc_red_stem)
@@ -1815,7 +1824,7 @@ f5_get_stem_contributions_d53(vrna_fold_compound_t      *fc,
 {
   char                    *ptype;
   short                   *S, *si1, sj1, **SS, **S5, **S3, *s3j1, *ssj1;
-  unsigned int            s, n_seq, **a2s, type;
+  unsigned int            s, n_seq, *w, **a2s, type;
   int                     i, ij, *indx, turn, *c, *stems;
   vrna_param_t            *P;
   vrna_md_t               *md;
@@ -1873,6 +1882,7 @@ f5_get_stem_contributions_d53(vrna_fold_compound_t      *fc,
 
     case VRNA_FC_TYPE_COMPARATIVE:
       n_seq = fc->n_seq;
+      w     = fc->seq_weights;
       SS    = fc->S;
       S5    = fc->S5;
       S3    = fc->S3;
@@ -1893,7 +1903,11 @@ f5_get_stem_contributions_d53(vrna_fold_compound_t      *fc,
           stems[i] = c[ij];
           for (s = 0; s < n_seq; s++) {
             type      = vrna_get_ptype_md(SS[s][i + 1], ssj1[s], md);
-            stems[i]  += E_ExtLoop(type, (a2s[s][i + 1] > 1) ? S5[s][i + 1] : -1, s3j1[s], P);
+            stems[i]  += E_WEIGHTED(E_ExtLoop(type,
+                                              (a2s[s][i + 1] > 1) ? S5[s][i + 1] : -1,
+                                              s3j1[s],
+                                              P),
+                                    w[s]);
           }
         }
       }
@@ -1910,7 +1924,11 @@ f5_get_stem_contributions_d53(vrna_fold_compound_t      *fc,
         stems[1] = c[ij];
         for (s = 0; s < n_seq; s++) {
           type      = vrna_get_ptype_md(SS[s][2], ssj1[s], md);
-          stems[1]  += E_ExtLoop(type, (a2s[s][2] > 1) ? S5[s][2] : -1, s3j1[s], P);
+          stems[1]  += E_WEIGHTED(E_ExtLoop(type,
+                                            (a2s[s][2] > 1) ? S5[s][2] : -1,
+                                            s3j1[s],
+                                            P),
+                                  w[s]);
         }
 
         if (sc_red_stem)
@@ -1936,7 +1954,7 @@ f3_get_stem_contributions_d53(vrna_fold_compound_t      *fc,
 {
   char                    **ptype;
   short                   *S1, **S, **S5, **S3, *s5i1, si1, sj1, *ssi1;
-  unsigned int            s, n_seq, **a2s, type;
+  unsigned int            s, n_seq, *w, **a2s, type;
   int                     energy, j, max_j, turn, *c, *stems, length, maxdist;
   vrna_param_t            *P;
   vrna_md_t               *md;
@@ -1997,6 +2015,7 @@ f3_get_stem_contributions_d53(vrna_fold_compound_t      *fc,
 
     case VRNA_FC_TYPE_COMPARATIVE:
       n_seq = fc->n_seq;
+      w     = fc->seq_weights;
       S     = fc->S;
       S5    = fc->S5;
       S3    = fc->S3;
@@ -2018,7 +2037,7 @@ f3_get_stem_contributions_d53(vrna_fold_compound_t      *fc,
           for (s = 0; s < n_seq; s++) {
             type    = vrna_get_ptype_md(ssi1[s], S[s][j - 1], md);
             sj1     = (a2s[s][j - 1] < a2s[s][S[0][0]]) ? S3[s][j - 1] : -1;
-            energy  += E_ExtLoop(type, s5i1[s], sj1, P);
+            energy  += E_WEIGHTED(E_ExtLoop(type, s5i1[s], sj1, P), w[s]);
           }
           stems[j] = energy;
         }
@@ -2037,7 +2056,7 @@ f3_get_stem_contributions_d53(vrna_fold_compound_t      *fc,
           for (s = 0; s < n_seq; s++) {
             type    = vrna_get_ptype_md(ssi1[s], S[s][j - 1], md);
             sj1     = (a2s[s][j - 1] < a2s[s][S[0][0]]) ? S3[s][j - 1] : -1;
-            energy  += E_ExtLoop(type, s5i1[s], sj1, P);
+            energy  += E_WEIGHTED(E_ExtLoop(type, s5i1[s], sj1, P), w[s]);
           }
 
           if (sc_red_stem)
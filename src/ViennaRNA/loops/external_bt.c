@@ -28,6 +28,7 @@
 
 #include "external_hc.inc"
 #include "external_sc.inc"
+#include "ViennaRNA/sequence_weights.inc"
 
 /*
  #################################
@@ -556,7 +557,7 @@ BT_ext_loop_f5_comparative(vrna_fold_compound_t *fc,
 {
   unsigned int              **a2s;
   short                     **S, **S5, **S3;
-  unsigned int              tt;
+  unsigned int              tt, *w;
   int                       fij, fi, jj, u, en, *my_f5, *my_c, *my_ggg, *idx,
                             dangle_model, turn, with_gquad, n_seq, ss, mm5, mm3;
   vrna_param_t              *P;
@@ -566,6 +567,7 @@ BT_ext_loop_f5_comparative(vrna_fold_compound_t *fc,
   struct default_data       hc_dat_local;
 
   n_seq         = fc->n_seq;
+  w             = fc->seq_weights;
   S             = fc->S;
   S5            = fc->S5;
   S3            = fc->S3;
@@ -634,7 +636,7 @@ BT_ext_loop_f5_comparative(vrna_fold_compound_t *fc,
 
           for (ss = 0; ss < n_seq; ss++) {
             tt  = vrna_get_ptype_md(S[ss][u], S[ss][jj], md);
-            en  += E_ExtLoop(tt, -1, -1, P);
+            en  += E_WEIGHTED(E_ExtLoop(tt, -1, -1, P), w[ss]);
           }
 
           if (scs) {
@@ -673,7 +675,7 @@ BT_ext_loop_f5_comparative(vrna_fold_compound_t *fc,
             tt  = vrna_get_ptype_md(S[ss][u], S[ss][jj], md);
             mm5 = (a2s[ss][u] > 1) ? S5[ss][u] : -1;
             mm3 = (a2s[ss][jj] < a2s[ss][S[0][0]]) ? S3[ss][jj] : -1;      /* why S[0][0] ??? */
-            en  += E_ExtLoop(tt, mm5, mm3, P);
+            en  += E_WEIGHTED(E_ExtLoop(tt, mm5, mm3, P), w[ss]);
           }
 
           if (scs) {
@@ -1018,7 +1020,7 @@ BT_ext_loop_f3_comparative(vrna_fold_compound_t *fc,
                            int                  *stack_count)
 {
   short                     **S, **S5, **S3;
-  unsigned int              type, ss, n_seq, **a2s;
+  unsigned int              type, ss, n_seq, *w, **a2s;
   int                       fij, cc, fj, ii, u, *f3, **c, **ggg,
                             dangle_model, turn, with_gquad;
   vrna_param_t              *P;
@@ -1028,6 +1030,7 @@ BT_ext_loop_f3_comparative(vrna_fold_compound_t *fc,
   struct default_data       hc_dat_local;
 
   n_seq         = fc->n_seq;
+  w             = fc->seq_weights;
   S             = fc->S;
   S5            = fc->S5;   /* S5[s][i] holds next base 5' of i in sequence s */
   S3            = fc->S3;   /* Sl[s][i] holds next base 3' of i in sequence s */
@@ -1096,7 +1099,7 @@ BT_ext_loop_f3_comparative(vrna_fold_compound_t *fc,
           cc = c[ii][u - ii];
           for (ss = 0; ss < n_seq; ss++) {
             type  = vrna_get_ptype_md(S[ss][ii], S[ss][u], md);
-            cc    += E_ExtLoop(type, -1, -1, P);
+            cc    += E_WEIGHTED(E_ExtLoop(type, -1, -1, P), w[ss]);
           }
 
           if (fij == cc + f3[u + 1]) {
@@ -1127,8 +1130,8 @@ BT_ext_loop_f3_comparative(vrna_fold_compound_t *fc,
           for (ss = 0; ss < n_seq; ss++) {
             type  = vrna_get_ptype_md(S[ss][ii], S[ss][u], md);
             cc    +=
-              E_ExtLoop(type, (a2s[ss][ii] > 1) ? S5[ss][ii] : -1,
-                        (a2s[ss][u] < a2s[ss][S[0][0]]) ? S3[ss][u] : -1, P);
+              E_WEIGHTED(E_ExtLoop(type, (a2s[ss][ii] > 1) ? S5[ss][ii] : -1,
+                                   (a2s[ss][u] < a2s[ss][S[0][0]]) ? S3[ss][u] : -1, P), w[ss]);
           }
 
           if (fij == cc + f3[u + 1]) {
@@ -1383,7 +1386,7 @@ BT_ext_loop_f3_pp_comparative(vrna_fold_compound_t  *fc,
 
   if (fc) {
     short                     **S, **S5, **S3;
-    unsigned int              tt, s, n_seq, **a2s;
+    unsigned int              tt, s, n_seq, *w, **a2s;
     int                       traced2, length, turn, dangle_model, with_gquad, maxdist, cc, **c,
                               **ggg, *f3, fij;
     vrna_param_t              *P;
@@ -1394,6 +1397,7 @@ BT_ext_loop_f3_pp_comparative(vrna_fold_compound_t  *fc,
 
     length        = fc->length;
     n_seq         = fc->n_seq;
+    w             = fc->seq_weights;
     S             = fc->S;
     S5            = fc->S5;   /* S5[s][start] holds next base 5' of start in sequence s */
     S3            = fc->S3;   /* Sl[s][start] holds next base 3' of start in sequence s */
@@ -1442,7 +1446,7 @@ BT_ext_loop_f3_pp_comparative(vrna_fold_compound_t  *fc,
 
             for (s = 0; s < n_seq; s++) {
               tt  = vrna_get_ptype_md(S[s][start], S[s][j], md);
-              cc  += E_ExtLoop(tt, -1, -1, P);
+              cc  += E_WEIGHTED(E_ExtLoop(tt, -1, -1, P), w[s]);
             }
 
             if (fij == cc + f3[j + 1]) {
@@ -1468,7 +1472,7 @@ BT_ext_loop_f3_pp_comparative(vrna_fold_compound_t  *fc,
 
             for (s = 0; s < n_seq; s++) {
               tt  = vrna_get_ptype_md(S[s][start], S[s][j], md);
-              cc  += E_ExtLoop(tt, -1, -1, P);
+              cc  += E_WEIGHTED(E_ExtLoop(tt, -1, -1, P), w[s]);
             }
 
             if (fij == cc) {
@@ -1497,10 +1501,10 @@ BT_ext_loop_f3_pp_comparative(vrna_fold_compound_t  *fc,
             for (s = 0; s < n_seq; s++) {
               tt  = vrna_get_ptype_md(S[s][start], S[s][j], md);
               cc  +=
-                E_ExtLoop(tt,
-                          (a2s[s][start] > 1) ? S5[s][start] : -1,
-                          (a2s[s][j] < a2s[s][S[0][0]]) ? S3[s][j] : -1,
-                          P);
+                E_WEIGHTED(E_ExtLoop(tt,
+                                     (a2s[s][start] > 1) ? S5[s][start] : -1,
+                                     (a2s[s][j] < a2s[s][S[0][0]]) ? S3[s][j] : -1,
+                                     P), w[s]);
             }
 
             if (fij == cc + f3[j + 1]) {
@@ -1525,7 +1529,8 @@ BT_ext_loop_f3_pp_comparative(vrna_fold_compound_t  *fc,
             cc = c[start][j - start];
             for (s = 0; s < n_seq; s++) {
               tt  = vrna_get_ptype_md(S[s][start], S[s][j], md);
-              cc  += E_ExtLoop(tt, (a2s[s][start] > 1) ? S5[s][start] :  -1, -1, P);
+              cc  += E_WEIGHTED(E_ExtLoop(tt, (a2s[s][start] > 1) ? S5[s][start] :  -1, -1, P),
+                                w[s]);
             }
 
             if (fij == cc) {
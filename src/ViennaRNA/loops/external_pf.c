@@ -30,6 +30,7 @@
 
 #include "external_hc.inc"
 #include "external_sc_pf.inc"
+#include "ViennaRNA/sequence_weights.inc"
 
 struct vrna_mx_pf_aux_el_s {
   FLT_OR_DBL  *qq;
@@ -381,7 +382,7 @@ reduce_ext_stem_fast(vrna_fold_compound_t       *fc,
                      struct sc_wrapper_exp_ext  *sc_wrapper)
 {
   short             **S, **S5, **S3, *S1, *S2, s5, s3;
-  unsigned int      type, *sn, n, s, n_seq, **a2s;
+  unsigned int      type, *sn, n, s, n_seq, *w, **a2s;
   int               *idx, circular;
   FLT_OR_DBL        qbt, q_temp, qb;
   vrna_exp_param_t  *pf_params;
@@ -416,16 +417,17 @@ reduce_ext_stem_fast(vrna_fold_compound_t       *fc,
 
       case VRNA_FC_TYPE_COMPARATIVE:
         n_seq = fc->n_seq;
+        w     = fc->seq_weights;
         S     = fc->S;
         S5    = fc->S5;
         S3    = fc->S3;
         a2s   = fc->a2s;
         for (s = 0; s < n_seq; s++) {
           type    = vrna_get_ptype_md(S[s][i], S[s][j], md);
-          q_temp  *= exp_E_ExtLoop(type,
-                                   ((a2s[s][i] > 1) || circular) ? S5[s][i] : -1,
-                                   ((a2s[s][j] < a2s[s][S[0][0]]) || circular) ? S3[s][j] : -1,
-                                   pf_params);
+          q_temp  *= exp_weighted(exp_E_ExtLoop(type,
+                                                ((a2s[s][i] > 1) || circular) ? S5[s][i] : -1,
+                                                ((a2s[s][j] < a2s[s][S[0][0]]) || circular) ? S3[s][j] : -1,
+                                                pf_params), w[s]);
         }
         break;
     }
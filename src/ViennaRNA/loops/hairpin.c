@@ -29,6 +29,7 @@
 
 #include "hairpin_hc.inc"
 #include "hairpin_sc.inc"
+#include "ViennaRNA/sequence_weights.inc"
 
 /*
  #################################
@@ -110,7 +111,7 @@ vrna_eval_ext_hp_loop(vrna_fold_compound_t  *fc,
   char                  **Ss, loopseq[10] = {
     0
   };
-  unsigned int          **a2s;
+  unsigned int          **a2s, *w;
   short                 *S, *S2, **SS, **S5, **S3;
   int                   u1, u2, e, s, type, n_seq, length, noGUclosure;
   vrna_param_t          *P;
@@ -159,6 +160,7 @@ vrna_eval_ext_hp_loop(vrna_fold_compound_t  *fc,
       S3    = fc->S3;   /* Sl[s][i] holds next base 3' of i in sequence s */
       Ss    = fc->Ss;
       a2s   = fc->a2s;
+      w     = fc->seq_weights;
       n_seq = fc->n_seq;
       e     = 0;
 
@@ -174,10 +176,10 @@ vrna_eval_ext_hp_loop(vrna_fold_compound_t  *fc,
         }
 
         if ((u1 + u2) < 3) {
-          e += 600;
+          e += E_WEIGHTED(600, w[s]);
         } else {
           type  = vrna_get_ptype_md(SS[s][j], SS[s][i], md);
-          e     += E_Hairpin(u1 + u2, type, S3[s][j], S5[s][i], loopseq, P);
+          e     += E_WEIGHTED(E_Hairpin(u1 + u2, type, S3[s][j], S5[s][i], loopseq, P), w[s]);
         }
       }
 
@@ -217,7 +219,7 @@ vrna_eval_hp_loop(vrna_fold_compound_t  *fc,
                   int                   j)
 {
   char                  **Ss;
-  unsigned int          **a2s;
+  unsigned int          **a2s, *w;
   short                 *S, *S2, **SS, **S5, **S3;
   unsigned int          *sn;
   int                   u, e, s, type, n_seq, en, noGUclosure;
@@ -261,15 +263,17 @@ vrna_eval_hp_loop(vrna_fold_compound_t  *fc,
       S3    = fc->S3;   /* Sl[s][i] holds next base 3' of i in sequence s */
       Ss    = fc->Ss;
       a2s   = fc->a2s;
+      w     = fc->seq_weights;
       n_seq = fc->n_seq;
 
       for (e = s = 0; s < n_seq; s++) {
         u = a2s[s][j - 1] - a2s[s][i];
         if (u < 3) {
-          e += 600;                          /* ??? really 600 ??? */
+          e += E_WEIGHTED(600, w[s]);        /* ??? really 600 ??? */
         } else {
           type  = vrna_get_ptype_md(SS[s][i], SS[s][j], md);
-          e     += E_Hairpin(u, type, S3[s][i], S5[s][j], Ss[s] + (a2s[s][i - 1]), P);
+          e     += E_WEIGHTED(E_Hairpin(u, type, S3[s][i], S5[s][j], Ss[s] + (a2s[s][i - 1]), P),
+                              w[s]);
         }
       }
 
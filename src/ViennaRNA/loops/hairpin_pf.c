@@ -29,6 +29,7 @@
 
 #include "hairpin_hc.inc"
 #include "hairpin_sc_pf.inc"
+#include "ViennaRNA/sequence_weights.inc"
 
 /*
  #################################
@@ -183,7 +184,7 @@ exp_eval_hp_loop(vrna_fold_compound_t *fc,
                  int                  j)
 {
   char                      **Ss;
-  unsigned int              **a2s;
+  unsigned int              **a2s, *w;
   short                     *S, *S2, **SS, **S5, **S3;
   unsigned int              *sn;
   int                       u, type, n_seq, s;
@@ -228,6 +229,7 @@ exp_eval_hp_loop(vrna_fold_compound_t *fc,
       S3    = fc->S3;   /* Sl[s][i] holds next base 3' of i in sequence s */
       Ss    = fc->Ss;
       a2s   = fc->a2s;
+      w     = fc->seq_weights;
       n_seq = fc->n_seq;
       qbt1  = 1.;
 
@@ -237,7 +239,8 @@ exp_eval_hp_loop(vrna_fold_compound_t *fc,
           continue;
 
         type  = vrna_get_ptype_md(SS[s][i], SS[s][j], md);
-        qbt1  *= exp_E_Hairpin(u, type, S3[s][i], S5[s][j], Ss[s] + a2s[s][i] - 1, P);
+        qbt1  *= exp_weighted(exp_E_Hairpin(u, type, S3[s][i], S5[s][j], Ss[s] + a2s[s][i] - 1, P),
+                              w[s]);
       }
 
       q = qbt1;
@@ -275,7 +278,7 @@ exp_eval_ext_hp_loop(vrna_fold_compound_t *fc,
   char                      **Ss, *sequence, loopseq[10] = {
     0
   };
-  unsigned int              **a2s;
+  unsigned int              **a2s, *w;
   short                     *S, *S2, **SS, **S5, **S3;
   int                       u1, u2, n, type, n_seq, s, noGUclosure;
   FLT_OR_DBL                q, qbt1, *scale;
@@ -327,6 +330,7 @@ exp_eval_ext_hp_loop(vrna_fold_compound_t *fc,
       S3    = fc->S3;   /* Sl[s][i] holds next base 3' of i in sequence s */
       Ss    = fc->Ss;
       a2s   = fc->a2s;
+      w     = fc->seq_weights;
       n_seq = fc->n_seq;
       qbt1  = 1.;
 
@@ -342,7 +346,8 @@ exp_eval_ext_hp_loop(vrna_fold_compound_t *fc,
         }
 
         type  = vrna_get_ptype_md(SS[s][j], SS[s][i], md);
-        qbt1  *= exp_E_Hairpin(u1_local + u2_local, type, S3[s][j], S5[s][i], loopseq, P);
+        qbt1  *= exp_weighted(exp_E_Hairpin(u1_local + u2_local, type, S3[s][j], S5[s][i], loopseq, P),
+                              w[s]);
       }
 
       q = qbt1;
@@ -27,6 +27,7 @@
 
 #include "internal_hc.inc"
 #include "internal_sc.inc"
+#include "ViennaRNA/sequence_weights.inc"
 
 /*
  #################################
@@ -147,7 +148,7 @@ eval_int_loop(vrna_fold_compound_t  *fc,
               int                   k,
               int                   l)
 {
-  unsigned int          *sn, *ss, n_seq, s, **a2s;
+  unsigned int          *sn, *ss, n_seq, s, **a2s, *w;
   int                   e, *rtype, type, type2, with_ud;
   short                 *S, *S2, **SS, **S5, **S3;
   vrna_param_t          *P;
@@ -167,6 +168,7 @@ eval_int_loop(vrna_fold_compound_t  *fc,
   S5          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S5;
   S3          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S3;
   a2s         = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->a2s;
+  w           = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   domains_up  = fc->domains_up;
   with_ud     = ((domains_up) && (domains_up->energy_cb)) ? 1 : 0;
   e           = INF;
@@ -211,7 +213,8 @@ eval_int_loop(vrna_fold_compound_t  *fc,
           type2   = vrna_get_ptype_md(SS[s][l], SS[s][k], md);
           u1      = a2s[s][k - 1] - a2s[s][i];
           u2      = a2s[s][j - 1] - a2s[s][l];
-          energy  += E_IntLoop(u1, u2, type, type2, S3[s][i], S5[s][j], S5[s][k], S3[s][l], P);
+          energy  += E_WEIGHTED(E_IntLoop(u1, u2, type, type2, S3[s][i], S5[s][j], S5[s][k], S3[s][l], P),
+                                w[s]);
         }
 
         break;
@@ -262,7 +265,7 @@ eval_ext_int_loop(vrna_fold_compound_t  *fc,
                   int                   k,
                   int                   l)
 {
-  unsigned int          n, n_seq, s, **a2s;
+  unsigned int          n, n_seq, s, **a2s, *w;
   int                   e, type, type2, with_ud;
   short                 *S, *S2, **SS, **S5, **S3;
   vrna_param_t          *P;
@@ -280,6 +283,7 @@ eval_ext_int_loop(vrna_fold_compound_t  *fc,
   S5          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S5;
   S3          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S3;
   a2s         = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->a2s;
+  w           = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   domains_up  = fc->domains_up;
   with_ud     = ((domains_up) && (domains_up->energy_cb)) ? 1 : 0;
   e           = INF;
@@ -312,7 +316,8 @@ eval_ext_int_loop(vrna_fold_compound_t  *fc,
           u1      = a2s[s][i - 1];
           u2      = a2s[s][k - 1] - a2s[s][j];
           u3      = a2s[s][n] - a2s[s][l];
-          energy  += E_IntLoop(u2, u1 + u3, type, type2, S3[s][j], S5[s][i], S5[s][k], S3[s][l], P);
+          energy  += E_WEIGHTED(E_IntLoop(u2, u1 + u3, type, type2, S3[s][j], S5[s][i], S5[s][k], S3[s][l], P),
+                                w[s]);
         }
 
         break;
@@ -365,7 +370,7 @@ E_internal_loop(vrna_fold_compound_t  *fc,
   unsigned char         sliding_window, hc_decompose, *hc_mx, **hc_mx_local;
   char                  *ptype, **ptype_local;
   short                 *S, **SS, **S5, **S3;
-  unsigned int          *sn, *ss, **a2s, n_seq, s, n;
+  unsigned int          *sn, *ss, **a2s, *w, n_seq, s, n;
   int                   e, eee, *idx, ij, *c, *ggg, *rtype, with_ud, with_gquad, noclose,
                         *hc_up, **c_local, **ggg_local;
   vrna_param_t          *P;
@@ -398,6 +403,7 @@ E_internal_loop(vrna_fold_compound_t  *fc,
   S5          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S5;
   S3          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S3;
   a2s         = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->a2s;
+  w           = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   c           = (sliding_window) ? NULL : fc->matrices->c;
   ggg         = (sliding_window) ? NULL : fc->matrices->ggg;
   c_local     = (sliding_window) ? fc->matrices->c_local : NULL;
@@ -473,7 +479,8 @@ E_internal_loop(vrna_fold_compound_t  *fc,
             case VRNA_FC_TYPE_COMPARATIVE:
               for (s = 0; s < n_seq; s++) {
                 type2 = vrna_get_ptype_md(SS[s][l], SS[s][k], md);
-                eee   += E_IntLoop(0, 0, tt[s], type2, S3[s][i], S5[s][j], S5[s][k], S3[s][l], P);
+                eee   += E_WEIGHTED(E_IntLoop(0, 0, tt[s], type2, S3[s][i], S5[s][j], S5[s][k], S3[s][l], P),
+                                    w[s]);
               }
 
               break;
@@ -546,8 +553,11 @@ E_internal_loop(vrna_fold_compound_t  *fc,
                 for (s = 0; s < n_seq; s++) {
                   int u1_local = a2s[s][k - 1] - a2s[s][i];
                   type2 = vrna_get_ptype_md(SS[s][l], SS[s][k], md);
-                  eee   +=
-                    E_IntLoop(u1_local, 0, tt[s], type2, S3[s][i], S5[s][j], S5[s][k], S3[s][l], P);
+                  eee   += E_WEIGHTED(E_IntLoop(u1_local, 0,
+                                                tt[s], type2,
+                                                S3[s][i], S5[s][j], S5[s][k], S3[s][l],
+                                                P),
+                                      w[s]);
                 }
 
                 break;
@@ -623,8 +633,11 @@ E_internal_loop(vrna_fold_compound_t  *fc,
                 for (s = 0; s < n_seq; s++) {
                   int u2_local = a2s[s][j - 1] - a2s[s][l];
                   type2 = vrna_get_ptype_md(SS[s][l], SS[s][k], md);
-                  eee   +=
-                    E_IntLoop(0, u2_local, tt[s], type2, S3[s][i], S5[s][j], S5[s][k], S3[s][l], P);
+                  eee   += E_WEIGHTED(E_IntLoop(0, u2_local,
+                                                tt[s], type2,
+                                                S3[s][i], S5[s][j], S5[s][k], S3[s][l],
+                                                P),
+                                      w[s]);
                 }
 
                 break;
@@ -711,15 +724,15 @@ E_internal_loop(vrna_fold_compound_t  *fc,
                   int u1_local  = a2s[s][k - 1] - a2s[s][i];
                   int u2_local  = a2s[s][j - 1] - a2s[s][l];
                   type2 = vrna_get_ptype_md(SS[s][l], SS[s][k], md);
-                  eee   += E_IntLoop(u1_local,
-                                     u2_local,
-                                     tt[s],
-                                     type2,
-                                     S3[s][i],
-                                     S5[s][j],
-                                     S5[s][k],
-                                     S3[s][l],
-                                     P);
+                  eee   += E_WEIGHTED(E_IntLoop(u1_local,
+                                                u2_local,
+                                                tt[s],
+                                                type2,
+                                                S3[s][i],
+                                                S5[s][j],
+                                                S5[s][k],
+                                                S3[s][l],
+                                                P), w[s]);
                 }
 
                 break;
@@ -887,7 +900,7 @@ E_stack(vrna_fold_compound_t  *fc,
                         *hc_mx, **hc_mx_local, eval_loop;
   char                  *ptype, **ptype_local;
   short                 *S, **SS;
-  unsigned int          n, *sn, *ss, type, type_2;
+  unsigned int          n, *sn, *ss, type, type_2, *w;
   int                   e, ij, pq, p, q, s, n_seq, *rtype, *indx;
   vrna_param_t          *P;
   vrna_md_t             *md;
@@ -905,6 +918,7 @@ E_stack(vrna_fold_compound_t  *fc,
   ss              = fc->strand_start;
   S               = (fc->type == VRNA_FC_TYPE_SINGLE) ? fc->sequence_encoding : NULL;
   SS              = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S;
+  w               = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   ptype           = (fc->type == VRNA_FC_TYPE_SINGLE) ?
                     (sliding_window ? NULL : fc->ptype) :
                     NULL;
@@ -963,7 +977,7 @@ E_stack(vrna_fold_compound_t  *fc,
         for (s = 0; s < n_seq; s++) {
           type    = vrna_get_ptype_md(SS[s][i], SS[s][j], md);
           type_2  = vrna_get_ptype_md(SS[s][q], SS[s][p], md);  /* q,p not p,q! */
-          e       += P->stack[type][type_2];
+          e       += E_WEIGHTED(P->stack[type][type_2], w[s]);
         }
 
         break;
@@ -27,6 +27,7 @@
 
 #include "internal_hc.inc"
 #include "internal_sc.inc"
+#include "ViennaRNA/sequence_weights.inc"
 
 /*
  #################################
@@ -98,7 +99,7 @@ BT_stack(vrna_fold_compound_t *fc,
   unsigned char         sliding_window, eval_loop, hc_decompose_ij, hc_decompose_pq;
   char                  *ptype, **ptype_local;
   short                 **SS;
-  unsigned int          n, n_seq, s, *sn, *ss, type, type_2;
+  unsigned int          n, n_seq, s, *sn, *ss, *w, type, type_2;
   int                   ret, eee, ij, p, q, *idx, *my_c, **c_local, *rtype;
   vrna_param_t          *P;
   vrna_md_t             *md;
@@ -113,6 +114,7 @@ BT_stack(vrna_fold_compound_t *fc,
   sn              = fc->strand_number;
   ss              = fc->strand_start;
   SS              = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S;
+  w               = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   ptype           = (sliding_window) ? NULL : fc->ptype;
   ptype_local     = (sliding_window) ? fc->ptype_local : NULL;
   idx             = (sliding_window) ? NULL : fc->jindx;
@@ -176,7 +178,7 @@ BT_stack(vrna_fold_compound_t *fc,
           for (s = 0; s < n_seq; s++) {
             type    = vrna_get_ptype_md(SS[s][*i], SS[s][*j], md);
             type_2  = vrna_get_ptype_md(SS[s][q], SS[s][p], md);
-            *en     -= P->stack[type][type_2];
+            *en     -= E_WEIGHTED(P->stack[type][type_2], w[s]);
           }
           *en += (sliding_window) ? fc->pscore_local[*i][*j - *i] : fc->pscore[ij];
 
@@ -27,6 +27,7 @@
 
 #include "internal_hc.inc"
 #include "internal_sc_pf.inc"
+#include "ViennaRNA/sequence_weights.inc"
 
 /*
  #################################
@@ -109,7 +110,7 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
   char                      *ptype, **ptype_local;
   unsigned char             *hc_mx, **hc_mx_local;
   short                     *S1, **SS, **S5, **S3;
-  unsigned int              *sn, *se, *ss, n_seq, s, **a2s, n;
+  unsigned int              *sn, *se, *ss, *w, n_seq, s, **a2s, n;
   int                       *rtype, noclose, *my_iindx, *jindx, *hc_up, ij,
                             with_gquad, with_ud;
   FLT_OR_DBL                qbt1, q_temp, *qb, **qb_local, *G, *scale;
@@ -131,6 +132,7 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
     (fc->type == VRNA_FC_TYPE_SINGLE) ? (sliding_window ? fc->ptype_local : NULL) : NULL;
   S1          = (fc->type == VRNA_FC_TYPE_SINGLE) ? fc->sequence_encoding : NULL;
   SS          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S;
+  w           = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   S5          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S5;
   S3          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S3;
   a2s         = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->a2s;
@@ -213,15 +215,15 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
           case VRNA_FC_TYPE_COMPARATIVE:
             for (s = 0; s < n_seq; s++) {
               type2   = vrna_get_ptype_md(SS[s][l], SS[s][k], md);
-              q_temp  *= exp_E_IntLoop(0,
-                                       0,
-                                       tt[s],
-                                       type2,
-                                       S3[s][i],
-                                       S5[s][j],
-                                       S5[s][k],
-                                       S3[s][l],
-                                       pf_params);
+              q_temp  *= exp_weighted(exp_E_IntLoop(0,
+                                                    0,
+                                                    tt[s],
+                                                    type2,
+                                                    S3[s][i],
+                                                    S5[s][j],
+                                                    S5[s][k],
+                                                    S3[s][l],
+                                                    pf_params), w[s]);
             }
             break;
         }
@@ -289,15 +291,15 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
                 for (s = 0; s < n_seq; s++) {
                   int u1_local = a2s[s][k - 1] - a2s[s][i];
                   type2   = vrna_get_ptype_md(SS[s][l], SS[s][k], md);
-                  q_temp  *= exp_E_IntLoop(u1_local,
-                                           0,
-                                           tt[s],
-                                           type2,
-                                           S3[s][i],
-                                           S5[s][j],
-                                           S5[s][k],
-                                           S3[s][l],
-                                           pf_params);
+                  q_temp  *= exp_weighted(exp_E_IntLoop(u1_local,
+                                                        0,
+                                                        tt[s],
+                                                        type2,
+                                                        S3[s][i],
+                                                        S5[s][j],
+                                                        S5[s][k],
+                                                        S3[s][l],
+                                                        pf_params), w[s]);
                 }
                 break;
             }
@@ -371,15 +373,15 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
                 for (s = 0; s < n_seq; s++) {
                   int u2_local = a2s[s][j - 1] - a2s[s][l];
                   type2   = vrna_get_ptype_md(SS[s][l], SS[s][k], md);
-                  q_temp  *= exp_E_IntLoop(0,
-                                           u2_local,
-                                           tt[s],
-                                           type2,
-                                           S3[s][i],
-                                           S5[s][j],
-                                           S5[s][k],
-                                           S3[s][l],
-                                           pf_params);
+                  q_temp  *= exp_weighted(exp_E_IntLoop(0,
+                                                        u2_local,
+                                                        tt[s],
+                                                        type2,
+                                                        S3[s][i],
+                                                        S5[s][j],
+                                                        S5[s][k],
+                                                        S3[s][l],
+                                                        pf_params), w[s]);
                 }
                 break;
             }
@@ -468,15 +470,15 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
                   int u1_local  = a2s[s][k - 1] - a2s[s][i];
                   int u2_local  = a2s[s][j - 1] - a2s[s][l];
                   type2   = vrna_get_ptype_md(SS[s][l], SS[s][k], md);
-                  q_temp  *= exp_E_IntLoop(u1_local,
-                                           u2_local,
-                                           tt[s],
-                                           type2,
-                                           S3[s][i],
-                                           S5[s][j],
-                                           S5[s][k],
-                                           S3[s][l],
-                                           pf_params);
+                  q_temp  *= exp_weighted(exp_E_IntLoop(u1_local,
+                                                        u2_local,
+                                                        tt[s],
+                                                        type2,
+                                                        S3[s][i],
+                                                        S5[s][j],
+                                                        S5[s][k],
+                                                        S3[s][l],
+                                                        pf_params), w[s]);
                 }
 
                 break;
@@ -564,7 +566,7 @@ exp_E_ext_int_loop(vrna_fold_compound_t *fc,
 {
   unsigned char             *hc_mx, eval_loop;
   short                     *S, *S2, **SS, **S5, **S3;
-  unsigned int              *tt, n_seq, s, **a2s, type, type2;
+  unsigned int              *tt, *w, n_seq, s, **a2s, type, type2;
   int                       k, l, u1, u2, u3, qmin, with_ud,
                             n, *my_iindx, *hc_up, turn,
                             u1_local, u2_local, u3_local;
@@ -581,6 +583,7 @@ exp_E_ext_int_loop(vrna_fold_compound_t *fc,
   S           = (fc->type == VRNA_FC_TYPE_SINGLE) ? fc->sequence_encoding : NULL;
   S2          = (fc->type == VRNA_FC_TYPE_SINGLE) ? fc->sequence_encoding2 : NULL;
   SS          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S;
+  w           = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   S5          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S5;
   S3          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S3;
   a2s         = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->a2s;
@@ -664,15 +667,15 @@ exp_E_ext_int_loop(vrna_fold_compound_t *fc,
                 u1_local  = a2s[s][i - 1];
                 u2_local  = a2s[s][k - 1] - a2s[s][j];
                 u3_local  = a2s[s][n] - a2s[s][l];
-                q_temp    *= exp_E_IntLoop(u2_local,
-                                           u1_local + u3_local,
-                                           tt[s],
-                                           type2,
-                                           S3[s][j],
-                                           S5[s][i],
-                                           S5[s][k],
-                                           S3[s][l],
-                                           pf_params);
+                q_temp    *= exp_weighted(exp_E_IntLoop(u2_local,
+                                                        u1_local + u3_local,
+                                                        tt[s],
+                                                        type2,
+                                                        S3[s][j],
+                                                        S5[s][i],
+                                                        S5[s][k],
+                                                        S3[s][l],
+                                                        pf_params), w[s]);
               }
               break;
           }
@@ -739,7 +742,7 @@ exp_E_interior_loop(vrna_fold_compound_t  *fc,
   char                      *ptype, **ptype_local;
   unsigned char             *hc_mx, **hc_mx_local, eval_loop, hc_decompose_ij, hc_decompose_kl;
   short                     *S1, **SS, **S5, **S3;
-  unsigned int              n, *sn, n_seq, s, **a2s;
+  unsigned int              n, *sn, *w, n_seq, s, **a2s;
   int                       u1, u2, *rtype, *jindx, *hc_up;
   FLT_OR_DBL                qbt1, q_temp, *scale;
   vrna_exp_param_t          *pf_params;
@@ -757,6 +760,7 @@ exp_E_interior_loop(vrna_fold_compound_t  *fc,
     (fc->type == VRNA_FC_TYPE_SINGLE) ? (sliding_window ? fc->ptype_local : NULL) : NULL;
   S1          = (fc->type == VRNA_FC_TYPE_SINGLE) ? fc->sequence_encoding : NULL;
   SS          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S;
+  w           = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   S5          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S5;
   S3          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S3;
   a2s         = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->a2s;
@@ -826,15 +830,15 @@ exp_E_interior_loop(vrna_fold_compound_t  *fc,
           int u2_local  = a2s[s][j - 1] - a2s[s][l];
           type    = vrna_get_ptype_md(SS[s][i], SS[s][j], md);
           type2   = vrna_get_ptype_md(SS[s][l], SS[s][k], md);
-          q_temp  *= exp_E_IntLoop(u1_local,
-                                   u2_local,
-                                   type,
-                                   type2,
-                                   S3[s][i],
-                                   S5[s][j],
-                                   S5[s][k],
-                                   S3[s][l],
-                                   pf_params);
+          q_temp  *= exp_weighted(exp_E_IntLoop(u1_local,
+                                                u2_local,
+                                                type,
+                                                type2,
+                                                S3[s][i],
+                                                S5[s][j],
+                                                S5[s][k],
+                                                S3[s][l],
+                                                pf_params), w[s]);
         }
 
         break;
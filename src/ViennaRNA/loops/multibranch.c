@@ -32,6 +32,7 @@
 
 #include "multibranch_hc.inc"
 #include "multibranch_sc.inc"
+#include "ViennaRNA/sequence_weights.inc"
 
 /*
  #################################
@@ -230,10 +231,10 @@ ml_pair_d0(vrna_fold_compound_t       *fc,
           SS    = fc->S;
           for (s = 0; s < n_seq; s++) {
             tt  = vrna_get_ptype_md(SS[s][j], SS[s][i], md);
-            e   += E_MLstem(tt, -1, -1, P);
+            e   += E_WEIGHTED(E_MLstem(tt, -1, -1, P), fc->seq_weights[s]);
           }
 
-          e += n_seq * P->MLclosing;
+          e += fc->n_seq_total * P->MLclosing;
           break;
       }
 
@@ -327,10 +328,10 @@ ml_pair_d2(vrna_fold_compound_t       *fc,
 
           for (s = 0; s < n_seq; s++) {
             tt  = vrna_get_ptype_md(SS[s][j], SS[s][i], md);
-            e   += E_MLstem(tt, S5[s][j], S3[s][i], P);
+            e   += E_WEIGHTED(E_MLstem(tt, S5[s][j], S3[s][i], P), fc->seq_weights[s]);
           }
 
-          e += n_seq * P->MLclosing;
+          e += fc->n_seq_total * P->MLclosing;
           break;
       }
 
@@ -391,10 +392,10 @@ ml_pair5(vrna_fold_compound_t       *fc,
 
           for (s = 0; s < n_seq; s++) {
             tt  = vrna_get_ptype_md(SS[s][j], SS[s][i], md);
-            e   += E_MLstem(tt, -1, S3[s][i], P);
+            e   += E_WEIGHTED(E_MLstem(tt, -1, S3[s][i], P), fc->seq_weights[s]);
           }
 
-          e += n_seq * P->MLclosing;
+          e += fc->n_seq_total * P->MLclosing;
           break;
       }
 
@@ -455,10 +456,10 @@ ml_pair3(vrna_fold_compound_t       *fc,
 
           for (s = 0; s < n_seq; s++) {
             tt  = vrna_get_ptype_md(SS[s][j], SS[s][i], md);
-            e   += E_MLstem(tt, S5[s][j], -1, P);
+            e   += E_WEIGHTED(E_MLstem(tt, S5[s][j], -1, P), fc->seq_weights[s]);
           }
 
-          e += n_seq * P->MLclosing;
+          e += fc->n_seq_total * P->MLclosing;
           break;
       }
 
@@ -522,10 +523,10 @@ ml_pair53(vrna_fold_compound_t      *fc,
 
           for (s = 0; s < n_seq; s++) {
             tt  = vrna_get_ptype_md(SS[s][j], SS[s][i], md);
-            e   += E_MLstem(tt, S5[s][j], S3[s][i], P);
+            e   += E_WEIGHTED(E_MLstem(tt, S5[s][j], S3[s][i], P), fc->seq_weights[s]);
           }
 
-          e += n_seq * P->MLclosing;
+          e += fc->n_seq_total * P->MLclosing;
           break;
       }
 
@@ -710,7 +711,7 @@ E_mb_loop_stack(vrna_fold_compound_t  *fc,
 {
   char                      *ptype, **ptype_local;
   short                     **SS;
-  unsigned int              n_seq, s, *tt, sliding_window;
+  unsigned int              n_seq, n_seq_total, *w, s, *tt, sliding_window;
   int                       *c, *fML, e, decomp, en, i1k, k1j1, ij, k, *indx, turn,
                             type, type_2, *rtype, **c_local, **fML_local;
   vrna_param_t              *P;
@@ -722,6 +723,8 @@ E_mb_loop_stack(vrna_fold_compound_t  *fc,
   sliding_window = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
 
   n_seq       = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
+  n_seq_total = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq_total;
+  w           = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   SS          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S;
   indx        = fc->jindx;
   P           = fc->params;
@@ -771,7 +774,7 @@ E_mb_loop_stack(vrna_fold_compound_t  *fc,
             case VRNA_FC_TYPE_COMPARATIVE:
               for (s = 0; s < n_seq; s++) {
                 type_2  = vrna_get_ptype_md(SS[s][k], SS[s][i + 1], md);
-                en      += P->stack[tt[s]][type_2];
+                en      += E_WEIGHTED(P->stack[tt[s]][type_2], w[s]);
               }
               break;
           }
@@ -796,7 +799,7 @@ E_mb_loop_stack(vrna_fold_compound_t  *fc,
             case VRNA_FC_TYPE_COMPARATIVE:
               for (s = 0; s < n_seq; s++) {
                 type_2  = vrna_get_ptype_md(SS[s][j - 1], SS[s][k + 1], md);
-                en      += P->stack[tt[s]][type_2];
+                en      += E_WEIGHTED(P->stack[tt[s]][type_2], w[s]);
               }
 
               break;
@@ -827,7 +830,7 @@ E_mb_loop_stack(vrna_fold_compound_t  *fc,
             case VRNA_FC_TYPE_COMPARATIVE:
               for (s = 0; s < n_seq; s++) {
                 type_2  = vrna_get_ptype_md(SS[s][k], SS[s][i + 1], md);
-                en      += P->stack[tt[s]][type_2];
+                en      += E_WEIGHTED(P->stack[tt[s]][type_2], w[s]);
               }
 
               break;
@@ -853,7 +856,7 @@ E_mb_loop_stack(vrna_fold_compound_t  *fc,
             case VRNA_FC_TYPE_COMPARATIVE:
               for (s = 0; s < n_seq; s++) {
                 type_2  = vrna_get_ptype_md(SS[s][j - 1], SS[s][k + 1], md);
-                en      += P->stack[tt[s]][type_2];
+                en      += E_WEIGHTED(P->stack[tt[s]][type_2], w[s]);
               }
 
               break;
@@ -869,7 +872,7 @@ E_mb_loop_stack(vrna_fold_compound_t  *fc,
 
     /* no TermAU penalty if coax stack */
     decomp += (2 * P->MLintern[1] + P->MLclosing) *
-              n_seq;
+              n_seq_total;
 
     if (sc_wrapper.pair)
       decomp += sc_wrapper.pair(i, j, &sc_wrapper);
@@ -900,7 +903,7 @@ extend_fm_3p(int                        i,
              struct sc_wrapper_ml       *sc_wrapper)
 {
   short         *S, **SS, **S5, **S3;
-  unsigned int  *sn, n_seq, s, sliding_window;
+  unsigned int  *sn, n_seq, n_seq_total, *w, s, sliding_window;
   int           en, en2, length, *indx, *c, **c_local, **fm_local, *ggg, **ggg_local, ij, type,
                 dangle_model, with_gquad, e, u, k, cnt, with_ud;
   vrna_param_t  *P;
@@ -909,6 +912,8 @@ extend_fm_3p(int                        i,
 
   sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
   n_seq           = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
+  n_seq_total     = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq_total;
+  w               = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   length          = fc->length;
   S               = (fc->type == VRNA_FC_TYPE_SINGLE) ? fc->sequence_encoding : NULL;
   SS              = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S;
@@ -956,12 +961,12 @@ extend_fm_3p(int                        i,
           if (dangle_model == 2) {
             for (s = 0; s < n_seq; s++) {
               type  = vrna_get_ptype_md(SS[s][i], SS[s][j], md);
-              en    += E_MLstem(type, S5[s][i], S3[s][j], P);
+              en    += E_WEIGHTED(E_MLstem(type, S5[s][i], S3[s][j], P), w[s]);
             }
           } else {
             for (s = 0; s < n_seq; s++) {
               type  = vrna_get_ptype_md(SS[s][i], SS[s][j], md);
-              en    += E_MLstem(type, -1, -1, P);
+              en    += E_WEIGHTED(E_MLstem(type, -1, -1, P), w[s]);
             }
           }
 
@@ -979,7 +984,7 @@ extend_fm_3p(int                        i,
     if (sn[i] == sn[j]) {
       en  = (sliding_window) ? ggg_local[i][j - i] : ggg[ij];
       en  += E_MLstem(0, -1, -1, P) *
-             n_seq;
+             n_seq_total;
 
       e = MIN2(e, en);
     }
@@ -989,7 +994,7 @@ extend_fm_3p(int                        i,
     en = (sliding_window) ? fm_local[i][j - 1 - i] : fm[indx[j - 1] + i];
     if (en != INF) {
       en += P->MLbase *
-            n_seq;
+            n_seq_total;
 
       if (sc_wrapper->red_ml)
         en += sc_wrapper->red_ml(i, j, i, j - 1, sc_wrapper);
@@ -1006,7 +1011,7 @@ extend_fm_3p(int                        i,
         en = (sliding_window) ? fm_local[i][k - 1 - i] : fm[indx[k - 1] + i];
         if (en != INF) {
           en += u * P->MLbase *
-                n_seq;
+                n_seq_total;
 
           en2 = domains_up->energy_cb(fc,
                                       k,
@@ -1039,7 +1044,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
 {
   char                      *ptype, **ptype_local;
   short                     *S, **SS, **S5, **S3;
-  unsigned int              *sn, *se, n_seq, s;
+  unsigned int              *sn, *se, n_seq, n_seq_total, *w, s;
   int                       k, en, decomp, mm5, mm3, type_2, k1j, length, *indx,
                             *c, *fm, ij, dangle_model, turn, type, *rtype, circular, e, u,
                             cnt, with_ud, sliding_window, **c_local, **fm_local;
@@ -1064,6 +1069,8 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
   S3            = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S3;
   indx          = (sliding_window) ? NULL : fc->jindx;
   n_seq         = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
+  n_seq_total   = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq_total;
+  w             = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   sn            = fc->strand_number;
   se            = fc->strand_end;
   hc            = fc->hc;
@@ -1101,7 +1108,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
     en = (sliding_window) ? fm_local[i + 1][j - i - 1] : fm[ij + 1];
     if (en != INF) {
       en += P->MLbase *
-            n_seq;
+            n_seq_total;
 
       if (sc_wrapper.red_ml)
         en += sc_wrapper.red_ml(i, j, i + 1, j, &sc_wrapper);
@@ -1119,7 +1126,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
         decomp = (sliding_window) ? fm_local[i + u][j - (i + u)] : fm[ij + u];
         if (decomp != INF) {
           decomp += u * P->MLbase *
-                    n_seq;
+                    n_seq_total;
 
           en = domains_up->energy_cb(fc,
                                      i,
@@ -1155,7 +1162,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
       en = (sliding_window) ? c_local[i + 1][j - (i + 1)] : c[ij + 1];
       if (en != INF) {
         en += P->MLbase *
-              n_seq;
+              n_seq_total;
 
         switch (fc->type) {
           case VRNA_FC_TYPE_SINGLE:
@@ -1169,7 +1176,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
           case VRNA_FC_TYPE_COMPARATIVE:
             for (s = 0; s < n_seq; s++) {
               type  = vrna_get_ptype_md(SS[s][i + 1], SS[s][j], md);
-              en    += E_MLstem(type, S5[s][i + 1], -1, P);
+              en    += E_WEIGHTED(E_MLstem(type, S5[s][i + 1], -1, P), w[s]);
             }
             break;
         }
@@ -1185,7 +1192,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
       en = (sliding_window) ? c_local[i][j - 1 - i] : c[indx[j - 1] + i];
       if (en != INF) {
         en += P->MLbase *
-              n_seq;
+              n_seq_total;
 
         switch (fc->type) {
           case VRNA_FC_TYPE_SINGLE:
@@ -1200,7 +1207,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
           case VRNA_FC_TYPE_COMPARATIVE:
             for (s = 0; s < n_seq; s++) {
               type  = vrna_get_ptype_md(SS[s][i], SS[s][j - 1], md);
-              en    += E_MLstem(type, -1, S3[s][j - 1], P);
+              en    += E_WEIGHTED(E_MLstem(type, -1, S3[s][j - 1], P), w[s]);
             }
             break;
         }
@@ -1216,7 +1223,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
       en = (sliding_window) ? c_local[i + 1][j - 1 - (i + 1)] : c[indx[j - 1] + i + 1];
       if (en != INF) {
         en += 2 * P->MLbase *
-              n_seq;
+              n_seq_total;
 
         switch (fc->type) {
           case VRNA_FC_TYPE_SINGLE:
@@ -1231,7 +1238,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
           case VRNA_FC_TYPE_COMPARATIVE:
             for (s = 0; s < n_seq; s++) {
               type  = vrna_get_ptype_md(SS[s][i + 1], SS[s][j - 1], md);
-              en    += E_MLstem(type, S5[s][i + 1], S3[s][j - 1], P);
+              en    += E_WEIGHTED(E_MLstem(type, S5[s][i + 1], S3[s][j - 1], P), w[s]);
             }
             break;
         }
@@ -1399,7 +1406,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
                   type    = vrna_get_ptype_md(SS[s][k], SS[s][i], md);
                   type_2  = vrna_get_ptype_md(SS[s][j], SS[s][k + 1], md);
 
-                  en += P->stack[type][type_2];
+                  en += E_WEIGHTED(P->stack[type][type_2], w[s]);
                 }
 
                 break;
@@ -1422,7 +1429,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
 
     /* no TermAU penalty if coax stack */
     decomp += 2 * P->MLintern[1] *
-              n_seq;
+              n_seq_total;
 #if 0
     /*
      * This is needed for Y shaped ML loops with coax stacking of
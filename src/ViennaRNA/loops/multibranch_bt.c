@@ -28,6 +28,7 @@
 
 #include "multibranch_hc.inc"
 #include "multibranch_sc.inc"
+#include "ViennaRNA/sequence_weights.inc"
 
 /*
  #################################
@@ -510,7 +511,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
   unsigned char             sliding_window;
   char                      *ptype, **ptype_local;
   short                     *S1, **SS, **S5, **S3;
-  unsigned int              n_seq, s;
+  unsigned int              n_seq, n_seq_total, *w, s;
   int                       ij, ii, jj, fij, fi, u, en, *my_c, *my_fML, *my_ggg,
                             turn, *idx, with_gquad, dangle_model, *rtype, kk, cnt,
                             with_ud, type, type_2, en2, **c_local, **fML_local, **ggg_local;
@@ -523,6 +524,8 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
 
   sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
   n_seq           = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
+  n_seq_total     = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq_total;
+  w               = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   P               = fc->params;
   md              = &(P->model_details);
   idx             = (sliding_window) ? NULL : fc->jindx;
@@ -563,7 +566,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
       /* process regular unpaired nucleotides (unbound by ligand) first */
       if (evaluate(ii, jj, ii, jj - 1, VRNA_DECOMP_ML_ML, &hc_dat_local)) {
         fi = P->MLbase *
-             n_seq;
+             n_seq_total;
         fi += (sliding_window) ? fML_local[ii][jj - 1 - ii] : my_fML[idx[jj - 1] + ii];
 
         if (sc_wrapper.red_ml)
@@ -594,7 +597,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
 
           fi = en +
                u * P->MLbase *
-               n_seq;
+               n_seq_total;
           fi += (sliding_window) ? fML_local[ii][kk - 1 - ii] : my_fML[idx[kk - 1] + ii];
 
           if (fij == fi) {
@@ -617,7 +620,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
       /* again, process regular unpaired nucleotides (unbound by ligand) first */
       if (evaluate(ii, jj, ii + 1, jj, VRNA_DECOMP_ML_ML, &hc_dat_local)) {
         fi = P->MLbase *
-             n_seq;
+             n_seq_total;
         fi += (sliding_window) ? fML_local[ii + 1][jj - (ii + 1)] : my_fML[idx[jj] + ii + 1];
 
         if (sc_wrapper.red_ml)
@@ -648,7 +651,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
 
           fi = en +
                u * P->MLbase *
-               n_seq;
+               n_seq_total;
 
           fi += (sliding_window) ? fML_local[kk + 1][jj - (kk + 1)] : my_fML[idx[jj] + kk + 1];
 
@@ -671,7 +674,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
 
       if (evaluate(ii, jj, ii, jj - 1, VRNA_DECOMP_ML_ML, &hc_dat_local)) {
         fi = P->MLbase *
-             n_seq;
+             n_seq_total;
         fi += (sliding_window) ? fML_local[ii][jj - 1 - ii] : my_fML[idx[jj - 1] + ii];
 
         if (sc_wrapper.red_ml)
@@ -690,7 +693,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
 
       if (evaluate(ii, jj, ii + 1, jj, VRNA_DECOMP_ML_ML, &hc_dat_local)) {
         fi = P->MLbase *
-             n_seq;
+             n_seq_total;
         fi += (sliding_window) ? fML_local[ii + 1][jj - (ii + 1)] : my_fML[idx[jj] + ii + 1];
 
         if (sc_wrapper.red_ml)
@@ -714,7 +717,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
 
   if (with_gquad) {
     en = E_MLstem(0, -1, -1, P) *
-         n_seq;
+         n_seq_total;
     en += (sliding_window) ? ggg_local[ii][jj - ii] : my_ggg[ij];
 
     if (fij == en) {
@@ -744,7 +747,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
           case VRNA_FC_TYPE_COMPARATIVE:
             for (s = 0; s < n_seq; s++) {
               type  = vrna_get_ptype_md(SS[s][ii], SS[s][jj], md);
-              en2   += E_MLstem(type, -1, -1, P);
+              en2   += E_WEIGHTED(E_MLstem(type, -1, -1, P), w[s]);
             }
             break;
         }
@@ -774,7 +777,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
           case VRNA_FC_TYPE_COMPARATIVE:
             for (s = 0; s < n_seq; s++) {
               type  = vrna_get_ptype_md(SS[s][ii], SS[s][jj], md);
-              en2   += E_MLstem(type, S5[s][ii], S3[s][jj], P);
+              en2   += E_WEIGHTED(E_MLstem(type, S5[s][ii], S3[s][jj], P), w[s]);
             }
             break;
         }
@@ -804,7 +807,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
           case VRNA_FC_TYPE_COMPARATIVE:
             for (s = 0; s < n_seq; s++) {
               type  = vrna_get_ptype_md(SS[s][ii], SS[s][jj], md);
-              en2   += E_MLstem(type, -1, -1, P);
+              en2   += E_WEIGHTED(E_MLstem(type, -1, -1, P), w[s]);
             }
             break;
         }
@@ -820,7 +823,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
 
       if (evaluate(ii, jj, ii + 1, jj, VRNA_DECOMP_ML_STEM, &hc_dat_local)) {
         en2 = P->MLbase *
-              n_seq;
+              n_seq_total;
         en2 += (sliding_window) ? c_local[ii + 1][jj - (ii + 1)] : my_c[ij + 1];
 
         switch (fc->type) {
@@ -835,7 +838,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
           case VRNA_FC_TYPE_COMPARATIVE:
             for (s = 0; s < n_seq; s++) {
               type  = vrna_get_ptype_md(SS[s][ii], SS[s][jj], md);
-              en2   += E_MLstem(type, S5[s][ii], -1, P);
+              en2   += E_WEIGHTED(E_MLstem(type, S5[s][ii], -1, P), w[s]);
             }
             break;
         }
@@ -854,7 +857,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
 
       if (evaluate(ii, jj, ii, jj - 1, VRNA_DECOMP_ML_STEM, &hc_dat_local)) {
         en2 = P->MLbase *
-              n_seq;
+              n_seq_total;
         en2 += (sliding_window) ? c_local[ii][jj - 1 - ii] : my_c[idx[jj - 1] + ii];
 
         switch (fc->type) {
@@ -870,7 +873,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
           case VRNA_FC_TYPE_COMPARATIVE:
             for (s = 0; s < n_seq; s++) {
               type  = vrna_get_ptype_md(SS[s][ii], SS[s][jj], md);
-              en2   += E_MLstem(type, -1, S3[s][jj], P);
+              en2   += E_WEIGHTED(E_MLstem(type, -1, S3[s][jj], P), w[s]);
             }
             break;
         }
@@ -889,7 +892,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
 
       if (evaluate(ii, jj, ii + 1, jj - 1, VRNA_DECOMP_ML_STEM, &hc_dat_local)) {
         en2 = 2 * P->MLbase *
-              n_seq;
+              n_seq_total;
         en2 += (sliding_window) ? c_local[ii + 1][jj - 1 - (ii + 1)] : my_c[idx[jj - 1] + ii + 1];
 
         switch (fc->type) {
@@ -905,7 +908,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
           case VRNA_FC_TYPE_COMPARATIVE:
             for (s = 0; s < n_seq; s++) {
               type  = vrna_get_ptype_md(SS[s][ii], SS[s][jj], md);
-              en2   += E_MLstem(type, S5[s][ii], S3[s][jj], P);
+              en2   += E_WEIGHTED(E_MLstem(type, S5[s][ii], S3[s][jj], P), w[s]);
             }
             break;
         }
@@ -956,7 +959,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
       ik = (sliding_window) ? 0 : idx[u] + ii;
       if (evaluate(ii, u, u + 1, jj, VRNA_DECOMP_ML_COAXIAL_ENC, &hc_dat_local)) {
         en = 2 * P->MLintern[1] *
-             n_seq;
+             n_seq_total;
         en += (sliding_window) ? c_local[ii][u - ii] + c_local[u + 1][jj - (u + 1)] : my_c[ik] +
               my_c[k1j];
 
@@ -978,7 +981,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
             for (s = 0; s < n_seq; s++) {
               type    = vrna_get_ptype_md(SS[s][u], SS[s][ii], md);
               type_2  = vrna_get_ptype_md(SS[s][jj], SS[s][u + 1], md);
-              en      += P->stack[type][type_2];
+              en      += E_WEIGHTED(P->stack[type][type_2], w[s]);
             }
             break;
         }
@@ -1014,7 +1017,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
   unsigned char             sliding_window;
   char                      *ptype, **ptype_local;
   short                     s5, s3, *S1, **SS, **S5, **S3;
-  unsigned int              *sn, *se, n_seq, s, *tt;
+  unsigned int              *sn, *se, n_seq, n_seq_total, *w, s, *tt;
   int                       ij, p, q, r, e, eee, tmp_en, *idx, turn, dangle_model,
                             *my_c, *my_fML, *my_fc, *rtype, type, type_2, **c_local, **fML_local;
   vrna_param_t              *P;
@@ -1028,6 +1031,8 @@ BT_mb_loop(vrna_fold_compound_t *fc,
 
   sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
   n_seq           = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
+  n_seq_total     = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq_total;
+  w               = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   idx             = (sliding_window) ? NULL : fc->jindx;
   ij              = (sliding_window) ? 0 : idx[*j] + *i;
   S1              = (fc->type == VRNA_FC_TYPE_SINGLE) ? fc->sequence_encoding : NULL;
@@ -1192,7 +1197,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
       case 0:
         e = en -
             P->MLclosing *
-            n_seq;
+            n_seq_total;
 
         switch (fc->type) {
           case VRNA_FC_TYPE_SINGLE:
@@ -1201,7 +1206,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
 
           case VRNA_FC_TYPE_COMPARATIVE:
             for (s = 0; s < n_seq; s++)
-              e -= E_MLstem(tt[s], -1, -1, P);
+              e -= E_WEIGHTED(E_MLstem(tt[s], -1, -1, P), w[s]);
             break;
         }
 
@@ -1229,7 +1234,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
       case 2:
         e = en -
             P->MLclosing *
-            n_seq;
+            n_seq_total;
 
         switch (fc->type) {
           case VRNA_FC_TYPE_SINGLE:
@@ -1238,7 +1243,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
 
           case VRNA_FC_TYPE_COMPARATIVE:
             for (s = 0; s < n_seq; s++)
-              e -= E_MLstem(tt[s], S5[s][*j], S3[s][*i], P);
+              e -= E_WEIGHTED(E_MLstem(tt[s], S5[s][*j], S3[s][*i], P), w[s]);
             break;
         }
 
@@ -1266,7 +1271,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
       default:
         eee = en -
               P->MLclosing *
-              n_seq;
+              n_seq_total;
 
         e = eee;
 
@@ -1280,7 +1285,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
 
           case VRNA_FC_TYPE_COMPARATIVE:
             for (s = 0; s < n_seq; s++)
-              e -= E_MLstem(tt[s], -1, -1, P);
+              e -= E_WEIGHTED(E_MLstem(tt[s], -1, -1, P), w[s]);
             break;
         }
 
@@ -1304,7 +1309,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
         if (evaluate(*i, *j, p + 1, q, VRNA_DECOMP_PAIR_ML, &hc_dat_local)) {
           e = eee -
               P->MLbase *
-              n_seq;
+              n_seq_total;
 
           if (sc_wrapper.pair5)
             e -= sc_wrapper.pair5(*i, *j, &sc_wrapper);
@@ -1316,7 +1321,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
 
             case VRNA_FC_TYPE_COMPARATIVE:
               for (s = 0; s < n_seq; s++)
-                e -= E_MLstem(tt[s], -1, S3[s][*i], P);
+                e -= E_WEIGHTED(E_MLstem(tt[s], -1, S3[s][*i], P), w[s]);
               break;
           }
 
@@ -1343,7 +1348,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
         if (evaluate(*i, *j, p, q - 1, VRNA_DECOMP_PAIR_ML, &hc_dat_local)) {
           e = eee -
               P->MLbase *
-              n_seq;
+              n_seq_total;
 
           if (sc_wrapper.pair3)
             e -= sc_wrapper.pair3(*i, *j, &sc_wrapper);
@@ -1355,7 +1360,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
 
             case VRNA_FC_TYPE_COMPARATIVE:
               for (s = 0; s < n_seq; s++)
-                e -= E_MLstem(tt[s], S5[s][*j], -1, P);
+                e -= E_WEIGHTED(E_MLstem(tt[s], S5[s][*j], -1, P), w[s]);
               break;
           }
 
@@ -1384,7 +1389,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
         if (evaluate(*i, *j, p + 1, q - 1, VRNA_DECOMP_PAIR_ML, &hc_dat_local)) {
           e = eee -
               2 * P->MLbase *
-              n_seq;
+              n_seq_total;
 
           if (sc_wrapper.pair53)
             e -= sc_wrapper.pair53(*i, *j, &sc_wrapper);
@@ -1396,7 +1401,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
 
             case VRNA_FC_TYPE_COMPARATIVE:
               for (s = 0; s < n_seq; s++)
-                e -= E_MLstem(tt[s], S5[s][*j], S3[s][*i], P);
+                e -= E_WEIGHTED(E_MLstem(tt[s], S5[s][*j], S3[s][*i], P), w[s]);
               break;
           }
 
@@ -1426,7 +1431,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
         if (dangle_model == 3) {
           e = eee -
               2 * P->MLintern[1] *
-              n_seq;
+              n_seq_total;
 
           if (sc_wrapper.pair)
             e -= sc_wrapper.pair(*i, *j, &sc_wrapper);
@@ -1456,7 +1461,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
                 case VRNA_FC_TYPE_COMPARATIVE:
                   for (s = 0; s < n_seq; s++) {
                     type_2  = vrna_get_ptype_md(SS[s][r], SS[s][p], md);
-                    tmp_en  += P->stack[tt[s]][type_2];
+                    tmp_en  += E_WEIGHTED(P->stack[tt[s]][type_2], w[s]);
                   }
                   break;
               }
@@ -1491,7 +1496,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
                 case VRNA_FC_TYPE_COMPARATIVE:
                   for (s = 0; s < n_seq; s++) {
                     type_2  = vrna_get_ptype_md(SS[s][q], SS[s][r + 1], md);
-                    tmp_en  += P->stack[tt[s]][type_2];
+                    tmp_en  += E_WEIGHTED(P->stack[tt[s]][type_2], w[s]);
                   }
                   break;
               }
@@ -28,6 +28,7 @@
 
 #include "multibranch_hc.inc"
 #include "multibranch_sc_pf.inc"
+#include "ViennaRNA/sequence_weights.inc"
 
 struct vrna_mx_pf_aux_ml_s {
   FLT_OR_DBL  *qqm;
@@ -242,7 +243,7 @@ exp_E_mb_loop_fast(vrna_fold_compound_t       *fc,
   unsigned char             sliding_window;
   char                      *ptype, **ptype_local;
   short                     *S1, **SS, **S5, **S3;
-  unsigned int              *sn, n_seq, s, *se;
+  unsigned int              *sn, n_seq, n_seq_total, *w, s, *se;
   int                       ij, k, kl, *my_iindx, *jindx, *rtype, tt;
   FLT_OR_DBL                qbt1, temp, qqqmmm, *qm, **qm_local, *scale, expMLclosing, *qqm1;
   vrna_hc_t                 *hc;
@@ -255,6 +256,8 @@ exp_E_mb_loop_fast(vrna_fold_compound_t       *fc,
   qqm1            = aux_mx->qqm1;
   sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
   n_seq           = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
+  n_seq_total     = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq_total;
+  w               = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   se              = fc->strand_end;
   my_iindx        = (sliding_window) ? NULL : fc->iindx;
   jindx           = (sliding_window) ? NULL : fc->jindx;
@@ -281,7 +284,7 @@ exp_E_mb_loop_fast(vrna_fold_compound_t       *fc,
 
   /* multiple stem loop contribution */
   if (evaluate(i, j, i + 1, j - 1, VRNA_DECOMP_PAIR_ML, &hc_dat_local)) {
-    qqqmmm = pow(expMLclosing, (double)n_seq) *
+    qqqmmm = pow(expMLclosing, (double)n_seq_total) *
              scale[2];
 
     switch (fc->type) {
@@ -297,7 +300,7 @@ exp_E_mb_loop_fast(vrna_fold_compound_t       *fc,
       case VRNA_FC_TYPE_COMPARATIVE:
         for (s = 0; s < n_seq; s++) {
           tt      = vrna_get_ptype_md(SS[s][j], SS[s][i], md);
-          qqqmmm  *= exp_E_MLstem(tt, S5[s][j], S3[s][i], pf_params);
+          qqqmmm  *= exp_weighted(exp_E_MLstem(tt, S5[s][j], S3[s][i], pf_params), w[s]);
         }
         break;
     }
@@ -386,7 +389,7 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
 {
   unsigned char             sliding_window;
   short                     *S1, *S2, **SS, **S5, **S3;
-  unsigned int              *sn, *ss, *se, n_seq, s;
+  unsigned int              *sn, *ss, *se, n_seq, n_seq_total, *w, s;
   int                       n, *iidx, k, ij, kl, maxk, ii, with_ud, u, circular, with_gquad,
                             *hc_up_ml, type;
   FLT_OR_DBL                qbt1, temp, *qm, *qb, *qqm, *qqm1, **qqmu, q_temp, q_temp2, *G,
@@ -405,6 +408,8 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
   ss              = fc->strand_start;
   se              = fc->strand_end;
   n_seq           = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
+  n_seq_total     = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq_total;
+  w               = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   SS              = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S;
   S5              = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S5;
   S3              = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S3;
@@ -495,10 +500,10 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
         q_temp = 1.;
         for (s = 0; s < n_seq; s++) {
           type    = vrna_get_ptype_md(SS[s][i], SS[s][j], md);
-          q_temp  *= exp_E_MLstem(type,
-                                  ((i > 1) || circular) ? S5[s][i] : -1,
-                                  ((j < n) || circular) ? S3[s][j] : -1,
-                                  pf_params);
+          q_temp  *= exp_weighted(exp_E_MLstem(type,
+                                               ((i > 1) || circular) ? S5[s][i] : -1,
+                                               ((j < n) || circular) ? S3[s][j] : -1,
+                                               pf_params), w[s]);
         }
         qbt1 *= q_temp;
         break;
@@ -513,7 +518,7 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
   if (with_gquad) {
     q_temp  = (sliding_window) ? G_local[i][j] : G[ij];
     qqm[i]  += q_temp *
-               pow(exp_E_MLstem(0, -1, -1, pf_params), (double)n_seq);
+               pow(exp_E_MLstem(0, -1, -1, pf_params), (double)n_seq_total);
   }
 
   if (with_ud)
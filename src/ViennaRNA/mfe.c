@@ -35,7 +35,9 @@
 #include "ViennaRNA/unstructured_domains.h"
 #include "ViennaRNA/loops/all.h"
 #include "ViennaRNA/alphabet.h"
+#include "ViennaRNA/sequence.h"
 #include "ViennaRNA/mfe.h"
+#include "ViennaRNA/utils/timing_hooks.h"
 
 #ifdef __GNUC__
 # define INLINE inline
@@ -43,6 +45,8 @@
 # define INLINE
 #endif
 
+#include "ViennaRNA/sequence_weights.inc"
+
 #define MAXSECTORS        500     /* dimension for a backtrack array */
 
 struct aux_arrays {
@@ -77,6 +81,23 @@ PRIVATE int
 fill_arrays(vrna_fold_compound_t *fc);
 
 
+PRIVATE int
+fill_arrays_mutated(vrna_fold_compound_t  *fc,
+                    const unsigned int    *mutations);
+
+
+PRIVATE int
+mutations_supported(vrna_fold_compound_t *fc);
+
+
+PRIVATE float
+finalize_mfe(vrna_fold_compound_t *fc,
+             int                  energy,
+             char                 *structure,
+             sect                 bt_stack[],
+             int                  s);
+
+
 PRIVATE int
 postprocess_circular(vrna_fold_compound_t *fc,
                      sect                 bt_stack[],
@@ -129,18 +150,14 @@ PUBLIC float
 vrna_mfe(vrna_fold_compound_t *fc,
          char                 *structure)
 {
-  char            *ss;
-  int             length, energy, s;
-  float           mfe;
-  sect            bt_stack[MAXSECTORS]; /* stack of partial structures for backtracking */
-  vrna_bp_stack_t *bp;
+  int   energy, s;
+  float mfe;
+  sect  bt_stack[MAXSECTORS]; /* stack of partial structures for backtracking */
 
   s   = 0;
   mfe = (float)(INF / 100.);
 
   if (fc) {
-    length = (int)fc->length;
-
     if (!vrna_fold_compound_prepare(fc, VRNA_OPTION_MFE)) {
       vrna_message_warning("vrna_mfe@mfe.c: Failed to prepare vrna_fold_compound");
       return mfe;
@@ -154,51 +171,63 @@ vrna_mfe(vrna_fold_compound_t *fc,
     if ((fc->aux_grammar) && (fc->aux_grammar->cb_proc))
       fc->aux_grammar->cb_proc(fc, VRNA_STATUS_MFE_PRE, fc->aux_grammar->data);
 
+    VRNA_TIMING_START(fc, VRNA_TIMING_MFE_FILL);
+
     energy = fill_arrays(fc);
 
     if (fc->params->model_details.circ)
       energy = postprocess_circular(fc, bt_stack, &s);
 
-    if (structure && fc->params->model_details.backtrack) {
-      /* add a guess of how many G's may be involved in a G quadruplex */
-      bp = (vrna_bp_stack_t *)vrna_alloc(sizeof(vrna_bp_stack_t) * (4 * (1 + length / 2)));
+    VRNA_TIMING_STOP(fc, VRNA_TIMING_MFE_FILL);
+    VRNA_TIMING_CELLS(fc,
+                      VRNA_TIMING_MFE_FILL,
+                      vrna_timing_cells_triangle((int)fc->length,
+                                                 fc->params->model_details.min_loop_size,
+                                                 (int)fc->length));
+
+    mfe = finalize_mfe(fc, energy, structure, bt_stack, s);
+  }
+
+  return mfe;
+}
 
-      if (backtrack(fc, bp, bt_stack, s) != 0) {
-        ss = vrna_db_from_bp_stack(bp, length);
-        strncpy(structure, ss, length + 1);
-        free(ss);
-      } else {
-        memset(structure, '\0', sizeof(char) * (length + 1));
-      }
 
-      free(bp);
+PUBLIC float
+vrna_mfe_mutate(vrna_fold_compound_t  *fc,
+                const char            *sequence,
+                char                  *structure)
+{
+  unsigned int  *mutations;
+  int           energy;
+  float         mfe;
+  sect          bt_stack[MAXSECTORS]; /* stack of partial structures for backtracking */
+
+  mfe = (float)(INF / 100.);
+
+  if ((fc) && (sequence)) {
+    if (vrna_sequence_mutate(fc, sequence, &mutations) < 0) {
+      vrna_message_warning("vrna_mfe_mutate@mfe.c: Failed to apply mutations");
+      return mfe;
+    }
+
+    if (!mutations_supported(fc)) {
+      free(mutations);
+      return vrna_mfe(fc, structure);
     }
 
     /* call user-defined recursion status callback function */
     if (fc->stat_cb)
-      fc->stat_cb(VRNA_STATUS_MFE_POST, fc->auxdata);
+      fc->stat_cb(VRNA_STATUS_MFE_PRE, fc->auxdata);
 
-    /* call user-defined grammar post-condition callback function */
-    if ((fc->aux_grammar) && (fc->aux_grammar->cb_proc))
-      fc->aux_grammar->cb_proc(fc, VRNA_STATUS_MFE_POST, fc->aux_grammar->data);
+    VRNA_TIMING_START(fc, VRNA_TIMING_MFE_FILL);
 
-    switch (fc->params->model_details.backtrack_type) {
-      case 'C':
-        mfe = (float)fc->matrices->c[fc->jindx[length] + 1] / 100.;
-        break;
+    energy = fill_arrays_mutated(fc, mutations);
 
-      case 'M':
-        mfe = (float)fc->matrices->fML[fc->jindx[length] + 1] / 100.;
-        break;
+    VRNA_TIMING_STOP(fc, VRNA_TIMING_MFE_FILL);
 
-      default:
-        if (fc->type == VRNA_FC_TYPE_COMPARATIVE)
-          mfe = (float)energy / (100. * (float)fc->n_seq);
-        else
-          mfe = (float)energy / 100.;
+    mfe = finalize_mfe(fc, energy, structure, bt_stack, 0);
 
-        break;
-    }
+    free(mutations);
   }
 
   return mfe;
@@ -303,6 +332,208 @@ fill_arrays(vrna_fold_compound_t *fc)
 }
 
 
+/*
+ *  re-fill DP matrices after point mutations
+ *
+ *  Assuming that the matrices are filled for the previous sequence,
+ *  only those entries that depend on any of the mutated nucleotides
+ *  are re-computed. Since fML[i,j] and fM1[i,j] may depend on the
+ *  nucleotides i - 1 and j + 1 (dangles), and the multibranch loop
+ *  closing in row i uses the auxiliary arrays of rows i + 1 and i + 2,
+ *  we re-compute fML and fM1 for all j >= m - 2 in each row i <= m + 2,
+ *  where m is the first mutated position downstream of i - 2. Pairs (i,j)
+ *  on the other hand, only need an update if the mutation is located
+ *  within [i, j].
+ */
+PRIVATE int
+fill_arrays_mutated(vrna_fold_compound_t  *fc,
+                    const unsigned int    *mutations)
+{
+  int               i, j, ij, m, length, turn, uniq_ML, i_max, j_min, j_c, *indx,
+                    *f5, *c, *fML, *fM1, *next;
+  vrna_mx_mfe_t     *matrices;
+  struct aux_arrays *helper_arrays;
+
+  length    = (int)fc->length;
+  indx      = fc->jindx;
+  uniq_ML   = fc->params->model_details.uniq_ML;
+  turn      = fc->params->model_details.min_loop_size;
+  matrices  = fc->matrices;
+  f5        = matrices->f5;
+  c         = matrices->c;
+  fML       = matrices->fML;
+  fM1       = matrices->fM1;
+
+  if ((turn < 0) || (turn > length))
+    turn = length;
+
+  if (length <= turn)
+    return 0;
+
+  /* next[p] holds the first mutated position >= p, m the last one */
+  next = (int *)vrna_alloc(sizeof(int) * (length + 2));
+
+  for (i = 0; i <= length + 1; i++)
+    next[i] = -1;
+
+  for (m = 0, i = 0; mutations[i]; i++) {
+    next[mutations[i]]  = mutations[i];
+    m                   = MAX2(m, (int)mutations[i]);
+  }
+
+  /*
+   *  multibranch stems with dangles on both sides use the nucleotides at the
+   *  opposite sequence end for i = 1 and j = n, so mutations at the first and
+   *  last position virtually also affect positions n + 1 and 0
+   */
+  if (next[1] == 1)
+    next[length + 1] = m = length + 1;
+
+  if (next[length] == length)
+    next[0] = 0;
+
+  if (next[length + 1] == -1)
+    next[length + 1] = length + 1;
+
+  for (i = length; i >= 0; i--)
+    if (next[i] == -1)
+      next[i] = next[i + 1];
+
+  if (m > 0) {
+    helper_arrays = get_aux_arrays(length);
+
+    i_max = MIN2(m + 2, length - turn - 1);
+
+    for (i = i_max; i >= 1; i--) {
+      j_min = next[(i > 2) ? i - 2 : 0] - 2;
+      j_min = MAX2(j_min, i + turn + 1);
+      j_c   = next[i];
+
+      /* unaffected part of row i */
+      for (j = i + turn + 1; j < j_min; j++)
+        helper_arrays->Fmi[j] = fML[indx[j] + i];
+
+      for (j = j_min; j <= length; j++) {
+        ij = indx[j] + i;
+
+        if (j >= j_c)
+          c[ij] = decompose_pair(fc, i, j, helper_arrays);
+
+        fML[ij] = vrna_E_ml_stems_fast(fc, i, j, helper_arrays->Fmi, helper_arrays->DMLi);
+
+        if (uniq_ML)
+          fM1[ij] = E_ml_rightmost_stem(i, j, fc);
+      }
+
+      rotate_aux_arrays(helper_arrays, length);
+    }
+
+    free_aux_arrays(helper_arrays);
+  }
+
+  free(next);
+
+  /* calculate energies of 5' fragments */
+  (void)vrna_E_ext_loop_5(fc);
+
+  return f5[length];
+}
+
+
+PRIVATE int
+mutations_supported(vrna_fold_compound_t *fc)
+{
+  vrna_md_t *md = &(fc->params->model_details);
+
+  /*
+   *  the incremental update requires a fully filled set of default MFE
+   *  matrices and a model without long-range dependencies beyond the
+   *  ones handled in fill_arrays_mutated()
+   */
+  if ((fc->type != VRNA_FC_TYPE_SINGLE) ||
+      (fc->strands != 1) ||
+      (!fc->matrices) ||
+      (fc->matrices->type != VRNA_MX_DEFAULT) ||
+      (!fc->matrices->c) ||
+      (!fc->matrices->fML) ||
+      (md->uniq_ML && (!fc->matrices->fM1)) ||
+      (fc->hc->type != VRNA_HC_DEFAULT) ||
+      (fc->hc->f) ||
+      (fc->domains_up) ||
+      (fc->aux_grammar) ||
+      (md->circ) ||
+      (md->gquad) ||
+      (md->noLP))
+    return 0;
+
+  return 1;
+}
+
+
+/* backtrack (if requested) and convert the final energy */
+PRIVATE float
+finalize_mfe(vrna_fold_compound_t *fc,
+             int                  energy,
+             char                 *structure,
+             sect                 bt_stack[],
+             int                  s)
+{
+  char            *ss;
+  int             length;
+  float           mfe;
+  vrna_bp_stack_t *bp;
+
+  length = (int)fc->length;
+
+  if (structure && fc->params->model_details.backtrack) {
+    VRNA_TIMING_START(fc, VRNA_TIMING_MFE_BACKTRACK);
+
+    /* add a guess of how many G's may be involved in a G quadruplex */
+    bp = (vrna_bp_stack_t *)vrna_alloc(sizeof(vrna_bp_stack_t) * (4 * (1 + length / 2)));
+
+    if (backtrack(fc, bp, bt_stack, s) != 0) {
+      ss = vrna_db_from_bp_stack(bp, length);
+      strncpy(structure, ss, length + 1);
+      free(ss);
+    } else {
+      memset(structure, '\0', sizeof(char) * (length + 1));
+    }
+
+    free(bp);
+
+    VRNA_TIMING_STOP(fc, VRNA_TIMING_MFE_BACKTRACK);
+  }
+
+  /* call user-defined recursion status callback function */
+  if (fc->stat_cb)
+    fc->stat_cb(VRNA_STATUS_MFE_POST, fc->auxdata);
+
+  /* call user-defined grammar post-condition callback function */
+  if ((fc->aux_grammar) && (fc->aux_grammar->cb_proc))
+    fc->aux_grammar->cb_proc(fc, VRNA_STATUS_MFE_POST, fc->aux_grammar->data);
+
+  switch (fc->params->model_details.backtrack_type) {
+    case 'C':
+      mfe = (float)fc->matrices->c[fc->jindx[length] + 1] / 100.;
+      break;
+
+    case 'M':
+      mfe = (float)fc->matrices->fML[fc->jindx[length] + 1] / 100.;
+      break;
+
+    default:
+      if (fc->type == VRNA_FC_TYPE_COMPARATIVE)
+        mfe = (float)energy / (100. * (float)fc->n_seq_total);
+      else
+        mfe = (float)energy / 100.;
+
+      break;
+  }
+
+  return mfe;
+}
+
+
 /* post-processing step for circular RNAs */
 PRIVATE int
 postprocess_circular(vrna_fold_compound_t *fc,
@@ -325,7 +556,8 @@ postprocess_circular(vrna_fold_compound_t *fc,
   int           Hi, Hj, Ii, Ij, Ip, Iq, ip, iq, Mi, *fM_d3, *fM_d5, Md3i,
                 Md5i, FcMd3, FcMd5, FcH, FcI, FcM, Fc, *fM2, i, j, ij, u,
                 length, new_c, fm, type, *my_c, *my_fML, *indx, FcO, tmp,
-                dangle_model, turn, s, n_seq;
+                dangle_model, turn, s, n_seq, n_seq_total;
+  unsigned int  *w;
   vrna_param_t  *P;
   vrna_md_t     *md;
   vrna_hc_t     *hc;
@@ -333,6 +565,8 @@ postprocess_circular(vrna_fold_compound_t *fc,
 
   length            = fc->length;
   n_seq             = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
+  n_seq_total       = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq_total;
+  w                 = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->seq_weights;
   P                 = fc->params;
   md                = &(P->model_details);
   ptype             = (fc->type == VRNA_FC_TYPE_SINGLE) ? fc->ptype : NULL;
@@ -582,7 +816,7 @@ postprocess_circular(vrna_fold_compound_t *fc,
         break;
 
       case VRNA_FC_TYPE_COMPARATIVE:
-        FcM += n_seq * P->MLclosing;
+        FcM += n_seq_total * P->MLclosing;
         break;
     }
   }
@@ -671,10 +905,10 @@ postprocess_circular(vrna_fold_compound_t *fc,
                 break;
 
               case VRNA_FC_TYPE_COMPARATIVE:
-                tmp = P->MLclosing * n_seq;
+                tmp = P->MLclosing * n_seq_total;
                 for (s = 0; s < n_seq; s++) {
                   type  = vrna_get_ptype_md(SS[s][i + 1], SS[s][length], md);
-                  tmp   += E_MLstem(type, -1, S3[s][length], P);
+                  tmp   += E_WEIGHTED(E_MLstem(type, -1, S3[s][length], P), w[s]);
                 }
                 break;
             }
@@ -772,10 +1006,10 @@ postprocess_circular(vrna_fold_compound_t *fc,
                 break;
 
               case VRNA_FC_TYPE_COMPARATIVE:
-                tmp = P->MLclosing * n_seq;
+                tmp = P->MLclosing * n_seq_total;
                 for (s = 0; s < n_seq; s++) {
                   type  = vrna_get_ptype_md(SS[s][i + 1], SS[s][length], md);
-                  tmp   += E_MLstem(type, S5[s][i + 1], S3[s][length], P);
+                  tmp   += E_WEIGHTED(E_MLstem(type, S5[s][i + 1], S3[s][length], P), w[s]);
                 }
                 break;
             }
@@ -861,10 +1095,10 @@ postprocess_circular(vrna_fold_compound_t *fc,
                 break;
 
               case VRNA_FC_TYPE_COMPARATIVE:
-                tmp = P->MLclosing * n_seq;
+                tmp = P->MLclosing * n_seq_total;
                 for (s = 0; s < n_seq; s++) {
                   type  = vrna_get_ptype_md(SS[s][1], SS[s][i], md);
-                  tmp   += E_MLstem(type, S5[s][1], -1, P);
+                  tmp   += E_WEIGHTED(E_MLstem(type, S5[s][1], -1, P), w[s]);
                 }
                 break;
             }
@@ -960,10 +1194,10 @@ postprocess_circular(vrna_fold_compound_t *fc,
                 break;
 
               case VRNA_FC_TYPE_COMPARATIVE:
-                tmp = P->MLclosing * n_seq;
+                tmp = P->MLclosing * n_seq_total;
                 for (s = 0; s < n_seq; s++) {
                   type  = vrna_get_ptype_md(SS[s][1], SS[s][i], md);
-                  tmp   += E_MLstem(type, S5[s][1], S3[s][i], P);
+                  tmp   += E_WEIGHTED(E_MLstem(type, S5[s][1], S3[s][i], P), w[s]);
                 }
                 break;
             }
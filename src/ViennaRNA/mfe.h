@@ -84,6 +84,36 @@ vrna_mfe(vrna_fold_compound_t *vc,
          char                 *structure);
 
 
+/**
+ *  @brief Re-compute the MFE after point mutations of the sequence
+ *
+ *  Replaces the sequence of the fold compound by @p sequence (see vrna_sequence_mutate())
+ *  and updates the MFE dynamic programming matrices. Only matrix entries that depend
+ *  on any of the mutated nucleotides are re-computed, which is much faster than a
+ *  full re-computation if only few positions changed, e.g. in the adaptive walks
+ *  of sequence design.
+ *
+ *  The matrices of the fold compound must hold the result of a previous call to
+ *  vrna_mfe() or vrna_mfe_mutate(). For model settings that do not allow for an
+ *  incremental update (circular RNAs, G-quadruplexes, lonely pair restrictions,
+ *  unstructured domains, generic hard constraints, etc.) this function falls back
+ *  to vrna_mfe().
+ *
+ *  @see vrna_mfe(), vrna_sequence_mutate()
+ *
+ *  @param vc             fold compound of type #VRNA_FC_TYPE_SINGLE
+ *  @param sequence       The mutated sequence (same length as the current sequence)
+ *  @param structure      A pointer to the character array where the
+ *                        secondary structure in dot-bracket notation will be written to (Maybe NULL)
+ *
+ *  @return the minimum free energy (MFE) in kcal/mol
+ */
+float
+vrna_mfe_mutate(vrna_fold_compound_t  *vc,
+                const char            *sequence,
+                char                  *structure);
+
+
 /**
  *  @brief Compute the minimum free energy of two interacting RNA molecules
  *
@@ -237,6 +267,32 @@ vrna_cofold(const char  *sequence,
             char        *structure);
 
 
+/**
+ *  @brief Compute Minimum Free Energy (MFE), and a corresponding secondary structure for each sequence of a list
+ *
+ *  This simplified interface to vrna_mfe() predicts the MFE of each sequence in the @p NULL terminated
+ *  list @p sequences, using the same model details @p md_p for all of them. The sequences are distributed
+ *  over @p num_threads parallel threads, using OpenMP if the library has been compiled with OpenMP support,
+ *  and POSIX threads otherwise. A value of @p num_threads <= 0 uses the default number of threads, i.e. the
+ *  number of available processor cores. As for vrna_fold(), memory required for the
+ *  dynamic programming (DP) matrices is allocated and free'd on-the-fly.
+ *
+ *  @see vrna_fold(), vrna_mfe()
+ *
+ *  @param sequences    A @p NULL terminated list of RNA sequences
+ *  @param md_p         The model details to use for all sequences (may be @p NULL for default settings)
+ *  @param structures   An array with one entry per sequence, where the newly allocated MFE structures
+ *                      in dot-bracket notation will be stored (may be @p NULL to skip backtracking)
+ *  @param num_threads  The number of parallel threads to use
+ *  @return             The minimum free energies (MFE) in kcal/mol, one for each sequence
+ */
+float *
+vrna_fold_batch(const char  **sequences,
+                vrna_md_t   *md_p,
+                char        **structures,
+                int         num_threads);
+
+
 /* End simplified global MFE interface */
 /**@}*/
 
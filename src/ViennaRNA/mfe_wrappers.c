@@ -9,6 +9,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#elif VRNA_WITH_PTHREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
 
 #include "ViennaRNA/fold_compound.h"
 #include "ViennaRNA/model.h"
@@ -16,6 +24,32 @@
 #include "ViennaRNA/mfe.h"
 
 
+typedef struct {
+  const char  **sequences;
+  vrna_md_t   *md;
+  char        **structures;
+  float       *mfes;
+  int         n;
+  int         next;
+#if !defined(_OPENMP) && VRNA_WITH_PTHREADS
+  pthread_mutex_t mtx;
+#endif
+} fold_batch_t;
+
+
+PRIVATE void
+fold_batch_sequence(fold_batch_t  *batch,
+                    int           i);
+
+
+#if !defined(_OPENMP) && VRNA_WITH_PTHREADS
+PRIVATE void *
+fold_batch_worker(void *arg);
+
+
+#endif
+
+
 /* wrappers for single sequences */
 PUBLIC float
 vrna_fold(const char  *string,
@@ -54,6 +88,81 @@ vrna_circfold(const char  *string,
 }
 
 
+PUBLIC float *
+vrna_fold_batch(const char  **sequences,
+                vrna_md_t   *md_p,
+                char        **structures,
+                int         num_threads)
+{
+  int           i, n;
+  float         *mfes;
+  vrna_md_t     md;
+  fold_batch_t  batch;
+
+  if (!sequences)
+    return NULL;
+
+  for (n = 0; sequences[n]; n++) ;
+
+  if (md_p)
+    vrna_md_copy(&md, md_p);
+  else
+    vrna_md_set_default(&md);
+
+  mfes = (float *)vrna_alloc(sizeof(float) * (n + 1));
+
+  batch.sequences   = sequences;
+  batch.md          = &md;
+  batch.structures  = structures;
+  batch.mfes        = mfes;
+  batch.n           = n;
+  batch.next        = 0;
+
+#ifdef _OPENMP
+  if (num_threads <= 0)
+    num_threads = omp_get_max_threads();
+
+#pragma omp parallel for schedule(dynamic) private(i) num_threads(num_threads)
+  for (i = 0; i < n; i++)
+    fold_batch_sequence(&batch, i);
+
+#elif VRNA_WITH_PTHREADS
+  int       t, started;
+  pthread_t *threads;
+
+  if (num_threads <= 0) {
+    long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = (num_cores > 0) ? (int)num_cores : 1;
+  }
+
+  if (num_threads > n)
+    num_threads = n;
+
+  pthread_mutex_init(&batch.mtx, NULL);
+  threads = (pthread_t *)vrna_alloc(sizeof(pthread_t) * ((num_threads > 0) ? num_threads : 1));
+
+  for (started = 0, t = 1; t < num_threads; t++)
+    if (pthread_create(&(threads[started]), NULL, &fold_batch_worker, (void *)&batch) == 0)
+      started++;
+
+  /* the calling thread takes part in the work as well */
+  fold_batch_worker((void *)&batch);
+
+  for (t = 0; t < started; t++)
+    pthread_join(threads[t], NULL);
+
+  pthread_mutex_destroy(&batch.mtx);
+  free(threads);
+#else
+  for (i = 0; i < n; i++)
+    fold_batch_sequence(&batch, i);
+
+#endif
+
+  return mfes;
+}
+
+
 /* wrappers for multiple sequence alignments */
 
 PUBLIC float
@@ -116,3 +225,57 @@ vrna_cofold(const char  *seq,
 
   return mfe;
 }
+
+
+/*
+ #####################################
+ # BEGIN OF STATIC HELPER FUNCTIONS  #
+ #####################################
+ */
+PRIVATE void
+fold_batch_sequence(fold_batch_t  *batch,
+                    int           i)
+{
+  char                  *structure;
+  vrna_fold_compound_t  *vc;
+
+  structure = NULL;
+  if (batch->structures)
+    structure = (char *)vrna_alloc(sizeof(char) * (strlen(batch->sequences[i]) + 1));
+
+  vc = vrna_fold_compound(batch->sequences[i], batch->md, VRNA_OPTION_DEFAULT);
+  if (vc) {
+    batch->mfes[i] = vrna_mfe(vc, structure);
+    vrna_fold_compound_free(vc);
+  } else {
+    batch->mfes[i] = (float)INF / 100.;
+  }
+
+  if (batch->structures)
+    batch->structures[i] = structure;
+}
+
+
+#if !defined(_OPENMP) && VRNA_WITH_PTHREADS
+PRIVATE void *
+fold_batch_worker(void *arg)
+{
+  int           i;
+  fold_batch_t  *batch = (fold_batch_t *)arg;
+
+  while (1) {
+    pthread_mutex_lock(&batch->mtx);
+    i = batch->next++;
+    pthread_mutex_unlock(&batch->mtx);
+
+    if (i >= batch->n)
+      break;
+
+    fold_batch_sequence(batch, i);
+  }
+
+  return NULL;
+}
+
+
+#endif
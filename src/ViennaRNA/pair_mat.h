@@ -16,8 +16,15 @@
 # endif
 #endif
 
-static const char Law_and_Order[]         = "_ACGUTXKI";
-static int        BP_pair[NBASES][NBASES] =
+/* thread-local storage for builds that use POSIX threads but not OpenMP */
+#if !defined(_OPENMP) && VRNA_WITH_PTHREADS && defined(__GNUC__)
+# define PAIR_MAT_THREAD_LOCAL __thread
+#else
+# define PAIR_MAT_THREAD_LOCAL
+#endif
+
+static const char                       Law_and_Order[]         = "_ACGUTXKI";
+static PAIR_MAT_THREAD_LOCAL int        BP_pair[NBASES][NBASES] =
   /* _  A  C  G  U  X  K  I */
 { { 0, 0, 0, 0, 0, 0, 0, 0 },
   { 0, 0, 0, 0, 5, 0, 0, 5 },
@@ -30,10 +37,10 @@ static int        BP_pair[NBASES][NBASES] =
 
 #define MAXALPHA 20       /* maximal length of alphabet */
 
-static short  alias[MAXALPHA + 1];
-static int    pair[MAXALPHA + 1][MAXALPHA + 1];
+static PAIR_MAT_THREAD_LOCAL short  alias[MAXALPHA + 1];
+static PAIR_MAT_THREAD_LOCAL int    pair[MAXALPHA + 1][MAXALPHA + 1];
 /* rtype[pair[i][j]]:=pair[j][i] */
-static int    rtype[8] = {
+static PAIR_MAT_THREAD_LOCAL int    rtype[8] = {
   0, 2, 1, 4, 3, 6, 5, 7
 };
 
@@ -18,6 +18,7 @@
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/params/io.h"
 #include "ViennaRNA/params/basic.h"
+#include "ViennaRNA/utils/timing_hooks.h"
 
 /**
  *** \file ViennaRNA/params/basic.c
@@ -241,7 +242,7 @@ vrna_exp_params_subst(vrna_fold_compound_t  *vc,
           break;
 
         case VRNA_FC_TYPE_COMPARATIVE:
-          vc->exp_params = vrna_exp_params_comparative(vc->n_seq, NULL);
+          vc->exp_params = vrna_exp_params_comparative(vc->n_seq_total, NULL);
           break;
 
         default:
@@ -264,13 +265,15 @@ vrna_exp_params_rescale(vrna_fold_compound_t  *vc,
   vrna_md_t         *md;
 
   if (vc) {
+    VRNA_TIMING_START(vc, VRNA_TIMING_PARAMS);
+
     if (!vc->exp_params) {
       switch (vc->type) {
         case VRNA_FC_TYPE_SINGLE:
           vc->exp_params = vrna_exp_params(&(vc->params->model_details));
           break;
         case VRNA_FC_TYPE_COMPARATIVE:
-          vc->exp_params = vrna_exp_params_comparative(vc->n_seq, &(vc->params->model_details));
+          vc->exp_params = vrna_exp_params_comparative(vc->n_seq_total, &(vc->params->model_details));
           break;
       }
     } else if (memcmp(&(vc->params->model_details),
@@ -287,7 +290,7 @@ vrna_exp_params_rescale(vrna_fold_compound_t  *vc,
       md  = &(pf->model_details);
 
       if (vc->type == VRNA_FC_TYPE_COMPARATIVE)
-        kT /= vc->n_seq;
+        kT /= vc->n_seq_total;
 
       /* re-compute scaling factor if necessary */
       if ((mfe) || (pf->pf_scale < 1.)) {
@@ -305,6 +308,8 @@ vrna_exp_params_rescale(vrna_fold_compound_t  *vc,
 
       rescale_params(vc);
     }
+
+    VRNA_TIMING_STOP(vc, VRNA_TIMING_PARAMS);
   }
 }
 
@@ -323,6 +328,8 @@ vrna_params_prepare(vrna_fold_compound_t  *fc,
      */
     md_p = &(fc->params->model_details);
 
+    VRNA_TIMING_START(fc, VRNA_TIMING_PARAMS);
+
     if (options & VRNA_OPTION_PF) {
       /* remove previous parameters if present and they differ from reference model */
       if (fc->exp_params) {
@@ -335,8 +342,10 @@ vrna_params_prepare(vrna_fold_compound_t  *fc,
       if (!fc->exp_params)
         fc->exp_params = (fc->type == VRNA_FC_TYPE_SINGLE) ? \
                          vrna_exp_params(md_p) : \
-                         vrna_exp_params_comparative(fc->n_seq, md_p);
+                         vrna_exp_params_comparative(fc->n_seq_total, md_p);
     }
+
+    VRNA_TIMING_STOP(fc, VRNA_TIMING_PARAMS);
   }
 }
 
@@ -25,9 +25,12 @@
 #include "ViennaRNA/constraints/soft.h"
 #include "ViennaRNA/mfe.h"
 #include "ViennaRNA/part_func.h"
+#include "ViennaRNA/utils/timing_hooks.h"
 
 #ifdef _OPENMP
 #include <omp.h>
+#elif VRNA_WITH_PTHREADS
+#include <pthread.h>
 #endif
 
 /*
@@ -42,6 +45,11 @@
  #################################
  */
 
+#if !defined(_OPENMP) && VRNA_WITH_PTHREADS && !defined(VRNA_DISABLE_BACKWARD_COMPATIBILITY)
+/* concurrent calls of vrna_pf() update the global pr */
+PRIVATE pthread_mutex_t pr_mtx = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 /*
  #################################
  # PRIVATE FUNCTION DECLARATIONS #
@@ -111,7 +119,10 @@ vrna_pf(vrna_fold_compound_t  *fc,
     if ((fc->aux_grammar) && (fc->aux_grammar->cb_proc))
       fc->aux_grammar->cb_proc(fc, VRNA_STATUS_PF_PRE, fc->aux_grammar->data);
 
+    VRNA_TIMING_START(fc, VRNA_TIMING_PF_FILL);
+
     if (!fill_arrays(fc)) {
+      VRNA_TIMING_STOP(fc, VRNA_TIMING_PF_FILL);
 #ifdef SUN4
       standard_arithmetic();
 #elif defined(HP9)
@@ -124,6 +135,11 @@ vrna_pf(vrna_fold_compound_t  *fc,
       /* do post processing step for circular RNAs */
       postprocess_circular(fc);
 
+    VRNA_TIMING_STOP(fc, VRNA_TIMING_PF_FILL);
+    VRNA_TIMING_CELLS(fc,
+                      VRNA_TIMING_PF_FILL,
+                      vrna_timing_cells_triangle(n, md->min_loop_size, n));
+
     /* calculate base pairing probability matrix (bppm)  */
     if (md->compute_bpp) {
       vrna_pairing_probs(fc, structure);
@@ -135,7 +151,16 @@ vrna_pf(vrna_fold_compound_t  *fc,
        *  This block may be removed if deprecated functions
        *  relying on the global variable "pr" vanish from within the package!
        */
+#ifdef _OPENMP
+#pragma omp atomic write
+      pr = matrices->probs;
+#elif VRNA_WITH_PTHREADS
+      pthread_mutex_lock(&pr_mtx);
       pr = matrices->probs;
+      pthread_mutex_unlock(&pr_mtx);
+#else
+      pr = matrices->probs;
+#endif
 
 #endif
     }
@@ -171,7 +196,7 @@ vrna_pf(vrna_fold_compound_t  *fc,
                   1000.0;
 
     if (fc->type == VRNA_FC_TYPE_COMPARATIVE)
-      free_energy /= fc->n_seq;
+      free_energy /= fc->n_seq_total;
 
 #ifdef SUN4
     standard_arithmetic();
@@ -735,7 +760,7 @@ postprocess_circular(vrna_fold_compound_t *fc)
                       qm2[k + 1];
         }
 
-        qbt1 *= pow(expMLclosing, fc->n_seq);
+        qbt1 *= pow(expMLclosing, fc->n_seq_total);
         break;
     }
   } else {
@@ -773,7 +798,7 @@ postprocess_circular(vrna_fold_compound_t *fc)
                     qm2[k + 1];
         }
 
-        qbt1 *= pow(expMLclosing, fc->n_seq);
+        qbt1 *= pow(expMLclosing, fc->n_seq_total);
         break;
     }
   }
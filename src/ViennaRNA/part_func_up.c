@@ -72,6 +72,9 @@
 #include "ViennaRNA/part_func_up.h"
 #include "ViennaRNA/duplex.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #define CO_TURN 0
 #define ZERO(A) (fabs(A) < DBL_EPSILON)
@@ -79,6 +82,21 @@
 #define ISOLATED  256.0
 /* #define NUMERIC 1 */
 
+/* accessibility profile of a target RNA, see pf_unstru_target() */
+struct pu_target {
+  char              *sequence;
+  int               length;
+  int               w;
+  int               incr3;
+  int               incr5;
+  int               noLP;
+  short             *S;
+  short             *S1;
+  double            **p_c_S;    /* total probability of being unpaired, [i][0..w+incr3+incr5[ */
+  char              *lp_otype;  /* pair types of (i, length - 1) without lonely pairs */
+  vrna_exp_param_t  *exp_params;
+};
+
 /*
  #################################
  # GLOBAL VARIABLES              #
@@ -90,7 +108,7 @@
  # PRIVATE VARIABLES             #
  #################################
  */
-PRIVATE short             *S = NULL, *S1 = NULL, *SS = NULL, *SS2 = NULL;
+PRIVATE short             *S = NULL, *S1 = NULL;
 PRIVATE vrna_exp_param_t  *Pf = NULL;                           /* use this structure for all the exp-arrays*/
 PRIVATE FLT_OR_DBL        *qb = NULL, *qm = NULL, *prpr = NULL; /* add arrays for pf_unpaired()*/
 PRIVATE FLT_OR_DBL        *probs = NULL;
@@ -103,6 +121,13 @@ PRIVATE double            init_temp;      /* temperature in last call to scale_p
 PRIVATE int               *my_iindx = NULL;
 /* make iptypes array for intermolecular constrains (ipidx for indexing)*/
 
+#ifdef _OPENMP
+/* NOTE: all variables are assumed to be uninitialized if they are declared as threadprivate
+ */
+#pragma omp threadprivate(S, S1, Pf, qb, qm, prpr, probs, q1k, qln, qqm2, qq_1m2, qqm, qqm1, \
+  scale, expMLbase, ptype, init_length, init_temp, my_iindx)
+#endif
+
 
 /*
  #################################
@@ -130,20 +155,16 @@ PRIVATE void
 init_pf_two(int length);
 
 
-PRIVATE void
-scale_int(const char  *s,
-          const char  *sl,
-          double      *sc_int);
-
-
-PRIVATE void
-encode_seq(const char *s1,
-           const char *s2);
+PRIVATE double
+scale_int(const char        *s,
+          const char        *sl,
+          vrna_exp_param_t  *P);
 
 
 PRIVATE constrain *
-get_ptypes_up(char        *S,
-              const char  *structure);
+get_ptypes_up(const char  *Seq,
+              const char  *structure,
+              int         noLP);
 
 
 PRIVATE void
@@ -160,16 +181,16 @@ set_encoded_seq(const char  *sequence,
                 short       **S1);
 
 
-PRIVATE void
-get_interact_arrays(unsigned int  n1,
-                    unsigned int  n2,
-                    pu_contrib    *p_c,
-                    pu_contrib    *p_c2,
-                    int           w,
-                    int           incr5,
-                    int           incr3,
-                    double        ***p_c_S,
-                    double        ***p_c2_S);
+PRIVATE char *
+get_ptypes_inter(const pu_target  *target,
+                 const short      *s2,
+                 int              n2);
+
+
+PRIVATE char *
+get_ptypes_inter_constrained(const pu_target  *target,
+                             const char       *s2,
+                             const char       *cstruc);
 
 
 /*
@@ -543,38 +564,117 @@ pf_unstru(char  *sequence,
 }
 
 
-PRIVATE void
-get_interact_arrays(unsigned int  n1,
-                    unsigned int  n2,
-                    pu_contrib    *p_c,
-                    pu_contrib    *p_c2,
-                    int           w,
-                    int           incr5,
-                    int           incr3,
-                    double        ***p_c_S,
-                    double        ***p_c2_S)
+PUBLIC pu_target *
+pf_unstru_target(const char *sequence,
+                 pu_contrib *p_c,
+                 int        w,
+                 int        incr3,
+                 int        incr5)
 {
-  unsigned int  i;
-  int           pc_size, j;
+  int       i, j, k, n, c, pc_size, type, otype, ntype;
+  short     *s;
+  vrna_md_t md;
+  pu_target *target;
 
-  *p_c_S = (double **)vrna_alloc(sizeof(double *) * (n1 + 1));
+  if ((!sequence) || (!p_c))
+    return NULL;
 
-  for (i = 1; i <= n1; i++) {
-    pc_size     = MIN2((w + incr5 + incr3), (int)n1);
-    (*p_c_S)[i] = (double *)vrna_alloc(sizeof(double) * (pc_size + 1));
+  n       = (int)strlen(sequence);
+  pc_size = MIN2((w + incr5 + incr3), n);
+
+  if (p_c->length != n) {
+    vrna_message_warning("pf_unstru_target: "
+                         "accessibility profile does not match the target sequence");
+    return NULL;
+  }
+
+  if (p_c->w < pc_size) {
+    vrna_message_warning("pf_unstru_target: "
+                         "accessibility profile covers unpaired regions up to length %d only, "
+                         "but %d are required",
+                         p_c->w,
+                         pc_size);
+    return NULL;
+  }
+
+  make_pair_matrix();
+  set_model_details(&md);
+
+  target              = (pu_target *)vrna_alloc(sizeof(pu_target));
+  target->sequence    = strdup(sequence);
+  target->length      = n;
+  target->w           = w;
+  target->incr3       = incr3;
+  target->incr5       = incr5;
+  target->noLP        = md.noLP;
+  target->exp_params  = vrna_exp_params(&md);
+
+  set_encoded_seq(sequence, &(target->S), &(target->S1));
+
+  /* total probability of being unpaired, i.e. the sum of all loop contributions */
+  target->p_c_S = (double **)vrna_alloc(sizeof(double *) * (n + 1));
+  for (i = 1; i <= n; i++) {
+    target->p_c_S[i] = (double *)vrna_alloc(sizeof(double) * (pc_size + 1));
     for (j = 0; j < pc_size; j++)
-      (*p_c_S)[i][j] = p_c->H[i][j] + p_c->I[i][j] + p_c->M[i][j] + p_c->E[i][j];
+      target->p_c_S[i][j] = p_c->H[i][j] + p_c->I[i][j] + p_c->M[i][j] + p_c->E[i][j];
   }
 
-  if (p_c2 != NULL) {
-    (*p_c2_S) = (double **)vrna_alloc(sizeof(double *) * (n2 + 1));
-    for (i = 1; i <= n2; i++) {
-      pc_size       = MIN2(w, (int)n2);
-      (*p_c2_S)[i]  = (double *)vrna_alloc(sizeof(double) * (pc_size + 2));
-      for (j = 0; j < pc_size; j++)
-        (*p_c2_S)[i][j] = p_c2->H[i][j] + p_c2->I[i][j] + p_c2->M[i][j] + p_c2->E[i][j];
+  /*
+   *  Pair types of (i, n - 1), i.e. the last pairs of each diagonal that do
+   *  not depend on the query sequence, after the removal of lonely pairs as
+   *  done in get_ptypes_up(). They are required to continue the diagonals
+   *  into the intermolecular region, see get_ptypes_inter()
+   */
+  target->lp_otype  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  s                 = target->S;
+  if (target->noLP) {
+    for (c = n; c < 2 * n - 2; c++) {
+      k     = (c & 1) ? (c - 1) / 2 : (c - 2) / 2;
+      i     = k;
+      j     = c - k;
+      type  = pair[s[i]][s[j]];
+      otype = ntype = 0;
+      for (; j < n - 1; i--, j++) {
+        if (i > 1)
+          ntype = pair[s[i - 1]][s[j + 1]];
+
+        if (!otype && !ntype)
+          type = 0;
+
+        otype = type;
+        type  = ntype;
+      }
+
+      if ((i > 1) && (j < n))
+        ntype = pair[s[i - 1]][s[j + 1]];
+
+      if (!otype && !ntype)
+        type = 0;
+
+      target->lp_otype[i] = (char)type;
     }
   }
+
+  return target;
+}
+
+
+PUBLIC void
+free_pu_target(pu_target *target)
+{
+  int i;
+
+  if (target) {
+    for (i = 1; i <= target->length; i++)
+      free(target->p_c_S[i]);
+    free(target->p_c_S);
+    free(target->lp_otype);
+    free(target->S);
+    free(target->S1);
+    free(target->exp_params);
+    free(target->sequence);
+    free(target);
+  }
 }
 
 
@@ -590,82 +690,71 @@ pf_interact(const char  *s1,
             int         incr3,
             int         incr5)
 {
-  int         i, j, k, l, n1, n2, add_i5, add_i3, pc_size;
-  double      temp, Z, rev_d, E, Z2, **p_c_S, **p_c2_S, int_scale;
-  FLT_OR_DBL  ****qint_4, **qint_ik;
-  /* PRIVATE double **pint; array for pf_up() output */
-  interact    *Int;
-  double      G_min, G_is, Gi_min;
-  int         gi, gj, gk, gl, ci, cj, ck, cl, prev_k, prev_l;
-  FLT_OR_DBL  **int_ik;
-  double      Z_int, temp_int, temppfs;
-  double      const_scale, const_T;
-  constrain   *cc = NULL;                           /* constrains for cofolding */
-  char        *Seq, *i_long, *i_short, *pos = NULL; /* short seq appended to long one */
-
-  /* int ***pu_jl; */ /* positions of interaction in the short RNA */
+  pu_target *target;
+  interact  *Int;
 
-  G_min = G_is = Gi_min = 100.0;
-  gi    = gj = gk = gl = ci = cj = ck = cl = 0;
-
-  n1      = (int)strlen(s1);
-  n2      = (int)strlen(s2);
-  prev_k  = 1;
-  prev_l  = n2;
-
-  i_long  = (char *)vrna_alloc(sizeof(char) * (n1 + 1));
-  i_short = (char *)vrna_alloc(sizeof(char) * (n2 + 1));
-  Seq     = (char *)vrna_alloc(sizeof(char) * (n1 + n2 + 2));
+  if (fold_constrained && cstruc == NULL)
+    vrna_message_error("option -C selected, but no constrained structure given\n");
 
-  strcpy(Seq, s1);
-  strcat(Seq, s2);
+  target = pf_unstru_target(s1, p_c, w, incr3, incr5);
+  if (!target)
+    vrna_message_error("pf_interact: invalid accessibility profile");
 
-  set_encoded_seq(s1, &S, &S1);
-  set_encoded_seq(s2, &SS, &SS2);
+  Int = pf_interact_target(target, s2, p_c2, (fold_constrained) ? cstruc : NULL);
+  if (!Int)
+    vrna_message_error("pf_interact: could not satisfy all constraints");
 
-  cc = get_ptypes_up(Seq, cstruc);
+  free_pu_target(target);
+  free_pf_arrays(); /* for arrays for pf_fold(...) */
 
-  get_interact_arrays(n1, n2, p_c, p_c2, w, incr5, incr3, &p_c_S, &p_c2_S);
+  return Int;
+}
 
-  /*array for pf_up() output */
-  Int     = (interact *)vrna_alloc(sizeof(interact) * 1);
-  Int->Pi = (double *)vrna_alloc(sizeof(double) * (n1 + 2));
-  Int->Gi = (double *)vrna_alloc(sizeof(double) * (n1 + 2));
 
-  /* use a different scaling for pf_interact*/
-  scale_int(s2, s1, &int_scale);
+PUBLIC interact *
+pf_interact_target(const pu_target  *target,
+                   const char       *s2,
+                   pu_contrib       *p_c2,
+                   const char       *cstruc)
+{
+  int               i, j, k, l, n1, n2, w, incr3, incr5, add_i5, add_i3, pc_size, isw;
+  double            temp, Z, rev_d, E, **p_c_S, **p_c2_S, int_scale;
+  FLT_OR_DBL        *qint_4, *qint_ik, *scale;
+  size_t            slot_size;
+  interact          *Int;
+  double            G_min, G_is, Gi_min;
+  int               gi, gj, gk, gl, ci, cj, ck, cl, prev_k, prev_l;
+  double            const_scale, const_T;
+  short             *S1, *SS, *SS2;
+  char              *ptype_int, *i_long, *i_short, *pos = NULL;
+  vrna_exp_param_t  *Pf;
+
+  if ((!target) || (!s2))
+    return NULL;
 
-  /* set the global scale array and the global variable pf_scale to the
-   * values used to scale the interaction, keep their former values !! */
-  temppfs   = pf_scale;
-  pf_scale  = int_scale;
+  G_min = G_is = Gi_min = 100.0;
+  gi    = gj = gk = gl = ci = cj = ck = cl = 0;
 
-  /* in order to scale expLoopEnergy correctly call*/
-  /* we also pass twice the seq-length to avoid bogus access to scale[] array */
-  scale_stru_pf_params((unsigned)2 * n1);
+  n1      = target->length;
+  n2      = (int)strlen(s2);
+  w       = target->w;
+  incr3   = target->incr3;
+  incr5   = target->incr5;
+  S1      = target->S1;
+  Pf      = target->exp_params;
+  p_c_S   = target->p_c_S;
+  prev_k  = 1;
+  prev_l  = n2;
 
-  qint_ik = (FLT_OR_DBL **)vrna_alloc(sizeof(FLT_OR_DBL *) * (n1 + 1));
-  for (i = 1; i <= n1; i++)
-    qint_ik[i] = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n1 + 1));
-  /* int_ik */
-  int_ik = (FLT_OR_DBL **)vrna_alloc(sizeof(FLT_OR_DBL *) * (n1 + 1));
-  for (i = 1; i <= n1; i++)
-    int_ik[i] = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n1 + 1));
-  Z_int = 0.;
-  /*  Gint = ( -log(int_ik[gk][gi])-( ((int) w/2)*log(pf_scale)) )*((Pf->temperature+K0)*GASCONST/1000.0); */
-  const_scale = ((int)w / 2) * log(pf_scale);
-  const_T     = (Pf->kT / 1000.0);
-  encode_seq(s1, s2);
-  /* static  short *S~S1, *S1~SS1, *SS~S2, *SS2; */
-  for (i = 0; i <= n1; i++)
-    Int->Pi[i] = Int->Gi[i] = 0.;
-  E = 0.;
-  Z = 0.;
+  /* the pair matrix is thread-local, see pair_mat.h */
+  make_pair_matrix();
 
-  if (fold_constrained && cstruc != NULL) {
+  if (cstruc != NULL) {
     pos = strchr(cstruc, '|');
     if (pos) {
-      ci = ck = cl = cj = 0;
+      i_long  = (char *)vrna_alloc(sizeof(char) * (n1 + 1));
+      i_short = (char *)vrna_alloc(sizeof(char) * (n2 + 1));
+      ci      = ck = cl = cj = 0;
       /* long seq              & short seq
        * .........||..|||||....&....||||...  w = maximal interaction length
        *         ck       ci       cj  cl    */
@@ -689,79 +778,126 @@ pf_interact(const char  *s1,
       if (pos)
         cj = (int)(pos - i_short) + 1;    /* j */
 
+      free(i_long);
+      free(i_short);
+
       if (ck > 0 && ci > 0 && ci - ck + 1 > w) {
         vrna_message_warning("distance between constrains in longer seq, %d, larger than -w = %d",
                              ci - ck + 1,
                              w);
-        vrna_message_error("pf_interact: could not satisfy all constraints");
+        return NULL;
       }
 
       if (cj > 0 && cl > 0 && cl - cj + 1 > w) {
         vrna_message_warning("distance between constrains in shorter seq, %d, larger than -w = %d",
                              cl - cj + 1,
                              w);
-        vrna_message_error("pf_interact: could not satisfy all constraints");
+        return NULL;
       }
     }
-  } else if (fold_constrained && cstruc == NULL) {
-    vrna_message_error("option -C selected, but no constrained structure given\n");
-  }
 
-  if (fold_constrained)
     pos = strchr(cstruc, '|');
+  }
+
+  set_encoded_seq(s2, &SS, &SS2);
+
+  if (cstruc != NULL)
+    ptype_int = get_ptypes_inter_constrained(target, s2, cstruc);
+  else
+    ptype_int = get_ptypes_inter(target, SS, n2);
+
+  p_c2_S = NULL;
+  if (p_c2 != NULL) {
+    p_c2_S = (double **)vrna_alloc(sizeof(double *) * (n2 + 1));
+    for (i = 1; i <= n2; i++) {
+      pc_size   = MIN2(w, n2);
+      p_c2_S[i] = (double *)vrna_alloc(sizeof(double) * (pc_size + 2));
+      for (j = 0; j < pc_size; j++)
+        p_c2_S[i][j] = p_c2->H[i][j] + p_c2->I[i][j] + p_c2->M[i][j] + p_c2->E[i][j];
+    }
+  }
+
+  /*array for pf_up() output */
+  Int     = (interact *)vrna_alloc(sizeof(interact) * 1);
+  Int->Pi = (double *)vrna_alloc(sizeof(double) * (n1 + 2));
+  Int->Gi = (double *)vrna_alloc(sizeof(double) * (n1 + 2));
+
+  /* use a different scaling for pf_interact */
+  int_scale = scale_int(s2, target->sequence, Pf);
+
+  /* scaling factors for up to 2 * w unpaired nucleotides in the interaction */
+  scale     = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (2 * w + 2));
+  scale[0]  = 1.;
+  scale[1]  = 1. / int_scale;
+  for (i = 2; i <= 2 * w + 1; i++)
+    scale[i] = scale[i / 2] * scale[i - (i / 2)];
+
+  /* qint_ik[k][i - k], for interactions of at most w nucleotides */
+  qint_ik = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n1 + 1) * w);
+
+  /*  Gint = ( -log(int_ik[gk][gi])-( ((int) w/2)*log(pf_scale)) )*((Pf->temperature+K0)*GASCONST/1000.0); */
+  const_scale = ((int)w / 2) * log(int_scale);
+  const_T     = (Pf->kT / 1000.0);
+  for (i = 0; i <= n1; i++)
+    Int->Pi[i] = Int->Gi[i] = 0.;
+  E = 0.;
+  Z = 0.;
 
   /*  qint_4[i][j][k][l] contribution that region (k-i) in seq1 (l=n1)
    *  is paired to region (l-j) in seq 2(l=n2) that is
-   *  a region closed by bp k-l  and bp i-j */
-  qint_4 = (FLT_OR_DBL ****)vrna_alloc(sizeof(FLT_OR_DBL ***) * (n1 + 1));
+   *  a region closed by bp k-l  and bp i-j
+   *
+   *  Only qint_4[i-w...i][][][] is required at any time, so we keep
+   *  w + 1 slots of (n2 + 1) x (w + 1) x (w + 1) entries in a ring buffer */
+  slot_size = (size_t)(n2 + 1) * (w + 1) * (w + 1);
+  qint_4    = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * slot_size * (w + 1));
+
+#define QINT_4(I, J, A, B)  qint_4[(size_t)((I) % (w + 1)) * slot_size + \
+                                   ((size_t)(J) * (w + 1) + (A)) * (w + 1) + (B)]
+#define QINT_IK(K, I)       qint_ik[(size_t)(K) * w + (I) - (K)]
 
   /* qint_4[i][j][k][l] */
   for (i = 1; i <= n1; i++) {
     int end_k;
     end_k = i - w;
-    if (fold_constrained && pos && ci)
+    if (pos && ci)
       end_k = MAX2(i - w, ci - w);
 
     /* '|' constrains for long sequence: index i from 1 to n1 (5' to 3')*/
     /* interaction has to include 3' most '|' constrain, ci */
-    if (fold_constrained && pos && ci && i == 1 && i < ci)
+    if (pos && ci && i == 1 && i < ci)
       i = ci - w + 1 > 1 ? ci - w + 1 : 1;
 
     /* interaction has to include 5' most '|' constrain, ck*/
-    if (fold_constrained && pos && ck && i > ck + w - 1)
+    if (pos && ck && i > ck + w - 1)
       break;
 
-    /* note: qint_4[i] will be freed before we allocate qint_4[i+1] */
-    qint_4[i] = (FLT_OR_DBL ***)vrna_alloc(sizeof(FLT_OR_DBL **) * (n2 + 1));
-    for (j = n2; j > 0; j--) {
-      qint_4[i][j] = (FLT_OR_DBL **)vrna_alloc(sizeof(FLT_OR_DBL *) * (w + 1));
-      for (k = 0; k <= w; k++)
-        qint_4[i][j][k] = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (w + 1));
-    }
+    /* re-use the slot of qint_4[i - w - 1] */
+    memset(&(QINT_4(i, 0, 0, 0)), 0, sizeof(FLT_OR_DBL) * slot_size);
 
     prev_k = 1;
     for (j = n2; j > 0; j--) {
       int type, type2, end_l;
       end_l = j + w;
-      if (fold_constrained && pos && ci)
+      if (pos && ci)
         end_l = MIN2(cj + w, j + w);
 
       /* '|' constrains for short sequence: index j from n2 to 1 (3' to 5')*/
       /* interaction has to include 5' most '|' constrain, cj */
-      if (fold_constrained && pos && cj && j == n2 && j > cj)
+      if (pos && cj && j == n2 && j > cj)
         j = cj + w - 1 > n2 ? n2 : cj + w - 1;
 
       /* interaction has to include 3' most '|' constrain, cl*/
-      if (fold_constrained && pos && cl && j < cl - w + 1)
+      if (pos && cl && j < cl - w + 1)
         break;
 
-      type                = cc->ptype[cc->indx[i] - (n1 + j)];
-      qint_4[i][j][0][0]  = type ? Pf->expDuplexInit : 0;
+      type                = ptype_int[i * (n2 + 1) + j];
+      QINT_4(i, j, 0, 0)  = type ? Pf->expDuplexInit : 0;
 
       if (!type)
         continue;
 
-      qint_4[i][j][0][0] *= exp_E_ExtLoop(type,
+      QINT_4(i, j, 0, 0) *= exp_E_ExtLoop(type,
                                           (i > 1) ? S1[i - 1] : -1,
                                           (j < n2) ? SS2[j + 1] : -1,
                                           Pf);
@@ -784,41 +920,35 @@ pf_interact(const char  *s1,
       /* only one bp (no interior loop) */
       if (p_c2 == NULL) {
         /* consider only structure of longer seq. */
-        qint_ik[i][i] += qint_4[i][j][0][0] * rev_d * p_c_S[add_i5][add_i3] * scale[((int)w / 2)];
-        Z             += qint_4[i][j][0][0] * rev_d * p_c_S[add_i5][add_i3] * scale[((int)w / 2)];
+        QINT_IK(i, i) += QINT_4(i, j, 0, 0) * rev_d * p_c_S[add_i5][add_i3] * scale[((int)w / 2)];
+        Z             += QINT_4(i, j, 0, 0) * rev_d * p_c_S[add_i5][add_i3] * scale[((int)w / 2)];
       } else {
         /* consider structures of both seqs. */
-        qint_ik[i][i] += qint_4[i][j][0][0] * rev_d * p_c_S[add_i5][add_i3] * p_c2_S[j][0] *
+        QINT_IK(i, i) += QINT_4(i, j, 0, 0) * rev_d * p_c_S[add_i5][add_i3] * p_c2_S[j][0] *
                          scale[((int)w / 2)];
-        Z += qint_4[i][j][0][0] * rev_d * p_c_S[add_i5][add_i3] * p_c2_S[j][0] *
+        Z += QINT_4(i, j, 0, 0) * rev_d * p_c_S[add_i5][add_i3] * p_c2_S[j][0] *
              scale[((int)w / 2)];
       }
 
-      /* int_ik */
-      /* check deltaG_ges = deltaG_int + deltaG_unstr; */
-      int_ik[i][i]  += qint_4[i][j][0][0] * rev_d * scale[((int)w / 2)];
-      Z_int         += qint_4[i][j][0][0] * rev_d * scale[((int)w / 2)];
-      temp_int      = 0.;
-
       temp    = 0.;
       prev_l  = n2;
       for (k = i - 1; k > end_k && k > 0; k--) {
-        if (fold_constrained && pos && cstruc[k - 1] == '|' && k > prev_k)
+        if (pos && cstruc[k - 1] == '|' && k > prev_k)
           prev_k = k;
 
         for (l = j + 1; l < end_l && l <= n2; l++) {
-          int     a, b, ia, ib, isw;
+          int     a, b, ia, ib;
           double  scalew, tt, intt;
 
-          type2 = cc->ptype[cc->indx[k] - (n1 + l)];
+          type2 = ptype_int[k * (n2 + 1) + l];
           /* '|' : l HAS TO be paired: not pair (k,x) where x>l allowed */
-          if (fold_constrained && pos && cstruc[n1 + l - 1] == '|' && l < prev_l)
+          if (pos && cstruc[n1 + l - 1] == '|' && l < prev_l)
             prev_l = l; /*break*/
 
-          if (fold_constrained && pos && (k <= ck || i >= ci) && !type2)
+          if (pos && (k <= ck || i >= ci) && !type2)
             continue;
 
-          if (fold_constrained && pos && ((cstruc[k - 1] == '|') || (cstruc[n1 + l - 1] == '|')) &&
+          if (pos && ((cstruc[k - 1] == '|') || (cstruc[n1 + l - 1] == '|')) &&
               !type2)
             break;
 
@@ -846,24 +976,24 @@ pf_interact(const char  *s1,
                                 S1[k + 1], SS2[l - 1], S1[i - 1], SS2[j + 1], Pf) *
                   scale[i - k + l - j]; /* add *scale[u1+u2+2] */
 
-              qint_4[i][j][a][b] += (qint_4[k][l][0][0] * E);
+              QINT_4(i, j, a, b) += (QINT_4(k, l, 0, 0) * E);
 
               /* use ia and ib to go from a....w-1 and from b....w-1  */
               ia = ib = 1;
               while ((a + ia) < w && i - (a + ia) >= 1 && (b + ib) < w && (j + b + ib) <= n2) {
                 int iaa, ibb;
 
-                qint_4[i][j][a + ia][b + ib] += qint_4[k][l][ia][ib] * E;
+                QINT_4(i, j, a + ia, b + ib) += QINT_4(k, l, ia, ib) * E;
 
                 iaa = ia + 1;
                 while (a + iaa < w && i - (a + iaa) >= 1) {
-                  qint_4[i][j][a + iaa][b + ib] += qint_4[k][l][iaa][ib] * E;
+                  QINT_4(i, j, a + iaa, b + ib) += QINT_4(k, l, iaa, ib) * E;
                   ++iaa;
                 }
 
                 ibb = ib + 1;
                 while ((b + ibb) < w && (j + b + ibb) <= n2) {
-                  qint_4[i][j][a + ia][b + ibb] += qint_4[k][l][ia][ibb] * E;
+                  QINT_4(i, j, a + ia, b + ibb) += QINT_4(k, l, ia, ibb) * E;
                   ++ibb;
                 }
                 ++ia;
@@ -874,20 +1004,20 @@ pf_interact(const char  *s1,
 
           /* '|' constrain in long sequence */
           /* collect interactions starting before 5' most '|' constrain */
-          if (fold_constrained && pos && ci && i < ci)
+          if (pos && ci && i < ci)
             continue;
 
           /* collect interactions ending after 3' most '|' constrain*/
-          if (fold_constrained && pos && ck && k > ck)
+          if (pos && ck && k > ck)
             continue;
 
           /* '|' constrain in short sequence */
           /* collect interactions starting before 5' most '|' constrain */
-          if (fold_constrained && pos && cj && j > cj)
+          if (pos && cj && j > cj)
             continue;
 
           /* collect interactions ending after 3' most '|' constrain*/
-          if (fold_constrained && pos && cl && l < cl)
+          if (pos && cl && l < cl)
             continue;
 
           /* scale everything to w/2*/
@@ -906,18 +1036,15 @@ pf_interact(const char  *s1,
             add_i3 = pc_size - 1;
 
           if (p_c2 == NULL) /* consider only structure of longer seq. */
-            tt = qint_4[i][j][a][b] * p_c_S[add_i5][add_i3] * scalew * rev_d;
+            tt = QINT_4(i, j, a, b) * p_c_S[add_i5][add_i3] * scalew * rev_d;
           else              /* consider structures of both seqs. */
-            tt = qint_4[i][j][a][b] * p_c_S[add_i5][add_i3] * p_c2_S[j][b] * scalew * rev_d;
+            tt = QINT_4(i, j, a, b) * p_c_S[add_i5][add_i3] * p_c2_S[j][b] * scalew * rev_d;
 
           temp          += tt;
-          qint_ik[k][i] += tt;
-          /* int_ik */
+          QINT_IK(k, i) += tt;
           /* check deltaG_ges = deltaG_int + deltaG_unstr; */
-          intt          = qint_4[i][j][a][b] * scalew * rev_d;
-          temp_int      += intt;
-          int_ik[k][i]  += intt;
-          G_is          = (-log(tt) - const_scale) * (const_T);
+          intt  = QINT_4(i, j, a, b) * scalew * rev_d;
+          G_is  = (-log(tt) - const_scale) * (const_T);
           if (G_is < G_min || EQUAL(G_is, G_min)) {
             G_min   = G_is;
             Gi_min  = (-log(intt) - const_scale) * (const_T);
@@ -929,92 +1056,44 @@ pf_interact(const char  *s1,
         }
       }
       Z += temp;
-      /* int_ik */
-      Z_int += temp_int;
-    }
-
-    /* free qint_4 values not needed any more */
-    if (i > w) {
-      int bla;
-      bla = i - w;
-      if (fold_constrained && pos && ci && i - w < ci - w + 1)
-        continue;
-
-      if (fold_constrained && pos && ci)
-        bla = MAX2(ci - w + 1, i - w);
-
-      for (j = n2; j > 0; j--) {
-        for (k = 0; k <= w; k++)
-          free(qint_4[bla][j][k]);
-        free(qint_4[bla][j]);
-      }
-      free(qint_4[bla]);
-      qint_4[bla] = NULL;
     }
   }
 
-
-  Z2 = 0.0;
   for (i = 1; i <= n1; i++) {
     for (k = i; k <= n1 && k < i + w; k++) {
-      Z2 += qint_ik[i][k];
+      double p, G;
+      /* Int->Pi[l]: prob that position l is within a paired region */
+      /* qint_ik[i][k] as well as Z are scaled to scale[((int) w/2) */
+      p = QINT_IK(i, k) / Z;
+      /* Int->Gi[l]: minimal delta G at position [l] */
+      G = (-log(QINT_IK(i, k)) - const_scale) * const_T;
       for (l = i; l <= k; l++) {
-        /* Int->Pi[l]: prob that position l is within a paired region */
-        /* qint_ik[i][k] as well as Z are scaled to scale[((int) w/2) */
-        Int->Pi[l] += qint_ik[i][k] / Z;
-        /* Int->Gi[l]: minimal delta G at position [l] */
-        Int->Gi[l] = MIN2(Int->Gi[l],
-                          (-log(qint_ik[i][k]) - (((int)w / 2) * log(pf_scale))) *
-                          (Pf->kT / 1000.0));
+        Int->Pi[l]  += p;
+        Int->Gi[l]  = MIN2(Int->Gi[l], G);
       }
     }
   }
-  if (n1 > w) {
-    int start_i, end_i;
-    start_i = n1 - w + 1;
-    end_i   = n1;
-    if (fold_constrained && pos && ci) {
-      /* a break in the k loop might result in unfreed values */
-      start_i = ci - w + 1 < n1 - w + 1 ? ci - w + 1 : n1 - w + 1;
-      start_i = start_i > 0 ? start_i : 1;
-      /* start_i = ck; */
-      end_i = ck + w - 1 > n1 ? n1 : ck + w - 1;
-    }
 
-    for (i = start_i; i <= end_i; i++) {
-      if (qint_4[i] == NULL)
-        continue;
+#undef QINT_4
+#undef QINT_IK
 
-      for (j = n2; j > 0; j--) {
-        for (k = 0; k <= w; k++)
-          free(qint_4[i][j][k]);
-        free(qint_4[i][j]);
-      }
-      free(qint_4[i]);
-    }
-    free(qint_4);
-  } else {
-    int start_i, end_i;
-    start_i = 1;
-    end_i   = n1;
-    if (fold_constrained && pos) {
-      start_i = ci - w + 1 > 0 ? ci - w + 1 : 1;
-      end_i   = ck + w - 1 > n1 ? n1 : ck + w - 1;
-    }
+  free(qint_4);
+  free(qint_ik);
+  free(scale);
+  free(ptype_int);
+  free(SS);
+  free(SS2);
 
-    for (i = start_i; i <= end_i; i++) {
-      for (j = n2; j > 0; j--) {
-        for (k = 0; k <= w; k++)
-          free(qint_4[i][j][k]);
-        free(qint_4[i][j]);
-      }
-      free(qint_4[i]);
-    }
-    free(qint_4);
+  if (p_c2 != NULL) {
+    for (i = 1; i <= n2; i++)
+      free(p_c2_S[i]);
+    free(p_c2_S);
   }
 
-  if (fold_constrained && (gi == 0 || gk == 0 || gl == 0 || gj == 0))
-    vrna_message_error("pf_interact: could not satisfy all constraints");
+  if (cstruc && (gi == 0 || gk == 0 || gl == 0 || gj == 0)) {
+    free_interact(Int);
+    return NULL;
+  }
 
   /* fill structure interact */
   Int->length   = n1;
@@ -1025,79 +1104,65 @@ pf_interact(const char  *s1,
   Int->Gikjl    = G_min;
   Int->Gikjl_wo = Gi_min;
 
-  free(i_long);
-  free(i_short);
+  return Int;
+}
 
-  for (i = 1; i <= n1; i++)
-    free(int_ik[i]);
-  free(int_ik);
-  for (i = 1; i <= n1; i++)
-    free(qint_ik[i]);
-  free(qint_ik);
 
-  /* reset the global variables pf_scale and scale to their original values */
-  pf_scale = temppfs;                 /* reset pf_scale */
-  scale_stru_pf_params((unsigned)n1); /* reset the scale array */
-  free_pf_arrays();                   /* for arrays for pf_fold(...) */
+PUBLIC interact **
+pf_interact_batch(const pu_target *target,
+                  const char      **queries,
+                  pu_contrib      **p_c2,
+                  int             num_threads)
+{
+  int       i, n;
+  interact  **results;
 
-  if (expMLbase != NULL) {
-    free(expMLbase);
-    expMLbase = NULL;
-  }
+  if ((!target) || (!queries))
+    return NULL;
 
-  if (scale != NULL) {
-    free(scale);
-    scale = NULL;
-  }
+  for (n = 0; queries[n]; n++) ;
 
-  for (i = 1; i <= n1; i++)
-    free(p_c_S[i]);
-  free(p_c_S);
-  if (p_c2 != NULL) {
-    for (i = 1; i <= n2; i++)
-      free(p_c2_S[i]);
-    free(p_c2_S);
-  }
+  results = (interact **)vrna_alloc(sizeof(interact *) * (n + 1));
 
-  free(Seq);
-  free(cc->indx);
-  free(cc->ptype);
-  free(cc);
-  return Int;
+#ifdef _OPENMP
+  if (num_threads <= 0)
+    num_threads = omp_get_max_threads();
+
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+#endif
+  for (i = 0; i < n; i++)
+    results[i] = pf_interact_target(target, queries[i], (p_c2) ? p_c2[i] : NULL, NULL);
+
+  return results;
 }
 
 
 /*------------------------------------------------------------------------*/
 /* use an extra scale for pf_interact, here sl is the longer sequence */
-PRIVATE void
-scale_int(const char  *s,
-          const char  *sl,
-          double      *sc_int)
+PRIVATE double
+scale_int(const char        *s,
+          const char        *sl,
+          vrna_exp_param_t  *P)
 {
-  int     n, nl;
+  int     n;
   duplexT mfe;
-  double  kT;
+  double  kT, sc_int;
 
-  n   = strlen(s);
-  nl  = strlen(sl);
-
-  free(expMLbase);
-  free(scale);
-
-  expMLbase = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * ((nl + 1) * 2));
-  scale     = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * ((nl + 1) * 2));
+  n = strlen(s);
 
   /* use RNA duplex to get a realistic estimate for the best possible
    * interaction energy between the short RNA s and its target sl */
   mfe = duplexfold(s, sl);
 
-  kT = Pf->kT / 1000.0; /* in Kcal */
+  kT = P->kT / 1000.0; /* in Kcal */
 
   /* sc_int is similar to pf_scale: i.e. one time the scale */
-  *sc_int = exp(-(mfe.energy) / kT / n);
+  sc_int = exp(-(mfe.energy) / kT / n);
 
   /* free the structure returned by duplexfold */
   free(mfe.structure);
+
+  return sc_int;
 }
 
 
@@ -1197,53 +1262,10 @@ free_up_arrays(void)
 PUBLIC void
 free_interact(interact *pin)
 {
-  if (S != NULL && pin != NULL) {
-    free(S);
-    S = NULL;
-  }
-
-  if (S1 != NULL && pin != NULL) {
-    free(S1);
-    S1 = NULL;
-  }
-
   if (pin != NULL) {
     free(pin->Pi);
     free(pin->Gi);
     free(pin);
-    pin = NULL;
-  }
-}
-
-
-/*---------------------------------------------------------------------------*/
-
-PRIVATE void
-encode_seq(const char *s1,
-           const char *s2)
-{
-  unsigned int i, l;
-
-  l = strlen(s1);
-  /* S and S1 are freed by free_pf_arrays(); ! */
-  S   = (short *)vrna_alloc(sizeof(short) * (l + 1));
-  S1  = (short *)vrna_alloc(sizeof(short) * (l + 1));
-  /* S1 exists only for the special X K and I bases and energy_set!=0 */
-  S[0] = l;
-  for (i = 1; i <= l; i++) {
-    /* make numerical encoding of sequence */
-    S[i]  = (short)encode_char(toupper(s1[i - 1]));
-    S1[i] = alias[S[i]]; /* for mismatches of nostandard bases */
-  }
-  if (s2 != NULL) {
-    l = strlen(s2);
-    /* SS2 exists only for the special X K and I bases and energy_set!=0 */
-    SS[0] = l;
-    for (i = 1; i <= l; i++) {
-      /* make numerical encoding of sequence */
-      SS[i]   = (short)encode_char(toupper(s2[i - 1]));
-      SS2[i]  = alias[SS[i]]; /* for mismatches of nostandard bases */
-    }
   }
 }
 
@@ -1619,15 +1641,15 @@ Up_plot(pu_contrib    *p_c,
 /*-------------------------------------------------------------------------*/
 /* copy from part_func_co.c */
 PRIVATE constrain *
-get_ptypes_up(char        *Seq,
-              const char  *structure)
+get_ptypes_up(const char  *Seq,
+              const char  *structure,
+              int         noLP)
 {
   int       n, i, j, k, l, length;
   constrain *con;
   short     *s, *s1;
 
   length = strlen(Seq);
-  make_pair_matrix();
   con       = (constrain *)vrna_alloc(sizeof(constrain));
   con->indx = (int *)vrna_alloc(sizeof(int) * (length + 1));
   for (i = 1; i <= length; i++)
@@ -1650,7 +1672,7 @@ get_ptypes_up(char        *Seq,
         if ((i > 1) && (j < n))
           ntype = pair[s[i - 1]][s[j + 1]];
 
-        if (noLonelyPairs && (!otype) && (!ntype))
+        if (noLP && (!otype) && (!ntype))
           type = 0; /* i.j can only form isolated pairs */
 
         con->ptype[con->indx[i] - j]  = (char)type;
@@ -1661,7 +1683,7 @@ get_ptypes_up(char        *Seq,
       }
     }
 
-  if (fold_constrained && (structure != NULL)) {
+  if (structure != NULL) {
     int   hx, *stack;
     char  type;
     stack = (int *)vrna_alloc(sizeof(int) * (n + 1));
@@ -1709,6 +1731,102 @@ get_ptypes_up(char        *Seq,
 }
 
 
+/*
+ *  Intermolecular pair types ptype[i * (n2 + 1) + j] between position i of
+ *  the target and position j of the query. These are the same pair types
+ *  get_ptypes_up() yields for the concatenated sequences. However, only the
+ *  diagonals that enter the intermolecular region are followed, starting
+ *  from the target's last column whenever possible.
+ */
+PRIVATE char *
+get_ptypes_inter(const pu_target  *target,
+                 const short      *s2,
+                 int              n2)
+{
+  int   i, j, k, c, n, n1, type, otype, ntype;
+  short *s1;
+  char  *ptype_int;
+
+  n1        = target->length;
+  n         = n1 + n2;
+  s1        = target->S;
+  ptype_int = (char *)vrna_alloc(sizeof(char) * (n1 + 1) * (n2 + 1));
+
+#define ENC(P)  (((P) <= n1) ? s1[(P)] : s2[(P) - n1])
+
+  for (c = n1 + 2; c <= n1 + n; c++) {
+    /* first pair (k, c - k) of the diagonal */
+    k = (c & 1) ? (c - 1) / 2 : (c - 2) / 2;
+    if (c - k > n)
+      continue;
+
+    ntype = 0;
+    if (c - k <= n1) {
+      /* diagonal starts within the target, continue at (c - n1, n1) */
+      i     = c - n1;
+      j     = n1;
+      type  = pair[s1[i]][s1[j]];
+      otype = (i == k) ? 0 : target->lp_otype[i + 1];
+    } else {
+      i     = k;
+      j     = c - k;
+      type  = pair[ENC(i)][ENC(j)];
+      otype = 0;
+    }
+
+    for (; (i >= 1) && (j <= n); i--, j++) {
+      if ((i > 1) && (j < n))
+        ntype = pair[ENC(i - 1)][ENC(j + 1)];
+
+      if (target->noLP && (!otype) && (!ntype))
+        type = 0; /* i.j can only form isolated pairs */
+
+      if ((i <= n1) && (j > n1))
+        ptype_int[i * (n2 + 1) + j - n1] = (char)type;
+
+      otype = type;
+      type  = ntype;
+    }
+  }
+
+#undef ENC
+
+  return ptype_int;
+}
+
+
+PRIVATE char *
+get_ptypes_inter_constrained(const pu_target  *target,
+                             const char       *s2,
+                             const char       *cstruc)
+{
+  int       i, j, n1, n2;
+  char      *Seq, *ptype_int;
+  constrain *cc;
+
+  n1  = target->length;
+  n2  = (int)strlen(s2);
+  Seq = (char *)vrna_alloc(sizeof(char) * (n1 + n2 + 2));
+
+  strcpy(Seq, target->sequence);
+  strcat(Seq, s2);
+
+  cc        = get_ptypes_up(Seq, cstruc, target->noLP);
+  ptype_int = (char *)vrna_alloc(sizeof(char) * (n1 + 1) * (n2 + 1));
+
+  for (i = 1; i <= n1; i++)
+    for (j = 1; j <= n2; j++)
+      ptype_int[i * (n2 + 1) + j] = cc->ptype[cc->indx[i] - (n1 + j)];
+
+  free(Seq);
+  free(cc->indx);
+  free(cc->ptype);
+  free(cc);
+
+  return ptype_int;
+}
+
+
 PRIVATE void
 set_encoded_seq(const char  *sequence,
                 short       **S,
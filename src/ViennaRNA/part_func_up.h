@@ -110,6 +110,98 @@ interact *pf_interact(const char *s1,
                       int incr3,
                       int incr5);
 
+/**
+ *  @brief  The accessibility profile of a target RNA
+ *
+ *  Stores everything about a target RNA that does not depend on the
+ *  interacting (query) sequence, such that interactions with many queries
+ *  can be computed without re-evaluating the target's accessibilities.
+ *
+ *  @see pf_unstru_target(), pf_interact_target(), pf_interact_batch()
+ */
+typedef struct pu_target pu_target;
+
+
+/**
+ *  @brief  Prepare a re-usable accessibility profile of a target RNA
+ *
+ *  The profile is created from the output @p p_c of pf_unstru() for the
+ *  target sequence, which has to be computed for unpaired regions of length
+ *  at least @p w + @p incr5 + @p incr3 (or the length of the sequence if it
+ *  is shorter). The parameters @p w, @p incr3 and @p incr5 have the same
+ *  meaning as for pf_interact(). The energy parameters are taken from the
+ *  global model settings at the time this function is called. The profile
+ *  is not modified by any of the functions that use it, so it can be
+ *  shared among concurrent threads.
+ *
+ *  @see pf_interact_target(), pf_interact_batch(), free_pu_target()
+ *
+ *  @param  sequence  The target RNA sequence (the longer sequence 's1' of pf_interact())
+ *  @param  p_c       The probabilities of being unpaired for @p sequence
+ *  @param  w         The maximal length of the interaction
+ *  @param  incr3     The number of additional unpaired nucleotides 3' of the interaction
+ *  @param  incr5     The number of additional unpaired nucleotides 5' of the interaction
+ *  @return           The accessibility profile, or @p NULL if @p p_c does not fit the sequence
+ */
+pu_target *pf_unstru_target(const char *sequence,
+                            pu_contrib *p_c,
+                            int        w,
+                            int        incr3,
+                            int        incr5);
+
+
+/**
+ *  @brief  Free an accessibility profile created by pf_unstru_target()
+ */
+void free_pu_target(pu_target *target);
+
+
+/**
+ *  @brief  Compute the interaction between a target profile and a query sequence
+ *
+ *  This is the re-entrant counterpart of pf_interact() with the target given
+ *  as accessibility profile. The function neither reads nor modifies any global
+ *  state, apart from duplexfold() that is used to estimate the scaling factor.
+ *  Contrary to pf_interact(), constrained interaction is done whenever @p cstruc
+ *  is not @p NULL, and the function returns @p NULL if the constraints can not be
+ *  satisfied.
+ *
+ *  @see pf_unstru_target(), pf_interact(), pf_interact_batch()
+ *
+ *  @param  target  The accessibility profile of the (longer) target sequence
+ *  @param  s2      The (shorter) query sequence
+ *  @param  p_c2    The probabilities of being unpaired for @p s2, or @p NULL
+ *  @param  cstruc  The constraint string for the concatenated sequences, or @p NULL
+ *  @return         The interaction, use free_interact() to free it
+ */
+interact *pf_interact_target(const pu_target  *target,
+                             const char       *s2,
+                             pu_contrib       *p_c2,
+                             const char       *cstruc);
+
+
+/**
+ *  @brief  Compute the interactions of a target profile with a set of query sequences
+ *
+ *  Calls pf_interact_target() without constraints for each sequence of the @p NULL
+ *  terminated list @p queries. The individual queries are distributed over
+ *  @p num_threads parallel threads, if the library has been compiled with OpenMP
+ *  support. A value of @p num_threads <= 0 uses the default number of threads.
+ *
+ *  @see pf_unstru_target(), pf_interact_target()
+ *
+ *  @param  target      The accessibility profile of the target sequence
+ *  @param  queries     A @p NULL terminated list of query sequences
+ *  @param  p_c2        The probabilities of being unpaired of each query, or @p NULL
+ *  @param  num_threads The number of parallel threads to use
+ *  @return             A @p NULL terminated list of interactions in the order of @p queries
+ */
+interact **pf_interact_batch(const pu_target  *target,
+                             const char       **queries,
+                             pu_contrib       **p_c2,
+                             int              num_threads);
+
+
 /**
  *  @brief Frees the output of function pf_interact().
  */
@@ -7,11 +7,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 #ifdef VRNA_WITH_GSL
 #include <gsl/gsl_multimin.h>
 #endif
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "ViennaRNA/eval.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/constraints/hard.h"
@@ -21,6 +26,7 @@
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/perturbation_fold.h"
+#include "ViennaRNA/utils/timing_hooks.h"
 
 static void
 calculate_probability_unpaired(vrna_fold_compound_t *vc,
@@ -181,35 +187,35 @@ pairing_probabilities_from_restricted_pf(vrna_fold_compound_t *vc,
 
   calculate_probability_unpaired(vc, prob_unpaired);
 
+  /*
+   *  Each thread re-uses its own copy of the fold compound for all
+   *  positions it is assigned to. The restricted partition functions
+   *  are independent of each other, so the results do not depend on
+   *  the number of threads.
+   */
 #ifdef _OPENMP
-#pragma omp parallel for private(i)
+#pragma omp parallel private(i)
 #endif
-  for (i = 1; i <= length; ++i) {
-    vrna_fold_compound_t  *restricted_vc;
-    char                  *hc_string;
-    unsigned int          constraint_options = VRNA_CONSTRAINT_DB
-                                               | VRNA_CONSTRAINT_DB_PIPE
-                                               | VRNA_CONSTRAINT_DB_DOT
-                                               | VRNA_CONSTRAINT_DB_X
-                                               | VRNA_CONSTRAINT_DB_ANG_BRACK
-                                               | VRNA_CONSTRAINT_DB_RND_BRACK;
-
-    hc_string = vrna_alloc(sizeof(char) * (length + 1));
-    memset(hc_string, '.', length);
-    hc_string[i - 1] = 'x';
+  {
+    vrna_fold_compound_t *restricted_vc;
 
     restricted_vc = vrna_fold_compound(vc->sequence,
                                        &(vc->exp_params->model_details),
                                        VRNA_OPTION_PF);
-    vrna_constraints_add(restricted_vc, hc_string, constraint_options);
-    free(hc_string);
-
     vrna_exp_params_subst(restricted_vc, vc->exp_params);
 
-    vrna_pf(restricted_vc, NULL);
-    calculate_probability_unpaired(restricted_vc, conditional_prob_unpaired[i]);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (i = 1; i <= length; ++i) {
+      /* position i must not pair */
+      vrna_hc_init(restricted_vc);
+      vrna_hc_add_up(restricted_vc, i, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
+
+      vrna_pf(restricted_vc, NULL);
+      calculate_probability_unpaired(restricted_vc, conditional_prob_unpaired[i]);
+    }
 
-    restricted_vc->sc = NULL;
     vrna_fold_compound_free(restricted_vc);
   }
 
@@ -217,6 +223,30 @@ pairing_probabilities_from_restricted_pf(vrna_fold_compound_t *vc,
 }
 
 
+/*
+ *  Seed the private random number stream of sample s. The state only
+ *  depends on the master seed and s, so the samples do not depend on
+ *  the number of threads or the order in which they are drawn
+ */
+static void
+sample_stream_seed(unsigned short *state,
+                   uint64_t       master,
+                   int            s)
+{
+  uint64_t z;
+
+  /* splitmix64 finalizer */
+  z = master + 0x9E3779B97F4A7C15ULL * (uint64_t)(s + 1);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z = z ^ (z >> 31);
+
+  state[0]  = (unsigned short)(z & 0xFFFF);
+  state[1]  = (unsigned short)((z >> 16) & 0xFFFF);
+  state[2]  = (unsigned short)((z >> 32) & 0xFFFF);
+}
+
+
 static void
 pairing_probabilities_from_sampling(vrna_fold_compound_t  *vc,
                                     const double          *epsilon,
@@ -224,8 +254,10 @@ pairing_probabilities_from_sampling(vrna_fold_compound_t  *vc,
                                     double                *prob_unpaired,
                                     double                **conditional_prob_unpaired)
 {
-  int length = vc->length;
-  int i, j, s;
+  int           length = vc->length;
+  int           i, j, s, t, num_threads;
+  unsigned int  **counts;
+  uint64_t      master;
 
   st_back = 1; /* is this really required? */
 
@@ -240,31 +272,88 @@ pairing_probabilities_from_sampling(vrna_fold_compound_t  *vc,
   vrna_pf(vc, NULL);
 
 
+  /*
+   *  Each sample is drawn from its own random number stream, seeded from
+   *  a single draw of the global stream. Hence, a fixed seed reproduces
+   *  the samples for any number of threads. Each thread counts the
+   *  (conditional) unpaired events of its samples in a private table,
+   *  and the integral counts are merged once all samples are drawn.
+   */
+  master      = (uint64_t)(vrna_urn() * 281474976710656.); /* 2^48 */
+  num_threads = 1;
+
 #ifdef _OPENMP
-#pragma omp parallel for private(s)
+  num_threads = omp_get_max_threads();
 #endif
-  for (s = 0; s < sample_size; ++s) {
-    char *sample = vrna_pbacktrack(vc);
+
+  counts = (unsigned int **)vrna_alloc(sizeof(unsigned int *) * num_threads);
+
+  VRNA_TIMING_START(vc, VRNA_TIMING_SAMPLING);
 
 #ifdef _OPENMP
-#pragma omp critical
+#pragma omp parallel private(i, j, s, t) num_threads(num_threads)
+#endif
+  {
+    unsigned short  state[3];
+    unsigned int    *up, *cond;
+    int             *unpaired, num_unpaired;
+    char            *structure;
+
+    t = 0;
+#ifdef _OPENMP
+    t = omp_get_thread_num();
 #endif
-    {
-      for (i = 1; i <= length; ++i) {
-        if (sample[i - 1] != '.')
-          continue;
 
-        ++prob_unpaired[i];
+    /* unpaired counts of each position, followed by the conditional counts of each pair of positions */
+    up        = (unsigned int *)vrna_alloc(sizeof(unsigned int) * (length + 1) * (length + 2));
+    cond      = up + length + 1;
+    unpaired  = (int *)vrna_alloc(sizeof(int) * (length + 1));
+    counts[t] = up;
 
-        for (j = 1; j <= length; ++j)
-          if (sample[j - 1] == '.')
-            ++conditional_prob_unpaired[i][j];
+    vrna_urn_stream(state);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (s = 0; s < sample_size; ++s) {
+      sample_stream_seed(state, master, s);
+      structure = vrna_pbacktrack(vc);
+
+      for (num_unpaired = 0, i = 1; i <= length; ++i)
+        if (structure[i - 1] == '.')
+          unpaired[num_unpaired++] = i;
+
+      for (i = 0; i < num_unpaired; ++i) {
+        ++up[unpaired[i]];
+        for (j = 0; j < num_unpaired; ++j)
+          ++cond[unpaired[i] * (length + 1) + unpaired[j]];
       }
+
+      free(structure);
     }
 
-    free(sample);
+    vrna_urn_stream(NULL);
+    free(unpaired);
   }
 
+  VRNA_TIMING_STOP(vc, VRNA_TIMING_SAMPLING);
+
+  /* merge the counts of all threads in a fixed order */
+  for (t = 0; t < num_threads; ++t) {
+    if (!counts[t])
+      continue;
+
+    for (i = 1; i <= length; ++i) {
+      prob_unpaired[i] += counts[t][i];
+      for (j = 1; j <= length; ++j)
+        conditional_prob_unpaired[i][j] += counts[t][length + 1 + i * (length + 1) + j];
+    }
+
+    free(counts[t]);
+  }
+
+  free(counts);
+
   for (i = 1; i <= length; ++i) {
     if (prob_unpaired[i])
       for (j = 1; j <= length; ++j)
@@ -339,6 +428,9 @@ evaluate_perturbation_vector_gradient(vrna_fold_compound_t  *vc,
                                              p_conditional_prob_unpaired);
   }
 
+#ifdef _OPENMP
+#pragma omp parallel for private(i, mu)
+#endif
   for (mu = 1; mu <= length; ++mu) {
     double sum = 0;
 
@@ -37,6 +37,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <math.h>
 #include <ctype.h>
 #include <string.h>
@@ -49,6 +50,17 @@
 #include "ViennaRNA/plex.h"
 #include "ViennaRNA/ali_plex.h"
 #include "ViennaRNA/loops/all.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* thread-local storage for builds that use POSIX threads but not OpenMP */
+#if !defined(_OPENMP) && VRNA_WITH_PTHREADS && defined(__GNUC__)
+# define PLEX_THREAD_LOCAL __thread
+#else
+# define PLEX_THREAD_LOCAL
+#endif
 /* #################SIMD############### */
 
 /* int subopt_sorted=0; */
@@ -251,7 +263,7 @@ fbacktrack_XS(int       i,
 #define MAXSECTORS      500     /* dimension for a backtrack array */
 #define LOCALITY        0.      /* locality parameter for base-pairs */
 
-PRIVATE vrna_param_t *P = NULL;
+PRIVATE PLEX_THREAD_LOCAL vrna_param_t *P = NULL;
 
 /**
 *** energy array used in fduplexfold and fduplexfold_XS
@@ -260,16 +272,29 @@ PRIVATE vrna_param_t *P = NULL;
 *** c -> stack;in -> interior loop;bx/by->bulge;inx/iny->1xn loops
 **/
 
-PRIVATE int **c = NULL, **in = NULL, **bx = NULL, **by = NULL, **inx = NULL, **iny = NULL;
+PRIVATE PLEX_THREAD_LOCAL int **c = NULL, **in = NULL, **bx = NULL, **by = NULL, **inx = NULL,
+                              **iny = NULL;
 
 /**
 *** S1, SS1, ... contains the encoded sequence for target and query
 *** n1, n2, n3, n4 contains target and query length
 **/
 
-PRIVATE short *S1 = NULL, *SS1 = NULL, *S2 = NULL, *SS2 = NULL; /*contains the sequences*/
-PRIVATE int   n1, n2;                                           /* sequence lengths */
-PRIVATE int   n3, n4; /*sequence length for the duplex*/;
+PRIVATE PLEX_THREAD_LOCAL short *S1 = NULL, *SS1 = NULL, *S2 = NULL, *SS2 = NULL; /*contains the sequences*/
+PRIVATE PLEX_THREAD_LOCAL int   n1, n2;                                           /* sequence lengths */
+PRIVATE PLEX_THREAD_LOCAL int   n3, n4; /*sequence length for the duplex*/;
+
+/* stream the hits of the calling thread are printed to, stdout if NULL */
+PRIVATE PLEX_THREAD_LOCAL vrna_cstr_t output_stream = NULL;
+
+#ifdef _OPENMP
+
+/* NOTE: all variables are assumed to be uninitialized if they are declared as threadprivate
+ */
+#pragma omp threadprivate(P, c, in, bx, by, inx, iny, S1, SS1, S2, SS2, n1, n2, n3, n4, \
+  output_stream)
+
+#endif
 
 
 /*-----------------------------------------------------------------------duplexfold_XS---------------------------------------------------------------------------*/
@@ -324,7 +349,7 @@ duplexfold_XS(const char  *s1,
   j     = 1 + j_flag;
   type  = pair[S1[i]][S2[j]];
   if (!type) {
-    printf("Error during initialization of the duplex in duplexfold_XS\n");
+    plex_output_printf("Error during initialization of the duplex in duplexfold_XS\n");
     mfe.structure = NULL;
     mfe.energy    = INF;
     return mfe;
@@ -2381,10 +2406,10 @@ find_max_XS(const int   *position,
         max_pos_j = position_j[pos + delta];
         int max;
         max = position[pos + delta];
-        printf("target upper bound %d: query lower bound %d  (%5.2f) \n",
-               pos - 10,
-               max_pos_j - 10,
-               ((double)max) / 100);
+        plex_output_printf("target upper bound %d: query lower bound %d  (%5.2f) \n",
+                           pos - 10,
+                           max_pos_j - 10,
+                           ((double)max) / 100);
         pos = MAX2(10, pos + temp_min - delta);
       }
     }
@@ -2437,7 +2462,7 @@ find_max_XS(const int   *position,
                               b_b);
         if (test.energy * 100 < threshold) {
           int l1 = strchr(test.structure, '&') - test.structure;
-          printf(
+          plex_output_printf(
             " %s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) [%5.2f] i:%d,j:%d <%5.2f>\n",
             test.structure,
             begin_t - 10 + test.i - l1 - 10,
@@ -2492,19 +2517,19 @@ find_max_XS(const int   *position,
         test =
           duplexfold_XS(s3, s4, access_s1, access_s2, pos, max_pos_j, threshold, i_flag, j_flag);
         if (test.energy * 100 < threshold) {
-          printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) i:%d,j:%d <%5.2f>\n",
-                 test.structure,
-                 test.tb,
-                 test.te,
-                 test.qb,
-                 test.qe,
-                 test.ddG,
-                 test.energy,
-                 test.dG1,
-                 test.dG2,
-                 pos - 10,
-                 max_pos_j - 10,
-                 ((double)position[pos + delta]) / 100);
+          plex_output_printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) i:%d,j:%d <%5.2f>\n",
+                             test.structure,
+                             test.tb,
+                             test.te,
+                             test.qb,
+                             test.qe,
+                             test.ddG,
+                             test.energy,
+                             test.dG1,
+                             test.dG2,
+                             pos - 10,
+                             max_pos_j - 10,
+                             ((double)position[pos + delta]) / 100);
           pos = MAX2(10, pos + temp_min - delta);
         }
 
@@ -2556,8 +2581,8 @@ plot_max_XS(const int   max,
             const int   b_b)
 {
   if (fast == 1) {
-    printf("target upper bound %d: query lower bound %d (%5.2f)\n", max_pos - 3, max_pos_j,
-           ((double)max) / 100);
+    plex_output_printf("target upper bound %d: query lower bound %d (%5.2f)\n", max_pos - 3, max_pos_j,
+                       ((double)max) / 100);
   } else if (fast == 2) {
     int   alignment_length2;
     alignment_length2 = MIN2(n1, n2);
@@ -2578,20 +2603,20 @@ plot_max_XS(const int   max,
     duplexT test;
     test = fduplexfold_XS(s3, s4, access_s1, access_s2, end_t, begin_q, INF, il_a, il_b, b_a, b_b);
     int     l1 = strchr(test.structure, '&') - test.structure;
-    printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) [%5.2f] i:%d,j:%d <%5.2f>\n",
-           test.structure,
-           begin_t - 10 + test.i - l1 - 10,
-           begin_t - 10 + test.i - 1 - 10,
-           begin_q - 10 + test.j - 1 - 10,
-           (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2 - 10,
-           test.ddG,
-           test.energy,
-           test.opening_backtrack_x,
-           test.opening_backtrack_y,
-           test.energy_backtrack,
-           max_pos - 10,
-           max_pos_j - 10,
-           (double)max / 100);
+    plex_output_printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) [%5.2f] i:%d,j:%d <%5.2f>\n",
+                       test.structure,
+                       begin_t - 10 + test.i - l1 - 10,
+                       begin_t - 10 + test.i - 1 - 10,
+                       begin_q - 10 + test.j - 1 - 10,
+                       (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2 - 10,
+                       test.ddG,
+                       test.energy,
+                       test.opening_backtrack_x,
+                       test.opening_backtrack_y,
+                       test.energy_backtrack,
+                       max_pos - 10,
+                       max_pos_j - 10,
+                       (double)max / 100);
 
     free(s3);
     free(s4);
@@ -2614,19 +2639,19 @@ plot_max_XS(const int   max,
     s4[end_q - begin_q + 1] = '\0';
     duplexT test;
     test = duplexfold_XS(s3, s4, access_s1, access_s2, max_pos, max_pos_j, INF, i_flag, j_flag);
-    printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) i:%d,j:%d <%5.2f>\n",
-           test.structure,
-           test.tb,
-           test.te,
-           test.qb,
-           test.qe,
-           test.ddG,
-           test.energy,
-           test.dG1,
-           test.dG2,
-           max_pos - 10,
-           max_pos_j - 10,
-           (double)max / 100);
+    plex_output_printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) i:%d,j:%d <%5.2f>\n",
+                       test.structure,
+                       test.tb,
+                       test.te,
+                       test.qb,
+                       test.qe,
+                       test.ddG,
+                       test.energy,
+                       test.dG1,
+                       test.dG2,
+                       max_pos - 10,
+                       max_pos_j - 10,
+                       (double)max / 100);
     free(s3);
     free(s4);
     free(test.structure);
@@ -4136,10 +4161,10 @@ find_max(const int  *position,
         max_pos_j = position_j[pos + delta];
         int max;
         max = position[pos + delta];
-        printf("target upper bound %d: query lower bound %d  (%5.2f) \n",
-               pos - 10,
-               max_pos_j - 10,
-               ((double)max) / 100);
+        plex_output_printf("target upper bound %d: query lower bound %d  (%5.2f) \n",
+                           pos - 10,
+                           max_pos_j - 10,
+                           ((double)max) / 100);
         pos = MAX2(10, pos + temp_min - delta);
       }
     }
@@ -4182,13 +4207,13 @@ find_max(const int  *position,
         test = fduplexfold(s3, s4, extension_cost, il_a, il_b, b_a, b_b);
         if (test.energy * 100 < threshold) {
           int l1 = strchr(test.structure, '&') - test.structure;
-          printf("%s %3d,%-3d : %3d,%-3d (%5.2f) [%5.2f]  i:%d,j:%d <%5.2f>\n", test.structure,
-                 begin_t - 10 + test.i - l1 - 10,
-                 begin_t - 10 + test.i - 1 - 10,
-                 begin_q - 10 + test.j - 1 - 10,
-                 (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2 - 10,
-                 test.energy, test.energy_backtrack, pos - 10, max_pos_j - 10,
-                 ((double)position[pos + delta]) / 100);
+          plex_output_printf("%s %3d,%-3d : %3d,%-3d (%5.2f) [%5.2f]  i:%d,j:%d <%5.2f>\n", test.structure,
+                             begin_t - 10 + test.i - l1 - 10,
+                             begin_t - 10 + test.i - 1 - 10,
+                             begin_q - 10 + test.j - 1 - 10,
+                             (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2 - 10,
+                             test.energy, test.energy_backtrack, pos - 10, max_pos_j - 10,
+                             ((double)position[pos + delta]) / 100);
           pos = MAX2(10, pos + temp_min - delta);
         }
 
@@ -4269,17 +4294,17 @@ find_max(const int  *position,
           //          l1=strchr(reverse.structure, '&')-test.structure;
 
 
-          printf("%s %3d,%-3d : %3d,%-3d (%5.2f) [%5.2f] i:%d,j:%d <%5.2f>\n",
-                 reverseStructure,
-                 begin_t - 10 + test.j - 1 - 10,
-                 (begin_t - 11) + test.j + strlen(test.structure) - l1 - 2 - 10,
-                 begin_q - 10 + test.i - l1 - 10,
-                 begin_q - 10 + test.i - 1 - 10,
-                 test.energy,
-                 test.energy_backtrack,
-                 pos,
-                 max_pos_j,
-                 ((double)position[pos + delta]) / 100);
+          plex_output_printf("%s %3d,%-3d : %3d,%-3d (%5.2f) [%5.2f] i:%d,j:%d <%5.2f>\n",
+                             reverseStructure,
+                             begin_t - 10 + test.j - 1 - 10,
+                             (begin_t - 11) + test.j + strlen(test.structure) - l1 - 2 - 10,
+                             begin_q - 10 + test.i - l1 - 10,
+                             begin_q - 10 + test.i - 1 - 10,
+                             test.energy,
+                             test.energy_backtrack,
+                             pos,
+                             max_pos_j,
+                             ((double)position[pos + delta]) / 100);
           pos = MAX2(10, pos + temp_min - delta);
         }
 
@@ -4325,12 +4350,12 @@ find_max(const int  *position,
         test = duplexfold(s3, s4, extension_cost);
         if (test.energy * 100 < threshold) {
           int l1 = strchr(test.structure, '&') - test.structure;
-          printf("%s %3d,%-3d : %3d,%-3d (%5.2f)  i:%d,j:%d <%5.2f>\n", test.structure,
-                 begin_t - 10 + test.i - l1,
-                 begin_t - 10 + test.i - 1,
-                 begin_q - 10 + test.j - 1,
-                 (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2,
-                 test.energy, pos - 10, max_pos_j - 10, ((double)position[pos + delta]) / 100);
+          plex_output_printf("%s %3d,%-3d : %3d,%-3d (%5.2f)  i:%d,j:%d <%5.2f>\n", test.structure,
+                             begin_t - 10 + test.i - l1,
+                             begin_t - 10 + test.i - 1,
+                             begin_q - 10 + test.j - 1,
+                             (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2,
+                             test.energy, pos - 10, max_pos_j - 10, ((double)position[pos + delta]) / 100);
           pos = MAX2(10, pos + temp_min - delta);
         }
 
@@ -4358,8 +4383,8 @@ plot_max(const int  max,
          const int  b_b)
 {
   if (fast == 1) {
-    printf("target upper bound %d: query lower bound %d (%5.2f)\n", max_pos - 10, max_pos_j - 10,
-           ((double)max) / 100);
+    plex_output_printf("target upper bound %d: query lower bound %d (%5.2f)\n", max_pos - 10, max_pos_j - 10,
+                       ((double)max) / 100);
   } else if (fast == 2) {
     int   alignment_length2;
     alignment_length2 = MIN2(n1, n2);
@@ -4380,12 +4405,12 @@ plot_max(const int  max,
     duplexT test;
     test = fduplexfold(s3, s4, extension_cost, il_a, il_b, b_a, b_b);
     int     l1 = strchr(test.structure, '&') - test.structure;
-    printf("%s %3d,%-3d : %3d,%-3d (%5.2f) [%5.2f] i:%d,j:%d <%5.2f>\n", test.structure,
-           begin_t - 10 + test.i - l1 - 10,
-           begin_t - 10 + test.i - 1 - 10,
-           begin_q - 10 + test.j - 1 - 10,
-           (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2 - 10,
-           test.energy, test.energy_backtrack, max_pos - 10, max_pos_j - 10, ((double)max) / 100);
+    plex_output_printf("%s %3d,%-3d : %3d,%-3d (%5.2f) [%5.2f] i:%d,j:%d <%5.2f>\n", test.structure,
+                       begin_t - 10 + test.i - l1 - 10,
+                       begin_t - 10 + test.i - 1 - 10,
+                       begin_q - 10 + test.j - 1 - 10,
+                       (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2 - 10,
+                       test.energy, test.energy_backtrack, max_pos - 10, max_pos_j - 10, ((double)max) / 100);
     free(s3);
     free(s4);
     free(test.structure);
@@ -4405,12 +4430,12 @@ plot_max(const int  max,
     s4[end_q - begin_q + 1] = '\0';
     test                    = duplexfold(s3, s4, extension_cost);
     int l1 = strchr(test.structure, '&') - test.structure;
-    printf("%s %3d,%-3d : %3d,%-3d (%5.2f) i:%d,j:%d <%5.2f>\n", test.structure,
-           begin_t - 10 + test.i - l1,
-           begin_t - 10 + test.i - 1,
-           begin_q - 10 + test.j - 1,
-           (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2,
-           test.energy, max_pos - 10, max_pos_j - 10, ((double)max) / 100);
+    plex_output_printf("%s %3d,%-3d : %3d,%-3d (%5.2f) i:%d,j:%d <%5.2f>\n", test.structure,
+                       begin_t - 10 + test.i - l1,
+                       begin_t - 10 + test.i - 1,
+                       begin_q - 10 + test.j - 1,
+                       (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2,
+                       test.energy, max_pos - 10, max_pos_j - 10, ((double)max) / 100);
     free(s3);
     free(s4);
     free(test.structure);
@@ -4477,6 +4502,30 @@ encode_seq(const char *sequence)
 }
 
 
+PUBLIC void
+plex_output_stream(vrna_cstr_t stream)
+{
+  output_stream = stream;
+}
+
+
+PUBLIC void
+plex_output_printf(const char *format,
+                   ...)
+{
+  va_list args;
+
+  va_start(args, format);
+
+  if (output_stream)
+    vrna_cstr_vprintf(output_stream, format, args);
+  else
+    vprintf(format, args);
+
+  va_end(args);
+}
+
+
 int
 arraySize(duplexT **array)
 {
@@ -2,6 +2,7 @@
 #define VIENNA_RNA_PACKAGE_PLEX_H
 
 #include <ViennaRNA/datastructures/basic.h>
+#include <ViennaRNA/datastructures/char_stream.h>
 
 
 extern int subopt_sorted;
@@ -74,6 +75,18 @@ duplexT** Lduplexfold_CXS(const char*s1,
 
 
 
+/**
+*** plex_output_stream sets the stream the Lduplexfold*() functions print their hits to
+*** in the calling thread. Hits are printed to stdout if stream is NULL (default)
+**/
+void plex_output_stream(vrna_cstr_t stream);
+
+/**
+*** plex_output_printf prints to the output stream of the calling thread, see plex_output_stream()
+**/
+void plex_output_printf(const char *format,
+                        ...);
+
 int      arraySize(duplexT** array);
 void     freeDuplexT(duplexT** array);
 
@@ -343,6 +343,18 @@ PS_rna_plot_snoop_a(const char *string,
                     const char *ssfile,
                     int *relative_access,
                     const char *seqs[])
+{
+  return PS_rna_plot_snoop_a_cut(string, structure, ssfile, relative_access, seqs, cut_point);
+}
+
+
+PUBLIC int
+PS_rna_plot_snoop_a_cut(const char *string,
+                        const char *structure,
+                        const char *ssfile,
+                        int *relative_access,
+                        const char *seqs[],
+                        int cut_point)
 {
   int    i, length;
   float *X, *Y;
@@ -34,6 +34,14 @@ int PS_rna_plot_snoop_a(const char *string,
                         int *relative_access,
                         const char *seqs[]);
 
+/* same as PS_rna_plot_snoop_a() but takes the cut point as argument instead of the global #cut_point */
+int PS_rna_plot_snoop_a_cut(const char *string,
+                            const char *structure,
+                            const char *ssfile,
+                            int *relative_access,
+                            const char *seqs[],
+                            int cut_point);
+
 /**
  *  @brief Produce a secondary structure graph in PostScript and write it to 'filename'.
  *
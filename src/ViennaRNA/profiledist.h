@@ -14,6 +14,7 @@
 #endif
 
 #include <ViennaRNA/datastructures/basic.h>
+#include <ViennaRNA/dist_matrix.h>
 
 /** \file profiledist.h  */
 
@@ -27,6 +28,25 @@ float profile_edit_distance(const float *T1,
                             const float *T2);
 
 
+/**
+ *  \brief Align all pairs of probability profiles
+ *
+ *  The pairs are distributed over @p num_threads parallel threads, each of
+ *  which re-uses its own memory for the dynamic programming tables. Alignments
+ *  are not computed, i.e. #edit_backtrack is ignored.
+ *
+ *  \see dist_matrix.h, vrna_dist_matrix_get(), vrna_file_distance_matrix()
+ *
+ *  \param profiles    The probability profiles as obtained from Make_bp_profile_bppm()
+ *  \param n           The number of profiles
+ *  \param num_threads The number of parallel threads (0 to use as many as cores are available)
+ *  \return            The packed upper triangular distance matrix of size n(n-1)/2 (NULL on error)
+ */
+float *profile_edit_distance_matrix(float **profiles,
+                                    int   n,
+                                    int   num_threads);
+
+
 /**
  *  \brief condense pair probability matrix into a vector containing probabilities
  *  for unpaired, upstream paired and downstream paired.
@@ -10,11 +10,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 
 #include "ViennaRNA/datastructures/basic.h"
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/utils/strings.h"
 #include "ViennaRNA/alphabet.h"
+#include "ViennaRNA/constraints/hard.h"
 #include "ViennaRNA/sequence.h"
 
 /*
@@ -183,6 +185,97 @@ vrna_sequence_prepare(vrna_fold_compound_t *fc)
 }
 
 
+PUBLIC int
+vrna_sequence_mutate(vrna_fold_compound_t *fc,
+                     const char           *sequence,
+                     unsigned int         **positions)
+{
+  unsigned int  i, j, k, p, n, turn, cnt, *mutated;
+  short         *S, *S2, enc;
+  vrna_md_t     *md;
+
+  if (positions)
+    *positions = NULL;
+
+  if ((!fc) || (!sequence))
+    return -1;
+
+  if ((fc->type != VRNA_FC_TYPE_SINGLE) ||
+      (fc->strands != 1) ||
+      ((fc->hc) && (fc->hc->type == VRNA_HC_WINDOW))) {
+    vrna_message_warning("vrna_sequence_mutate@sequence.c: "
+                         "Fold compound type not supported!");
+    return -1;
+  }
+
+  n = fc->length;
+
+  if (strlen(sequence) != n) {
+    vrna_message_warning("vrna_sequence_mutate@sequence.c: "
+                         "Sequence length mismatch (%u vs. %u)!",
+                         (unsigned int)strlen(sequence),
+                         n);
+    return -1;
+  }
+
+  md      = &(fc->params->model_details);
+  turn    = md->min_loop_size;
+  S       = fc->sequence_encoding;
+  S2      = fc->sequence_encoding2;
+  mutated = (unsigned int *)vrna_alloc(sizeof(unsigned int) * (n + 1));
+
+  /* 1. update sequence and its encodings */
+  for (cnt = 0, i = 1; i <= n; i++) {
+    fc->sequence[i - 1] = sequence[i - 1];
+    if (fc->nucleotides[0].string)
+      fc->nucleotides[0].string[i - 1] = toupper(sequence[i - 1]);
+
+    enc = (short)vrna_nucleotide_encode(sequence[i - 1], md);
+    if (enc != S2[i]) {
+      S2[i]           = enc;
+      S[i]            = md->alias[enc];
+      mutated[cnt++]  = i;
+    }
+  }
+
+  S2[n + 1] = S2[1];
+  S[n + 1]  = S[1];
+  S[0]      = S[n];
+
+  if (cnt > 0) {
+    /* 2. update pair types */
+    if (fc->ptype) {
+      if (md->noLP) {
+        free(fc->ptype);
+        fc->ptype = vrna_ptypes(S2, md);
+      } else {
+        for (k = 0; k < cnt; k++) {
+          p = mutated[k];
+          for (j = p + turn + 1; j <= n; j++)
+            fc->ptype[fc->jindx[j] + p] = (char)md->pair[S2[p]][S2[j]];
+          for (i = 1; i + turn < p; i++)
+            fc->ptype[fc->jindx[p] + i] = (char)md->pair[S2[i]][S2[p]];
+        }
+      }
+    }
+
+    /* backward compatibility ptypes will be re-created on demand */
+    free(fc->ptype_pf_compat);
+    fc->ptype_pf_compat = NULL;
+
+    /* 3. update default hard constraints */
+    vrna_hc_reset_pairs(fc, mutated);
+  }
+
+  if (positions)
+    *positions = mutated;
+  else
+    free(mutated);
+
+  return (int)cnt;
+}
+
+
 PRIVATE void
 set_sequence(vrna_seq_t   *obj,
              const char   *string,
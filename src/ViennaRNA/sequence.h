@@ -61,6 +61,31 @@ void          vrna_sequence_remove_all(vrna_fold_compound_t *vc);
 void          vrna_sequence_prepare(vrna_fold_compound_t *fc);
 
 
+/**
+ *  @brief  Replace the sequence of a fold compound by a point-mutated variant
+ *
+ *  Updates the sequence, its numerical encodings, the pair type array, and
+ *  the default hard constraints of all base pairs that involve a mutated
+ *  nucleotide (see vrna_hc_reset_pairs()). Everything else, in particular
+ *  the energy parameters and the allocated DP matrices, stays untouched.
+ *  This allows for cheap re-evaluation of many closely related sequences,
+ *  e.g. in sequence design, see vrna_mfe_mutate().
+ *
+ *  Only single sequence fold compounds that consist of a single strand and
+ *  were not created for sliding-window computations are supported.
+ *
+ *  @see vrna_mfe_mutate(), vrna_hc_reset_pairs()
+ *
+ *  @param  fc          The fold compound
+ *  @param  sequence    The new sequence (same length as the current one)
+ *  @param  positions   A pointer to store a 0-terminated list of mutated (1-based) positions into (maybe NULL)
+ *  @return             The number of mutated positions, or -1 on any error
+ */
+int           vrna_sequence_mutate(vrna_fold_compound_t *fc,
+                                   const char           *sequence,
+                                   unsigned int         **positions);
+
+
 /**
  *  @}
  */
@@ -27,6 +27,10 @@
 #include "ViennaRNA/snofold.h"
 #include "ViennaRNA/loops/all.h"
 
+#if VRNA_WITH_PTHREADS
+#include <pthread.h>
+#endif
+
 #ifdef __GNUC__
 #define INLINE inline
 #else
@@ -150,6 +154,15 @@ PRIVATE int           *BP = NULL; /* contains the structure constrainsts: BP[i]
 
 static sect   sector[MAXSECTORS]; /* stack of partial structures for backtracking */
 
+#if VRNA_WITH_PTHREADS
+/*
+ *  The backtracking from a pair uses the global arrays of the last snofold()
+ *  call, so concurrent backtracks and parameter updates, e.g. from the snoop
+ *  functions of several threads, are serialized
+ */
+PRIVATE pthread_mutex_t snofold_mtx = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 PRIVATE char  alpha[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
 /* needed by cofold/eval */
 /* PRIVATE int cut_in_loop(int i); */
@@ -1216,6 +1229,10 @@ snobacktrack_fold_from_pair(const char  *sequence,
 {
   char *structure;
 
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&snofold_mtx);
+#endif
+
   sector[1].i     = i;
   sector[1].j     = j;
   sector[1].ml    = 2;
@@ -1225,6 +1242,11 @@ snobacktrack_fold_from_pair(const char  *sequence,
   structure = vrna_db_from_bp_stack(base_pair, strlen(sequence));
   free(S);
   free(S1);
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&snofold_mtx);
+#endif
+
   return structure;
 }
 
@@ -1238,6 +1260,10 @@ alisnobacktrack_fold_from_pair(const char **strings,
   char  *structure;
   int   n_seq, s, length;
 
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&snofold_mtx);
+#endif
+
   length = (int)strlen(strings[0]);
   for (s = 0; strings[s] != NULL; s++) ;
   n_seq           = s;
@@ -1260,6 +1286,11 @@ alisnobacktrack_fold_from_pair(const char **strings,
   for (s = 0; s < n_seq; s++)
     free(Sali[s]);
   free(Sali);
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&snofold_mtx);
+#endif
+
   return structure;
 }
 
@@ -1328,6 +1359,10 @@ snoupdate_fold_params(void)
 {
   vrna_md_t md;
 
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&snofold_mtx);
+#endif
+
   if (P)
     free(P);
 
@@ -1336,6 +1371,10 @@ snoupdate_fold_params(void)
   make_pair_matrix();
   if (init_length < 0)
     init_length = 0;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&snofold_mtx);
+#endif
 }
 
 
@@ -14,6 +14,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <math.h>
 #include <ctype.h>
 #include <string.h>
@@ -31,6 +32,17 @@
 #include "ViennaRNA/duplex.h"
 #include "ViennaRNA/loops/all.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* thread-local storage for builds that use POSIX threads but not OpenMP */
+#if !defined(_OPENMP) && VRNA_WITH_PTHREADS && defined(__GNUC__)
+# define SNOOP_THREAD_LOCAL __thread
+#else
+# define SNOOP_THREAD_LOCAL
+#endif
+
 
 #define STACK_BULGE1  1   /* stacking energies for bulges of size 1 */
 #define NEW_NINIO     1   /* new asymetry penalty */
@@ -197,6 +209,11 @@ PRIVATE short *
 aliencode_seq(const char *sequence);
 
 
+PRIVATE void
+snoop_output_printf(const char  *format,
+                    ...);
+
+
 PUBLIC int snoop_subopt_sorted = 0; /* from subopt.c, default 0 */
 
 
@@ -207,24 +224,36 @@ PUBLIC int snoop_subopt_sorted = 0; /* from subopt.c, default 0 */
 #define MIN2(A, B)      ((A) < (B) ? (A) : (B))
 #define MAX2(A, B)      ((A) > (B) ? (A) : (B))
 #define ASS                1
-PRIVATE vrna_param_t  *P = NULL;
+PRIVATE SNOOP_THREAD_LOCAL vrna_param_t  *P = NULL;
 
-PRIVATE int           **c       = NULL; /* energy array, given that i-j pair */
-PRIVATE int           **r       = NULL;
-PRIVATE int           **lc      = NULL; /* energy array, given that i-j pair */
-PRIVATE int           **lr      = NULL;
-PRIVATE int           **c_fill  = NULL;
-PRIVATE int           **r_fill  = NULL;
-PRIVATE int           **lpair   = NULL;
+PRIVATE SNOOP_THREAD_LOCAL int           **c       = NULL; /* energy array, given that i-j pair */
+PRIVATE SNOOP_THREAD_LOCAL int           **r       = NULL;
+PRIVATE SNOOP_THREAD_LOCAL int           **lc      = NULL; /* energy array, given that i-j pair */
+PRIVATE SNOOP_THREAD_LOCAL int           **lr      = NULL;
+PRIVATE SNOOP_THREAD_LOCAL int           **c_fill  = NULL;
+PRIVATE SNOOP_THREAD_LOCAL int           **r_fill  = NULL;
+PRIVATE SNOOP_THREAD_LOCAL int           **lpair   = NULL;
 
 
-PRIVATE short         *S1 = NULL, *SS1 = NULL, *S2 = NULL, *SS2 = NULL;
-PRIVATE short         *S1_fill = NULL, *SS1_fill = NULL, *S2_fill = NULL, *SS2_fill = NULL;
-PRIVATE int           n1, n2; /* sequence lengths */
+PRIVATE SNOOP_THREAD_LOCAL short         *S1 = NULL, *SS1 = NULL, *S2 = NULL, *SS2 = NULL;
+PRIVATE SNOOP_THREAD_LOCAL short         *S1_fill = NULL, *SS1_fill = NULL, *S2_fill = NULL,
+                                         *SS2_fill = NULL;
+PRIVATE SNOOP_THREAD_LOCAL int           n1, n2; /* sequence lengths */
 
-extern int            cut_point;
 
-PRIVATE int           delay_free = 0;
+PRIVATE SNOOP_THREAD_LOCAL int           delay_free = 0;
+
+/* stream the hits of the calling thread are printed to, stdout if NULL */
+PRIVATE SNOOP_THREAD_LOCAL vrna_cstr_t   output_stream = NULL;
+
+#ifdef _OPENMP
+
+/* NOTE: all variables are assumed to be uninitialized if they are declared as threadprivate
+ */
+#pragma omp threadprivate(P, c, r, lc, lr, c_fill, r_fill, lpair, \
+  S1, SS1, S2, SS2, S1_fill, SS1_fill, S2_fill, SS2_fill, n1, n2, delay_free, output_stream)
+
+#endif
 /*--------------------------------------------------------------------------*/
 
 snoopT
@@ -400,7 +429,7 @@ alisnoopfold(const char **s1,
     }
   }
   if (Emin > 0) {
-    printf("no target found under the constraints chosen\n");
+    snoop_output_printf("no target found under the constraints chosen\n");
     for (i = 0; i <= n1; i++) {
       free(r[i]);
       free(c[i]);
@@ -1648,7 +1677,7 @@ find_max_snoop(const char *s1,
       s4 = (char *)vrna_alloc(sizeof(char) * (strlen(s2) - 9));
       strncpy(s4, s2 + 5, (int)strlen(s2) - 10);
       s4[(int)strlen(s2) - 10] = '\0';
-      printf(
+      snoop_output_printf(
         "%s %3d,%-3d;%3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f + %5.2f + 4.1 ) (%5.2f) \n%s&%s\n",
         target_struct,
         begin + test.i - 5 - l1,
@@ -1676,14 +1705,12 @@ find_max_snoop(const char *s1,
         strcat(temp_struc, target_struct + l1 + 1);
         temp_seq[n2 + l1 - 10]    = '\0';
         temp_struc[n2 + l1 - 10]  = '\0';
-        cut_point                 = l1 + 1;
         psoutput                  = vrna_strdup_printf("sno_%d_u_%d_%s.ps",
                                                        count,
                                                        begin + test.u - 6,
                                                        name);
 
-        PS_rna_plot_snoop_a(temp_seq, temp_struc, psoutput, NULL, NULL);
-        cut_point = -1;
+        PS_rna_plot_snoop_a_cut(temp_seq, temp_struc, psoutput, NULL, NULL, l1 + 1);
         free(temp_seq);
         free(temp_struc);
         free(psoutput);
@@ -1834,7 +1861,7 @@ snoopfold(const char  *s1,
     }
   }
   if (Emin > 0) {
-    printf("no target found under the constraints chosen\n");
+    snoop_output_printf("no target found under the constraints chosen\n");
     for (i = 0; i <= n1; i++) {
       free(r[i]);
       free(c[i]);
@@ -2356,7 +2383,7 @@ snoop_subopt_XS(const char  *s1,
       strncpy(s5, s3 + test.i - 1, n5 - test.i + 1 - 5);
       s5[n5 - test.i + 1 - 5] = '\0';
       float dE = ((float)(access_s1[n5 - test.i + 1 - 5][i])) * 0.01;
-      printf(
+      snoop_output_printf(
         "%s %3d,%-3d;%3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f + %5.2f + %5.2f + 4.10)  (%5.2f)\n%s&%s\n",
         test.structure,
         i - (n5 - test.i),
@@ -2382,7 +2409,6 @@ snoop_subopt_XS(const char  *s1,
         end_t     = n5 - test.i + 1 - 5;
         and       = end_t + 1;
         pipe      = test.u - test.i + 1;
-        cut_point = end_t + 1;
         char *catseq, *catstruct;/*  *fname;  */
         catseq    = (char *)vrna_alloc(n5 + end_q - begin_q + 2);
         catstruct = (char *)vrna_alloc(n5 + end_q - begin_q + 2);
@@ -2404,7 +2430,7 @@ snoop_subopt_XS(const char  *s1,
                                       i - (n5 - test.u),
                                       name);
 
-        PS_rna_plot_snoop_a(catseq, catstruct, psoutput, relative_access, NULL);
+        PS_rna_plot_snoop_a_cut(catseq, catstruct, psoutput, relative_access, NULL, end_t + 1);
         free(catseq);
         free(catstruct);
         free(relative_access);
@@ -3049,7 +3075,7 @@ find_max_snoop_XS(const char  *s1,
       strncpy(s5, s3 + test.i - 1, n5 - test.i + 1 - 5);
       s5[n5 - test.i + 1 - 5] = '\0';
       float dE = ((float)(access_s1[n5 - test.i + 1 - 5][pos])) * 0.01;
-      printf(
+      snoop_output_printf(
         "%s %3d,%-3d;%3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f + %5.2f + %5.2f + 4.10) (%5.2f)\n%s&%s\n",
         test.structure,
         pos - (n5 - test.i),
@@ -3075,7 +3101,6 @@ find_max_snoop_XS(const char  *s1,
         end_t     = n5 - test.i + 1 - 5;
         and       = end_t + 1;
         pipe      = test.u - test.i + 1;
-        cut_point = end_t + 1;
         char *catseq, *catstruct;/*  *fname;  */
         catseq    = (char *)vrna_alloc(n5 + end_q - begin_q + 2);
         catstruct = (char *)vrna_alloc(n5 + end_q - begin_q + 2);
@@ -3098,7 +3123,7 @@ find_max_snoop_XS(const char  *s1,
                                       pos - (n5 - test.u),
                                       name);
 
-        PS_rna_plot_snoop_a(catseq, catstruct, psoutput, relative_access, NULL);
+        PS_rna_plot_snoop_a_cut(catseq, catstruct, psoutput, relative_access, NULL, end_t + 1);
         free(catseq);
         free(catstruct);
         free(relative_access);
@@ -3272,7 +3297,7 @@ snoopfold_XS(const char *s1,
     }
   }
   if (Emin > 0) {
-    printf("no target found under the constraints chosen\n");
+    snoop_output_printf("no target found under the constraints chosen\n");
     for (i = 0; i <= n1; i++) {
       free(r[i]);
       free(c[i]);
@@ -3734,3 +3759,27 @@ compare(const void  *sub1,
 
   return ((snoopT *)sub1)->j - ((snoopT *)sub2)->j;
 }
+
+
+PUBLIC void
+snoop_output_stream(vrna_cstr_t stream)
+{
+  output_stream = stream;
+}
+
+
+PRIVATE void
+snoop_output_printf(const char  *format,
+                    ...)
+{
+  va_list args;
+
+  va_start(args, format);
+
+  if (output_stream)
+    vrna_cstr_vprintf(output_stream, format, args);
+  else
+    vprintf(format, args);
+
+  va_end(args);
+}
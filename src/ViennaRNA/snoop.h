@@ -2,6 +2,7 @@
 #define VIENNA_RNA_PACKAGE_SNOOP_H
 
 #include <ViennaRNA/datastructures/basic.h>
+#include <ViennaRNA/datastructures/char_stream.h>
 /**
 *** computes snoRNA-RNA interactions in RNAduplex manner
 **/
@@ -285,5 +286,13 @@ snoopT snoopfold_XS(const char  *s1,
                     const int   fullStemEnergy);
 
 
+
+/**
+*** snoop_output_stream sets the stream the snoop functions print their hits to in the
+*** calling thread. Hits are printed to stdout if stream is NULL (default)
+**/
+void snoop_output_stream(vrna_cstr_t stream);
+
+
 extern int snoop_subopt_sorted;
 #endif
@@ -16,12 +16,19 @@
 #include "ViennaRNA/edit_cost.h"
 #include "ViennaRNA/dist_vars.h"
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/dist_matrix.h"
 
 PUBLIC float
 string_edit_distance(swString *T1,
                      swString *T2);
 
 
+PUBLIC float *
+string_edit_distance_matrix(swString  **strings,
+                            int       n,
+                            int       num_threads);
+
+
 PUBLIC swString *
 Make_swString(char *string);
 
@@ -66,6 +73,13 @@ PRIVATE int *alignment[2];       /* contains information from backtracking
                                   *  alignment[0][n] is the node in tree2
                                   *  matching node n in tree1               */
 
+#ifdef _OPENMP
+/* NOTE: all variables are assumed to be uninitialized if they are declared as threadprivate */
+#pragma omp threadprivate(alignment, EditCost)
+#endif
+
+#include "dist_matrix.inc"
+
 
 /*---------------------------------------------------------------------------*/
 
@@ -208,6 +222,107 @@ string_edit_distance(swString *T1,
 }
 
 
+/*---------------------------------------------------------------------------*/
+
+/*
+ *  per-thread scratch memory for string_edit_distance_matrix(), only two
+ *  rows of the distance table are kept since no backtracking is done
+ */
+typedef struct {
+  float *rows[2];
+  int   length;
+} string_scratch;
+
+
+PRIVATE void *
+string_scratch_get(void *data)
+{
+  /* EditCost is threadprivate, so set it for each thread of the batch */
+  if (cost_matrix == 0)
+    EditCost = &UsualCost;
+  else
+    EditCost = &ShapiroCost;
+
+  return vrna_alloc(sizeof(string_scratch));
+}
+
+
+PRIVATE void
+string_scratch_free(void *scratch)
+{
+  string_scratch *s = (string_scratch *)scratch;
+
+  free(s->rows[0]);
+  free(s->rows[1]);
+  free(s);
+}
+
+
+PRIVATE float
+string_pair_dist(void *data,
+                 void *scratch,
+                 int  i,
+                 int  j)
+{
+  int             k, l, length1, length2;
+  float           *prev, *cur, *tmp, minus, plus, change;
+  swString        **strings = (swString **)data;
+  string_scratch  *s        = (string_scratch *)scratch;
+  swString        *T1, *T2;
+
+  /* same argument order as the lower triangle matrix of RNAdistance */
+  T1      = strings[j];
+  T2      = strings[i];
+  length1 = T1[0].sign;
+  length2 = T2[0].sign;
+
+  if (length2 + 1 > s->length) {
+    s->rows[0]  = (float *)vrna_realloc(s->rows[0], sizeof(float) * (length2 + 1));
+    s->rows[1]  = (float *)vrna_realloc(s->rows[1], sizeof(float) * (length2 + 1));
+    s->length   = length2 + 1;
+  }
+
+  prev    = s->rows[0];
+  cur     = s->rows[1];
+  prev[0] = 0.;
+
+  for (l = 1; l <= length2; l++)
+    prev[l] = prev[l - 1] + StrEditCost(0, l, T1, T2);
+
+  for (k = 1; k <= length1; k++) {
+    cur[0] = prev[0] + StrEditCost(k, 0, T1, T2);
+    for (l = 1; l <= length2; l++) {
+      minus   = prev[l] + StrEditCost(k, 0, T1, T2);
+      plus    = cur[l - 1] + StrEditCost(0, l, T1, T2);
+      change  = prev[l - 1] + StrEditCost(k, l, T1, T2);
+      cur[l]  = MIN3(minus, plus, change);
+    }
+    tmp   = prev;
+    prev  = cur;
+    cur   = tmp;
+  }
+
+  return prev[length2];
+}
+
+
+PUBLIC float *
+string_edit_distance_matrix(swString  **strings,
+                            int       n,
+                            int       num_threads)
+{
+  if ((!strings) || (n < 0))
+    return NULL;
+
+  return distance_matrix_tiled(n,
+                               num_threads,
+                               (void *)strings,
+                               &string_scratch_get,
+                               &string_pair_dist,
+                               &string_scratch_free);
+}
+
+
 /*---------------------------------------------------------------------------*/
 
 PRIVATE float
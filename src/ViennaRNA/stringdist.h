@@ -7,6 +7,7 @@
  */
 
 #include <ViennaRNA/dist_vars.h>
+#include <ViennaRNA/dist_matrix.h>
 
 
 /**
@@ -27,4 +28,22 @@ swString *Make_swString(char *string);
 float     string_edit_distance( swString *T1,
                                 swString *T2);
 
+/**
+ *  \brief Calculate the string edit distances between all pairs of strings.
+ *
+ *  The pairs are distributed over @p num_threads parallel threads, each of
+ *  which re-uses its own memory for the dynamic programming tables. Alignments
+ *  are not computed, i.e. #edit_backtrack is ignored.
+ *
+ *  \see dist_matrix.h, vrna_dist_matrix_get(), vrna_file_distance_matrix()
+ *
+ *  \param  strings     The strings as obtained from Make_swString()
+ *  \param  n           The number of strings
+ *  \param  num_threads The number of parallel threads (0 to use as many as cores are available)
+ *  \return             The packed upper triangular distance matrix of size n(n-1)/2 (NULL on error)
+ */
+float     *string_edit_distance_matrix(swString  **strings,
+                                       int       n,
+                                       int       num_threads);
+
 #endif
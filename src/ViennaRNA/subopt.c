@@ -35,6 +35,8 @@
 
 #ifdef _OPENMP
 #include <omp.h>
+#elif VRNA_WITH_PTHREADS
+#include <pthread.h>
 #endif
 
 #define true              1
@@ -98,6 +100,10 @@ PRIVATE vrna_fold_compound_t  *backward_compat_compound = NULL;
 
 #pragma omp threadprivate(backward_compat_compound, backward_compat)
 
+#elif VRNA_WITH_PTHREADS
+
+PRIVATE pthread_mutex_t density_of_states_mtx = PTHREAD_MUTEX_INITIALIZER;
+
 #endif
 
 /*
@@ -925,7 +931,18 @@ vrna_subopt_cb(vrna_fold_compound_t *vc,
       if (e > MAXDOS)
         e = MAXDOS;
 
+      /* concurrent calls, e.g. from threads of the scripting interfaces, share the counts */
+#ifdef _OPENMP
+#pragma omp atomic update
+      density_of_states[e]++;
+#elif VRNA_WITH_PTHREADS
+      pthread_mutex_lock(&density_of_states_mtx);
       density_of_states[e]++;
+      pthread_mutex_unlock(&density_of_states_mtx);
+#else
+      density_of_states[e]++;
+#endif
+
       if (structure_energy <= eprint) {
         char *outstruct = vrna_cut_point_insert(structure, cp);
         cb((const char *)outstruct, structure_energy, data);
@@ -15,6 +15,7 @@
 #include "ViennaRNA/edit_cost.h"
 #include "ViennaRNA/dist_vars.h"
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/dist_matrix.h"
 
 #define PRIVATE  static
 #define PUBLIC
@@ -30,6 +31,12 @@ tree_edit_distance(Tree *T1,
                    Tree *T2);
 
 
+PUBLIC float *
+tree_edit_distance_matrix(Tree  **trees,
+                          int   n,
+                          int   num_threads);
+
+
 PUBLIC void
 print_tree(Tree *t);
 
@@ -38,6 +45,10 @@ PUBLIC void
 free_tree(Tree *t);
 
 
+PRIVATE void
+keyroot_dist(void);
+
+
 PRIVATE void
 tree_dist(int i,
           int j);
@@ -98,13 +109,20 @@ PRIVATE int   *alignment[2];  /* contains numeric information on the alignment:
                                * INDELs have one 0.
                                * alignment[0][0] contains the length of the alignment. */
 
+#ifdef _OPENMP
+/* NOTE: all variables are assumed to be uninitialized if they are declared as threadprivate */
+#pragma omp threadprivate(tree1, tree2, tdist, fdist, alignment, EditCost)
+#endif
+
+#include "dist_matrix.inc"
+
 /*---------------------------------------------------------------------------*/
 
 PUBLIC float
 tree_edit_distance(Tree *T1,
                    Tree *T2)
 {
-  int i1, j1, i, j, dist;
+  int i, dist;
   int n1, n2;
 
   if (cost_matrix == 0)
@@ -125,14 +143,7 @@ tree_edit_distance(Tree *T1,
   tree1 = T1;
   tree2 = T2;
 
-  for (i1 = 1; i1 <= T1->keyroots[0]; i1++) {
-    i = T1->keyroots[i1];
-    for (j1 = 1; j1 <= T2->keyroots[0]; j1++) {
-      j = T2->keyroots[j1];
-
-      tree_dist(i, j);
-    }
-  }
+  keyroot_dist();
 
   if (edit_backtrack) {
     if ((n1 > MNODES) || (n2 > MNODES))
@@ -159,6 +170,123 @@ tree_edit_distance(Tree *T1,
 }
 
 
+/*---------------------------------------------------------------------------*/
+
+/*
+ *  per-thread scratch memory for tree_edit_distance_matrix(), i.e. flat
+ *  storage for the tdist and fdist arrays that grows on demand
+ */
+typedef struct {
+  int     *t_mem;
+  int     *f_mem;
+  int     **t_rows;
+  int     **f_rows;
+  size_t  size;
+  int     rows;
+} tree_scratch;
+
+
+PRIVATE void *
+tree_scratch_get(void *data)
+{
+  /* EditCost is threadprivate, so set it for each thread of the batch */
+  if (cost_matrix == 0)
+    EditCost = &UsualCost;
+  else
+    EditCost = &ShapiroCost;
+
+  return vrna_alloc(sizeof(tree_scratch));
+}
+
+
+PRIVATE void
+tree_scratch_free(void *scratch)
+{
+  tree_scratch *s = (tree_scratch *)scratch;
+
+  free(s->t_mem);
+  free(s->f_mem);
+  free(s->t_rows);
+  free(s->f_rows);
+  free(s);
+}
+
+
+PRIVATE float
+tree_pair_dist(void *data,
+               void *scratch,
+               int  i,
+               int  j)
+{
+  int           k, n1, n2;
+  size_t        size;
+  Tree          **trees = (Tree **)data;
+  tree_scratch  *s      = (tree_scratch *)scratch;
+
+  /* same argument order as the lower triangle matrix of RNAdistance */
+  tree1 = trees[j];
+  tree2 = trees[i];
+  n1    = tree1->postorder_list[0].sons;
+  n2    = tree2->postorder_list[0].sons;
+  size  = (size_t)(n1 + 1) * (size_t)(n2 + 1);
+
+  if (size > s->size) {
+    s->t_mem  = (int *)vrna_realloc(s->t_mem, sizeof(int) * size);
+    s->f_mem  = (int *)vrna_realloc(s->f_mem, sizeof(int) * size);
+    s->size   = size;
+  }
+
+  if (n1 + 1 > s->rows) {
+    s->t_rows = (int **)vrna_realloc(s->t_rows, sizeof(int *) * (n1 + 1));
+    s->f_rows = (int **)vrna_realloc(s->f_rows, sizeof(int *) * (n1 + 1));
+    s->rows   = n1 + 1;
+  }
+
+  /* all entries are written by tree_dist() before they are read, no need to clear */
+  for (k = 0; k <= n1; k++) {
+    s->t_rows[k]  = s->t_mem + (size_t)k * (n2 + 1);
+    s->f_rows[k]  = s->f_mem + (size_t)k * (n2 + 1);
+  }
+
+  tdist = s->t_rows;
+  fdist = s->f_rows;
+
+  keyroot_dist();
+
+  return (float)tdist[n1][n2];
+}
+
+
+PUBLIC float *
+tree_edit_distance_matrix(Tree  **trees,
+                          int   n,
+                          int   num_threads)
+{
+  if ((!trees) || (n < 0))
+    return NULL;
+
+  return distance_matrix_tiled(n,
+                               num_threads,
+                               (void *)trees,
+                               &tree_scratch_get,
+                               &tree_pair_dist,
+                               &tree_scratch_free);
+}
+
+
+/*---------------------------------------------------------------------------*/
+
+PRIVATE void
+keyroot_dist(void)
+{
+  int i1, j1;
+
+  for (i1 = 1; i1 <= tree1->keyroots[0]; i1++)
+    for (j1 = 1; j1 <= tree2->keyroots[0]; j1++)
+      tree_dist(tree1->keyroots[i1], tree2->keyroots[j1]);
+}
+
+
 /*---------------------------------------------------------------------------*/
 
 PRIVATE void
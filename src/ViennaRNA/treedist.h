@@ -7,6 +7,7 @@
  */
 
 #include <ViennaRNA/dist_vars.h>
+#include <ViennaRNA/dist_matrix.h>
 
 /**
  *  \brief Constructs a Tree ( essentially the postorder list ) of the
@@ -29,6 +30,25 @@ float   tree_edit_distance(Tree *T1,
                            Tree *T2);
 
 
+/**
+ *  \brief Calculates the tree edit distances between all pairs of trees.
+ *
+ *  The pairs are distributed over @p num_threads parallel threads, each of
+ *  which re-uses its own memory for the dynamic programming tables. Alignments
+ *  are not computed, i.e. #edit_backtrack is ignored.
+ *
+ *  \see dist_matrix.h, vrna_dist_matrix_get(), vrna_file_distance_matrix()
+ *
+ *  \param trees       The trees as obtained from make_tree()
+ *  \param n           The number of trees
+ *  \param num_threads The number of parallel threads (0 to use as many as cores are available)
+ *  \return            The packed upper triangular distance matrix of size n(n-1)/2 (NULL on error)
+ */
+float   *tree_edit_distance_matrix(Tree **trees,
+                                   int  n,
+                                   int  num_threads);
+
+
 /**
  *  \brief Print a tree (mainly for debugging)
  */
@@ -204,6 +204,36 @@ vrna_aln_copy(const char    **alignment,
               unsigned int  options);
 
 
+/**
+ *  @brief  Collapse redundant sequences of a multiple sequence alignment into weighted representatives
+ *
+ *  Deep alignments often contain many identical, or almost identical sequences. Since
+ *  comparative structure prediction sums up the energy contributions of each individual
+ *  sequence, such redundant rows can be replaced by a single representative that
+ *  is weighted by the number of sequences it stands for. The resulting alignment together
+ *  with its weights may then be passed to vrna_fold_compound_comparative_weighted().
+ *
+ *  Sequences are compared column-wise, ignoring case and treating @p T and @p U as
+ *  identical. Each sequence is assigned to the first representative that differs in
+ *  at most @p max_mismatch columns, or becomes a new representative otherwise. The
+ *  representatives are returned in order of their first occurrence in the input alignment.
+ *
+ *  @note   Only @p max_mismatch = 0, i.e. merging identical sequences only, results in predictions
+ *          that are equivalent to those of the full alignment. Larger values trade accuracy for speed.
+ *
+ *  @see    vrna_fold_compound_comparative_weighted(), vrna_aln_free()
+ *
+ *  @param  alignment     The input sequence alignment (last entry must be @em NULL terminated)
+ *  @param  max_mismatch  The maximum number of mismatching columns for a sequence to be merged into a representative
+ *  @param  weights       A pointer to store the address of the (0-based) array of weights for each representative
+ *  @return               The (@em NULL terminated) alignment of representatives, or @em NULL on error
+ */
+char **
+vrna_aln_collapse(const char    **alignment,
+                  unsigned int  max_mismatch,
+                  unsigned int  **weights);
+
+
 /**
  *  @brief Compute base pair conservation of a consensus structure
  *
@@ -258,6 +288,27 @@ char *
 vrna_aln_consensus_sequence(const char      **alignment,
                             const vrna_md_t *md_p);
 
+
+/**
+ *  @brief  Compute the consensus sequence for a weighted multiple sequence alignment
+ *
+ *  Same as vrna_aln_consensus_sequence() but each sequence @p s contributes @p weights[s]
+ *  times to the nucleotide frequencies of a column. For an alignment of representatives
+ *  obtained from vrna_aln_collapse(), this yields the consensus sequence of the full
+ *  (uncollapsed) alignment.
+ *
+ *  @see    vrna_aln_consensus_sequence(), vrna_aln_collapse(), vrna_fold_compound_comparative_weighted()
+ *
+ *  @param  alignment   The input sequence alignment (last entry must be @em NULL terminated)
+ *  @param  weights     The (0-based) weight of each sequence (Maybe @em NULL for unit weights)
+ *  @param  md_p        Model details that specify known nucleotides (Maybe @em NULL)
+ *  @return             The consensus sequence of the alignment, i.e. the most frequent nucleotide for each alignment column
+ */
+char *
+vrna_aln_consensus_sequence_weighted(const char         **alignment,
+                                     const unsigned int *weights,
+                                     const vrna_md_t    *md_p);
+
 /**
  *  @brief  Compute the Most Informative Sequence (MIS) for a given multiple sequence alignment
  *
@@ -167,6 +167,12 @@ void vrna_init_rand(void);
  *  This variable is used by vrna_urn(). These should be set to some
  *  random number seeds before the first call to vrna_urn().
  *
+ *  @note Only the first thread that calls vrna_urn() draws from this state.
+ *        Every other thread without a private stream, see vrna_urn_stream(),
+ *        draws from its own default stream, which is derived from the value
+ *        of #xsubi at the first call of vrna_urn() and the order in which the
+ *        threads draw their first random number.
+ *
  *  @see vrna_urn()
  */
 extern unsigned short xsubi[3];
@@ -181,6 +187,21 @@ extern unsigned short xsubi[3];
 double vrna_urn(void);
 
 
+/**
+ *  @brief  Let the calling thread draw its random numbers from a private stream
+ *
+ *  Once set, vrna_urn() and vrna_int_urn() in the calling thread use the
+ *  48 bit state @p state instead of their default stream, see #xsubi. Other
+ *  threads are not affected. Pass NULL to switch back to the default stream.
+ *
+ *  @note Without @e erand48() support, the private stream is ignored.
+ *
+ *  @see  vrna_urn()
+ *  @param  state   The 48 bit state of the stream (3 unsigned shorts), or NULL
+ */
+void vrna_urn_stream(unsigned short *state);
+
+
 /**
  *  @brief Generates a pseudo random integer in a specified range
  *
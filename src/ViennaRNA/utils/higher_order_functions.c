@@ -15,6 +15,11 @@ typedef int (proto_fun_zip_reduce)(const int  *a,
                                    int        size);
 
 
+typedef int (proto_fun_zip_count)(const short *a,
+                                  const short *b,
+                                  int         size);
+
+
 /*
  #################################
  # PRIVATE FUNCTION DECLARATIONS #
@@ -31,6 +36,17 @@ fun_zip_add_min_default(const int *e1,
                         int       count);
 
 
+static int zip_count_shared_dispatcher(const short  *a,
+                                       const short  *b,
+                                       int          size);
+
+
+static int
+fun_zip_count_shared_default(const short  *a,
+                             const short  *b,
+                             int          count);
+
+
 #if VRNA_WITH_SIMD_AVX512
 int
 vrna_fun_zip_add_min_avx512(const int *e1,
@@ -38,6 +54,12 @@ vrna_fun_zip_add_min_avx512(const int *e1,
                             int       count);
 
 
+int
+vrna_fun_zip_count_shared_avx512(const short  *a,
+                                 const short  *b,
+                                 int          count);
+
+
 #endif
 
 #if VRNA_WITH_SIMD_SSE41
@@ -47,10 +69,17 @@ vrna_fun_zip_add_min_sse41(const int  *e1,
                            int        count);
 
 
+int
+vrna_fun_zip_count_shared_sse41(const short *a,
+                                const short *b,
+                                int         count);
+
+
 #endif
 
 
 static proto_fun_zip_reduce *fun_zip_add_min = &zip_add_min_dispatcher;
+static proto_fun_zip_count  *fun_zip_count_shared = &zip_count_shared_dispatcher;
 
 
 /*
@@ -61,14 +90,16 @@ static proto_fun_zip_reduce *fun_zip_add_min = &zip_add_min_dispatcher;
 PUBLIC void
 vrna_fun_dispatch_disable(void)
 {
-  fun_zip_add_min = &fun_zip_add_min_default;
+  fun_zip_add_min       = &fun_zip_add_min_default;
+  fun_zip_count_shared  = &fun_zip_count_shared_default;
 }
 
 
 PUBLIC void
 vrna_fun_dispatch_enable(void)
 {
-  fun_zip_add_min = &zip_add_min_dispatcher;
+  fun_zip_add_min       = &zip_add_min_dispatcher;
+  fun_zip_count_shared  = &zip_count_shared_dispatcher;
 }
 
 
@@ -81,6 +112,15 @@ vrna_fun_zip_add_min(const int  *e1,
 }
 
 
+PUBLIC int
+vrna_fun_zip_count_shared(const short *a,
+                          const short *b,
+                          int         count)
+{
+  return (*fun_zip_count_shared)(a, b, count);
+}
+
+
 /*
  #################################
  # STATIC helper functions below #
@@ -136,3 +176,49 @@ fun_zip_add_min_default(const int *e1,
 
   return decomp;
 }
+
+
+/* zip_count_shared() dispatcher */
+static int
+zip_count_shared_dispatcher(const short *a,
+                            const short *b,
+                            int         size)
+{
+  unsigned int features = vrna_cpu_simd_capabilities();
+
+#if VRNA_WITH_SIMD_AVX512
+  if (features & VRNA_CPU_SIMD_AVX512F) {
+    fun_zip_count_shared = &vrna_fun_zip_count_shared_avx512;
+    goto exec_fun_zip_count_shared;
+  }
+
+#endif
+
+#if VRNA_WITH_SIMD_SSE41
+  if (features & VRNA_CPU_SIMD_SSE41) {
+    fun_zip_count_shared = &vrna_fun_zip_count_shared_sse41;
+    goto exec_fun_zip_count_shared;
+  }
+
+#endif
+
+  fun_zip_count_shared = &fun_zip_count_shared_default;
+
+exec_fun_zip_count_shared:
+
+  return (*fun_zip_count_shared)(a, b, size);
+}
+
+
+static int
+fun_zip_count_shared_default(const short  *a,
+                             const short  *b,
+                             int          count)
+{
+  int i, shared = 0;
+
+  for (i = 0; i < count; i++)
+    shared += (a[i] == b[i]) & (a[i] != 0);
+
+  return shared;
+}
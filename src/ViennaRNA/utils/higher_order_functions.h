@@ -15,4 +15,10 @@ vrna_fun_zip_add_min(const int  *e1,
                      int        count);
 
 
+int
+vrna_fun_zip_count_shared(const short *a,
+                          const short *b,
+                          int         count);
+
+
 #endif
@@ -48,3 +48,35 @@ vrna_fun_zip_add_min_avx512(const int *e1,
 
   return decomp;
 }
+
+
+PUBLIC int
+vrna_fun_zip_count_shared_avx512(const short  *a,
+                                 const short  *b,
+                                 int          count)
+{
+  int     i       = 0;
+  int     shared  = 0;
+
+  __m512i ones  = _mm512_set1_epi32(1);
+  __m512i acc   = _mm512_setzero_si512();
+
+  /* AVX512F lacks 16-bit comparisons, so we widen to 32-bit lanes */
+  for (i = 0; i < count - 15; i += 16) {
+    __m512i   x = _mm512_cvtepi16_epi32(_mm256_loadu_si256((__m256i *)&a[i]));
+    __m512i   y = _mm512_cvtepi16_epi32(_mm256_loadu_si256((__m256i *)&b[i]));
+
+    /* mask of entries that are equal in x and y but non-zero */
+    __mmask16 mask = _kand_mask16(_mm512_cmpeq_epi32_mask(x, y),
+                                  _mm512_test_epi32_mask(x, x));
+
+    acc = _mm512_mask_add_epi32(acc, mask, acc, ones);
+  }
+
+  shared = _mm512_reduce_add_epi32(acc);
+
+  for (; i < count; i++)
+    shared += (a[i] == b[i]) & (a[i] != 0);
+
+  return shared;
+}
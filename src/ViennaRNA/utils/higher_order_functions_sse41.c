@@ -15,6 +15,10 @@ static int
 horizontal_min_Vec4i(__m128i x);
 
 
+static int
+horizontal_add_Vec8s(__m128i x);
+
+
 PUBLIC int
 vrna_fun_zip_add_min_sse41(const int  *e1,
                            const int  *e2,
@@ -69,3 +73,53 @@ horizontal_min_Vec4i(__m128i x)
 
   return _mm_cvtsi128_si32(min4);
 }
+
+
+PUBLIC int
+vrna_fun_zip_count_shared_sse41(const short *a,
+                                const short *b,
+                                int         count)
+{
+  int     i       = 0;
+  int     shared  = 0;
+
+  __m128i zero  = _mm_setzero_si128();
+  __m128i acc   = _mm_setzero_si128();
+
+  while (i < count - 7) {
+    /* limit the number of iterations per accumulation to prevent 16-bit overflows */
+    int block = MIN2(count - 7, i + 8 * 32767);
+
+    for (; i < block; i += 8) {
+      __m128i x = _mm_loadu_si128((__m128i *)&a[i]);
+      __m128i y = _mm_loadu_si128((__m128i *)&b[i]);
+
+      /* mask of entries that are equal in x and y but non-zero */
+      __m128i mask = _mm_andnot_si128(_mm_cmpeq_epi16(x, zero),
+                                      _mm_cmpeq_epi16(x, y));
+
+      /* masked entries are -1, so subtracting them counts matches */
+      acc = _mm_sub_epi16(acc, mask);
+    }
+
+    shared  += horizontal_add_Vec8s(acc);
+    acc     = _mm_setzero_si128();
+  }
+
+  for (; i < count; i++)
+    shared += (a[i] == b[i]) & (a[i] != 0);
+
+  return shared;
+}
+
+
+/* sum of 8 unsigned 16-bit integers */
+static int
+horizontal_add_Vec8s(__m128i x)
+{
+  __m128i sum1  = _mm_madd_epi16(x, _mm_set1_epi16(1));
+  __m128i sum2  = _mm_add_epi32(sum1, _mm_shuffle_epi32(sum1, _MM_SHUFFLE(1, 0, 3, 2)));
+  __m128i sum3  = _mm_add_epi32(sum2, _mm_shuffle_epi32(sum2, _MM_SHUFFLE(2, 3, 0, 1)));
+
+  return _mm_cvtsi128_si32(sum3);
+}
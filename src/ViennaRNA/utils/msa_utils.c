@@ -52,6 +52,21 @@ copy_alignment(const char   **alignment,
                unsigned int options);
 
 
+PRIVATE char *
+collapse_key(const char *sequence);
+
+
+PRIVATE int
+compare_collapse_keys(const void  *a,
+                      const void  *b);
+
+
+PRIVATE unsigned int
+collapse_mismatches(const char    *s1,
+                    const char    *s2,
+                    unsigned int  max_mismatch);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -125,6 +140,7 @@ vrna_aln_pinfo(vrna_fold_compound_t *vc,
   short         **S       = vc->S;
   char          **AS      = vc->sequences;
   int           n_seq     = vc->n_seq;
+  unsigned int  *w        = vc->seq_weights;
   int           n         = vc->length;
   int           *my_iindx = vc->iindx;
   FLT_OR_DBL    *probs    = vc->exp_matrices->probs;
@@ -161,7 +177,7 @@ vrna_aln_pinfo(vrna_fold_compound_t *vc,
           if ((AS[s][i - 1] == '~') || (AS[s][j - 1] == '~'))
             type = 7;
 
-          pi[num_p].bp[type]++;
+          pi[num_p].bp[type] += w[s];
         }
         if (ptable)
           pi[num_p].comp = (ptable[i] == j) ? 1 : 0;
@@ -410,6 +426,105 @@ vrna_aln_copy(const char    **alignment,
 }
 
 
+struct collapse_entry {
+  char          *key;
+  unsigned int  idx;
+};
+
+
+PUBLIC char **
+vrna_aln_collapse(const char    **alignment,
+                  unsigned int  max_mismatch,
+                  unsigned int  **weights)
+{
+  char                  **keys, **output;
+  unsigned int          n, s, r, n_seq, n_rep, *rep, *w;
+  struct collapse_entry *entries;
+
+  if ((!alignment) || (!alignment[0]) || (!weights))
+    return NULL;
+
+  n = strlen(alignment[0]);
+
+  for (n_seq = 0; alignment[n_seq]; n_seq++)
+    if (strlen(alignment[n_seq]) != n) {
+      vrna_message_warning("vrna_aln_collapse: "
+                           "unequal sequence lengths in alignment");
+      return NULL;
+    }
+
+  keys  = (char **)vrna_alloc(sizeof(char *) * n_seq);
+  rep   = (unsigned int *)vrna_alloc(sizeof(unsigned int) * n_seq);
+
+  for (s = 0; s < n_seq; s++)
+    keys[s] = collapse_key(alignment[s]);
+
+  if (max_mismatch == 0) {
+    /* identical sequences only, group them by sorting */
+    entries = (struct collapse_entry *)vrna_alloc(sizeof(struct collapse_entry) * n_seq);
+
+    for (s = 0; s < n_seq; s++) {
+      entries[s].key  = keys[s];
+      entries[s].idx  = s;
+    }
+
+    qsort(entries, n_seq, sizeof(struct collapse_entry), compare_collapse_keys);
+
+    /* the first occurrence of each sequence becomes its representative */
+    for (r = s = 0; s < n_seq; s++) {
+      if (strcmp(entries[s].key, entries[r].key))
+        r = s;
+
+      rep[entries[s].idx] = entries[r].idx;
+    }
+
+    free(entries);
+  } else {
+    /* greedy assignment to the first sufficiently similar representative */
+    for (s = 0; s < n_seq; s++) {
+      rep[s] = s;
+      for (r = 0; r < s; r++) {
+        if ((rep[r] == r) &&
+            (collapse_mismatches(keys[r], keys[s], max_mismatch) <= max_mismatch)) {
+          rep[s] = r;
+          break;
+        }
+      }
+    }
+  }
+
+  /* count the representatives and their weights */
+  w = (unsigned int *)vrna_alloc(sizeof(unsigned int) * n_seq);
+
+  for (s = 0; s < n_seq; s++)
+    w[rep[s]]++;
+
+  for (n_rep = s = 0; s < n_seq; s++)
+    if (rep[s] == s)
+      n_rep++;
+
+  output    = (char **)vrna_alloc(sizeof(char *) * (n_rep + 1));
+  *weights  = (unsigned int *)vrna_alloc(sizeof(unsigned int) * (n_rep + 1));
+
+  for (r = s = 0; s < n_seq; s++)
+    if (rep[s] == s) {
+      output[r]       = strdup(alignment[s]);
+      (*weights)[r++] = w[s];
+    }
+
+  output[r] = NULL;
+
+  for (s = 0; s < n_seq; s++)
+    free(keys[s]);
+
+  free(keys);
+  free(rep);
+  free(w);
+
+  return output;
+}
+
+
 PUBLIC float *
 vrna_aln_conservation_struct(const char       **alignment,
                              const char       *structure,
@@ -542,6 +657,15 @@ vrna_aln_conservation_col(const char      **alignment,
 PUBLIC char *
 vrna_aln_consensus_sequence(const char      **alignment,
                             const vrna_md_t *md_p)
+{
+  return vrna_aln_consensus_sequence_weighted(alignment, NULL, md_p);
+}
+
+
+PUBLIC char *
+vrna_aln_consensus_sequence_weighted(const char         **alignment,
+                                     const unsigned int *weights,
+                                     const vrna_md_t    *md_p)
 {
   /* simple consensus sequence (most frequent character) */
   char          *consensus;
@@ -575,13 +699,14 @@ vrna_aln_consensus_sequence(const char      **alignment,
       consensus = (char *)vrna_alloc((n + 1) * sizeof(char));
 
       for (i = 0; i < n; i++) {
-        int c, fm;
-        int freq[8] = {
+        unsigned int  c, fm;
+        unsigned int  freq[8] = {
           0, 0, 0, 0, 0, 0, 0, 0
         };
 
+        /* each sequence counts as many times as it is represented */
         for (s = 0; s < n_seq; s++)
-          freq[vrna_nucleotide_encode(alignment[s][i], &md)]++;
+          freq[vrna_nucleotide_encode(alignment[s][i], &md)] += (weights) ? weights[s] : 1;
 
         for (s = c = fm = 0; s < 8; s++) /* find the most frequent char */
           if (freq[s] > fm) {
@@ -723,6 +848,54 @@ copy_alignment(const char   **alignment,
 }
 
 
+PRIVATE char *
+collapse_key(const char *sequence)
+{
+  char *key;
+
+  key = strdup(sequence);
+
+  vrna_seq_toupper(key);
+  vrna_seq_toRNA(key);
+
+  return key;
+}
+
+
+PRIVATE int
+compare_collapse_keys(const void  *a,
+                      const void  *b)
+{
+  int                   c;
+  struct collapse_entry *e1, *e2;
+
+  e1  = (struct collapse_entry *)a;
+  e2  = (struct collapse_entry *)b;
+  c   = strcmp(e1->key, e2->key);
+
+  if (c == 0)
+    c = (e1->idx < e2->idx) ? -1 : 1;
+
+  return c;
+}
+
+
+PRIVATE unsigned int
+collapse_mismatches(const char    *s1,
+                    const char    *s2,
+                    unsigned int  max_mismatch)
+{
+  unsigned int d;
+
+  /* stop counting as soon as the threshold is exceeded */
+  for (d = 0; (*s1) && (d <= max_mismatch); s1++, s2++)
+    if (*s1 != *s2)
+      d++;
+
+  return d;
+}
+
+
 /*###########################################*/
 /*# deprecated functions below              #*/
 /*###########################################*/
@@ -0,0 +1,359 @@
+/*
+ *  ViennaRNA/utils/structure_sets.c
+ *
+ *  Packed sets of secondary structures for fast base pair distance
+ *  computations, centroids, and medoids
+ *
+ *              Vienna RNA package
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/structures.h"
+#include "ViennaRNA/utils/higher_order_functions.h"
+#include "ViennaRNA/dist_matrix.h"
+
+#ifdef __GNUC__
+# define INLINE inline
+#else
+# define INLINE
+#endif
+
+/* number of positions per work package in centroid computations */
+#define CENTROID_CHUNK  256
+
+/*
+ #################################
+ # PRIVATE FUNCTION DECLARATIONS #
+ #################################
+ */
+PRIVATE INLINE int
+set_bp_distance(const vrna_structure_set_t  *set1,
+                unsigned int                i,
+                const vrna_structure_set_t  *set2,
+                unsigned int                j);
+
+
+PRIVATE int
+get_num_threads(int num_threads);
+
+
+/*
+ #################################
+ # BEGIN OF FUNCTION DEFINITIONS #
+ #################################
+ */
+PUBLIC vrna_structure_set_t *
+vrna_structure_set(const char **structures)
+{
+  unsigned int          i, s, num, length;
+  short                 *pt, *partners;
+  vrna_structure_set_t  *set;
+
+  if ((!structures) || (!structures[0])) {
+    vrna_message_warning("vrna_structure_set: no structures provided");
+    return NULL;
+  }
+
+  length = strlen(structures[0]);
+  if (length > SHRT_MAX) {
+    vrna_message_warning("vrna_structure_set: structures too long");
+    return NULL;
+  }
+
+  for (num = 0; structures[num]; num++)
+    if (strlen(structures[num]) != length) {
+      vrna_message_warning("vrna_structure_set: "
+                           "structure %u differs in length from the first one",
+                           num + 1);
+      return NULL;
+    }
+
+  set         = (vrna_structure_set_t *)vrna_alloc(sizeof(vrna_structure_set_t));
+  set->length = length;
+  set->num    = num;
+  /* pad each structure to full SIMD vectors, trailing zeros never count as shared pairs */
+  set->stride   = ((length + 15) / 16) * 16;
+  set->partners = (short *)calloc((size_t)set->stride * num + 1, sizeof(short));
+  set->pairs    = (unsigned int *)vrna_alloc(sizeof(unsigned int) * num);
+
+  if (!set->partners) {
+    vrna_message_warning("vrna_structure_set: not enough memory for %u structures", num);
+    free(set->pairs);
+    free(set);
+    return NULL;
+  }
+
+  for (s = 0; s < num; s++) {
+    pt        = vrna_ptable(structures[s]);
+    partners  = set->partners + (size_t)s * set->stride;
+
+    for (i = 1; i <= length; i++)
+      if (pt[i] > (short)i) {
+        partners[i - 1] = pt[i];
+        set->pairs[s]++;
+      }
+
+    free(pt);
+  }
+
+  return set;
+}
+
+
+PUBLIC void
+vrna_structure_set_free(vrna_structure_set_t *set)
+{
+  if (set) {
+    free(set->partners);
+    free(set->pairs);
+    free(set);
+  }
+}
+
+
+PUBLIC int *
+vrna_structure_set_bp_distances(const vrna_structure_set_t  *set1,
+                                const vrna_structure_set_t  *set2,
+                                int                         num_threads)
+{
+  int           i;
+  unsigned int  n1, n2;
+  size_t        size;
+  int           *distances;
+
+  if (!set1)
+    return NULL;
+
+  if ((set2) && (set2->length != set1->length)) {
+    vrna_message_warning("vrna_structure_set_bp_distances: "
+                         "structure sets differ in length");
+    return NULL;
+  }
+
+  n1    = set1->num;
+  n2    = (set2) ? set2->num : set1->num;
+  size  = (set2) ? (size_t)n1 * n2 : ((size_t)n1 * (n1 - 1)) / 2;
+
+  distances = (int *)calloc(size + 1, sizeof(int));
+  if (!distances) {
+    vrna_message_warning("vrna_structure_set_bp_distances: "
+                         "not enough memory for %u x %u distances",
+                         n1, n2);
+    return NULL;
+  }
+
+  num_threads = get_num_threads(num_threads);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+#endif
+  for (i = 0; i < (int)n1; i++) {
+    unsigned int j;
+
+    if (set2) {
+      int *row = distances + (size_t)i * n2;
+      for (j = 0; j < n2; j++)
+        row[j] = set_bp_distance(set1, i, set2, j);
+    } else {
+      for (j = i + 1; j < n1; j++)
+        distances[VRNA_DIST_MATRIX_INDEX(n1, i, j)] = set_bp_distance(set1, i, set1, j);
+    }
+  }
+
+  return distances;
+}
+
+
+PUBLIC char *
+vrna_structure_set_centroid(const vrna_structure_set_t  *set,
+                            double                      *dist,
+                            int                         num_threads)
+{
+  int                   c, num_chunks;
+  unsigned int          s;
+  char                  *structure;
+  const char            *db[2];
+  unsigned long         sum;
+  vrna_structure_set_t  *centroid;
+
+  if ((!set) || (set->num == 0))
+    return NULL;
+
+  structure = (char *)vrna_alloc(sizeof(char) * (set->length + 1));
+  memset(structure, '.', set->length);
+
+  num_threads = get_num_threads(num_threads);
+  num_chunks  = (set->length + CENTROID_CHUNK - 1) / CENTROID_CHUNK;
+
+  /*
+   *  find the majority partner of each position with the Boyer-Moore
+   *  majority vote, and verify it in a second pass over all structures
+   */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads) private(s)
+#endif
+  for (c = 0; c < num_chunks; c++) {
+    unsigned int  k, k_max, cnt[CENTROID_CHUNK];
+    short         cand[CENTROID_CHUNK];
+    const short   *row;
+
+    k_max = MIN2(set->length - c * CENTROID_CHUNK, CENTROID_CHUNK);
+    memset(cnt, 0, sizeof(cnt));
+    memset(cand, 0, sizeof(cand));
+
+    for (s = 0; s < set->num; s++) {
+      row = set->partners + (size_t)s * set->stride + c * CENTROID_CHUNK;
+      for (k = 0; k < k_max; k++) {
+        if (cnt[k] == 0) {
+          cand[k] = row[k];
+          cnt[k]  = 1;
+        } else if (cand[k] == row[k]) {
+          cnt[k]++;
+        } else {
+          cnt[k]--;
+        }
+      }
+    }
+
+    memset(cnt, 0, sizeof(cnt));
+
+    for (s = 0; s < set->num; s++) {
+      row = set->partners + (size_t)s * set->stride + c * CENTROID_CHUNK;
+      for (k = 0; k < k_max; k++)
+        cnt[k] += (row[k] == cand[k]);
+    }
+
+    /* pairs with frequency above 0.5 are always compatible */
+    for (k = 0; k < k_max; k++)
+      if ((cand[k] != 0) && (2 * cnt[k] > set->num)) {
+        structure[c * CENTROID_CHUNK + k] = '(';
+        structure[cand[k] - 1]            = ')';
+      }
+  }
+
+  if (dist) {
+    db[0]     = structure;
+    db[1]     = NULL;
+    centroid  = vrna_structure_set(db);
+    sum       = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(num_threads) reduction(+:sum)
+#endif
+    for (c = 0; c < (int)set->num; c++)
+      sum += set_bp_distance(centroid, 0, set, c);
+
+    *dist = (double)sum / set->num;
+
+    vrna_structure_set_free(centroid);
+  }
+
+  return structure;
+}
+
+
+PUBLIC int
+vrna_structure_set_medoid(const vrna_structure_set_t  *set,
+                          double                      *dist,
+                          int                         num_threads)
+{
+  int           i, medoid;
+  unsigned int  n;
+  unsigned long *sums;
+
+  if ((!set) || (set->num == 0))
+    return -1;
+
+  n     = set->num;
+  sums  = (unsigned long *)vrna_alloc(sizeof(unsigned long) * n);
+
+  num_threads = get_num_threads(num_threads);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(num_threads)
+#endif
+  {
+    unsigned int  j;
+    int           d;
+    unsigned long *local = (unsigned long *)vrna_alloc(sizeof(unsigned long) * n);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (i = 0; i < (int)n; i++)
+      for (j = i + 1; j < n; j++) {
+        d         = set_bp_distance(set, i, set, j);
+        local[i]  += d;
+        local[j]  += d;
+      }
+
+    /* integer sums, so the order of accumulation does not matter */
+#ifdef _OPENMP
+#pragma omp critical (structure_set_medoid)
+#endif
+    for (j = 0; j < n; j++)
+      sums[j] += local[j];
+
+    free(local);
+  }
+
+  for (medoid = 0, i = 1; i < (int)n; i++)
+    if (sums[i] < sums[medoid])
+      medoid = i;
+
+  if (dist)
+    *dist = (double)sums[medoid] / n;
+
+  free(sums);
+
+  return medoid;
+}
+
+
+/*
+ #################################
+ # STATIC helper functions below #
+ #################################
+ */
+PRIVATE INLINE int
+set_bp_distance(const vrna_structure_set_t  *set1,
+                unsigned int                i,
+                const vrna_structure_set_t  *set2,
+                unsigned int                j)
+{
+  int shared;
+
+  shared = vrna_fun_zip_count_shared(set1->partners + (size_t)i * set1->stride,
+                                     set2->partners + (size_t)j * set2->stride,
+                                     (int)set1->stride);
+
+  return (int)(set1->pairs[i] + set2->pairs[j]) - 2 * shared;
+}
+
+
+PRIVATE int
+get_num_threads(int num_threads)
+{
+#ifdef _OPENMP
+  if (num_threads <= 0)
+    num_threads = omp_get_max_threads();
+
+#else
+  num_threads = 1;
+#endif
+
+  return num_threads;
+}
@@ -44,6 +44,13 @@ typedef struct vrna_hx_s vrna_hx_t;
 typedef struct vrna_elem_prob_s vrna_ep_t;
 
 
+/**
+ *  @brief Convenience typedef for data structure #vrna_structure_set_s
+ *  @ingroup  struct_utils_sets
+ */
+typedef struct vrna_structure_set_s vrna_structure_set_t;
+
+
 /**
  *  @addtogroup struct_utils_dot_bracket
  *  @{
@@ -469,6 +476,113 @@ vrna_dist_mountain(const char   *str1,
                    unsigned int p);
 
 
+/**
+ *  @addtogroup struct_utils_sets
+ *  @{
+ *  @brief  Packed sets of secondary structures for fast all-vs-all comparisons
+ *
+ *  Large sets of structures, e.g. Boltzmann samples, are stored as one contiguous
+ *  block of 16-bit pair partner entries, where only the 5' end of a base pair
+ *  holds its partner. The base pair distance of two structures then reduces to
+ *  counting identical non-zero entries, which is done with SIMD instructions
+ *  whenever the CPU supports them.
+ */
+
+/**
+ *  @brief  A packed set of secondary structures of equal length
+ */
+struct vrna_structure_set_s {
+  unsigned int  length;     /**< @brief Length of the structures */
+  unsigned int  num;        /**< @brief Number of structures in the set */
+  unsigned int  stride;     /**< @brief Number of entries per structure in vrna_structure_set_s.partners */
+  short         *partners;  /**< @brief For each structure and position the partner @p j of a pair @p (i,j) with @p i<j at position @p i-1, 0 otherwise */
+  unsigned int  *pairs;     /**< @brief Number of base pairs of each structure */
+};
+
+
+/**
+ *  @brief  Create a packed set of secondary structures
+ *
+ *  @see vrna_structure_set_free(), vrna_structure_set_bp_distances()
+ *
+ *  @param  structures  A @p NULL terminated list of structures in dot-bracket notation, all of the same length
+ *  @return             The packed structure set (@p NULL on error)
+ */
+vrna_structure_set_t *
+vrna_structure_set(const char **structures);
+
+
+/**
+ *  @brief  Free memory occupied by a packed set of secondary structures
+ */
+void
+vrna_structure_set_free(vrna_structure_set_t *set);
+
+
+/**
+ *  @brief  Compute the base pair distances between all structures of two sets
+ *
+ *  If @p set2 is @p NULL, the distances between all pairs of structures in @p set1
+ *  are returned as packed upper triangular matrix, see #VRNA_DIST_MATRIX_INDEX().
+ *  Otherwise, the result is a @p set1->num times @p set2->num matrix in row-major
+ *  order. Rows are distributed over @p num_threads parallel threads.
+ *
+ *  @see vrna_bp_distance()
+ *
+ *  @param  set1        The first set of structures
+ *  @param  set2        The second set of structures (may be @p NULL)
+ *  @param  num_threads The number of parallel threads (0 to use as many as cores are available)
+ *  @return             The base pair distances (@p NULL on error)
+ */
+int *
+vrna_structure_set_bp_distances(const vrna_structure_set_t  *set1,
+                                const vrna_structure_set_t  *set2,
+                                int                         num_threads);
+
+
+/**
+ *  @brief  Get the base pair distance centroid of a set of structures
+ *
+ *  The centroid consists of all base pairs that are present in more than half of
+ *  the structures, and minimizes the sum of base pair distances to all structures
+ *  in the set.
+ *
+ *  @see vrna_centroid(), vrna_structure_set_medoid()
+ *
+ *  @param  set         The set of structures
+ *  @param  dist        A pointer to store the average base pair distance of the centroid to the set (may be @p NULL)
+ *  @param  num_threads The number of parallel threads (0 to use as many as cores are available)
+ *  @return             The centroid structure in dot-bracket notation (@p NULL on error)
+ */
+char *
+vrna_structure_set_centroid(const vrna_structure_set_t  *set,
+                            double                      *dist,
+                            int                         num_threads);
+
+
+/**
+ *  @brief  Get the base pair distance medoid of a set of structures
+ *
+ *  The medoid is the structure of the set with the smallest sum of base pair
+ *  distances to all other structures in the set. Ties are resolved in favor of
+ *  the smallest index.
+ *
+ *  @see vrna_structure_set_centroid()
+ *
+ *  @param  set         The set of structures
+ *  @param  dist        A pointer to store the average base pair distance of the medoid to the set (may be @p NULL)
+ *  @param  num_threads The number of parallel threads (0 to use as many as cores are available)
+ *  @return             The index of the medoid structure (-1 on error)
+ */
+int
+vrna_structure_set_medoid(const vrna_structure_set_t  *set,
+                          double                      *dist,
+                          int                         num_threads);
+
+
+/**@}*/
+
+
 /**
  *  @brief Make a reference base pair count matrix
  *
@@ -0,0 +1,313 @@
+/*
+ *  ViennaRNA/utils/timing.c
+ *
+ *  Per-phase timings and counters for the computations of a fold compound
+ *
+ *  (c) 2019 - Vienna RNA package
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#if VRNA_WITH_PTHREADS
+# include <pthread.h>
+#endif
+
+#include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/fold_compound.h"
+#include "ViennaRNA/utils/timing.h"
+#include "ViennaRNA/utils/timing_hooks.h"
+
+/*
+ #################################
+ # PRIVATE VARIABLES             #
+ #################################
+ */
+PRIVATE const char *phase_names[VRNA_TIMING_PHASES] = {
+  "parameter preparation",
+  "matrix allocation",
+  "MFE fill",
+  "MFE backtracking",
+  "PF fill (inside)",
+  "PF outside (bpp)",
+  "stochastic sampling"
+};
+
+#if defined(VRNA_WITH_TIMING) && VRNA_WITH_PTHREADS
+/* threads may draw samples from the same fold compound concurrently */
+PRIVATE pthread_mutex_t timing_mtx = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/*
+ #################################
+ # PRIVATE FUNCTION DECLARATIONS #
+ #################################
+ */
+#ifdef VRNA_WITH_TIMING
+
+PRIVATE double
+wall_time(void);
+
+
+PRIVATE double
+cpu_time(void);
+
+
+#endif
+
+/*
+ #################################
+ # BEGIN OF FUNCTION DEFINITIONS #
+ #################################
+ */
+PUBLIC int
+vrna_timing_enable(vrna_fold_compound_t *fc,
+                   int                  enable)
+{
+  if (!fc)
+    return 0;
+
+  if (!enable) {
+    free(fc->timing);
+    fc->timing = NULL;
+    return 1;
+  }
+
+#ifdef VRNA_WITH_TIMING
+  if (!fc->timing) {
+    fc->timing = (vrna_timing_t *)vrna_alloc(sizeof(vrna_timing_t));
+    vrna_timing_mx_current(fc);
+  }
+
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+
+PUBLIC void
+vrna_timing_reset(vrna_fold_compound_t *fc)
+{
+  if ((fc) && (fc->timing))
+    memset(fc->timing, 0, sizeof(vrna_timing_t));
+}
+
+
+PUBLIC const vrna_timing_t *
+vrna_timing(vrna_fold_compound_t *fc)
+{
+  return (fc) ? fc->timing : NULL;
+}
+
+
+PUBLIC const char *
+vrna_timing_phase_name(vrna_timing_phase_e phase)
+{
+  if (((int)phase < 0) || ((int)phase >= VRNA_TIMING_PHASES))
+    return "unknown";
+
+  return phase_names[phase];
+}
+
+
+PUBLIC void
+vrna_timing_print(FILE                  *fp,
+                  vrna_fold_compound_t  *fc,
+                  const char            *title)
+{
+  unsigned int        i;
+  const vrna_timing_t *t;
+
+  if ((!fp) || (!fc) || (!(t = fc->timing)))
+    return;
+
+  if (title)
+    fprintf(fp, "%s\n", title);
+
+  fprintf(fp,
+          "%-22s %8s %12s %12s %14s %12s\n",
+          "phase", "calls", "wall [s]", "cpu [s]", "nominal cells", "cells/s");
+
+  for (i = 0; i < VRNA_TIMING_PHASES; i++) {
+    if (t->calls[i] == 0)
+      continue;
+
+    fprintf(fp,
+            "%-22s %8u %12.6f %12.6f",
+            phase_names[i],
+            t->calls[i],
+            t->wall[i],
+            t->cpu[i]);
+
+    if (t->cells[i] > 0)
+      fprintf(fp,
+              " %14.0f %12.4g\n",
+              t->cells[i],
+              (t->wall[i] > 0) ? t->cells[i] / t->wall[i] : 0.);
+    else
+      fprintf(fp, " %14s %12s\n", "-", "-");
+  }
+
+  if (t->num_matrices > 0) {
+    fprintf(fp, "%-22s %10s\n", "matrix", "bytes");
+    for (i = 0; i < t->num_matrices; i++)
+      fprintf(fp, "%-22s %10lu\n", t->matrices[i].name, (unsigned long)t->matrices[i].bytes);
+
+    fprintf(fp, "%-22s %10lu\n", "total", (unsigned long)t->mx_bytes);
+  }
+}
+
+
+#ifdef VRNA_WITH_TIMING
+
+void
+vrna_timing_phase_start(vrna_timing_t       *timing,
+                        vrna_timing_phase_e phase)
+{
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&timing_mtx);
+#endif
+
+  /* only the outermost call of re-entrant or concurrent phases is timed */
+  if (timing->depth[phase]++ == 0) {
+    timing->start_wall[phase] = wall_time();
+    timing->start_cpu[phase]  = cpu_time();
+    timing->calls[phase]++;
+  }
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&timing_mtx);
+#endif
+}
+
+
+void
+vrna_timing_phase_stop(vrna_timing_t        *timing,
+                       vrna_timing_phase_e  phase)
+{
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&timing_mtx);
+#endif
+
+  if ((timing->depth[phase] > 0) &&
+      (--timing->depth[phase] == 0)) {
+    timing->wall[phase] += wall_time() - timing->start_wall[phase];
+    timing->cpu[phase]  += cpu_time() - timing->start_cpu[phase];
+  }
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&timing_mtx);
+#endif
+}
+
+
+void
+vrna_timing_cells_add(vrna_timing_t       *timing,
+                      vrna_timing_phase_e phase,
+                      double              num)
+{
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&timing_mtx);
+#endif
+
+  timing->cells[phase] += num;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&timing_mtx);
+#endif
+}
+
+
+void
+vrna_timing_mx_add(vrna_timing_t  *timing,
+                   const char     *name,
+                   size_t         bytes)
+{
+  unsigned int i;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&timing_mtx);
+#endif
+
+  timing->mx_bytes += bytes;
+
+  for (i = 0; i < timing->num_matrices; i++)
+    if (!strcmp(timing->matrices[i].name, name))
+      break;
+
+  if (i < timing->num_matrices) {
+    timing->matrices[i].bytes += bytes;
+  } else if (i < VRNA_TIMING_MX_MAX) {
+    timing->matrices[i].name  = name;
+    timing->matrices[i].bytes = bytes;
+    timing->num_matrices++;
+  }
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&timing_mtx);
+#endif
+}
+
+
+double
+vrna_timing_cells_triangle(int  n,
+                           int  turn,
+                           int  span)
+{
+  double  d, cells;
+
+  /* count pairs (i,j) for each distance d = j - i */
+  if ((span <= 0) || (span > n))
+    span = n;
+
+  d = (double)(span - turn - 1);
+  if (d <= 0)
+    return 0.;
+
+  /* sum_{k = turn + 1}^{span - 1} (n - k) */
+  cells = d * (double)n - ((double)(span - 1) * (double)span - (double)turn * (double)(turn + 1)) / 2.;
+
+  return (cells > 0) ? cells : 0.;
+}
+
+
+/*
+ #####################################
+ # BEGIN OF STATIC HELPER FUNCTIONS  #
+ #####################################
+ */
+PRIVATE double
+wall_time(void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+
+  return (double)t.tv_sec + 1e-9 * (double)t.tv_nsec;
+#else
+  struct timeval t;
+
+  gettimeofday(&t, NULL);
+
+  return (double)t.tv_sec + 1e-6 * (double)t.tv_usec;
+#endif
+}
+
+
+PRIVATE double
+cpu_time(void)
+{
+  return (double)clock() / (double)CLOCKS_PER_SEC;
+}
+
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef VIENNA_RNA_PACKAGE_UTILS_TIMING_H
+#define VIENNA_RNA_PACKAGE_UTILS_TIMING_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/**
+ *  @file     ViennaRNA/utils/timing.h
+ *  @ingroup  timing_utils
+ *  @brief    Per-phase timings and counters for the computations of a #vrna_fold_compound_t
+ */
+
+/**
+ *  @addtogroup   timing_utils
+ *  @{
+ *  @brief  Record where the time goes within structure predictions
+ *
+ *  Once enabled for a #vrna_fold_compound_t with vrna_timing_enable(), the
+ *  library records wall clock and CPU time spent in each phase of the
+ *  computations, i.e. preparation of the energy parameters, allocation of
+ *  the DP matrices, the MFE and partition function recursions, the outside
+ *  algorithm for base pair probabilities, MFE backtracking, and stochastic
+ *  sampling. Additionally, the nominal number of DP matrix cells filled by
+ *  the recursions and the number of bytes allocated for each DP matrix are
+ *  counted.
+ *
+ *  Cell counts are nominal, i.e. they are derived from the sequence length,
+ *  the minimal hairpin size, and the maximal base pair span of the model
+ *  rather than counted within the recursions. They include cells that the
+ *  recursions skip, e.g. due to hard constraints, and thus serve as a
+ *  measure of throughput that is comparable between runs, not as an exact
+ *  count of the work done.
+ *
+ *  Phases may be nested, e.g. the energy parameters are re-scaled while the
+ *  partition function matrices are allocated. The time of a nested phase is
+ *  then included in the enclosing phase as well. CPU times are process CPU
+ *  times, thus include the work of all threads. Threads that work on the
+ *  same fold compound concurrently, e.g. when drawing stochastic samples,
+ *  may share its timings. Overlapping calls of a phase are then timed as a
+ *  single call from the first start to the last stop.
+ *
+ *  The instrumentation costs a single pointer comparison per phase if
+ *  it is not enabled for a particular #vrna_fold_compound_t, and it can be
+ *  removed completely with the @p --disable-timing configure option. In
+ *  that case, vrna_timing_enable() always fails.
+ */
+
+#ifndef VRNA_TIMING_MX_MAX
+/**
+ *  @brief  Maximum number of distinct DP matrices whose memory consumption is recorded
+ */
+#define VRNA_TIMING_MX_MAX  24
+#endif
+
+/**
+ *  @brief  Phases of the computations that are timed separately
+ */
+typedef enum {
+  VRNA_TIMING_PARAMS,         /**< @brief Preparation of (Boltzmann weighted) energy parameters */
+  VRNA_TIMING_MX_PREPARE,     /**< @brief Allocation of the DP matrices, see vrna_mx_prepare() */
+  VRNA_TIMING_MFE_FILL,       /**< @brief MFE recursions */
+  VRNA_TIMING_MFE_BACKTRACK,  /**< @brief MFE backtracking */
+  VRNA_TIMING_PF_FILL,        /**< @brief Partition function (inside) recursions */
+  VRNA_TIMING_PF_OUTSIDE,     /**< @brief Outside recursions for base pair probabilities */
+  VRNA_TIMING_SAMPLING,       /**< @brief Stochastic backtracking */
+  VRNA_TIMING_PHASES          /**< @brief Number of distinct phases */
+} vrna_timing_phase_e;
+
+
+/**
+ *  @brief  Typename for the timing data structure #vrna_timing_s
+ */
+typedef struct vrna_timing_s vrna_timing_t;
+
+
+/**
+ *  @brief  Memory allocated for a particular DP matrix
+ */
+typedef struct {
+  const char  *name;  /**<  @brief  Name of the matrix, e.g. "c" or "probs" */
+  size_t      bytes;  /**<  @brief  Total number of bytes allocated for this matrix */
+} vrna_timing_mx_t;
+
+
+/**
+ *  @brief  Timings and counters recorded for a #vrna_fold_compound_t
+ */
+struct vrna_timing_s {
+  double            wall[VRNA_TIMING_PHASES];   /**<  @brief  Wall clock time in seconds for each phase */
+  double            cpu[VRNA_TIMING_PHASES];    /**<  @brief  CPU time in seconds for each phase */
+  unsigned int      calls[VRNA_TIMING_PHASES];  /**<  @brief  Number of times each phase was entered */
+  double            cells[VRNA_TIMING_PHASES];  /**<  @brief  Nominal number of DP matrix cells filled in each phase */
+
+  vrna_timing_mx_t  matrices[VRNA_TIMING_MX_MAX]; /**<  @brief  Memory allocated for each DP matrix */
+  unsigned int      num_matrices;                 /**<  @brief  Number of entries in @p matrices */
+  size_t            mx_bytes;                     /**<  @brief  Total number of bytes allocated for DP matrices */
+
+  /* internal use only */
+  double            start_wall[VRNA_TIMING_PHASES];
+  double            start_cpu[VRNA_TIMING_PHASES];
+  unsigned int      depth[VRNA_TIMING_PHASES];
+};
+
+
+#include <ViennaRNA/fold_compound.h>
+
+/**
+ *  @brief  Enable or disable recording of timings and counters for a #vrna_fold_compound_t
+ *
+ *  DP matrices that are already attached to the fold compound are recorded
+ *  right away. Enabling the instrumentation for a fold compound that already
+ *  records data keeps the data recorded so far. Disabling it discards all
+ *  recorded data.
+ *
+ *  @param  fc      The fold compound
+ *  @param  enable  Enable (non-zero) or disable (0) the instrumentation
+ *  @return         1 on success, 0 if the library was built without instrumentation support
+ */
+int
+vrna_timing_enable(vrna_fold_compound_t *fc,
+                   int                  enable);
+
+
+/**
+ *  @brief  Reset all timings and counters recorded for a #vrna_fold_compound_t
+ *
+ *  @param  fc  The fold compound
+ */
+void
+vrna_timing_reset(vrna_fold_compound_t *fc);
+
+
+/**
+ *  @brief  Retrieve the timings and counters recorded for a #vrna_fold_compound_t
+ *
+ *  @param  fc  The fold compound
+ *  @return     The recorded data, or NULL if the instrumentation is not enabled
+ */
+const vrna_timing_t *
+vrna_timing(vrna_fold_compound_t *fc);
+
+
+/**
+ *  @brief  Get a human readable name of a phase
+ *
+ *  @param  phase The phase
+ *  @return       The name of the phase
+ */
+const char *
+vrna_timing_phase_name(vrna_timing_phase_e phase);
+
+
+/**
+ *  @brief  Print the timings and counters recorded for a #vrna_fold_compound_t
+ *
+ *  Prints a table with the wall clock and CPU time, number of calls, nominal DP matrix
+ *  cells, and nominal cells per second of each phase that was entered at least once, followed by
+ *  the memory allocated for each DP matrix.
+ *
+ *  @param  fp    The output stream
+ *  @param  fc    The fold compound
+ *  @param  title An optional title for the table, or NULL
+ */
+void
+vrna_timing_print(FILE                  *fp,
+                  vrna_fold_compound_t  *fc,
+                  const char            *title);
+
+
+/**
+ *  @}
+ */
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef VIENNA_RNA_PACKAGE_UTILS_TIMING_HOOKS_H
+#define VIENNA_RNA_PACKAGE_UTILS_TIMING_HOOKS_H
+
+/*
+ *  Internal instrumentation hooks, see ViennaRNA/utils/timing.h
+ *
+ *  All hooks expand to nothing unless the library is configured with
+ *  timing support (VRNA_WITH_TIMING). Otherwise, they cost a single
+ *  pointer comparison if the instrumentation is not enabled for the
+ *  fold compound at hand. The hooks may be called concurrently, e.g. by
+ *  threads that draw samples from the same fold compound.
+ */
+
+#include "ViennaRNA/utils/timing.h"
+
+#ifdef VRNA_WITH_TIMING
+
+/* the hooks are not part of the API, keep them out of the symbol table of shared objects */
+#if defined(__GNUC__) && !defined(_WIN32)
+# define VRNA_TIMING_INTERNAL __attribute__ ((visibility("hidden")))
+#else
+# define VRNA_TIMING_INTERNAL
+#endif
+
+VRNA_TIMING_INTERNAL void
+vrna_timing_phase_start(vrna_timing_t       *timing,
+                        vrna_timing_phase_e phase);
+
+
+VRNA_TIMING_INTERNAL void
+vrna_timing_phase_stop(vrna_timing_t        *timing,
+                       vrna_timing_phase_e  phase);
+
+
+VRNA_TIMING_INTERNAL void
+vrna_timing_cells_add(vrna_timing_t       *timing,
+                      vrna_timing_phase_e phase,
+                      double              num);
+
+
+VRNA_TIMING_INTERNAL void
+vrna_timing_mx_add(vrna_timing_t  *timing,
+                   const char     *name,
+                   size_t         bytes);
+
+
+/* record the DP matrices that are already attached to a fold compound, see dp_matrices.c */
+VRNA_TIMING_INTERNAL void
+vrna_timing_mx_current(vrna_fold_compound_t *fc);
+
+
+/* number of pairs (i,j) with turn < j - i < span in a sequence of length n */
+VRNA_TIMING_INTERNAL double
+vrna_timing_cells_triangle(int  n,
+                           int  turn,
+                           int  span);
+
+
+# define VRNA_TIMING_START(fc, phase) \
+  do { if ((fc)->timing) vrna_timing_phase_start((fc)->timing, (phase)); } while (0)
+
+# define VRNA_TIMING_STOP(fc, phase) \
+  do { if ((fc)->timing) vrna_timing_phase_stop((fc)->timing, (phase)); } while (0)
+
+# define VRNA_TIMING_CELLS(fc, phase, num) \
+  do { if ((fc)->timing) vrna_timing_cells_add((fc)->timing, (phase), (double)(num)); } while (0)
+
+# define VRNA_TIMING_MX(fc, name, bytes) \
+  do { if (((fc)->timing) && (bytes)) vrna_timing_mx_add((fc)->timing, (name), (size_t)(bytes)); } while (0)
+
+#else
+
+# define VRNA_TIMING_START(fc, phase)
+# define VRNA_TIMING_STOP(fc, phase)
+# define VRNA_TIMING_CELLS(fc, phase, num)
+# define VRNA_TIMING_MX(fc, name, bytes)
+
+#endif
+
+#endif
@@ -20,6 +20,10 @@
 #include <stdarg.h>
 #include <errno.h>
 
+#if VRNA_WITH_PTHREADS
+# include <pthread.h>
+#endif
+
 /* for getpid() we need some distinction between UNIX and Win systems */
 #ifdef _WIN32
 #include <windows.h>
@@ -56,6 +60,37 @@ PUBLIC unsigned short xsubi[3];
  # PRIVATE VARIABLES             #
  #################################
  */
+/* thread-local storage for builds that use POSIX threads but not OpenMP */
+#if !defined(_OPENMP) && VRNA_WITH_PTHREADS && defined(__GNUC__)
+# define URN_THREAD_LOCAL __thread
+#else
+# define URN_THREAD_LOCAL
+#endif
+
+#define URN_UNSET   0
+#define URN_GLOBAL  1   /* the thread draws from xsubi */
+#define URN_OWN     2   /* the thread draws from its own default stream */
+
+/*
+ *  Private stream set by vrna_urn_stream(), and the default stream of each
+ *  thread. The first thread that draws a random number uses xsubi, all
+ *  others obtain their own stream such that vrna_urn() never needs a lock
+ */
+PRIVATE URN_THREAD_LOCAL unsigned short *urn_stream = NULL;
+PRIVATE URN_THREAD_LOCAL unsigned short urn_default[3];
+PRIVATE URN_THREAD_LOCAL int            urn_mode = URN_UNSET;
+
+#ifdef _OPENMP
+#pragma omp threadprivate(urn_stream, urn_default, urn_mode)
+#endif
+
+PRIVATE int             urn_threads = 0;  /* number of threads that drew random numbers */
+PRIVATE unsigned short  urn_seed[3];      /* xsubi at the first draw, seeds the default streams */
+
+#if VRNA_WITH_PTHREADS
+PRIVATE pthread_mutex_t urn_mtx = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 PRIVATE char  scale1[]  = "....,....1....,....2....,....3....,....4";
 PRIVATE char  scale2[]  = "....,....5....,....6....,....7....,....8";
 
@@ -70,6 +105,10 @@ rj_mix(uint32_t a,
        uint32_t c);
 
 
+PRIVATE void
+urn_default_stream(void);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -264,14 +303,26 @@ vrna_urn(void)
 #ifdef HAVE_ERAND48
   extern double erand48(unsigned short[]);
 
+  if (urn_stream)
+    return erand48(urn_stream);
+
+  if (urn_mode == URN_UNSET)
+    urn_default_stream();
 
-  return erand48(xsubi);
+  return erand48((urn_mode == URN_GLOBAL) ? xsubi : urn_default);
 #else
   return ((double)rand()) / RAND_MAX;
 #endif
 }
 
 
+PUBLIC void
+vrna_urn_stream(unsigned short *state)
+{
+  urn_stream = state;
+}
+
+
 /*------------------------------------------------------------------------*/
 
 PUBLIC int
@@ -519,6 +570,36 @@ rj_mix(uint32_t a,
 }
 
 
+/* decide which default stream the calling thread draws its random numbers from */
+PRIVATE void
+urn_default_stream(void)
+{
+  uint32_t seed;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&urn_mtx);
+#endif
+
+  if (urn_threads++ == 0) {
+    memcpy(urn_seed, xsubi, sizeof(urn_seed));
+    urn_mode = URN_GLOBAL;
+  } else {
+    /* derive a distinct stream from the seed and the number of threads so far */
+    seed = rj_mix(((uint32_t)urn_seed[0] << 16) | (uint32_t)urn_seed[1],
+                  (uint32_t)urn_seed[2],
+                  (uint32_t)urn_threads);
+    urn_default[0]  = (unsigned short)seed;
+    urn_default[1]  = (unsigned short)(seed >> 16);
+    urn_default[2]  = (unsigned short)rj_mix(seed, (uint32_t)urn_threads, (uint32_t)urn_seed[0]);
+    urn_mode        = URN_OWN;
+  }
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&urn_mtx);
+#endif
+}
+
+
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
 /*###########################################*/
@@ -45,7 +45,7 @@ main(int  argc,
   char                              *mfe_structure, *structure1, *structure2, *reference_struc1,
                                     *reference_struc2, *ParamFile;
   int                               i, length, l, pf, istty, noconv, circ, maxDistance1, maxDistance2,
-                                    do_backtrack, stBT, nstBT;
+                                    do_backtrack, stBT, nstBT, num_threads;
   double                            min_en;
   vrna_md_t                         md;
 
@@ -60,6 +60,7 @@ main(int  argc,
   do_backtrack      = 1;
   stBT              = 0;
   nstBT             = 0;
+  num_threads       = 0;
   neighborhoods     = NULL;
   neighborhoods_cur = NULL;
 
@@ -113,13 +114,12 @@ main(int  argc,
   }
 
   /* set number of threads for parallel computation */
-  if (args_info.numThreads_given)
+  if (args_info.numThreads_given) {
 #ifdef _OPENMP
     omp_set_num_threads(args_info.numThreads_arg);
-
-#else
-    vrna_message_error("\'j\' option is available only if compiled with OpenMP support!");
 #endif
+    num_threads = args_info.numThreads_arg;
+  }
 
   /* get energy parameter file name */
   if (args_info.parameterFile_given)
@@ -270,8 +270,11 @@ main(int  argc,
     vrna_fold_compound_free(vc_global);
 
     /* get all variables need for the folding process (some memory will be preallocated here too) */
-    vrna_fold_compound_t  *vc     = vrna_fold_compound_TwoD(string, structure1, structure2, &md, VRNA_OPTION_MFE | (pf ? VRNA_OPTION_PF : 0));
-    vrna_sol_TwoD_t       *mfe_s  = vrna_mfe_TwoD(vc, maxDistance1, maxDistance2);
+    vrna_fold_compound_t  *vc = vrna_fold_compound_TwoD(string, structure1, structure2, &md, VRNA_OPTION_MFE | (pf ? VRNA_OPTION_PF : 0));
+    vrna_sol_TwoD_t       *mfe_s;
+
+    vrna_TwoD_set_num_threads(vc, num_threads);
+    mfe_s = vrna_mfe_TwoD(vc, maxDistance1, maxDistance2);
 
     if (!pf) {
 #ifdef COUNT_STATES
@@ -359,23 +362,25 @@ main(int  argc,
             int k, l;
             k = tmp->k;
             l = tmp->l;
+            char **samples = vrna_pbacktrack_TwoD_num(vc, k, l, nstBT);
             for (i = 0; i < nstBT; i++) {
-              char  *s      = vrna_pbacktrack_TwoD(vc, k, l);
-              char  *tline  = vrna_strdup_printf("%d\t%d\t%6.2f\t%s", k, l, vrna_eval_structure(vc, s), s);
+              char  *tline = vrna_strdup_printf("%d\t%d\t%6.2f\t%s", k, l, vrna_eval_structure(vc, samples[i]), samples[i]);
               print_table(stdout, NULL, tline);
               free(tline);
-              free(s);
+              free(samples[i]);
             }
+            free(samples);
           }
         } else {
           for (i = 0; pf_s[i].k != INF; i++) {
+            char **samples = vrna_pbacktrack_TwoD_num(vc, pf_s[i].k, pf_s[i].l, nstBT);
             for (l = 0; l < nstBT; l++) {
-              char  *s      = vrna_pbacktrack_TwoD(vc, pf_s[i].k, pf_s[i].l);
-              char  *tline  = vrna_strdup_printf("%d\t%d\t%6.2f\t%s", pf_s[i].k, pf_s[i].l, vrna_eval_structure(vc, s), s);
+              char  *tline = vrna_strdup_printf("%d\t%d\t%6.2f\t%s", pf_s[i].k, pf_s[i].l, vrna_eval_structure(vc, samples[l]), samples[l]);
               print_table(stdout, NULL, tline);
               free(tline);
-              free(s);
+              free(samples[l]);
             }
+            free(samples);
           }
         }
       }
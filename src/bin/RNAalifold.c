@@ -76,6 +76,7 @@ struct options {
   int             mis;
   int             sci;
   int             endgaps;
+  int             collapse;
 
   int             aln_out;
   char            *aln_out_prefix;
@@ -231,6 +232,7 @@ init_default_options(struct options *opt)
   opt->mis          = 0;
   opt->sci          = 0;
   opt->endgaps      = 0;
+  opt->collapse     = -1;
 
   opt->aln_out        = 0;
   opt->aln_out_prefix = NULL;
@@ -489,6 +491,20 @@ main(int  argc,
   if (args_info.sci_given)
     opt.sci = 1;
 
+  /* collapse redundant sequences */
+  if (args_info.collapse_given) {
+    if (args_info.collapse_arg < 0)
+      vrna_message_warning("Number of mismatches for --collapse must not be negative, using 0");
+
+    opt.collapse = MAX2(0, args_info.collapse_arg);
+
+    if (opt.md.gquad)
+      vrna_message_warning("--collapse is not supported with G-Quadruplexes, ignoring it");
+
+    if (opt.shape)
+      vrna_message_warning("--collapse is not supported with SHAPE reactivity data, ignoring it");
+  }
+
   /* alignment file name(s) given as unnamed option? */
   input_files = collect_unnamed_options(&args_info, &num_input);
 
@@ -836,8 +852,8 @@ process_input(FILE            *input_stream,
 static void
 process_record(struct record_data *record)
 {
-  char                  **alignment, *consensus_sequence, *mfe_structure;
-  unsigned int          n, i, n_seq;
+  char                  **alignment, **representatives, *consensus_sequence, *mfe_structure;
+  unsigned int          n, i, n_seq, *weights;
   double                min_en, real_en, cov_en;
   struct options        *opt;
   vrna_fold_compound_t  *vc;
@@ -866,9 +882,27 @@ process_record(struct record_data *record)
     for (i = 0; i < n_seq; i++)
       mark_endgaps(alignment[i], '~');
 
-  vc = vrna_fold_compound_comparative((const char **)alignment,
-                                      &(opt->md),
-                                      VRNA_OPTION_DEFAULT);
+  representatives = NULL;
+  weights         = NULL;
+
+  if ((opt->collapse >= 0) && (!opt->md.gquad) && (!opt->shape))
+    representatives = vrna_aln_collapse((const char **)alignment,
+                                        (unsigned int)opt->collapse,
+                                        &weights);
+
+  if (representatives) {
+    vc = vrna_fold_compound_comparative_weighted((const char **)representatives,
+                                                 weights,
+                                                 &(opt->md),
+                                                 VRNA_OPTION_DEFAULT);
+    vrna_aln_free(representatives);
+    free(weights);
+  } else {
+    vc = vrna_fold_compound_comparative((const char **)alignment,
+                                        &(opt->md),
+                                        VRNA_OPTION_DEFAULT);
+  }
+
   n = vc->length;
 
   if (fold_constrained)
@@ -887,6 +921,11 @@ process_record(struct record_data *record)
                            "%u sequences; length of alignment %u.",
                            n_seq,
                            n);
+
+    if (vc->n_seq < n_seq)
+      vrna_cstr_message_info(o_stream->err,
+                             "collapsed into %u weighted representatives.",
+                             vc->n_seq);
   }
 
   /*
@@ -1449,7 +1488,7 @@ print_aliout(vrna_fold_compound_t *vc,
   int           k;
   vrna_pinfo_t  *pi;
   char          **AS  = vc->sequences;
-  int           n_seq = vc->n_seq;
+  int           n_seq = vc->n_seq_total;
 
   pi = vrna_aln_pinfo(vc, (const char *)mfe, threshold);
 
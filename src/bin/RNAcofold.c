@@ -99,6 +99,17 @@ struct record_data {
 };
 
 
+/* maximum number of records and nucleotides passed to a worker thread at once */
+#define RECORD_BATCH_SIZE     64
+#define RECORD_BATCH_LENGTH   10000
+
+struct record_batch {
+  unsigned int        num;
+  size_t              length;
+  struct record_data  *records[RECORD_BATCH_SIZE];
+};
+
+
 struct output_stream {
   vrna_cstr_t data;
   vrna_cstr_t err;
@@ -109,6 +120,19 @@ static void
 process_record(struct record_data *record);
 
 
+static void
+process_batch(struct record_batch *batch);
+
+
+static unsigned int
+read_input_record(vrna_fasta_reader_t  reader,
+                  FILE                *input_stream,
+                  char                **id,
+                  char                **sequence,
+                  char                ***rest,
+                  unsigned int        options);
+
+
 PRIVATE vrna_dimer_pf_t
 do_partfunc(char            *string,
             int             length,
@@ -526,11 +550,16 @@ process_input(FILE            *input_stream,
               const char      *input_filename,
               struct options  *opt)
 {
-  unsigned int  read_opt;
-  int           istty, istty_in, istty_out, ret;
+  unsigned int        read_opt, batch_size;
+  int                 istty, istty_in, istty_out, ret;
+  vrna_fasta_reader_t reader;
+  struct record_batch *batch;
 
-  ret       = 1;
-  read_opt  = 0;
+  ret         = 1;
+  read_opt    = 0;
+  batch_size  = RECORD_BATCH_SIZE;
+  reader      = NULL;
+  batch       = NULL;
 
   istty_in  = isatty(fileno(input_stream));
   istty_out = isatty(fileno(stdout));
@@ -556,6 +585,23 @@ process_input(FILE            *input_stream,
   if (!fold_constrained)
     read_opt |= VRNA_INPUT_NO_REST;
 
+  /*
+   * read non-interactive input in large blocks and hand the records over
+   * to the worker threads in batches. Concentrations that are read from
+   * stdin interleave with the records, so stdin must be read line by line
+   * in that case
+   */
+  if ((!istty_in) &&
+      (!(opt->doC && (!opt->concentration_file) && (input_stream == stdin)))) {
+    reader = vrna_file_fasta_reader_init(input_stream);
+    if (!reader)
+      vrna_message_error("Unable to read input from \"%s\"",
+                         (input_filename) ? input_filename : "stdin");
+  }
+
+  if ((!reader) || (opt->jobs == 1))
+    batch_size = 1;
+
   /*
    #############################################
    # main loop: continue until end of file
@@ -570,11 +616,12 @@ process_input(FILE            *input_stream,
     rec_rest        = NULL;
     maybe_multiline = 0;
 
-    rec_type = vrna_file_fasta_read_record(&rec_id,
-                                           &rec_sequence,
-                                           &rec_rest,
-                                           input_stream,
-                                           read_opt);
+    rec_type = read_input_record(reader,
+                                 input_stream,
+                                 &rec_id,
+                                 &rec_sequence,
+                                 &rec_rest,
+                                 read_opt);
 
     if (rec_type & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT))
       break;
@@ -608,7 +655,19 @@ process_input(FILE            *input_stream,
     if (opt->output_queue)
       vrna_ostream_request(opt->output_queue, opt->next_record_number++);
 
-    RUN_IN_PARALLEL(process_record, record);
+    if (!batch)
+      batch = (struct record_batch *)vrna_alloc(sizeof(struct record_batch));
+
+    batch->records[batch->num++]  = record;
+    batch->length                 += strlen(rec_sequence);
+
+    if ((batch->num == batch_size) ||
+        (batch->length >= RECORD_BATCH_LENGTH)) {
+      /* keep the reader at most two batches per thread ahead of the workers */
+      WAIT_FOR_JOB_SLOT(2 * opt->jobs);
+      RUN_IN_PARALLEL(process_batch, batch);
+      batch = NULL;
+    }
 
     if (opt->shape || (opt->constraint_file && (!opt->constraint_batch))) {
       ret = 0;
@@ -630,10 +689,63 @@ process_input(FILE            *input_stream,
     }
   } while (1);
 
+  /* process the remaining records */
+  if (batch) {
+    WAIT_FOR_JOB_SLOT(2 * opt->jobs);
+    RUN_IN_PARALLEL(process_batch, batch);
+  }
+
+  vrna_file_fasta_reader_free(reader);
+
   return ret;
 }
 
 
+static unsigned int
+read_input_record(vrna_fasta_reader_t  reader,
+                  FILE                *input_stream,
+                  char                **id,
+                  char                **sequence,
+                  char                ***rest,
+                  unsigned int        options)
+{
+  unsigned int        i, rec_type;
+  vrna_fasta_record_t record;
+
+  if (!reader)
+    return vrna_file_fasta_read_record(id, sequence, rest, input_stream, options);
+
+  rec_type = vrna_file_fasta_read_record_view(reader, &record, options);
+
+  if (rec_type & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT))
+    return rec_type;
+
+  /* the records outlive the read buffer, so we need our own copies */
+  *id       = (record.header) ? strdup(record.header) : NULL;
+  *sequence = (record.sequence) ? strdup(record.sequence) : NULL;
+  *rest     = (char **)vrna_alloc(sizeof(char *) * (record.rest_count + 1));
+
+  for (i = 0; i < record.rest_count; i++)
+    (*rest)[i] = strdup(record.rest[i]);
+
+  return rec_type;
+}
+
+
+static void
+process_batch(struct record_batch *batch)
+{
+  unsigned int i;
+
+  for (i = 0; i < batch->num; i++)
+    process_record(batch->records[i]);
+
+  free(batch);
+
+  RELEASE_JOB_SLOT
+}
+
+
 static void
 process_record(struct record_data *record)
 {
@@ -18,6 +18,7 @@
 #include "ViennaRNA/RNAstruct.h"
 #include "ViennaRNA/treedist.h"
 #include "ViennaRNA/stringdist.h"
+#include "ViennaRNA/dist_matrix.h"
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/utils/strings.h"
 #include "ViennaRNA/utils/structures.h"
@@ -25,8 +26,6 @@
 #include "ViennaRNA/datastructures/basic.h"
 #include "RNAdistance_cmdl.h"
 
-#define MAXNUM      1000    /* max number of structs for distance matrix */
-
 #define PUBLIC
 #define PRIVATE     static
 
@@ -47,6 +46,12 @@ PRIVATE int check_brackets(char *line);
 PRIVATE void print_aligned_lines(FILE *somewhere);
 
 
+PRIVATE float *distance_matrix(char dtype,
+                               void **objects,
+                               int  num,
+                               FILE *somewhere);
+
+
 PRIVATE char  ruler[] = "....,....1....,....2....,....3....,....4"
                         "....,....5....,....6....,....7....,....8";
 PRIVATE int   types = 1;
@@ -56,23 +61,42 @@ PRIVATE char  outfile[FILENAME_MAX_LENGTH], *list_title;
 
 PRIVATE char  ttype[10] = "f";
 PRIVATE int   n         = 0;
+PRIVATE int   jobs      = 0;
+PRIVATE char  *matrix_file;
+PRIVATE int   matrix_format;
 
 int
 main(int  argc,
      char *argv[])
 {
   char      *line = NULL, *xstruc, *cc;
-  Tree      *T[10][MAXNUM];
+  Tree      **T[10];
   int       tree_types = 0, ttree;
-  swString  *S[10][MAXNUM];
-  char      *P[MAXNUM];  /* structures for base pair distances */
+  swString  **S[10];
+  char      **P;  /* structures for base pair distances */
   int       string_types = 0, tstr;
-  int       i, j, tt, istty, type;
+  int       i, j, tt, istty, type, size;
   int       it, is;
-  FILE      *somewhere = NULL;
+  float     *matrix;
+  void      **objects;
+  FILE      *somewhere = NULL, *matrix_out = NULL;
 
   command_line(argc, argv);
 
+  /* storage for the structures of a distance matrix, grows on demand */
+  size = 0;
+  P    = NULL;
+  for (tt = 0; tt < 10; tt++) {
+    T[tt] = NULL;
+    S[tt] = NULL;
+  }
+
+  if (matrix_file) {
+    matrix_out = fopen(matrix_file, (matrix_format == VRNA_DIST_MATRIX_BINARY) ? "wb" : "w");
+    if (!matrix_out)
+      vrna_message_error("Can't open matrix file \"%s\"", matrix_file);
+  }
+
   if ((outfile[0] == '\0') && (task == 2) && (edit_backtrack))
     strcpy(outfile, "backtrack.file");
 
@@ -106,54 +130,42 @@ main(int  argc,
       tstr  = 0;
       for (tt = 0; tt < types; tt++) {
         printf("> %c   %d\n", ttype[tt], n);
-        if (islower(ttype[tt])) {
-          for (i = 1; i < n; i++) {
-            for (j = 0; j < i; j++) {
-              printf("%g ", tree_edit_distance(T[ttree][i], T[ttree][j]));
-              if (edit_backtrack) {
-                fprintf(somewhere, "%d %d", i + 1, j + 1);
-                if (ttype[tt] == 'f')
-                  unexpand_aligned_F(aligned_line);
-
-                print_aligned_lines(somewhere);
-              }
-            }
-            printf("\n");
-          }
+        if (ttype[tt] == 'P')
+          objects = (void **)P;
+        else if (islower(ttype[tt]))
+          objects = (void **)T[ttree];
+        else
+          objects = (void **)S[tstr];
+
+        matrix = distance_matrix(ttype[tt], objects, n, somewhere);
+        if (!matrix)
+          vrna_message_error("Failed to compute distance matrix");
+
+        for (i = 1; i < n; i++) {
+          for (j = 0; j < i; j++)
+            printf("%g ", matrix[VRNA_DIST_MATRIX_INDEX(n, j, i)]);
           printf("\n");
-          for (i = 0; i < n; i++)
-            free_tree(T[ttree][i]);
-          ttree++;
         }
+        printf("\n");
 
-        if (ttype[tt] == 'P') {
-          for (i = 1; i < n; i++) {
-            for (j = 0; j < i; j++)
-              printf("%g ", (float)vrna_bp_distance(P[i], P[j]));
-            printf("\n");
-          }
-          printf("\n");
-          for (i = 0; i < n; i++)
+        if (matrix_out)
+          vrna_file_distance_matrix(matrix_out, matrix, n, NULL, matrix_format);
+
+        free(matrix);
+
+        for (i = 0; i < n; i++) {
+          if (ttype[tt] == 'P')
             free(P[i]);
-        } else if (isupper(ttype[tt])) {
-          for (i = 1; i < n; i++) {
-            for (j = 0; j < i; j++) {
-              printf("%g ", string_edit_distance(S[tstr][i], S[tstr][j]));
-              if (edit_backtrack) {
-                fprintf(somewhere, "%d %d", i + 1, j + 1);
-                if (ttype[tt] == 'F')
-                  unexpand_aligned_F(aligned_line);
-
-                print_aligned_lines(somewhere);
-              }
-            }
-            printf("\n");
-          }
-          printf("\n");
-          for (i = 0; i < n; i++)
+          else if (islower(ttype[tt]))
+            free_tree(T[ttree][i]);
+          else
             free(S[tstr][i]);
-          tstr++;
         }
+
+        if (islower(ttype[tt]))
+          ttree++;
+        else if (ttype[tt] != 'P')
+          tstr++;
       }
       fflush(stdout);
       if (type == 888) {
@@ -170,6 +182,16 @@ main(int  argc,
       if (outfile[0] != '\0')
         fclose(somewhere);
 
+      if (matrix_out)
+        fclose(matrix_out);
+
+      for (tt = 0; tt < 10; tt++) {
+        free(T[tt]);
+        free(S[tt]);
+      }
+      free(P);
+      free(matrix_file);
+
       return 0;
     }
 
@@ -187,6 +209,15 @@ main(int  argc,
       type  = 1;
     }
 
+    if (n == size) {
+      size = (size) ? 2 * size : 128;
+      P    = (char **)vrna_realloc(P, sizeof(char *) * size);
+      for (tt = 0; tt < types; tt++) {
+        T[tt] = (Tree **)vrna_realloc(T[tt], sizeof(Tree *) * size);
+        S[tt] = (swString **)vrna_realloc(S[tt], sizeof(swString *) * size);
+      }
+    }
+
     tree_types    = 0;
     string_types  = 0;
     for (tt = 0; tt < types; tt++) {
@@ -655,6 +686,27 @@ command_line(int  argc,
     edit_backtrack = 1;
   }
 
+  if (args_info.jobs_given)
+    jobs = args_info.jobs_arg;
+
+  if (args_info.matrix_file_given)
+    matrix_file = strdup(args_info.matrix_file_arg);
+
+  matrix_format = VRNA_DIST_MATRIX_PHYLIP;
+  if (args_info.matrix_format_given) {
+    switch (args_info.matrix_format_arg[0]) {
+      case 'p':
+        matrix_format = VRNA_DIST_MATRIX_PHYLIP;
+        break;
+      case 'b':
+        matrix_format = VRNA_DIST_MATRIX_BINARY;
+        break;
+      default:
+        RNAdistance_cmdline_parser_print_help();
+        exit(EXIT_FAILURE);
+    }
+  }
+
   /* free allocated memory of command line data structure */
   RNAdistance_cmdline_parser_free(&args_info);
 }
@@ -670,3 +722,49 @@ print_aligned_lines(FILE *somewhere)
     fflush(somewhere);
   }
 }
+
+
+/*--------------------------------------------------------------------------*/
+
+PRIVATE float *
+distance_matrix(char dtype,
+                void **objects,
+                int  num,
+                FILE *somewhere)
+{
+  int   i, j;
+  float *matrix, dist;
+
+  if ((dtype != 'P') && (!edit_backtrack)) {
+    if (islower(dtype))
+      return tree_edit_distance_matrix((Tree **)objects, num, jobs);
+
+    return string_edit_distance_matrix((swString **)objects, num, jobs);
+  }
+
+  /* base pair distances and alignments are computed sequentially */
+  matrix = (float *)vrna_alloc(sizeof(float) * ((num * (num - 1)) / 2 + 1));
+
+  for (i = 1; i < num; i++) {
+    for (j = 0; j < i; j++) {
+      if (dtype == 'P')
+        dist = (float)vrna_bp_distance((char *)objects[i], (char *)objects[j]);
+      else if (islower(dtype))
+        dist = tree_edit_distance((Tree *)objects[i], (Tree *)objects[j]);
+      else
+        dist = string_edit_distance((swString *)objects[i], (swString *)objects[j]);
+
+      matrix[VRNA_DIST_MATRIX_INDEX(num, j, i)] = dist;
+
+      if ((edit_backtrack) && (dtype != 'P')) {
+        fprintf(somewhere, "%d %d", i + 1, j + 1);
+        if (tolower(dtype) == 'f')
+          unexpand_aligned_F(aligned_line);
+
+        print_aligned_lines(somewhere);
+      }
+    }
+  }
+
+  return matrix;
+}
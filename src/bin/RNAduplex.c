@@ -21,11 +21,53 @@
 #include "ViennaRNA/params/io.h"
 #include "ViennaRNA/subopt.h"
 #include "ViennaRNA/duplex.h"
+#include "ViennaRNA/datastructures/char_stream.h"
+#include "ViennaRNA/datastructures/stream_output.h"
 #include "RNAduplex_cmdl.h"
 
 #include "ViennaRNA/color_output.inc"
+#include "parallel_helpers.h"
+
+struct options {
+  int             delta;
+  int             jobs;
+  int             keep_order;
+  unsigned int    next_record_number;
+  vrna_ostream_t  output_queue;
+  vrna_md_t       md;
+};
+
+
+struct record_data {
+  unsigned int    number;
+  char            *s1;
+  char            *s2;
+  vrna_cstr_t     data;
+  struct options  *options;
+  int             tty;
+};
+
+
+PRIVATE void
+process_record(struct record_data *record);
+
+
+PRIVATE void
+print_struc(vrna_cstr_t   stream,
+            duplexT const *dup);
+
+
+PRIVATE void
+flush_cstr_callback(void          *auxdata,
+                    unsigned int  i,
+                    void          *data)
+{
+  vrna_cstr_t s = (vrna_cstr_t)data;
+
+  /* flush/free data */
+  vrna_cstr_free(s);
+}
 
-PRIVATE void  print_struc(duplexT const *dup);
 
 
 /*--------------------------------------------------------------------------*/
@@ -35,17 +77,22 @@ main(int  argc,
      char *argv[])
 {
   struct        RNAduplex_args_info args_info;
-  char                              *input_string, *s1, *s2, *orig_s1, *orig_s2,
-                                    *c, *ParamFile, *ns_bases;
+  char                              *input_string, *s1, *s2, *c, *ParamFile, *ns_bases;
   unsigned int                      input_type;
-  int                               i, sym, istty, delta, noconv;
-
-  ParamFile = NULL;
-  ns_bases  = NULL;
-  s1        = s2 = orig_s1 = orig_s2 = NULL;
-  dangles   = 2;
-  delta     = -1;
-  noconv    = 0;
+  int                               i, sym, istty, noconv;
+  vrna_cstr_t                       headers;
+  struct options                    opt;
+
+  ParamFile               = NULL;
+  ns_bases                = NULL;
+  s1                      = s2 = NULL;
+  dangles                 = 2;
+  noconv                  = 0;
+  opt.delta               = -1;
+  opt.jobs                = 1;
+  opt.keep_order          = 1;
+  opt.next_record_number  = 0;
+  opt.output_queue        = NULL;
 
   /*
    #############################################
@@ -97,12 +144,39 @@ main(int  argc,
 
   /*energy range */
   if (args_info.deltaEnergy_given)
-    delta = (int)(0.1 + args_info.deltaEnergy_arg * 100);
+    opt.delta = (int)(0.1 + args_info.deltaEnergy_arg * 100);
 
   /* sorted output */
   if (args_info.sorted_given)
     subopt_sorted = 1;
 
+  if (args_info.jobs_given) {
+#if VRNA_WITH_PTHREADS
+    int thread_max = max_user_threads();
+    if (args_info.jobs_arg == 0) {
+      /* use maximum of concurrent threads */
+      int proc_cores, proc_cores_conf;
+      if (num_proc_cores(&proc_cores, &proc_cores_conf)) {
+        opt.jobs = MIN2(thread_max, proc_cores_conf);
+      } else {
+        vrna_message_warning("Could not determine number of available processor cores!\n"
+                             "Defaulting to serial computation");
+        opt.jobs = 1;
+      }
+    } else {
+      opt.jobs = MIN2(thread_max, args_info.jobs_arg);
+    }
+
+    opt.jobs = MAX2(1, opt.jobs);
+#else
+    vrna_message_warning(
+      "This version of RNAduplex has been built without parallel input processing capabilities");
+#endif
+
+    if (args_info.unordered_given)
+      opt.keep_order = 0;
+  }
+
   /* free allocated memory of command line data structure */
   RNAduplex_cmdline_parser_free(&args_info);
 
@@ -139,13 +213,20 @@ main(int  argc,
 
   istty = isatty(fileno(stdout)) && isatty(fileno(stdin));
 
+  update_fold_params();
+  set_model_details(&(opt.md));
+
+  if (opt.keep_order)
+    opt.output_queue = vrna_ostream_init(&flush_cstr_callback, NULL);
+
+  INIT_PARALLELIZATION(opt.jobs);
+
   /*
    #############################################
    # main loop: continue until end of file
    #############################################
    */
   do {
-    duplexT mfe, *subopt;
     /*
      ########################################################
      # handle user input from 'stdin'
@@ -154,14 +235,18 @@ main(int  argc,
     if (istty)
       vrna_message_input_seq("Input two sequences (one line each)");
 
+    /* collect any FASTA header in the output of the current record */
+    headers = vrna_cstr(100, stdout);
+
     /* extract filename from fasta header if available */
     while ((input_type = get_input_line(&input_string, 0)) == VRNA_INPUT_FASTA_HEADER) {
-      print_fasta_header(stdout, input_string);
+      vrna_cstr_print_fasta_header(headers, input_string);
       free(input_string);
     }
 
     /* break on any error, EOF or quit request */
     if (input_type & (VRNA_INPUT_QUIT | VRNA_INPUT_ERROR)) {
+      vrna_cstr_free(headers);
       break;
     }
     /* else assume a proper sequence of letters of a certain alphabet (RNA, DNA, etc.) */
@@ -172,11 +257,13 @@ main(int  argc,
 
     /* get second sequence */
     while ((input_type = get_input_line(&input_string, 0)) == VRNA_INPUT_FASTA_HEADER) {
-      print_fasta_header(stdout, input_string);
+      vrna_cstr_print_fasta_header(headers, input_string);
       free(input_string);
     }
     /* break on any error, EOF or quit request */
     if (input_type & (VRNA_INPUT_QUIT | VRNA_INPUT_ERROR)) {
+      vrna_cstr_free(headers);
+      free(s1);
       break;
     }
     /* else assume a proper sequence of letters of a certain alphabet (RNA, DNA, etc.) */
@@ -191,65 +278,103 @@ main(int  argc,
       vrna_seq_toRNA(s2);
     }
 
-    /* store case-unmodified sequence */
-    orig_s1 = strdup(s1);
-    orig_s2 = strdup(s2);
     /* convert sequence to uppercase letters only */
     vrna_seq_toupper(s1);
     vrna_seq_toupper(s2);
 
-    if (istty)
-      vrna_message_info(stdout, "lengths = %d,%d\n", (int)strlen(s1), (int)strlen(s2));
-
     /*
      ########################################################
-     # done with 'stdin' handling, now init everything properly
+     # hand over the sequence pair to the next free compute slot
      ########################################################
      */
-    update_fold_params();
+    struct record_data *record = (struct record_data *)vrna_alloc(sizeof(struct record_data));
 
-    /*
-     ########################################################
-     # begin actual computations
-     ########################################################
-     */
-    if (delta >= 0) {
-      duplexT *sub;
-      subopt = duplex_subopt(s1, s2, delta, 5);
-      for (sub = subopt; sub->i > 0; sub++) {
-        print_struc(sub);
-        free(sub->structure);
-      }
-      free(subopt);
-    } else {
-      mfe = duplexfold(s1, s2);
-      print_struc(&mfe);
-      free(mfe.structure);
-    }
+    record->number  = opt.next_record_number;
+    record->s1      = s1;
+    record->s2      = s2;
+    record->data    = headers;
+    record->options = &opt;
+    record->tty     = istty;
 
-    (void)fflush(stdout);
-    free(s1);
-    free(s2);
-    free(orig_s1);
-    free(orig_s2);
-    s1 = s2 = orig_s1 = orig_s2 = NULL;
+    if (opt.output_queue)
+      vrna_ostream_request(opt.output_queue, opt.next_record_number++);
+
+    RUN_IN_PARALLEL(process_record, record);
+
+    s1 = s2 = NULL;
   } while (1);
+
+  UNINIT_PARALLELIZATION
+
+  vrna_ostream_free(opt.output_queue);
+
   return 0;
 }
 
 
 PRIVATE void
-print_struc(duplexT const *dup)
+process_record(struct record_data *record)
+{
+  duplexT               mfe, *subopt, *sub;
+  vrna_cstr_t           o_stream;
+  vrna_duplex_context_t *ctx;
+  struct options        *opt;
+
+  opt       = record->options;
+  o_stream  = record->data;
+
+  if (record->tty)
+    vrna_cstr_message_info(o_stream,
+                           "lengths = %d,%d\n",
+                           (int)strlen(record->s1),
+                           (int)strlen(record->s2));
+
+  /*
+   ########################################################
+   # begin actual computations
+   ########################################################
+   */
+  ctx = vrna_duplex_context(&(opt->md));
+
+  if (opt->delta >= 0) {
+    subopt = vrna_duplex_subopt(ctx, record->s1, record->s2, opt->delta, 5);
+    for (sub = subopt; sub->i > 0; sub++) {
+      print_struc(o_stream, sub);
+      free(sub->structure);
+    }
+    free(subopt);
+  } else {
+    mfe = vrna_duplexfold(ctx, record->s1, record->s2);
+    print_struc(o_stream, &mfe);
+    free(mfe.structure);
+  }
+
+  vrna_duplex_context_free(ctx);
+
+  if (opt->output_queue)
+    vrna_ostream_provide(opt->output_queue, record->number, (void *)o_stream);
+  else
+    flush_cstr_callback(NULL, 0, (void *)o_stream);
+
+  free(record->s1);
+  free(record->s2);
+  free(record);
+}
+
+
+PRIVATE void
+print_struc(vrna_cstr_t   stream,
+            duplexT const *dup)
 {
-  int   l1;
+  int l1;
 
   l1 = strchr(dup->structure, '&') - dup->structure;
-  char  *msg = vrna_strdup_printf(" %3d,%-3d : %3d,%-3d (%5.2f)",
-                                  dup->i + 1 - l1,
-                                  dup->i,
-                                  dup->j,
-                                  dup->j + (int)strlen(dup->structure) - l1 - 2,
-                                  dup->energy);
-  print_structure(stdout, dup->structure, msg);
-  free(msg);
+  vrna_cstr_printf_structure(stream,
+                             dup->structure,
+                             " %3d,%-3d : %3d,%-3d (%5.2f)",
+                             dup->i + 1 - l1,
+                             dup->i,
+                             dup->j,
+                             dup->j + (int)strlen(dup->structure) - l1 - 2,
+                             dup->energy);
 }
@@ -47,6 +47,7 @@
 #include "ViennaRNA/datastructures/char_stream.h"
 #include "ViennaRNA/datastructures/stream_output.h"
 #include "ViennaRNA/combinatorics.h"
+#include "ViennaRNA/utils/timing.h"
 #include "ViennaRNA/color_output.inc"
 
 #include "RNAfold_cmdl.h"
@@ -66,6 +67,7 @@ struct options {
   double          MEAgamma;
   double          bppmThreshold;
   int             verbose;
+  int             timing;
   char            *ligandMotif;
   vrna_cmd_t      cmds;
   vrna_md_t       md;
@@ -103,6 +105,17 @@ struct record_data {
 };
 
 
+/* maximum number of records and nucleotides passed to a worker thread at once */
+#define RECORD_BATCH_SIZE     64
+#define RECORD_BATCH_LENGTH   10000
+
+struct record_batch {
+  unsigned int        num;
+  size_t              length;
+  struct record_data  *records[RECORD_BATCH_SIZE];
+};
+
+
 struct output_stream {
   vrna_cstr_t data;
   int         individual;
@@ -192,6 +205,19 @@ static void
 process_record(struct record_data *record);
 
 
+static void
+process_batch(struct record_batch *batch);
+
+
+static unsigned int
+read_input_record(vrna_fasta_reader_t  reader,
+                  FILE                *input_stream,
+                  char                **id,
+                  char                **sequence,
+                  char                ***rest,
+                  unsigned int        options);
+
+
 /*--------------------------------------------------------------------------*/
 void
 flush_cstr_callback(void          *auxdata,
@@ -367,6 +393,7 @@ init_default_options(struct options *opt)
   opt->MEAgamma       = 1.;
   opt->bppmThreshold  = 1e-5;
   opt->verbose        = 0;
+  opt->timing         = 0;
   opt->ligandMotif    = NULL;
   opt->cmds           = NULL;
   set_model_details(&(opt->md));
@@ -504,6 +531,15 @@ main(int  argc,
   if (args_info.filename_full_given)
     opt.filename_full = 1;
 
+  if (args_info.timing_given) {
+#ifdef VRNA_WITH_TIMING
+    opt.timing = 1;
+#else
+    vrna_message_warning(
+      "This version of RNAfold has been built without timing instrumentation");
+#endif
+  }
+
   if (args_info.jobs_given) {
 #if VRNA_WITH_PTHREADS
     int thread_max = max_user_threads();
@@ -698,11 +734,14 @@ process_input(FILE            *input_stream,
               const char      *input_filename,
               struct options  *opt)
 {
-  int           ret       = 1;
-  int           istty_in  = isatty(fileno(input_stream));
-  int           istty_out = isatty(fileno(stdout));
+  int                 ret       = 1;
+  int                 istty_in  = isatty(fileno(input_stream));
+  int                 istty_out = isatty(fileno(stdout));
 
-  unsigned int  read_opt = 0;
+  unsigned int        read_opt    = 0;
+  unsigned int        batch_size  = RECORD_BATCH_SIZE;
+  vrna_fasta_reader_t reader      = NULL;
+  struct record_batch *batch      = NULL;
 
   /* print user help if we get input from tty */
   if (istty_in && istty_out) {
@@ -721,6 +760,20 @@ process_input(FILE            *input_stream,
   if (!fold_constrained)
     read_opt |= VRNA_INPUT_NO_REST;
 
+  /*
+   * read non-interactive input in large blocks and hand the records over
+   * to the worker threads in batches
+   */
+  if (!istty_in) {
+    reader = vrna_file_fasta_reader_init(input_stream);
+    if (!reader)
+      vrna_message_error("Unable to read input from \"%s\"",
+                         (input_filename) ? input_filename : "stdin");
+  }
+
+  if ((!reader) || (opt->jobs == 1))
+    batch_size = 1;
+
   /* main loop that processes each record obtained from input stream */
   do {
     char          *rec_sequence, *rec_id, **rec_rest;
@@ -731,11 +784,12 @@ process_input(FILE            *input_stream,
     rec_rest        = NULL;
     maybe_multiline = 0;
 
-    rec_type = vrna_file_fasta_read_record(&rec_id,
-                                           &rec_sequence,
-                                           &rec_rest,
-                                           input_stream,
-                                           read_opt);
+    rec_type = read_input_record(reader,
+                                 input_stream,
+                                 &rec_id,
+                                 &rec_sequence,
+                                 &rec_rest,
+                                 read_opt);
 
     if (rec_type & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT))
       break;
@@ -769,7 +823,19 @@ process_input(FILE            *input_stream,
     if (opt->output_queue)
       vrna_ostream_request(opt->output_queue, opt->next_record_number++);
 
-    RUN_IN_PARALLEL(process_record, record);
+    if (!batch)
+      batch = (struct record_batch *)vrna_alloc(sizeof(struct record_batch));
+
+    batch->records[batch->num++]  = record;
+    batch->length                 += strlen(rec_sequence);
+
+    if ((batch->num == batch_size) ||
+        (batch->length >= RECORD_BATCH_LENGTH)) {
+      /* keep the reader at most two batches per thread ahead of the workers */
+      WAIT_FOR_JOB_SLOT(2 * opt->jobs);
+      RUN_IN_PARALLEL(process_batch, batch);
+      batch = NULL;
+    }
 
     if (opt->shape || (opt->constraint_file && (!opt->constraint_batch))) {
       ret = 0;
@@ -788,10 +854,63 @@ process_input(FILE            *input_stream,
     }
   } while (1);
 
+  /* process the remaining records */
+  if (batch) {
+    WAIT_FOR_JOB_SLOT(2 * opt->jobs);
+    RUN_IN_PARALLEL(process_batch, batch);
+  }
+
+  vrna_file_fasta_reader_free(reader);
+
   return ret;
 }
 
 
+static unsigned int
+read_input_record(vrna_fasta_reader_t  reader,
+                  FILE                *input_stream,
+                  char                **id,
+                  char                **sequence,
+                  char                ***rest,
+                  unsigned int        options)
+{
+  unsigned int        i, rec_type;
+  vrna_fasta_record_t record;
+
+  if (!reader)
+    return vrna_file_fasta_read_record(id, sequence, rest, input_stream, options);
+
+  rec_type = vrna_file_fasta_read_record_view(reader, &record, options);
+
+  if (rec_type & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT))
+    return rec_type;
+
+  /* the records outlive the read buffer, so we need our own copies */
+  *id       = (record.header) ? strdup(record.header) : NULL;
+  *sequence = (record.sequence) ? strdup(record.sequence) : NULL;
+  *rest     = (char **)vrna_alloc(sizeof(char *) * (record.rest_count + 1));
+
+  for (i = 0; i < record.rest_count; i++)
+    (*rest)[i] = strdup(record.rest[i]);
+
+  return rec_type;
+}
+
+
+static void
+process_batch(struct record_batch *batch)
+{
+  unsigned int i;
+
+  for (i = 0; i < batch->num; i++)
+    process_record(batch->records[i]);
+
+  free(batch);
+
+  RELEASE_JOB_SLOT
+}
+
+
 static void
 process_record(struct record_data *record)
 {
@@ -817,6 +936,9 @@ process_record(struct record_data *record)
 
   vc = vrna_fold_compound(rec_sequence, &(opt->md), VRNA_OPTION_DEFAULT);
 
+  if (opt->timing)
+    vrna_timing_enable(vc, 1);
+
   length = vc->length;
 
   if ((opt->md.circ) && (vrna_rotational_symmetry(rec_sequence) > 1))
@@ -1050,6 +1172,15 @@ process_record(struct record_data *record)
     ATOMIC_BLOCK(flush_cstr_callback(NULL, record->number, (void *)o_stream));
   }
 
+  if (opt->timing) {
+    char *title = (record->SEQ_ID) ?
+                  vrna_strdup_printf("Timings for %s", record->SEQ_ID) :
+                  vrna_strdup_printf("Timings for sequence %u", record->number + 1);
+
+    ATOMIC_BLOCK(vrna_timing_print(stderr, vc, title));
+    free(title);
+  }
+
   /* clean up */
   vrna_fold_compound_free(vc);
   free(record->id);
@@ -43,18 +43,22 @@ main(int  argc,
   char                        *input_string, *start, *structure, *rstart, *str2,
                               *ParamFile, *c, *ns_bases;
   int                         input_type, i, length, l, hd, sym, pf, mfe, istty, repeat,
-                              found;
+                              found, starts, jobs;
+  unsigned int                starts_options;
   double                      energy, kT;
 
-  ParamFile     = NULL;
-  energy        = 0.;
-  dangles       = 2;
-  do_backtrack  = 0;
-  pf            = 0;
-  mfe           = 1;
-  repeat        = 0;
-  input_type    = 0;
-  input_string  = ns_bases = NULL;
+  ParamFile       = NULL;
+  energy          = 0.;
+  dangles         = 2;
+  do_backtrack    = 0;
+  pf              = 0;
+  mfe             = 1;
+  repeat          = 0;
+  starts          = 1;
+  jobs            = 0;
+  starts_options  = 0;
+  input_type      = 0;
+  input_string    = ns_bases = NULL;
   vrna_init_rand();
 
   /*
@@ -131,6 +135,21 @@ main(int  argc,
   if (args_info.final_given)
     final_cost = args_info.final_arg;
 
+  /* number of independent adaptive walks per search */
+  if (args_info.starts_given) {
+    starts = args_info.starts_arg;
+    if (starts < 1) {
+      vrna_message_warning("Number of starts must be positive, falling back to a single walk");
+      starts = 1;
+    }
+  }
+
+  if (args_info.first_given)
+    starts_options |= VRNA_INVERSE_FIRST;
+
+  if (args_info.jobs_given)
+    jobs = args_info.jobs_arg;
+
   /* do we wannabe verbose */
   if (args_info.verbose_given)
     inv_verbose = 1;
@@ -256,7 +275,11 @@ main(int  argc,
       strcpy(rstart, string); /* remember start string */
 
       if (mfe) {
-        energy = inverse_fold(string, structure);
+        if (starts > 1)
+          energy = inverse_fold_multistart(string, structure, starts, jobs, starts_options);
+        else
+          energy = inverse_fold(string, structure);
+
         if ((repeat >= 0) || (energy <= 0.0)) {
           found--;
           hd = vrna_hamming_distance(rstart, string);
@@ -288,7 +311,11 @@ main(int  argc,
           pf_scale  = exp(-(sfact * min_en) / kT / length);
           /* init_pf_fold(length); <- obsolete (hopefully commenting this out does not affect anything crucial ;) */
 
-          energy  = inverse_pf_fold(string, structure);
+          if (starts > 1)
+            energy = inverse_pf_fold_multistart(string, structure, starts, jobs, starts_options);
+          else
+            energy = inverse_pf_fold(string, structure);
+
           prob    = exp(-energy / kT);
           hd      = vrna_hamming_distance(rstart, string);
           char *msg = vrna_strdup_printf("  %3d  (%g)", hd, prob);
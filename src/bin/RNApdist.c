@@ -28,7 +28,6 @@
 
 
 #define MAXLENGTH  10000
-#define MAXSEQ      1000
 
 PRIVATE void command_line(int       argc,
                           char      *argv[],
@@ -40,6 +39,9 @@ PRIVATE void print_aligned_lines(FILE *somewhere);
 
 PRIVATE char  task;
 PRIVATE char  outfile[FILENAME_MAX_LENGTH];
+PRIVATE int   jobs = 0;
+PRIVATE char  *matrix_file;
+PRIVATE int   matrix_format;
 PRIVATE char  ruler[] = "....,....1....,....2....,....3....,....4"
                         "....,....5....,....6....,....7....,....8";
 static int    noconv = 0;
@@ -49,11 +51,11 @@ main(int  argc,
      char *argv[])
 
 {
-  float     *T[MAXSEQ];
-  int       i, j, istty, n = 0;
+  float     **T, *matrix;
+  int       i, j, istty, n = 0, size;
   int       type, taxa_list = 0;
   float     dist;
-  FILE      *somewhere = NULL;
+  FILE      *somewhere = NULL, *matrix_out = NULL;
   char      *structure;
   char      *line = NULL, fname[FILENAME_MAX_LENGTH], *list_title = NULL;
   plist     *pr_pl, *mfe_pl;
@@ -75,6 +77,16 @@ main(int  argc,
   if (somewhere == NULL)
     somewhere = stdout;
 
+  if (matrix_file) {
+    matrix_out = fopen(matrix_file, (matrix_format == VRNA_DIST_MATRIX_BINARY) ? "wb" : "w");
+    if (!matrix_out)
+      vrna_message_error("Can't open matrix file \"%s\"", matrix_file);
+  }
+
+  /* storage for the profiles of a distance matrix, grows on demand */
+  size  = 0;
+  T     = NULL;
+
   istty = (isatty(fileno(stdout)) && isatty(fileno(stdin)));
 
   while (1) {
@@ -143,16 +155,31 @@ main(int  argc,
         printf("* END of taxa list\n");
 
       printf("> p %d (pdist)\n", n);
-      for (i = 1; i < n; i++) {
-        for (j = 0; j < i; j++) {
-          printf("%g ", profile_edit_distance(T[i], T[j]));
-          if (edit_backtrack)
+      if (edit_backtrack) {
+        /* alignments are computed sequentially */
+        matrix = (float *)vrna_alloc(sizeof(float) * ((n * (n - 1)) / 2 + 1));
+        for (i = 1; i < n; i++)
+          for (j = 0; j < i; j++) {
+            matrix[VRNA_DIST_MATRIX_INDEX(n, j, i)] = profile_edit_distance(T[i], T[j]);
             fprintf(somewhere, "> %d %d\n", i + 1, j + 1);
+            print_aligned_lines(somewhere);
+          }
+      } else {
+        matrix = profile_edit_distance_matrix(T, n, jobs);
+        if (!matrix)
+          vrna_message_error("Failed to compute distance matrix");
+      }
 
-          print_aligned_lines(somewhere);
-        }
+      for (i = 1; i < n; i++) {
+        for (j = 0; j < i; j++)
+          printf("%g ", matrix[VRNA_DIST_MATRIX_INDEX(n, j, i)]);
         printf("\n");
       }
+
+      if (matrix_out)
+        vrna_file_distance_matrix(matrix_out, matrix, n, NULL, matrix_format);
+
+      free(matrix);
       if (type == 888) {
         /* do another distance matrix */
         n = 0;
@@ -170,9 +197,15 @@ main(int  argc,
       if (outfile[0] != '\0')
         (void)fclose(somewhere);
 
+      if (matrix_out)
+        (void)fclose(matrix_out);
+
       if (line != NULL)
         free(line);
 
+      free(T);
+      free(matrix_file);
+
       return 0; /* finito */
     }
 
@@ -200,6 +233,11 @@ main(int  argc,
     /* call threadsafe dot plot printing function */
     PS_dot_plot_list(line, fname, pr_pl, mfe_pl, "");
 
+    if (n == size) {
+      size  = (size) ? 2 * size : 128;
+      T     = (float **)vrna_realloc(T, sizeof(float *) * size);
+    }
+
     T[n] = Make_bp_profile_bppm(vc->exp_matrices->probs, vc->length);
 
     if ((istty) && (task == 'm'))
@@ -345,6 +383,27 @@ command_line(int        argc,
     edit_backtrack = 1;
   }
 
+  if (args_info.jobs_given)
+    jobs = args_info.jobs_arg;
+
+  if (args_info.matrix_file_given)
+    matrix_file = strdup(args_info.matrix_file_arg);
+
+  matrix_format = VRNA_DIST_MATRIX_PHYLIP;
+  if (args_info.matrix_format_given) {
+    switch (args_info.matrix_format_arg[0]) {
+      case 'p':
+        matrix_format = VRNA_DIST_MATRIX_PHYLIP;
+        break;
+      case 'b':
+        matrix_format = VRNA_DIST_MATRIX_BINARY;
+        break;
+      default:
+        RNApdist_cmdline_parser_print_help();
+        exit(EXIT_FAILURE);
+    }
+  }
+
   /* free allocated memory of command line data structure */
   RNApdist_cmdline_parser_free(&args_info);
 
@@ -14,10 +14,17 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
+#include <stdint.h>
 #include <time.h>
+#include <fcntl.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <unistd.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/params/basic.h"
@@ -33,8 +40,12 @@
 #include "ViennaRNA/plotting/alignments.h"
 #include "ViennaRNA/params/io.h"
 #include "ViennaRNA/io/utils.h"
+#include "ViennaRNA/datastructures/char_stream.h"
+#include "ViennaRNA/datastructures/stream_output.h"
 #include "RNAplex_cmdl.h"
 
+#include "parallel_helpers.h"
+
 
 clock_t
 BeginTimer()
@@ -154,9 +165,160 @@ double probcompute_newparameters(char   *s1,
 static int convert_plfold_i(char *fname);/* convert test accessibility into bin accessibility. */
 
 
+static int get_plfold_i_dimensions(const char *fname,
+                                   int        *u_length,
+                                   int        *length);
+
+
+/**
+ * Indexed binary store of opening energy profiles. A single store file
+ * holds the profiles of many RNAs in the same layout as the _openen_bin
+ * files. The store is mapped into memory once and profiles are handed
+ * out as row pointers into the mapping, i.e. without copying or parsing.
+ * Only rescaled profiles (-V option) are copied, since the store keeps
+ * the unscaled opening energies.
+ */
+#define ACCESS_STORE_MAGIC    "VRNAPLXA"
+#define ACCESS_STORE_VERSION  1
+
+struct access_store_header {
+  char    magic[8];
+  int32_t version;
+  int32_t num_profiles;
+  int64_t index_offset;   /* start of the (sorted) profile index */
+  int64_t names_offset;   /* start of the profile names */
+};
+
+struct access_store_entry {
+  int64_t name_offset;    /* relative to names_offset */
+  int64_t data_offset;    /* (u_length + 2) rows of (length + 20) ints */
+  int32_t u_length;
+  int32_t length;
+};
+
+typedef struct {
+  char                              *data;
+  size_t                            size;
+  const struct access_store_header  *header;
+  const struct access_store_entry   *index;
+  double                            scale;  /* scaling factor of the opening energies */
+} access_store;
+
+
+static int create_access_store(const char *dirname,
+                               const char *fname);
+
+
+static access_store *open_access_store(const char  *fname,
+                                       double      scale);
+
+
+static void close_access_store(access_store *store);
+
+
+static int **fetch_access_store(const access_store  *store,
+                                const char          *id,
+                                const int           end,
+                                const int           length,
+                                int                 fast);
+
+
+static void free_plfold_i(int           **access,
+                          access_store  *store);
+
+
 static char scale[] = "....,....1....,....2....,....3....,....4"
                       "....,....5....,....6....,....7....,....8";
 
+
+/**
+ * Settings of the target-query interaction jobs (-t and -q options)
+ */
+struct options {
+  int             jobs;
+  int             keep_order;
+  unsigned int    next_record_number;
+  vrna_ostream_t  output_queue;
+  access_store    *store;
+  int             delta;
+  int             extension_cost;
+  int             alignment_length;
+  int             deltaz;
+  int             fast;
+  int             il_a;
+  int             il_b;
+  int             b_a;
+  int             b_b;
+};
+
+
+/**
+ * A target sequence and its accessibility profile, shared by all jobs
+ * of the target. The last job to release it frees it.
+ */
+struct target_data {
+  char          *id;
+  char          *s;
+  int           **access;
+  unsigned int  refs;
+};
+
+
+struct record_data {
+  unsigned int        number;
+  struct target_data  *target;
+  char                *id;
+  char                *s;
+  int                 **access;
+  char                *structure;
+  struct options      *options;
+};
+
+
+static struct target_data *new_target(char  *id,
+                                      char  *s,
+                                      int   **access);
+
+
+static void release_target(struct target_data *target,
+                           access_store       *store);
+
+
+static void add_interaction(struct options      *opt,
+                            struct target_data  *target,
+                            char                *id,
+                            char                *s,
+                            int                 **access,
+                            char                *structure);
+
+
+static void process_record(struct record_data *record);
+
+
+static void print_message(struct options  *opt,
+                          const char      *format,
+                          ...);
+
+
+/*
+ * options of the target-query jobs, if any. The profile readers print
+ * their messages in order with the output of the jobs
+ */
+static struct options *job_options = NULL;
+
+
+static void
+flush_cstr_callback(void          *auxdata,
+                    unsigned int  i,
+                    void          *data)
+{
+  vrna_cstr_t s = (vrna_cstr_t)data;
+
+  /* flush/free data */
+  vrna_cstr_free(s);
+}
+
+
 /*--------------------------------------------------------------------------*/
 
 int
@@ -193,6 +355,8 @@ main(int  argc,
   int                             redraw            = 0;
   int                             binaries          = 0;
   int                             convert           = 0;
+  char                            *store_file       = NULL;
+  access_store                    *store            = NULL;
   /**
    * Defines how many nucleotides has to be added at the begining and end of the target and query sequence in order to generate the structure figure
    */
@@ -211,6 +375,14 @@ main(int  argc,
   double                          k_concentration     = 0;
   double                          tris_concentration  = 0;
   int                             probe_mode          = 0;
+  struct options                  opt;
+
+  opt.jobs                = 1;
+  opt.keep_order          = 1;
+  opt.next_record_number  = 0;
+  opt.output_queue        = NULL;
+  opt.store               = NULL;
+
   /*
    #############################################
    # check the command line parameters
@@ -271,6 +443,10 @@ main(int  argc,
   if (args_info.convert_to_bin_given)
     convert = 1;
 
+  /*create_store*/
+  if (args_info.create_store_given)
+    store_file = strdup(args_info.create_store_arg);
+
   /*alignment_mode*/
   if (args_info.alignment_mode_given)
     alignment_mode = 1;
@@ -290,6 +466,34 @@ main(int  argc,
   /*probe concentration*/
   probe_concentration = args_info.probe_concentration_arg;
 
+  /*parallel processing of target-query pairs*/
+  if (args_info.jobs_given) {
+#if VRNA_WITH_PTHREADS
+    int thread_max = max_user_threads();
+    if (args_info.jobs_arg == 0) {
+      /* use maximum of concurrent threads */
+      int proc_cores, proc_cores_conf;
+      if (num_proc_cores(&proc_cores, &proc_cores_conf)) {
+        opt.jobs = MIN2(thread_max, proc_cores_conf);
+      } else {
+        vrna_message_warning("Could not determine number of available processor cores!\n"
+                             "Defaulting to serial computation");
+        opt.jobs = 1;
+      }
+    } else {
+      opt.jobs = MIN2(thread_max, args_info.jobs_arg);
+    }
+
+    opt.jobs = MAX2(1, opt.jobs);
+#else
+    vrna_message_warning(
+      "This version of RNAplex has been built without parallel input processing capabilities");
+#endif
+
+    if (args_info.unordered_given)
+      opt.keep_order = 0;
+  }
+
   /*Probe mode Salt concentration*/
   if (ParamFile != NULL)
     read_parameter_file(ParamFile);
@@ -395,6 +599,35 @@ main(int  argc,
     return 0;
   }
 
+  /**
+   * Here we check if the user wants to pack all text opening energy files
+   * of a directory into a single indexed binary store
+   */
+  if (store_file && access) {
+    if (create_access_store(access, store_file) < 0)
+      vrna_message_warning("Failed to create accessibility store %s", store_file);
+
+    free(store_file);
+    RNAplex_cmdline_parser_free(&args_info);
+    return 0;
+  }
+
+  /**
+   * An accessibility location that is a regular file instead of a directory
+   * denotes an indexed binary store which we map into memory once
+   */
+  if (access) {
+    struct stat st;
+    if ((stat(access, &st) == 0) && (S_ISREG(st.st_mode))) {
+      if (alignment_mode)
+        vrna_message_error("Accessibility stores are not supported in alignment mode");
+
+      store = open_access_store(access, verhaeltnis);
+      if (!store)
+        vrna_message_error("Unable to read accessibility store %s", access);
+    }
+  }
+
   if (convert && access) {
     char          pattern[8];
     strcpy(pattern, "_openen");
@@ -543,6 +776,25 @@ main(int  argc,
     /*free allocated memory of commandline parser*/
     RNAplex_cmdline_parser_free(&args_info);
 
+    /*each target-query pair is processed as a separate job*/
+    opt.store             = store;
+    opt.delta             = delta;
+    opt.extension_cost    = extension_cost;
+    opt.alignment_length  = alignment_length;
+    opt.deltaz            = deltaz;
+    opt.fast              = fast;
+    opt.il_a              = il_a;
+    opt.il_b              = il_b;
+    opt.b_a               = b_a;
+    opt.b_b               = b_b;
+
+    if (opt.keep_order)
+      opt.output_queue = vrna_ostream_init(&flush_cstr_callback, NULL);
+
+    job_options = &opt;
+
+    INIT_PARALLELIZATION(opt.jobs);
+
     if (!fold_constrained) {
       if (access) {
         char *id_s1 = NULL;
@@ -617,7 +869,9 @@ main(int  argc,
           strcat(file_s1, "/");
           strcat(file_s1, id_s1);
           strcat(file_s1, "_openen");
-          if (!binaries) {
+          if (store) {
+            access_s1 = fetch_access_store(store, id_s1, s1_len, alignment_length, fast);
+          } else if (!binaries) {
             access_s1 = read_plfold_i(file_s1, 1, s1_len, verhaeltnis, alignment_length, fast);
           } else {
             strcat(file_s1, "_bin");
@@ -625,7 +879,7 @@ main(int  argc,
           }
 
           if (access_s1 == NULL) {
-            printf("Accessibility file %s not found or corrupt, look at next target RNA\n", file_s1);
+            print_message(&opt, "Accessibility file %s not found or corrupt, look at next target RNA\n", file_s1);
             free(file_s1);
             free(s1);
             free(id_s1);
@@ -633,6 +887,8 @@ main(int  argc,
             continue;
           }
 
+          struct target_data *target = new_target(id_s1, s1, access_s1);
+
           do {
             char *id_s2 = NULL;
             if ((line_q = vrna_read_line(sRNA)) == NULL)
@@ -691,7 +947,9 @@ main(int  argc,
             strcat(file_s2, "/");
             strcat(file_s2, id_s2);
             strcat(file_s2, "_openen");
-            if (!binaries) {
+            if (store) {
+              access_s2 = fetch_access_store(store, id_s2, s2_len, alignment_length, fast);
+            } else if (!binaries) {
               access_s2 = read_plfold_i(file_s2, 1, s2_len, verhaeltnis, alignment_length, fast);
             } else {
               strcat(file_s2, "_bin");
@@ -699,7 +957,7 @@ main(int  argc,
             }
 
             if (access_s2 == NULL) {
-              printf("Accessibility file %s not found, look at next target RNA\n", file_s2);
+              print_message(&opt, "Accessibility file %s not found, look at next target RNA\n", file_s2);
               free(file_s2);
               free(s2);
               free(id_s2);
@@ -707,32 +965,14 @@ main(int  argc,
               continue;
             }
 
-            printf(">%s\n>%s\n", id_s1, id_s2);
-            double  begin = BeginTimer();
-            Lduplexfold_XS(s1, s2, (const int **)access_s1, (const int **)access_s2, delta, alignment_length, deltaz, fast, il_a, il_b, b_a, b_b);
-            float   elapTicks;
-            float   elapMilli;
-            elapTicks = (EndTimer(begin) - begin);
-            elapMilli = elapTicks / 1000;
-            /*             printf("Millisecond %.2f\n",elapMilli); */
-            free(id_s2);
+            add_interaction(&opt, target, id_s2, s2, access_s2, NULL);
             free(file_s2);
-            free(s2);
             id_s2 = NULL;
-            i     = access_s2[0][0];
-            while (--i > -1)
-              free(access_s2[i]);
-            free(access_s2);
           } while (1);
-          free(id_s1);
           id_s1 = NULL;
           free(file_s1);
-          free(s1);
           rewind(sRNA);
-          i = access_s1[0][0];
-          while (--i > -1)
-            free(access_s1[i]);
-          free(access_s1);
+          release_target(target, store);
         } while (1);
         fclose(mRNA);
         fclose(sRNA);
@@ -802,6 +1042,9 @@ main(int  argc,
             if (!noconv && s1[l] == 'T')
               s1[l] = 'U';
           }
+
+          struct target_data *target = new_target(id_s1, s1, NULL);
+
           do {
             /*read sRNA files*/
             char *id_s2 = NULL;
@@ -852,23 +1095,12 @@ main(int  argc,
               if (!noconv && s2[l] == 'T')
                 s2[l] = 'U';
             }
-            printf(">%s\n>%s\n", id_s1, id_s2);
-            /*             double begin = BeginTimer(); */
-            Lduplexfold(s1, s2, delta, extension_cost, alignment_length, deltaz, fast, il_a, il_b, b_a, b_b);
-            /* float elapTicks; */
-            /* float elapMilli; */
-            /* elapTicks = (EndTimer(begin) - begin); */
-            /* elapMilli = elapTicks/1000; */
-            /* printf("Millisecond %.2f\n",elapMilli); */
-            /* printf("\n"); */
-            free(id_s2);
+            add_interaction(&opt, target, id_s2, s2, NULL, NULL);
             id_s2 = NULL;
-            free(s2);
           } while (1);
-          free(id_s1);
           id_s1 = NULL;
-          free(s1);
           rewind(sRNA);
+          release_target(target, store);
         } while (1);
         fclose(mRNA);
         fclose(sRNA);
@@ -948,7 +1180,9 @@ main(int  argc,
           strcat(file_s1, "/");
           strcat(file_s1, id_s1);
           strcat(file_s1, "_openen");
-          if (!binaries) {
+          if (store) {
+            access_s1 = fetch_access_store(store, id_s1, s1_len, alignment_length, fast);
+          } else if (!binaries) {
             access_s1 = read_plfold_i(file_s1, 1, s1_len, verhaeltnis, alignment_length, fast);
           } else {
             strcat(file_s1, "_bin");
@@ -956,7 +1190,7 @@ main(int  argc,
           }
 
           if (access_s1 == NULL) {
-            printf("Accessibility file %s not found, look at next target RNA\n", file_s1);
+            print_message(&opt, "Accessibility file %s not found, look at next target RNA\n", file_s1);
             free(file_s1);
             free(s1);
             free(id_s1);
@@ -964,6 +1198,8 @@ main(int  argc,
             continue;
           }
 
+          struct target_data *target = new_target(id_s1, s1, access_s1);
+
           do {
             char *id_s2 = NULL;
             /*read sRNA files*/
@@ -1041,7 +1277,9 @@ main(int  argc,
             strcat(file_s2, "/");
             strcat(file_s2, id_s2);
             strcat(file_s2, "_openen");
-            if (!binaries) {
+            if (store) {
+              access_s2 = fetch_access_store(store, id_s2, s2_len, alignment_length, fast);
+            } else if (!binaries) {
               access_s2 = read_plfold_i(file_s2, 1, s2_len, verhaeltnis, alignment_length, fast);
             } else {
               strcat(file_s2, "_bin");
@@ -1049,33 +1287,21 @@ main(int  argc,
             }
 
             if (access_s2 == NULL) {
-              printf("Accessibility file %s not found, look at next target RNA\n", file_s2);
+              print_message(&opt, "Accessibility file %s not found, look at next target RNA\n", file_s2);
               free(file_s2);
               free(s2);
               free(id_s2);
+              free(structure);
               continue;
             }
 
-            printf(">%s\n>%s\n", id_s1, id_s2);
-            Lduplexfold_CXS(s1, s2, (const int **)access_s1, (const int **)access_s2, delta, alignment_length, deltaz, fast, structure, il_a, il_b, b_a, b_b);/* , target_dead, query_dead); */
-            free(id_s2);
+            add_interaction(&opt, target, id_s2, s2, access_s2, structure);
             free(file_s2);
-            free(s2);
-            i = access_s2[0][0];
-            while (--i > -1)
-              free(access_s2[i]);
-            free(access_s2);
-            free(structure);
           } while (1);
-          free(id_s1);
           id_s1 = NULL;
           free(file_s1);
-          free(s1);
           rewind(sRNA);
-          i = access_s1[0][0];
-          while (--i > -1)
-            free(access_s1[i]);
-          free(access_s1);
+          release_target(target, store);
         } while (1);
         fclose(mRNA);
         fclose(sRNA);
@@ -1146,6 +1372,9 @@ main(int  argc,
             if (!noconv && s1[l] == 'T')
               s1[l] = 'U';
           }
+
+          struct target_data *target = new_target(id_s1, s1, NULL);
+
           do {
             char *id_s2 = NULL;
             /*read sRNA files*/
@@ -1216,27 +1445,21 @@ main(int  argc,
             if (alignment_length < b - a + 1)
               vrna_message_error("Maximal duplex length (-l option) is smaller than constraint on the structures\n. Please adjust the -l option accordingly\n");
 
-            printf(">%s\n>%s\n", id_s1, id_s2);
-            double  begin = BeginTimer();
-            Lduplexfold_C(s1, s2, delta, extension_cost, alignment_length, deltaz, fast, structure, il_a, il_b, b_a, b_b);
-            float   elapTicks;
-            float   elapMilli;
-            elapTicks = EndTimer(begin);
-            elapMilli = elapTicks / 1000;
-            /*             printf("Millisecond %.2f\n",elapMilli); */
-            free(id_s2);
-            free(s2);
-            free(structure);
+            add_interaction(&opt, target, id_s2, s2, NULL, structure);
           } while (1);
-          free(id_s1);
           id_s1 = NULL;
-          free(s1);
           rewind(sRNA);
+          release_target(target, store);
         } while (1);
         fclose(mRNA);
         fclose(sRNA);
       }
     }
+
+    UNINIT_PARALLELIZATION
+
+    job_options = NULL;
+    vrna_ostream_free(opt.output_queue);
   } else if (!qname && !tname && !(alignment_mode)) {
     istty = isatty(fileno(stdout)) && isatty(fileno(stdin));
 
@@ -1383,7 +1606,9 @@ main(int  argc,
         strcat(file_s2, id_s2);
         strcat(file_s1, "_openen");
         strcat(file_s2, "_openen");
-        if (!binaries) {
+        if (store) {
+          access_s1 = fetch_access_store(store, id_s1, s1_len, alignment_length, fast);
+        } else if (!binaries) {
           access_s1 = read_plfold_i(file_s1, 1, s1_len, verhaeltnis, alignment_length, fast);
         } else {
           strcat(file_s1, "_bin");
@@ -1400,7 +1625,9 @@ main(int  argc,
           continue;
         }
 
-        if (!binaries) {
+        if (store) {
+          access_s2 = fetch_access_store(store, id_s2, s2_len, alignment_length, fast);
+        } else if (!binaries) {
           access_s2 = read_plfold_i(file_s2, 1, s2_len, verhaeltnis, alignment_length, fast);
         } else {
           strcat(file_s2, "_bin");
@@ -1408,7 +1635,7 @@ main(int  argc,
         }
 
         if (access_s2 == NULL) {
-          free(access_s1);
+          free_plfold_i(access_s1, store);
           free(file_s1);
           free(s1);
           free(s2);
@@ -1429,14 +1656,8 @@ main(int  argc,
           Lduplexfold_CXS(s1, s2, (const int **)access_s1, (const int **)access_s2, delta, alignment_length, deltaz, fast, structure, il_a, il_b, b_a, b_b);/* , target_dead, query_dead); */
         }
 
-        i = access_s1[0][0];
-        while (--i > -1)
-          free(access_s1[i]);
-        i = access_s2[0][0];
-        while (--i > -1)
-          free(access_s2[i]);
-        free(access_s1);
-        free(access_s2);
+        free_plfold_i(access_s1, store);
+        free_plfold_i(access_s2, store);
         free(file_s1);
         free(file_s2);
         free(id_s1);
@@ -1556,6 +1777,8 @@ main(int  argc,
     access = NULL;
   }
 
+  close_access_store(store);
+
   if (qname) {
     free(tname);
     access = NULL;
@@ -1571,6 +1794,157 @@ main(int  argc,
 }
 
 
+static struct target_data *
+new_target(char *id,
+           char *s,
+           int  **access)
+{
+  struct target_data *target = (struct target_data *)vrna_alloc(sizeof(struct target_data));
+
+  target->id      = id;
+  target->s       = s;
+  target->access  = access;
+  target->refs    = 1; /* the reading loop holds the first reference */
+
+  return target;
+}
+
+
+static void
+release_target(struct target_data *target,
+               access_store       *store)
+{
+  unsigned int refs;
+
+  ATOMIC_BLOCK(refs = --target->refs);
+
+  if (refs == 0) {
+    free(target->id);
+    free(target->s);
+    free_plfold_i(target->access, store);
+    free(target);
+  }
+}
+
+
+/**
+ * Hand over a query and its target to the next free compute slot. The job
+ * takes ownership of the query id, sequence, accessibility and constraint.
+ */
+static void
+add_interaction(struct options      *opt,
+                struct target_data  *target,
+                char                *id,
+                char                *s,
+                int                 **access,
+                char                *structure)
+{
+  struct record_data *record = (struct record_data *)vrna_alloc(sizeof(struct record_data));
+
+  ATOMIC_BLOCK(target->refs++);
+
+  record->number    = opt->next_record_number;
+  record->target    = target;
+  record->id        = id;
+  record->s         = s;
+  record->access    = access;
+  record->structure = structure;
+  record->options   = opt;
+
+  if (opt->output_queue)
+    vrna_ostream_request(opt->output_queue, opt->next_record_number++);
+
+  RUN_IN_PARALLEL(process_record, record);
+}
+
+
+static void
+process_record(struct record_data *record)
+{
+  vrna_cstr_t         o_stream;
+  struct options      *opt;
+  struct target_data  *target;
+
+  opt       = record->options;
+  target    = record->target;
+  o_stream  = vrna_cstr(100, stdout);
+
+  vrna_cstr_printf(o_stream, ">%s\n>%s\n", target->id, record->id);
+
+  /* collect the hits of this job */
+  plex_output_stream(o_stream);
+
+  if (target->access) {
+    if (record->structure)
+      Lduplexfold_CXS(target->s, record->s,
+                      (const int **)target->access, (const int **)record->access,
+                      opt->delta, opt->alignment_length, opt->deltaz, opt->fast,
+                      record->structure, opt->il_a, opt->il_b, opt->b_a, opt->b_b);
+    else
+      Lduplexfold_XS(target->s, record->s,
+                     (const int **)target->access, (const int **)record->access,
+                     opt->delta, opt->alignment_length, opt->deltaz, opt->fast,
+                     opt->il_a, opt->il_b, opt->b_a, opt->b_b);
+  } else {
+    if (record->structure)
+      Lduplexfold_C(target->s, record->s,
+                    opt->delta, opt->extension_cost, opt->alignment_length, opt->deltaz, opt->fast,
+                    record->structure, opt->il_a, opt->il_b, opt->b_a, opt->b_b);
+    else
+      Lduplexfold(target->s, record->s,
+                  opt->delta, opt->extension_cost, opt->alignment_length, opt->deltaz, opt->fast,
+                  opt->il_a, opt->il_b, opt->b_a, opt->b_b);
+  }
+
+  plex_output_stream(NULL);
+
+  if (opt->output_queue)
+    vrna_ostream_provide(opt->output_queue, record->number, (void *)o_stream);
+  else
+    THREADSAFE_STREAM_OUTPUT(flush_cstr_callback(NULL, record->number, (void *)o_stream));
+
+  free(record->id);
+  free(record->s);
+  free_plfold_i(record->access, opt->store);
+  free(record->structure);
+  release_target(target, opt->store);
+  free(record);
+}
+
+
+/**
+ * Print a message in order with the output of the jobs, or directly
+ * to stdout if there are no jobs (opt == NULL)
+ */
+static void
+print_message(struct options  *opt,
+              const char      *format,
+              ...)
+{
+  va_list     args;
+  vrna_cstr_t o_stream;
+
+  va_start(args, format);
+
+  if (!opt) {
+    vprintf(format, args);
+    va_end(args);
+    return;
+  }
+
+  o_stream = vrna_cstr(100, stdout);
+  vrna_cstr_vprintf(o_stream, format, args);
+  va_end(args);
+
+  if (opt->output_queue) {
+    vrna_ostream_request(opt->output_queue, opt->next_record_number);
+    vrna_ostream_provide(opt->output_queue, opt->next_record_number++, (void *)o_stream);
+  } else {
+    THREADSAFE_STREAM_OUTPUT(flush_cstr_callback(NULL, 0, (void *)o_stream));
+  }
+}
+
+
 #if 0
 static int
 print_struc(duplexT const *dup)
@@ -1637,8 +2011,8 @@ read_plfold_i(char      *fname,
   int dim_x;
   dim_x = get_max_u(tmp, '\t');
   if (length > dim_x && fast == 0) {
-    printf("Interaction length %d is larger than the length of the largest region %d \nfor which the opening energy was computed (-u parameter of RNAplfold)\n", length, dim_x);
-    printf("Please recompute your profiles with a larger -u or set -l to a smaller interaction length\n");
+    print_message(job_options, "Interaction length %d is larger than the length of the largest region %d \nfor which the opening energy was computed (-u parameter of RNAplfold)\n", length, dim_x);
+    print_message(job_options, "Please recompute your profiles with a larger -u or set -l to a smaller interaction length\n");
     return NULL;
   }
 
@@ -1672,8 +2046,8 @@ read_plfold_i(char      *fname,
     }
   }
   if (end_r > 20) {
-    printf("Accessibility files contains %d less entries than expected based on the sequence length\n", end_r - 20);
-    printf("Please recompute your profiles so that profile length and sequence length match\n");
+    print_message(job_options, "Accessibility files contains %d less entries than expected based on the sequence length\n", end_r - 20);
+    print_message(job_options, "Please recompute your profiles so that profile length and sequence length match\n");
     return NULL;
   }
 
@@ -1687,10 +2061,11 @@ read_plfold_i(char      *fname,
 
 
 static int
-convert_plfold_i(char *fname)
+get_plfold_i_dimensions(const char  *fname,
+                        int         *u_length,
+                        int         *length)
 {
-  int   i;
-  FILE  *in = fopen(fname, "r");
+  FILE *in = fopen(fname, "r");
 
   if (in == NULL) {
     vrna_message_warning("File ' %s ' open error", fname);
@@ -1705,23 +2080,36 @@ convert_plfold_i(char *fname)
 
   if (strchr(tmp, '>')) {
     vrna_message_warning("file %s is not in RNAplfold format", fname);
+    fclose(in);
     return -1;
   }
 
   if (fgets(tmp, sizeof(tmp), in) == 0) {
     vrna_message_warning("No accessibility data");
+    fclose(in);
     return -1;
   }
 
-  int   u_length;
-  u_length = get_max_u(tmp, '\t'); /* get the x dimension */
-  char  c;
-  int   length = 0;
+  *u_length = get_max_u(tmp, '\t'); /* get the x dimension */
+  int c;
+  *length = 0;
   while ((c = fgetc(in)) != EOF)
     if (c == '\n')
-      length++;
+      (*length)++;
 
   fclose(in);
+  return 1;
+}
+
+
+static int
+convert_plfold_i(char *fname)
+{
+  int i, u_length, length;
+
+  if (get_plfold_i_dimensions(fname, &u_length, &length) < 0)
+    return -1;
+
   int   **access = read_plfold_i(fname, 1, length + 20, 1, u_length, 2);
   char  *outname;
   outname = (char *)vrna_alloc((strlen(fname) + 5) * sizeof(char));
@@ -1772,8 +2160,8 @@ read_plfold_i_bin(char      *fname,
   lim_x     = first_line[0];
   seqlength = first_line[1];                                  /* length of the sequence RNAplfold was ran on. */
   if (length > lim_x && fast == 0) {
-    printf("Interaction length %d is larger than the length of the largest region %d \nfor which the opening energy was computed (-u parameter of RNAplfold)\n", length, lim_x);
-    printf("Please recompute your profiles with a larger -u or set -l to a smaller interaction length\n");
+    print_message(job_options, "Interaction length %d is larger than the length of the largest region %d \nfor which the opening energy was computed (-u parameter of RNAplfold)\n", length, lim_x);
+    print_message(job_options, "Please recompute your profiles with a larger -u or set -l to a smaller interaction length\n");
     return NULL;
   }
 
@@ -1793,7 +2181,7 @@ read_plfold_i_bin(char      *fname,
     fseek(fp, (beg - 1) * sizeof(int), SEEK_CUR);                 /* go to the desired position, note the 10 offset */
     position = ftell(fp);
     if (!fread(access[count], sizeof(int), (end - beg) + 1, fp))  /* read the needed number of accessibility values */
-      printf("File '%s' is corrupted \n", fname);
+      print_message(job_options, "File '%s' is corrupted \n", fname);
 
     position = ftell(fp);
     fseek(fp, (seqlength - end + 20) * sizeof(int), SEEK_CUR); /* place to the begining of the next file */
@@ -1813,6 +2201,315 @@ read_plfold_i_bin(char      *fname,
 }
 
 
+struct access_store_record {
+  char                      *name;
+  struct access_store_entry entry;
+};
+
+
+static int
+compare_access_store_records(const void *a,
+                             const void *b)
+{
+  return strcmp(((const struct access_store_record *)a)->name,
+                ((const struct access_store_record *)b)->name);
+}
+
+
+static int
+create_access_store(const char  *dirname,
+                    const char  *fname)
+{
+  int                         r, n, n_max, u_length, length, **access;
+  size_t                      name_len;
+  int64_t                     offset, name_offset;
+  char                        *path, padding[8] = {
+    0
+  };
+  DIR                         *dfd;
+  FILE                        *fp;
+  struct dirent               *dir;
+  struct access_store_header  header;
+  struct access_store_record  *records;
+
+  dfd = opendir(dirname);
+  if (!dfd) {
+    vrna_message_warning("Unable to open accessibility directory %s", dirname);
+    return -1;
+  }
+
+  fp = fopen(fname, "wb");
+  if (!fp) {
+    vrna_message_warning("Unable to open %s for writing", fname);
+    closedir(dfd);
+    return -1;
+  }
+
+  /* leave room for the header, it is written once all profiles are known */
+  memset(&header, 0, sizeof(struct access_store_header));
+  fwrite(&header, sizeof(struct access_store_header), 1, fp);
+  offset = sizeof(struct access_store_header);
+
+  n       = 0;
+  n_max   = 1024;
+  records = (struct access_store_record *)vrna_alloc(sizeof(struct access_store_record) * n_max);
+
+  while ((dir = readdir(dfd)) != NULL) {
+    /* only take text opening energy files, i.e. names ending in _openen */
+    name_len = strlen(dir->d_name);
+    if ((name_len <= 7) || (strcmp(dir->d_name + name_len - 7, "_openen") != 0))
+      continue;
+
+    path = vrna_strdup_printf("%s/%s", dirname, dir->d_name);
+
+    if ((get_plfold_i_dimensions(path, &u_length, &length) > 0) &&
+        ((access = read_plfold_i(path, 1, length + 20, 1, u_length, 2)) != NULL)) {
+      /* store the same row layout as in _openen_bin files */
+      access[0][0]  = u_length + 1;
+      access[0][1]  = length;
+      for (r = 0; r < u_length + 2; r++) {
+        fwrite(access[r], sizeof(int), length + 20, fp);
+        free(access[r]);
+      }
+      free(access);
+
+      if (n == n_max) {
+        n_max   *= 2;
+        records = (struct access_store_record *)vrna_realloc(records,
+                                                              sizeof(struct access_store_record) *
+                                                              n_max);
+      }
+
+      records[n].name = (char *)vrna_alloc(sizeof(char) * (name_len - 6));
+      memcpy(records[n].name, dir->d_name, name_len - 7);
+      records[n].entry.data_offset  = offset;
+      records[n].entry.u_length     = u_length;
+      records[n].entry.length       = length;
+      offset                        += (int64_t)(u_length + 2) * (length + 20) * sizeof(int);
+      n++;
+    } else {
+      vrna_message_warning("Skipping accessibility file %s", path);
+    }
+
+    free(path);
+  }
+  closedir(dfd);
+
+  /* sort the index by name for binary search look-up */
+  qsort(records, n, sizeof(struct access_store_record), compare_access_store_records);
+
+  /* 8-byte align the index */
+  fwrite(padding, sizeof(char), (8 - offset % 8) % 8, fp);
+  offset += (8 - offset % 8) % 8;
+
+  header.index_offset = offset;
+  header.names_offset = offset + (int64_t)n * sizeof(struct access_store_entry);
+
+  for (name_offset = r = 0; r < n; r++) {
+    records[r].entry.name_offset  = name_offset;
+    name_offset                   += strlen(records[r].name) + 1;
+    fwrite(&(records[r].entry), sizeof(struct access_store_entry), 1, fp);
+  }
+
+  for (r = 0; r < n; r++) {
+    fwrite(records[r].name, sizeof(char), strlen(records[r].name) + 1, fp);
+    free(records[r].name);
+  }
+  free(records);
+
+  memcpy(header.magic, ACCESS_STORE_MAGIC, 8);
+  header.version      = ACCESS_STORE_VERSION;
+  header.num_profiles = n;
+  fseek(fp, 0, SEEK_SET);
+  fwrite(&header, sizeof(struct access_store_header), 1, fp);
+
+  if (fclose(fp) != 0) {
+    vrna_message_warning("Error writing accessibility store %s", fname);
+    return -1;
+  }
+
+  return n;
+}
+
+
+static access_store *
+open_access_store(const char  *fname,
+                  double      scale)
+{
+  int                               fd;
+  char                              *data;
+  struct stat                       st;
+  const struct access_store_header  *header;
+  access_store                      *store;
+
+  fd = open(fname, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+
+  if ((fstat(fd, &st) != 0) || (st.st_size < (off_t)sizeof(struct access_store_header))) {
+    close(fd);
+    return NULL;
+  }
+
+#ifdef HAVE_MMAP
+  data = (char *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    close(fd);
+    return NULL;
+  }
+
+#else
+  ssize_t bytes, got;
+  data = (char *)vrna_alloc((size_t)st.st_size);
+  for (got = 0; got < st.st_size; got += bytes) {
+    bytes = read(fd, data + got, (size_t)(st.st_size - got));
+    if (bytes <= 0) {
+      free(data);
+      close(fd);
+      return NULL;
+    }
+  }
+#endif
+
+  close(fd);
+
+  store         = (access_store *)vrna_alloc(sizeof(access_store));
+  store->data   = data;
+  store->size   = (size_t)st.st_size;
+  store->header = header = (const struct access_store_header *)data;
+  store->index  = (const struct access_store_entry *)(data + header->index_offset);
+  store->scale  = scale;
+
+  if ((memcmp(header->magic, ACCESS_STORE_MAGIC, 8) != 0) ||
+      (header->version != ACCESS_STORE_VERSION) ||
+      (header->num_profiles < 0) ||
+      (header->index_offset < (int64_t)sizeof(struct access_store_header)) ||
+      (header->names_offset != header->index_offset + (int64_t)header->num_profiles *
+       sizeof(struct access_store_entry)) ||
+      (header->names_offset > (int64_t)store->size)) {
+    vrna_message_warning("File %s is not an accessibility store", fname);
+    close_access_store(store);
+    return NULL;
+  }
+
+  return store;
+}
+
+
+static void
+close_access_store(access_store *store)
+{
+  if (store) {
+#ifdef HAVE_MMAP
+    munmap(store->data, store->size);
+#else
+    free(store->data);
+#endif
+    free(store);
+  }
+}
+
+
+static int **
+fetch_access_store(const access_store *store,
+                   const char         *id,
+                   const int          end,
+                   const int          length,
+                   int                fast)
+{
+  int                             left, right, mid, cmp, r, i, **access;
+  int                             *rows;
+  const char                      *names;
+  const struct access_store_entry *e;
+
+  names = store->data + store->header->names_offset;
+  left  = 0;
+  right = store->header->num_profiles - 1;
+  e     = NULL;
+
+  while (left <= right) {
+    mid = (left + right) / 2;
+    if (store->index[mid].name_offset >= (int64_t)store->size - store->header->names_offset)
+      break;
+
+    cmp = strcmp(id, names + store->index[mid].name_offset);
+    if (cmp == 0) {
+      e = store->index + mid;
+      break;
+    } else if (cmp < 0) {
+      right = mid - 1;
+    } else {
+      left = mid + 1;
+    }
+  }
+
+  if (!e) {
+    vrna_message_warning("No accessibility profile for %s in store", id);
+    return NULL;
+  }
+
+  if (length > e->u_length && fast == 0) {
+    print_message(job_options, "Interaction length %d is larger than the length of the largest region %d \nfor which the opening energy was computed (-u parameter of RNAplfold)\n", length, e->u_length);
+    print_message(job_options, "Please recompute your profiles with a larger -u or set -l to a smaller interaction length\n");
+    return NULL;
+  }
+
+  if (end > e->length + 20) {
+    print_message(job_options, "Accessibility profile of %s contains %d less entries than expected based on the sequence length\n", id, end - e->length - 20);
+    print_message(job_options, "Please recompute your profiles so that profile length and sequence length match\n");
+    return NULL;
+  }
+
+  if ((e->data_offset < 0) ||
+      (e->data_offset + (int64_t)(e->u_length + 2) * (e->length + 20) * sizeof(int) >
+       (int64_t)store->size)) {
+    vrna_message_warning("Accessibility profile of %s is corrupted", id);
+    return NULL;
+  }
+
+  rows    = (int *)(store->data + e->data_offset);
+  access  = (int **)vrna_alloc(sizeof(int *) * (e->u_length + 1));
+
+  if (store->scale != 1.) {
+    /* rescale a copy of the profile exactly as read_plfold_i() does */
+    for (r = 0; r < e->u_length + 1; r++) {
+      access[r] = (int *)vrna_alloc(sizeof(int) * (e->length + 20));
+      memcpy(access[r], rows + (size_t)r * (e->length + 20), sizeof(int) * (e->length + 20));
+      if (r > 0)
+        for (i = 0; i < e->length + 20; i++)
+          if (access[r][i] != INF)
+            access[r][i] *= store->scale;
+    }
+  } else {
+    /* hand out row pointers into the store, no values are copied */
+    for (r = 0; r < e->u_length + 1; r++)
+      access[r] = rows + (size_t)r * (e->length + 20);
+  }
+
+  return access;
+}
+
+
+static void
+free_plfold_i(int           **access,
+              access_store  *store)
+{
+  int i;
+
+  if (!access)
+    return;
+
+  /* rows of unscaled profiles from a store belong to the mapping */
+  if ((!store) || (store->scale != 1.)) {
+    i = access[0][0];
+    while (--i > -1)
+      free(access[i]);
+  }
+
+  free(access);
+}
+
+
 static int
 get_max_u(const char  *s,
           char        delim)
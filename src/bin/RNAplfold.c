@@ -29,6 +29,7 @@
 #include "ViennaRNA/io/file_formats.h"
 #include "ViennaRNA/io/utils.h"
 #include "ViennaRNA/commands.h"
+#include "ViennaRNA/utils/timing.h"
 #include "RNAplfold_cmdl.h"
 #include "gengetopt_helper.h"
 #include "input_id_helpers.h"
@@ -145,7 +146,7 @@ main(int  argc,
   unsigned int                rec_type, read_opt;
   int                         length, istty, winsize, pairdist, tempwin, temppair, tempunpaired,
                               noconv, i, plexoutput, simply_putout, openenergies, binaries,
-                              filename_full, with_shapes, verbose;
+                              filename_full, with_shapes, verbose, timing;
   float                       cutoff;
   vrna_exp_param_t            *pf_parameters;
   vrna_md_t                   md;
@@ -170,6 +171,7 @@ main(int  argc,
   command_file  = NULL;
   commands      = NULL;
   verbose       = 0;
+  timing        = 0;
 
   set_model_details(&md);
 
@@ -295,6 +297,15 @@ main(int  argc,
   if (args_info.commands_given)
     command_file = strdup(args_info.commands_arg);
 
+  if (args_info.timing_given) {
+#ifdef VRNA_WITH_TIMING
+    timing = 1;
+#else
+    vrna_message_warning(
+      "This version of RNAplfold has been built without timing instrumentation");
+#endif
+  }
+
   /* free allocated memory of command line data structure */
   RNAplfold_cmdline_parser_free(&args_info);
 
@@ -483,6 +494,9 @@ main(int  argc,
 
       vrna_fold_compound_t *fc = vrna_fold_compound(rec_sequence, &md, VRNA_OPTION_WINDOW);
 
+      if (timing)
+        vrna_timing_enable(fc, 1);
+
       if (with_shapes) {
         vrna_constraints_add_SHAPE(fc,
                                    shape_file,
@@ -588,6 +602,12 @@ main(int  argc,
         }
       }
 
+      if (timing) {
+        char *title = vrna_strdup_printf("Timings for %s", SEQ_ID);
+        vrna_timing_print(stderr, fc, title);
+        free(title);
+      }
+
       vrna_fold_compound_free(fc);
 
       free(pf_parameters);
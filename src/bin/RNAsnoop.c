@@ -29,7 +29,74 @@
 #include "ViennaRNA/utils/strings.h"
 #include "ViennaRNA/utils/alignments.h"
 #include "ViennaRNA/io/utils.h"
+#include "ViennaRNA/datastructures/char_stream.h"
+#include "ViennaRNA/datastructures/stream_output.h"
 #include "RNAsnoop_cmdl.h"
+
+#include "parallel_helpers.h"
+
+/**
+ * Settings of the snoRNA-target jobs
+ */
+struct options {
+  int             jobs;
+  int             keep_order;
+  unsigned int    next_record_number;
+  vrna_ostream_t  output_queue;
+  int             fast;
+  int             plfold_up_flag;
+  char            *access;
+  char            *suffix;
+  int             nice;
+  int             delta;
+  int             penalty;
+  int             threshloop;
+  int             threshLE;
+  int             threshRE;
+  int             threshDE;
+  int             threshTE;
+  int             threshSE;
+  int             threshD;
+  int             distance;
+  int             half_stem;
+  int             max_half_stem;
+  int             min_s2;
+  int             max_s2;
+  int             min_s1;
+  int             max_s1;
+  int             min_d1;
+  int             min_d2;
+  int             alignment_length;
+};
+
+
+struct record_data {
+  unsigned int    number;
+  const char      *name_s;          /* snoRNA, shared by all jobs of the snoRNA */
+  const char      *string_s;
+  int             fullStemEnergy;
+  char            *name_t;
+  char            *string_t;
+  vrna_cstr_t     data;
+  struct options  *options;
+};
+
+
+static void process_record(struct record_data *record);
+
+
+static void
+flush_cstr_callback(void          *auxdata,
+                    unsigned int  i,
+                    void          *data)
+{
+  vrna_cstr_t s = (vrna_cstr_t)data;
+
+  /* flush/free data */
+  vrna_cstr_free(s);
+}
+
+
 static void  aliprint_struc(snoopT      *dup,
                             const char  **s1,
                             const char  **s2,
@@ -39,11 +106,12 @@ static void  aliprint_struc(snoopT      *dup,
                             int);
 
 
-static void  print_struc(snoopT     *dup,
-                         const char *s1,
-                         const char *s2,
-                         char *,
-                         char *,
+static void  print_struc(vrna_cstr_t  stream,
+                         snoopT       *dup,
+                         const char   *s1,
+                         const char   *s2,
+                         const char *,
+                         const char *,
                          int,
                          int);
 
@@ -133,6 +201,13 @@ main(int  argc,
                                     redraw /*if used (option I) allow to redraw command line output into ps files */;
 
   int noconv = 0;
+  struct options opt;
+
+  opt.jobs                = 1;
+  opt.keep_order          = 1;
+  opt.next_record_number  = 0;
+  opt.output_queue        = NULL;
+
   string_s            = NULL;
   string_t            = NULL;
   plfold_up_flag      = 0;
@@ -232,6 +307,34 @@ main(int  argc,
   /*threshold on minimal lower stem energy*/
   alignment_length = args_info.alignmentLength_arg;
 
+  /*parallel processing of the targets*/
+  if (args_info.jobs_given) {
+#if VRNA_WITH_PTHREADS
+    int thread_max = max_user_threads();
+    if (args_info.jobs_arg == 0) {
+      /* use maximum of concurrent threads */
+      int proc_cores, proc_cores_conf;
+      if (num_proc_cores(&proc_cores, &proc_cores_conf)) {
+        opt.jobs = MIN2(thread_max, proc_cores_conf);
+      } else {
+        vrna_message_warning("Could not determine number of available processor cores!\n"
+                             "Defaulting to serial computation");
+        opt.jobs = 1;
+      }
+    } else {
+      opt.jobs = MIN2(thread_max, args_info.jobs_arg);
+    }
+
+    opt.jobs = MAX2(1, opt.jobs);
+#else
+    vrna_message_warning(
+      "This version of RNAsnoop has been built without parallel input processing capabilities");
+#endif
+
+    if (args_info.unordered_given)
+      opt.keep_order = 0;
+  }
+
   threshloop = MIN2(threshloop, 0);
 
   /*   if(plfold_up_flag && !fast){ */
@@ -268,6 +371,30 @@ main(int  argc,
   min_d1  += 5;
   min_d2  += 5;
 
+  opt.fast              = fast;
+  opt.plfold_up_flag    = plfold_up_flag;
+  opt.access            = access;
+  opt.suffix            = suffix;
+  opt.nice              = nice;
+  opt.delta             = delta;
+  opt.penalty           = penalty;
+  opt.threshloop        = threshloop;
+  opt.threshLE          = threshLE;
+  opt.threshRE          = threshRE;
+  opt.threshDE          = threshDE;
+  opt.threshTE          = threshTE;
+  opt.threshSE          = threshSE;
+  opt.threshD           = threshD;
+  opt.distance          = distance;
+  opt.half_stem         = half_stem;
+  opt.max_half_stem     = max_half_stem;
+  opt.min_s2            = min_s2;
+  opt.max_s2            = max_s2;
+  opt.min_s1            = min_s1;
+  opt.max_s1            = max_s1;
+  opt.min_d1            = min_d1;
+  opt.min_d2            = min_d2;
+  opt.alignment_length  = alignment_length;
 
   if (!alignment) {
     if (tname == NULL || sname == NULL)
@@ -285,6 +412,11 @@ main(int  argc,
       return 0;
     }
 
+    if (opt.keep_order)
+      opt.output_queue = vrna_ostream_init(&flush_cstr_callback, NULL);
+
+    INIT_PARALLELIZATION(opt.jobs);
+
     do {
       /* main loop: continue until end of file */
       if ((line_s = vrna_read_line(sno)) == NULL) {
@@ -347,21 +479,21 @@ main(int  argc,
       fullStemEnergy = snofold(string_s, structure, max_asymm, threshloop, min_s2, max_s2, half_stem, max_half_stem);
       do {
         /* main loop for target continue until end of file */
-        snoopT  mfe;
         if ((line_t = vrna_read_line(mrna)) == NULL)
           /* free(line_t); */
           break;
 
-        char    *name_t = NULL;
+        char        *name_t   = NULL;
+        vrna_cstr_t headers   = vrna_cstr(100, stdout);
 
         /* skip comment lines and get filenames */
         while ((*line_t == '*') || (*line_t == '\0') || (*line_t == '>')) {
           if (*line_t == '>') {
-            printf("%s\n", name_s);
+            vrna_cstr_printf(headers, "%s\n", name_s);
             name_t = (char *)vrna_alloc(strlen(line_t) + 1);
             (void)sscanf(line_t, "%s", name_t);
 
-            printf("%s\n", name_t);
+            vrna_cstr_printf(headers, "%s\n", name_t);
             free(line_t);
             /*             free(string_t); */
           }
@@ -379,6 +511,7 @@ main(int  argc,
         /*   if ((line ==NULL) || (strcmp(line, "@") == 0)) break; */
         temp_t = (char *)vrna_alloc(strlen(line_t) + 1);
         (void)sscanf(line_t, "%s", temp_t);
+        free(line_t);
         int length_t;
         length_t = (int)strlen(temp_t);
         for (l = 0; l < length_t; l++) {
@@ -391,141 +524,37 @@ main(int  argc,
         strcat(string_t + 5, temp_t);
         strcat(string_t + 5 + length_t, "NNNNN");
         free(temp_t);
-        char *name_output;
-        name_output = NULL;
-        if (nice) {
-          name_output = (char *)vrna_alloc(sizeof(char) * (length_t + length_s + 2));
-          strcpy(name_output, name_t + 1);
-          strcat(name_output, "_");
-          strcat(name_output, name_s + 1);
-          name_output[length_t + length_s + 1] = '\0';
-        }
 
-        if (delta >= 0) {
-          snoopT  *subopt;
-          snoopT  *sub;
-          if (!fast && !plfold_up_flag) {
-            subopt = snoop_subopt(string_t, string_s, delta, 5, penalty, threshloop,
-                                  threshLE, threshRE, threshDE, threshTE, threshSE, threshD, distance,
-                                  half_stem, max_half_stem, min_s2, max_s2, min_s1, max_s1, min_d1, min_d2, fullStemEnergy);
-            if (subopt == NULL) {
-              printf("no target found under the given constraints\n");
-              free(subopt);
-              free(string_t);
-              free(line_t);
-              continue;
-            }
-
-            int count = 0;
-            for (sub = subopt; sub->structure != NULL; sub++) {
-              print_struc(sub, string_t, string_s, name_s, name_t, count++, nice);
-              free(sub->structure);
-            }
-            free(subopt);
-            free(string_t);
-            free(line_t);
-          } else if (!plfold_up_flag) {
-            Lsnoop_subopt_list(string_t, string_s, delta, 5, penalty, threshloop,
-                               threshLE, threshRE, threshDE, threshTE, threshSE, threshD, distance,
-                               half_stem, max_half_stem, min_s2, max_s2, min_s1, max_s1, min_d1, min_d2, alignment_length, name_output, fullStemEnergy);
-            free(string_t);
-            free(line_t);
-          } else {
-            if (plfold_up_flag == 1) {
-              int   **access_s1;
-              char  *file_s1;
-              int   s1_len;/* k;*/ /*,j; */
-              s1_len  = strlen(string_t);
-              file_s1 = (char *)vrna_alloc(sizeof(char) * (strlen(name_t + 1) + strlen(access) + 9));
-              strcpy(file_s1, access);
-              strcat(file_s1, "/");
-              strcat(file_s1, name_t + 1);
-              strcat(file_s1, "_openen");
-              access_s1 = read_plfold_i(file_s1, 1, s1_len);
-              if (fast) {
-                Lsnoop_subopt_list_XS(string_t, string_s, (const int **)access_s1, delta, 5, penalty, threshloop,
-                                      threshLE, threshRE, threshDE, threshTE, threshSE, threshD, distance,
-                                      half_stem, max_half_stem, min_s2, max_s2, min_s1, max_s1, min_d1, min_d2, alignment_length, name_output, fullStemEnergy);
-              } else {
-                snoop_subopt_XS(string_t, string_s, (const int **)access_s1, delta, 5, penalty, threshloop,
-                                threshLE, threshRE, threshDE, threshTE, threshSE, threshD, distance,
-                                half_stem, max_half_stem, min_s2, max_s2, min_s1, max_s1, min_d1, min_d2, alignment_length, name_output, fullStemEnergy);
-              }
-
-              /*                for(j=0; j<s1_len; j++){  */
-              /*                  for(k=0; k<access_s1[0][0];k++){  */
-              /*                    printf("%d \t",access_s1[k][j]);  */
-              /*                  }  */
-              /*                  printf("\n");  */
-              /*                }  */
-              free(file_s1);
-              free(string_t);
-              free(line_t);
-              int i = access_s1[0][0];
-              while (--i > -1)
-                free(access_s1[i]);
-              free(access_s1);
-            } else if (plfold_up_flag == 2) {
-              int   **access_s1;
-              char  *file_s1;
-              int   s1_len, k;/* ,j; */
-              s1_len  = strlen(string_t);
-              file_s1 = (char *)vrna_alloc(sizeof(char) * (strlen(name_t + 1) + strlen(suffix) + strlen(access) + 3));
-              strcpy(file_s1, access);
-              strcat(file_s1, "/");
-              strcat(file_s1, name_t + 1);
-              strcat(file_s1, "_");
-              strcat(file_s1, suffix);
-              access_s1 = read_rnaup(file_s1, 1, s1_len);
-              if (fast) {
-                Lsnoop_subopt_list_XS(string_t, string_s, (const int **)access_s1, delta, 5, penalty, threshloop,
-                                      threshLE, threshRE, threshDE, threshTE, threshSE, threshD, distance,
-                                      half_stem, max_half_stem, min_s2, max_s2, min_s1, max_s1, min_d1, min_d2, alignment_length, name_output, fullStemEnergy);
-              } else {
-                snoop_subopt_XS(string_t, string_s, (const int **)access_s1, delta, 5, penalty, threshloop,
-                                threshLE, threshRE, threshDE, threshTE, threshSE, threshD, distance,
-                                half_stem, max_half_stem, min_s2, max_s2, min_s1, max_s1, min_d1, min_d2, alignment_length, name_output, fullStemEnergy);
-              }
-
-              /*                for(j=0; j<s1_len; j++){  */
-              /*                  for(k=0; k<access_s1[0][0];k++){  */
-              /*                    printf("%d \t",access_s1[k][j]);  */
-              /*                  }  */
-              /*                  printf("\n");  */
-              /*                }  */
-              free(file_s1);
-              free(string_t);
-              free(line_t);
-              k = access_s1[0][0];
-              while (--k > -1)
-                free(access_s1[k]);
-              free(access_s1);
-            }
-          }
-        } else {
-          mfe = snoopfold(string_t, string_s, penalty, threshloop, threshLE, threshRE, threshDE, threshD,
-                          half_stem, max_half_stem, min_s2, max_s2, min_s1, max_s1, min_d1, min_d2, fullStemEnergy);
-          if (mfe.energy < INF) {
-            print_struc(&mfe, string_t, string_s, name_s, name_t, 0, 1);
-            free(mfe.structure);
-          }
+        /* hand over the target to the next free compute slot */
+        struct record_data *record = (struct record_data *)vrna_alloc(sizeof(struct record_data));
 
-          free(line_t);
-          length_t = (int)strlen(string_t);
-          free(string_t);
-        }
+        record->number          = opt.next_record_number;
+        record->name_s          = name_s;
+        record->string_s        = string_s;
+        record->fullStemEnergy  = fullStemEnergy;
+        record->name_t          = name_t;
+        record->string_t        = string_t;
+        record->data            = headers;
+        record->options         = &opt;
+
+        if (opt.output_queue)
+          vrna_ostream_request(opt.output_queue, opt.next_record_number++);
 
-        free(name_t);
-        if (nice)
-          free(name_output);
+        RUN_IN_PARALLEL(process_record, record);
       } while (1);
       rewind(mrna);
+      /* the jobs use the snoRNA and its stem loop arrays */
+      WAIT_FOR_ALL_JOBS;
       snofree_arrays(strlen(string_s));  /* free's base_pair */
       free(string_s);
       string_s = NULL;
       free(name_s);
       name_s = NULL;
     } while (1);
+
+    UNINIT_PARALLELIZATION
+
+    vrna_ostream_free(opt.output_queue);
   } else {
     if (tname == NULL || sname == NULL)
       RNAsnoop_cmdline_parser_print_help();
@@ -620,11 +649,128 @@ main(int  argc,
 
 
 static void
-print_struc(snoopT      *dup,
+process_record(struct record_data *record)
+{
+  const char      *string_s, *name_s;
+  char            *string_t, *name_t, *name_output;
+  int             length_s, length_t;
+  vrna_cstr_t     o_stream;
+  struct options  *opt;
+
+  opt       = record->options;
+  o_stream  = record->data;
+  string_s  = record->string_s;
+  name_s    = record->name_s;
+  string_t  = record->string_t;
+  name_t    = record->name_t;
+  length_s  = (int)strlen(string_s) - 10;
+  length_t  = (int)strlen(string_t) - 10;
+
+  name_output = NULL;
+  if (opt->nice) {
+    name_output = (char *)vrna_alloc(sizeof(char) * (length_t + length_s + 2));
+    strcpy(name_output, name_t + 1);
+    strcat(name_output, "_");
+    strcat(name_output, name_s + 1);
+    name_output[length_t + length_s + 1] = '\0';
+  }
+
+  /* collect the interactions of this job */
+  snoop_output_stream(o_stream);
+
+  if (opt->delta >= 0) {
+    snoopT  *subopt;
+    snoopT  *sub;
+    if (!opt->fast && !opt->plfold_up_flag) {
+      subopt = snoop_subopt(string_t, string_s, opt->delta, 5, opt->penalty, opt->threshloop,
+                            opt->threshLE, opt->threshRE, opt->threshDE, opt->threshTE, opt->threshSE, opt->threshD, opt->distance,
+                            opt->half_stem, opt->max_half_stem, opt->min_s2, opt->max_s2, opt->min_s1, opt->max_s1, opt->min_d1, opt->min_d2, record->fullStemEnergy);
+      if (subopt == NULL) {
+        vrna_cstr_printf(o_stream, "no target found under the given constraints\n");
+      } else {
+        int count = 0;
+        for (sub = subopt; sub->structure != NULL; sub++) {
+          print_struc(o_stream, sub, string_t, string_s, name_s, name_t, count++, opt->nice);
+          free(sub->structure);
+        }
+        free(subopt);
+      }
+    } else if (!opt->plfold_up_flag) {
+      Lsnoop_subopt_list(string_t, string_s, opt->delta, 5, opt->penalty, opt->threshloop,
+                         opt->threshLE, opt->threshRE, opt->threshDE, opt->threshTE, opt->threshSE, opt->threshD, opt->distance,
+                         opt->half_stem, opt->max_half_stem, opt->min_s2, opt->max_s2, opt->min_s1, opt->max_s1, opt->min_d1, opt->min_d2,
+                         opt->alignment_length, name_output, record->fullStemEnergy);
+    } else {
+      int   **access_s1, i;
+      char  *file_s1;
+      int   s1_len;
+      s1_len = strlen(string_t);
+      if (opt->plfold_up_flag == 1) {
+        file_s1 = (char *)vrna_alloc(sizeof(char) * (strlen(name_t + 1) + strlen(opt->access) + 9));
+        strcpy(file_s1, opt->access);
+        strcat(file_s1, "/");
+        strcat(file_s1, name_t + 1);
+        strcat(file_s1, "_openen");
+        access_s1 = read_plfold_i(file_s1, 1, s1_len);
+      } else {
+        file_s1 = (char *)vrna_alloc(sizeof(char) * (strlen(name_t + 1) + strlen(opt->suffix) + strlen(opt->access) + 3));
+        strcpy(file_s1, opt->access);
+        strcat(file_s1, "/");
+        strcat(file_s1, name_t + 1);
+        strcat(file_s1, "_");
+        strcat(file_s1, opt->suffix);
+        access_s1 = read_rnaup(file_s1, 1, s1_len);
+      }
+
+      if (opt->fast) {
+        Lsnoop_subopt_list_XS(string_t, string_s, (const int **)access_s1, opt->delta, 5, opt->penalty, opt->threshloop,
+                              opt->threshLE, opt->threshRE, opt->threshDE, opt->threshTE, opt->threshSE, opt->threshD, opt->distance,
+                              opt->half_stem, opt->max_half_stem, opt->min_s2, opt->max_s2, opt->min_s1, opt->max_s1, opt->min_d1, opt->min_d2,
+                              opt->alignment_length, name_output, record->fullStemEnergy);
+      } else {
+        snoop_subopt_XS(string_t, string_s, (const int **)access_s1, opt->delta, 5, opt->penalty, opt->threshloop,
+                        opt->threshLE, opt->threshRE, opt->threshDE, opt->threshTE, opt->threshSE, opt->threshD, opt->distance,
+                        opt->half_stem, opt->max_half_stem, opt->min_s2, opt->max_s2, opt->min_s1, opt->max_s1, opt->min_d1, opt->min_d2,
+                        opt->alignment_length, name_output, record->fullStemEnergy);
+      }
+
+      free(file_s1);
+      i = access_s1[0][0];
+      while (--i > -1)
+        free(access_s1[i]);
+      free(access_s1);
+    }
+  } else {
+    snoopT mfe = snoopfold(string_t, string_s, opt->penalty, opt->threshloop, opt->threshLE, opt->threshRE, opt->threshDE, opt->threshD,
+                           opt->half_stem, opt->max_half_stem, opt->min_s2, opt->max_s2, opt->min_s1, opt->max_s1, opt->min_d1, opt->min_d2,
+                           record->fullStemEnergy);
+    if (mfe.energy < INF) {
+      print_struc(o_stream, &mfe, string_t, string_s, name_s, name_t, 0, 1);
+      free(mfe.structure);
+    }
+  }
+
+  snoop_output_stream(NULL);
+
+  if (opt->output_queue)
+    vrna_ostream_provide(opt->output_queue, record->number, (void *)o_stream);
+  else
+    THREADSAFE_STREAM_OUTPUT(flush_cstr_callback(NULL, record->number, (void *)o_stream));
+
+  free(name_output);
+  free(string_t);
+  free(name_t);
+  free(record);
+}
+
+
+static void
+print_struc(vrna_cstr_t stream,
+            snoopT      *dup,
             const char  *s1,
             const char  *s2,
-            char        *name_s,
-            char        *name_t,
+            const char  *name_s,
+            const char  *name_t,
             int         count,
             int         nice)
 {
@@ -656,11 +802,12 @@ print_struc(snoopT      *dup,
   s4  = (char *)vrna_alloc(sizeof(char) * (n2 - 9));
   strncpy(s4, s2 + 5, n2 - 10);
   s4[n2 - 10] = '\0';
-  printf("%s %3d,%-3d;%3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f + %5.2f + 4.1 ) (%5.2f) \n%s&%s\n",
-         target_struct, dup->i + 1 - l1,
-         dup->i, dup->u, dup->j + 1, dup->j + (int)(strrchr(dup->structure, '>') - strchr(dup->structure, '>')) + 1,
-         (dup->Loop_D + dup->Duplex_El + dup->Duplex_Er + dup->Loop_E) + 4.10,
-         dup->Duplex_El, dup->Duplex_Er, dup->Loop_E, dup->Loop_D, dup->fullStemEnergy, target, s4);
+  vrna_cstr_printf(stream,
+                   "%s %3d,%-3d;%3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f + %5.2f + 4.1 ) (%5.2f) \n%s&%s\n",
+                   target_struct, dup->i + 1 - l1,
+                   dup->i, dup->u, dup->j + 1, dup->j + (int)(strrchr(dup->structure, '>') - strchr(dup->structure, '>')) + 1,
+                   (dup->Loop_D + dup->Duplex_El + dup->Duplex_Er + dup->Loop_E) + 4.10,
+                   dup->Duplex_El, dup->Duplex_Er, dup->Loop_E, dup->Loop_D, dup->fullStemEnergy, target, s4);
   if (nice) {
     char  *temp_seq;
     char  *temp_struc;
@@ -672,7 +819,6 @@ print_struc(snoopT      *dup,
     strcat(temp_struc, target_struct + l1 + 1);
     temp_seq[n2 + l1 - 10]    = '\0';
     temp_struc[n2 + l1 - 10]  = '\0';
-    cut_point                 = l1 + 1;
 
     psoutput = vrna_strdup_printf("sno_%d_u_%d_%s_%s.ps",
                                   count,
@@ -680,8 +826,8 @@ print_struc(snoopT      *dup,
                                   name_t + 1,
                                   name_s + 1);
 
-    PS_rna_plot_snoop_a(temp_seq, temp_struc, psoutput, NULL, NULL);
-    cut_point = -1;
+    THREADSAFE_FILE_OUTPUT(
+      PS_rna_plot_snoop_a_cut(temp_seq, temp_struc, psoutput, NULL, NULL, l1 + 1));
     free(temp_seq);
     free(temp_struc);
     free(psoutput);
@@ -97,6 +97,7 @@ main(int  argc,
 
   /* variables for output */
   pu_contrib              *unstr_out, *unstr_short, *unstr_target, *contrib1, *contrib2;
+  pu_target               *target_profile;
   interact                *inter_out;
   /* pu_out *longer; */
 
@@ -126,6 +127,7 @@ main(int  argc,
   length1         = length2 = length_target = 0;
   inter_out       = NULL;
   unstr_out       = unstr_short = unstr_target = contrib1 = contrib2 = NULL;
+  target_profile  = NULL;
   structure       = ParamFile = ns_bases = head = orig_s1 = orig_s2 = orig_target = NULL;
   up_out          = NULL;
   fname_target[0] = '\0';
@@ -770,7 +772,14 @@ main(int  argc,
           contrib1  = unstr_out;
           contrib2  = unstr_target;
         } else {
-          inter_out = pf_interact(s_target, s1, unstr_target, unstr_out, w, cstruc_combined, incr3, incr5);
+          /* re-use the accessibility profile of the target for all queries */
+          if (target_profile == NULL)
+            target_profile = pf_unstru_target(s_target, unstr_target, w, incr3, incr5);
+
+          inter_out = pf_interact_target(target_profile, s1, unstr_out, cstruc_combined);
+          if (inter_out == NULL)
+            vrna_message_error("pf_interact: could not satisfy all constraints");
+
           print_interaction(inter_out, orig_target, orig_s1, unstr_target, unstr_out, w, incr3, incr5);
           contrib1  = unstr_target;
           contrib2  = unstr_out;
@@ -836,6 +845,7 @@ main(int  argc,
 
     free_arrays(); /* for arrays for fold(...) */
   } while (1);
+  free_pu_target(target_profile);
   free(cmdl_parameters);
 
   return EXIT_SUCCESS;
@@ -8,6 +8,9 @@
 
 pthread_mutex_t output_mutex;
 pthread_mutex_t output_file_mutex;
+pthread_mutex_t job_slot_mutex;
+pthread_cond_t  job_slot_cond;
+unsigned int    jobs_in_flight;
 unsigned int    max_threads;
 threadpool      worker_pool;
 
@@ -47,7 +50,10 @@ threadpool      worker_pool;
     if (max_threads > 1) { \
       pthread_mutex_init(&output_mutex, NULL); \
       pthread_mutex_init(&output_file_mutex, NULL); \
-      worker_pool = thpool_init(max_threads); \
+      pthread_mutex_init(&job_slot_mutex, NULL); \
+      pthread_cond_init(&job_slot_cond, NULL); \
+      jobs_in_flight  = 0; \
+      worker_pool     = thpool_init(max_threads); \
     } \
 }
 
@@ -56,8 +62,11 @@ threadpool      worker_pool;
       thpool_wait(worker_pool); \
     pthread_mutex_destroy(&output_mutex); \
     pthread_mutex_destroy(&output_file_mutex); \
-    if (max_threads > 1) \
+    if (max_threads > 1) { \
       thpool_destroy(worker_pool); \
+      pthread_mutex_destroy(&job_slot_mutex); \
+      pthread_cond_destroy(&job_slot_cond); \
+    } \
 }
 
 #define RUN_IN_PARALLEL(fun, data)  { \
@@ -72,6 +81,32 @@ threadpool      worker_pool;
     } \
 }
 
+#define WAIT_FOR_ALL_JOBS { \
+    if (max_threads > 1) \
+      thpool_wait(worker_pool); \
+}
+
+/* limit the number of jobs queued or running to (a) */
+#define WAIT_FOR_JOB_SLOT(a) { \
+    if (max_threads > 1) { \
+      pthread_mutex_lock(&job_slot_mutex); \
+      while (jobs_in_flight >= (unsigned int)(a)) \
+        pthread_cond_wait(&job_slot_cond, &job_slot_mutex); \
+      jobs_in_flight++; \
+      pthread_mutex_unlock(&job_slot_mutex); \
+    } \
+}
+
+/* to be called at the end of each job started after WAIT_FOR_JOB_SLOT() */
+#define RELEASE_JOB_SLOT { \
+    if (max_threads > 1) { \
+      pthread_mutex_lock(&job_slot_mutex); \
+      jobs_in_flight--; \
+      pthread_cond_signal(&job_slot_cond); \
+      pthread_mutex_unlock(&job_slot_mutex); \
+    } \
+}
+
 #else
 
 #define ATOMIC_BLOCK(a)             { (a); }
@@ -81,6 +116,9 @@ threadpool      worker_pool;
 #define UNINIT_PARALLELIZATION
 #define RUN_IN_PARALLEL(fun, data)  { fun(data); }
 #define WAIT_FOR_FREE_SLOT(a)
+#define WAIT_FOR_ALL_JOBS
+#define WAIT_FOR_JOB_SLOT(a)
+#define RELEASE_JOB_SLOT
 
 #endif
 
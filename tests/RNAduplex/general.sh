@@ -0,0 +1,39 @@
+echo "Testing RNAduplex (MFE and general features):"
+
+RETURN=0
+
+function failed {
+    RETURN=1
+    echo " [ NOT OK ]"
+}
+
+function passed {
+    echo " [ OK ]"
+}
+
+function testline {
+  echo -en "...testing $1:\t\t"
+}
+
+# serial reference output
+RNAduplex < ${DATADIR}/rnaduplex.small.fa > rnaduplex.serial
+RNAduplex -e 3 < ${DATADIR}/rnaduplex.small.fa > rnaduplex.serial.subopt
+
+# Parallel processing of sequence pairs must not change the output
+for jobs in 2 4
+do
+  testline "MFE prediction (RNAduplex -j${jobs})"
+  RNAduplex -j${jobs} < ${DATADIR}/rnaduplex.small.fa > rnaduplex.parallel
+  diff=$(${DIFF} rnaduplex.serial rnaduplex.parallel)
+  if [ "x${diff}" != "x" ] ; then failed; echo -e "$diff"; else passed; fi
+
+  testline "Suboptimal duplexes (RNAduplex -e 3 -j${jobs})"
+  RNAduplex -e 3 -j${jobs} < ${DATADIR}/rnaduplex.small.fa > rnaduplex.parallel
+  diff=$(${DIFF} rnaduplex.serial.subopt rnaduplex.parallel)
+  if [ "x${diff}" != "x" ] ; then failed; echo -e "$diff"; else passed; fi
+done
+
+# clean up
+rm rnaduplex.serial rnaduplex.serial.subopt rnaduplex.parallel
+
+exit ${RETURN}
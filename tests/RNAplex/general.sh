@@ -0,0 +1,48 @@
+echo "Testing RNAplex (accessibility profiles):"
+
+RETURN=0
+
+function failed {
+    RETURN=1
+    echo " [ NOT OK ]"
+}
+
+function passed {
+    echo " [ OK ]"
+}
+
+function testline {
+  echo -en "...testing $1:\t\t"
+}
+
+# compute the opening energy profiles of all targets and queries
+mkdir -p rnaplex.access
+( cd rnaplex.access && \
+  RNAplfold -W 80 -L 60 -u 30 -O < ${DATADIR}/rnaplex.target.fa 2>/dev/null && \
+  RNAplfold -W 80 -L 60 -u 30 -O < ${DATADIR}/rnaplex.query.fa 2>/dev/null && \
+  rm -f *_dp.ps )
+
+testline "Create accessibility store (RNAplex --create-store)"
+RNAplex -a rnaplex.access --create-store rnaplex.store
+if [ ! -s rnaplex.store ] ; then failed; else passed; fi
+
+# Interactions computed from the store must match those computed from the text profiles
+for scale in 1 0.5 2.5
+do
+  testline "Accessibility store (RNAplex -V ${scale})"
+  RNAplex -t ${DATADIR}/rnaplex.target.fa \
+          -q ${DATADIR}/rnaplex.query.fa \
+          -l 15 -V ${scale} \
+          -a rnaplex.access > rnaplex.text
+  RNAplex -t ${DATADIR}/rnaplex.target.fa \
+          -q ${DATADIR}/rnaplex.query.fa \
+          -l 15 -V ${scale} \
+          -a rnaplex.store > rnaplex.mapped
+  diff=$(${DIFF} rnaplex.text rnaplex.mapped)
+  if [ "x${diff}" != "x" ] ; then failed; echo -e "$diff"; else passed; fi
+done
+
+# clean up
+rm -rf rnaplex.access rnaplex.store rnaplex.text rnaplex.mapped
+
+exit ${RETURN}
@@ -0,0 +1,1087 @@
+/*
+ *  Benchmarks for the core folding kernels of RNAlib
+ *
+ *  Every kernel is run on a fixed set of random sequences (fixed seed)
+ *  and on the real RNAs found in the test data directory. Each benchmark
+ *  is executed in a separate child process, such that the peak resident
+ *  set size can be attributed to a single kernel and sequence. Results
+ *  are written as JSON.
+ *
+ *  Usage: kernels [--data-dir=DIR] [--output=FILE] [--repeat=N]
+ *                 [--max-length=N] [--kernels=LIST]
+ *
+ *  (c) 2026 - Vienna RNA package
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <sys/utsname.h>
+
+#include "ViennaRNA/model.h"
+#include "ViennaRNA/fold_compound.h"
+#include "ViennaRNA/dp_matrices.h"
+#include "ViennaRNA/mfe.h"
+#include "ViennaRNA/part_func.h"
+#include "ViennaRNA/equilibrium_probs.h"
+#include "ViennaRNA/subopt.h"
+#include "ViennaRNA/part_func_window.h"
+#include "ViennaRNA/boltzmann_sampling.h"
+#include "ViennaRNA/findpath.h"
+#include "ViennaRNA/params/basic.h"
+#include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/strings.h"
+#include "ViennaRNA/utils/structures.h"
+#include "ViennaRNA/io/utils.h"
+#include "ViennaRNA/io/file_formats.h"
+#include "ViennaRNA/io/file_formats_msa.h"
+
+#ifdef VRNA_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#define BENCH_SEED              20190801U
+#define BENCH_REPEAT            3
+#define BENCH_MAX_LENGTH        10000
+#define BENCH_SUBOPT_DELTA      50      /* dcal/mol */
+#define BENCH_WINDOW_SIZE       200
+#define BENCH_WINDOW_SPAN       150
+#define BENCH_SAMPLES           1000
+#define BENCH_FINDPATH_WIDTH    10
+#define BENCH_FASTA_BYTES       (16 * 1024 * 1024)
+
+typedef struct {
+  char          *name;
+  const char    *set;
+  char          *sequence;
+  unsigned int  length;
+} bench_sequence_t;
+
+typedef struct {
+  double  time;   /* wall clock time of the kernel in seconds */
+  double  cells;  /* number of DP matrix cells filled by the kernel */
+  double  items;  /* number of items produced, e.g. structures or samples */
+} bench_run_t;
+
+typedef int (bench_kernel_f)(const char   *sequence,
+                             bench_run_t  *run);
+
+typedef struct {
+  const char      *name;
+  const char      *items_unit;
+  unsigned int    max_length;
+  bench_kernel_f  *run;
+} bench_kernel_t;
+
+
+PRIVATE int bench_mfe(const char   *sequence,
+                      bench_run_t  *run);
+
+
+PRIVATE int bench_pf(const char  *sequence,
+                     bench_run_t *run);
+
+
+PRIVATE int bench_bpp(const char   *sequence,
+                      bench_run_t  *run);
+
+
+PRIVATE int bench_subopt(const char  *sequence,
+                         bench_run_t *run);
+
+
+PRIVATE int bench_window(const char  *sequence,
+                         bench_run_t *run);
+
+
+PRIVATE int bench_pbacktrack(const char  *sequence,
+                             bench_run_t *run);
+
+
+PRIVATE int bench_findpath(const char  *sequence,
+                           bench_run_t *run);
+
+
+PRIVATE int bench_fasta(const char   *sequence,
+                        bench_run_t  *run);
+
+
+PRIVATE int bench_fasta_view(const char   *sequence,
+                             bench_run_t  *run);
+
+
+#ifdef VRNA_WITH_ZLIB
+PRIVATE int bench_fasta_gz(const char   *sequence,
+                           bench_run_t  *run);
+#endif
+
+
+/* kernel name, unit of produced items, default maximum sequence length, benchmark function */
+PRIVATE bench_kernel_t kernels[] = {
+  { "mfe",           NULL,             10000, &bench_mfe        },
+  { "pf",            NULL,             5000,  &bench_pf         },
+  { "pairing_probs", NULL,             5000,  &bench_bpp        },
+  { "subopt_cb",     "structures",     500,   &bench_subopt     },
+  { "probs_window",  NULL,             10000, &bench_window     },
+  { "pbacktrack_nr", "samples",        2000,  &bench_pbacktrack },
+  { "findpath",      "base pairs",     1000,  &bench_findpath   },
+  { "fasta_read",    "bytes",          10000, &bench_fasta      },
+  { "fasta_view",    "bytes",          10000, &bench_fasta_view },
+#ifdef VRNA_WITH_ZLIB
+  { "fasta_gz",      "bytes",          10000, &bench_fasta_gz   },
+#endif
+  { NULL,            NULL,             0,     NULL              }
+};
+
+PRIVATE unsigned int random_lengths[] = {
+  100, 200, 500, 1000, 2000, 5000, 10000, 0
+};
+
+
+PRIVATE double
+wall_time(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+
+  return (double)t.tv_sec + 1e-9 * (double)t.tv_nsec;
+}
+
+
+PRIVATE double
+triangle_cells(unsigned int n)
+{
+  return (double)n * (double)(n + 1) / 2.;
+}
+
+
+/*
+ *  A small xorshift generator, such that the random sequences are
+ *  the same on every platform, independent of the C library in use
+ */
+PRIVATE char *
+random_sequence(unsigned int n)
+{
+  unsigned int  i, x;
+  char          *s;
+
+  x = BENCH_SEED ^ (n * 2654435761U);
+  s = (char *)vrna_alloc(sizeof(char) * (n + 1));
+
+  for (i = 0; i < n; i++) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s[i] = "ACGU"[(x >> 7) & 3];
+  }
+
+  return s;
+}
+
+
+/*
+ *  Convert a (possibly aligned) DNA/RNA sequence into an
+ *  ungapped, upper-case RNA sequence
+ */
+PRIVATE char *
+clean_sequence(const char *seq)
+{
+  char  *s, *p;
+
+  s = (char *)vrna_alloc(sizeof(char) * (strlen(seq) + 1));
+
+  for (p = s; *seq; seq++) {
+    switch (*seq) {
+      case '-':
+      case '.':
+      case '_':
+      case '~':
+      case ' ':
+      case '\n':
+      case '\r':
+        break;
+
+      default:
+        *p = (char)toupper(*seq);
+        if (*p == 'T')
+          *p = 'U';
+
+        p++;
+        break;
+    }
+  }
+  *p = '\0';
+
+  return s;
+}
+
+
+PRIVATE void
+add_sequence(bench_sequence_t **seqs,
+             unsigned int     *num,
+             const char       *name,
+             const char       *set,
+             char             *sequence)
+{
+  unsigned int n = strlen(sequence);
+
+  if (n == 0) {
+    free(sequence);
+    return;
+  }
+
+  *seqs                   = (bench_sequence_t *)vrna_realloc(*seqs,
+                                                             sizeof(bench_sequence_t) * (*num + 1));
+  (*seqs)[*num].name      = strdup(name);
+  (*seqs)[*num].set       = set;
+  (*seqs)[*num].sequence  = sequence;
+  (*seqs)[*num].length    = n;
+  (*num)++;
+}
+
+
+PRIVATE void
+read_single_sequences(bench_sequence_t  **seqs,
+                      unsigned int      *num,
+                      const char        *data_dir,
+                      const char        *file,
+                      const char        *prefix,
+                      int               all_lines)
+{
+  char          *filename, *line, *name;
+  unsigned int  cnt;
+  FILE          *fp;
+
+  filename  = vrna_strdup_printf("%s/%s", data_dir, file);
+  fp        = fopen(filename, "r");
+
+  if (!fp) {
+    vrna_message_warning("Could not open %s, skipping", filename);
+    free(filename);
+    return;
+  }
+
+  cnt = 0;
+  while ((line = vrna_read_line(fp))) {
+    if (line[0] != '>') {
+      name = (all_lines) ? vrna_strdup_printf("%s_%u", prefix, ++cnt) : strdup(prefix);
+      add_sequence(seqs, num, name, "real", clean_sequence(line));
+      free(name);
+
+      /* dot-bracket files hold the sequence in the first line only */
+      if (!all_lines) {
+        free(line);
+        break;
+      }
+    }
+
+    free(line);
+  }
+
+  fclose(fp);
+  free(filename);
+}
+
+
+PRIVATE void
+read_alignment(bench_sequence_t **seqs,
+               unsigned int     *num,
+               const char       *data_dir,
+               const char       *file)
+{
+  char  *filename, **names, **aln, *id, *structure;
+  int   i, n;
+
+  filename  = vrna_strdup_printf("%s/%s", data_dir, file);
+  names     = NULL;
+  aln       = NULL;
+  id        = NULL;
+  structure = NULL;
+  n         = vrna_file_msa_read(filename,
+                                 &names,
+                                 &aln,
+                                 &id,
+                                 &structure,
+                                 VRNA_FILE_FORMAT_MSA_FASTA | VRNA_FILE_FORMAT_MSA_SILENT);
+
+  if (n <= 0)
+    vrna_message_warning("Could not read alignment %s, skipping", filename);
+
+  for (i = 0; i < n; i++) {
+    add_sequence(seqs, num, names[i], "real", clean_sequence(aln[i]));
+    free(names[i]);
+    free(aln[i]);
+  }
+
+  free(names);
+  free(aln);
+  free(id);
+  free(structure);
+  free(filename);
+}
+
+
+/*
+ *  The kernels. Each function prepares everything required by the
+ *  kernel outside of the timed region and reports the wall clock
+ *  time of the kernel call alone
+ */
+PRIVATE int
+bench_mfe(const char  *sequence,
+          bench_run_t *run)
+{
+  char                  *structure;
+  double                t;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  vrna_md_set_default(&md);
+
+  fc        = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  structure = (char *)vrna_alloc(sizeof(char) * (fc->length + 1));
+
+  t = wall_time();
+  (void)vrna_mfe(fc, structure);
+  run->time = wall_time() - t;
+
+  run->cells = triangle_cells(fc->length);
+
+  free(structure);
+  vrna_fold_compound_free(fc);
+
+  return 1;
+}
+
+
+PRIVATE int
+bench_pf(const char   *sequence,
+         bench_run_t  *run)
+{
+  double                t, mfe;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  vrna_md_set_default(&md);
+  md.compute_bpp = 0;
+
+  fc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  mfe = (double)vrna_mfe(fc, NULL);
+  vrna_exp_params_rescale(fc, &mfe);
+
+  t = wall_time();
+  (void)vrna_pf(fc, NULL);
+  run->time = wall_time() - t;
+
+  run->cells = triangle_cells(fc->length);
+
+  vrna_fold_compound_free(fc);
+
+  return 1;
+}
+
+
+PRIVATE int
+bench_bpp(const char  *sequence,
+          bench_run_t *run)
+{
+  int                   ret;
+  double                t, mfe;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  vrna_md_set_default(&md);
+
+  fc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  mfe = (double)vrna_mfe(fc, NULL);
+  vrna_exp_params_rescale(fc, &mfe);
+
+  /*
+   *  allocate the matrices including the probability array, but
+   *  leave the outside algorithm out of the partition function
+   */
+  (void)vrna_mx_prepare(fc, VRNA_OPTION_PF);
+  fc->exp_params->model_details.compute_bpp = 0;
+  (void)vrna_pf(fc, NULL);
+  fc->exp_params->model_details.compute_bpp = 1;
+
+  t   = wall_time();
+  ret = vrna_pairing_probs(fc, NULL);
+  run->time = wall_time() - t;
+
+  run->cells = triangle_cells(fc->length);
+
+  vrna_fold_compound_free(fc);
+
+  return ret;
+}
+
+
+PRIVATE void
+count_structures(const char *structure,
+                 float      energy,
+                 void       *data)
+{
+  if (structure)
+    (*((double *)data))++;
+}
+
+
+PRIVATE int
+bench_subopt(const char   *sequence,
+             bench_run_t  *run)
+{
+  double                t;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  vrna_md_set_default(&md);
+  md.uniq_ML = 1;
+
+  fc          = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  run->items  = 0;
+
+  t = wall_time();
+  vrna_subopt_cb(fc, BENCH_SUBOPT_DELTA, &count_structures, (void *)&(run->items));
+  run->time = wall_time() - t;
+
+  run->cells = triangle_cells(fc->length);
+
+  vrna_fold_compound_free(fc);
+
+  return 1;
+}
+
+
+PRIVATE void
+discard_probs(FLT_OR_DBL    *pr,
+              int           pr_size,
+              int           i,
+              int           max,
+              unsigned int  type,
+              void          *data)
+{
+  return;
+}
+
+
+PRIVATE int
+bench_window(const char   *sequence,
+             bench_run_t  *run)
+{
+  int                   ret;
+  unsigned int          n, span;
+  double                t;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  vrna_md_set_default(&md);
+  md.compute_bpp  = 1;
+  md.window_size  = BENCH_WINDOW_SIZE;
+  md.max_bp_span  = BENCH_WINDOW_SPAN;
+
+  n = strlen(sequence);
+  if ((unsigned int)md.window_size > n)
+    md.window_size = n;
+
+  if (md.max_bp_span > md.window_size)
+    md.max_bp_span = md.window_size;
+
+  fc = vrna_fold_compound(sequence, &md, VRNA_OPTION_WINDOW);
+
+  t   = wall_time();
+  ret = vrna_probs_window(fc, 0, VRNA_PROBS_WINDOW_BPP, &discard_probs, NULL);
+  run->time = wall_time() - t;
+
+  /* pairs (i,j) with j - i < max_bp_span */
+  span        = (unsigned int)md.max_bp_span;
+  run->cells  = (double)n * (double)span - triangle_cells(span - 1);
+
+  vrna_fold_compound_free(fc);
+
+  return ret;
+}
+
+
+PRIVATE int
+bench_pbacktrack(const char   *sequence,
+                 bench_run_t  *run)
+{
+  char                  **samples, **ptr;
+  double                t, mfe;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  vrna_md_set_default(&md);
+  md.uniq_ML      = 1;
+  md.compute_bpp  = 0;
+
+  fc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  mfe = (double)vrna_mfe(fc, NULL);
+  vrna_exp_params_rescale(fc, &mfe);
+  (void)vrna_pf(fc, NULL);
+
+  t       = wall_time();
+  samples = vrna_pbacktrack_nr(fc, BENCH_SAMPLES);
+  run->time = wall_time() - t;
+
+  run->items = 0;
+  if (samples) {
+    for (ptr = samples; *ptr; ptr++) {
+      run->items++;
+      free(*ptr);
+    }
+    free(samples);
+  }
+
+  vrna_fold_compound_free(fc);
+
+  return samples != NULL;
+}
+
+
+PRIVATE int
+bench_findpath(const char   *sequence,
+               bench_run_t  *run)
+{
+  char                  *s1, *s2;
+  double                t;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  vrna_md_set_default(&md);
+
+  /* refold from the MFE structure into the open chain */
+  fc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  s1  = (char *)vrna_alloc(sizeof(char) * (fc->length + 1));
+  s2  = (char *)vrna_alloc(sizeof(char) * (fc->length + 1));
+  memset(s2, '.', fc->length);
+  (void)vrna_mfe(fc, s1);
+
+  t = wall_time();
+  (void)vrna_path_findpath_saddle(fc, s1, s2, BENCH_FINDPATH_WIDTH);
+  run->time = wall_time() - t;
+
+  run->items = (double)vrna_bp_distance(s1, s2);
+
+  free(s1);
+  free(s2);
+  vrna_fold_compound_free(fc);
+
+  return 1;
+}
+
+
+/*
+ *  Create a temporary FASTA file with the sequence, repeated as often
+ *  as required, in lines of 60 characters. The file is written through
+ *  zlib if compress is non-zero
+ */
+PRIVATE FILE *
+fasta_input(const char  *sequence,
+            int         compress,
+            double      *bytes)
+{
+  char          tmpl[] = "/tmp/rnabenchXXXXXX", *data;
+  unsigned int  i, r, n, records;
+  size_t        length;
+  int           fd;
+  FILE          *fp;
+
+  fd = mkstemp(tmpl);
+  if ((fd < 0) || (!(fp = fdopen(fd, "w+")))) {
+    vrna_message_warning("Could not create temporary FASTA file");
+    return NULL;
+  }
+
+  unlink(tmpl);
+
+  n       = strlen(sequence);
+  records = BENCH_FASTA_BYTES / n + 1;
+  data    = (char *)vrna_alloc(sizeof(char) * (records * (n + n / 60 + 32) + 1));
+  length  = 0;
+
+  for (r = 0; r < records; r++) {
+    length += sprintf(data + length, ">record_%u\n", r);
+    for (i = 0; i < n; i += 60)
+      length += sprintf(data + length, "%.60s\n", sequence + i);
+  }
+
+  *bytes = (double)length;
+
+#ifdef VRNA_WITH_ZLIB
+  if (compress) {
+    gzFile gz = gzdopen(dup(fd), "wb");
+
+    if ((!gz) || (gzwrite(gz, data, (unsigned int)length) != (int)length)) {
+      vrna_message_warning("Could not write compressed FASTA file");
+      fclose(fp);
+      free(data);
+      return NULL;
+    }
+
+    gzclose(gz);
+  } else
+#endif
+  {
+    fwrite(data, sizeof(char), length, fp);
+  }
+
+  free(data);
+  rewind(fp);
+
+  return fp;
+}
+
+
+PRIVATE int
+bench_fasta(const char  *sequence,
+            bench_run_t *run)
+{
+  char    *id, *seq, **rest, **ptr;
+  double  t;
+  FILE    *fp;
+
+  if (!(fp = fasta_input(sequence, 0, &(run->items))))
+    return 0;
+
+  t = wall_time();
+  while (!(vrna_file_fasta_read_record(&id, &seq, &rest, fp, 0) & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT))) {
+    free(id);
+    free(seq);
+    for (ptr = rest; *ptr; ptr++)
+      free(*ptr);
+    free(rest);
+  }
+  run->time = wall_time() - t;
+
+  fclose(fp);
+
+  return 1;
+}
+
+
+/* read the records as views into the read buffer of a vrna_fasta_reader_t */
+PRIVATE int
+read_fasta_views(FILE         *fp,
+                 bench_run_t  *run)
+{
+  size_t              bytes;
+  double              t;
+  vrna_fasta_reader_t reader;
+  vrna_fasta_record_t record;
+
+  bytes = 0;
+  t     = wall_time();
+
+  if (!(reader = vrna_file_fasta_reader_init(fp)))
+    return 0;
+
+  while (!(vrna_file_fasta_read_record_view(reader, &record, 0) & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT)))
+    bytes += record.sequence_length;
+
+  vrna_file_fasta_reader_free(reader);
+  run->time = wall_time() - t;
+
+  return bytes > 0;
+}
+
+
+PRIVATE int
+bench_fasta_view(const char   *sequence,
+                 bench_run_t  *run)
+{
+  int   ret;
+  FILE  *fp;
+
+  if (!(fp = fasta_input(sequence, 0, &(run->items))))
+    return 0;
+
+  ret = read_fasta_views(fp, run);
+
+  fclose(fp);
+
+  return ret;
+}
+
+
+#ifdef VRNA_WITH_ZLIB
+PRIVATE int
+bench_fasta_gz(const char   *sequence,
+               bench_run_t  *run)
+{
+  int   ret;
+  FILE  *fp;
+
+  if (!(fp = fasta_input(sequence, 1, &(run->items))))
+    return 0;
+
+  ret = read_fasta_views(fp, run);
+
+  fclose(fp);
+
+  return ret;
+}
+
+
+#endif
+
+
+/*
+ *  Run a benchmark in a child process. The child sends the results
+ *  of each repetition through a pipe, the parent collects the peak
+ *  resident set size of the child via wait4()
+ */
+PRIVATE int
+run_benchmark(bench_kernel_t    *kernel,
+              bench_sequence_t  *seq,
+              unsigned int      repeat,
+              bench_run_t       *runs,
+              long              *peak_rss)
+{
+  int           fds[2], status;
+  unsigned int  r, received;
+  ssize_t       cnt;
+  pid_t         pid;
+  struct rusage usage;
+
+  if (pipe(fds)) {
+    vrna_message_warning("Could not create pipe");
+    return 0;
+  }
+
+  fflush(NULL);
+
+  pid = fork();
+  if (pid < 0) {
+    vrna_message_warning("Could not fork benchmark process");
+    close(fds[0]);
+    close(fds[1]);
+    return 0;
+  }
+
+  if (pid == 0) {
+    close(fds[0]);
+    for (r = 0; r < repeat; r++) {
+      memset(&(runs[r]), 0, sizeof(bench_run_t));
+      if (!kernel->run(seq->sequence, &(runs[r])))
+        _exit(EXIT_FAILURE);
+
+      if (write(fds[1], &(runs[r]), sizeof(bench_run_t)) != sizeof(bench_run_t))
+        _exit(EXIT_FAILURE);
+    }
+    close(fds[1]);
+    _exit(EXIT_SUCCESS);
+  }
+
+  close(fds[1]);
+
+  received = 0;
+  while (received < repeat) {
+    cnt = read(fds[0], &(runs[received]), sizeof(bench_run_t));
+    if (cnt != sizeof(bench_run_t))
+      break;
+
+    received++;
+  }
+  close(fds[0]);
+
+  if (wait4(pid, &status, 0, &usage) < 0)
+    return 0;
+
+#ifdef __APPLE__
+  *peak_rss = usage.ru_maxrss / 1024;
+#else
+  *peak_rss = usage.ru_maxrss;
+#endif
+
+  return (WIFEXITED(status)) &&
+         (WEXITSTATUS(status) == EXIT_SUCCESS) &&
+         (received == repeat);
+}
+
+
+PRIVATE int
+compare_runs(const void *a,
+             const void *b)
+{
+  double  ta  = ((const bench_run_t *)a)->time;
+  double  tb  = ((const bench_run_t *)b)->time;
+
+  return (ta > tb) - (ta < tb);
+}
+
+
+PRIVATE void
+print_result(FILE             *out,
+             int              first,
+             bench_kernel_t   *kernel,
+             bench_sequence_t *seq,
+             unsigned int     repeat,
+             bench_run_t      *runs,
+             long             peak_rss,
+             int              ok)
+{
+  double median;
+
+  fprintf(out,
+          "%s\n    {\n"
+          "      \"kernel\": \"%s\",\n"
+          "      \"sequence\": \"%s\",\n"
+          "      \"set\": \"%s\",\n"
+          "      \"length\": %u,\n",
+          (first) ? "" : ",",
+          kernel->name,
+          seq->name,
+          seq->set,
+          seq->length);
+
+  if (ok) {
+    qsort(runs, repeat, sizeof(bench_run_t), &compare_runs);
+    median = (repeat % 2) ?
+             runs[repeat / 2].time :
+             (runs[repeat / 2 - 1].time + runs[repeat / 2].time) / 2.;
+
+    fprintf(out,
+            "      \"status\": \"ok\",\n"
+            "      \"repeat\": %u,\n"
+            "      \"time_min\": %.6f,\n"
+            "      \"time_median\": %.6f,\n"
+            "      \"time_max\": %.6f,\n"
+            "      \"peak_rss_kb\": %ld",
+            repeat,
+            runs[0].time,
+            median,
+            runs[repeat - 1].time,
+            peak_rss);
+
+    if (runs[0].cells > 0)
+      fprintf(out,
+              ",\n      \"cells\": %.0f,\n"
+              "      \"cells_per_second\": %.6g",
+              runs[0].cells,
+              (median > 0) ? runs[0].cells / median : 0.);
+
+    if (kernel->items_unit)
+      fprintf(out,
+              ",\n      \"items\": %.0f,\n"
+              "      \"items_unit\": \"%s\",\n"
+              "      \"items_per_second\": %.6g",
+              runs[0].items,
+              kernel->items_unit,
+              (median > 0) ? runs[0].items / median : 0.);
+
+    fprintf(out, "\n    }");
+  } else {
+    fprintf(out, "      \"status\": \"failed\"\n    }");
+  }
+}
+
+
+PRIVATE int
+kernel_selected(const char  *name,
+                const char  *list)
+{
+  size_t      len;
+  const char  *p;
+
+  if (!list)
+    return 1;
+
+  len = strlen(name);
+  for (p = list; (p = strstr(p, name)); p += len)
+    if (((p == list) || (p[-1] == ',')) &&
+        ((p[len] == ',') || (p[len] == '\0')))
+      return 1;
+
+  return 0;
+}
+
+
+PRIVATE void
+usage(const char *prog)
+{
+  bench_kernel_t *k;
+
+  fprintf(stderr,
+          "Usage: %s [OPTION]...\n\n"
+          "Benchmark the core folding kernels of RNAlib and write the results in JSON format\n\n"
+          "  --data-dir=DIR    Directory with the test data sets (default: data)\n"
+          "  --output=FILE     Write results to FILE instead of stdout\n"
+          "  --repeat=N        Number of repetitions per benchmark (default: %d)\n"
+          "  --max-length=N    Skip sequences longer than N nt (default: %d)\n"
+          "  --kernels=LIST    Comma separated list of kernels to run (default: all)\n\n"
+          "Available kernels:",
+          prog,
+          BENCH_REPEAT,
+          BENCH_MAX_LENGTH);
+
+  for (k = kernels; k->name; k++)
+    fprintf(stderr, " %s", k->name);
+
+  fprintf(stderr, "\n");
+}
+
+
+int
+main(int  argc,
+     char *argv[])
+{
+  char              *data_dir, *output, *selection, timestamp[32];
+  int               i, first, ok;
+  unsigned int      s, num_seqs, repeat, max_length;
+  long              peak_rss;
+  time_t            now;
+  FILE              *out;
+  struct utsname    host;
+  bench_kernel_t    *k;
+  bench_sequence_t  *seqs;
+  bench_run_t       *runs;
+
+  data_dir    = "data";
+  output      = NULL;
+  selection   = NULL;
+  repeat      = BENCH_REPEAT;
+  max_length  = BENCH_MAX_LENGTH;
+
+  for (i = 1; i < argc; i++) {
+    if (!strncmp(argv[i], "--data-dir=", 11)) {
+      data_dir = argv[i] + 11;
+    } else if (!strncmp(argv[i], "--output=", 9)) {
+      output = argv[i] + 9;
+    } else if (!strncmp(argv[i], "--repeat=", 9)) {
+      repeat = (unsigned int)atoi(argv[i] + 9);
+    } else if (!strncmp(argv[i], "--max-length=", 13)) {
+      max_length = (unsigned int)atoi(argv[i] + 13);
+    } else if (!strncmp(argv[i], "--kernels=", 10)) {
+      selection = argv[i] + 10;
+    } else {
+      usage(argv[0]);
+      return (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h")) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  if (repeat == 0)
+    repeat = 1;
+
+  /* collect the sequence sets */
+  seqs      = NULL;
+  num_seqs  = 0;
+
+  for (s = 0; random_lengths[s]; s++) {
+    char *name = vrna_strdup_printf("random_%u", random_lengths[s]);
+    add_sequence(&seqs, &num_seqs, name, "random", random_sequence(random_lengths[s]));
+    free(name);
+  }
+
+  read_single_sequences(&seqs, &num_seqs, data_dir, "rnafold.seq", "rnafold", 1);
+  read_single_sequences(&seqs, &num_seqs, data_dir, "5domain16S_rRNA_E.coli.db", "E.coli_16S_5domain", 0);
+  read_single_sequences(&seqs, &num_seqs, data_dir, "5domain16S_rRNA_H.volcanii.db", "H.volcanii_16S_5domain", 0);
+  read_alignment(&seqs, &num_seqs, data_dir, "070313_ecoli_cdiff_16S_fasta.aln");
+
+  if (output) {
+    out = fopen(output, "w");
+    if (!out)
+      vrna_message_error("Could not open output file %s", output);
+  } else {
+    out = stdout;
+  }
+
+  now = time(NULL);
+  strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+  if (uname(&host))
+    memset(&host, 0, sizeof(host));
+
+  fprintf(out,
+          "{\n"
+          "  \"version\": \"%s\",\n"
+          "  \"timestamp\": \"%s\",\n"
+          "  \"host\": {\n"
+          "    \"system\": \"%s\",\n"
+          "    \"release\": \"%s\",\n"
+          "    \"machine\": \"%s\"\n"
+          "  },\n"
+          "  \"settings\": {\n"
+          "    \"repeat\": %u,\n"
+          "    \"max_length\": %u,\n"
+          "    \"seed\": %u,\n"
+          "    \"subopt_delta\": %d,\n"
+          "    \"window_size\": %d,\n"
+          "    \"max_bp_span\": %d,\n"
+          "    \"samples\": %d,\n"
+          "    \"findpath_width\": %d\n"
+          "  },\n"
+          "  \"results\": [",
+          VERSION,
+          timestamp,
+          host.sysname,
+          host.release,
+          host.machine,
+          repeat,
+          max_length,
+          BENCH_SEED,
+          BENCH_SUBOPT_DELTA,
+          BENCH_WINDOW_SIZE,
+          BENCH_WINDOW_SPAN,
+          BENCH_SAMPLES,
+          BENCH_FINDPATH_WIDTH);
+
+  runs  = (bench_run_t *)vrna_alloc(sizeof(bench_run_t) * repeat);
+  first = 1;
+  ok    = 1;
+
+  for (k = kernels; k->name; k++) {
+    if (!kernel_selected(k->name, selection))
+      continue;
+
+    for (s = 0; s < num_seqs; s++) {
+      if ((seqs[s].length > k->max_length) ||
+          (seqs[s].length > max_length))
+        continue;
+
+      /* the FASTA readers only depend on the record length */
+      if ((!strncmp(k->name, "fasta_", 6)) && (strcmp(seqs[s].set, "random")))
+        continue;
+
+      fprintf(stderr, "%-14s %-28s %6u nt ... ", k->name, seqs[s].name, seqs[s].length);
+
+      peak_rss = 0;
+      if (run_benchmark(k, &(seqs[s]), repeat, runs, &peak_rss)) {
+        print_result(out, first, k, &(seqs[s]), repeat, runs, peak_rss, 1);
+        fprintf(stderr, "%.3fs\n", runs[repeat / 2].time);
+      } else {
+        print_result(out, first, k, &(seqs[s]), repeat, runs, peak_rss, 0);
+        fprintf(stderr, "failed\n");
+        ok = 0;
+      }
+
+      first = 0;
+      fflush(out);
+    }
+  }
+
+  fprintf(out, "\n  ]\n}\n");
+
+  if (output)
+    fclose(out);
+
+  for (s = 0; s < num_seqs; s++) {
+    free(seqs[s].name);
+    free(seqs[s].sequence);
+  }
+  free(seqs);
+  free(runs);
+
+  return (ok) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
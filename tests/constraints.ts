@@ -1,10 +1,19 @@
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <ViennaRNA/io/file_formats.h>
 #include <ViennaRNA/constraints/basic.h>
 #include <ViennaRNA/constraints/SHAPE.h>
+#include <ViennaRNA/perturbation_fold.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/timing.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 static int
 deltaCompare(double a,
@@ -32,6 +41,56 @@ writeTempFile(char        *tempfile,
 }
 
 
+static void
+perturbation_sampled(const char *seq,
+                     int        seed,
+                     int        threads,
+                     double     *epsilon)
+{
+  double                *q;
+  int                   i, n;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  n = strlen(seq);
+  q = (double *)vrna_alloc(sizeof(double) * (n + 1));
+
+  /* pretend the 5' half was observed unpaired */
+  for (i = 1; i <= n; i++)
+    q[i] = (i <= n / 2) ? 0.9 : 0.1;
+
+  memset(epsilon, 0, sizeof(double) * (n + 1));
+
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+
+  xsubi[0]  = xsubi[1] = xsubi[2] = (unsigned short)seed;
+  vrna_md_set_default(&md);
+  md.uniq_ML = 1;
+
+  fc = vrna_fold_compound(seq, &md, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+
+  /* all threads update the timings of fc while sampling */
+  vrna_timing_enable(fc, 1);
+
+  vrna_sc_minimize_pertubation(fc, q,
+                               VRNA_OBJECTIVE_FUNCTION_QUADRATIC,
+                               0.5, 0.5,
+                               VRNA_MINIMIZER_DEFAULT,
+                               500,
+                               epsilon,
+                               0.01, 1e-15, 1e-3, 1e-3,
+                               NULL);
+
+  if (vrna_timing(fc))
+    ck_assert(vrna_timing(fc)->calls[VRNA_TIMING_SAMPLING] > 0);
+
+  vrna_fold_compound_free(fc);
+  free(q);
+}
+
+
 /* end of prologue */
 
 #suite Constraints
@@ -448,3 +507,34 @@ writeTempFile(char        *tempfile,
   ck_assert(deltaCompare(p1, 0));
   ck_assert(deltaCompare(p2, 0));
 }
+
+
+#tcase  Perturbation
+
+#test test_vrna_sc_minimize_pertubation_sampling_seed
+{
+  const char  *seq = "GGGAAAUCCCGCUUCGGCGGGAUUUCCCAAAGGCGAUCGCC";
+  double      *e1, *e2, *e3;
+  int         n;
+
+  n   = strlen(seq);
+  e1  = (double *)vrna_alloc(sizeof(double) * (n + 1));
+  e2  = (double *)vrna_alloc(sizeof(double) * (n + 1));
+  e3  = (double *)vrna_alloc(sizeof(double) * (n + 1));
+
+  /* the same seed yields the same perturbation vector for any number of threads */
+  perturbation_sampled(seq, 4711, 1, e1);
+  perturbation_sampled(seq, 4711, 4, e2);
+  perturbation_sampled(seq, 4711, 4, e3);
+
+  ck_assert(memcmp(e1, e2, sizeof(double) * (n + 1)) == 0);
+  ck_assert(memcmp(e2, e3, sizeof(double) * (n + 1)) == 0);
+
+  /* while the samples actually depend on the seed */
+  perturbation_sampled(seq, 42, 4, e3);
+  ck_assert(memcmp(e1, e3, sizeof(double) * (n + 1)) != 0);
+
+  free(e1);
+  free(e2);
+  free(e3);
+}
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ViennaRNA/treedist.h>
+#include <ViennaRNA/stringdist.h>
+#include <ViennaRNA/RNAstruct.h>
+#include <ViennaRNA/dist_vars.h>
+#include <ViennaRNA/dist_matrix.h>
+#include <ViennaRNA/utils/basic.h>
+
+#define NUM_STRUCTURES  6
+
+static const char *structures[NUM_STRUCTURES] = {
+  "((((((...((((........)))).(((((.......))))).....(((((.......))))).))))))....",
+  "((((((...((((........)))).........................(((((.......))))).))))))..",
+  "..((((((((.....))))((((.....)))).))))....(((((((......)))))))...............",
+  "............................................................................",
+  "(((((((((....)))))...((((((((....))))))))..(((....)))..)))).................",
+  ".....((((((((....))))))))......................((((((((....))))))))........."
+};
+
+#suite Distance_Matrix
+
+#tcase All_vs_All
+
+#test test_edit_distance_matrix
+{
+  int       i, j, cm;
+  char      *xstruc;
+  float     *tm, *sm;
+  Tree      *T[NUM_STRUCTURES];
+  swString  *S[NUM_STRUCTURES];
+
+  for (cm = 0; cm < 2; cm++) {
+    cost_matrix = cm;
+
+    for (i = 0; i < NUM_STRUCTURES; i++) {
+      xstruc  = (cm) ? b2Shapiro((char *)structures[i]) : expand_Full((char *)structures[i]);
+      T[i]    = make_tree(xstruc);
+      S[i]    = Make_swString(xstruc);
+      free(xstruc);
+    }
+
+    tm  = tree_edit_distance_matrix(T, NUM_STRUCTURES, 3);
+    sm  = string_edit_distance_matrix(S, NUM_STRUCTURES, 3);
+
+    ck_assert(tm != NULL);
+    ck_assert(sm != NULL);
+
+    for (i = 0; i < NUM_STRUCTURES; i++)
+      for (j = i + 1; j < NUM_STRUCTURES; j++) {
+        ck_assert(tm[VRNA_DIST_MATRIX_INDEX(NUM_STRUCTURES, i, j)] == tree_edit_distance(T[j], T[i]));
+        ck_assert(sm[VRNA_DIST_MATRIX_INDEX(NUM_STRUCTURES, i, j)] == string_edit_distance(S[j], S[i]));
+        ck_assert(vrna_dist_matrix_get(tm, NUM_STRUCTURES, j, i) == tree_edit_distance(T[j], T[i]));
+      }
+
+    ck_assert(vrna_dist_matrix_get(tm, NUM_STRUCTURES, 2, 2) == 0.);
+
+    for (i = 0; i < NUM_STRUCTURES; i++) {
+      free_tree(T[i]);
+      free(S[i]);
+    }
+    free(tm);
+    free(sm);
+  }
+
+  cost_matrix = 0;
+}
+
+#test test_distance_matrix_file
+{
+  float         matrix[3] = {
+    1., 2., 3.
+  };
+  const char    *labels[3] = {
+    "first", "second_label_too_long", NULL
+  };
+  char          buf[256];
+  unsigned int  header[2];
+  float         values[3];
+  FILE          *fp;
+
+  fp = tmpfile();
+  ck_assert(vrna_file_distance_matrix(fp, matrix, 3, labels, VRNA_DIST_MATRIX_PHYLIP) == 1);
+  rewind(fp);
+  ck_assert(fgets(buf, sizeof(buf), fp) != NULL);
+  ck_assert_str_eq(buf, "    3\n");
+  ck_assert(fgets(buf, sizeof(buf), fp) != NULL);
+  ck_assert_str_eq(buf, "first      0 1 2\n");
+  ck_assert(fgets(buf, sizeof(buf), fp) != NULL);
+  ck_assert_str_eq(buf, "second_lab 1 0 3\n");
+  ck_assert(fgets(buf, sizeof(buf), fp) != NULL);
+  ck_assert_str_eq(buf, "3          2 3 0\n");
+  fclose(fp);
+
+  fp = tmpfile();
+  ck_assert(vrna_file_distance_matrix(fp, matrix, 3, NULL, VRNA_DIST_MATRIX_BINARY) == 1);
+  rewind(fp);
+  ck_assert(fread(buf, sizeof(char), 8, fp) == 8);
+  ck_assert(strncmp(buf, "VRNADIST", 8) == 0);
+  ck_assert(fread(header, sizeof(unsigned int), 2, fp) == 2);
+  ck_assert(header[0] == 1);
+  ck_assert(header[1] == 3);
+  ck_assert(fread(values, sizeof(float), 3, fp) == 3);
+  ck_assert(memcmp(values, matrix, sizeof(matrix)) == 0);
+  fclose(fp);
+}
@@ -7,7 +7,67 @@
 #include <ViennaRNA/utils/structures.h>
 #include <ViennaRNA/constraints/basic.h>
 #include <ViennaRNA/fold.h>
+#include <ViennaRNA/mfe.h>
 #include <ViennaRNA/part_func.h>
+#include <ViennaRNA/eval.h>
+#include <ViennaRNA/utils/alignments.h>
+#include <ViennaRNA/part_func_up.h>
+#include <ViennaRNA/vrna_config.h>
+#include <ViennaRNA/utils/timing.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define BATCH_SIZE  24
+
+/* a fixed set of pseudo-random sequences for the multi-threading tests */
+static char **
+batch_sequences(void)
+{
+  char          **seqs;
+  unsigned int  i, j, n, r;
+
+  seqs  = (char **)vrna_alloc(sizeof(char *) * (BATCH_SIZE + 1));
+  r     = 4711;
+
+  for (i = 0; i < BATCH_SIZE; i++) {
+    n       = 30 + 7 * i;
+    seqs[i] = (char *)vrna_alloc(sizeof(char) * (n + 1));
+    for (j = 0; j < n; j++) {
+      r           = r * 1103515245 + 12345;
+      seqs[i][j]  = "ACGU"[(r >> 16) & 3];
+    }
+  }
+
+  return seqs;
+}
+
+
+static void
+free_strings(char **s)
+{
+  char **ptr;
+
+  for (ptr = s; *ptr; ptr++)
+    free(*ptr);
+  free(s);
+}
+
+
+/* memory recorded for a particular DP matrix */
+static size_t
+timing_mx_bytes(const vrna_timing_t *t,
+                const char          *name)
+{
+  unsigned int i;
+
+  for (i = 0; i < t->num_matrices; i++)
+    if (!strcmp(t->matrices[i].name, name))
+      return t->matrices[i].bytes;
+
+  return 0;
+}
 
 #suite  MFE_Prediction
 
@@ -24,6 +84,506 @@
   free(structure);
 }
 
+#tcase  Incremental_Update
+
+#test test_mfe_mutate
+{
+  const char            *seq1 =
+    "UGCCUGGCGGCCGUAGCGCGGUGGUCCCACCUGACCCCAUGCCGAACUCAGAAGUGAAACGCCGUAGCGCCGAUGGUAGUGUGGGGUCUCC";
+  const char            *nt = "ACGU";
+  char                  *seq, *s1, *s2;
+  int                   d, k, n;
+  float                 e1, e2;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc, *fc_full;
+
+  n   = strlen(seq1);
+  seq = strdup(seq1);
+  s1  = (char *)malloc(sizeof(char) * (n + 1));
+  s2  = (char *)malloc(sizeof(char) * (n + 1));
+
+  for (d = 0; d <= 3; d++) {
+    vrna_md_set_default(&md);
+    md.dangles = d;
+
+    strcpy(seq, seq1);
+    fc = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+    (void)vrna_mfe(fc, s1);
+
+    /* mutate positions throughout the sequence, including both ends */
+    for (k = 0; k < n; k += 7) {
+      seq[k]          = nt[(k + d) % 4];
+      seq[n - 1 - k]  = nt[(k + d + 1) % 4];
+
+      e1      = vrna_mfe_mutate(fc, seq, s1);
+      fc_full = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+      e2      = vrna_mfe(fc_full, s2);
+
+      ck_assert(e1 == e2);
+      ck_assert(strcmp(s1, s2) == 0);
+
+      vrna_fold_compound_free(fc_full);
+    }
+
+    vrna_fold_compound_free(fc);
+  }
+
+  free(seq);
+  free(s1);
+  free(s2);
+}
+
+#test test_mfe_mutate_constraints
+{
+  const char            *seq1 =
+    "UGCCUGGCGGCCGUAGCGCGGUGGUCCCACCUGACCCCAUGCCGAACUCAGAAGUGAAACGCCGUAGCGCCGAUGGUAGUGUGGGGUCUCC";
+  const char            *nt = "ACGU";
+  unsigned int          pos[] = {
+    2, 30, 45, 60, 85, 0
+  };
+  char                  *seq, *s1, *s2;
+  int                   k, m, n;
+  float                 e1, e2;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc, *fc_full;
+
+  n   = strlen(seq1);
+  seq = strdup(seq1);
+  s1  = (char *)malloc(sizeof(char) * (n + 1));
+  s2  = (char *)malloc(sizeof(char) * (n + 1));
+
+  vrna_md_set_default(&md);
+
+  fc = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+  vrna_hc_add_up(fc, 2, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
+  vrna_hc_add_bp(fc, 20, 70, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+  (void)vrna_mfe(fc, s1);
+
+  /* mutate the constrained nucleotide and positions within and outside the forced pair */
+  for (m = 0; m < 4; m++) {
+    for (k = 0; pos[k]; k++)
+      seq[pos[k] - 1] = nt[(m + k) % 4];
+
+    e1      = vrna_mfe_mutate(fc, seq, s1);
+    fc_full = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+    vrna_hc_add_up(fc_full, 2, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
+    vrna_hc_add_bp(fc_full,
+                   20,
+                   70,
+                   VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+    e2 = vrna_mfe(fc_full, s2);
+
+    ck_assert(e1 == e2);
+    ck_assert(strcmp(s1, s2) == 0);
+    ck_assert(s1[1] == '.');
+    ck_assert(s1[19] == '(');
+    ck_assert(s1[69] == ')');
+
+    vrna_fold_compound_free(fc_full);
+  }
+
+  /* revert all mutations */
+  strcpy(seq, seq1);
+  e1      = vrna_mfe_mutate(fc, seq, s1);
+  fc_full = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+  vrna_hc_add_up(fc_full, 2, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
+  vrna_hc_add_bp(fc_full, 20, 70, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+  e2 = vrna_mfe(fc_full, s2);
+
+  ck_assert(e1 == e2);
+  ck_assert(strcmp(s1, s2) == 0);
+  ck_assert(s1[1] == '.');
+
+  vrna_fold_compound_free(fc_full);
+  vrna_fold_compound_free(fc);
+
+  free(seq);
+  free(s1);
+  free(s2);
+}
+
+
+#tcase  Comparative_Weights
+
+#test test_comparative_weights_uniform
+{
+  const char            *aln[] = {
+    "GGGGUAUAGCUCAGUUGGUAGAGCGCUGCCUUUGCACGGCAGAUGUCAGGGGUUCGAGUCCCCUUACCUCCA",
+    "GGGGUAUAGCUCAGU-GGUAGAGCGCUGCCUUUGCACGGCAGAUGUCAGGGGUUCGAGUCCCCUUACCUCCA",
+    "GCGGAUUUAGCUCAGUUGGGAGAGCGCCAGACUGAAGAUCUGGAGGUCCUGUGUUCGAUCCACAGAAUUCGC",
+    NULL
+  };
+  unsigned int          w[] = {
+    1, 1, 1
+  };
+  char                  *s1, *s2;
+  int                   i, j, n;
+  float                 e1, e2;
+  double                g1, g2;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc1, *fc2;
+
+  n   = strlen(aln[0]);
+  s1  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  s2  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+
+  vrna_md_set_default(&md);
+
+  fc1 = vrna_fold_compound_comparative(aln, &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+  fc2 = vrna_fold_compound_comparative_weighted(aln, w, &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+
+  ck_assert_int_eq(fc2->n_seq_total, 3);
+  ck_assert_str_eq(fc1->cons_seq, fc2->cons_seq);
+
+  e1 = vrna_mfe(fc1, s1);
+  e2 = vrna_mfe(fc2, s2);
+  ck_assert(e1 == e2);
+  ck_assert_str_eq(s1, s2);
+
+  g1  = vrna_pf(fc1, NULL);
+  g2  = vrna_pf(fc2, NULL);
+  ck_assert(g1 == g2);
+
+  for (i = 1; i < n; i++)
+    for (j = i + 1; j <= n; j++)
+      ck_assert(fc1->exp_matrices->probs[fc1->iindx[i] - j] ==
+                fc2->exp_matrices->probs[fc2->iindx[i] - j]);
+
+  vrna_fold_compound_free(fc1);
+  vrna_fold_compound_free(fc2);
+  free(s1);
+  free(s2);
+}
+
+#test test_comparative_weights_collapsed
+{
+  /*
+   *  the first two sequences differ in a single column only, and are
+   *  outnumbered by the third in the uncollapsed alignment
+   */
+  const char            *rep[] = {
+    "GGGGUAUAGCUCAGUUGGUAGAGCGCUGCCUUUGCACGGCAGAUGUCAGGGGUUCGAGUCCCCUUACCUCCA",
+    "GGGGUAUAGCUCAGU-GGUAGAGCGCUGCCUUUGCACGGCAGAUGUCAGGGGUUCGAGUCCCCUUACCUCCA",
+    "GCGGAUUUAGCUCAGUUGGGAGAGCGCCAGACUGAAGAUCUGGAGGUCCUGUGUUCGAUCCACAGAAUUCGC",
+    NULL
+  };
+  unsigned int          reps[] = {
+    1, 1, 3
+  };
+  const char            *full[6];
+  char                  *s1, *s2, *cons, *cons_unweighted, **collapsed;
+  int                   i, j, k, s, n, d;
+  unsigned int          *w;
+  float                 e1, e2;
+  double                g1, g2, mfe;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc1, *fc2;
+
+  for (k = s = 0; rep[s]; s++)
+    for (i = 0; i < reps[s]; i++)
+      full[k++] = rep[s];
+
+  full[k] = NULL;
+
+  n   = strlen(rep[0]);
+  s1  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  s2  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+
+  collapsed = vrna_aln_collapse(full, 0, &w);
+  ck_assert_int_eq(w[0], 1);
+  ck_assert_int_eq(w[1], 1);
+  ck_assert_int_eq(w[2], 3);
+
+  /* the consensus follows the weights rather than the representatives */
+  cons            = vrna_aln_consensus_sequence(full, NULL);
+  cons_unweighted = vrna_aln_consensus_sequence((const char **)collapsed, NULL);
+  ck_assert(strcmp(cons, cons_unweighted) != 0);
+
+  /* comparative structure prediction supports dangles 0 and 2 only */
+  for (d = 0; d <= 2; d += 2) {
+    vrna_md_set_default(&md);
+    md.dangles = d;
+
+    fc1 = vrna_fold_compound_comparative(full, &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+    fc2 = vrna_fold_compound_comparative_weighted((const char **)collapsed,
+                                                  w,
+                                                  &md,
+                                                  VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+
+    ck_assert_int_eq(fc2->n_seq, 3);
+    ck_assert_int_eq(fc2->n_seq_total, 5);
+    ck_assert_str_eq(fc1->cons_seq, cons);
+    ck_assert_str_eq(fc2->cons_seq, cons);
+
+    e1 = vrna_mfe(fc1, s1);
+    e2 = vrna_mfe(fc2, s2);
+    ck_assert(fabs(e1 - e2) < 1e-4);
+    ck_assert_str_eq(s1, s2);
+    ck_assert(fabs(vrna_eval_structure(fc1, s1) - vrna_eval_structure(fc2, s1)) < 1e-4);
+
+    mfe = (double)e1;
+    vrna_exp_params_rescale(fc1, &mfe);
+    vrna_exp_params_rescale(fc2, &mfe);
+
+    g1  = vrna_pf(fc1, NULL);
+    g2  = vrna_pf(fc2, NULL);
+    ck_assert(fabs(g1 - g2) < 1e-4);
+
+    for (i = 1; i < n; i++)
+      for (j = i + 1; j <= n; j++)
+        ck_assert(fabs(fc1->exp_matrices->probs[fc1->iindx[i] - j] -
+                       fc2->exp_matrices->probs[fc2->iindx[i] - j]) < 1e-6);
+
+    vrna_fold_compound_free(fc1);
+    vrna_fold_compound_free(fc2);
+  }
+
+  vrna_aln_free(collapsed);
+  free(w);
+  free(cons);
+  free(cons_unweighted);
+  free(s1);
+  free(s2);
+}
+
+#tcase  Memory_Budget
+
+#test test_mx_memory_budget
+{
+  const char            *seq1 = "CGCAGGGAUACCCGCGUAGCGCGGUGGUCCCACCUGACCCCAUGCCGAACUCAG";
+  char                  *structure;
+  size_t                used, predicted;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  structure = (char *)malloc(sizeof(char) * (strlen(seq1) + 1));
+  used      = vrna_mx_memory_used();
+
+  vrna_md_set_default(&md);
+  md.circ   = 1;
+  md.gquad  = 1;
+  predicted = vrna_mx_memory(VRNA_MX_DEFAULT, strlen(seq1), &md, VRNA_OPTION_MFE);
+
+  /* the prediction matches what is reserved for the DP matrices */
+  fc = vrna_fold_compound(seq1, &md, VRNA_OPTION_DEFAULT);
+  ck_assert(vrna_fold_compound_prepare(fc, VRNA_OPTION_MFE) == 1);
+  ck_assert(vrna_mx_memory_used() - used == predicted);
+  vrna_fold_compound_free(fc);
+  ck_assert(vrna_mx_memory_used() == used);
+
+  /* preparation fails gracefully if the budget is exceeded */
+  vrna_mx_memory_budget_set(used + predicted - 1);
+  fc = vrna_fold_compound(seq1, &md, VRNA_OPTION_DEFAULT);
+  ck_assert(vrna_fold_compound_prepare(fc, VRNA_OPTION_MFE) == 0);
+  ck_assert(vrna_mx_memory_used() == used);
+  vrna_fold_compound_free(fc);
+
+  vrna_mx_memory_budget_set(used + predicted);
+  fc = vrna_fold_compound(seq1, &md, VRNA_OPTION_DEFAULT);
+  ck_assert(vrna_mfe(fc, structure) < 0.);
+  vrna_fold_compound_free(fc);
+
+  vrna_mx_memory_budget_set(0);
+  free(structure);
+}
+
+#test test_mx_ref
+{
+  const char            *seq1 = "CGCAGGGAUACCCGCGUAGCGCGGUGGUCCCACCUGACCCCAUGCCGAACUCAG";
+  char                  *structure;
+  int                   n, *f5;
+  float                 mfe;
+  size_t                used;
+  vrna_mx_mfe_t         *mx;
+  vrna_fold_compound_t  *fc;
+
+  n         = strlen(seq1);
+  structure = (char *)malloc(sizeof(char) * (n + 1));
+  used      = vrna_mx_memory_used();
+
+  fc  = vrna_fold_compound(seq1, NULL, VRNA_OPTION_DEFAULT);
+  mfe = vrna_mfe(fc, structure);
+  mx  = vrna_mx_mfe_ref(fc);
+  ck_assert(mx == fc->matrices);
+  f5 = mx->f5;
+
+  /* re-allocation detaches the referenced matrices from the fold compound, but keeps them */
+  ck_assert(vrna_mx_mfe_add(fc, VRNA_MX_DEFAULT, VRNA_OPTION_MFE) == 1);
+  ck_assert(fc->matrices != mx);
+  ck_assert(vrna_mx_memory_used() - used == fc->matrices->bytes + mx->bytes);
+  ck_assert(mx->f5 == f5);
+  ck_assert(f5[n] == (int)(mfe * 100. + (mfe < 0 ? -0.5 : 0.5)));
+
+  /* they are released together with the last reference */
+  vrna_mx_mfe_unref(mx);
+  ck_assert(vrna_mx_memory_used() - used == fc->matrices->bytes);
+
+  /* the same holds if the fold compound goes first */
+  (void)vrna_pf(fc, NULL);
+  ck_assert(vrna_mx_mfe_ref(NULL) == NULL);
+  ck_assert(vrna_mx_pf_ref(fc) == fc->exp_matrices);
+  ck_assert(vrna_mx_pf_ref(fc) == fc->exp_matrices);
+  vrna_mx_pf_unref(fc->exp_matrices);
+  vrna_mx_pf_unref(fc->exp_matrices);
+
+  mx = vrna_mx_mfe_ref(fc);
+  vrna_fold_compound_free(fc);
+  ck_assert(vrna_mx_memory_used() - used == mx->bytes);
+  vrna_mx_mfe_unref(mx);
+  ck_assert(vrna_mx_memory_used() == used);
+
+  free(structure);
+}
+
+#tcase  Multi_Threading
+
+#test test_fold_batch
+{
+  char  **seqs, **structures, *structure;
+  int   i, t, threads[3] = {
+    1, 4, 0
+  };
+  float *mfes, mfe;
+
+  seqs = batch_sequences();
+
+  for (t = 0; t < 3; t++) {
+    structures  = (char **)vrna_alloc(sizeof(char *) * (BATCH_SIZE + 1));
+    mfes        = vrna_fold_batch((const char **)seqs, NULL, structures, threads[t]);
+
+    for (i = 0; i < BATCH_SIZE; i++) {
+      structure = (char *)vrna_alloc(sizeof(char) * (strlen(seqs[i]) + 1));
+      mfe       = vrna_fold(seqs[i], structure);
+      ck_assert_str_eq(structures[i], structure);
+      ck_assert(mfes[i] == mfe);
+      free(structure);
+    }
+
+    free_strings(structures);
+    free(mfes);
+  }
+
+  /* energies only */
+  mfes = vrna_fold_batch((const char **)seqs, NULL, NULL, 4);
+  for (i = 0; i < BATCH_SIZE; i++)
+    ck_assert(mfes[i] == vrna_fold(seqs[i], NULL));
+
+  free(mfes);
+  free_strings(seqs);
+}
+
+#test test_concurrent_fold_compounds
+{
+  char      **seqs, **structures[2];
+  int       i, t;
+  double    *ens[2];
+  vrna_md_t md;
+
+  seqs = batch_sequences();
+  vrna_md_set_default(&md);
+  md.uniq_ML = 1;
+
+  /*
+   *  MFE, partition function, and stochastic backtracking on separate fold
+   *  compounds, first serially, then concurrently
+   */
+  for (t = 0; t < 2; t++) {
+    structures[t] = (char **)vrna_alloc(sizeof(char *) * (2 * BATCH_SIZE + 1));
+    ens[t]        = (double *)vrna_alloc(sizeof(double) * 2 * BATCH_SIZE);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads((t) ? 4 : 1)
+#endif
+    for (i = 0; i < BATCH_SIZE; i++) {
+      vrna_fold_compound_t *fc = vrna_fold_compound(seqs[i], &md, VRNA_OPTION_DEFAULT);
+
+      structures[t][2 * i]  = (char *)vrna_alloc(sizeof(char) * (fc->length + 1));
+      ens[t][2 * i]         = vrna_mfe(fc, structures[t][2 * i]);
+      vrna_exp_params_rescale(fc, &(ens[t][2 * i]));
+      ens[t][2 * i + 1]         = vrna_pf(fc, NULL);
+      structures[t][2 * i + 1]  = vrna_pbacktrack(fc);
+      vrna_fold_compound_free(fc);
+    }
+  }
+
+  for (i = 0; i < 2 * BATCH_SIZE; i++) {
+    ck_assert(ens[0][i] == ens[1][i]);
+    if (i % 2)  /* samples are random, but need to be valid structures */
+      ck_assert_int_eq(strlen(structures[1][i]), strlen(seqs[i / 2]));
+    else
+      ck_assert_str_eq(structures[0][i], structures[1][i]);
+  }
+
+  for (t = 0; t < 2; t++) {
+    free_strings(structures[t]);
+    free(ens[t]);
+  }
+
+  free_strings(seqs);
+}
+
+#tcase  Timing
+
+#test test_timing
+{
+  const char            *seq1 = "CGCAGGGAUACCCGCGUAGCGCGGUGGUCCCACCUGACCCCAUGCCGAACUCAG";
+  char                  *structure;
+  int                   i;
+  double                mfe;
+  const vrna_timing_t   *t;
+  vrna_fold_compound_t  *fc;
+  vrna_timing_phase_e   phases[] = {
+    VRNA_TIMING_MFE_FILL, VRNA_TIMING_MFE_BACKTRACK, VRNA_TIMING_PF_FILL, VRNA_TIMING_PF_OUTSIDE
+  };
+  vrna_timing_phase_e   filled[] = {
+    VRNA_TIMING_MFE_FILL, VRNA_TIMING_PF_FILL, VRNA_TIMING_PF_OUTSIDE
+  };
+
+  structure = (char *)vrna_alloc(sizeof(char) * (strlen(seq1) + 1));
+  fc        = vrna_fold_compound(seq1, NULL, VRNA_OPTION_DEFAULT);
+
+  /* nothing is recorded unless enabled */
+  ck_assert(vrna_timing(fc) == NULL);
+
+#ifdef VRNA_WITH_TIMING
+  ck_assert_int_eq(vrna_timing_enable(fc, 1), 1);
+
+  mfe = vrna_mfe(fc, structure);
+  vrna_exp_params_rescale(fc, &mfe);
+  (void)vrna_pf(fc, NULL);
+
+  t = vrna_timing(fc);
+  ck_assert(t != NULL);
+
+  for (i = 0; i < (int)(sizeof(phases) / sizeof(phases[0])); i++)
+    ck_assert_msg(t->calls[phases[i]] > 0,
+                  "phase \"%s\" was not entered",
+                  vrna_timing_phase_name(phases[i]));
+
+  for (i = 0; i < (int)(sizeof(filled) / sizeof(filled[0])); i++)
+    ck_assert_msg(t->cells[filled[i]] > 0,
+                  "no cells recorded for phase \"%s\"",
+                  vrna_timing_phase_name(filled[i]));
+
+  ck_assert(t->calls[VRNA_TIMING_PARAMS] > 0);
+  ck_assert(timing_mx_bytes(t, "c") > 0);
+  ck_assert(timing_mx_bytes(t, "qb") > 0);
+  ck_assert(t->mx_bytes > 0);
+
+  /* disabling discards the recorded data */
+  ck_assert_int_eq(vrna_timing_enable(fc, 0), 1);
+  ck_assert(vrna_timing(fc) == NULL);
+  (void)vrna_mfe(fc, structure);
+  ck_assert(vrna_timing(fc) == NULL);
+#else
+  ck_assert_int_eq(vrna_timing_enable(fc, 1), 0);
+  ck_assert(vrna_timing(fc) == NULL);
+#endif
+
+  vrna_fold_compound_free(fc);
+  free(structure);
+}
+
 #suite  Partition_Function
 
 #tcase Stochastic_Backtracking
@@ -55,6 +615,119 @@
   vrna_fold_compound_free(vc);
 }
 
+#tcase  Interaction
+
+#test test_pf_interact_batch
+{
+  const char  *target =
+    "AGAGUUUUUCGAACUCGUGUUGUCGAGCGACGGAAUUAGAUCAGUUAAAUGGCAGAAAACUGGCAGGGCUUUUAGUCGUGGGAUGAUCAGUGGGUAAAGGUGGCGCGG";
+  const char  *queries[] = {
+    "CGUAAUGCCUUUCCCUAA",
+    "AGCUGGUGUGUUAUCCAUUC",
+    "AGAAUCCUAAAUCAGAAAUGGAACA",
+    "UCUGAUUUUCUAGGGU",
+    NULL
+  };
+  char        *structure;
+  int         q, i, n, w;
+  pu_contrib  *p_c, *p_c2[5];
+  pu_target   *profile;
+  interact    *single, *legacy, **batch;
+
+  /*
+   *  reference values computed with pf_interact() before target profiles
+   *  were introduced: Gikjl, Gikjl_wo, i, j, k, l, and Gi[] at i = 10, 37, 82
+   */
+  const struct {
+    double  Gikjl, Gikjl_wo;
+    int     i, j, k, l;
+    double  Gi[3];
+  } ref[] = {
+    { -13.181411858164582, -15.8257808939609,   107, 1, 92, 15,
+      { 0., -2.6418807747785134, -5.5808525196449423 } },
+    { -8.3396957492721668, -11.922325291613685, 46,  1, 32, 16,
+      { 0., -8.3424831245355975, -5.5278809865604357 } },
+    { -2.2074006069178309, -6.7009005780603577, 84,  4, 79, 9,
+      { -1.4745320285437595, -1.225999184527337, -2.2108921172983513 } },
+    { -5.2700367652538782, -9.239178914901327,  90,  2, 81, 11,
+      { 0., -5.2148544142305582, -5.2763053975395486 } }
+  };
+  const int   ref_pos[] = {
+    10, 37, 82
+  };
+
+  w = 20;
+  n = strlen(target);
+
+  /* probabilities of being unpaired for target and queries */
+  structure = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  (void)pf_fold(target, structure);
+  p_c = pf_unstru((char *)target, w);
+  free_pf_arrays();
+
+  for (q = 0; queries[q]; q++) {
+    (void)pf_fold(queries[q], structure);
+    p_c2[q] = pf_unstru((char *)queries[q], w);
+    free_pf_arrays();
+  }
+  p_c2[q] = NULL;
+  free(structure);
+
+  profile = pf_unstru_target(target, p_c, w, 0, 0);
+  ck_assert(profile != NULL);
+
+  batch = pf_interact_batch(profile, queries, p_c2, 4);
+  ck_assert(batch != NULL);
+
+  for (q = 0; queries[q]; q++) {
+    single  = pf_interact_target(profile, queries[q], p_c2[q], NULL);
+    legacy  = pf_interact(target, queries[q], p_c, p_c2[q], w, NULL, 0, 0);
+
+    ck_assert(batch[q] != NULL);
+    ck_assert(single != NULL);
+
+    /* batch results equal the per-query results exactly */
+    ck_assert(batch[q]->Gikjl == single->Gikjl);
+    ck_assert(batch[q]->Gikjl_wo == single->Gikjl_wo);
+    ck_assert_int_eq(batch[q]->i, single->i);
+    ck_assert_int_eq(batch[q]->k, single->k);
+    ck_assert_int_eq(batch[q]->j, single->j);
+    ck_assert_int_eq(batch[q]->l, single->l);
+    ck_assert_int_eq(batch[q]->length, n);
+    for (i = 1; i <= n; i++) {
+      ck_assert(batch[q]->Pi[i] == single->Pi[i]);
+      ck_assert(batch[q]->Gi[i] == single->Gi[i]);
+    }
+
+    /* and so do those of the non re-entrant interface */
+    ck_assert(legacy->Gikjl == single->Gikjl);
+    ck_assert_int_eq(legacy->i, single->i);
+    ck_assert_int_eq(legacy->k, single->k);
+    ck_assert_int_eq(legacy->j, single->j);
+    ck_assert_int_eq(legacy->l, single->l);
+
+    /* and all of them the pre-change implementation */
+    ck_assert(fabs(single->Gikjl - ref[q].Gikjl) < 1e-9);
+    ck_assert(fabs(single->Gikjl_wo - ref[q].Gikjl_wo) < 1e-9);
+    ck_assert_int_eq(single->i, ref[q].i);
+    ck_assert_int_eq(single->j, ref[q].j);
+    ck_assert_int_eq(single->k, ref[q].k);
+    ck_assert_int_eq(single->l, ref[q].l);
+    for (i = 0; i < 3; i++)
+      ck_assert(fabs(single->Gi[ref_pos[i]] - ref[q].Gi[i]) < 1e-9);
+
+    free_interact(single);
+    free_interact(legacy);
+    free_interact(batch[q]);
+    free_pu_contrib_struct(p_c2[q]);
+  }
+  ck_assert(batch[q] == NULL);
+
+  free(batch);
+  free_pu_target(profile);
+  free_pu_contrib_struct(p_c);
+}
+
 #suite  Constraints_Implementation
 
 #tcase  Soft_Constraints
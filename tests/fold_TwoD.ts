@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <ViennaRNA/data_structures.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/mfe.h>
+#include <ViennaRNA/dp_matrices.h>
+#include <ViennaRNA/2Dfold.h>
+#include <ViennaRNA/2Dpfold.h>
+
+static const char *seq =
+  "GGGCUAUUAGCUCAGUUGGUUAGAGCGCACCCCUGAUAAGGGUGAGGUCGCUGAUUCGAAUUCAGCAUAGCCCA";
+
+
+static int
+corridor(unsigned int k,
+         unsigned int l,
+         void         *data)
+{
+  return k + l <= *((unsigned int *)data);
+}
+
+
+static vrna_fold_compound_t *
+TwoD_compound_circ(int circ)
+{
+  char                  *ref1, *ref2;
+  unsigned int          n;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  vrna_md_set_default(&md);
+  md.uniq_ML  = 1;
+  md.circ     = circ;
+
+  /* distances to the MFE structure and the open chain */
+  n     = strlen(seq);
+  ref1  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  ref2  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  memset(ref2, '.', n);
+
+  fc = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+  (void)vrna_mfe(fc, ref1);
+  vrna_fold_compound_free(fc);
+
+  fc = vrna_fold_compound_TwoD(seq, ref1, ref2, &md, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+  free(ref1);
+  free(ref2);
+
+  return fc;
+}
+
+
+static vrna_fold_compound_t *
+TwoD_compound(void)
+{
+  return TwoD_compound_circ(0);
+}
+
+
+/* end of prologue */
+
+#suite TwoD_Folding
+
+#tcase Band
+
+#test test_TwoD_band_mfe
+{
+  unsigned int          c = 30;
+  int                   i, j, n, found, beyond;
+  vrna_fold_compound_t  *fc;
+  vrna_sol_TwoD_t       *full, *band;
+
+  fc    = TwoD_compound();
+  full  = vrna_mfe_TwoD(fc, -1, -1);
+  vrna_fold_compound_free(fc);
+
+  fc = TwoD_compound();
+  ck_assert_int_eq(vrna_TwoD_set_band(fc, &corridor, &c), 1);
+  band = vrna_mfe_TwoD(fc, -1, -1);
+  vrna_fold_compound_free(fc);
+
+  /*
+   *  the band lists exactly the classes of the full run within the corridor,
+   *  plus the remainder class (-1,-1) for everything beyond
+   */
+  for (n = 0, i = 0; band[i].k != INF; i++) {
+    if (band[i].k == -1) {
+      ck_assert(band[i].l == -1);
+      continue;
+    }
+
+    ck_assert((unsigned int)(band[i].k + band[i].l) <= c);
+    n++;
+  }
+
+  for (beyond = found = 0, j = 0; full[j].k != INF; j++) {
+    if ((unsigned int)(full[j].k + full[j].l) > c) {
+      beyond++;
+      continue;
+    }
+
+    for (i = 0; band[i].k != INF; i++)
+      if ((band[i].k == full[j].k) && (band[i].l == full[j].l))
+        break;
+
+    ck_assert_msg(band[i].k != INF, "class (%d,%d) missing in band", full[j].k, full[j].l);
+    ck_assert(band[i].en == full[j].en);
+    ck_assert_str_eq(band[i].s, full[j].s);
+    found++;
+  }
+
+  ck_assert_int_eq(found, n);
+  ck_assert(found > 0);
+  ck_assert(beyond > 0);
+
+  for (i = 0; full[i].k != INF; i++)
+    free(full[i].s);
+  for (i = 0; band[i].k != INF; i++)
+    free(band[i].s);
+
+  free(full);
+  free(band);
+}
+
+#test test_TwoD_band_pf
+{
+  unsigned int          c = 30;
+  int                   i, j, n, found, beyond;
+  vrna_fold_compound_t  *fc;
+  vrna_sol_TwoD_pf_t    *full, *band;
+
+  fc = TwoD_compound();
+  vrna_exp_params_rescale(fc, NULL);
+  full = vrna_pf_TwoD(fc, -1, -1);
+  vrna_fold_compound_free(fc);
+
+  fc = TwoD_compound();
+  ck_assert_int_eq(vrna_TwoD_set_band(fc, &corridor, &c), 1);
+  vrna_exp_params_rescale(fc, NULL);
+  band = vrna_pf_TwoD(fc, -1, -1);
+  vrna_fold_compound_free(fc);
+
+  for (n = 0, i = 0; band[i].k != INF; i++) {
+    if (band[i].k == -1) {
+      ck_assert(band[i].l == -1);
+      continue;
+    }
+
+    ck_assert((unsigned int)(band[i].k + band[i].l) <= c);
+    n++;
+  }
+
+  for (beyond = found = 0, j = 0; full[j].k != INF; j++) {
+    if ((unsigned int)(full[j].k + full[j].l) > c) {
+      beyond++;
+      continue;
+    }
+
+    for (i = 0; band[i].k != INF; i++)
+      if ((band[i].k == full[j].k) && (band[i].l == full[j].l))
+        break;
+
+    ck_assert_msg(band[i].k != INF, "class (%d,%d) missing in band", full[j].k, full[j].l);
+    ck_assert(fabs(band[i].q - full[j].q) <= 1e-12 * full[j].q);
+    found++;
+  }
+
+  ck_assert_int_eq(found, n);
+  ck_assert(found > 0);
+  ck_assert(beyond > 0);
+
+  free(full);
+  free(band);
+}
+
+#tcase Threads
+
+#test test_TwoD_threads
+{
+  char                  **samples[2];
+  int                   i, t, threads[2] = {
+    1, 4
+  };
+  vrna_fold_compound_t  *fc;
+  vrna_sol_TwoD_t       *mfe[2];
+  vrna_sol_TwoD_pf_t    *pf[2];
+
+  for (t = 0; t < 2; t++) {
+    fc = TwoD_compound();
+    vrna_TwoD_set_num_threads(fc, threads[t]);
+    ck_assert_int_eq(vrna_TwoD_get_num_threads(fc), threads[t]);
+
+    mfe[t]  = vrna_mfe_TwoD(fc, -1, -1);
+    vrna_exp_params_rescale(fc, NULL);
+    pf[t] = vrna_pf_TwoD(fc, -1, -1);
+
+    /* sample from the second distance class with a fixed seed */
+    xsubi[0]    = xsubi[1] = xsubi[2] = 4711;
+    samples[t]  = vrna_pbacktrack_TwoD_num(fc, pf[t][1].k, pf[t][1].l, 50);
+
+    vrna_fold_compound_free(fc);
+  }
+
+  /* MFE and partition function of each class do not depend on the number of threads */
+  for (i = 0; mfe[0][i].k != INF; i++) {
+    ck_assert(mfe[1][i].k == mfe[0][i].k);
+    ck_assert(mfe[1][i].l == mfe[0][i].l);
+    ck_assert(mfe[1][i].en == mfe[0][i].en);
+    ck_assert_str_eq(mfe[1][i].s, mfe[0][i].s);
+    free(mfe[0][i].s);
+    free(mfe[1][i].s);
+  }
+  ck_assert(mfe[1][i].k == INF);
+
+  for (i = 0; pf[0][i].k != INF; i++) {
+    ck_assert(pf[1][i].k == pf[0][i].k);
+    ck_assert(pf[1][i].l == pf[0][i].l);
+    ck_assert(pf[1][i].q == pf[0][i].q);
+  }
+  ck_assert(pf[1][i].k == INF);
+
+  /* neither do the samples for a fixed seed */
+  for (i = 0; i < 50; i++) {
+    ck_assert(samples[0][i] != NULL);
+    ck_assert(samples[1][i] != NULL);
+    ck_assert_str_eq(samples[0][i], samples[1][i]);
+    free(samples[0][i]);
+    free(samples[1][i]);
+  }
+  ck_assert(samples[0][50] == NULL);
+  ck_assert(samples[1][50] == NULL);
+
+  for (t = 0; t < 2; t++) {
+    free(samples[t]);
+    free(mfe[t]);
+    free(pf[t]);
+  }
+}
+
+#test test_TwoD_threads_circ
+{
+  int                   i, t, threads[2] = {
+    1, 4
+  };
+  vrna_fold_compound_t  *fc;
+  vrna_sol_TwoD_t       *mfe[2];
+  vrna_sol_TwoD_pf_t    *pf[2];
+
+  for (t = 0; t < 2; t++) {
+    fc = TwoD_compound_circ(1);
+    vrna_TwoD_set_num_threads(fc, threads[t]);
+
+    mfe[t] = vrna_mfe_TwoD(fc, -1, -1);
+    vrna_exp_params_rescale(fc, NULL);
+    pf[t] = vrna_pf_TwoD(fc, -1, -1);
+
+    vrna_fold_compound_free(fc);
+  }
+
+  for (i = 0; mfe[0][i].k != INF; i++) {
+    ck_assert(mfe[1][i].k == mfe[0][i].k);
+    ck_assert(mfe[1][i].l == mfe[0][i].l);
+    ck_assert(mfe[1][i].en == mfe[0][i].en);
+    free(mfe[0][i].s);
+    free(mfe[1][i].s);
+  }
+  ck_assert(mfe[1][i].k == INF);
+
+  /* the exterior loops are summed up in per-thread partial sums, so only the rounding differs */
+  for (i = 0; pf[0][i].k != INF; i++) {
+    ck_assert(pf[1][i].k == pf[0][i].k);
+    ck_assert(pf[1][i].l == pf[0][i].l);
+    ck_assert(fabs(pf[1][i].q - pf[0][i].q) <= 1e-12 * pf[0][i].q);
+  }
+  ck_assert(pf[1][i].k == INF);
+
+  for (t = 0; t < 2; t++) {
+    free(mfe[t]);
+    free(pf[t]);
+  }
+}
+
+#tcase Memory_Budget
+
+#test test_TwoD_memory_budget
+{
+  int                   i;
+  size_t                used, reserved;
+  vrna_fold_compound_t  *fc;
+  vrna_sol_TwoD_t       *mfe;
+  vrna_sol_TwoD_pf_t    *pf;
+
+  used      = vrna_mx_memory_used();
+  fc        = TwoD_compound();
+  reserved  = vrna_mx_memory_used();
+
+  /* the distance classes are checked against the budget before they are filled */
+  vrna_mx_memory_budget_set(reserved + 1);
+  ck_assert(vrna_mfe_TwoD(fc, -1, -1) == NULL);
+  ck_assert(vrna_pf_TwoD(fc, -1, -1) == NULL);
+  ck_assert(vrna_mx_memory_used() == reserved);
+
+  vrna_mx_memory_budget_set(0);
+  mfe = vrna_mfe_TwoD(fc, -1, -1);
+  ck_assert(mfe != NULL);
+  ck_assert(vrna_mx_memory_used() > reserved);
+
+  for (i = 0; mfe[i].k != INF; i++)
+    free(mfe[i].s);
+  free(mfe);
+
+  vrna_exp_params_rescale(fc, NULL);
+  pf = vrna_pf_TwoD(fc, -1, -1);
+  ck_assert(pf != NULL);
+  free(pf);
+
+  /* the bound is released together with the matrices */
+  vrna_fold_compound_free(fc);
+  ck_assert(vrna_mx_memory_used() == used);
+}
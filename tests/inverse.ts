@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ViennaRNA/inverse.h>
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/mfe.h>
+#include <ViennaRNA/constraints/basic.h>
+#include <ViennaRNA/utils/basic.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define NUM_JOBS  8
+
+static const char *targets[] = {
+  "((((((...((((........)))).(((((.......))))).....(((((.......))))).))))))....",
+  "..((((((((.....))))((((.....)))).))))....(((((((......)))))))....",
+  "(((((((((....)))))...((((((((....))))))))..(((....)))..)))).......",
+  ".....((((((((....))))))))...."
+};
+
+#suite Inverse_Folding
+
+#tcase Reentrant_Design
+
+#test test_vrna_inverse_concurrent
+{
+  char                *serial[NUM_JOBS], *parallel[NUM_JOBS];
+  float               d_serial[NUM_JOBS], d_parallel[NUM_JOBS];
+  int                 i, k;
+  vrna_inverse_opt_t  opt;
+
+  vrna_inverse_opt_defaults(&opt);
+
+  for (i = 0; i < NUM_JOBS; i++) {
+    const char *target = targets[i % 4];
+    int         n      = strlen(target);
+
+    serial[i] = (char *)vrna_alloc(sizeof(char) * (n + 1));
+    for (k = 0; k < n; k++)
+      serial[i][k] = "ACGU"[(i + 3 * k) % 4];
+
+    parallel[i] = strdup(serial[i]);
+  }
+
+  for (i = 0; i < NUM_JOBS; i++) {
+    opt.seed    = 4711 + i;
+    opt.type    = (i % 4 == 3) ? VRNA_INVERSE_PF : VRNA_INVERSE_MFE;
+    d_serial[i] = vrna_inverse(NULL, targets[i % 4], serial[i], &opt);
+    ck_assert(d_serial[i] >= 0.);
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(4) firstprivate(opt)
+#endif
+  for (i = 0; i < NUM_JOBS; i++) {
+    opt.seed      = 4711 + i;
+    opt.type      = (i % 4 == 3) ? VRNA_INVERSE_PF : VRNA_INVERSE_MFE;
+    d_parallel[i] = vrna_inverse(NULL, targets[i % 4], parallel[i], &opt);
+  }
+
+  for (i = 0; i < NUM_JOBS; i++) {
+    ck_assert_str_eq(parallel[i], serial[i]);
+    ck_assert(d_parallel[i] == d_serial[i]);
+    free(serial[i]);
+    free(parallel[i]);
+  }
+}
+
+#test test_vrna_inverse_constraints
+{
+  const char            *target     = "((((((....))))))....((((((....))))))";
+  const char            *constraint = "..................xx................";
+  char                  *sequence, *structure;
+  int                   n;
+  float                 dist;
+  vrna_md_t             md;
+  vrna_inverse_opt_t    opt;
+  vrna_fold_compound_t  *fc;
+
+  n         = strlen(target);
+  sequence  = strdup("GGGGGGAAAACCCCCCAAAAGGGGGGAAAACCCCCC");
+  structure = (char *)vrna_alloc(sizeof(char) * (n + 1));
+
+  vrna_md_set_default(&md);
+  fc = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  vrna_constraints_add(fc, constraint, VRNA_CONSTRAINT_DB_DEFAULT);
+
+  vrna_inverse_opt_defaults(&opt);
+  opt.seed  = 42;
+  dist      = vrna_inverse(fc, target, sequence, &opt);
+
+  ck_assert(dist == 0.);
+
+  /* the design must fold into the target under the very same constraints */
+  vrna_fold_compound_free(fc);
+  fc = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  vrna_constraints_add(fc, constraint, VRNA_CONSTRAINT_DB_DEFAULT);
+  (void)vrna_mfe(fc, structure);
+
+  ck_assert_str_eq(structure, target);
+
+  /* mismatching lengths are rejected */
+  ck_assert(vrna_inverse(fc, "((...))", sequence, &opt) < 0.);
+
+  vrna_fold_compound_free(fc);
+  free(structure);
+  free(sequence);
+}
@@ -0,0 +1,560 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ViennaRNA/vrna_config.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/io/utils.h>
+#include <ViennaRNA/io/file_formats.h>
+
+#ifdef VRNA_WITH_ZLIB
+# include <unistd.h>
+# include <zlib.h>
+#endif
+
+/* write the input to a temporary file and rewind it for reading */
+static FILE *
+input(const char *data)
+{
+  FILE *fp = tmpfile();
+
+  ck_assert(fp != NULL);
+  fputs(data, fp);
+  rewind(fp);
+
+  return fp;
+}
+
+
+static char *
+repeat(const char *unit,
+       unsigned int n,
+       const char *sep)
+{
+  char          *s;
+  unsigned int  i, lu, ls;
+
+  lu  = strlen(unit);
+  ls  = strlen(sep);
+  s   = (char *)vrna_alloc(sizeof(char) * (n * (lu + ls) + 1));
+
+  for (i = 0; i < n; i++) {
+    memcpy(s + i * (lu + ls), unit, sizeof(char) * lu);
+    memcpy(s + i * (lu + ls) + lu, sep, sizeof(char) * ls);
+  }
+
+  return s;
+}
+
+
+static void
+free_rest(char **rest)
+{
+  char **r;
+
+  if (rest) {
+    for (r = rest; *r; r++)
+      free(*r);
+    free(rest);
+  }
+}
+
+
+/* read until the end of the stream such that no record is buffered for the next test */
+static void
+drain(FILE *fp)
+{
+  char          *header, *sequence, **rest;
+  unsigned int  type;
+
+  do {
+    type = vrna_file_fasta_read_record(&header, &sequence, &rest, fp, 0);
+    free(header);
+    free(sequence);
+    if (type & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT))
+      free(rest);
+    else
+      free_rest(rest);
+  } while (!(type & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT)));
+}
+
+
+/* check that the buffered reader yields the same records as vrna_file_fasta_read_record() */
+static void
+compare_reader(FILE                 *fp,
+               vrna_fasta_reader_t  reader,
+               unsigned int         options)
+{
+  char                *header, *sequence, **rest;
+  unsigned int        i, type, type_view;
+  vrna_fasta_record_t record;
+
+  do {
+    type      = vrna_file_fasta_read_record(&header, &sequence, &rest, fp, options);
+    type_view = vrna_file_fasta_read_record_view(reader, &record, options);
+
+    ck_assert_int_eq(type_view, type);
+
+    if (header) {
+      ck_assert(record.header != NULL);
+      ck_assert_str_eq(record.header, header);
+      ck_assert_int_eq(record.header_length, strlen(header));
+    } else {
+      ck_assert(record.header == NULL);
+    }
+
+    if (sequence) {
+      ck_assert(record.sequence != NULL);
+      ck_assert_str_eq(record.sequence, sequence);
+      ck_assert_int_eq(record.sequence_length, strlen(sequence));
+    } else {
+      ck_assert(record.sequence == NULL);
+    }
+
+    if (type & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT)) {
+      free(rest);
+    } else {
+      for (i = 0; rest[i]; i++) {
+        ck_assert(i < record.rest_count);
+        ck_assert_str_eq(record.rest[i], rest[i]);
+      }
+      ck_assert_int_eq(i, record.rest_count);
+      ck_assert(record.rest[i] == NULL);
+      free_rest(rest);
+    }
+
+    free(header);
+    free(sequence);
+  } while (!(type & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT)));
+
+  drain(fp);
+}
+
+
+static void
+compare_reader_input(const char   *data,
+                     unsigned int options)
+{
+  FILE                *fp, *fp_view;
+  vrna_fasta_reader_t reader;
+
+  fp      = input(data);
+  fp_view = input(data);
+  reader  = vrna_file_fasta_reader_init(fp_view);
+
+  ck_assert(reader != NULL);
+  compare_reader(fp, reader, options);
+
+  vrna_file_fasta_reader_free(reader);
+  fclose(fp_view);
+  fclose(fp);
+}
+
+
+#ifdef VRNA_WITH_ZLIB
+/* write the input as gzip compressed file, split into the given number of gzip members */
+static char *
+gz_input(const char   *data,
+         unsigned int members)
+{
+  char          *filename;
+  unsigned int  i;
+  size_t        n, chunk;
+  int           fd;
+  gzFile        gz;
+
+  filename  = vrna_strdup_printf("io_test_XXXXXX");
+  fd        = mkstemp(filename);
+  ck_assert(fd != -1);
+  close(fd);
+
+  n     = strlen(data);
+  chunk = n / members + 1;
+
+  for (i = 0; i < members; i++) {
+    gz = gzopen(filename, (i == 0) ? "wb" : "ab");
+    ck_assert(gz != NULL);
+    if (i * chunk < n)
+      gzwrite(gz, data + i * chunk, (unsigned int)MIN2(chunk, n - i * chunk));
+
+    gzclose(gz);
+  }
+
+  return filename;
+}
+
+
+#endif
+
+
+/* end of prologue */
+
+#suite IO
+
+#tcase Read_Line
+
+#test test_vrna_read_line_empty
+{
+  FILE *fp = input("");
+
+  ck_assert(vrna_read_line(fp) == NULL);
+  ck_assert(vrna_read_line(fp) == NULL);
+
+  fclose(fp);
+}
+
+#test test_vrna_read_line
+{
+  char  *line;
+  FILE  *fp = input("ACGU\n\n  GGGG  \nUUUU");
+
+  line = vrna_read_line(fp);
+  ck_assert_str_eq(line, "ACGU");
+  free(line);
+
+  /* empty lines are returned as empty strings, not as NULL */
+  line = vrna_read_line(fp);
+  ck_assert(line != NULL);
+  ck_assert_str_eq(line, "");
+  free(line);
+
+  line = vrna_read_line(fp);
+  ck_assert_str_eq(line, "  GGGG  ");
+  free(line);
+
+  /* last line without trailing newline */
+  line = vrna_read_line(fp);
+  ck_assert_str_eq(line, "UUUU");
+  free(line);
+
+  ck_assert(vrna_read_line(fp) == NULL);
+
+  fclose(fp);
+}
+
+#test test_vrna_read_line_long
+{
+  char          *data, *line, *expected;
+  unsigned int  n;
+  FILE          *fp;
+
+  /* lines that span several read chunks, one of them ending exactly at a chunk border */
+  for (n = 8191; n <= 8193; n++) {
+    expected  = repeat("A", n, "");
+    data      = vrna_strdup_printf("%s\n%s", expected, expected);
+    fp        = input(data);
+
+    line = vrna_read_line(fp);
+    ck_assert_int_eq(strlen(line), n);
+    ck_assert_str_eq(line, expected);
+    free(line);
+
+    line = vrna_read_line(fp);
+    ck_assert_str_eq(line, expected);
+    free(line);
+
+    ck_assert(vrna_read_line(fp) == NULL);
+
+    fclose(fp);
+    free(data);
+    free(expected);
+  }
+
+  expected  = repeat("ACGU", 50000, "");
+  data      = vrna_strdup_printf("%s\n", expected);
+  fp        = input(data);
+
+  line = vrna_read_line(fp);
+  ck_assert_str_eq(line, expected);
+  free(line);
+  ck_assert(vrna_read_line(fp) == NULL);
+
+  fclose(fp);
+  free(data);
+  free(expected);
+}
+
+#tcase Fasta_Records
+
+#test test_fasta_read_record_empty
+{
+  char          *header, *sequence, **rest;
+  unsigned int  type;
+  FILE          *fp;
+
+  fp    = input("");
+  type  = vrna_file_fasta_read_record(&header, &sequence, &rest, fp, 0);
+  ck_assert(type & VRNA_INPUT_ERROR);
+  ck_assert(header == NULL);
+  ck_assert(sequence == NULL);
+  free(rest);
+  fclose(fp);
+
+  /* nothing but blank lines and comments */
+  fp    = input("\n# comment\n\n; another one\n");
+  type  = vrna_file_fasta_read_record(&header, &sequence, &rest, fp, 0);
+  ck_assert(type & VRNA_INPUT_ERROR);
+  ck_assert(header == NULL);
+  ck_assert(sequence == NULL);
+  free(rest);
+  fclose(fp);
+}
+
+#test test_fasta_read_record
+{
+  char          *header, *sequence, **rest, *data, *line, *expected;
+  unsigned int  type;
+  FILE          *fp;
+
+  /* sequence spanning many lines, followed by a structure and a record without header */
+  line      = repeat("ACGUACGUAC", 1000, "\n");
+  expected  = repeat("ACGUACGUAC", 1000, "");
+  data      = vrna_strdup_printf(">first record\n%s((((....))))\n\nGGGGAAAACCCC", line);
+  fp        = input(data);
+
+  type = vrna_file_fasta_read_record(&header, &sequence, &rest, fp, 0);
+  ck_assert(type & VRNA_INPUT_FASTA_HEADER);
+  ck_assert(type & VRNA_INPUT_SEQUENCE);
+  ck_assert_str_eq(header, ">first record");
+  ck_assert_int_eq(strlen(sequence), 10000);
+  ck_assert_str_eq(sequence, expected);
+  ck_assert(rest[0] != NULL);
+  ck_assert_str_eq(rest[0], "((((....))))");
+  ck_assert(rest[1] == NULL);
+  free(header);
+  free(sequence);
+  free_rest(rest);
+
+  /* last record lacks both, the header and the trailing newline */
+  type = vrna_file_fasta_read_record(&header, &sequence, &rest, fp, 0);
+  ck_assert(!(type & VRNA_INPUT_FASTA_HEADER));
+  ck_assert(type & VRNA_INPUT_SEQUENCE);
+  ck_assert(header == NULL);
+  ck_assert_str_eq(sequence, "GGGGAAAACCCC");
+  ck_assert(rest[0] == NULL);
+  free(sequence);
+  free_rest(rest);
+
+  drain(fp);
+  fclose(fp);
+  free(data);
+  free(line);
+  free(expected);
+}
+
+#test test_fasta_read_record_malformed
+{
+  char          *header, *sequence, **rest;
+  unsigned int  type;
+  FILE          *fp;
+
+  /* header at the end of the input */
+  fp    = input(">lonely header\n");
+  type  = vrna_file_fasta_read_record(&header, &sequence, &rest, fp, 0);
+  ck_assert(type & VRNA_INPUT_FASTA_HEADER);
+  ck_assert(type & VRNA_INPUT_ERROR);
+  ck_assert(!(type & VRNA_INPUT_SEQUENCE));
+  ck_assert_str_eq(header, ">lonely header");
+  ck_assert(sequence == NULL);
+  free(header);
+  free(rest);
+  drain(fp);
+  fclose(fp);
+
+  /* header directly followed by the next header */
+  fp    = input(">first\n>second\nACGU\n");
+  type  = vrna_file_fasta_read_record(&header, &sequence, &rest, fp, 0);
+  ck_assert(type & VRNA_INPUT_ERROR);
+  ck_assert(sequence == NULL);
+  free(header);
+  free(rest);
+  drain(fp);
+  fclose(fp);
+
+  /* structure without a sequence */
+  fp    = input(">first\n((....))\n");
+  type  = vrna_file_fasta_read_record(&header, &sequence, &rest, fp, 0);
+  ck_assert(type & VRNA_INPUT_ERROR);
+  ck_assert(sequence == NULL);
+  free(header);
+  free(rest);
+  drain(fp);
+  fclose(fp);
+
+  /* user abort */
+  fp    = input("@\nACGU\n");
+  type  = vrna_file_fasta_read_record(&header, &sequence, &rest, fp, 0);
+  ck_assert(type & VRNA_INPUT_QUIT);
+  ck_assert(header == NULL);
+  ck_assert(sequence == NULL);
+  free(rest);
+  drain(fp);
+  fclose(fp);
+}
+
+#tcase Fasta_Reader
+
+#test test_fasta_reader_records
+{
+  const char    *inputs[] = {
+    "",
+    "\n# comment\n\n; another one\n",
+    ">first record\nACGU\nACGU\n((((....))))\n\nGGGGAAAACCCC",
+    ">a\nACGU\n# comment\n....\n; another comment\nxx..\n>b\n\nGGGG\n\n>c\nUUUU\n",
+    "ACGUACGU\n((....))\nGGGG&CCCC\n(((.&)))\nAAAA\n",
+    ">with blanks  \n  ACGU  \nACGU \n\n\n>next\nCCCC\n",
+    ">crlf\r\nGGGGAAAACCCC\r\n((((....))))\r\n>last\r\nACGU",
+    ">lonely header\n",
+    ">first\n>second\nACGU\n",
+    ">first\n((....))\n",
+    "ACGU\n@\nACGU\n",
+    "@\nACGU\n",
+    ">x\nACGU\nxxxx\n|||.\n<<>>\n>y\nACGU\n",
+    NULL
+  };
+  unsigned int  options[] = {
+    0,
+    VRNA_INPUT_NO_REST,
+    VRNA_INPUT_NO_SPAN,
+    VRNA_INPUT_NOSKIP_COMMENTS,
+    VRNA_INPUT_NOSKIP_BLANK_LINES,
+    VRNA_INPUT_NOSKIP_BLANK_LINES | VRNA_INPUT_NOSKIP_COMMENTS,
+    VRNA_INPUT_NO_SPAN | VRNA_INPUT_NO_REST
+  };
+  unsigned int  i, o;
+
+  for (i = 0; inputs[i]; i++)
+    for (o = 0; o < sizeof(options) / sizeof(options[0]); o++)
+      compare_reader_input(inputs[i], options[o]);
+}
+
+#test test_fasta_reader_buffer
+{
+  char          *line, *data;
+  unsigned int  i;
+
+  /* records that exceed the initial read buffer */
+  line  = repeat("ACGUACGUAC", 150000, "\n");
+  data  = vrna_strdup_printf(">long\n%s((..))\n>short\nACGU\n", line);
+  compare_reader_input(data, 0);
+  compare_reader_input(data, VRNA_INPUT_NO_SPAN);
+  free(data);
+  free(line);
+
+  line  = repeat("ACGU", 600000, "");
+  data  = vrna_strdup_printf("%s\n%s", line, line);
+  compare_reader_input(data, 0);
+  free(data);
+  free(line);
+
+  /* many small records such that records cross the borders of the read buffer */
+  for (i = 0; i < 3; i++) {
+    data = repeat(">record\nGGGGAAAACCCC\n((((....))))\n", 40000 + 7 * i, i == 1 ? "\n" : "");
+    compare_reader_input(data, 0);
+    compare_reader_input(data, VRNA_INPUT_NO_REST);
+    free(data);
+  }
+}
+
+#test test_fasta_reader_views
+{
+  char                *line, *data;
+  unsigned int        type;
+  FILE                *fp;
+  vrna_fasta_reader_t reader;
+  vrna_fasta_record_t record;
+
+  ck_assert(vrna_file_fasta_reader_open("io_test_does_not_exist.fa") == NULL);
+  ck_assert(vrna_file_fasta_read_record_view(NULL, &record, 0) & VRNA_INPUT_ERROR);
+
+  /* multi-line sequences are joined in place */
+  line    = repeat("ACGUACGUAC", 100, "\n");
+  data    = vrna_strdup_printf(">multi\n%s", line);
+  fp      = input(data);
+  reader  = vrna_file_fasta_reader_init(fp);
+  type    = vrna_file_fasta_read_record_view(reader, &record, 0);
+  ck_assert(type & VRNA_INPUT_SEQUENCE);
+  ck_assert_str_eq(record.header, ">multi");
+  ck_assert_int_eq(record.header_length, 6);
+  ck_assert_int_eq(record.sequence_length, 1000);
+  ck_assert_int_eq(strlen(record.sequence), 1000);
+  ck_assert_int_eq(record.rest_count, 0);
+  ck_assert(record.rest[0] == NULL);
+  type = vrna_file_fasta_read_record_view(reader, &record, 0);
+  ck_assert(type & VRNA_INPUT_ERROR);
+  vrna_file_fasta_reader_free(reader);
+  fclose(fp);
+  free(data);
+  free(line);
+
+#ifndef VRNA_WITH_ZLIB
+  /* compressed input is refused without zlib support */
+  fp = input("\x1f\x8b\x08");
+  ck_assert(vrna_file_fasta_reader_init(fp) == NULL);
+  fclose(fp);
+#endif
+}
+
+#test test_fasta_reader_gzip
+{
+#ifdef VRNA_WITH_ZLIB
+  char                *filename, *line, *seq, *data, *buf;
+  unsigned int        members, type;
+  long                size;
+  FILE                *fp, *fp_gz;
+  vrna_fasta_reader_t reader;
+  vrna_fasta_record_t record;
+
+  line  = repeat(">record\nGGGGAAAACCCC\n((((....))))\n", 20000, "");
+  seq   = repeat("ACGU", 500000, "");
+  data  = vrna_strdup_printf(">long\n%s\n%s", seq, line);
+
+  /* single and concatenated gzip members */
+  for (members = 1; members <= 5; members += 4) {
+    filename  = gz_input(data, members);
+    fp        = input(data);
+    reader    = vrna_file_fasta_reader_open(filename);
+    ck_assert(reader != NULL);
+    compare_reader(fp, reader, 0);
+    vrna_file_fasta_reader_free(reader);
+    fclose(fp);
+    unlink(filename);
+    free(filename);
+  }
+
+  /* truncated input ends the stream without crashing */
+  filename  = gz_input(line, 1);
+  fp_gz     = fopen(filename, "rb");
+  ck_assert(fp_gz != NULL);
+  fseek(fp_gz, 0, SEEK_END);
+  size = ftell(fp_gz) / 2;
+  rewind(fp_gz);
+
+  buf = (char *)vrna_alloc(sizeof(char) * size);
+  ck_assert_int_eq(fread(buf, sizeof(char), size, fp_gz), size);
+  fclose(fp_gz);
+
+  fp = tmpfile();
+  ck_assert(fp != NULL);
+  fwrite(buf, sizeof(char), size, fp);
+  rewind(fp);
+
+  reader = vrna_file_fasta_reader_init(fp);
+  ck_assert(reader != NULL);
+  do {
+    type = vrna_file_fasta_read_record_view(reader, &record, 0);
+    if (type & VRNA_INPUT_SEQUENCE)
+      ck_assert_str_eq(record.header, ">record");
+  } while (!(type & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT)));
+  vrna_file_fasta_reader_free(reader);
+  fclose(fp);
+  unlink(filename);
+  free(filename);
+
+  free(buf);
+  free(data);
+  free(seq);
+  free(line);
+#endif
+}
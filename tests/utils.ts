@@ -3,6 +3,9 @@
 #include <ViennaRNA/model.h>
 #include <ViennaRNA/utils/basic.h>
 #include <ViennaRNA/alphabet.h>
+#include <ViennaRNA/utils/structures.h>
+#include <ViennaRNA/utils/higher_order_functions.h>
+#include <ViennaRNA/dist_matrix.h>
 
 #suite Utilities
 
@@ -205,3 +208,72 @@
 //@TODO: extend alphabeth
 //@TODO: details.noLP = 1
 //@TODO: idx_type = 1
+
+#test test_vrna_structure_set
+{
+  const char            *structures[] = {
+    "((((....))))..((((....))))..........",
+    "((((....))))..((((....))))..........",
+    "((((....))))........................",
+    "...((((....))))....((((......))))...",
+    ".(((....)))...((((....))))..........",
+    NULL
+  };
+  int                   i, j, n, *d, *d_default, medoid, sum;
+  char                  *centroid;
+  double                dist;
+  vrna_structure_set_t  *set, *set2;
+
+  set = vrna_structure_set(structures);
+  n   = 5;
+
+  ck_assert(set != NULL);
+  ck_assert_int_eq(set->num, n);
+  ck_assert_int_eq(set->pairs[3], 8);
+
+  d = vrna_structure_set_bp_distances(set, NULL, 2);
+
+  vrna_fun_dispatch_disable();
+  d_default = vrna_structure_set_bp_distances(set, NULL, 1);
+  vrna_fun_dispatch_enable();
+
+  for (i = 0; i < n; i++)
+    for (j = i + 1; j < n; j++) {
+      ck_assert_int_eq(d[VRNA_DIST_MATRIX_INDEX(n, i, j)],
+                       vrna_bp_distance(structures[i], structures[j]));
+      ck_assert_int_eq(d_default[VRNA_DIST_MATRIX_INDEX(n, i, j)],
+                       d[VRNA_DIST_MATRIX_INDEX(n, i, j)]);
+    }
+
+  free(d);
+  free(d_default);
+
+  /* many-to-many distances */
+  set2  = vrna_structure_set(structures + 3);
+  d     = vrna_structure_set_bp_distances(set, set2, 2);
+
+  for (i = 0; i < n; i++)
+    for (j = 0; j < 2; j++)
+      ck_assert_int_eq(d[i * 2 + j], vrna_bp_distance(structures[i], structures[3 + j]));
+
+  free(d);
+  vrna_structure_set_free(set2);
+
+  for (sum = 0, i = 0; i < n; i++)
+    sum += vrna_bp_distance(structures[0], structures[i]);
+
+  centroid = vrna_structure_set_centroid(set, &dist, 2);
+  ck_assert_str_eq(centroid, structures[0]);
+  ck_assert(dist == (double)sum / n);
+  free(centroid);
+
+  medoid = vrna_structure_set_medoid(set, &dist, 2);
+  ck_assert_int_eq(medoid, 0);
+  ck_assert(dist == (double)sum / n);
+
+  vrna_structure_set_free(set);
+
+  /* structures of different length are rejected */
+  structures[1] = "((....))";
+  ck_assert(vrna_structure_set(structures) == NULL);
+}